@@ -37,12 +37,17 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <ctime>
+#include <deque>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "wx/wxprec.h"
 
@@ -64,6 +69,7 @@
 #include "model/cli_platform.h"
 #include "model/comm_appmsg_bus.h"
 #include "model/comm_driver.h"
+#include "model/comm_drv_capture.h"
 #include "model/comm_navmsg_bus.h"
 #include "model/config_vars.h"
 #include "model/downloader.h"
@@ -142,8 +148,30 @@ Usage: opencpn-cli [options] <command>
   print-hostname:
      Print official hostname for generate-key and store-key.
 
+  replay <capture file> [speed]
+     Replay a log recorded using opencpn --capture on the message bus and
+     print throughput and latency statistics. Messages are played at
+     recorded speed times speed, as fast as possible if speed is 0 which
+     is the default.
+
 )""";
 
+/** Return the p percentile of values in us, reordering values. */
+static double Percentile(std::vector<uint32_t>& values, double p) {
+  if (values.empty()) return 0;
+  size_t n = std::min(values.size() - 1,
+                      static_cast<size_t>(p * values.size()));
+  std::nth_element(values.begin(), values.begin() + n, values.end());
+  return values[n] / 1000.0;
+}
+
+static void PrintLatency(const char* label, std::vector<uint32_t>& values) {
+  std::cout << label << std::fixed << std::setprecision(1)
+            << "p50 " << Percentile(values, 0.5) << " us, p99 "
+            << Percentile(values, 0.99) << " us, max "
+            << Percentile(values, 1.0) << " us\n";
+}
+
 static const char* const DOWNLOAD_REPO_PROTO =
     "https://raw.githubusercontent.com/OpenCPN/plugins/@branch@/"
     "ocpn-plugins.xml";
@@ -377,6 +405,78 @@ class CliApp : public wxAppConsole {
     std::cout << hostname << "\n";
   }
 
+  void replay(const std::string& path, const std::string& speed_arg) {
+    double speed = 0;
+    if (speed_arg != "") {
+      try {
+        speed = std::stod(speed_arg);
+      } catch (...) {
+        std::cerr << "Cannot parse speed: " << speed_arg << "\n";
+        exit(1);
+      }
+    }
+
+    //  Worker latency: the Direct subscriber stamps each message on the
+    //  replay thread, the Worker one gets them in the same order.
+    std::mutex mutex;
+    std::deque<std::chrono::steady_clock::time_point> stamps;
+    std::vector<uint32_t> worker_ns;
+    std::atomic<uint64_t> delivered(0);
+    auto stamp = [&](std::shared_ptr<const NavMsg>) {
+      std::lock_guard<std::mutex> lock(mutex);
+      stamps.push_back(std::chrono::steady_clock::now());
+    };
+    auto deliver = [&](std::shared_ptr<const NavMsg>) {
+      auto now = std::chrono::steady_clock::now();
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      now - stamps.front()).count();
+        stamps.pop_front();
+        worker_ns.push_back(static_cast<uint32_t>(
+            std::min<int64_t>(ns, UINT32_MAX)));
+      }
+      delivered++;
+    };
+    NavMsgSubscription direct(NavMsgBus::kAllMsgs, stamp,
+                              NavMsgDelivery::Direct);
+    NavMsgSubscription worker(NavMsgBus::kAllMsgs, deliver,
+                              NavMsgDelivery::Worker);
+
+    auto driver = std::make_shared<ReplayCommDriver>(
+        path, NavMsgBus::GetInstance(), speed);
+    if (!driver->Run() && driver->GetStats().messages == 0) exit(1);
+    ReplayStats stats = driver->GetStats();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (delivered < stats.messages &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    direct.Reset();
+    worker.Reset();
+
+    double wall_s = stats.wall_ns / 1e9;
+    std::cout << "Messages:        " << stats.messages << " ("
+              << stats.bytes << " bytes)\n";
+    std::cout << std::fixed << std::setprecision(3)
+              << "Recorded time:   " << stats.log_ns / 1e9 << " s\n"
+              << "Replay time:     " << wall_s << " s\n";
+    if (wall_s > 0) {
+      std::cout << std::setprecision(0)
+                << "Throughput:      " << stats.messages / wall_s
+                << " msgs/s, " << stats.bytes / wall_s << " bytes/s\n";
+    }
+    if (speed > 0) {
+      std::cout << std::setprecision(3)
+                << "Max lag:         " << stats.max_lag_ns / 1e6 << " ms\n";
+    }
+    PrintLatency("Notify latency:  ", stats.notify_ns);
+    std::lock_guard<std::mutex> lock(mutex);
+    std::cout << "Worker delivery: " << worker_ns.size() << " messages\n";
+    PrintLatency("Worker latency:  ", worker_ns);
+  }
+
   void check_param_count(const wxCmdLineParser& parser, size_t count) {
     if (parser.GetParamCount() < count) {
       std::cerr << USAGE << "\n";
@@ -464,6 +564,11 @@ class CliApp : public wxAppConsole {
     } else if (command == "print-hostname") {
       check_param_count(parser, 0);
       print_hostname();
+    } else if (command == "replay") {
+      check_param_count(parser, 2);
+      std::string speed;
+      if (parser.GetParamCount() > 2) speed = parser.GetParam(2).ToStdString();
+      replay(parser.GetParam(1).ToStdString(), speed);
     } else {
       std::cerr << USAGE << "\n";
       exit(2);
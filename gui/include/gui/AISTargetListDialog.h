@@ -30,6 +30,8 @@
 #include <wx/panel.h>
 #include <wx/checkbox.h>
 
+#include "model/ais_list_model.h"
+
 #define ID_AIS_TARGET_LIST 10003
 #define ID_RCLK_UNDOCK 7035
 
@@ -46,8 +48,6 @@ class wxListEvent;
 class wxAuiManager;
 class wxAuiManagerEvent;
 
-WX_DEFINE_SORTED_ARRAY_INT(int, ArrayOfMMSI);
-
 class AISTargetListDialog : public wxPanel {
   DECLARE_CLASS(AISTargetListDialog)
 
@@ -68,14 +68,18 @@ public:
   void CenterToTarget(bool);
   std::shared_ptr<AisTargetData> GetpTarget(unsigned int list_item);
 
+  /** Return the text of a list cell, cached until the target changes. */
+  wxString GetCellText(long item, long column);
+
   OCPNListCtrl *m_pListCtrlAISTargets;
   AisDecoder *m_pdecoder;
 
-  ArrayOfMMSI *m_pMMSI_array;
-
 private:
   void CreateControls(void);
 
+  /** Sync m_rows with the decoder targets in range. */
+  void SyncRows(bool show_lost);
+
   void OnPaneClose(wxAuiManagerEvent &event);
   void UpdateButtons();
   void OnTargetSelected(wxListEvent &event);
@@ -113,7 +117,7 @@ private:
   wxButton *m_pButtonOK;
   wxCheckBox *m_pCBAutosort;
 
-  bool m_bautosort_force;
+  AisListModel m_rows;
 
   DECLARE_EVENT_TABLE()
 };
@@ -30,6 +30,7 @@
 #include <wx/window.h>
 
 #include "model/nmea_log.h"
+#include "model/nmea_log_pipeline.h"
 
 #include "WindowDestroyListener.h"
 #include "TTYWindow.h"
@@ -44,6 +45,9 @@
  * Reading geometry information from the window will cache them
  * inside this class. This is used to store them permanently in
  * the configuration file.
+ *
+ * Lines are formatted and filtered by a NmeaLogPipeline while the window
+ * is open, and added to the window at most once per repaint interval.
  */
 class NMEALogWindow : public NmeaLog, public WindowDestroyListener {
 public:
@@ -53,6 +57,7 @@ public:
   bool Active() const;
   void Create(wxWindow *parent, int num_lines = 35);
   void Add(const wxString &s);
+  void Add(NmeaLogEntry &&entry);
   void Refresh(bool do_refresh = false);
   int GetSizeW();
   int GetSizeH();
@@ -72,9 +77,11 @@ private:
   NMEALogWindow();
   virtual ~NMEALogWindow(){};
   void UpdateGeometry();
+  void ShowBatch();
 
   static NMEALogWindow *instance;
   TTYWindow *m_window;
+  NmeaLogPipeline m_pipeline;
   int m_width;
   int m_height;
   int m_pos_x;
@@ -25,6 +25,10 @@
 #ifndef __TTYSCROLL_H__
 #define __TTYSCROLL_H__
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include <wx/scrolwin.h>
 #include <wx/textctrl.h>
 
@@ -35,6 +39,11 @@ public:
   virtual ~TTYScroll();
   virtual void OnDraw(wxDC &dc);
   virtual void Add(const wxString &line);
+  /**
+   * Add lines already filtered, with a single refresh. A non-zero dropped
+   * count is shown as a line of its own before them.
+   */
+  void Add(const std::vector<std::string> &lines, uint64_t dropped);
   void OnSize(wxSizeEvent &event);
   void Pause(bool pause) { bpause = pause; }
   void Copy();
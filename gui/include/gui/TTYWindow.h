@@ -25,6 +25,10 @@
 #ifndef __TTYWINDOW_H__
 #define __TTYWINDOW_H__
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include <wx/frame.h>
 #include <wx/bitmap.h>
 
@@ -44,6 +48,7 @@ public:
   virtual ~TTYWindow();
 
   void Add(const wxString &line);
+  void Add(const std::vector<std::string> &lines, uint64_t dropped);
   void OnCloseWindow(wxCloseEvent &event);
   void Close();
   void OnPauseClick(wxCommandEvent &event);
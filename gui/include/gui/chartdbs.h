@@ -30,6 +30,7 @@
 #include <memory>
 #include <vector>
 
+#include "model/chart_scan.h"
 #include "model/ocpn_types.h"
 #include "bbox.h"
 #include "LLRegion.h"
@@ -304,6 +305,17 @@ public:
   virtual ~ChartDatabase(){};
 
   bool Create(ArrayOfCDI &dir_array, wxGenericProgressDialog *pprog);
+
+  /**
+   * Bring the database up to date with the chart directories.
+   *
+   * Runs on the calling thread and returns with the merge complete: the
+   * frame rebuilds its quilts and plugins call UpdateChartDBInplace()
+   * expecting the new charts to be there. Directory listings and the
+   * header probes of KAP and GEO charts run on worker threads meanwhile,
+   * with pprog kept responsive. Other chart classes are probed on the
+   * calling thread, their Init() shares state with the rest of the app.
+   */
   bool Update(ArrayOfCDI &dir_array, bool bForce,
               wxGenericProgressDialog *pprog);
 
@@ -377,14 +389,14 @@ private:
 
   int SearchDirAndAddCharts(wxString &dir_name_base,
                             ChartClassDescriptor &chart_desc,
-                            wxGenericProgressDialog *pprog);
+                            wxGenericProgressDialog *pprog,
+                            const std::vector<ChartScanFile> &files);
 
   int TraverseDirAndAddCharts(ChartDirInfo &dir_info,
                               wxGenericProgressDialog *pprog,
                               wxString &dir_magic, bool bForce);
-  bool DetectDirChange(const wxString &dir_path, const wxString &prog_label,
-                       const wxString &magic, wxString &new_magic,
-                       wxGenericProgressDialog *pprog);
+  bool DetectDirChange(const std::vector<ChartScanFile> &files,
+                       const wxString &magic, wxString &new_magic);
 
   bool AddChart(wxString &chartfilename, ChartClassDescriptor &chart_desc,
                 wxGenericProgressDialog *pprog, int isearch,
@@ -406,6 +418,7 @@ private:
   int m_nentries;
 
   LLBBox m_dummy_bbox;
+  ChartScanManifest m_manifest;  ///< Files probed by Update()
 };
 
 //-------------------------------------------------------------------------------------------
@@ -239,6 +239,11 @@ public:
                                  wxPoint2DDouble *r);
   bool GetCanvasPointPix(double rlat, double rlon, wxPoint *r);
   bool GetCanvasPointPixVP(ViewPort &vp, double rlat, double rlon, wxPoint *r);
+  /** Batch versions of the above, for polylines and other large point sets */
+  void GetDoubleCanvasPointPix(const double *lat, const double *lon, int count,
+                               wxPoint2DDouble *r);
+  void GetCanvasPointPix(const double *lat, const double *lon, int count,
+                         wxPoint *r);
 
   void GetCanvasPixPoint(double x, double y, double &lat, double &lon);
   void WarpPointerDeferred(int x, int y);
@@ -568,6 +573,10 @@ public:
 private:
   int AdjustQuiltRefChart();
 
+  //  Raster chart whose own georeferencing is used to project points, or
+  //  NULL when the viewport projection is used
+  ChartBaseBSB *GetGeorefRasterChart(ViewPort &vp);
+
   bool UpdateS52State();
 
   void CallPopupMenu(int x, int y);
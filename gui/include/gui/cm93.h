@@ -26,6 +26,9 @@
 #ifndef __CM93CHART_H__
 #define __CM93CHART_H__
 
+#include <list>
+#include <memory>
+
 #include <wx/listctrl.h>  // Somehow missing from wx build
 
 #include "s57chart.h"
@@ -40,9 +43,12 @@
 //    Static functions
 int Get_CM93_CellIndex(double lat, double lon, int scale);
 void Get_CM93_Cell_Origin(int cellindex, int scale, double *lat, double *lon);
+std::vector<int> Get_CM93_CellArray(const LLBBox &box, int scale, int dval);
 
 //    Fwd definitions
 class covr_set;
+class CM93CellSet;
+struct CM93CellRequest;
 class wxSpinCtrl;
 class ChartCanvas;
 
@@ -217,8 +223,17 @@ typedef struct {
   vector_record_descriptor *object_vector_record_descriptor_block;
   Object *pobject_block;
 
+  size_t alloc_size;  // total size of the allocated blocks
+
 } Cell_Info_Block;
 
+//    Cell file access, these may be called from any thread
+bool Ingest_CM93_Cell(const char *cell_file_name, Cell_Info_Block *pCIB);
+void Clear_CM93_Cell(Cell_Info_Block *pCIB);
+void Free_CM93_Cell(Cell_Info_Block *pCIB);
+wxString Find_CM93_Cell_File(const wxString &prefix, const wxString &scalechar,
+                             int dval, int cellindex, wxChar sub_char);
+
 //----------------------------------------------------------------------------
 // cm93_dictionary class
 //    Encapsulating the conversion between binary cm_93 object class,
@@ -325,6 +340,13 @@ public:
 
   std::vector<int> GetVPCellArray(const ViewPort &vpt);
 
+  CM93CellRequest GetCellRequest(int cell_index);
+  bool IsCellLoaded(int cell_index);
+  /** True if all the cells covering vpt have been loaded by SetVPParms(). */
+  bool IsVPLoaded(const ViewPort &vpt);
+  /** True if SetVPParms(vpt) would not have to read any cell file. */
+  bool IsVPCellsReady(const ViewPort &vpt);
+
   Array_Of_M_COVR_Desc_Ptr m_pcovr_array_loaded;
 
   void SetUserOffsets(int cell_index, int object_id, int subcell, int xoff,
@@ -366,6 +388,7 @@ private:
   M_COVR_Desc *FindM_COVR_InWorkingSet(double lat, double lon);
 
   Cell_Info_Block m_CIB;
+  std::shared_ptr<const CM93CellSet> m_cell_set;  // holds the m_CIB blocks
 
   cm93_dictionary *m_pDict;
   cm93manager *m_pManager;
@@ -392,7 +415,6 @@ private:
   wxString m_LastFileName;
 
   LLRegion m_region;
-  wxArrayString m_noFindArray;
 };
 
 //----------------------------------------------------------------------------
@@ -480,6 +502,10 @@ private:
   void FillScaleArray(double lat, double lon);
   int PrepareChartScale(const ViewPort &vpt, int cmscale,
                         bool bOZ_protect = true);
+  int FindLoadedScale(const ViewPort &vpt, int cmscale);
+  void GetCellRequests(const LLBBox &box, int scale_index,
+                       std::vector<CM93CellRequest> &requests);
+  void PrefetchCells(const ViewPort &vpt, int cmscale);
   int GetCMScaleFromVP(const ViewPort &vpt);
   bool DoRenderRegionViewOnDC(wxMemoryDC &dc, const ViewPort &VPoint,
                               const OCPNRegion &Region);
@@ -513,6 +539,7 @@ private:
   int m_special_offset_x;
   int m_special_offset_y;
   ViewPort m_vpt;
+  ViewPort m_prefetch_vp;
 
   cm93chart *m_last_cell_adjustvp;
 };
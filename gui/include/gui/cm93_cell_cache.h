@@ -0,0 +1,160 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Cache and background loader of decoded CM93 cells
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#ifndef CM93_CELL_CACHE_H
+#define CM93_CELL_CACHE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <wx/string.h>
+
+#include "cm93.h"
+
+/** A CM93 cell at one scale, identifies the files read by the cache. */
+struct CM93CellRequest {
+  wxString prefix;     // CM93 root directory, with trailing separator
+  wxString scalechar;  // "Z", "A" ... "G"
+  int dval;            // cell size, in units of 20 minutes
+  int cell_index;
+
+  std::string GetKey() const;
+};
+
+/** One decoded (sub)cell file, read only once loaded. */
+class CM93Cell {
+public:
+  CM93Cell();
+  ~CM93Cell();
+
+  /** Read and decode file, decompressing it first if it is a .xz file. */
+  static std::unique_ptr<CM93Cell> Load(const wxString &file);
+
+  wxChar sub_char;  // '0' for the base cell, 'A'... for the subcells
+  wxString file;
+  Cell_Info_Block cib;
+};
+
+/** The base cell and subcells found for a CM93CellRequest. */
+class CM93CellSet {
+public:
+  CM93CellSet() : mem_size(0) {}
+
+  /** Return the (sub)cell sub_char, or NULL if there is no such file. */
+  const CM93Cell *Find(wxChar sub_char) const;
+
+  std::vector<std::unique_ptr<CM93Cell> > cells;
+  size_t mem_size;
+};
+
+/**
+ * Process wide cache of decoded CM93 cells, shared by all cm93chart scales.
+ *
+ * Reading and decoding cells is done either on the calling thread by Get(),
+ * or ahead of time by worker threads for the cells passed to Prefetch().
+ * Cells are kept within a memory budget and dropped least recently used
+ * first; a cell set stays valid while a caller holds it.
+ */
+class CM93CellCache {
+public:
+  static CM93CellCache &GetInstance();
+  ~CM93CellCache();
+
+  /**
+   * Return the cells of request, reading them on the calling thread unless
+   * they are cached. Waits if a worker is currently reading them.
+   */
+  std::shared_ptr<const CM93CellSet> Get(const CM93CellRequest &request);
+
+  /** True if Get() would return without reading files. */
+  bool IsCached(const CM93CellRequest &request);
+
+  /**
+   * Queue requests for the workers, ahead of the requests already queued.
+   * If notify is set, the ready callback is run once all the requests
+   * queued with notify have been loaded. Older requests beyond a cap are
+   * dropped, but never the ones queued with notify.
+   */
+  void Prefetch(const std::vector<CM93CellRequest> &requests, bool notify);
+
+  void SetMemoryBudget(size_t bytes);
+  /**
+   * Set the function run when the requests queued with notify are loaded,
+   * on the thread which loaded the last of them.
+   */
+  void SetReadyCallback(std::function<void()> callback);
+
+private:
+  CM93CellCache();
+
+  struct Entry {
+    Entry() : loading(false), notify(false) {}
+
+    std::shared_ptr<const CM93CellSet> cells;
+    bool loading;
+    bool notify;  // the ready callback waits for this entry
+    std::list<std::string>::iterator lru;
+  };
+
+  struct Pending {
+    CM93CellRequest request;
+    std::string key;
+    bool notify;
+  };
+
+  static std::shared_ptr<const CM93CellSet> LoadCells(
+      const CM93CellRequest &request);
+  /** Return true if the ready callback is due. */
+  bool Store(const std::string &key, std::shared_ptr<const CM93CellSet> cells);
+  void RunReadyCallback(std::unique_lock<std::mutex> &lock);
+  void Evict();
+  bool HasNotifyPending() const;
+  void StartWorkers();
+  void Run();
+
+  std::mutex m_mutex;  // protects everything below
+  std::condition_variable m_work_cv;
+  std::condition_variable m_done_cv;
+  std::unordered_map<std::string, Entry> m_entries;
+  std::list<std::string> m_lru;  // cached keys, most recently used first
+  std::deque<Pending> m_queue;
+  size_t m_mem_size;
+  size_t m_mem_budget;
+  int m_notify_in_flight;
+  std::function<void()> m_ready_callback;
+
+  std::vector<std::thread> m_workers;
+  bool m_stop;
+};
+
+#endif
@@ -203,6 +203,8 @@ protected:
   void RenderScene(bool bRenderCharts = true, bool bRenderOverlays = true);
 
   void RenderGLAlertMessage();
+  /** Draw RenderStats pass timings, see ShowRenderStats config option. */
+  void DrawRenderStats();
 
   void RenderQuiltViewGL(ViewPort &vp, const OCPNRegion &rect_region);
   void RenderQuiltViewGLText(ViewPort &vp, const OCPNRegion &rect_region);
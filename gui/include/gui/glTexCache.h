@@ -26,19 +26,17 @@
 #define __GLTEXTCACHE_H__
 
 #include <wx/glcanvas.h>
-#include <wx/ffile.h>
 #include <wx/timer.h>
 #include <stdint.h>
 
 #include "model/ocpn_types.h"
+#include "model/tex_cache_file.h"
 #include "color_types.h"
 #include "bbox.h"
 #include "viewport.h"
 
 class glTextureDescriptor;
 
-#define COMPRESSED_CACHE_MAGIC 0xf013  // change this when the format changes
-
 #define FACTORY_TIMER 10000
 
 void HalfScaleChartBits(int width, int height, unsigned char *source,
@@ -47,44 +45,6 @@ void HalfScaleChartBits(int width, int height, unsigned char *source,
 class ChartBaseBSB;
 class ChartPlugInWrapper;
 
-struct CompressedCacheHeader {
-  uint32_t magic;
-  uint32_t format;
-  uint32_t chartdate;
-  uint32_t m_nentries;
-  uint32_t catalog_offset;
-  uint32_t chartfile_date;
-  uint32_t chartfile_size;
-};
-
-struct CatalogEntryKey {
-  int mip_level;
-  ColorScheme tcolorscheme;
-  int x;
-  int y;
-};
-
-struct CatalogEntryValue {
-  int texture_offset;
-  uint32_t compressed_size;
-};
-
-#define CATALOG_ENTRY_SERIAL_SIZE 6 * sizeof(uint32_t)
-
-class CatalogEntry {
-public:
-  CatalogEntry();
-  ~CatalogEntry();
-  CatalogEntry(int level, int x0, int y0, ColorScheme colorscheme);
-  int GetSerialSize();
-  void Serialize(unsigned char *);
-  void DeSerialize(unsigned char *);
-  CatalogEntryKey k;
-  CatalogEntryValue v;
-};
-
-WX_DEFINE_ARRAY(CatalogEntry *, ArrayOfCatalogEntries);
-
 class glTexTile {
 public:
   glTexTile() {
@@ -148,42 +108,28 @@ public:
   void GetCenter(double &lat, double &lon) { lat = m_clat, lon = m_clon; }
 
 private:
-  bool LoadCatalog(void);
-  bool LoadHeader(void);
-  bool WriteCatalogAndHeader();
-
-  bool UpdateCachePrecomp(unsigned char *data, int data_size,
-                          const wxRect &rect, int level,
-                          ColorScheme color_scheme, bool write_catalog = true);
+  bool OpenCacheFile();
+  const unsigned char *GetCachedLevel(const wxRect &rect, int level,
+                                      ColorScheme color_scheme);
   bool UpdateCacheLevel(const wxRect &rect, int level, ColorScheme color_scheme,
-                        unsigned char *data, int size);
+                        const unsigned char *data, int size);
 
   void DeleteSingleTexture(glTextureDescriptor *ptd);
 
-  CatalogEntryValue *GetCacheEntryValue(int level, int x, int y,
-                                        ColorScheme color_scheme);
-  bool AddCacheEntryValue(const CatalogEntry &p);
   int ArrayIndex(int x, int y) const {
     return ((y / m_tex_dim) * m_stride) + (x / m_tex_dim);
   }
-  void ArrayXY(wxRect *r, int index) const;
-
-  int n_catalog_entries;
-
-  CatalogEntryValue *m_cache[N_COLOR_SCHEMES][MAX_TEX_LEVEL];
 
   wxString m_ChartPath;
   wxString m_HashKey;
   wxString m_CompressedCacheFilePath;
 
-  int m_catalog_offset;
-  bool m_hdrOK;
-  bool m_catalogOK;
-  bool m_newCatalog;
-
-  bool m_catalogCorrupted;
+  TexCacheFile m_cache_file;
+  std::vector<unsigned char> m_staging;  ///< Cached level, ready for upload
+  bool m_cacheFileFailed;
+  bool m_newCache;
+  unsigned m_cacheCorruptLogged;
 
-  wxFFile *m_fs;
   uint32_t m_chart_date_binary;
   uint32_t m_chartfile_date_binary;
   uint32_t m_chartfile_size;
@@ -27,6 +27,10 @@
 #ifndef __GLTEXTUREMANAGER_H__
 #define __GLTEXTUREMANAGER_H__
 
+#include <functional>
+#include <string>
+#include <vector>
+
 const wxEventType wxEVT_OCPN_COMPRESSIONTHREAD = wxNewEventType();
 
 class JobTicket;
@@ -34,18 +38,6 @@ class wxGenericProgressDialog;
 
 WX_DECLARE_LIST(JobTicket, JobList);
 
-class ProgressInfoItem;
-WX_DECLARE_LIST(ProgressInfoItem, ProgressInfoList);
-
-class ProgressInfoItem {
-public:
-  ProgressInfoItem(){};
-  ~ProgressInfoItem(){};
-
-  wxString file_path;
-  wxString msgx;
-};
-
 class CompressionPoolThread : public wxThread {
 public:
   CompressionPoolThread(JobTicket *ticket, wxEvtHandler *message_target);
@@ -68,8 +60,6 @@ public:
   wxEvent *Clone() const;
 
   int type;
-  int nstat;
-  int nstat_max;
 
 private:
   JobTicket *m_ticket;
@@ -80,8 +70,8 @@ class JobTicket {
 public:
   JobTicket();
   ~JobTicket() { free(level0_bits); }
-  bool DoJob();
   bool DoJob(const wxRect &rect);
+  void FreeCompressedBits();
 
   glTexFactory *pFact;
   wxRect m_rect;
@@ -99,7 +89,24 @@ public:
   bool binplace;
   unsigned char *compcomp_bits_array[10];
   int compcomp_size_array[10];
-  bool b_inCompressAll;
+};
+
+/** Progress of glTextureManager::CompressAllCharts(). */
+struct CacheBuildStatus {
+  /** A chart with tiles being compressed. */
+  struct Chart {
+    wxString path;
+    int tiles_done;
+    int tiles_total;
+  };
+
+  int charts_done;   ///< Charts scheduled, or found complete in the cache
+  int charts_total;
+  double distance;   ///< Of the last scheduled chart from ownship, NMi
+  long tiles_done;   ///< Of all charts scheduled so far
+  long tiles_total;
+  long tiles_compressed;  ///< Tiles done and stored in the cache
+  std::vector<Chart> active;
 };
 
 //      This is a hashmap with Chart full path as key, and glTexFactory as value
@@ -126,8 +133,23 @@ public:
   bool PurgeChartTextures(ChartBase *pc, bool b_purge_factory = false);
   bool TextureCrunch(double factor);
   bool FactoryCrunch(double factor);
+  /** Compress all raster charts into the cache, showing a progress dialog. */
   void BuildCompressedCache();
 
+  /**
+   * Compress all raster charts into the cache without user interaction,
+   * logging progress. Interrupted builds continue where they stopped.
+   * Return false if the OpenGL setup does not support the cache.
+   */
+  bool BuildCompressedCacheBatch();
+
+  /**
+   * Set up the compressed texture format, "dxt1" or "etc1", for
+   * BuildCompressedCacheBatch() without an OpenGL context, as
+   * glChartCanvas::SetupCompression() would find it on a display.
+   */
+  static bool SetupBatchCompression(const std::string &format);
+
   //    This is a hash table
   //    key is Chart full path
   //    Value is glTexFactory*
@@ -137,6 +159,9 @@ private:
   bool DoJob(JobTicket *pticket);
   bool DoThreadJob(JobTicket *pticket);
   bool StartTopJob();
+  bool CompressAllCharts(
+      const std::function<bool(const CacheBuildStatus &)> &progress);
+  void CreateCacheProgressDialog(int count);
 
   JobList running_list;
   JobList todo_list;
@@ -147,11 +172,7 @@ private:
   wxTimer m_timer;
   size_t m_ticks;
   wxGenericProgressDialog *m_progDialog;
-  wxString m_progMsg;
-  unsigned int m_jcnt;
-  ProgressInfoList progList;
   bool m_skip;
-  bool m_skipout;
   bool m_bcompact;
 };
 
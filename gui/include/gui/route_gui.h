@@ -27,6 +27,8 @@
 #ifndef _ROUTE_GUI_H
 #define _ROUTE_GUI_H
 
+#include <vector>
+
 #include <wx/gdicmn.h>
 #include <wx/dc.h>
 
@@ -58,6 +60,9 @@ public:
                 SendToGpsDlg *dialog);
 
 private:
+  /** Positions of the route points, in route order. */
+  void GetPointLatLons(std::vector<double> &lat, std::vector<double> &lon);
+
   Route& m_route;
 };
 
@@ -0,0 +1,111 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Spatial index over the rendering rules of an S57 chart
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#ifndef S57_SPATIAL_INDEX_H
+#define S57_SPATIAL_INDEX_H
+
+#include <cstdint>
+#include <vector>
+
+#include "s52s57.h"
+#include "bbox.h"
+
+/** A rule returned by S57SpatialIndex::Query. */
+struct S57IndexHit {
+  ObjRazRules *rules;
+  uint32_t index;  // position of the rule in its razRules list
+};
+
+/**
+ * Uniform lat/lon grid over each razRules[prio][type] list of a chart,
+ * used to skip the objects outside the viewport when rendering and to
+ * limit pick queries to the objects near the cursor.
+ *
+ * A list is indexed on first use, and again after Invalidate(). Queries
+ * return the rules whose object bounding box may intersect the query box,
+ * in list order, so the S52 drawing order within a display priority is
+ * kept. The caller still performs the exact render or pick checks.
+ *
+ * Rendering expands the bounding box of point objects by their symbol and
+ * text extent. Update() must be called with the hits of a render pass so
+ * the grown boxes are indexed for the following queries.
+ */
+class S57SpatialIndex {
+public:
+  S57SpatialIndex() {}
+
+  /** Drop all lists, they are indexed again on the next query. */
+  void Clear();
+  /** Drop one list, called when rules are added to it. */
+  void Invalidate(int prio, int type);
+
+  /**
+   * Collect in hits the rules of list (prio, type) whose object bounding
+   * box intersects box, taking the +-360 degrees longitude wrap into
+   * account. head is the current head of the list.
+   */
+  void Query(ObjRazRules *head, int prio, int type, const LLBBox &box,
+             std::vector<S57IndexHit> &hits);
+
+  /** Index again the hits whose object bounding box has grown. */
+  void Update(int prio, int type, const std::vector<S57IndexHit> &hits);
+
+private:
+  struct Box {
+    double minlat, minlon, maxlat, maxlon;
+  };
+
+  struct Slot {
+    Slot() : built(false), head(nullptr), nx(0), ny(0), query_id(0) {}
+
+    bool built;
+    ObjRazRules *head;
+    std::vector<ObjRazRules *> rules;  // in list order
+    std::vector<Box> boxes;            // union of the indexed boxes
+    std::vector<uint8_t> in_large;
+    std::vector<uint32_t> stamp;  // query_id of the last query returning it
+
+    // Grid over the union of the boxes, cells hold rule indices
+    double lat0, lon0, lat1, lon1;
+    double inv_cell_lat, inv_cell_lon;
+    int nx, ny;
+    std::vector<std::vector<uint32_t> > cells;
+    // Rules spanning a large part of the grid, or outside of it
+    std::vector<uint32_t> large;
+
+    uint32_t query_id;
+  };
+
+  void Build(Slot &slot, ObjRazRules *head);
+  void Insert(Slot &slot, uint32_t index, const Box &old_box,
+              bool have_old_box);
+  void CellRange(const Slot &slot, const Box &box, int &ix0, int &iy0,
+                 int &ix1, int &iy1) const;
+  void Collect(Slot &slot, const Box &box, std::vector<S57IndexHit> &hits);
+
+  Slot m_slots[PRIO_NUM][LUPNAME_NUM];
+};
+
+#endif
@@ -44,10 +44,12 @@
 #include "S57ClassRegistrar.h"
 #include "S57Light.h"
 #include "S57Sector.h"
+#include "s57_spatial_index.h"
 #include "OCPNRegion.h"
 #include "ocpndc.h"
 #include "viewport.h"
 #include "SencManager.h"
+#include <list>
 #include <memory>
 #include "ocpn_plugin.h"
 #include <unordered_map>
@@ -285,6 +287,7 @@ protected:
   void AssembleLineGeometry(void);
 
   ObjRazRules *razRules[PRIO_NUM][LUPNAME_NUM];
+  S57SpatialIndex m_spatial_index;
   double m_next_safe_cnt;
 
 private:
@@ -323,6 +326,8 @@ private:
   void FreeObjectsAndRules();
   const char *getName(OGRFeature *feature);
 
+  /** Rules of razRules[prio][type] within the s52plib view box. */
+  void QueryVisibleRules(int prio, int type, std::vector<S57IndexHit> &hits);
   bool DoRenderOnGL(const wxGLContext &glc, const ViewPort &VPoint);
   bool DoRenderOnGLText(const wxGLContext &glc, const ViewPort &VPoint);
   bool DoRenderRegionViewOnGL(const wxGLContext &glc, const ViewPort &VPoint,
@@ -44,6 +44,7 @@ extern GLShaderProgram *ptexture_2D_shader_program[2];
 extern GLShaderProgram *pcircle_filled_shader_program[2];
 extern GLShaderProgram *ptexture_2DA_shader_program[2];
 extern GLShaderProgram *pring_shader_program[2];
+extern GLShaderProgram *pais_batch_shader_program[2];
 
 extern GLint texture_2DA_shader_program;
 
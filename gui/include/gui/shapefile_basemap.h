@@ -28,6 +28,7 @@
 #ifndef SHAPEFILE_BASEMAP_H
 #define SHAPEFILE_BASEMAP_H
 
+#include <atomic>
 #include <functional>
 #include <vector>
 #include <map>
@@ -94,6 +95,38 @@ enum Quality {
 typedef std::vector<wxRealPoint> contour;
 typedef std::vector<contour> contour_list;
 
+/// @brief Line segment between two positions, for batch land tests
+struct LandTestSegment {
+  double lat1;
+  double lon1;
+  double lat2;
+  double lon2;
+};
+
+/// @brief Land polygons of one basemap tile, read and tessellated once when
+/// the basemap is loaded
+struct BasemapMesh {
+  BasemapMesh(double lat, double lon) : ref_lat(lat), ref_lon(lon), vbo(0) {}
+
+  /// @brief Reference position, all coordinates are float offsets from it
+  double ref_lat;
+  double ref_lon;
+  /// @brief Ring outlines as (lon, lat) offset pairs without the closing
+  /// point. Ring i spans the pairs ring_starts[i] to ring_starts[i + 1]
+  std::vector<float> rings;
+  std::vector<size_t> ring_starts{0};
+  /// @brief Bounding box of each ring
+  std::vector<LLBBox> ring_boxes;
+  /// @brief Triangle list as (lon, lat) offset pairs
+  std::vector<float> triangles;
+  /// @brief Rings as mercator meters from the reference, built on first use
+  /// by the DC path
+  std::vector<float> rings_sm;
+  /// @brief GL buffer holding the triangles as mercator meters from the
+  /// reference, 0 until first drawn
+  unsigned int vbo;
+};
+
 /// @brief Basemap
 class ShapeBaseChart {
 public:
@@ -119,9 +152,9 @@ public:
     this->_reader = nullptr;
     this->_color = t._color;
     this->_dmod = t._dmod;
-    this->_loading = t._loading;
+    this->_loading = t._loading.load();
   }
-  ~ShapeBaseChart() { delete _reader; }
+  ~ShapeBaseChart();
 
   int _dmod;
 
@@ -135,34 +168,47 @@ public:
            quality_suffix + ".shp");
   }
 
+  /// @brief Check if the segment crosses a land polygon edge. Loads the
+  /// basemap and waits for it if needed, must then be called from the main
+  /// thread. Once loaded the test is read only and thread safe.
   bool CrossesLand(double &lat1, double &lon1, double &lat2, double &lon2);
 
+  /// @brief Start loading if not done yet, return true if loaded and usable.
+  /// If wait is false return false while still loading.
+  bool Loaded(bool wait);
+
 private:
   std::future<bool> _loaded;
-  bool _loading;
+  std::atomic<bool> _loading;
   bool _is_usable;
   bool _is_tiled;
   size_t _min_scale;
-  void DoDrawPolygonFilled(ocpnDC &pnt, ViewPort &vp,
-                           const shp::Feature &feature);
-  void DoDrawPolygonFilledGL(ocpnDC &pnt, ViewPort &vp,
-                             const shp::Feature &feature);
+  void AddFeature(BasemapMesh &mesh, const shp::Feature &feature);
+  void DoDrawPolygonFilled(ocpnDC &pnt, ViewPort &vp, BasemapMesh &mesh,
+                           double lon_shift);
+  void DoDrawPolygonFilledGL(ocpnDC &pnt, ViewPort &vp, BasemapMesh &mesh,
+                             double lon_shift);
   void DrawPolygonFilled(ocpnDC &pnt, ViewPort &vp);
-    void AddPointToTessList(shp::Point &point, ViewPort &vp, GLUtesselator *tobj, bool idl);
 
   std::string _filename;
   shp::ShapefileReader *_reader;
-  std::unordered_map<LatLonKey, std::vector<size_t>> _tiles;
+  /// @brief Meshes of all tiles, a single one if the basemap is not tiled
+  std::vector<BasemapMesh> _meshes;
+  /// @brief Index in _meshes of each tile
+  std::unordered_map<LatLonKey, size_t> _tiles;
   wxColor _color;
+  /// @brief Projected points reused by the draw methods
+  std::vector<wxPoint> _dc_points;
+  std::vector<float> _gl_points;
 
   bool LineLineIntersect(const std::pair<double, double> &A,
                          const std::pair<double, double> &B,
                          const std::pair<double, double> &C,
-                         const std::pair<double, double> &D);
+                         const std::pair<double, double> &D) const;
 
-  bool PolygonLineIntersect(const shp::Feature &feature,
-                        const std::pair<double, double> &A,
-                        const std::pair<double, double> &B);
+  bool PolygonLineIntersect(const BasemapMesh &mesh, const LLBBox &box,
+                            const std::pair<double, double> &A,
+                            const std::pair<double, double> &B) const;
 };
 
 /// @brief Set of basemaps at different resolutions
@@ -185,6 +231,11 @@ public:
     return false;
   }
 
+  /// @brief Test many segments against the highest quality basemap, spread
+  /// over all cores. Element i of the result is true if segment i crosses
+  /// land. Must be called from the main thread.
+  std::vector<bool> CrossesLand(const std::vector<LandTestSegment> &segments);
+
   void Reset();
 
 private:
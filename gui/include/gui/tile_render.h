@@ -0,0 +1,87 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Batch rendering of XYZ chart tiles without OpenGL
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+/** \file tile_render.h Render chart tiles to PNG files or MBTiles. */
+
+#ifndef TILE_RENDER_H__
+#define TILE_RENDER_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "model/xyz_tiles.h"
+
+class ChartCanvas;
+
+/** Destination of encoded PNG tiles, Put() is called from worker threads. */
+class TileSink {
+public:
+  virtual ~TileSink() = default;
+
+  /** Store png as tile, return success. */
+  virtual bool Put(const TileId& tile,
+                   const std::vector<unsigned char>& png) = 0;
+
+  /** Flush all data, return success. */
+  virtual bool Close() { return true; }
+
+  /** Return a MBTiles or z/x/y.png directory sink for spec.output. */
+  static std::unique_ptr<TileSink> Create(const TileRenderSpec& spec);
+};
+
+/**
+ * Renders web mercator tiles using the quilt and s52plib DC renderer of a
+ * chart canvas in the running GUI, without OpenGL.
+ *
+ * Charts, the chart cache and s52plib are not thread safe: tiles are
+ * rendered one by one on the main thread while PNG encoding and writing
+ * runs on a pool with one thread per core. Tiles without charts are
+ * skipped. The canvas viewport is restored when done.
+ *
+ * This is a batch tool for a desktop or a virtual display such as
+ * xvfb-run, not a render server: the canvas, its charts and the wxMemoryDC
+ * need the GUI, and rendering itself uses one core. A display free renderer
+ * rendering on all cores would need chart and s52plib instances per thread.
+ * It is not provided.
+ */
+class TileRenderer {
+public:
+  explicit TileRenderer(ChartCanvas* canvas, int tile_size = 256);
+
+  /** Render all tiles in spec, return number of tiles written or -1. */
+  int Run(const TileRenderSpec& spec);
+
+private:
+  /** Render tile into rgb, return false if there is no chart data. */
+  bool RenderTile(const TileId& tile, std::vector<unsigned char>& rgb);
+
+  ChartCanvas* m_canvas;
+  const int m_tile_size;
+};
+
+/** Run the --render_tiles spec on canvas, return success. */
+bool RenderTiles(ChartCanvas* canvas, const std::string& spec);
+
+#endif  // TILE_RENDER_H__
@@ -27,6 +27,7 @@
 #define _TRACK_GUI_H
 
 #include <list>
+#include <vector>
 
 #include "bbox.h"
 #include "chcanv.h"
@@ -49,8 +50,7 @@ public:
   void Draw(ChartCanvas* cc, ocpnDC& dc, ViewPort& VP, const LLBBox& box);
 
 protected:
-  void Segments(ChartCanvas *cc, std::list<std::list<wxPoint> > &pointlists,
-                const LLBBox &box, double scale);
+  void Segments(std::vector<int> &points, const LLBBox &box, double scale);
 
 private:
   Track& m_track;
@@ -58,10 +58,12 @@ private:
                      std::list<std::list<wxPoint> > &pointlists, ViewPort &VP,
                      const LLBBox &box);
   void Finalize();
-  void Assemble(ChartCanvas *cc, std::list<std::list<wxPoint> > &pointlists,
-                const LLBBox &box, double scale, int &last, int level, int pos);
-  void AddPointToList(ChartCanvas *cc,
-                      std::list<std::list<wxPoint> > &pointlists, int n);
+  bool DrawGL(ChartCanvas *cc, ocpnDC &dc, const wxColour &col, int width,
+              wxPenStyle style, int hilite_width);
+  void Assemble(std::vector<int> &points, const LLBBox &box, double scale,
+                int &last, int level, int pos);
+  void AddPointToList(std::list<std::list<wxPoint> > &pointlists,
+                      const wxPoint &r);
   void AddPointToLists(ChartCanvas *cc,
                        std::list<std::list<wxPoint> > &pointlists, int &last,
                        int n);
@@ -88,6 +88,13 @@ public:
   }
   void GetLLFromPix(const wxPoint2DDouble &p, double *lat, double *lon);
   wxPoint2DDouble GetDoublePixFromLL(double lat, double lon);
+  /**
+   * Project count positions, with the same results as GetDoublePixFromLL()
+   * on each of them. The projection setup is done once for the whole array,
+   * use this for polylines and other large point sets.
+   */
+  void GetDoublePixFromLL(const double *lat, const double *lon, int count,
+                          wxPoint2DDouble *r);
 
   LLRegion GetLLRegion(const OCPNRegion &region);
   OCPNRegion GetVPRegionIntersect(const OCPNRegion &region,
@@ -170,6 +177,10 @@ private:
 
   bool bValid;  // This VP is valid
 
+  void UpdateProjectionCache();
+  void ProjectBlock(const double *lat, const double *lon, int count,
+                    double *easting, double *northing);
+
   double lat0_cache, cache0, cache1;
 };
 
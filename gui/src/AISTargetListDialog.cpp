@@ -34,6 +34,8 @@
 #include "model/ais_decoder.h"
 #include "model/ais_state_vars.h"
 #include "model/ais_target_data.h"
+#include "model/config_vars.h"
+#include "model/own_ship.h"
 #include "model/route_point.h"
 #include "model/select.h"
 
@@ -46,8 +48,6 @@
 #include "routemanagerdialog.h"
 #include "styles.h"
 
-static AisDecoder *s_p_sort_decoder;
-
 extern int g_AisTargetList_count;
 extern bool g_bAisTargetList_autosort;
 extern ocpnStyle::StyleManager *g_StyleManager;
@@ -65,251 +65,147 @@ END_EVENT_TABLE()
 
 static bool g_bsort_once;
 
-static int ItemCompare(AisTargetData *pAISTarget1,
-                       AisTargetData *pAISTarget2) {
-  wxString s1, s2;
-  double n1 = 0.;
-  double n2 = 0.;
-  bool b_cmptype_num = false;
-
-  //    Don't sort unless requested
-  if (!g_bAisTargetList_autosort && !g_bsort_once) return 0;
-
-  AisTargetData *t1 = pAISTarget1;
-  AisTargetData *t2 = pAISTarget2;
-
-  if (t1->Class == AIS_SART) {
-    if (t2->Class == AIS_DSC)
-      return 0;
-    else
-      return -1;
-  }
-
-  if (t2->Class == AIS_SART) {
-    if (t1->Class == AIS_DSC)
-      return 0;
-    else
-      return 1;
-  }
+/** Return the sort key of a target in the current sort column. */
+static AisListKey GetSortKey(AisTargetData *t) {
+  AisListKey key;
+  key.rank = t->Class == AIS_SART ? 0 : 1;
+  key.numeric = true;
+  key.range = t->Range_NM;
 
   switch (g_AisTargetList_sortColumn) {
     case tlTRK:
-      n1 = t1->b_show_track;
-      n2 = t2->b_show_track;
-      b_cmptype_num = true;
+      key.num = t->b_show_track;
       break;
 
     case tlNAME:
-      s1 = trimAISField(t1->ShipName);
-      if ((!t1->b_nameValid && (t1->Class == AIS_BASE)) ||
-          (t1->Class == AIS_SART))
-        s1 = _T("-");
-
-      s2 = trimAISField(t2->ShipName);
-      if ((!t2->b_nameValid && (t2->Class == AIS_BASE)) ||
-          (t2->Class == AIS_SART))
-        s2 = _T("-");
+      key.numeric = false;
+      key.str = trimAISField(t->ShipName);
+      if ((!t->b_nameValid && (t->Class == AIS_BASE)) ||
+          (t->Class == AIS_SART))
+        key.str = _T("-");
       break;
 
     case tlCALL:
-      s1 = trimAISField(t1->CallSign);
-      s2 = trimAISField(t2->CallSign);
+      key.numeric = false;
+      key.str = trimAISField(t->CallSign);
       break;
 
     case tlMMSI:
-      n1 = t1->MMSI;
-      n2 = t2->MMSI;
-      b_cmptype_num = true;
+      key.num = t->MMSI;
       break;
 
     case tlCLASS:
-      s1 = t1->Get_class_string(true);
-      s2 = t2->Get_class_string(true);
+      key.numeric = false;
+      key.str = t->Get_class_string(true);
       break;
 
     case tlTYPE:
-      s1 = t1->Get_vessel_type_string(false);
-      if ((t1->Class == AIS_BASE) ||
-          (t1->Class == AIS_SART || (t1->Class == AIS_METEO)))
-        s1 = _T("-");
-
-      s2 = t2->Get_vessel_type_string(false);
-      if ((t1->Class == AIS_BASE) || (t1->Class == AIS_SART) ||
-          (t1->Class == AIS_METEO))
-        s2 = _T("-");
+      key.numeric = false;
+      key.str = t->Get_vessel_type_string(false);
+      if ((t->Class == AIS_BASE) || (t->Class == AIS_SART) ||
+          (t->Class == AIS_METEO))
+        key.str = _T("-");
       break;
 
     case tlNAVSTATUS: {
-      if ((t1->NavStatus <= 15) && (t1->NavStatus >= 0)) {
-        if (t1->Class == AIS_SART) {
-          if (t1->NavStatus == RESERVED_14)
-            s1 = _("Active");
-          else if (t1->NavStatus == UNDEFINED)
-            s1 = _("Testing");
-        } else
-          s1 = ais_get_status(t1->NavStatus);
-      } else
-        s1 = _("-");
-
-      if ((t1->Class == AIS_ATON) || (t1->Class == AIS_BASE) ||
-          (t1->Class == AIS_CLASS_B) || (t1->Class == AIS_METEO)) s1 = _T("-");
-
-      if ((t2->NavStatus <= 15) && (t2->NavStatus >= 0)) {
-        if (t2->Class == AIS_SART) {
-          if (t2->NavStatus == RESERVED_14)
-            s2 = _("Active");
-          else if (t2->NavStatus == UNDEFINED)
-            s2 = _("Testing");
+      key.numeric = false;
+      if ((t->NavStatus <= 15) && (t->NavStatus >= 0)) {
+        if (t->Class == AIS_SART) {
+          if (t->NavStatus == RESERVED_14)
+            key.str = _("Active");
+          else if (t->NavStatus == UNDEFINED)
+            key.str = _("Testing");
         } else
-          s2 = ais_get_status(t2->NavStatus);
+          key.str = ais_get_status(t->NavStatus);
       } else
-        s2 = _("-");
-
-      if ((t2->Class == AIS_ATON) || (t2->Class == AIS_BASE) ||
-          (t2->Class == AIS_CLASS_B) || (t2->Class == AIS_METEO)) s2 = _T("-");
+        key.str = _("-");
 
+      if ((t->Class == AIS_ATON) || (t->Class == AIS_BASE) ||
+          (t->Class == AIS_CLASS_B) || (t->Class == AIS_METEO))
+        key.str = _T("-");
       break;
     }
 
     case tlBRG: {
-      int brg1 = wxRound(t1->Brg);
-      if (brg1 == 360)
-        n1 = 0.;
-      else
-        n1 = brg1;
-
-      int brg2 = wxRound(t2->Brg);
-      if (brg2 == 360)
-        n2 = 0.;
-      else
-        n2 = brg2;
-
-      b_cmptype_num = true;
+      int brg = wxRound(t->Brg);
+      key.num = brg == 360 ? 0. : brg;
       break;
     }
 
     case tlCOG: {
-      if ((t1->COG >= 360.0) || (t1->Class == AIS_ATON) ||
-          (t1->Class == AIS_BASE) || (t1->Class == AIS_METEO))
-        n1 = -1.0;
+      if ((t->COG >= 360.0) || (t->Class == AIS_ATON) ||
+          (t->Class == AIS_BASE) || (t->Class == AIS_METEO))
+        key.num = -1.0;
       else {
-        int crs = wxRound(t1->COG);
-        if (crs == 360)
-          n1 = 0.;
-        else
-          n1 = crs;
+        int crs = wxRound(t->COG);
+        key.num = crs == 360 ? 0. : crs;
       }
-
-      if ((t2->COG >= 360.0) || (t2->Class == AIS_ATON) ||
-          (t2->Class == AIS_BASE) || (t2->Class == AIS_METEO))
-        n2 = -1.0;
-      else {
-        int crs = wxRound(t2->COG);
-        if (crs == 360)
-          n2 = 0.;
-        else
-          n2 = crs;
-      }
-
-      b_cmptype_num = true;
       break;
     }
 
     case tlSOG: {
-      if ((t1->SOG > 100.) || (t1->Class == AIS_ATON) ||
-          (t1->Class == AIS_BASE) || (t1->Class == AIS_METEO))
-        n1 = -1.0;
+      if ((t->SOG > 100.) || (t->Class == AIS_ATON) ||
+          (t->Class == AIS_BASE) || (t->Class == AIS_METEO))
+        key.num = -1.0;
       else
-        n1 = t1->SOG;
-
-      if ((t2->SOG > 100.) || (t2->Class == AIS_ATON) ||
-          (t2->Class == AIS_BASE) || (t2->Class == AIS_METEO))
-        n2 = -1.0;
-      else
-        n2 = t2->SOG;
-
-      b_cmptype_num = true;
+        key.num = t->SOG;
       break;
     }
     case tlCPA: {
-      if ((!t1->bCPA_Valid) || (t1->Class == AIS_ATON) ||
-          (t1->Class == AIS_BASE) || (t1->Class == AIS_METEO))
-        n1 = 99999.0;
+      if ((!t->bCPA_Valid) || (t->Class == AIS_ATON) ||
+          (t->Class == AIS_BASE) || (t->Class == AIS_METEO))
+        key.num = 99999.0;
       else
-        n1 = t1->CPA;
-
-      if ((!t2->bCPA_Valid) || (t2->Class == AIS_ATON) ||
-          (t2->Class == AIS_BASE))
-        n2 = 99999.0;
-      else
-        n2 = t2->CPA;
-
-      b_cmptype_num = true;
+        key.num = t->CPA;
       break;
     }
     case tlTCPA: {
-      if ((!t1->bCPA_Valid) || (t1->Class == AIS_ATON) ||
-          (t1->Class == AIS_BASE) || (t1->Class == AIS_METEO))
-        n1 = 99999.0;
-      else
-        n1 = t1->TCPA;
-
-      if ((!t2->bCPA_Valid) || (t2->Class == AIS_ATON) ||
-          (t2->Class == AIS_BASE) || (t2->Class == AIS_METEO))
-        n2 = 99999.0;
+      if ((!t->bCPA_Valid) || (t->Class == AIS_ATON) ||
+          (t->Class == AIS_BASE) || (t->Class == AIS_METEO))
+        key.num = 99999.0;
       else
-        n2 = t2->TCPA;
-
-      b_cmptype_num = true;
+        key.num = t->TCPA;
       break;
     }
     case tlRNG: {
-      n1 = t1->Range_NM;
-      n2 = t2->Range_NM;
-      b_cmptype_num = true;
+      key.num = t->Range_NM;
       break;
     }
 
     default:
       break;
   }
-
-  if (!b_cmptype_num) {
-    if (g_bAisTargetList_sortReverse) return s2.Cmp(s1);
-    return s1.Cmp(s2);
-  } else {
-    //    If numeric sort values are equal, secondary sort is on Range_NM
-    if (g_bAisTargetList_sortReverse) {
-      if (n2 > n1)
-        return 1;
-      else if (n2 < n1)
-        return -1;
-      else
-        return (t1->Range_NM > t2->Range_NM);  // 0;
-    } else {
-      if (n2 > n1)
-        return -1;
-      else if (n2 < n1)
-        return 1;
-      else
-        return (t1->Range_NM > t2->Range_NM);  // 0;
-    }
-  }
+  return key;
 }
 
-static int ArrayItemCompareMMSI(int MMSI1, int MMSI2) {
-  if (s_p_sort_decoder) {
-    std::shared_ptr<AisTargetData> pAISTarget1 =
-        s_p_sort_decoder->Get_Target_Data_From_MMSI(MMSI1);
-    std::shared_ptr<AisTargetData> pAISTarget2 =
-        s_p_sort_decoder->Get_Target_Data_From_MMSI(MMSI2);
-
-    if (pAISTarget1 && pAISTarget2)
-      return ItemCompare(pAISTarget1.get(), pAISTarget2.get());
-    else
-      return 0;
-  } else
-    return 0;
+/**
+ * Return a hash of everything OCPNListCtrl::GetTargetColumnData() shows
+ * for a target, used to invalidate the cached cell texts.
+ */
+static uint64_t GetRowFingerprint(AisTargetData *t) {
+  uint64_t hash = 14695981039346656037ULL;
+  auto add = [&hash](const void *data, size_t size) {
+    auto bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; i++) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ULL;
+    }
+  };
+  add(t->ShipName, strnlen(t->ShipName, SHIP_NAME_LEN));
+  add(t->ShipNameExtension,
+      strnlen(t->ShipNameExtension, sizeof(t->ShipNameExtension)));
+  add(t->CallSign, strnlen(t->CallSign, CALL_SIGN_LEN));
+  int ints[] = {t->MMSI,          t->Class,          t->NavStatus,
+                t->ShipType,      t->UN_shiptype,    t->b_isEuroInland,
+                t->b_show_track,  t->b_NoTrack,      t->b_nameValid,
+                t->b_SarAircraftPosnReport,          t->b_positionOnceValid,
+                t->bCPA_Valid,    bGPSValid,         g_iSpeedFormat,
+                g_iDistanceFormat};
+  add(ints, sizeof(ints));
+  double doubles[] = {t->Brg, t->Lat, t->COG, t->SOG,
+                      t->CPA, t->TCPA, t->Range_NM};
+  add(doubles, sizeof(doubles));
+  return hash;
 }
 
 AISTargetListDialog::AISTargetListDialog(wxWindow *parent, wxAuiManager *auimgr,
@@ -320,14 +216,10 @@ AISTargetListDialog::AISTargetListDialog(wxWindow *parent, wxAuiManager *auimgr,
   m_pAuiManager = auimgr;
   m_pdecoder = pdecoder;
   g_bsort_once = false;
-  m_bautosort_force = false;
 
   wxFont *qFont = GetOCPNScaledFont(_("Dialog"));
   SetFont(*qFont);
 
-  s_p_sort_decoder = pdecoder;
-  m_pMMSI_array = new ArrayOfMMSI(ArrayItemCompareMMSI);
-
   CreateControls();
 
   // Set default color for panel, respecting Dark mode if enabled
@@ -849,7 +741,7 @@ void AISTargetListDialog::UpdateButtons() {
   m_pButtonInfo->Enable(enable);
 
   if (m_pdecoder && item != -1) {
-    auto pAISTargetSel =  m_pdecoder->Get_Target_Data_From_MMSI(m_pMMSI_array->Item(item));
+    auto pAISTargetSel =  m_pdecoder->Get_Target_Data_From_MMSI(m_rows.GetMmsi(item));
     if (pAISTargetSel && (!pAISTargetSel->b_positionOnceValid)) enable = false;
   }
   m_pButtonJumpTo->Enable(enable);
@@ -883,7 +775,7 @@ void AISTargetListDialog::OnTargetQuery(wxCommandEvent &event) {
   if (selItemID == -1) return;
 
   if (m_pdecoder) {
-    auto pAISTarget = m_pdecoder->Get_Target_Data_From_MMSI(m_pMMSI_array->Item(selItemID));
+    auto pAISTarget = m_pdecoder->Get_Target_Data_From_MMSI(m_rows.GetMmsi(selItemID));
     if (pAISTarget) DoTargetQuery(pAISTarget->MMSI);
   }
 }
@@ -891,8 +783,6 @@ void AISTargetListDialog::OnTargetQuery(wxCommandEvent &event) {
 void AISTargetListDialog::OnAutosortCB(wxCommandEvent &event) {
   g_bAisTargetList_autosort = m_pCBAutosort->GetValue();
 
-  m_bautosort_force = g_bAisTargetList_autosort;
-
   if (!g_bAisTargetList_autosort) {
     wxListItem item;
     item.SetMask(wxLIST_MASK_IMAGE);
@@ -906,6 +796,7 @@ void AISTargetListDialog::OnAutosortCB(wxCommandEvent &event) {
 
     if (g_AisTargetList_sortColumn >= 0) {
       m_pListCtrlAISTargets->SetColumn(g_AisTargetList_sortColumn, item);
+      g_bsort_once = true;
       UpdateAISTargetList();
     }
   }
@@ -925,7 +816,7 @@ void AISTargetListDialog::OnTargetListColumnClicked(wxListEvent &event) {
   }
   item.SetImage(g_bAisTargetList_sortReverse ? 1 : 0);
 
-  if (!g_bAisTargetList_autosort) g_bsort_once = true;
+  g_bsort_once = true;
 
   if (g_AisTargetList_sortColumn >= 0) {
     m_pListCtrlAISTargets->SetColumn(g_AisTargetList_sortColumn, item);
@@ -950,7 +841,7 @@ void AISTargetListDialog::OnTargetCreateWpt(wxCommandEvent &event) {
   std::shared_ptr<AisTargetData> pAISTarget = NULL;
   if (m_pdecoder)
     pAISTarget =
-        m_pdecoder->Get_Target_Data_From_MMSI(m_pMMSI_array->Item(selItemID));
+        m_pdecoder->Get_Target_Data_From_MMSI(m_rows.GetMmsi(selItemID));
 
   if (pAISTarget) {
     RoutePoint *pWP =
@@ -1008,7 +899,7 @@ void AISTargetListDialog::OnToggleTrack(wxCommandEvent &event) {
   std::shared_ptr<AisTargetData> pAISTarget = NULL;
   if (m_pdecoder)
     pAISTarget =
-        m_pdecoder->Get_Target_Data_From_MMSI(m_pMMSI_array->Item(selItemID));
+        m_pdecoder->Get_Target_Data_From_MMSI(m_rows.GetMmsi(selItemID));
 
   if (pAISTarget) {
     pAISTarget->b_show_track = !pAISTarget->b_show_track;
@@ -1021,7 +912,7 @@ void AISTargetListDialog::OnCopyMMSI(wxCommandEvent &event) {
   selItemID = m_pListCtrlAISTargets->GetNextItem(selItemID, wxLIST_NEXT_ALL,
                                                  wxLIST_STATE_SELECTED);
   if (selItemID == -1) return;
-  CopyMMSItoClipBoard((int)m_pMMSI_array->Item(selItemID));
+  CopyMMSItoClipBoard((int)m_rows.GetMmsi(selItemID));
 }
 
 void AISTargetListDialog::CenterToTarget(bool close) {
@@ -1033,7 +924,7 @@ void AISTargetListDialog::CenterToTarget(bool close) {
   std::shared_ptr<AisTargetData> pAISTarget = NULL;
   if (m_pdecoder)
     pAISTarget =
-    m_pdecoder->Get_Target_Data_From_MMSI(m_pMMSI_array->Item(selItemID));
+    m_pdecoder->Get_Target_Data_From_MMSI(m_rows.GetMmsi(selItemID));
 
   if (pAISTarget) {
     double scale = gFrame->GetFocusCanvas()->GetVPScale();
@@ -1068,12 +959,53 @@ void AISTargetListDialog::OnLimitRange(wxCommandEvent &event) {
 
 std::shared_ptr<AisTargetData> AISTargetListDialog::GetpTarget(unsigned int list_item) {
   if (m_pdecoder)
-    return m_pdecoder->Get_Target_Data_From_MMSI(
-        m_pMMSI_array->Item(list_item));
+    return m_pdecoder->Get_Target_Data_From_MMSI(m_rows.GetMmsi(list_item));
   else
     return NULL;
 }
 
+wxString AISTargetListDialog::GetCellText(long item, long column) {
+  const wxString *cached = m_rows.GetCell(item, column);
+  if (cached) return *cached;
+  wxString text;
+  auto pAISTarget = GetpTarget(item);
+  if (pAISTarget) {
+    text = m_pListCtrlAISTargets->GetTargetColumnData(pAISTarget.get(), column);
+    m_rows.SetCell(item, column, text);
+  }
+  return text;
+}
+
+void AISTargetListDialog::SyncRows(bool show_lost) {
+  m_rows.SetReverse(g_bAisTargetList_sortReverse);
+  m_rows.SetAutosort(g_bAisTargetList_autosort);
+  m_rows.BeginSync();
+  for (const auto &it : m_pdecoder->GetTargetList()) {
+    auto pAISTarget = it.second;
+    if (NULL == pAISTarget) continue;
+
+    bool b_add = false;
+    if ((pAISTarget->b_positionOnceValid) &&
+        (pAISTarget->Range_NM <= g_AisTargetList_range))
+      b_add = true;
+    else if (!pAISTarget->b_positionOnceValid)
+      b_add = true;
+
+    // Do not show any "lost" targets in the list.
+    if (pAISTarget->b_lost && !show_lost) b_add = false;
+
+    if (b_add) {
+      m_rows.Update(pAISTarget->MMSI, GetSortKey(pAISTarget.get()),
+                    GetRowFingerprint(pAISTarget.get()));
+    }
+  }
+  m_rows.EndSync();
+  if (g_bsort_once) m_rows.Sort();
+  g_bsort_once = false;
+
+  g_AisTargetList_count = m_rows.Size();
+}
+
 void AISTargetListDialog::UpdateAISTargetList(void) {
   if (m_pListCtrlAISTargets && !m_pListCtrlAISTargets->IsVirtual())
     return UpdateNVAISTargetList();
@@ -1085,60 +1017,20 @@ void AISTargetListDialog::UpdateAISTargetList(void) {
                                                    wxLIST_STATE_SELECTED);
 
     int selMMSI = -1;
-    if (selItemID != -1) selMMSI = m_pMMSI_array->Item(selItemID);
+    if (selItemID != -1) selMMSI = m_rows.GetMmsi(selItemID);
 
-    const auto &current_targets = m_pdecoder->GetTargetList();
-    wxListItem item;
-
-    int index = 0;
-    m_pMMSI_array->Clear();
+    SyncRows(false);
 
-    for (auto it = current_targets.begin(); it != current_targets.end();
-         ++it, ++index) {
-      auto pAISTarget = it->second;
-      item.SetId(index);
-
-      if (NULL != pAISTarget) {
-        bool b_add = false;
-        if ((pAISTarget->b_positionOnceValid) &&
-            (pAISTarget->Range_NM <= g_AisTargetList_range))
-          b_add = true;
-        else if (!pAISTarget->b_positionOnceValid)
-          b_add = true;
-
-        // Do not show any "lost" targets in the list.
-        if (pAISTarget->b_lost)
-          b_add = false;
-
-        if (b_add) {
-          m_pMMSI_array->Add(pAISTarget->MMSI);
-        }
-      }
-    }
-
-    g_bsort_once = false;
-
-    m_pListCtrlAISTargets->SetItemCount(m_pMMSI_array->GetCount());
-
-    g_AisTargetList_count = m_pMMSI_array->GetCount();
-
-    if ((g_AisTargetList_count > 1000) && !m_bautosort_force)
-      g_bAisTargetList_autosort = false;
+    m_pListCtrlAISTargets->SetItemCount(m_rows.Size());
 
     m_pCBAutosort->SetValue(g_bAisTargetList_autosort);
 
     //    Restore selected item
     long item_sel = 0;
-    if ((selItemID != -1) && (selMMSI != -1)) {
-      for (unsigned int i = 0; i < m_pMMSI_array->GetCount(); i++) {
-        if (m_pMMSI_array->Item(i) == selMMSI) {
-          item_sel = i;
-          break;
-        }
-      }
-    }
+    if ((selItemID != -1) && (selMMSI != -1))
+      item_sel = wxMax(m_rows.FindRow(selMMSI), 0);
 
-    if (m_pMMSI_array->GetCount())
+    if (m_rows.Size())
       m_pListCtrlAISTargets->SetItemState(
           item_sel, wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED,
           wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED);
@@ -1146,7 +1038,7 @@ void AISTargetListDialog::UpdateAISTargetList(void) {
       m_pListCtrlAISTargets->DeleteAllItems();
 
     wxString count;
-    count.Printf(_T("%lu"), (unsigned long)m_pMMSI_array->GetCount());
+    count.Printf(_T("%lu"), (unsigned long)m_rows.Size());
     m_pTextTargetCount->ChangeValue(count);
 
 #ifdef __WXMSW__
@@ -1163,36 +1055,9 @@ void AISTargetListDialog::UpdateNVAISTargetList(void) {
                                                    wxLIST_STATE_SELECTED);
 
     int selMMSI = -1;
-    if (selItemID != -1) selMMSI = m_pMMSI_array->Item(selItemID);
-
-    const auto &current_targets = m_pdecoder->GetTargetList();
-    wxListItem item;
-
-    int index = 0;
-    m_pMMSI_array->Clear();
+    if (selItemID != -1) selMMSI = m_rows.GetMmsi(selItemID);
 
-    for (auto it = current_targets.begin(); it != current_targets.end();
-         ++it, ++index) {
-      auto pAISTarget = it->second;
-      item.SetId(index);
-
-      if (NULL != pAISTarget) {
-        bool b_add = false;
-        if ((pAISTarget->b_positionOnceValid) &&
-            (pAISTarget->Range_NM <= g_AisTargetList_range))
-          b_add = true;
-        else if (!pAISTarget->b_positionOnceValid)
-          b_add = true;
-
-        if (b_add) {
-          m_pMMSI_array->Add(pAISTarget->MMSI);
-        }
-      }
-    }
-
-    g_bsort_once = false;
-
-    g_AisTargetList_count = m_pMMSI_array->GetCount();
+    SyncRows(true);
 
     m_pListCtrlAISTargets->DeleteAllItems();
 
@@ -1202,28 +1067,19 @@ void AISTargetListDialog::UpdateNVAISTargetList(void) {
       m_pListCtrlAISTargets->InsertItem(item);
       for (int j = 0; j < tlTCPA + 1; j++) {
         item.SetColumn(j);
-        item.SetText(m_pListCtrlAISTargets->OnGetItemText(i, j));
+        item.SetText(GetCellText(i, j));
         m_pListCtrlAISTargets->SetItem(item);
       }
     }
 
-    if ((g_AisTargetList_count > 1000) && !m_bautosort_force)
-      g_bAisTargetList_autosort = false;
-
     m_pCBAutosort->SetValue(g_bAisTargetList_autosort);
 
     //    Restore selected item
     long item_sel = 0;
-    if ((selItemID != -1) && (selMMSI != -1)) {
-      for (unsigned int i = 0; i < m_pMMSI_array->GetCount(); i++) {
-        if (m_pMMSI_array->Item(i) == selMMSI) {
-          item_sel = i;
-          break;
-        }
-      }
-    }
+    if ((selItemID != -1) && (selMMSI != -1))
+      item_sel = wxMax(m_rows.FindRow(selMMSI), 0);
 
-    if (m_pMMSI_array->GetCount())
+    if (m_rows.Size())
       m_pListCtrlAISTargets->SetItemState(
           item_sel, wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED,
           wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED);
@@ -1231,7 +1087,7 @@ void AISTargetListDialog::UpdateNVAISTargetList(void) {
       m_pListCtrlAISTargets->DeleteAllItems();
 
     wxString count;
-    count.Printf(_T("%lu"), (unsigned long)m_pMMSI_array->GetCount());
+    count.Printf(_T("%lu"), (unsigned long)m_rows.Size());
     m_pTextTargetCount->ChangeValue(count);
 
 #ifdef __WXMSW__
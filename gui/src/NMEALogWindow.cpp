@@ -22,6 +22,10 @@
  ***************************************************************************
  */
 
+#include <chrono>
+
+#include <wx/app.h>
+
 #include "NMEALogWindow.h"
 #include "TTYWindow.h"
 #include "OCPNPlatform.h"
@@ -32,6 +36,8 @@
 
 extern OCPNPlatform *g_Platform;
 
+static const std::chrono::milliseconds kRepaintInterval(100);
+
 NMEALogWindow *NMEALogWindow::instance = NULL;
 
 NMEALogWindow &NMEALogWindow::GetInstance() {
@@ -63,12 +69,31 @@ void NMEALogWindow::Create(wxWindow *parent, int num_lines) {
     m_pos_y = wxMax(m_pos_y, 40);
 
     m_window->SetSize(m_pos_x, m_pos_y, m_width, m_height);
+
+    //  Text events from the filter control propagate to the window
+    m_pipeline.SetFilter("");
+    m_window->Bind(wxEVT_TEXT, [&](wxCommandEvent &ev) {
+      m_pipeline.SetFilter(ev.GetString().ToStdString());
+      ev.Skip();
+    });
+    m_pipeline.Start(num_lines, kRepaintInterval, [] {
+      wxTheApp->CallAfter([] { NMEALogWindow::GetInstance().ShowBatch(); });
+    });
   }
   m_window->Show();
 }
 
 void NMEALogWindow::Add(const wxString &s) {
-  if (m_window) m_window->Add(s);
+  if (m_window) m_pipeline.Push(NmeaLogEntry(s.ToStdString()));
+}
+
+void NMEALogWindow::Add(NmeaLogEntry &&entry) {
+  if (m_window) m_pipeline.Push(std::move(entry));
+}
+
+void NMEALogWindow::ShowBatch() {
+  NmeaLogBatch batch = m_pipeline.TakeBatch();
+  if (m_window) m_window->Add(batch.lines, batch.dropped);
 }
 
 void NMEALogWindow::Refresh(bool do_refresh) {
@@ -132,6 +157,7 @@ void NMEALogWindow::CheckPos(int display_width, int display_height) {
 
 void NMEALogWindow::DestroyWindow() {
   if (m_window) {
+    m_pipeline.Stop();
     UpdateGeometry();
     m_window->Destroy();
     m_window = NULL;
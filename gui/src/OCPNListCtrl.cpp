@@ -60,10 +60,8 @@ OCPNListCtrl::~OCPNListCtrl() {
 wxString OCPNListCtrl::OnGetItemText(long item, long column) const {
   wxString ret;
 
-  if (m_parent->m_pListCtrlAISTargets) {
-    auto pAISTarget = m_parent->GetpTarget(item);
-    if (pAISTarget) ret = GetTargetColumnData(pAISTarget.get(), column);
-  }
+  if (m_parent->m_pListCtrlAISTargets)
+    ret = m_parent->GetCellText(item, column);
 
   return ret;
 }
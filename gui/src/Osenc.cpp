@@ -49,6 +49,7 @@
 #include "mygeom.h"
 #include "model/georef.h"
 #include "gui_lib.h"
+#include <algorithm>
 #include <mutex>
 
 extern s57RegistrarMgr *m_pRegistrarMan;
@@ -62,8 +63,6 @@ using namespace std;
 #include <wx/arrimpl.cpp>
 WX_DEFINE_ARRAY(float *, MyFloatPtrArray);
 
-#define MAX_VECTOR_POINTS 1000
-
 #ifndef __WXMSW__
 sigjmp_buf env_osenc_ogrf;  // the context saved by sigsetjmp();
 #endif
@@ -2615,50 +2614,32 @@ void Osenc::CreateSENCVectorEdgeTableRecord200(Osenc_outstream *stream,
       pRun += sizeof(int);
 
       //  Transcribe points to a buffer
-      // We reduce the maximum number of points in the table to
-      // MAX_VECTOR_POINTS using a naive algorithm skipping the proportional
-      // part of them to avoid too deep a recursion and crash in DouglasPeucker
-      // later
-      int reduction_ratio = nPoints / MAX_VECTOR_POINTS + 1;
-      int reduced_points = 0;
-
-      double *ppd = (double *)malloc((nPoints / reduction_ratio + 1) * 2 *
-                                     sizeof(double));
+      double *ppd = (double *)malloc(nPoints * 2 * sizeof(double));
       double *ppr = ppd;
 
       for (int i = 0; i < nPoints; i++) {
-        if (i % reduction_ratio == 0) {
-          OGRPoint p;
-          pLS->getPoint(i, &p);
+        OGRPoint p;
+        pLS->getPoint(i, &p);
 
-          //  Calculate SM from chart common reference point
-          double easting, northing;
-          toSM(p.getY(), p.getX(), m_ref_lat, m_ref_lon, &easting, &northing);
+        //  Calculate SM from chart common reference point
+        double easting, northing;
+        toSM(p.getY(), p.getX(), m_ref_lat, m_ref_lon, &easting, &northing);
 
-          *ppr++ = easting;
-          *ppr++ = northing;
-          reduced_points++;
-        }
+        *ppr++ = easting;
+        *ppr++ = northing;
       }
-      nPoints = reduced_points;
 
       //      Reduce the LOD of this linestring
-      std::vector<int> index_keep;
+      std::vector<bool> keep;
+      int nPointReduced = nPoints;
       if (nPoints > 5 && (m_LOD_meters > .01)) {
-        index_keep.push_back(0);
-        index_keep.push_back(nPoints - 1);
-
-        DouglasPeucker(ppd, 0, nPoints - 1, m_LOD_meters, &index_keep);
-        //               printf("DP Reduction: %d/%d\n", index_keep.GetCount(),
-        //               nPoints);
-
+        LODReduce(ppd, 0, nPoints - 1, m_LOD_meters, keep);
+        nPointReduced = std::count(keep.begin(), keep.begin() + nPoints, true);
       } else {
-        index_keep.resize(nPoints);
-        for (int i = 0; i < nPoints; i++) index_keep[i] = i;
+        keep.assign(nPoints, true);
       }
 
       //  Store the point count in the payload
-      int nPointReduced = index_keep.size();
       *(int *)pRun = nPointReduced;
       pRun += sizeof(int);
 
@@ -2678,13 +2659,10 @@ void Osenc::CreateSENCVectorEdgeTableRecord200(Osenc_outstream *stream,
         double x = *ppr++;
         double y = *ppr++;
 
-        for (unsigned int j = 0; j < index_keep.size(); j++) {
-          if (index_keep[j] == ip) {
-            *npp_run++ = x;
-            *npp_run++ = y;
-            pRun += 2 * sizeof(float);
-            break;
-          }
+        if (keep[ip]) {
+          *npp_run++ = x;
+          *npp_run++ = y;
+          pRun += 2 * sizeof(float);
         }
       }
 
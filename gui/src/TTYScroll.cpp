@@ -45,21 +45,27 @@ TTYScroll::~TTYScroll() { delete m_plineArray; }
 void TTYScroll::Add(const wxString &line) {
   wxString filter = m_tFilter.GetValue();
   if (!bpause && (filter.IsEmpty() || line.Contains(filter))) {
-    if (m_plineArray->GetCount() > m_nLines - 1) {  // shuffle the arraystring
-      wxArrayString *p_newArray = new wxArrayString;
-
-      for (unsigned int i = 1; i < m_plineArray->GetCount(); i++)
-        p_newArray->Add(m_plineArray->Item(i));
-
-      delete m_plineArray;
-      m_plineArray = p_newArray;
-    }
+    if (m_plineArray->GetCount() > m_nLines - 1)  // shuffle the arraystring
+      m_plineArray->RemoveAt(0);
 
     m_plineArray->Add(line);
     Refresh(true);
   }
 }
 
+void TTYScroll::Add(const std::vector<std::string> &lines, uint64_t dropped) {
+  if (bpause) return;
+  if (dropped > 0)
+    m_plineArray->Add(
+        wxString::Format("<RED>... %llu lines dropped",
+                         static_cast<unsigned long long>(dropped)));
+  for (const auto &line : lines) m_plineArray->Add(wxString(line));
+
+  size_t count = m_plineArray->GetCount();
+  if (count > m_nLines) m_plineArray->RemoveAt(0, count - m_nLines);
+  Refresh(true);
+}
+
 void TTYScroll::OnDraw(wxDC &dc) {
   // update region is always in device coords, translate to logical ones
   wxRect rectUpdate = GetUpdateRegion().GetBox();
@@ -195,3 +195,7 @@ void TTYWindow::OnCloseWindow(wxCloseEvent&) {
 void TTYWindow::Add(const wxString& line) {
   if (m_tty_scroll) m_tty_scroll->Add(line);
 }
+
+void TTYWindow::Add(const std::vector<std::string>& lines, uint64_t dropped) {
+  if (m_tty_scroll) m_tty_scroll->Add(lines, dropped);
+}
@@ -24,10 +24,13 @@
  ***************************************************************************
  */
 
+#include <stddef.h>
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
 
+#include <vector>
+
 #ifdef __MINGW32__
 #undef IPV6STRICT  // mingw FTBS fix:  missing struct ip_mreq
 #include <windows.h>
@@ -41,6 +44,7 @@
 
 #include "model/ais_decoder.h"
 #include "model/ais_state_vars.h"
+#include "model/ais_symbol_batch.h"
 #include "model/ais_target_data.h"
 #include "model/cutil.h"
 #include "model/georef.h"
@@ -60,6 +64,10 @@
 #include "ocpn_plugin.h"
 #include "styles.h"
 
+#ifdef ocpnUSE_GL
+#include "shaders.h"
+#endif
+
 extern MyFrame *gFrame;
 extern OCPNPlatform *g_Platform;
 
@@ -247,6 +255,116 @@ static void transrot_pts(int n, wxPoint *pt, float sin_theta, float cos_theta,
     pt[i] = transrot(pt[i], sin_theta, cos_theta, offset);
 }
 
+/** Target name, drawn after all batched symbols. */
+struct AisLabel {
+  wxString text;
+  int x;
+  int y;
+};
+
+/**
+ * The GL geometry of the targets in one AISDraw() pass. Hulls, predictors,
+ * status symbols and tracks are added to symbols and drawn with a single
+ * draw call, everything else is drawn through the ocpnDC after flushing
+ * the batch so the drawing order is kept.
+ */
+struct AisDrawBatch {
+  AisDrawBatch() : vbo(0) {
+    std::vector<float> quad = {-8, -6, 0, 24, 8, -6, 0, -6};
+    // The quad icons are concave, fan from the point between the wings
+    ship_a = symbols.AddTemplate(quad, AisSymbolBatch::FanTriangles(4, 3));
+    quad[7] = 0;
+    ship_b = symbols.AddTemplate(quad, AisSymbolBatch::FanTriangles(4, 3));
+    buddy = symbols.AddTemplate({-5, -12, -3, 12, 3, 12, 5, -12},
+                                AisSymbolBatch::FanTriangles(4));
+    dsc = symbols.AddTemplate({-8, 0, 0, 8, 8, 0, 0, -8},
+                              AisSymbolBatch::FanTriangles(4));
+    aprs = symbols.AddTemplate({-8, -8, -8, 8, 8, 8, 8, -8},
+                               AisSymbolBatch::FanTriangles(4));
+    octo = symbols.AddTemplate({4, 8, 8, 4, 8, -4, 4, -8, -4, -8, -8, -4,
+                                -8, 4, -4, 8},
+                               AisSymbolBatch::FanTriangles(8));
+    circle = symbols.AddTemplate(AisSymbolBatch::CircleOutline(16),
+                                 AisSymbolBatch::FanTriangles(16));
+  }
+
+  AisSymbolBatch symbols;
+  std::vector<AisLabel> labels;
+  unsigned vbo;
+  int ship_a, ship_b, buddy, dsc, aprs, octo, circle;
+};
+
+static AisBatchColor BatchColor(const wxColour &c) {
+  return {c.Red(), c.Green(), c.Blue(), 255};
+}
+
+static const AisBatchColor kNoFill = {0, 0, 0, 0};
+
+static void BatchPolygon(AisDrawBatch *batch, int n, const wxPoint *pts,
+                         int x, int y, AisBatchColor fill,
+                         const wxColour &line, float line_width) {
+  float xy[16];
+  n = wxMin(n, 8);
+  for (int i = 0; i < n; i++) {
+    xy[2 * i] = pts[i].x;
+    xy[2 * i + 1] = pts[i].y;
+  }
+  batch->symbols.AddPolygon(AisSymbolInstance(x, y), xy, n, fill,
+                            BatchColor(line), line_width);
+}
+
+static void BatchCircle(AisDrawBatch *batch, int x, int y, float radius,
+                        const wxColour &fill, const wxColour &line,
+                        float line_width) {
+  batch->symbols.AddSymbol(batch->circle, AisSymbolInstance(x, y, radius),
+                           BatchColor(fill), BatchColor(line), line_width);
+}
+
+/** Draw and clear the batched geometry. */
+static void FlushAisBatch(ocpnDC &dc, AisDrawBatch *batch) {
+#if defined(USE_ANDROID_GLES2) || defined(ocpnUSE_GLSL)
+  const auto &vertices = batch->symbols.GetVertices();
+  if (vertices.empty()) return;
+
+  GLShaderProgram *shader = pais_batch_shader_program[dc.m_canvasIndex];
+  shader->Bind();
+  if (!batch->vbo) glGenBuffers(1, &batch->vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, batch->vbo);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(AisBatchVertex),
+               vertices.data(), GL_STREAM_DRAW);
+
+  struct {
+    const char *name;
+    GLint size;
+    GLenum type;
+    size_t offset;
+  } attribs[] = {
+      {"aLocal", 2, GL_FLOAT, offsetof(AisBatchVertex, local)},
+      {"aExtrude", 2, GL_FLOAT, offsetof(AisBatchVertex, extrude)},
+      {"aPos", 2, GL_FLOAT, offsetof(AisBatchVertex, pos)},
+      {"aRot", 2, GL_FLOAT, offsetof(AisBatchVertex, rot)},
+      {"aScale", 1, GL_FLOAT, offsetof(AisBatchVertex, scale)},
+      {"aColor", 4, GL_UNSIGNED_BYTE, offsetof(AisBatchVertex, color)}};
+  GLint locs[6];
+  for (int i = 0; i < 6; i++) {
+    locs[i] = glGetAttribLocation(shader->programId(), attribs[i].name);
+    if (locs[i] < 0) continue;
+    // With the buffer bound the attribute pointer is an offset into it
+    glVertexAttribPointer(locs[i], attribs[i].size, attribs[i].type,
+                          attribs[i].type == GL_UNSIGNED_BYTE,
+                          sizeof(AisBatchVertex),
+                          (const GLvoid *)attribs[i].offset);
+    glEnableVertexAttribArray(locs[i]);
+  }
+  glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+  for (int i = 0; i < 6; i++)
+    if (locs[i] >= 0) glDisableVertexAttribArray(locs[i]);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  shader->UnBind();
+#endif
+  batch->symbols.Clear();
+}
+
 void AISDrawAreaNotices(ocpnDC &dc, ViewPort &vp, ChartCanvas *cp) {
   if (cp == NULL) return;
   if (!g_pAIS || !cp->GetShowAIS() || !g_bShowAreaNotices) return;
@@ -756,7 +874,7 @@ static void AISSetMetrics() {
 }
 
 static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
-                          ChartCanvas *cp) {
+                          ChartCanvas *cp, AisDrawBatch *batch) {
   //      Target data must be valid
   if (NULL == td) return;
 
@@ -1051,6 +1169,8 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
   //    Check for alarms here, maintained by AIS class timer tick
   if (((td->n_alert_state == AIS_ALERT_SET) && (td->bCPA_Valid)) ||
       (td->b_show_AIS_CPA && (td->bCPA_Valid))) {
+    if (batch) FlushAisBatch(dc, batch);
+
     //  Calculate the point of CPA for target
     double tcpa_lat, tcpa_lon;
     ll_gc_ll(td->Lat, td->Lon, td->COG, target_sog * td->TCPA / 60., &tcpa_lat,
@@ -1148,15 +1268,19 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
     auto alert_dlg_active =
         dynamic_cast<AISTargetAlertDialog *>(g_pais_alert_dialog_active);
     if (alert_dlg_active && alert_dlg_active->IsShown() && cp) {
-      if (alert_dlg_active->Get_Dialog_MMSI() == td->MMSI)
+      if (alert_dlg_active->Get_Dialog_MMSI() == td->MMSI) {
+        if (batch) FlushAisBatch(dc, batch);
         cp->JaggyCircle(dc, wxPen(URED, 2), TargetPoint.x, TargetPoint.y, 100);
+      }
     }
   }
 
   //  Highlight the AIS target symbol if a query dialog is currently open for it
   if (g_pais_query_dialog_active && g_pais_query_dialog_active->IsShown()) {
-    if (g_pais_query_dialog_active->GetMMSI() == td->MMSI)
+    if (g_pais_query_dialog_active->GetMMSI() == td->MMSI) {
+      if (batch) FlushAisBatch(dc, batch);
       TargetFrame(dc, wxPen(UBLCK, 2), TargetPoint.x, TargetPoint.y, 25);
+    }
   }
 
   //       Render the COG line if the speed is greater than moored speed defined
@@ -1176,7 +1300,27 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
       ClipResult res = cohen_sutherland_line_clip_i(
           &pixx, &pixy, &pixx1, &pixy1, 0, vp.pix_width, 0, vp.pix_height);
 
-      if (res != Invisible) {
+      if (res != Invisible && batch) {
+        float narrow_width = AIS_width_cogpredictor_line;
+        if (targetscale >= 75)
+          batch->symbols.AddLine(pixx, pixy, pixx1, pixy1,
+                                 AIS_width_cogpredictor_base,
+                                 BatchColor(target_brush.GetColour()));
+        if (AIS_width_cogpredictor_base > 1) {
+          if (targetscale < 75) {
+            narrow_width = 1;
+            batch->symbols.AddDashedLine(pixx, pixy, pixx1, pixy1, 1, 2, 2,
+                                         BatchColor(UBLCK));
+          } else {
+            batch->symbols.AddLine(pixx, pixy, pixx1, pixy1, narrow_width,
+                                   BatchColor(UBLCK));
+          }
+        }
+        BatchCircle(batch, PredPoint.x, PredPoint.y,
+                    AIS_intercept_bar_circle_diameter * AIS_user_scale_factor *
+                        targetscale / 100,
+                    target_brush.GetColour(), UBLCK, narrow_width);
+      } else if (res != Invisible) {
         //    Draw a wider coloured line
         if (targetscale >= 75) {
           wxPen wide_pen(target_brush.GetColour(), AIS_width_cogpredictor_base);
@@ -1268,12 +1412,22 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
 
         int xrot = (int)round(pixx1 + (nv * cosf(theta2)));
         int yrot = (int)round(pixy1 + (nv * sinf(theta2)));
-        dc.StrokeLine(pixx1, pixy1, xrot, yrot);
+        if (batch)
+          batch->symbols.AddLine(pixx1, pixy1, xrot, yrot,
+                                 AIS_width_cogpredictor_line,
+                                 BatchColor(UBLCK));
+        else
+          dc.StrokeLine(pixx1, pixy1, xrot, yrot);
       }
     }
   }
 
   //        Actually Draw the target
+  if (batch && ((td->Class == AIS_ARPA) || (td->Class == AIS_METEO) ||
+                (td->Class == AIS_ATON) || (td->Class == AIS_BASE) ||
+                (td->Class == AIS_SART) || td->b_SarAircraftPosnReport))
+    FlushAisBatch(dc, batch);
+
   if (td->Class == AIS_ARPA) {
     wxPen target_pen(UBLCK, 2);
 
@@ -1464,6 +1618,30 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
     wxPen target_pen(UBLCK, 1);
     dc.SetPen(target_pen);
 
+    //  The batched icon is the template matching iconPoints
+    int hull = -1;
+    float hull_scale = AIS_scale_factor;
+    float hull_sin = sin_theta, hull_cos = cos_theta;
+    if (batch) {
+      if (g_bInlandEcdis) {
+        hull = batch->ship_a;
+        if (!b_hdgValid) {
+          hull = batch->octo;
+          hull_sin = 1, hull_cos = 0;
+        }
+      } else if ((td->Class == AIS_GPSG_BUDDY) || (td->b_isFollower)) {
+        hull = batch->buddy;
+      } else if (td->Class == AIS_DSC) {
+        hull = batch->dsc;
+      } else if (td->Class == AIS_APRS) {
+        hull = batch->aprs;
+      } else {
+        hull = td->Class == AIS_CLASS_B ? batch->ship_b : batch->ship_a;
+        hull_scale *= targetscale / 100.;
+      }
+    }
+    float line_width = AIS_width_target_outline;
+
     wxPoint Point = TargetPoint;
     if (g_bDrawAISRealtime &&
         (td->Class == AIS_CLASS_A || td->Class == AIS_CLASS_B) &&
@@ -1479,12 +1657,28 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
       GetCanvasPointPix(vp, cp, lat, lon, &Point);
 
       wxBrush realtime_brush = wxBrush(GetGlobalColor("GREY1"));
-      dc.SetBrush(realtime_brush);
-      dc.StrokePolygon(nPoints, iconPoints, Point.x, Point.y, AIS_scale_factor);
+      if (batch) {
+        batch->symbols.AddSymbol(
+            hull,
+            AisSymbolInstance(Point.x, Point.y, hull_scale, hull_sin,
+                              hull_cos),
+            BatchColor(realtime_brush.GetColour()), BatchColor(UBLCK), 1);
+      } else {
+        dc.SetBrush(realtime_brush);
+        dc.StrokePolygon(nPoints, iconPoints, Point.x, Point.y,
+                         AIS_scale_factor);
+      }
     }
     dc.SetBrush(target_brush);
 
-    if (dc.GetDC()) {
+    if (batch) {
+      batch->symbols.AddSymbol(
+          hull,
+          AisSymbolInstance(TargetPoint.x, TargetPoint.y, hull_scale,
+                            hull_sin, hull_cos),
+          BatchColor(target_brush.GetColour()), BatchColor(UBLCK),
+          AIS_width_target_outline);
+    } else if (dc.GetDC()) {
       dc.StrokePolygon(nPoints, iconPoints, TargetPoint.x, TargetPoint.y,
                        AIS_scale_factor);
     } else {
@@ -1540,18 +1734,33 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
       transrot_pts(3, ais_follow_stroke, sin_theta, cos_theta);
 
       int penWidth = wxMax(target_outline_pen.GetWidth(), 2);
-      dc.SetPen(wxPen(UBLCK, penWidth));
-      dc.StrokeLine(ais_follow_stroke[0].x + TargetPoint.x,
-                    ais_follow_stroke[0].y + TargetPoint.y,
-                    ais_follow_stroke[1].x + TargetPoint.x,
-                    ais_follow_stroke[1].y + TargetPoint.y);
-      dc.StrokeLine(ais_follow_stroke[1].x + TargetPoint.x,
-                    ais_follow_stroke[1].y + TargetPoint.y,
-                    ais_follow_stroke[2].x + TargetPoint.x,
-                    ais_follow_stroke[2].y + TargetPoint.y);
+      if (batch) {
+        for (int i = 0; i < 2; i++)
+          batch->symbols.AddLine(ais_follow_stroke[i].x + TargetPoint.x,
+                                 ais_follow_stroke[i].y + TargetPoint.y,
+                                 ais_follow_stroke[i + 1].x + TargetPoint.x,
+                                 ais_follow_stroke[i + 1].y + TargetPoint.y,
+                                 penWidth, BatchColor(UBLCK));
+        line_width = penWidth;
+      } else {
+        dc.SetPen(wxPen(UBLCK, penWidth));
+        dc.StrokeLine(ais_follow_stroke[0].x + TargetPoint.x,
+                      ais_follow_stroke[0].y + TargetPoint.y,
+                      ais_follow_stroke[1].x + TargetPoint.x,
+                      ais_follow_stroke[1].y + TargetPoint.y);
+        dc.StrokeLine(ais_follow_stroke[1].x + TargetPoint.x,
+                      ais_follow_stroke[1].y + TargetPoint.y,
+                      ais_follow_stroke[2].x + TargetPoint.x,
+                      ais_follow_stroke[2].y + TargetPoint.y);
+      }
     }
 
-    if (g_bDrawAISSize && bcan_draw_size) {
+    if (g_bDrawAISSize && bcan_draw_size && batch) {
+      if (!g_bInlandEcdis || b_hdgValid)
+        BatchPolygon(batch, 6, ais_real_size, TargetPoint.x, TargetPoint.y,
+                     kNoFill, UBLCK, AIS_width_target_outline);
+      line_width = AIS_width_target_outline;
+    } else if (g_bDrawAISSize && bcan_draw_size) {
       dc.SetPen(target_outline_pen);
       dc.SetBrush(wxBrush(UBLCK, wxBRUSHSTYLE_TRANSPARENT));
       if (!g_bInlandEcdis) {
@@ -1563,9 +1772,26 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
       }
     }
 
-    dc.SetBrush(wxBrush(GetGlobalColor(_T ( "SHIPS" ))));
+    wxColour ships = GetGlobalColor(_T ( "SHIPS" ));
+    dc.SetBrush(wxBrush(ships));
     int navstatus = td->NavStatus;
 
+    //  Status symbols with the current pen and brush, or batched
+    auto status_circle = [&](int x, int y, float radius) {
+      if (batch)
+        BatchCircle(batch, x, y, radius, ships, UBLCK, line_width);
+      else
+        dc.StrokeCircle(x, y, radius);
+    };
+    auto status_polygon = [&](int n, wxPoint *pts, int x, int y,
+                              const wxColour &fill) {
+      if (batch)
+        BatchPolygon(batch, n, pts, x, y, BatchColor(fill), UBLCK,
+                     line_width);
+      else
+        dc.StrokePolygon(n, pts, x, y);
+    };
+
     // HSC usually have correct ShipType but navstatus == 0...
     // Class B can have (HSC)ShipType but never navstatus.
     if (((td->ShipType >= 40) && (td->ShipType < 50)) &&
@@ -1576,7 +1802,7 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
       switch (navstatus) {
         case MOORED:
         case AT_ANCHOR: {
-          dc.StrokeCircle(TargetPoint.x, TargetPoint.y, 4 * AIS_scale_factor);
+          status_circle(TargetPoint.x, TargetPoint.y, 4 * AIS_scale_factor);
           break;
         }
         case RESTRICTED_MANOEUVRABILITY: {
@@ -1585,10 +1811,10 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
           diamond[1] = wxPoint(0, -6) * AIS_scale_factor;
           diamond[2] = wxPoint(-4, 0) * AIS_scale_factor;
           diamond[3] = wxPoint(0, 6) * AIS_scale_factor;
-          dc.StrokePolygon(4, diamond, TargetPoint.x,
-                           TargetPoint.y - (11 * AIS_scale_factor));
-          dc.StrokeCircle(TargetPoint.x, TargetPoint.y, 4 * AIS_scale_factor);
-          dc.StrokeCircle(TargetPoint.x,
+          status_polygon(4, diamond, TargetPoint.x,
+                         TargetPoint.y - (11 * AIS_scale_factor), ships);
+          status_circle(TargetPoint.x, TargetPoint.y, 4 * AIS_scale_factor);
+          status_circle(TargetPoint.x,
                           TargetPoint.y - (22 * AIS_scale_factor),
                           4 * AIS_scale_factor);
           break;
@@ -1599,12 +1825,12 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
                             wxPoint(3, 0) * AIS_scale_factor,
                             wxPoint(3, -16) * AIS_scale_factor,
                             wxPoint(-3, -16) * AIS_scale_factor};
-          dc.StrokePolygon(4, can, TargetPoint.x, TargetPoint.y);
+          status_polygon(4, can, TargetPoint.x, TargetPoint.y, ships);
           break;
         }
         case NOT_UNDER_COMMAND: {
-          dc.StrokeCircle(TargetPoint.x, TargetPoint.y, 4 * AIS_scale_factor);
-          dc.StrokeCircle(TargetPoint.x, TargetPoint.y - 9,
+          status_circle(TargetPoint.x, TargetPoint.y, 4 * AIS_scale_factor);
+          status_circle(TargetPoint.x, TargetPoint.y - 9,
                           4 * AIS_scale_factor);
           break;
         }
@@ -1613,18 +1839,18 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
           tri[0] = wxPoint(-4, 0) * AIS_scale_factor;
           tri[1] = wxPoint(4, 0) * AIS_scale_factor;
           tri[2] = wxPoint(0, -9) * AIS_scale_factor;
-          dc.StrokePolygon(3, tri, TargetPoint.x, TargetPoint.y);
+          status_polygon(3, tri, TargetPoint.x, TargetPoint.y, ships);
           tri[0] = wxPoint(0, -9) * AIS_scale_factor;
           tri[1] = wxPoint(4, -18) * AIS_scale_factor;
           tri[2] = wxPoint(-4, -18) * AIS_scale_factor;
-          dc.StrokePolygon(3, tri, TargetPoint.x, TargetPoint.y);
+          status_polygon(3, tri, TargetPoint.x, TargetPoint.y, ships);
           break;
         }
         case AGROUND: {
-          dc.StrokeCircle(TargetPoint.x, TargetPoint.y, 4 * AIS_scale_factor);
-          dc.StrokeCircle(TargetPoint.x, TargetPoint.y - 9,
+          status_circle(TargetPoint.x, TargetPoint.y, 4 * AIS_scale_factor);
+          status_circle(TargetPoint.x, TargetPoint.y - 9,
                           4 * AIS_scale_factor);
-          dc.StrokeCircle(TargetPoint.x, TargetPoint.y - 18,
+          status_circle(TargetPoint.x, TargetPoint.y - 18,
                           4 * AIS_scale_factor);
           break;
         }
@@ -1636,13 +1862,13 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
                                wxPoint(0, 27) * AIS_scale_factor,
                                wxPoint(4, 20) * AIS_scale_factor};
           transrot_pts(3, arrow1, sin_theta, cos_theta, TargetPoint);
-          dc.StrokePolygon(3, arrow1);
+          status_polygon(3, arrow1, 0, 0, target_brush.GetColour());
 
           wxPoint arrow2[3] = {wxPoint(-4, 27) * AIS_scale_factor,
                                wxPoint(0, 34) * AIS_scale_factor,
                                wxPoint(4, 27) * AIS_scale_factor};
           transrot_pts(3, arrow2, sin_theta, cos_theta, TargetPoint);
-          dc.StrokePolygon(3, arrow2);
+          status_polygon(3, arrow2, 0, 0, target_brush.GetColour());
           break;
         }
       }
@@ -1655,8 +1881,12 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
       wxPoint p2 = transrot(wxPoint((int)14 * targetscale / 100, 0), sin_theta,
                             cos_theta, TargetPoint);
 
-      dc.SetPen(wxPen(UBLCK, 2));
-      dc.StrokeLine(p1.x, p1.y, p2.x, p2.y);
+      if (batch) {
+        batch->symbols.AddLine(p1.x, p1.y, p2.x, p2.y, 2, BatchColor(UBLCK));
+      } else {
+        dc.SetPen(wxPen(UBLCK, 2));
+        dc.StrokeLine(p1.x, p1.y, p2.x, p2.y);
+      }
     }
 
     //    European Inland AIS define a "stbd-stbd" meeting sign, a blue paddle.
@@ -1701,8 +1931,14 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
         ais_flag_icon[2] = ais_flag_icon[3];
       }
 
-      dc.SetBrush(wxBrush(GetGlobalColor(_T ( "UINFB" ))));
-      dc.StrokePolygon(4, ais_flag_icon);
+      if (batch) {
+        BatchPolygon(batch, 4, ais_flag_icon, 0, 0,
+                     BatchColor(GetGlobalColor(_T ( "UINFB" ))),
+                     GetGlobalColor(_T ( "CHWHT" )), penWidth);
+      } else {
+        dc.SetBrush(wxBrush(GetGlobalColor(_T ( "UINFB" ))));
+        dc.StrokePolygon(4, ais_flag_icon);
+      }
     }
   }
 
@@ -1723,11 +1959,12 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
         h *= g_Platform->GetDisplayDIPMult(gFrame);
         w *= g_Platform->GetDisplayDIPMult(gFrame);
 
-        if ((td->COG > 90) && (td->COG < 180))
-          dc.DrawText(tgt_name, TargetPoint.x + w, TargetPoint.y - h);
+        int label_y = TargetPoint.y;
+        if ((td->COG > 90) && (td->COG < 180)) label_y -= h;
+        if (batch)
+          batch->labels.push_back({tgt_name, TargetPoint.x + w, label_y});
         else
-          dc.DrawText(tgt_name, TargetPoint.x + w,
-                      TargetPoint.y /*+ (0.5 * h)*/);
+          dc.DrawText(tgt_name, TargetPoint.x + w, label_y);
 
       }  // If name do not empty
     }    // if scale
@@ -1767,7 +2004,8 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
     }
 
     wxColour c = GetGlobalColor(_T ( "CHMGD" ));
-    dc.SetPen(wxPen(c, 1.5 * AIS_nominal_line_width_pix));
+    float track_width = 1.5 * AIS_nominal_line_width_pix;
+    dc.SetPen(wxPen(c, track_width));
 
     // Check for any persistently tracked target
     // Render persistently tracked targets slightly differently.
@@ -1777,13 +2015,15 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
       auto *ptrack = itt->second;
       if (ptrack->m_Colour == wxEmptyString) {
         c = GetGlobalColor(_T ( "TEAL1" ));
-        dc.SetPen(wxPen(c, 2.0 * AIS_nominal_line_width_pix));
+        track_width = 2.0 * AIS_nominal_line_width_pix;
+        dc.SetPen(wxPen(c, track_width));
       } else {
         for (unsigned int i = 0;
              i < sizeof(::GpxxColorNames) / sizeof(wxString); i++) {
           if (ptrack->m_Colour == ::GpxxColorNames[i]) {
             c = ::GpxxColors[i];
-            dc.SetPen(wxPen(c, 2.0 * AIS_nominal_line_width_pix));
+            track_width = 2.0 * AIS_nominal_line_width_pix;
+            dc.SetPen(wxPen(c, track_width));
             break;
           }
         }
@@ -1808,7 +2048,17 @@ static void AISDrawTarget(AisTargetData *td, ocpnDC &dc, ViewPort &vp,
       dc.DrawLines(TrackPointCount, TrackPoints);
     }
 #else
-    dc.DrawLines(TrackPointCount, TrackPoints);
+    if (batch) {
+      std::vector<float> xy(2 * TrackPointCount);
+      for (int i = 0; i < TrackPointCount; i++) {
+        xy[2 * i] = TrackPoints[i].x;
+        xy[2 * i + 1] = TrackPoints[i].y;
+      }
+      batch->symbols.AddPolyline(xy.data(), TrackPointCount, track_width,
+                                 BatchColor(c));
+    } else {
+      dc.DrawLines(TrackPointCount, TrackPoints);
+    }
 #endif
 
 #else
@@ -1902,13 +2152,26 @@ void AISDraw(ocpnDC &dc, ViewPort &vp, ChartCanvas *cp) {
   }
   delete[] Array;
 
+  //    With GLSL the target graphics are batched into one draw call
+  AisDrawBatch *batch = NULL;
+#if defined(USE_ANDROID_GLES2) || defined(ocpnUSE_GLSL)
+  static AisDrawBatch *s_batch[2];
+  if (cp && !dc.GetDC() && dc.m_canvasIndex >= 0 && dc.m_canvasIndex < 2 &&
+      pais_batch_shader_program[dc.m_canvasIndex]) {
+    if (!s_batch[dc.m_canvasIndex])
+      s_batch[dc.m_canvasIndex] = new AisDrawBatch;
+    batch = s_batch[dc.m_canvasIndex];
+    batch->labels.clear();
+  }
+#endif
+
   //    Draw all targets in three pass loop, sorted on SOG, GPSGate & DSC on top
   //    This way, fast targets are not obscured by slow/stationary targets
   for (const auto &it : current_targets) {
     auto td = it.second;
     if ((td->SOG < g_SOGminCOG_kts) &&
         !((td->Class == AIS_GPSG_BUDDY) || (td->Class == AIS_DSC))) {
-      AISDrawTarget(td.get(), dc, vp, cp);
+      AISDrawTarget(td.get(), dc, vp, cp, batch);
     }
   }
 
@@ -1916,15 +2179,27 @@ void AISDraw(ocpnDC &dc, ViewPort &vp, ChartCanvas *cp) {
     auto td = it.second;
     if ((td->SOG >= g_SOGminCOG_kts) &&
         !((td->Class == AIS_GPSG_BUDDY) || (td->Class == AIS_DSC))) {
-      AISDrawTarget(td.get(), dc, vp, cp);  // yes this is a doubling of code;(
-      if (td->importance > 0) AISDrawTarget(td.get(), dc, vp, cp);
+      AISDrawTarget(td.get(), dc, vp, cp,
+                    batch);  // yes this is a doubling of code;(
+      if (td->importance > 0) AISDrawTarget(td.get(), dc, vp, cp, batch);
     }
   }
 
   for (const auto &it : current_targets) {
     auto td = it.second;
     if ((td->Class == AIS_GPSG_BUDDY) || (td->Class == AIS_DSC))
-      AISDrawTarget(td.get(), dc, vp, cp);
+      AISDrawTarget(td.get(), dc, vp, cp, batch);
+  }
+
+  if (batch) {
+    FlushAisBatch(dc, batch);
+    if (!batch->labels.empty()) {
+      dc.SetFont(*AIS_NameFont);
+      dc.SetTextForeground(FontMgr::Get().GetFontColor(_("AIS Target Name")));
+      for (const auto &label : batch->labels)
+        dc.DrawText(label.text, label.x, label.y);
+      batch->labels.clear();
+    }
   }
 }
 
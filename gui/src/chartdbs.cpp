@@ -29,6 +29,15 @@
 #include <wx/wx.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
 #include <wx/arrimpl.cpp>
 #include <wx/encconv.h>
 #include <wx/regex.h>
@@ -40,7 +49,7 @@
 #include "chartbase.h"
 #include "pluginmanager.h"
 #include "mbtiles.h"
-#include "mygeom.h"  // For DouglasPeucker();
+#include "mygeom.h"
 #include "FlexHash.h"
 #include "LOD_reduce.h"
 #include "shapefile_basemap.h"
@@ -62,6 +71,115 @@ static int s_dbVersion;  //    Database version currently in use at runtime
                          //  Needed for ChartTableEntry::GetChartType() only
                          //  TODO This can go away at opencpn Version 1.3.8 and
                          //  above....
+
+/**
+ * Probes chart headers on worker threads ahead of the database merge,
+ * which takes the results in file order on the calling thread.
+ */
+class ChartProbePool {
+public:
+  ChartProbePool(size_t count, std::function<ChartTableEntry *(size_t)> probe)
+      : m_probe(probe), m_results(count, nullptr), m_done(count, false) {
+    unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+    threads = std::min<size_t>(threads, count);
+    for (unsigned t = 0; t < threads; t++)
+      m_workers.push_back(std::async(std::launch::async, [this] { Run(); }));
+  }
+
+  ~ChartProbePool() {
+    m_stop = true;
+    for (auto &worker : m_workers) worker.get();
+    for (auto entry : m_results) delete entry;
+  }
+
+  /** Wait at most timeout_ms for probe i, return true if it is done. */
+  bool Wait(size_t i, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_cond.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                           [&] { return m_done[i]; });
+  }
+
+  /** Take the entry of a finished probe, NULL if it failed. */
+  ChartTableEntry *Take(size_t i) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ChartTableEntry *entry = m_results[i];
+    m_results[i] = nullptr;
+    return entry;
+  }
+
+private:
+  void Run() {
+    for (size_t i = m_next++; i < m_results.size() && !m_stop; i = m_next++) {
+      ChartTableEntry *entry = m_probe(i);
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_results[i] = entry;
+      m_done[i] = true;
+      m_cond.notify_all();
+    }
+  }
+
+  std::function<ChartTableEntry *(size_t)> m_probe;
+  std::vector<ChartTableEntry *> m_results;
+  std::vector<bool> m_done;
+  std::atomic<size_t> m_next{0};
+  std::atomic<bool> m_stop{false};
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  std::vector<std::future<void>> m_workers;
+};
+
+/**
+ * Chart classes whose header-only Init() uses no shared state. S57 and cm93
+ * use the s52plib and their shared dictionaries, MBTiles builds its coverage
+ * from wxRegion, and plugin charts may not be thread safe.
+ */
+static bool IsConcurrentProbe(const ChartClassDescriptor &chart_desc) {
+  return chart_desc.m_descriptor_type == BUILTIN_DESCRIPTOR &&
+         (chart_desc.m_class_name == _T("ChartKAP") ||
+          chart_desc.m_class_name == _T("ChartGEO"));
+}
+
+/**
+ * True if a failed probe of path by chart_desc may be remembered until the
+ * file changes. Plugin charts may fail for want of a licence installed
+ * later, and a file which cannot be read may be readable next time.
+ */
+static bool IsLastingProbeFailure(const ChartClassDescriptor &chart_desc,
+                                  const wxString &path) {
+  return IsConcurrentProbe(chart_desc) && wxFileName::IsFileReadable(path);
+}
+
+/**
+ * True if file_name matches the upper or lower case search mask followed
+ * by suffix as is, like "FOO.KAP.xz", or on MSW the mask and suffix in any
+ * case like wxDir::GetAllFiles().
+ */
+static bool MatchesSearchMask(const wxString &file_name, const wxString &mask,
+                              const wxString &suffix = wxEmptyString) {
+#ifdef __WXMSW__
+  return file_name.Lower().Matches(mask.Lower() + suffix.Lower());
+#else
+  return file_name.Matches(mask.Upper() + suffix) ||
+         file_name.Matches(mask.Lower() + suffix);
+#endif
+}
+
+/** Wait for a background job, keeping the progress dialog responsive. */
+template <typename T>
+static T WaitWithProgress(std::future<T> &job, wxGenericProgressDialog *pprog,
+                          const wxString &label) {
+  while (job.wait_for(std::chrono::milliseconds(100)) !=
+         std::future_status::ready)
+    if (pprog) pprog->Pulse(label);
+  return job.get();
+}
+
+static wxString ManifestPath(const wxString &db_path) {
+  wxFileName fn(db_path);
+  fn.SetExt(_T("scan"));
+  return fn.GetFullPath();
+}
+
 ///////////////////////////////////////////////////////////////////////
 
 bool FindMatchingFile(const wxString &theDir, const wxChar *theRegEx,
@@ -231,42 +349,25 @@ ChartTableEntry::ChartTableEntry(ChartBase &theChart, wxString &utf8Path) {
     nPlyEntries = theChart.GetCOVRTablePoints(0);
 
     if (nPlyEntries > 5 && (LOD_meters > .01)) {
-      std::vector<int> index_keep{0, nPlyEntries - 1, 1, nPlyEntries - 2};
-
-      double *DPbuffer = (double *)malloc(2 * nPlyEntries * sizeof(double));
+      std::vector<bool> keep(nPlyEntries, false);
+      keep[0] = keep[nPlyEntries - 1] = true;
 
-      double *pfed = DPbuffer;
       Plypoint *ppp = (Plypoint *)theChart.GetCOVRTableHead(0);
+      LODReduce(&ppp->ltp, 1, nPlyEntries - 2, LOD_meters / (1852 * 60), keep);
 
-      for (int i = 0; i < nPlyEntries; i++) {
-        *pfed++ = ppp->ltp;
-        *pfed++ = ppp->lnp;
-        ppp++;
-      }
-
-      DouglasPeucker(DPbuffer, 1, nPlyEntries - 2, LOD_meters / (1852 * 60),
-                     &index_keep);
-      //              printf("DB DP Reduction: %d/%d\n", index_keep.size(),
-      //              nPlyEntries);
-
-      // Mark the keepers by adding a simple constant to ltp
-      for (unsigned int i = 0; i < index_keep.size(); i++) {
-        DPbuffer[2 * index_keep[i]] += 2000.;
-      }
-
-      float *pf = (float *)malloc(2 * index_keep.size() * sizeof(float));
+      int nKeep = std::count(keep.begin(), keep.end(), true);
+      float *pf = (float *)malloc(2 * nKeep * sizeof(float));
       float *pfe = pf;
 
       for (int i = 0; i < nPlyEntries; i++) {
-        if (DPbuffer[2 * i] > 1000.) {
-          *pfe++ = DPbuffer[2 * i] - 2000.;
-          *pfe++ = DPbuffer[(2 * i) + 1];
+        if (keep[i]) {
+          *pfe++ = ppp[i].ltp;
+          *pfe++ = ppp[i].lnp;
         }
       }
 
       pPlyTable = pf;
-      nPlyEntries = index_keep.size();
-      free(DPbuffer);
+      nPlyEntries = nKeep;
     } else {
       float *pf = (float *)malloc(2 * nPlyEntries * sizeof(float));
       pPlyTable = pf;
@@ -315,42 +416,25 @@ ChartTableEntry::ChartTableEntry(ChartBase &theChart, wxString &utf8Path) {
       int nPE = theChart.GetCOVRTablePoints(j);
 
       if (nPE > 5 && (LOD_meters > .01)) {
-        std::vector<int> index_keep{0, nPE - 1, 1, nPE - 2};
-
-        double *DPbuffer = (double *)malloc(2 * nPE * sizeof(double));
+        std::vector<bool> keep(nPE, false);
+        keep[0] = keep[nPE - 1] = true;
 
-        double *pfed = DPbuffer;
         Plypoint *ppp = (Plypoint *)theChart.GetCOVRTableHead(j);
+        LODReduce(&ppp->ltp, 1, nPE - 2, LOD_meters / (1852 * 60), keep);
 
-        for (int i = 0; i < nPE; i++) {
-          *pfed++ = ppp->ltp;
-          *pfed++ = ppp->lnp;
-          ppp++;
-        }
-
-        DouglasPeucker(DPbuffer, 1, nPE - 2, LOD_meters / (1852 * 60),
-                       &index_keep);
-        //                 printf("DBa DP Reduction: %d/%d\n",
-        //                 index_keep.size(), nPE);
-
-        // Mark the keepers by adding a simple constant to ltp
-        for (unsigned int i = 0; i < index_keep.size(); i++) {
-          DPbuffer[2 * index_keep[i]] += 2000.;
-        }
-
-        float *pf = (float *)malloc(2 * index_keep.size() * sizeof(float));
+        int nKeep = std::count(keep.begin(), keep.end(), true);
+        float *pf = (float *)malloc(2 * nKeep * sizeof(float));
         float *pfe = pf;
 
         for (int i = 0; i < nPE; i++) {
-          if (DPbuffer[2 * i] > 1000.) {
-            *pfe++ = DPbuffer[2 * i] - 2000.;
-            *pfe++ = DPbuffer[(2 * i) + 1];
+          if (keep[i]) {
+            *pfe++ = ppp[i].ltp;
+            *pfe++ = ppp[i].lnp;
           }
         }
 
         pft0[j] = pf;
-        pip[j] = index_keep.size();
-        free(DPbuffer);
+        pip[j] = nKeep;
       } else {
         float *pf_entry =
             (float *)malloc(theChart.GetCOVRTablePoints(j) * 2 * sizeof(float));
@@ -950,31 +1034,17 @@ std::vector<float> ChartTableEntry::GetReducedPlyPoints() {
     *npsm++ = y;
   }
 
-  std::vector<int> index_keep;
+  std::vector<bool> keep(nPoints, true);
   if (nPoints > 10) {
-    index_keep.push_back(0);
-    index_keep.push_back(nPoints - 1);
-    index_keep.push_back(1);
-    index_keep.push_back(nPoints - 2);
-
-    DouglasPeuckerM(ppsm, 1, nPoints - 2, LOD_meters, &index_keep);
-
-  } else {
-    index_keep.resize(nPoints);
-    for (int i = 0; i < nPoints; i++) index_keep[i] = i;
+    keep.assign(nPoints, false);
+    keep[0] = keep[nPoints - 1] = true;
+    LODReduce(ppsm, 1, nPoints - 2, LOD_meters, keep);
   }
 
-  double *ppr = ppd;
   for (int ip = 0; ip < nPoints; ip++) {
-    double x = *ppr++;
-    double y = *ppr++;
-
-    for (unsigned int j = 0; j < index_keep.size(); j++) {
-      if (index_keep[j] == ip) {
-        m_reducedPlyPoints.push_back(x);
-        m_reducedPlyPoints.push_back(y);
-        break;
-      }
+    if (keep[ip]) {
+      m_reducedPlyPoints.push_back(ppd[2 * ip]);
+      m_reducedPlyPoints.push_back(ppd[2 * ip + 1]);
     }
   }
 
@@ -1028,33 +1098,17 @@ std::vector<float> ChartTableEntry::GetReducedAuxPlyPoints(int iTable) {
     *npsm++ = y;
   }
 
-  std::vector<int> index_keep;
+  std::vector<bool> keep(nPoints, true);
   if (nPoints > 10) {
-    index_keep.push_back(0);
-    index_keep.push_back(nPoints - 1);
-    index_keep.push_back(1);
-    index_keep.push_back(nPoints - 2);
-
-    DouglasPeuckerM(ppsm, 1, nPoints - 2, LOD_meters, &index_keep);
-
-  } else {
-    index_keep.resize(nPoints);
-    for (int i = 0; i < nPoints; i++) index_keep[i] = i;
+    keep.assign(nPoints, false);
+    keep[0] = keep[nPoints - 1] = true;
+    LODReduce(ppsm, 1, nPoints - 2, LOD_meters, keep);
   }
 
-  int nnn = index_keep.size();
-
-  double *ppr = ppd;
   for (int ip = 0; ip < nPoints; ip++) {
-    double x = *ppr++;
-    double y = *ppr++;
-
-    for (unsigned int j = 0; j < index_keep.size(); j++) {
-      if (index_keep[j] == ip) {
-        vec.push_back(x);
-        vec.push_back(y);
-        break;
-      }
+    if (keep[ip]) {
+      vec.push_back(ppd[2 * ip]);
+      vec.push_back(ppd[2 * ip + 1]);
     }
   }
 
@@ -1178,6 +1232,7 @@ bool ChartDatabase::Read(const wxString &filePath) {
   if (!file.FileExists()) return false;
 
   m_DBFileName = filePath;
+  m_manifest.Load(ManifestPath(filePath));
 
   wxFFileInputStream ifs(filePath);
   if (!ifs.Ok()) return false;
@@ -1269,6 +1324,8 @@ bool ChartDatabase::Write(const wxString &filePath) {
   for (UINT32 iTable = 0; iTable < active_chartTable.size(); iTable++)
     active_chartTable[iTable].Write(this, ofs);
 
+  m_manifest.Save(ManifestPath(filePath));
+
   //      Explicitly set the version
   m_dbversion = DB_VERSION_CURRENT;
 
@@ -1510,6 +1567,9 @@ bool ChartDatabase::Update(ArrayOfCDI &dir_array, bool bForce,
     m_dbversion = DB_VERSION_CURRENT;  // and the member
   }
 
+  //  A full rebuild probes every file again
+  if (lbForce) m_manifest.Clear();
+
   //  Get the new charts
 
   for (unsigned int j = 0; j < dir_array.GetCount(); j++) {
@@ -1650,9 +1710,14 @@ int ChartDatabase::TraverseDirAndAddCharts(ChartDirInfo &dir_info,
 
   //    Quick scan the directory to see if it has changed
   //    If not, there is no need to scan again.....
-  if (!b_skipDetectDirChange)
-    b_dirchange = DetectDirChange(dir_path, dir_info.fullpath, old_magic,
-                                  new_magic, pprog);
+  //    The listing is kept for the chart search below
+  std::vector<ChartScanFile> files;
+  if (!b_skipDetectDirChange) {
+    if (pprog) pprog->SetTitle(_("OpenCPN Directory Scan...."));
+    auto listing = std::async(std::launch::async, ListChartDirFiles, dir_path);
+    files = WaitWithProgress(listing, pprog, dir_info.fullpath);
+    b_dirchange = DetectDirChange(files, old_magic, new_magic);
+  }
 
   if (!bForce && !b_dirchange) {
     wxString msg(_T("   No change detected on directory "));
@@ -1694,41 +1759,27 @@ int ChartDatabase::TraverseDirAndAddCharts(ChartDirInfo &dir_info,
 
   //    Look for all possible defined chart classes
   for (auto &cd : m_ChartClassDescriptorArray) {
-    nAdd += SearchDirAndAddCharts(dir_info.fullpath,
-                                  cd, pprog);
+    nAdd += SearchDirAndAddCharts(dir_info.fullpath, cd, pprog, files);
   }
 
+  //    Forget files which are gone
+  if (!b_cm93) m_manifest.Prune(dir_path, files);
+
   return nAdd;
 }
 
-bool ChartDatabase::DetectDirChange(const wxString &dir_path,
-                                    const wxString &prog_label,
-                                    const wxString &magic, wxString &new_magic,
-                                    wxGenericProgressDialog *pprog) {
-  if (pprog) pprog->SetTitle(_("OpenCPN Directory Scan...."));
-
-  //    parse the magic number
-  long long unsigned int nmagic;
+bool ChartDatabase::DetectDirChange(const std::vector<ChartScanFile> &files,
+                                    const wxString &magic,
+                                    wxString &new_magic) {
   wxULongLong nacc = 0;
 
-  magic.ToULongLong(&nmagic, 10);
-
-  //    Get an arraystring of all files
-  wxArrayString FileList;
-  wxDir dir(dir_path);
-  int n_files = dir.GetAllFiles(dir_path, &FileList);
-  FileList.Sort();  // Ensure persistent order of items being hashed.
-
   FlexHash hash(sizeof nacc);
   hash.Reset();
 
   // Traverse the list of files, getting their interesting stuff to add to
   // accumulator
-  for (int ifile = 0; ifile < n_files; ifile++) {
-    if (pprog && (ifile % (n_files / 60 + 1)) == 0)
-      pprog->Update(wxMin((ifile * 100) / n_files, 100), prog_label);
-
-    wxFileName file(FileList[ifile]);
+  for (const auto &scan_file : files) {
+    wxFileName file(scan_file.path);
 
     // NOTE. Do not ever try to optimize this code by combining `wxString`
     // calls. Otherwise `fileNameUTF8` will point to a stale buffer overwritten
@@ -1738,13 +1789,11 @@ bool ChartDatabase::DetectDirChange(const wxString &dir_path,
     hash.Update(fileNameUTF8.data(), fileNameUTF8.length());
 
     //    File Size;
-    wxULongLong size = file.GetSize();
-    wxULongLong fileSize = ((size != wxInvalidSize) ? size : 0);
+    wxULongLong fileSize = scan_file.size;
     hash.Update(&fileSize, (sizeof fileSize));
 
     //    Mod time, in ticks
-    wxDateTime t = file.GetModificationTime();
-    wxULongLong fileTime = t.GetTicks();
+    wxULongLong fileTime = static_cast<wxULongLong_t>(scan_file.mtime);
     hash.Update(&fileTime, (sizeof fileTime));
   }
 
@@ -1954,9 +2003,9 @@ one_file) find_unique = false;
 
 WX_DECLARE_STRING_HASH_MAP(int, ChartCollisionsHashMap);
 
-int ChartDatabase::SearchDirAndAddCharts(wxString &dir_name_base,
-                                         ChartClassDescriptor &chart_desc,
-                                         wxGenericProgressDialog *pprog) {
+int ChartDatabase::SearchDirAndAddCharts(
+    wxString &dir_name_base, ChartClassDescriptor &chart_desc,
+    wxGenericProgressDialog *pprog, const std::vector<ChartScanFile> &files) {
   wxString msg(_T("Searching directory: "));
   msg += dir_name_base;
   msg += _T(" for ");
@@ -1973,14 +2022,8 @@ int ChartDatabase::SearchDirAndAddCharts(wxString &dir_name_base,
 
   wxString filespec = chart_desc.m_search_mask.Upper();
   wxString lowerFileSpec = chart_desc.m_search_mask.Lower();
-  wxString filespecXZ = filespec + _T(".xz");
-  wxString lowerFileSpecXZ = lowerFileSpec + _T(".xz");
   wxString filename;
 
-  //    Count the files
-  wxArrayString FileList;
-  int gaf_flags = wxDIR_DEFAULT;  // as default, recurse into subdirs
-
   //    Here is an optimization for MSW/cm93 especially
   //    If this directory seems to be a cm93, and we are not explicitely looking
   //    for cm93, then abort Otherwise, we will be looking thru entire cm93 tree
@@ -1997,59 +2040,47 @@ int ChartDatabase::SearchDirAndAddCharts(wxString &dir_name_base,
     }
   }
 
+  //    Pick the chart files from the directory listing. It is sorted, which
+  //    makes the progress bar more meaningful to the user.
+  std::vector<ChartScanFile> FileList;
   if (!b_found_cm93) {
-
-    wxDir dir(dir_name);
-    dir.GetAllFiles(dir_name, &FileList, filespec, gaf_flags);
-
-#ifdef __OCPN__ANDROID__
-    if (!FileList.GetCount()) {
-      wxArrayString afl = androidTraverseDir(dir_name, filespec);
-      for (wxArrayString::const_iterator item = afl.begin(); item != afl.end();
-           item++)
-        FileList.Add(*item);
-    }
+    for (const auto &file : files) {
+      wxString file_name = file.path.AfterLast(wxFILE_SEP_PATH);
+      if (MatchesSearchMask(file_name, chart_desc.m_search_mask)
+#ifdef OCPN_USE_LZMA
+          || MatchesSearchMask(file_name, chart_desc.m_search_mask, ".xz")
 #endif
-
-
-#ifndef __WXMSW__
-    if (filespec != lowerFileSpec) {
-      // add lowercase filespec files too
-      wxArrayString lowerFileList;
-      dir.GetAllFiles(dir_name, &lowerFileList, lowerFileSpec, gaf_flags);
-
+      )
+        FileList.push_back(file);
+    }
 
 #ifdef __OCPN__ANDROID__
-      if (!lowerFileList.GetCount()) {
-        wxArrayString afl = androidTraverseDir(dir_name, lowerFileSpec);
-        for (wxArrayString::const_iterator item = afl.begin();
-             item != afl.end(); item++)
-          lowerFileList.Add(*item);
+    if (FileList.empty()) {
+      wxArrayString afl = androidTraverseDir(dir_name, filespec);
+      if (filespec != lowerFileSpec) {
+        wxArrayString lower_afl = androidTraverseDir(dir_name, lowerFileSpec);
+        for (const auto &item : lower_afl) afl.Add(item);
+      }
+      afl.Sort();
+      for (const auto &item : afl) {
+        wxFileName fn(item);
+        wxULongLong size = fn.GetSize();
+        FileList.push_back(
+            {item, size != wxInvalidSize ? size.GetValue() : 0,
+             static_cast<int64_t>(fn.GetModificationTime().GetTicks())});
       }
-#endif
-
-      for (wxArrayString::const_iterator item = lowerFileList.begin();
-           item != lowerFileList.end(); item++)
-        FileList.Add(*item);
     }
 #endif
-
-#ifdef OCPN_USE_LZMA
-      // add xz compressed files;
-     dir.GetAllFiles(dir_name, &FileList, filespecXZ, gaf_flags);
-     dir.GetAllFiles(dir_name, &FileList, lowerFileSpecXZ, gaf_flags);
-#endif
-
-
-    FileList.Sort();  // Sorted processing order makes the progress bar more
-                      // meaningful to the user.
-  } else {            // This is a cm93 dataset, specified as yada/yada/cm93
+  } else {  // This is a cm93 dataset, specified as yada/yada/cm93
     wxString dir_plus = dir_name;
     dir_plus += wxFileName::GetPathSeparator();
-    FileList.Add(dir_plus);
+    wxFileName fn(dir_plus);
+    FileList.push_back(
+        {dir_plus, 0,
+         static_cast<int64_t>(fn.GetModificationTime().GetTicks())});
   }
 
-  int nFile = FileList.GetCount();
+  int nFile = FileList.size();
 
   if (!nFile) return false;
 
@@ -2065,21 +2096,20 @@ int ChartDatabase::SearchDirAndAddCharts(wxString &dir_name_base,
   // build a hash table based on filename (without directory prefix) of
   // the chart to fast to detect identical charts
   ChartCollisionsHashMap collision_map;
+  std::map<wxString, int> path_map;
   int nEntry = active_chartTable.GetCount();
   for (int i = 0; i < nEntry; i++) {
     wxString table_file_name = active_chartTable[i].GetFullSystemPath();
     wxFileName table_file(table_file_name);
     collision_map[table_file.GetFullName()] = i;
+    path_map[table_file_name] = i;
   }
 
-  int nFileProgressQuantum = wxMax(nFile / 100, 2);
-  double rFileProgressRatio = 100.0 / wxMax(nFile, 1);
-
+  std::vector<wxString> full_names(nFile), utf8_paths(nFile);
   for (int ifile = 0; ifile < nFile; ifile++) {
-    wxFileName file(FileList[ifile]);
-    wxString full_name = file.GetFullPath();
-    wxString file_name = file.GetFullName();
-    wxString utf8_path = full_name;
+    wxFileName file(FileList[ifile].path);
+    full_names[ifile] = file.GetFullPath();
+    utf8_paths[ifile] = full_names[ifile];
 
 #ifdef __OCPN__ANDROID__
     // The full path (full_name) is the broken Android files system
@@ -2090,22 +2120,62 @@ int ChartDatabase::SearchDirAndAddCharts(wxString &dir_name_base,
     wxFileName fnbase(dir_name_base);
     int nDirs = fnbase.GetDirCount();
 
-    wxFileName file_target(FileList[ifile]);
+    wxFileName file_target(FileList[ifile].path);
 
     for (int i = 0; i < nDirs + 1;
          i++)  // strip off the erroneous intial directories
       file_target.RemoveDir(0);
 
     wxString leftover_path = file_target.GetFullPath();
-    utf8_path =
+    utf8_paths[ifile] =
         dir_name_base + leftover_path;  // reconstruct a fully utf-8 version
 #endif
+  }
+
+  //    Start probing the files which are likely new or changed on worker
+  //    threads, if the chart class allows it. The merge below waits for
+  //    them in file order, or probes by itself when the guess was wrong.
+  std::vector<int> probe_job(nFile, -1);
+  std::unique_ptr<ChartProbePool> pool;
+  if (IsConcurrentProbe(chart_desc)) {
+    std::vector<int> jobs;
+    for (int ifile = 0; ifile < nFile; ifile++) {
+      ChartScanManifest::State state =
+          m_manifest.Find(FileList[ifile], chart_desc.m_class_name);
+      if (state == ChartScanManifest::kNotChart) continue;
+      auto known = path_map.find(full_names[ifile]);
+      if (bthis_dir_in_dB && known != path_map.end() &&
+          FileList[ifile].mtime <=
+              active_chartTable[known->second].GetFileTime() &&
+          state != ChartScanManifest::kChanged)
+        continue;
+      probe_job[ifile] = jobs.size();
+      jobs.push_back(ifile);
+    }
+    if (jobs.size() > 1)
+      pool.reset(new ChartProbePool(jobs.size(), [&, jobs](size_t j) {
+        return CreateChartTableEntry(full_names[jobs[j]], utf8_paths[jobs[j]],
+                                     chart_desc);
+      }));
+    else
+      probe_job.assign(nFile, -1);
+  }
+
+  int nFileProgressQuantum = wxMax(nFile / 100, 2);
+  double rFileProgressRatio = 100.0 / wxMax(nFile, 1);
+
+  for (int ifile = 0; ifile < nFile; ifile++) {
+    const ChartScanFile &scan_file = FileList[ifile];
+    wxFileName file(scan_file.path);
+    wxString full_name = full_names[ifile];
+    wxString file_name = file.GetFullName();
+    wxString utf8_path = utf8_paths[ifile];
 
     //    Validate the file name again, considering MSW's semi-random treatment
     //    of case....
     // TODO...something fishy here - may need to normalize saved name?
-    if (!file_name.Matches(lowerFileSpec) && !file_name.Matches(filespec) &&
-        !file_name.Matches(lowerFileSpecXZ) && !file_name.Matches(filespecXZ) &&
+    if (!MatchesSearchMask(file_name, chart_desc.m_search_mask) &&
+        !MatchesSearchMask(file_name, chart_desc.m_search_mask, ".xz") &&
         !b_found_cm93) {
       // wxLogMessage(_T("FileSpec test failed for:") + file_name);
       continue;
@@ -2118,6 +2188,10 @@ int ChartDatabase::SearchDirAndAddCharts(wxString &dir_name_base,
     bool bAddFinal = true;
     int b_add_msg = 0;
 
+    ChartScanManifest::State state = ChartScanManifest::kUnknown;
+    if (!b_found_cm93)
+      state = m_manifest.Find(scan_file, chart_desc.m_class_name);
+
     // Check the collisions map looking for duplicates, and choosing the right
     // one.
     ChartCollisionsHashMap::const_iterator collision_ptr =
@@ -2139,11 +2213,12 @@ int ChartDatabase::SearchDirAndAddCharts(wxString &dir_name_base,
       if (file_path_is_same) {
         b_add_msg++;
 
-        //    Check the file modification time
+        //    Check the file modification time, and the size recorded in the
+        //    manifest
         time_t t_oldFile = pEntry->GetFileTime();
-        time_t t_newFile = file.GetModificationTime().GetTicks();
+        time_t t_newFile = scan_file.mtime;
 
-        if (t_newFile <= t_oldFile) {
+        if (t_newFile <= t_oldFile && state != ChartScanManifest::kChanged) {
           file_time_is_same = true;
           bAddFinal = false;
           pEntry->SetValid(true);
@@ -2161,8 +2236,30 @@ int ChartDatabase::SearchDirAndAddCharts(wxString &dir_name_base,
       // `CreateChartTableEntry()`.
       wxLogMessage(
           wxString::Format(_T("Loading chart data for %s"), msg_fn.c_str()));
+      if (!b_found_cm93)
+        m_manifest.Set(scan_file, chart_desc.m_class_name, true);
+    } else if (state == ChartScanManifest::kNotChart) {
+      bAddFinal = false;
+      wxLogMessage(wxString::Format(
+          _T("   Skipping unchanged file which is not a chart: %s"),
+          msg_fn.c_str()));
     } else {
-      pnewChart = CreateChartTableEntry(full_name, utf8_path, chart_desc);
+      if (probe_job[ifile] >= 0) {
+        while (!pool->Wait(probe_job[ifile], 100))
+          if (pprog)
+            pprog->Update(static_cast<int>(ifile * rFileProgressRatio),
+                          utf8_path);
+        pnewChart = pool->Take(probe_job[ifile]);
+      } else {
+        pnewChart = CreateChartTableEntry(full_name, utf8_path, chart_desc);
+      }
+      if (!b_found_cm93) {
+        if (pnewChart || IsLastingProbeFailure(chart_desc, full_name))
+          m_manifest.Set(scan_file, chart_desc.m_class_name,
+                         pnewChart != NULL);
+        else
+          m_manifest.Forget(scan_file);
+      }
       if (!pnewChart) {
         bAddFinal = false;
         wxLogMessage(wxString::Format(
@@ -2404,7 +2501,7 @@ bool ChartDatabase::AddSingleChart(wxString &ChartFullPath,
 
   //  Get a new magic number
   wxString new_magic;
-  DetectDirChange(dir_name, _T(""), _T(""), new_magic, 0);
+  DetectDirChange(ListChartDirFiles(dir_name), _T(""), new_magic);
 
   //    Update (clone) the CDI array
   bool bcfound = false;
@@ -50,6 +50,7 @@
 #include "model/nav_object_database.h"
 #include "model/navutil_base.h"
 #include "model/own_ship.h"
+#include "model/perf_trace.h"
 #include "model/route.h"
 #include "model/routeman.h"
 #include "model/select.h"
@@ -4251,8 +4252,7 @@ void ChartCanvas::GetDoubleCanvasPointPix(double rlat, double rlon,
   return GetDoubleCanvasPointPixVP(GetVP(), rlat, rlon, r);
 }
 
-void ChartCanvas::GetDoubleCanvasPointPixVP(ViewPort &vp, double rlat,
-                                            double rlon, wxPoint2DDouble *r) {
+ChartBaseBSB *ChartCanvas::GetGeorefRasterChart(ViewPort &vp) {
   // If the Current Chart is a raster chart, and the
   // requested lat/long is within the boundaries of the chart,
   // and the VP is not rotated,
@@ -4260,9 +4260,6 @@ void ChartCanvas::GetDoubleCanvasPointPixVP(ViewPort &vp, double rlat,
   // for greater accuracy
   // Additionally, use chart embedded georef if the projection is TMERC
   //  i.e. NOT MERCATOR and NOT POLYCONIC
-
-  // If for some reason the chart rejects the request by returning an error,
-  // then fall back to Viewport Projection estimate from canvas parameters
   if (!g_bopengl && m_singleChart &&
       (m_singleChart->GetChartFamily() == CHART_FAMILY_RASTER) &&
       (((fabs(vp.rotation) < .0001) && (fabs(vp.skew) < .0001)) ||
@@ -4271,27 +4268,35 @@ void ChartCanvas::GetDoubleCanvasPointPixVP(ViewPort &vp, double rlat,
          PROJECTION_TRANSVERSE_MERCATOR) &&
         (m_singleChart->GetChartProjectionType() != PROJECTION_POLYCONIC))) &&
       (m_singleChart->GetChartProjectionType() == vp.m_projection_type) &&
-      (m_singleChart->GetChartType() != CHART_TYPE_PLUGIN)) {
-    ChartBaseBSB *Cur_BSB_Ch = dynamic_cast<ChartBaseBSB *>(m_singleChart);
-    //                        bool bInside = G_FloatPtInPolygon ( ( MyFlPoint *
-    //                        ) Cur_BSB_Ch->GetCOVRTableHead ( 0 ),
-    //                                                            Cur_BSB_Ch->GetCOVRTablenPoints
-    //                                                            ( 0 ), rlon,
-    //                                                            rlat );
-    //                        bInside = true;
-    //                        if ( bInside )
-    if (Cur_BSB_Ch) {
-      //    This is a Raster chart....
-      //    If the VP is changing, the raster chart parameters may not yet be
-      //    setup So do that before accessing the chart's embedded
-      //    georeferencing
-      Cur_BSB_Ch->SetVPRasterParms(vp);
-      double rpixxd, rpixyd;
-      if (0 == Cur_BSB_Ch->latlong_to_pix_vp(rlat, rlon, rpixxd, rpixyd, vp)) {
-        r->m_x = rpixxd;
-        r->m_y = rpixyd;
-        return;
-      }
+      (m_singleChart->GetChartType() != CHART_TYPE_PLUGIN))
+    return dynamic_cast<ChartBaseBSB *>(m_singleChart);
+
+  return NULL;
+}
+
+void ChartCanvas::GetDoubleCanvasPointPixVP(ViewPort &vp, double rlat,
+                                            double rlon, wxPoint2DDouble *r) {
+  // If for some reason the chart rejects the request by returning an error,
+  // then fall back to Viewport Projection estimate from canvas parameters
+  ChartBaseBSB *Cur_BSB_Ch = GetGeorefRasterChart(vp);
+  //                        bool bInside = G_FloatPtInPolygon ( ( MyFlPoint *
+  //                        ) Cur_BSB_Ch->GetCOVRTableHead ( 0 ),
+  //                                                            Cur_BSB_Ch->GetCOVRTablenPoints
+  //                                                            ( 0 ), rlon,
+  //                                                            rlat );
+  //                        bInside = true;
+  //                        if ( bInside )
+  if (Cur_BSB_Ch) {
+    //    This is a Raster chart....
+    //    If the VP is changing, the raster chart parameters may not yet be
+    //    setup So do that before accessing the chart's embedded
+    //    georeferencing
+    Cur_BSB_Ch->SetVPRasterParms(vp);
+    double rpixxd, rpixyd;
+    if (0 == Cur_BSB_Ch->latlong_to_pix_vp(rlat, rlon, rpixxd, rpixyd, vp)) {
+      r->m_x = rpixxd;
+      r->m_y = rpixyd;
+      return;
     }
   }
 
@@ -4299,6 +4304,31 @@ void ChartCanvas::GetDoubleCanvasPointPixVP(ViewPort &vp, double rlat,
   *r = vp.GetDoublePixFromLL(rlat, rlon);
 }
 
+void ChartCanvas::GetDoubleCanvasPointPix(const double *lat, const double *lon,
+                                          int count, wxPoint2DDouble *r) {
+  ViewPort &vp = GetVP();
+  if (GetGeorefRasterChart(vp)) {
+    for (int i = 0; i < count; i++)
+      GetDoubleCanvasPointPixVP(vp, lat[i], lon[i], r + i);
+  } else
+    vp.GetDoublePixFromLL(lat, lon, count, r);
+}
+
+void ChartCanvas::GetCanvasPointPix(const double *lat, const double *lon,
+                                    int count, wxPoint *r) {
+  std::vector<wxPoint2DDouble> p(count);
+  GetDoubleCanvasPointPix(lat, lon, count, p.data());
+
+  //  Same conversion as GetCanvasPointPixVP()
+  for (int i = 0; i < count; i++) {
+    if (!std::isnan(p[i].m_x) && (abs(p[i].m_x) < 1e6) &&
+        (abs(p[i].m_y) < 1e6))
+      r[i] = wxPoint(wxRound(p[i].m_x), wxRound(p[i].m_y));
+    else
+      r[i] = wxPoint(INVALID_COORD, INVALID_COORD);
+  }
+}
+
 // This routine might be deleted and all of the rendering improved
 // to have floating point accuracy
 bool ChartCanvas::GetCanvasPointPix(double rlat, double rlon, wxPoint *r) {
@@ -10875,6 +10905,7 @@ void ChartCanvas::UpdateCanvasS52PLIBConfig() {
 int spaint;
 int s_in_update;
 void ChartCanvas::OnPaint(wxPaintEvent &event) {
+  PerfScope perf("ChartCanvas::OnPaint");
   wxPaintDC dc(this);
 
   // GetToolbar()->Show( m_bToolbarEnable );
@@ -45,6 +45,7 @@
 #include "s52s57.h"
 #include "s57chart.h"
 #include "cm93.h"
+#include "cm93_cell_cache.h"
 #include "s52plib.h"
 #include "model/georef.h"
 #include "mygeom.h"
@@ -90,6 +91,9 @@ extern PlugInManager *g_pi_manager;
 
 extern bool g_b_EnableVBO;
 
+WX_DEFINE_ARRAY_PTR(ChartCanvas *, arrayofCanvasPtr);
+extern arrayofCanvasPtr g_canvasArray;
+
 // TODO  These should be gotten from the ctor
 extern MyFrame *gFrame;
 
@@ -1120,59 +1124,65 @@ void Get_CM93_Cell_Origin(int cellindex, int scale, double *lat, double *lon) {
 
 //    Answer the query: "Is there a cm93 cell at the specified scale which
 //    contains a given lat/lon?"
-bool Is_CM93Cell_Present(wxString &fileprefix, double lat, double lon,
-                         int scale_index) {
-  int scale;
-  int dval;
-  wxChar scale_char;
-
+//    Native scale, cell size and file extension of a cm93 scale index
+static void Get_CM93_Scale_Params(int scale_index, int *scale, int *dval,
+                                  wxChar *scale_char) {
   switch (scale_index) {
     case 0:
-      scale = 20000000;
-      dval = 120;
-      scale_char = 'Z';
+      *scale = 20000000;
+      *dval = 120;
+      *scale_char = 'Z';
       break;  // Z
     case 1:
-      scale = 3000000;
-      dval = 60;
-      scale_char = 'A';
+      *scale = 3000000;
+      *dval = 60;
+      *scale_char = 'A';
       break;  // A
     case 2:
-      scale = 1000000;
-      dval = 30;
-      scale_char = 'B';
+      *scale = 1000000;
+      *dval = 30;
+      *scale_char = 'B';
       break;  // B
     case 3:
-      scale = 200000;
-      dval = 12;
-      scale_char = 'C';
+      *scale = 200000;
+      *dval = 12;
+      *scale_char = 'C';
       break;  // C
     case 4:
-      scale = 100000;
-      dval = 3;
-      scale_char = 'D';
+      *scale = 100000;
+      *dval = 3;
+      *scale_char = 'D';
       break;  // D
     case 5:
-      scale = 50000;
-      dval = 1;
-      scale_char = 'E';
+      *scale = 50000;
+      *dval = 1;
+      *scale_char = 'E';
       break;  // E
     case 6:
-      scale = 20000;
-      dval = 1;
-      scale_char = 'F';
+      *scale = 20000;
+      *dval = 1;
+      *scale_char = 'F';
       break;  // F
     case 7:
-      scale = 7500;
-      dval = 1;
-      scale_char = 'G';
+      *scale = 7500;
+      *dval = 1;
+      *scale_char = 'G';
       break;  // G
     default:
-      scale = 20000000;
-      dval = 120;
-      scale_char = ' ';
+      *scale = 20000000;
+      *dval = 120;
+      *scale_char = ' ';
       break;
   }
+}
+
+bool Is_CM93Cell_Present(wxString &fileprefix, double lat, double lon,
+                         int scale_index) {
+  int scale;
+  int dval;
+  wxChar scale_char;
+
+  Get_CM93_Scale_Params(scale_index, &scale, &dval, &scale_char);
 
   int cellindex = Get_CM93_CellIndex(lat, lon, scale);
 
@@ -1338,6 +1348,17 @@ static bool read_header_and_populate_cib(FILE *stream, Cell_Info_Block *pCIB) {
   pCIB->p3dpoint_array =
       (cm93_point_3d *)malloc(header.m_50 * sizeof(cm93_point_3d));
 
+  pCIB->alloc_size =
+      pCIB->m_nfeature_records * sizeof(Object) +
+      pCIB->m_n_point2d_records * sizeof(cm93_point) +
+      header.m_nrelated_object_pointers * sizeof(Object *) +
+      (header.m_4a + header.m_46) * sizeof(vector_record_descriptor) +
+      header.m_78 +
+      header.usn_vector_records * sizeof(geometry_descriptor) +
+      header.n_vector_record_points * sizeof(cm93_point) +
+      pCIB->m_n_point3d_records * sizeof(geometry_descriptor) +
+      header.m_50 * sizeof(cm93_point_3d);
+
   return true;
 }
 
@@ -1770,6 +1791,8 @@ cm93chart::cm93chart() {
   m_this_chart_context = (chart_context *)calloc(sizeof(chart_context), 1);
   m_this_chart_context->chart = this;
   m_RAZBuilt = true;
+
+  Clear_CM93_Cell(&m_CIB);
 }
 
 cm93chart::~cm93chart() {
@@ -1780,17 +1803,47 @@ cm93chart::~cm93chart() {
   free(m_pDrawBuffer);
 }
 
+void Clear_CM93_Cell(Cell_Info_Block *pCIB) {
+  pCIB->transform_x_rate = pCIB->transform_y_rate = 0;
+  pCIB->transform_x_origin = pCIB->transform_y_origin = 0;
+  pCIB->p2dpoint_array = NULL;
+  pCIB->pprelated_object_block = NULL;
+  pCIB->attribute_block_top = NULL;
+  pCIB->edge_vector_descriptor_block = NULL;
+  pCIB->point3d_descriptor_block = NULL;
+  pCIB->pvector_record_block_top = NULL;
+  pCIB->p3dpoint_array = NULL;
+  pCIB->m_nvector_records = 0;
+  pCIB->m_nfeature_records = 0;
+  pCIB->m_n_point3d_records = 0;
+  pCIB->m_n_point2d_records = 0;
+  pCIB->b_have_offsets = false;
+  pCIB->b_have_user_offsets = false;
+  pCIB->user_xoff = pCIB->user_yoff = 0;
+  pCIB->min_lat = pCIB->min_lon = 0;
+  pCIB->object_vector_record_descriptor_block = NULL;
+  pCIB->pobject_block = NULL;
+  pCIB->alloc_size = 0;
+}
+
+void Free_CM93_Cell(Cell_Info_Block *pCIB) {
+  free(pCIB->pobject_block);
+  //      free(pCIB->m_2a);
+  free(pCIB->p2dpoint_array);
+  free(pCIB->pprelated_object_block);
+  free(pCIB->object_vector_record_descriptor_block);
+  free(pCIB->attribute_block_top);
+  free(pCIB->edge_vector_descriptor_block);
+  free(pCIB->pvector_record_block_top);
+  free(pCIB->point3d_descriptor_block);
+  free(pCIB->p3dpoint_array);
+  Clear_CM93_Cell(pCIB);
+}
+
+//    The cell blocks belong to the shared m_cell_set, just let go of them
 void cm93chart::Unload_CM93_Cell(void) {
-  free(m_CIB.pobject_block);
-  //      free(m_CIB.m_2a);
-  free(m_CIB.p2dpoint_array);
-  free(m_CIB.pprelated_object_block);
-  free(m_CIB.object_vector_record_descriptor_block);
-  free(m_CIB.attribute_block_top);
-  free(m_CIB.edge_vector_descriptor_block);
-  free(m_CIB.pvector_record_block_top);
-  free(m_CIB.point3d_descriptor_block);
-  free(m_CIB.p3dpoint_array);
+  Clear_CM93_Cell(&m_CIB);
+  m_cell_set.reset();
 }
 
 //    The idea here is to suggest to upper layers the appropriate scale values
@@ -2110,16 +2163,18 @@ void cm93chart::SetVPParms(const ViewPort &vpt) {
 std::vector<int> cm93chart::GetVPCellArray(const ViewPort &vpt) {
   //    Fetch the lat/lon of the screen corner points
   ViewPort vptl = vpt;
-  LLBBox box = vptl.GetBBox();
+  return Get_CM93_CellArray(vptl.GetBBox(), GetNativeScale(), (int)m_dval);
+}
+
+//    Create an array of CellIndexes covering a lat/lon box, for a cm93 scale
+//    of cell size dval
+std::vector<int> Get_CM93_CellArray(const LLBBox &box, int scale, int dval) {
   double ll_lon = box.GetMinLon();
   double ll_lat = box.GetMinLat();
 
   double ur_lon = box.GetMaxLon();
   double ur_lat = box.GetMaxLat();
 
-  // CLip upper latitude to avoid trying to fetch non-existent cells.
-  ur_lat = wxMin(ur_lat, 79.99999);
-
   // CLip upper latitude to avoid trying to fetch non-existent cells above N80.
   ur_lat = wxMin(ur_lat, 79.99999);
 
@@ -2129,23 +2184,22 @@ std::vector<int> cm93chart::GetVPCellArray(const ViewPort &vpt) {
     ur_lon += 360;
   }
 
-  //    Create an array of CellIndexes covering the current viewport
   std::vector<int> vpcells;
 
-  int lower_left_cell = Get_CM93_CellIndex(ll_lat, ll_lon, GetNativeScale());
+  int lower_left_cell = Get_CM93_CellIndex(ll_lat, ll_lon, scale);
   vpcells.push_back(lower_left_cell);  // always add the lower left cell
 
   if (g_bDebugCM93)
     printf("cm93chart::GetVPCellArray   Adding %d\n", lower_left_cell);
 
   double rlat, rlon;
-  Get_CM93_Cell_Origin(lower_left_cell, GetNativeScale(), &rlat, &rlon);
+  Get_CM93_Cell_Origin(lower_left_cell, scale, &rlat, &rlon);
 
   // Use exact integer math here
   //    It is more obtuse, but it removes dependency on FP rounding policy
 
   int loni_0 = (int)wxRound(rlon * 3);
-  int loni_20 = loni_0 + (int)m_dval;  // already added the lower left cell
+  int loni_20 = loni_0 + dval;  // already added the lower left cell
   int lati_20 = (int)wxRound(rlat * 3);
 
   while (lati_20 < (ur_lat * 3.)) {
@@ -2161,15 +2215,44 @@ std::vector<int> cm93chart::GetVPCellArray(const ViewPort &vpt) {
       if (g_bDebugCM93)
         printf("cm93chart::GetVPCellArray   Adding %d\n", next_cell);
 
-      loni_20 += (int)m_dval;
+      loni_20 += dval;
     }
-    lati_20 += (int)m_dval;
+    lati_20 += dval;
     loni_20 = loni_0;
   }
 
   return vpcells;
 }
 
+CM93CellRequest cm93chart::GetCellRequest(int cell_index) {
+  CM93CellRequest request;
+  request.prefix = m_prefix;
+  request.scalechar = m_scalechar;
+  request.dval = (int)m_dval;
+  request.cell_index = cell_index;
+  return request;
+}
+
+bool cm93chart::IsCellLoaded(int cell_index) {
+  return std::find(m_cells_loaded_array.begin(), m_cells_loaded_array.end(),
+                   cell_index) != m_cells_loaded_array.end();
+}
+
+bool cm93chart::IsVPLoaded(const ViewPort &vpt) {
+  for (int cell_index : GetVPCellArray(vpt))
+    if (!IsCellLoaded(cell_index)) return false;
+  return true;
+}
+
+bool cm93chart::IsVPCellsReady(const ViewPort &vpt) {
+  CM93CellCache &cache = CM93CellCache::GetInstance();
+  for (int cell_index : GetVPCellArray(vpt)) {
+    if (IsCellLoaded(cell_index)) continue;
+    if (!cache.IsCached(GetCellRequest(cell_index))) return false;
+  }
+  return true;
+}
+
 void cm93chart::ProcessVectorEdges(void) {
   //    Create the vector(edge) map for this cell, appending to the existing
   //    member hash map
@@ -4226,184 +4309,94 @@ int cm93chart::loadcell_in_sequence(int cellindex, char subcell) {
   return rv;
 }
 
-int cm93chart::loadsubcell(int cellindex, wxChar sub_char) {
-  //    Create the file name
-
+//    Return the path of a cell file, or of its .xz compressed version, or an
+//    empty string if neither exists
+wxString Find_CM93_Cell_File(const wxString &prefix, const wxString &scalechar,
+                             int dval, int cellindex, wxChar sub_char) {
   int ilat = cellindex / 10000;
   int ilon = cellindex % 10000;
 
-  if (g_bDebugCM93) {
-    double dlat = m_dval / 3.;
-    double dlon = m_dval / 3.;
-    double lat, lon;
-    Get_CM93_Cell_Origin(cellindex, GetNativeScale(), &lat, &lon);
-    printf(
-        "\n   Attempting loadcell %d scale %lc, sub_char %lc at lat: %g/%g "
-        "lon:%g/%g\n",
-        cellindex, wxChar(m_scalechar[0]), sub_char, lat, lat + dlat, lon,
-        lon + dlon);
-  }
-
-  int jlat = (int)(((ilat - 30) / m_dval) * m_dval) + 30;  // normalize
-  int jlon = (int)((ilon / m_dval) * m_dval);
+  int jlat = (((ilat - 30) / dval) * dval) + 30;  // normalize
+  int jlon = ((ilon / dval) * dval);
 
   int ilatroot = (((ilat - 30) / 60) * 60) + 30;
   int ilonroot = (ilon / 60) * 60;
 
-  wxString file;
-  file.Printf(_T ( "%04d%04d." ), jlat, jlon);
-  file += m_scalechar;
-  file[0] = sub_char;
-
-  // We prefer to make use of the NoFind array to avoid file system access to
-  // cells known not to exist. However, when the arra becomes "large", then
-  // searching the array becomes slower than actually accessing the file system.
-  // So, detect this case, and skip the NoFind array if the array size is larger
-  // than nnn items. "nnn" determined by experimentation/intuition. Could also
-  // be platform dependent.
-  bool b_useNoFind = true;
-  if (m_noFindArray.GetCount() > 500) b_useNoFind = false;
-
-  wxString fileroot;
-  fileroot.Printf(_T ( "%04d%04d" ), ilatroot, ilonroot);
-  appendOSDirSep(&fileroot);
-  fileroot.append(m_scalechar);
-  appendOSDirSep(&fileroot);
-  wxString key = fileroot;
-  key.append(file);
-  fileroot.Prepend(m_prefix);
-
-  file.Prepend(fileroot);
+  //    Try with the scale character as given, then with its lower case
+  wxString scalechars[2] = {scalechar, scalechar.Lower()};
+  for (int i = 0; i < 2; i++) {
+    if (i && scalechars[1] == scalechars[0]) break;
 
-  if (g_bDebugCM93) {
-    char sfile[200];
-    strncpy(sfile, file.mb_str(), 199);
-    sfile[199] = 0;
-    printf("    filename: %s\n", sfile);
-  }
-
-  bool bfound = false;
-  wxString compfile;
-  if (b_useNoFind) {
-    if (m_noFindArray.Index(key) == wxNOT_FOUND) {
-      if (::wxFileExists(file))
-        bfound = true;
-      else
-        m_noFindArray.Add(key);
-    }
-  } else {
-    if (::wxFileExists(file)) bfound = true;
-    ;
-  }
-
-  if (!bfound) {  // try compressed version
-    if (b_useNoFind) {
-      if (m_noFindArray.Index(key + _T(".xz")) == wxNOT_FOUND) {
-        if (::wxFileExists(file + _T(".xz"))) {
-          compfile = file + _T(".xz");
-        }
-      } else {
-        m_noFindArray.Add(key + _T(".xz"));
-      }
-    } else {
-      if (::wxFileExists(file + _T(".xz"))) compfile = file + _T(".xz");
-    }
-  }
-
-  // Try again with alternate scale character
-  if (!bfound && !compfile.Length()) {
-    //    Try with alternate case of m_scalechar
-    wxString new_scalechar = m_scalechar.Lower();
-
-    wxString file1;
-    file1.Printf(_T ( "%04d%04d." ), jlat, jlon);
-    file1 += new_scalechar;
-    file1[0] = sub_char;
+    wxString file;
+    file.Printf(_T ( "%04d%04d." ), jlat, jlon);
+    file += scalechars[i];
+    file[0] = sub_char;
 
+    wxString fileroot;
     fileroot.Printf(_T ( "%04d%04d" ), ilatroot, ilonroot);
     appendOSDirSep(&fileroot);
-    fileroot.append(new_scalechar);
+    fileroot.append(scalechars[i]);
     appendOSDirSep(&fileroot);
-    key = fileroot;
-    key.append(file1);
-
-    fileroot.Prepend(m_prefix);
-
-    file1.Prepend(fileroot);
+    fileroot.Prepend(prefix);
 
-    if (b_useNoFind) {
-      if (m_noFindArray.Index(key) == wxNOT_FOUND) {
-        if (::wxFileExists(file1)) {
-          bfound = true;
-          file = file1;  // found the file as lowercase, substitute the name
-        } else {
-          m_noFindArray.Add(key);
-        }
-      }
-    } else {
-      if (::wxFileExists(file1)) {
-        bfound = true;
-        file = file1;  // found the file as lowercase, substitute the name
-      }
-    }
+    file.Prepend(fileroot);
 
-    if (!bfound) {  // try compressed version
-      if (b_useNoFind) {
-        if (m_noFindArray.Index(key + _T(".xz")) == wxNOT_FOUND) {
-          if (::wxFileExists(file1 + _T(".xz")))
-            compfile = file1 + _T(".xz");
-          else
-            m_noFindArray.Add(key + _T(".xz"));
-        }
-      } else {
-        if (::wxFileExists(file1 + _T(".xz"))) compfile = file1 + _T(".xz");
-      }
-    }
+    if (::wxFileExists(file)) return file;
+    if (::wxFileExists(file + _T(".xz"))) return file + _T(".xz");
   }
 
+  return wxEmptyString;
+}
+
+//    Make the (sub)cell available in m_CIB. Cells are read and decoded once
+//    by the shared CM93CellCache, possibly ahead of time by its workers.
+int cm93chart::loadsubcell(int cellindex, wxChar sub_char) {
   if (g_bDebugCM93) {
-    printf("noFind count: %d\n", (int)m_noFindArray.GetCount());
+    double dlat = m_dval / 3.;
+    double dlon = m_dval / 3.;
+    double lat, lon;
+    Get_CM93_Cell_Origin(cellindex, GetNativeScale(), &lat, &lon);
+    printf(
+        "\n   Attempting loadcell %d scale %lc, sub_char %lc at lat: %g/%g "
+        "lon:%g/%g\n",
+        cellindex, wxChar(m_scalechar[0]), sub_char, lat, lat + dlat, lon,
+        lon + dlon);
   }
 
-  if (!bfound && !compfile.Length()) return 0;
-
-  //    File is known to exist
-
-  wxString msg(_T ( "Loading CM93 cell " ));
-  msg += file;
-  wxLogMessage(msg);
+  std::shared_ptr<const CM93CellSet> cell_set =
+      CM93CellCache::GetInstance().Get(GetCellRequest(cellindex));
+  const CM93Cell *cell = cell_set->Find(sub_char);
+  if (!cell) return 0;
 
   //    Set the member variable to be the actual file name for use in single
   //    chart mode info display
-  m_LastFileName = file;
-
-  // Decompress if needed
-  if (compfile.Length()) {
-    file = wxFileName::CreateTempFileName(wxFileName(compfile).GetFullName());
-    if (!DecompressXZFile(compfile, file)) {
-      wxRemoveFile(file);
-      return 0;
-    }
-  }
-
-  if (g_bDebugCM93) {
-    char str[256];
-    strncpy(str, msg.mb_str(), 255);
-    str[255] = 0;
-    printf("   %s\n", str);
-  }
-
-  //    Ingest it
-  if (!Ingest_CM93_Cell((const char *)file.mb_str(), &m_CIB)) {
-    wxString msg(_T ( "   cm93chart  Error ingesting " ));
-    msg.Append(file);
-    wxLogMessage(msg);
-
-    if (compfile.Length()) wxRemoveFile(file);
-    return 0;
-  }
-
-  if (compfile.Length()) wxRemoveFile(file);
+  m_LastFileName = cell->file;
+
+  //    Share the decoded blocks, the per load state starts afresh
+  const Cell_Info_Block &cib = cell->cib;
+  Clear_CM93_Cell(&m_CIB);
+  m_CIB.transform_x_rate = cib.transform_x_rate;
+  m_CIB.transform_y_rate = cib.transform_y_rate;
+  m_CIB.transform_x_origin = cib.transform_x_origin;
+  m_CIB.transform_y_origin = cib.transform_y_origin;
+  m_CIB.p2dpoint_array = cib.p2dpoint_array;
+  m_CIB.pprelated_object_block = cib.pprelated_object_block;
+  m_CIB.attribute_block_top = cib.attribute_block_top;
+  m_CIB.edge_vector_descriptor_block = cib.edge_vector_descriptor_block;
+  m_CIB.point3d_descriptor_block = cib.point3d_descriptor_block;
+  m_CIB.pvector_record_block_top = cib.pvector_record_block_top;
+  m_CIB.p3dpoint_array = cib.p3dpoint_array;
+  m_CIB.m_nvector_records = cib.m_nvector_records;
+  m_CIB.m_nfeature_records = cib.m_nfeature_records;
+  m_CIB.m_n_point3d_records = cib.m_n_point3d_records;
+  m_CIB.m_n_point2d_records = cib.m_n_point2d_records;
+  m_CIB.min_lat = cib.min_lat;
+  m_CIB.min_lon = cib.min_lon;
+  m_CIB.object_vector_record_descriptor_block =
+      cib.object_vector_record_descriptor_block;
+  m_CIB.pobject_block = cib.pobject_block;
+  m_CIB.alloc_size = cib.alloc_size;
+  m_cell_set = cell_set;
 
   return 1;
 }
@@ -4515,6 +4508,15 @@ cm93_dictionary *cm93manager::FindAndLoadDict(const wxString &file) {
 //----------------------------------------------------------------------------
 // cm93 Composite Chart object class Implementation
 //----------------------------------------------------------------------------
+//    Called once the cells of a scale, read in the background, are ready to
+//    replace the less detailed scale drawn meanwhile
+static void OnCM93CellsReady() {
+  for (unsigned int i = 0; i < g_canvasArray.GetCount(); i++) {
+    ChartCanvas *cc = g_canvasArray.Item(i);
+    if (cc) cc->ReloadVP();
+  }
+}
+
 cm93compchart::cm93compchart() {
   m_ChartType = CHART_TYPE_CM93COMP;
   m_pDictComposite = NULL;
@@ -4551,6 +4553,8 @@ cm93compchart::~cm93compchart() {
 
   for (int i = 0; i < 8; i++) delete m_pcm93chart_array[i];
 
+  CM93CellCache::GetInstance().SetReadyCallback(nullptr);
+
   delete m_pDictComposite;
   delete m_pDummyBM;
   delete m_pcm93mgr;
@@ -4621,6 +4625,11 @@ InitReturn cm93compchart::Init(const wxString &name, ChartInitFlag flags) {
   //    Set the color scheme
   SetColorScheme(m_global_color_scheme, false);
 
+  //    Redraw when the cells of a scale which were missing are read
+  CM93CellCache::GetInstance().SetReadyCallback([]() {
+    if (gFrame) gFrame->CallAfter([]() { OnCM93CellsReady(); });
+  });
+
   bReadyToRender = true;
 
   return INIT_OK;
@@ -4804,6 +4813,26 @@ int cm93compchart::PrepareChartScale(const ViewPort &vpt, int cmscale,
     }
 
     if (m_pcm93chart_current) {
+      //    Rather than stall reading the cells of this scale, draw a less
+      //    detailed scale which is already loaded until they are ready
+      if (!m_pcm93chart_current->IsVPCellsReady(vpt)) {
+        int fallback = FindLoadedScale(vpt, cmscale);
+        if (fallback >= 0) {
+          std::vector<CM93CellRequest> requests;
+          for (int cell_index : m_pcm93chart_current->GetVPCellArray(vpt))
+            requests.push_back(
+                m_pcm93chart_current->GetCellRequest(cell_index));
+          CM93CellCache::GetInstance().Prefetch(requests, true);
+
+          if (g_bDebugCM93)
+            printf(" chart %c is loading, drawing %c\n",
+                   (char)('A' + cmscale - 1), (char)('A' + fallback - 1));
+
+          m_pcm93chart_current = m_pcm93chart_array[fallback];
+          return fallback;
+        }
+      }
+
       //    Pass the parameters to the proper scale chart
       //    Which will also load the needed cell(s)
       m_pcm93chart_current->SetVPParms(vpt);
@@ -4929,9 +4958,72 @@ int cm93compchart::PrepareChartScale(const ViewPort &vpt, int cmscale,
     }
   }
 
+  PrefetchCells(vpt, cmscale);
+
   return cmscale;
 }
 
+static const size_t kMaxPrefetchCells = 24;
+
+//    Return the most detailed scale below cmscale whose cells covering vpt
+//    are all loaded, or -1
+int cm93compchart::FindLoadedScale(const ViewPort &vpt, int cmscale) {
+  for (int s = cmscale - 1; s >= 0; s--) {
+    cm93chart *chart = m_pcm93chart_array[s];
+    if (!chart || !chart->IsVPLoaded(vpt)) continue;
+
+    chart->SetVPParms(vpt);  // no cell to load
+    if (chart->IsPointInLoadedM_COVR(vpt.clon, vpt.clat)) return s;
+  }
+  return -1;
+}
+
+void cm93compchart::GetCellRequests(const LLBBox &box, int scale_index,
+                                    std::vector<CM93CellRequest> &requests) {
+  int scale, dval;
+  wxChar scale_char;
+  Get_CM93_Scale_Params(scale_index, &scale, &dval, &scale_char);
+
+  //    Not worth it when zoomed out over many cells
+  std::vector<int> cells = Get_CM93_CellArray(box, scale, dval);
+  if (cells.size() > kMaxPrefetchCells) return;
+
+  cm93chart *chart = m_pcm93chart_array[scale_index];
+  CM93CellRequest request;
+  request.prefix = m_prefixComposite;
+  request.scalechar = wxString(scale_char);
+  request.dval = dval;
+  for (int cell_index : cells) {
+    if (chart && chart->IsCellLoaded(cell_index)) continue;
+    request.cell_index = cell_index;
+    requests.push_back(request);
+  }
+}
+
+//    Read ahead, in the background, the cells under the viewport at the next
+//    more and less detailed scales, and the cells around it at this scale
+void cm93compchart::PrefetchCells(const ViewPort &vpt, int cmscale) {
+  if (m_prefetch_vp == vpt) return;
+  m_prefetch_vp = vpt;
+
+  ViewPort vp = vpt;
+  LLBBox box = vp.GetBBox();
+  if (!box.GetValid()) return;
+
+  double dlat = box.GetLatRange() / 2, dlon = box.GetLonRange() / 2;
+  LLBBox around;
+  around.Set(wxMax(box.GetMinLat() - dlat, -79.99999),
+             box.GetMinLon() - dlon, wxMin(box.GetMaxLat() + dlat, 79.99999),
+             box.GetMaxLon() + dlon);
+
+  std::vector<CM93CellRequest> requests;
+  if (cmscale < 7) GetCellRequests(box, cmscale + 1, requests);
+  GetCellRequests(around, cmscale, requests);
+  if (cmscale > 0) GetCellRequests(box, cmscale - 1, requests);
+
+  CM93CellCache::GetInstance().Prefetch(requests, false);
+}
+
 //    Populate the member bool array describing which chart scales are available
 //    at any location
 void cm93compchart::FillScaleArray(double lat, double lon) {
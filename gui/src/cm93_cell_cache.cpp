@@ -0,0 +1,296 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Cache and background loader of decoded CM93 cells
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <algorithm>
+
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+
+#include "cm93_cell_cache.h"
+#include "model/chartdata_input_stream.h"
+
+static const size_t kDefaultMemoryBudget = 256 * 1024 * 1024;
+static const size_t kMaxQueued = 64;
+static const int kMaxWorkers = 4;
+
+std::string CM93CellRequest::GetKey() const {
+  wxString key;
+  key.Printf(_T("%s|%s|%d"), prefix.c_str(), scalechar.c_str(), cell_index);
+  return std::string(key.mb_str());
+}
+
+CM93Cell::CM93Cell() : sub_char('0') { Clear_CM93_Cell(&cib); }
+
+CM93Cell::~CM93Cell() { Free_CM93_Cell(&cib); }
+
+std::unique_ptr<CM93Cell> CM93Cell::Load(const wxString &file) {
+  wxString msg(_T ( "Loading CM93 cell " ));
+  msg += file;
+  wxLogMessage(msg);
+
+  wxString ingest_file = file;
+  bool compressed = file.EndsWith(_T(".xz"));
+  if (compressed) {
+    ingest_file =
+        wxFileName::CreateTempFileName(wxFileName(file).GetFullName());
+    if (!DecompressXZFile(file, ingest_file)) {
+      wxRemoveFile(ingest_file);
+      return nullptr;
+    }
+  }
+
+  std::unique_ptr<CM93Cell> cell(new CM93Cell);
+  cell->file = file;
+  bool ok = Ingest_CM93_Cell((const char *)ingest_file.mb_str(), &cell->cib);
+  if (compressed) wxRemoveFile(ingest_file);
+
+  if (!ok) {
+    wxString msg(_T ( "   cm93chart  Error ingesting " ));
+    msg.Append(file);
+    wxLogMessage(msg);
+    return nullptr;
+  }
+  return cell;
+}
+
+const CM93Cell *CM93CellSet::Find(wxChar sub_char) const {
+  for (auto &cell : cells)
+    if (cell->sub_char == sub_char) return cell.get();
+  return NULL;
+}
+
+CM93CellCache &CM93CellCache::GetInstance() {
+  static CM93CellCache instance;
+  return instance;
+}
+
+CM93CellCache::CM93CellCache()
+    : m_mem_size(0),
+      m_mem_budget(kDefaultMemoryBudget),
+      m_notify_in_flight(0),
+      m_stop(false) {}
+
+CM93CellCache::~CM93CellCache() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+    m_queue.clear();
+  }
+  m_work_cv.notify_all();
+  for (auto &worker : m_workers) worker.join();
+}
+
+//  Same sequence as the original synchronous loader: the base cell '0' if
+//  present, then the subcells 'A', 'B'... up to the first missing one.
+std::shared_ptr<const CM93CellSet> CM93CellCache::LoadCells(
+    const CM93CellRequest &request) {
+  auto set = std::make_shared<CM93CellSet>();
+  wxChar sub_char = '0';
+  while (true) {
+    wxString file =
+        Find_CM93_Cell_File(request.prefix, request.scalechar, request.dval,
+                            request.cell_index, sub_char);
+    if (file.IsEmpty()) {
+      if (sub_char != '0') break;
+    } else {
+      std::unique_ptr<CM93Cell> cell = CM93Cell::Load(file);
+      if (!cell) {
+        if (sub_char != '0') break;
+      } else {
+        cell->sub_char = sub_char;
+        set->mem_size += cell->cib.alloc_size;
+        set->cells.push_back(std::move(cell));
+      }
+    }
+    sub_char = (sub_char == '0') ? 'A' : sub_char + 1;
+  }
+  return set;
+}
+
+std::shared_ptr<const CM93CellSet> CM93CellCache::Get(
+    const CM93CellRequest &request) {
+  std::string key = request.GetKey();
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    while (it != m_entries.end() && it->second.loading) {
+      m_done_cv.wait(lock);
+      it = m_entries.find(key);  // may have been evicted meanwhile
+    }
+    if (it != m_entries.end() && it->second.cells) {
+      m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+      return it->second.cells;
+    }
+    m_entries[key].loading = true;
+
+    //  Loaded here, no need for a worker to do it again
+    m_queue.erase(
+        std::remove_if(m_queue.begin(), m_queue.end(),
+                       [&](const Pending &p) { return p.key == key; }),
+        m_queue.end());
+  }
+
+  std::shared_ptr<const CM93CellSet> cells = LoadCells(request);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (Store(key, cells)) RunReadyCallback(lock);
+  return cells;
+}
+
+bool CM93CellCache::IsCached(const CM93CellRequest &request) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_entries.find(request.GetKey());
+  return it != m_entries.end() && it->second.cells;
+}
+
+bool CM93CellCache::Store(const std::string &key,
+                          std::shared_ptr<const CM93CellSet> cells) {
+  Entry &entry = m_entries[key];
+  bool notify = entry.notify;
+  entry.loading = false;
+  entry.notify = false;
+  entry.cells = cells;
+  m_lru.push_front(key);
+  entry.lru = m_lru.begin();
+  m_mem_size += cells->mem_size;
+  Evict();
+  m_done_cv.notify_all();
+
+  if (!notify) return false;
+  m_notify_in_flight--;
+  return !HasNotifyPending();
+}
+
+void CM93CellCache::RunReadyCallback(std::unique_lock<std::mutex> &lock) {
+  if (!m_ready_callback || m_stop) return;
+  std::function<void()> callback = m_ready_callback;
+  lock.unlock();
+  callback();
+  lock.lock();
+}
+
+void CM93CellCache::Evict() {
+  //  Keep at least the most recent set, whatever its size
+  while (m_mem_size > m_mem_budget && m_lru.size() > 1) {
+    auto it = m_entries.find(m_lru.back());
+    m_mem_size -= it->second.cells->mem_size;
+    m_entries.erase(it);
+    m_lru.pop_back();
+  }
+}
+
+bool CM93CellCache::HasNotifyPending() const {
+  if (m_notify_in_flight) return true;
+  for (const Pending &p : m_queue)
+    if (p.notify) return true;
+  return false;
+}
+
+void CM93CellCache::Prefetch(const std::vector<CM93CellRequest> &requests,
+                             bool notify) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_stop) return;
+
+  //  Push in reverse so the first request ends up at the queue head
+  for (auto it = requests.rbegin(); it != requests.rend(); ++it) {
+    //  Copies of a wxString may share its buffer, the workers get their own
+    Pending pending = {*it, it->GetKey(), notify};
+    pending.request.prefix = wxString(it->prefix.wc_str());
+    pending.request.scalechar = wxString(it->scalechar.wc_str());
+    auto e = m_entries.find(pending.key);
+    if (e != m_entries.end() && e->second.cells) continue;
+    if (e != m_entries.end() && e->second.loading) {
+      if (notify && !e->second.notify) {
+        e->second.notify = true;
+        m_notify_in_flight++;
+      }
+      continue;
+    }
+
+    auto q = std::find_if(
+        m_queue.begin(), m_queue.end(),
+        [&](const Pending &p) { return p.key == pending.key; });
+    if (q != m_queue.end()) {
+      pending.notify |= q->notify;
+      m_queue.erase(q);
+    }
+    m_queue.push_front(pending);
+  }
+  //  Trim stale speculative requests, never the ones a caller waits for
+  size_t max_queued = std::max(kMaxQueued, requests.size());
+  for (auto q = m_queue.end();
+       m_queue.size() > max_queued && q != m_queue.begin();) {
+    --q;
+    if (!q->notify) q = m_queue.erase(q);
+  }
+
+  if (m_queue.empty()) return;
+  StartWorkers();
+  m_work_cv.notify_all();
+}
+
+void CM93CellCache::SetMemoryBudget(size_t bytes) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_mem_budget = bytes;
+  Evict();
+}
+
+void CM93CellCache::SetReadyCallback(std::function<void()> callback) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_ready_callback = callback;
+}
+
+void CM93CellCache::StartWorkers() {
+  if (m_workers.size()) return;
+
+  int n = std::thread::hardware_concurrency() / 2;
+  n = std::max(1, std::min(n, kMaxWorkers));
+  for (int i = 0; i < n; i++)
+    m_workers.emplace_back(&CM93CellCache::Run, this);
+}
+
+void CM93CellCache::Run() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_work_cv.wait(lock, [&] { return m_stop || m_queue.size(); });
+    if (m_stop) return;
+
+    Pending pending = m_queue.front();
+    m_queue.pop_front();
+
+    Entry &entry = m_entries[pending.key];
+    if (entry.cells || entry.loading) continue;
+    entry.loading = true;
+    entry.notify = pending.notify;
+    if (pending.notify) m_notify_in_flight++;
+
+    lock.unlock();
+    std::shared_ptr<const CM93CellSet> cells = LoadCells(pending.request);
+    lock.lock();
+
+    if (Store(pending.key, cells)) RunReadyCallback(lock);
+  }
+}
@@ -34,6 +34,7 @@
 #include "dychart.h"
 
 #include <algorithm>
+#include <list>
 #include <stdint.h>
 #include <vector>
 
@@ -58,6 +59,8 @@
 #include <wx/window.h>
 
 #include "model/own_ship.h"
+#include "model/perf_trace.h"
+#include "model/render_stats.h"
 #include "model/route.h"
 #include "model/routeman.h"
 #include "model/track.h"
@@ -73,6 +76,7 @@
 #include "color_handler.h"
 #include "compass.h"
 #include "config.h"
+#include "dxt1.h"
 #include "emboss_data.h"
 #include "FontMgr.h"
 #include "glChartCanvas.h"
@@ -233,6 +237,7 @@ extern ShapeBaseChartSet gShapeBasemap;
 //    For VBO(s)
 bool g_b_EnableVBO;
 bool g_b_needFinish;  // Need glFinish() call on each frame?
+bool g_bShowRenderStats;  // Draw render pass timings on the canvas?
 
 // MacOS has some missing parts:
 #ifndef APIENTRY
@@ -1028,6 +1033,7 @@ void glChartCanvas::BuildFBO() {
 }
 
 void glChartCanvas::SetupOpenGL() {
+  PerfScope perf("glChartCanvas::SetupOpenGL");
   SetCurrent(*m_pcontext);
 
   char *str = (char *)glGetString(GL_RENDERER);
@@ -1248,6 +1254,7 @@ void glChartCanvas::SetupOpenGL() {
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
   MipMap_ResolveRoutines();
+  Dxt1_ResolveRoutines();
   SetupCompression();
 
   wxString lwmsg;
@@ -1336,7 +1343,7 @@ void glChartCanvas::SetupCompression() {
     /* because s3tc is patented, many foss drivers disable
        support by default, however the extension dxt1 allows
        us to load this texture type which is enough because we
-       compress in software using libsquish for superior quality anyway */
+       compress in software for superior quality anyway */
 
     if ((QueryExtension("GL_EXT_texture_compression_s3tc") ||
          QueryExtension("GL_EXT_texture_compression_dxt1"))
@@ -2686,10 +2693,12 @@ void glChartCanvas::DrawFloatingOverlayObjects(ocpnDC &dc) {
 
   // all functions called with m_pParentCanvas-> are still slow because they go
   // through ocpndc
+  RenderPassTimer ais_timer("AISDraw");
   AISDrawAreaNotices(dc, m_pParentCanvas->GetVP(), m_pParentCanvas);
 
   m_pParentCanvas->DrawAnchorWatchPoints(dc);
   AISDraw(dc, m_pParentCanvas->GetVP(), m_pParentCanvas);
+  ais_timer.Stop();
   ShipDraw(dc);
   m_pParentCanvas->AlertDraw(dc);
 
@@ -2902,7 +2911,7 @@ void glChartCanvas::DrawRegion(ViewPort &vp, const LLRegion &region) {
   gluTessNormal(tobj, 0, 0, 1);
 
   gluTessBeginPolygon(tobj, NULL);
-  for (std::list<poly_contour>::const_iterator i = region.contours.begin();
+  for (std::vector<poly_contour>::const_iterator i = region.contours.begin();
        i != region.contours.end(); i++) {
     gluTessBeginContour(tobj);
     contour_pt l = *i->rbegin();
@@ -3477,6 +3486,7 @@ void glChartCanvas::RenderQuiltViewGLText(ViewPort &vp,
 }
 
 void glChartCanvas::RenderCharts(ocpnDC &dc, const OCPNRegion &rect_region) {
+  PerfScope perf("glChartCanvas::RenderCharts");
   ViewPort &vp = m_pParentCanvas->VPoint;
 
   // Only for cm93 (not quilted), SetVPParms can change the valid region of the
@@ -3547,9 +3557,10 @@ void glChartCanvas::RenderCharts(ocpnDC &dc, const OCPNRegion &rect_region) {
     }
   }
 
-  if (vp.b_quilt)
+  if (vp.b_quilt) {
+    RenderPassTimer timer("RenderQuiltViewGL");
     RenderQuiltViewGL(vp, rect_region);
-  else {
+  } else {
     LLRegion region = vp.GetLLRegion(rect_region);
     if (m_pParentCanvas->m_singleChart->GetChartFamily() ==
         CHART_FAMILY_RASTER) {
@@ -3831,11 +3842,52 @@ void glChartCanvas::RenderGLAlertMessage() {
   }
 }
 
+void glChartCanvas::DrawRenderStats() {
+  std::vector<RenderPassStats> summary =
+      RenderStats::GetInstance().GetSummary();
+  if (summary.empty()) return;
+
+  std::vector<wxString> lines;
+  lines.push_back(wxString::Format("%-36s %7s %7s %7s %7s", "Pass (ms)",
+                                   "last", "p50", "p95", "p99"));
+  for (const auto &stats : summary) {
+    lines.push_back(wxString::Format("%-36.36s %7.2f %7.2f %7.2f %7.2f",
+                                     stats.pass.c_str(), stats.last,
+                                     stats.p50, stats.p95, stats.p99));
+  }
+
+  wxFont font(10, wxFONTFAMILY_TELETYPE, wxFONTSTYLE_NORMAL,
+              wxFONTWEIGHT_NORMAL);
+  m_gldc.SetFont(font);
+
+  int w = 0, h = 0;
+  wxScreenDC sdc;
+  for (const auto &line : lines) {
+    int lw, lh;
+    sdc.GetTextExtent(line, &lw, &lh, NULL, NULL, &font);
+    w = wxMax(w, lw);
+    h = wxMax(h, lh);
+  }
+
+  int xp = 10;
+  int yp = 10 + m_pParentCanvas->m_focus_indicator_pix * m_displayScale;
+
+  wxPen ppPen1(GetGlobalColor(_T ( "UBLCK" )), 1, wxPENSTYLE_SOLID);
+  m_gldc.SetPen(ppPen1);
+  m_gldc.SetBrush(wxBrush(GetGlobalColor(_T ( "UIBCK" ))));
+  m_gldc.DrawRectangle(xp, yp, w + 8, h * lines.size() + 4);
+
+  m_gldc.SetTextForeground(GetGlobalColor(_T ( "UITX1" )));
+  for (size_t i = 0; i < lines.size(); i++)
+    m_gldc.DrawText(lines[i], xp + 4, yp + 2 + h * i);
+}
+
 unsigned long quiltHash;
 int refChartIndex;
 
 int n_render;
 void glChartCanvas::Render() {
+  PerfScope perf("glChartCanvas::Render");
   if (!m_bsetup || !m_pParentCanvas->m_pQuilt ||
       (m_pParentCanvas->VPoint.b_quilt && !m_pParentCanvas->m_pQuilt) ||
       (!m_pParentCanvas->VPoint.b_quilt && !m_pParentCanvas->m_singleChart)) {
@@ -3846,6 +3898,8 @@ void glChartCanvas::Render() {
     if(!g_PrintingInProgress) return;
   }
 
+  RenderPassTimer frame_timer(RenderStats::kFrame);
+
 #if defined(USE_ANDROID_GLES2) || defined(ocpnUSE_GLSL)
   loadShaders(GetCanvasIndex());
   configureShaders(m_pParentCanvas->VPoint);
@@ -3981,6 +4035,8 @@ void glChartCanvas::Render() {
 
   g_glTextureManager->TextureCrunch(0.8);
 
+  RenderPassTimer charts_timer("Charts");
+
   //  If we plan to post process the display, don't use accelerated panning
   double scale_factor = VPoint.ref_scale / VPoint.chart_scale;
 
@@ -4361,22 +4417,32 @@ void glChartCanvas::Render() {
   {
     RenderCharts(m_gldc, screen_region);
   }
+  charts_timer.Stop();
 
 #if 1
   // Done with base charts.
   // Now the overlays
-  RenderS57TextOverlay(VPoint);
-  RenderMBTilesOverlay(VPoint);
+  {
+    RenderPassTimer timer("RenderS57TextOverlay");
+    RenderS57TextOverlay(VPoint);
+  }
+  {
+    RenderPassTimer timer("RenderMBTilesOverlay");
+    RenderMBTilesOverlay(VPoint);
+  }
 
   // Render static overlay objects
+  RenderPassTimer grounded_timer("DrawGroundedOverlayObjects");
   for (OCPNRegionIterator upd(screen_region); upd.HaveRects(); upd.NextRect()) {
     wxRect rt = upd.GetRect();
     LLRegion region = VPoint.GetLLRegion(rt);
     ViewPort cvp = ClippedViewport(VPoint, region);
     DrawGroundedOverlayObjects(gldc, cvp);
   }
+  grounded_timer.Stop();
 
   if (m_pParentCanvas->m_bShowTide || m_pParentCanvas->m_bShowCurrent) {
+    RenderPassTimer timer("Tides and currents");
     LLRegion screenLLRegion = VPoint.GetLLRegion(screen_region);
     LLBBox screenBox = screenLLRegion.GetBox();
     // Enlarge the box a bit
@@ -4421,11 +4487,17 @@ void glChartCanvas::Render() {
     }
   }
 
-  DrawDynamicRoutesTracksAndWaypoints(VPoint);
+  {
+    RenderPassTimer timer("DrawDynamicRoutesTracksAndWaypoints");
+    DrawDynamicRoutesTracksAndWaypoints(VPoint);
+  }
 
   // Now draw all the objects which normally move around and are not
   // cached from the previous frame
-  DrawFloatingOverlayObjects(m_gldc);
+  {
+    RenderPassTimer timer("DrawFloatingOverlayObjects");
+    DrawFloatingOverlayObjects(m_gldc);
+  }
 
 #ifndef USE_ANDROID_GLES2
   // from this point on don't use perspective
@@ -4532,7 +4604,12 @@ void glChartCanvas::Render() {
 
   if (g_b_needFinish) glFinish();
 
-  SwapBuffers();
+  if (g_bShowRenderStats) DrawRenderStats();
+
+  {
+    RenderPassTimer timer("SwapBuffers");
+    SwapBuffers();
+  }
 
   g_glTextureManager->TextureCrunch(0.8);
   g_glTextureManager->FactoryCrunch(0.6);
@@ -5367,6 +5444,13 @@ void glChartCanvas::configureShaders(ViewPort & vp) {
       shader->SetUniformMatrix4fv("TransformMatrix", (GLfloat *)I);
       shader->UnBind();
 
+      shader = pais_batch_shader_program[GetCanvasIndex()];
+      if (shader) {
+        shader->Bind();
+        shader->SetUniformMatrix4fv("MVMatrix", (GLfloat *)pvp->vp_matrix_transform);
+        shader->UnBind();
+      }
+
       //  Leftover shader required by some older Android plugins
       if (texture_2DA_shader_program){
         glUseProgram(texture_2DA_shader_program);
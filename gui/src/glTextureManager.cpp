@@ -24,6 +24,14 @@
  ***************************************************************************
  */
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 #include <wx/wxprec.h>
 #include <wx/progdlg.h>
 #include <wx/wx.h>
@@ -57,13 +65,12 @@
 #define GL_ETC1_RGB8_OES 0x8D64
 #endif
 
-#include "squish.h"
+#include "dxt1.h"
 #include "lz4.h"
 #include "lz4hc.h"
 
 #include <wx/listimpl.cpp>
 WX_DEFINE_LIST(JobList);
-WX_DEFINE_LIST(ProgressInfoList);
 
 WX_DEFINE_ARRAY_PTR(ChartCanvas *, arrayofCanvasPtr);
 
@@ -183,11 +190,6 @@ class compress_target {
   double distance;
 };
 
-#include <wx/arrimpl.cpp>
-
-WX_DECLARE_OBJARRAY(compress_target, ArrayOfCompressTargets);
-// WX_DEFINE_OBJARRAY(ArrayOfCompressTargets);
-
 JobTicket::JobTicket() {
   for (int i = 0; i < 10; i++) {
     compcomp_size_array[i] = 0;
@@ -368,56 +370,11 @@ int TextureTileSize(int level, bool compressed) {
   return size;
 }
 
-bool JobTicket::DoJob() {
-  if (!m_rect.IsEmpty()) return DoJob(m_rect);
-
-  // otherwise this ticket covers all the rects in the chart
-  ChartBase *pchart = ChartData->OpenChartFromDB(m_ChartPath, FULL_INIT);
-  if (!pchart) return false;
-
-  ChartBaseBSB *pBSBChart = dynamic_cast<ChartBaseBSB *>(pchart);
-  if (!pBSBChart) return false;
-
-  int size_X = pBSBChart->GetSize_X();
-  int size_Y = pBSBChart->GetSize_Y();
-
-  int dim = g_GLOptions.m_iTextureDimension;
-
-  int nx_tex = ceil((float)size_X / dim);
-  int ny_tex = ceil((float)size_Y / dim);
-
-  wxRect rect;
-  rect.y = 0;
-  rect.width = dim;
-  rect.height = dim;
-  for (int y = 0; y < ny_tex; y++) {
-    if (pthread && pthread->m_pMessageTarget) {
-      OCPN_CompressionThreadEvent Nevent(wxEVT_OCPN_COMPRESSIONTHREAD, 0);
-      Nevent.nstat = y;
-      Nevent.nstat_max = ny_tex;
-      Nevent.type = 1;
-      Nevent.SetTicket(this);
-      pthread->m_pMessageTarget->AddPendingEvent(Nevent);
-    }
-
-    rect.x = 0;
-    for (int x = 0; x < nx_tex; x++) {
-      if (!DoJob(rect)) return false;
-
-      pFact->UpdateCacheAllLevels(rect, global_color_scheme,
-                                  compcomp_bits_array, compcomp_size_array);
-
-      for (int i = 0; i < g_mipmap_max_level + 1; i++) {
-        free(comp_bits_array[i]), comp_bits_array[i] = 0;
-        free(compcomp_bits_array[i]), compcomp_bits_array[i] = 0;
-      }
-
-      rect.x += rect.width;
-    }
-    rect.y += rect.height;
+void JobTicket::FreeCompressedBits() {
+  for (int i = 0; i < g_mipmap_max_level + 1; i++) {
+    free(comp_bits_array[i]), comp_bits_array[i] = 0;
+    free(compcomp_bits_array[i]), compcomp_bits_array[i] = 0;
   }
-
-  return true;
 }
 
 #if 0  // defined( __UNIX__ ) && !defined(__WXOSX__)  // high resolution
@@ -508,20 +465,19 @@ bool JobTicket::DoJob(const wxRect &rect) {
     int size = TextureTileSize(level, true);
     unsigned char *tex_data = (unsigned char *)malloc(size);
     if (g_raster_format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) {
-      // color range fit is worse quality but twice as fast
-      int flags = squish::kDxt1 | squish::kColourRangeFit;
+      // the fast mode skips the endpoint refinement
+      Dxt1Quality quality = DXT1_FAST;
 
       if (g_GLOptions.m_bTextureCompressionCaching) {
-        /* use slower cluster fit since we are building the cache for
-         * better quality, this takes roughly 25% longer and uses about
-         * 10% more disk space (result doesn't compress as well with lz4) */
-        flags = squish::kDxt1 | squish::kColourClusterFit;
+        /* use the slower quality mode since we are building the cache,
+         * the result is kept for good */
+        quality = DXT1_QUALITY;
       }
 
       OCPNStopWatch sww;
-      squish::CompressImageRGBpow2_Flatten_Throttle_Abort(
-          bit_array[level], dim, dim, tex_data, flags, true,
-          b_throttle ? throttle_func : 0, &sww, b_abort);
+      Dxt1_CompressImageRGB(bit_array[level], dim, dim, tex_data, quality,
+                            true, b_throttle ? throttle_func : 0, &sww,
+                            b_abort);
 
     } else if (g_raster_format == GL_ETC1_RGB8_OES)
       CompressDataETC(bit_array[level], dim, size, tex_data, b_abort);
@@ -622,8 +578,6 @@ wxEvent *OCPN_CompressionThreadEvent::Clone() const {
       new OCPN_CompressionThreadEvent(*this);
   newevent->m_ticket = this->m_ticket;
   newevent->type = this->type;
-  newevent->nstat = this->nstat;
-  newevent->nstat_max = this->nstat_max;
   /*
       newevent->m_ticket = new JobTicket;
 
@@ -677,7 +631,7 @@ void *CompressionPoolThread::Entry() {
   {
     SetPriority(WXTHREAD_MIN_PRIORITY);
 
-    if (!m_ticket->DoJob()) m_ticket->b_isaborted = true;
+    if (!m_ticket->DoJob(m_ticket->m_rect)) m_ticket->b_isaborted = true;
 
     if (m_pMessageTarget) {
       OCPN_CompressionThreadEvent Nevent(wxEVT_OCPN_COMPRESSIONTHREAD, 0);
@@ -725,8 +679,6 @@ glTextureManager::glTextureManager() {
 
   m_progDialog = NULL;
 
-  for (int i = 0; i < m_max_jobs; i++) progList.Append(new ProgressInfoItem);
-
   //  Create/connect a dynamic event handler slot for messages from the worker
   //  threads
   Connect(
@@ -736,7 +688,6 @@ glTextureManager::glTextureManager() {
   m_ticks = 0;
   m_skip = false;
   m_bcompact = false;
-  m_skipout = false;
 
   m_timer.Connect(wxEVT_TIMER, wxTimerEventHandler(glTextureManager::OnTimer),
                   NULL, this);
@@ -746,107 +697,17 @@ glTextureManager::glTextureManager() {
 glTextureManager::~glTextureManager() {
   //    ClearAllRasterTextures();
   ClearJobList();
-  for (int i = 0; i < m_max_jobs; i++) {
-    delete(progList[i]);
-  }
-  progList.Clear();
   for(auto hash : m_chart_texfactory_hash) {
     delete hash.second;
   }
   m_chart_texfactory_hash.clear();
 }
 
-#define NBAR_LENGTH 40
-
 void glTextureManager::OnEvtThread(OCPN_CompressionThreadEvent &event) {
   JobTicket *ticket = event.GetTicket();
 
-  if (event.type == 1) {
-    if (!m_progDialog) {
-      // currently unreachable, but...
-      return;
-    }
-    // Look for a matching entry...
-    bool bfound = false;
-    ProgressInfoItem *item;
-    wxProgressInfoListNode *tnode = progList.GetFirst();
-    while (tnode) {
-      item = tnode->GetData();
-      if (item->file_path == ticket->m_ChartPath) {
-        bfound = true;
-        break;
-      }
-      tnode = tnode->GetNext();
-    }
-
-    if (!bfound) {
-      // look for an empty slot
-      tnode = progList.GetFirst();
-      while (tnode) {
-        item = tnode->GetData();
-        if (item->file_path.IsEmpty()) {
-          bfound = true;
-          item->file_path = ticket->m_ChartPath;
-          break;
-        }
-        tnode = tnode->GetNext();
-      }
-    }
-
-    if (bfound) {
-      wxString msgx;
-      if (1) {
-        int bar_length = NBAR_LENGTH;
-        if (m_bcompact) bar_length = 20;
-
-        msgx += _T("\n[");
-        wxString block = wxString::Format(_T("%c"), 0x2588);
-        float cutoff = -1.;
-        if (event.nstat_max != 0)
-          cutoff = ((event.nstat + 1) / (float)event.nstat_max) * bar_length;
-        for (int i = 0; i < bar_length; i++) {
-          if (i <= cutoff)
-            msgx += block;
-          else
-            msgx += _T("-");
-        }
-        msgx += _T("]");
-
-        if (!m_bcompact) {
-          wxString msgy;
-          msgy.Printf(_T("  [%3d/%3d]  "), event.nstat + 1, event.nstat_max);
-          msgx += msgy;
-
-          wxFileName fn(ticket->m_ChartPath);
-          msgx += fn.GetFullName();
-        }
-      } else
-        msgx.Printf(_T("\n %3d/%3d"), event.nstat + 1, event.nstat_max);
-
-      item->msgx = msgx;
-    }
-
-    // Ready to compose
-    wxString msg;
-    tnode = progList.GetFirst();
-    while (tnode) {
-      item = tnode->GetData();
-      msg += item->msgx + _T("\n");
-      tnode = tnode->GetNext();
-    }
-
-    if (m_skipout) m_progMsg = _T("Skipping, please wait...\n\n");
-
-    if (!m_progDialog->Update(m_jcnt, m_progMsg + msg, &m_skip)) m_skip = true;
-    if (m_skip) m_skipout = true;
-    return;
-  }
-
   if (ticket->b_isaborted || ticket->b_abort) {
-    for (int i = 0; i < g_mipmap_max_level + 1; i++) {
-      free(ticket->comp_bits_array[i]);
-      free(ticket->compcomp_bits_array[i]);
-    }
+    ticket->FreeCompressedBits();
 
     if (bthread_debug)
       printf(
@@ -854,7 +715,7 @@ void glTextureManager::OnEvtThread(OCPN_CompressionThreadEvent &event) {
           "\n",
           ticket->ident, GetRunningJobCount(),
           (unsigned long)todo_list.GetCount());
-  } else if (!ticket->b_inCompressAll) {
+  } else {
     //   Normal completion from here
     glTextureDescriptor *ptd = ticket->pFact->GetpTD(ticket->m_rect);
     if (ptd) {
@@ -883,21 +744,6 @@ void glTextureManager::OnEvtThread(OCPN_CompressionThreadEvent &event) {
           (unsigned long)todo_list.GetCount());
   }
 
-  //      Free all possible memory
-  if (ticket->b_inCompressAll) {  // if compressing all write cache here
-    ChartBase *pchart =
-        ChartData->OpenChartFromDB(ticket->m_ChartPath, FULL_INIT);
-    ChartData->DeleteCacheChart(pchart);
-    delete ticket->pFact;
-  }
-
-  wxProgressInfoListNode *tnode = progList.GetFirst();
-  while (tnode) {
-    ProgressInfoItem *item = tnode->GetData();
-    if (item->file_path == ticket->m_ChartPath) item->file_path = _T("");
-    tnode = tnode->GetNext();
-  }
-
   if (g_raster_format != GL_COMPRESSED_RGB_FXT1_3DFX) {
     running_list.DeleteObject(ticket);
     StartTopJob();
@@ -1005,11 +851,10 @@ bool glTextureManager::ScheduleJob(glTexFactory *client, const wxRect &rect,
   pt->b_isaborted = false;
   pt->bpost_zip_compress = b_postZip;
   pt->binplace = b_inplace;
-  pt->b_inCompressAll = b_inCompressAllCharts;
 
   /* do we compress in ram using builtin libraries, or do we
      upload to the gpu and use the driver to perform compression?
-     we have builtin libraries for DXT1 (squish) and ETC1 (etcpak)
+     we have builtin libraries for DXT1 (dxt1) and ETC1 (etcpak)
      FXT1 must use the driver, ETC1 cannot, and DXT1 can use the driver
      but the results are worse and don't compress well.
 
@@ -1337,7 +1182,116 @@ bool glTextureManager::FactoryCrunch(double factor) {
   return true;
 }
 
-void glTextureManager::BuildCompressedCache() {
+/** A chart whose tiles are being compressed by CompressAllCharts(). */
+struct CacheBuildChart {
+  wxString path;
+  ChartBase *chart;
+  glTexFactory *factory;
+  int tiles_total;
+  std::atomic<int> tiles_done{0};
+  std::atomic<int> tiles_compressed{0};
+  std::mutex mutex;  ///< Serializes updates of the cache file
+};
+
+/**
+ * Threads compressing single tiles into the cache file of their chart.
+ * Each tile is stored as soon as it is done, so an interrupted build
+ * resumes from there. Without threads, tiles are compressed by Add() in
+ * the calling thread as GPU compression requires.
+ */
+class CacheBuildPool {
+public:
+  explicit CacheBuildPool(int threads) {
+    for (int i = 0; i < threads; i++)
+      m_threads.emplace_back([this] { Work(); });
+  }
+
+  ~CacheBuildPool() {
+    Clear();
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_cond.notify_all();
+    for (auto &thread : m_threads) thread.join();
+  }
+
+  void Add(JobTicket *ticket, CacheBuildChart *chart) {
+    if (m_threads.empty()) {
+      Compress(ticket, chart);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_queue.emplace_back(ticket, chart);
+    }
+    m_cond.notify_one();
+  }
+
+  size_t GetQueued() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queue.size();
+  }
+
+  /** Drop tiles not yet started, the running ones are completed. */
+  void Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &job : m_queue) {
+      delete job.first;
+      job.second->tiles_done++;
+    }
+    m_queue.clear();
+  }
+
+private:
+  static void Compress(JobTicket *ticket, CacheBuildChart *chart) {
+#ifdef __MSVC__
+    try
+#endif
+    {
+      if (ticket->DoJob(ticket->m_rect)) {
+        std::lock_guard<std::mutex> lock(chart->mutex);
+        if (chart->factory->UpdateCacheAllLevels(
+                ticket->m_rect, global_color_scheme,
+                ticket->compcomp_bits_array, ticket->compcomp_size_array))
+          chart->tiles_compressed++;
+      }
+    }
+#ifdef __MSVC__
+    catch (SE_Exception e) {
+      //  Tile is left out of the cache, and retried on the next build
+    }
+#endif
+    ticket->FreeCompressedBits();
+    delete ticket;
+    chart->tiles_done++;
+  }
+
+  void Work() {
+#ifdef __MSVC__
+    _set_se_translator(my_translate);
+#endif
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+      m_cond.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+      if (m_queue.empty()) return;
+      auto job = m_queue.front();
+      m_queue.pop_front();
+      lock.unlock();
+      Compress(job.first, job.second);
+      lock.lock();
+    }
+  }
+
+  std::vector<std::thread> m_threads;
+  std::deque<std::pair<JobTicket *, CacheBuildChart *>> m_queue;
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  bool m_stop = false;
+};
+
+bool glTextureManager::CompressAllCharts(
+    const std::function<bool(const CacheBuildStatus &)> &progress) {
   idx_sorted_by_distance.Clear();
 
   // Building the cache may take a long time....
@@ -1356,18 +1310,12 @@ void glTextureManager::BuildCompressedCache() {
       if (chart_type != CHART_TYPE_KAP) continue;
     }
 
-    wxString CompressedCacheFilePath =
-        CompressedCachePath(ChartData->GetDBChartFileName(i));
-    wxFileName fn(CompressedCacheFilePath);
-    //        if(fn.FileExists()) /* skip if file exists */
-    //            continue;
-
     idx_sorted_by_distance.Add(i);
 
     count++;
   }
 
-  if (count == 0) return;
+  if (count == 0) return false;
 
   wxLogMessage(
       wxString::Format(_T("BuildCompressedCache() count = %d"), count));
@@ -1407,23 +1355,176 @@ void glTextureManager::BuildCompressedCache() {
   //  We need to do this, as the chart table will not be invariant
   //  after the compression threads start, so our index array will be invalid.
 
-  ArrayOfCompressTargets ct_array;
+  std::vector<compress_target> ct_array;
   for (unsigned int j = 0; j < idx_sorted_by_distance.GetCount(); j++) {
     int i = idx_sorted_by_distance[j];
 
     const ChartTableEntry &cte = ChartData->GetChartTableEntry(i);
-    double distance = chart_dist(i);
+    compress_target ct;
+    ct.distance = chart_dist(i);
+    ct.chart_path = cte.GetFullSystemPath();
+    ct_array.push_back(ct);
+  }
+
+  //  Every tile is a job of its own, so that large charts are spread over all
+  //  cores. GPU compression must stay in this thread.
+  int threads = g_raster_format == GL_COMPRESSED_RGB_FXT1_3DFX ? 0 : m_max_jobs;
+  size_t max_queued = 2 * std::max(threads, 1);
+
+  CacheBuildStatus status;
+  status.charts_done = 0;
+  status.charts_total = ct_array.size();
+  status.distance = 0;
+  status.tiles_done = 0;
+  status.tiles_total = 0;
+  status.tiles_compressed = 0;
+
+  std::vector<std::unique_ptr<CacheBuildChart>> active;
+  long tiles_released = 0;
+  long compressed_released = 0;
+  bool skip = false;
+  wxStopWatch report_sw;
+
+  //  Release the charts with all tiles done, and report progress now and
+  //  then, or at once if final
+  auto update = [&](bool final) {
+    status.active.clear();
+    status.tiles_done = tiles_released;
+    status.tiles_compressed = compressed_released;
+    for (auto it = active.begin(); it != active.end();) {
+      CacheBuildChart *chart = it->get();
+      int done = chart->tiles_done;
+      status.tiles_compressed += chart->tiles_compressed;
+      if (done < chart->tiles_total) {
+        status.tiles_done += done;
+        status.active.push_back({chart->path, done, chart->tiles_total});
+        ++it;
+        continue;
+      }
+      tiles_released += chart->tiles_total;
+      compressed_released += chart->tiles_compressed;
+      status.tiles_done += chart->tiles_total;
+      ChartData->DeleteCacheChart(chart->chart);
+      delete chart->factory;
+      it = active.erase(it);
+    }
+    if (!final && report_sw.Time() < 100) return;
+    report_sw.Start();
+    if (!progress(status)) skip = true;
+  };
+
+  {
+    CacheBuildPool pool(threads);
+
+    for (size_t j = 0; j < ct_array.size() && !skip; j++) {
+      //  Keep the queue short, so that charts are opened just in time and
+      //  skipping is quick
+      while (pool.GetQueued() > max_queued && !skip) {
+        wxThread::Sleep(50);
+        update(false);
+      }
+      if (skip) break;
+      update(false);
+
+      wxString filename = ct_array[j].chart_path;
+      status.charts_done = j + 1;
+      status.distance = ct_array[j].distance;
+
+      ChartBase *pchart =
+          ChartData->OpenChartFromDBAndLock(filename, FULL_INIT);
+      if (!pchart) /* probably a corrupt chart */
+        continue;
+
+      // bad things if more than one texfactory for a chart
+      PurgeChartTextures(pchart, true);
+
+      ChartBaseBSB *pBSBChart = dynamic_cast<ChartBaseBSB *>(pchart);
+      if (pBSBChart == 0) continue;
+
+      glTexFactory *tex_fact = new glTexFactory(pchart, g_raster_format);
+
+      //  Schedule the tiles with any level not yet in the cache. Levels are
+      //  compressed from the first one missing, those already in the cache
+      //  are not written again.
+      int size_X = pBSBChart->GetSize_X();
+      int size_Y = pBSBChart->GetSize_Y();
+
+      int tex_dim = g_GLOptions.m_iTextureDimension;
+
+      int nx_tex = ceil((float)size_X / tex_dim);
+      int ny_tex = ceil((float)size_Y / tex_dim);
+
+      std::vector<std::pair<wxRect, int>> tiles;
+      wxRect rect;
+      rect.y = 0;
+      rect.width = tex_dim;
+      rect.height = tex_dim;
+      for (int y = 0; y < ny_tex; y++) {
+        rect.x = 0;
+        for (int x = 0; x < nx_tex; x++) {
+          for (int level = 0; level < g_mipmap_max_level + 1; level++) {
+            if (!tex_fact->IsLevelInCache(level, rect, global_color_scheme)) {
+              tiles.push_back(std::make_pair(rect, level));
+              break;
+            }
+          }
+          rect.x += rect.width;
+        }
+        rect.y += rect.height;
+      }
 
-    wxString filename = cte.GetFullSystemPath();
+      if (tiles.empty()) {
+        //  Nothing to do
+        //  Free all possible memory
+        ChartData->DeleteCacheChart(pchart);
+        delete tex_fact;
+        continue;
+      }
 
-    compress_target *pct = new compress_target;
-    pct->distance = distance;
-    pct->chart_path = filename;
+      CacheBuildChart *chart = new CacheBuildChart;
+      chart->path = filename;
+      chart->chart = pchart;
+      chart->factory = tex_fact;
+      chart->tiles_total = tiles.size();
+      active.emplace_back(chart);
+      status.tiles_total += tiles.size();
+
+      for (auto &tile : tiles) {
+        JobTicket *pt = new JobTicket;
+        pt->pFact = tex_fact;
+        pt->m_rect = tile.first;
+        pt->level_min_request = tile.second;
+        pt->ident = 0;
+        pt->b_throttle = false;
+        pt->pthread = NULL;
+        pt->m_ChartPath = filename;
+        pt->level0_bits = NULL;
+        pt->b_abort = false;
+        pt->b_isaborted = false;
+        pt->bpost_zip_compress = true;
+        pt->binplace = false;
+        pool.Add(pt, chart);
+      }
+    }
 
-    ct_array.Add(pct);
+    if (skip) pool.Clear();
+    while (!active.empty()) {
+      wxThread::Sleep(50);
+      update(false);
+      if (skip) pool.Clear();
+    }
   }
+  //  The pool has drained, report the final status
+  update(true);
+
+  b_inCompressAllCharts = false;
+  m_timer.Start(500);
+  return true;
+}
 
-  // create progress dialog
+#define NBAR_LENGTH 40
+
+void glTextureManager::CreateCacheProgressDialog(int count) {
   long style = wxPD_SMOOTH | wxPD_ELAPSED_TIME | wxPD_ESTIMATED_TIME |
                wxPD_REMAINING_TIME | wxPD_CAN_ABORT;
 
@@ -1475,111 +1576,105 @@ void glTextureManager::BuildCompressedCache() {
   m_progDialog->SetSize(sz);
 
   m_progDialog->Layout();
-  wxSize sza = m_progDialog->GetSize();
 
   m_progDialog->Centre();
   m_progDialog->Show();
   m_progDialog->Raise();
+}
 
-  m_skipout = false;
+void glTextureManager::BuildCompressedCache() {
   m_skip = false;
-  int yield = 0;
-
-  for (m_jcnt = 0; m_jcnt < ct_array.GetCount(); m_jcnt++) {
-    wxString filename = ct_array[m_jcnt].chart_path;
-    wxString CompressedCacheFilePath = CompressedCachePath(filename);
-    double distance = ct_array[m_jcnt].distance;
 
-    ChartBase *pchart = ChartData->OpenChartFromDBAndLock(filename, FULL_INIT);
-    if (!pchart) /* probably a corrupt chart */
-      continue;
+  CompressAllCharts([&](const CacheBuildStatus &status) {
+    if (!m_progDialog) CreateCacheProgressDialog(status.charts_total);
 
-    // bad things if more than one texfactory for a chart
-    g_glTextureManager->PurgeChartTextures(pchart, true);
-
-    ChartBaseBSB *pBSBChart = dynamic_cast<ChartBaseBSB *>(pchart);
-    if (pBSBChart == 0) continue;
-
-    glTexFactory *tex_fact = new glTexFactory(pchart, g_raster_format);
-
-    m_progMsg.Printf(_("Distance from Ownship:  %4.0f NMi"), distance);
-    m_progMsg += "\n";
-    m_progMsg.Prepend(_T("Preparing RNC Cache...\n"));
-
-    if (m_skipout) {
-      g_glTextureManager->PurgeJobList();
-      ChartData->DeleteCacheChart(pchart);
-      delete tex_fact;
-      break;
+    wxString msg;
+    if (m_skip) {
+      msg = _T("Skipping, please wait...\n\n");
+    } else {
+      msg = _T("Preparing RNC Cache...\n");
+      msg += wxString::Format(_("Distance from Ownship:  %4.0f NMi"),
+                              status.distance);
+      msg += "\n";
     }
 
-    int size_X = pBSBChart->GetSize_X();
-    int size_Y = pBSBChart->GetSize_Y();
-
-    int tex_dim = g_GLOptions.m_iTextureDimension;
-
-    int nx_tex = ceil((float)size_X / tex_dim);
-    int ny_tex = ceil((float)size_Y / tex_dim);
-
-    wxRect rect;
-    rect.y = 0;
-    rect.width = tex_dim;
-    rect.height = tex_dim;
-    for (int y = 0; y < ny_tex; y++) {
-      rect.x = 0;
-      for (int x = 0; x < nx_tex; x++) {
-        for (int level = 0; level < g_mipmap_max_level + 1; level++) {
-          if (!tex_fact->IsLevelInCache(level, rect, global_color_scheme)) {
-            goto schedule;
-          }
-        }
-        rect.x += rect.width;
+    //  One bar for each chart in progress
+    int bar_length = NBAR_LENGTH;
+    if (m_bcompact) bar_length = 20;
+    wxString block = wxString::Format(_T("%c"), 0x2588);
+    for (size_t i = 0; i < status.active.size() && (int)i < m_max_jobs; i++) {
+      const CacheBuildStatus::Chart &chart = status.active[i];
+      wxString msgx = _T("\n[");
+      float cutoff = chart.tiles_done * bar_length / (float)chart.tiles_total;
+      for (int j = 0; j < bar_length; j++) {
+        if (j < cutoff)
+          msgx += block;
+        else
+          msgx += _T("-");
       }
-      rect.y += rect.height;
-    }
-    //  Nothing to do
-    //  Free all possible memory
-    ChartData->DeleteCacheChart(pchart);
-    delete tex_fact;
-    yield++;
-    if (yield == 200) {
-      ::wxYield();
-      yield = 0;
-      if (!m_progDialog->Update(m_jcnt)) {
-        m_skip = true;
-        m_skipout = true;
+      msgx += _T("]");
+
+      if (!m_bcompact) {
+        msgx += wxString::Format(_T("  [%3d/%3d]  "), chart.tiles_done,
+                                 chart.tiles_total);
+        msgx += wxFileName(chart.path).GetFullName();
       }
-    }
-    continue;
-
-  // some work to do
-  schedule:
-
-    yield = 0;
-    ScheduleJob(tex_fact, wxRect(), 0, false, true, true, false);
-    while (!m_skip) {
-      ::wxYield();
-      int cnt = GetJobCount() - GetRunningJobCount();
-      if (!cnt) break;
-      wxThread::Sleep(1);
+      msg += msgx + _T("\n");
     }
 
-    if (m_skipout) {
-      g_glTextureManager->PurgeJobList();
-      ChartData->DeleteCacheChart(pchart);
-      delete tex_fact;
-      break;
-    }
-  }
+    if (!m_progDialog->Update(status.charts_done, msg, &m_skip)) m_skip = true;
+    return !m_skip;
+  });
+
+  delete m_progDialog;
+  m_progDialog = nullptr;
+}
 
-  while (GetRunningJobCount()) {
-    wxThread::Sleep(1);
-    ::wxYield();
+bool glTextureManager::BuildCompressedCacheBatch() {
+  if (!g_GLOptions.m_bTextureCompression ||
+      !g_GLOptions.m_bTextureCompressionCaching || g_raster_format == GL_RGB) {
+    wxLogWarning(_T("OpenGL texture compression and caching not available"));
+    return false;
   }
 
-  b_inCompressAllCharts = false;
-  m_timer.Start(500);
+  wxStopWatch sw;
+  long next_log = 0;
+  CacheBuildStatus last = {};
+  bool found = CompressAllCharts([&](const CacheBuildStatus &status) {
+    //  The last call has the final status
+    last = status;
+    if (sw.Time() >= next_log) {
+      wxLogMessage("Compressed cache: chart %d of %d, %ld of %ld tiles done",
+                   status.charts_done, status.charts_total, status.tiles_done,
+                   status.tiles_total);
+      next_log = sw.Time() + 10000;
+    }
+    return true;
+  });
+  if (!found)
+    wxLogMessage(_T("Compressed cache: no raster charts"));
+  else
+    wxLogMessage("Compressed cache: %d of %d charts checked, %ld of %ld tiles "
+                 "compressed in %ld s",
+                 last.charts_done, last.charts_total, last.tiles_compressed,
+                 last.tiles_total, sw.Time() / 1000);
+  return true;
+}
 
-  delete m_progDialog;
-  m_progDialog = nullptr;
+bool glTextureManager::SetupBatchCompression(const std::string &format) {
+  if (format == "dxt1")
+    g_raster_format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+  else if (format == "etc1")
+    g_raster_format = GL_ETC1_RGB8_OES;
+  else
+    return false;
+
+  //  Both take 4 bits a pixel, and all levels are uploaded
+  int dim = g_GLOptions.m_iTextureDimension;
+  g_uncompressed_tile_size = dim * dim * 4;
+  g_tile_size = dim * dim / 2;
+  int max_level = 0;
+  for (int d = dim; d > 0; d /= 2) max_level++;
+  g_mipmap_max_level = max_level - 1;
+  return true;
 }
@@ -294,6 +294,7 @@ extern wxString g_default_wp_icon;
 extern ChartGroupArray *g_pGroupArray;
 
 extern bool g_bDebugOGL;
+extern bool g_bShowRenderStats;
 extern int g_tcwin_scale;
 extern wxString g_uploadConnection;
 
@@ -893,6 +894,7 @@ int MyConfig::LoadMyConfigRaw(bool bAsTemplate) {
     Read(_T ( "GPUTextureDimension" ), &g_GLOptions.m_iTextureDimension);
     Read(_T ( "GPUTextureMemSize" ), &g_GLOptions.m_iTextureMemorySize);
     Read(_T ( "DebugOpenGL" ), &g_bDebugOGL);
+    Read(_T ( "ShowRenderStats" ), &g_bShowRenderStats);
     Read(_T ( "OpenGL" ), &g_bopengl);
     Read(_T ( "SoftwareGL" ), &g_bSoftwareGL);
   }
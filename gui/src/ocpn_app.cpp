@@ -102,6 +102,7 @@ using namespace std::literals::chrono_literals;
 #include "model/certificates.h"
 #include "model/cmdline.h"
 #include "model/comm_bridge.h"
+#include "model/comm_drv_capture.h"
 #include "model/comm_n0183_output.h"
 #include "model/comm_vars.h"
 #include "model/config_vars.h"
@@ -114,11 +115,13 @@ using namespace std::literals::chrono_literals;
 #include "model/nav_object_database.h"
 #include "model/navutil_base.h"
 #include "model/own_ship.h"
+#include "model/perf_trace.h"
 #include "model/plugin_handler.h"
 #include "model/route.h"
 #include "model/routeman.h"
 #include "model/select.h"
 #include "model/track.h"
+#include "model/xyz_tiles.h"
 
 #include "AboutFrameImpl.h"
 #include "about.h"
@@ -197,7 +200,7 @@ void RedirectIOToConsole();
 const char* const kUsage =
 R"""(Usage:
   opencpn -h | --help
-  opencpn [-p] [-f] [-G] [-g] [-P] [-l <str>] [-u <num>] [-U] [-s] [GPX file ...]
+  opencpn [-p] [-f] [-G] [-g] [-P] [-l <str>] [-u <num>] [-U] [-s] [-C <path>] [-T <path>] [GPX file ...]
   opencpn --remote [-R] | -q] | -e] |-o <str>]
 
 Options for starting opencpn
@@ -208,6 +211,14 @@ Options for starting opencpn
   -G, --no_opengl              	Disable OpenGL video acceleration. This setting will
                                 be remembered.
   -g, --rebuild_gl_raster_cache	Rebuild OpenGL raster cache on start.
+      --build_gl_raster_cache   Build OpenGL raster cache without user
+                                interaction and exit. An interrupted build
+                                continues where it stopped. No chart window
+                                or OpenGL context is created.
+      --gl_raster_format=<fmt>  Texture format of --build_gl_raster_cache,
+                                dxt1 (default, desktop) or etc1 (GLES). The
+                                cache is used only by a display that picks
+                                the same format.
   -D, --rebuild_chart_db        Rescan chart directories and rebuild the chart database
   -P, --parse_all_enc          	Convert all S-57 charts to OpenCPN's internal format on start.
   -l, --loglevel=<str>         	Amount of logging: error, warning, message, info, debug or trace
@@ -216,6 +227,17 @@ Options for starting opencpn
   -U, --unit_test_2
   -s, --safe_mode              	Run without plugins, opengl and other "dangerous" stuff
   -W, --config_wizard          	Start with initial configuration wizard
+  -C, --capture=<path>          Record all received messages to a binary log
+                                which can be replayed using opencpn-cmd.
+  -T, --trace=<path>            Record timing of startup phases, rendering
+                                and decoding, write it as a Chrome trace file
+                                on exit.
+      --render_tiles=<spec>     Start the chart window, render XYZ chart tiles
+                                through it one at a time and exit. Needs a
+                                display, e.g. xvfb-run on servers.
+                                <spec> is <lat_min>,<lon_min>,<lat_max>,<lon_max>
+                                :<zmin>-<zmax>:<output>, where <output> is a
+                                .mbtiles file or a directory for z/x/y.png.
 
 Options manipulating already started opencpn
   -r, --remote                 	Execute commands on already running instance
@@ -709,6 +731,32 @@ static bool LoadAllPlugIns(bool load_enabled) {
   return b;
 }
 
+#ifdef ocpnUSE_GL
+/**
+ * Build the raster texture cache for --build_gl_raster_cache. Takes the
+ * texture format from --gl_raster_format rather than the OpenGL driver, so
+ * neither the frame nor a GL context is needed.
+ */
+static void BuildRasterCacheBatch() {
+  glTextureManager::SetupBatchCompression(g_gl_raster_format);
+
+  ArrayOfCDI ChartDirArray;
+  pConfig->LoadChartDirArray(ChartDirArray);
+  ChartData = new ChartDB();
+  if (ChartData->LoadBinary(ChartListFileName, ChartDirArray)) {
+    g_glTextureManager = new glTextureManager;
+    g_glTextureManager->BuildCompressedCacheBatch();
+    delete g_glTextureManager;
+    g_glTextureManager = nullptr;
+  } else {
+    wxLogWarning("Raster cache build: no chart database, start OpenCPN once "
+                 "to build it");
+  }
+  delete ChartData;
+  ChartData = nullptr;
+}
+#endif
+
 //------------------------------------------------------------------------------
 //    PNG Icon resources
 //------------------------------------------------------------------------------
@@ -826,11 +874,20 @@ void MyApp::OnInitCmdLine(wxCmdLineParser &parser) {
   parser.AddSwitch("G", "no_opengl");
   parser.AddSwitch("W", "config_wizard");
   parser.AddSwitch("g", "rebuild_gl_raster_cache");
+  parser.AddSwitch("", "build_gl_raster_cache");
+  parser.AddOption("", "gl_raster_format", "", wxCMD_LINE_VAL_STRING,
+                   wxCMD_LINE_PARAM_OPTIONAL);
   parser.AddSwitch("D", "rebuild_chart_db");
   parser.AddSwitch("P", "parse_all_enc");
   parser.AddOption("l", "loglevel");
   parser.AddOption("u", "unit_test_1", "", wxCMD_LINE_VAL_NUMBER);
   parser.AddSwitch("U", "unit_test_2");
+  parser.AddOption("C", "capture", "", wxCMD_LINE_VAL_STRING,
+                   wxCMD_LINE_PARAM_OPTIONAL);
+  parser.AddOption("T", "trace", "", wxCMD_LINE_VAL_STRING,
+                   wxCMD_LINE_PARAM_OPTIONAL);
+  parser.AddOption("", "render_tiles", "", wxCMD_LINE_VAL_STRING,
+                   wxCMD_LINE_PARAM_OPTIONAL);
   parser.AddParam("import GPX files", wxCMD_LINE_VAL_STRING,
                   wxCMD_LINE_PARAM_OPTIONAL | wxCMD_LINE_PARAM_MULTIPLE);
   parser.AddSwitch("s", "safe_mode");
@@ -883,6 +940,7 @@ bool MyApp::OnCmdLineParsed(wxCmdLineParser &parser) {
   g_start_fullscreen = parser.Found("fullscreen");
   g_bdisable_opengl = parser.Found("no_opengl");
   g_rebuild_gl_cache = parser.Found("rebuild_gl_raster_cache");
+  g_build_gl_cache = parser.Found("build_gl_raster_cache");
   g_NeedDBUpdate = parser.Found("rebuild_chart_db") ? 2 : 0;
   g_parse_all_enc = parser.Found("parse_all_enc");
   g_config_wizard = parser.Found("config_wizard");
@@ -901,11 +959,32 @@ bool MyApp::OnCmdLineParsed(wxCmdLineParser &parser) {
       return false;
     }
   }
+  if (parser.Found("capture", &wxstr)) g_capture_file = wxstr.ToStdString();
+  if (parser.Found("trace", &wxstr)) g_trace_file = wxstr.ToStdString();
+  if (parser.Found("gl_raster_format", &wxstr)) {
+    g_gl_raster_format = wxstr.Lower().ToStdString();
+    if (g_gl_raster_format != "dxt1" && g_gl_raster_format != "etc1") {
+      std::cerr << "--gl_raster_format: use dxt1 or etc1\n";
+      return false;
+    }
+  }
+  if (parser.Found("render_tiles", &wxstr)) {
+    TileRenderSpec spec;
+    std::string error = spec.Parse(wxstr.ToStdString());
+    if (!error.empty()) {
+      std::cerr << "--render_tiles: " << error << "\n";
+      return false;
+    }
+    g_render_tiles = wxstr.ToStdString();
+    g_bdisable_opengl = true;  // Tiles are rendered using the DC path
+  }
 
   bool has_start_options = false;
   static const std::vector<std::string> kStartOptions = {
     "unit_test_2", "p", "fullscreen", "no_opengl", "rebuild_gl_raster_cache",
-    "rebuild_chart_db", "parse_all_enc", "unit_test_1", "safe_mode", "loglevel" };
+    "rebuild_chart_db", "parse_all_enc", "unit_test_1", "safe_mode", "loglevel",
+    "capture", "trace", "render_tiles", "build_gl_raster_cache",
+    "gl_raster_format" };
   for (const auto& opt : kStartOptions) {
     if (parser.Found(opt)) has_start_options = true;
   }
@@ -993,6 +1072,9 @@ MyApp::MyApp()
 
 bool MyApp::OnInit() {
   if (!wxApp::OnInit()) return false;
+  //  Startup phases are always timed and logged, see MyFrame::OnInitTimer()
+  PerfTrace::GetInstance().SetEnabled(true);
+  PerfScope perf_init("MyApp::OnInit", PerfTrace::kStartup);
 #ifdef __ANDROID__
   androidEnableBackButton(false);
   androidEnableOptionItems(false);
@@ -1273,9 +1355,11 @@ bool MyApp::OnInit() {
   }
 
   //      Open/Create the Config Object
+  PerfScope perf_config("Load config", PerfTrace::kStartup);
   pConfig = g_Platform->GetConfigObject();
   InitBaseConfig(pConfig);
   pConfig->LoadMyConfig();
+  perf_config.End();
 
   //  Override for some safe and nice default values if the config file was
   //  created from scratch
@@ -1495,6 +1579,17 @@ bool MyApp::OnInit() {
 
   g_Platform->Initialize_2();
 
+  //  Built without the frame, and exit once the event loop is running
+  if (g_build_gl_cache) {
+#ifdef ocpnUSE_GL
+    BuildRasterCacheBatch();
+#else
+    wxLogWarning("Raster cache build requires OpenGL");
+#endif
+    CallAfter([] { wxTheApp->ExitMainLoop(); });
+    return true;
+  }
+
   //  Set up the frame initial visual parameters
   //      Default size, resized later
   wxSize new_frame_size(-1, -1);
@@ -1602,8 +1697,10 @@ bool MyApp::OnInit() {
               new_frame_size.x, new_frame_size.y, position.x, position.y);
   wxLogMessage(fmsg);
 
+  PerfScope perf_frame("Create MyFrame", PerfTrace::kStartup);
   gFrame = new MyFrame(NULL, myframe_window_title, position, new_frame_size,
                        app_style);  // Gunther
+  perf_frame.End();
 
   //  Do those platform specific initialization things that need gFrame
   g_Platform->Initialize_3();
@@ -1622,7 +1719,9 @@ bool MyApp::OnInit() {
   // tell wxAuiManager to manage the frame
   g_pauimgr->SetManagedWindow(gFrame);
 
+  PerfScope perf_layout("Create canvas layout", PerfTrace::kStartup);
   gFrame->CreateCanvasLayout();
+  perf_layout.End();
 
   // gFrame->RequestNewMasterToolbar( true );
 
@@ -1707,6 +1806,7 @@ bool MyApp::OnInit() {
     if (::wxFileExists(ChartListFileName)) ::wxRemoveFile(ChartListFileName);
 
   //      Try to load the current chart list Data file
+  PerfScope perf_chartdb("Load chart database", PerfTrace::kStartup);
   ChartData = new ChartDB();
   if (g_NeedDBUpdate == 0 && !ChartData->LoadBinary(ChartListFileName, ChartDirArray)) {
     g_NeedDBUpdate = 1;
@@ -1723,6 +1823,7 @@ bool MyApp::OnInit() {
 
   //  Apply the inital Group Array structure to the chart database
   ChartData->ApplyGroupArray(g_pGroupArray);
+  perf_chartdb.End();
 
   //      All set to go.....
 
@@ -1741,6 +1842,7 @@ bool MyApp::OnInit() {
     //        if( g_MainToolbar )
     //            g_MainToolbar->Hide();
 
+    PerfScope perf_cache("Build texture cache", PerfTrace::kStartup);
     if (g_glTextureManager) g_glTextureManager->BuildCompressedCache();
   }
 #endif
@@ -1774,12 +1876,14 @@ bool MyApp::OnInit() {
 
   Yield();
 
+  PerfScope perf_charts("Initial chart update", PerfTrace::kStartup);
   gFrame->DoChartUpdate();
 
   FontMgr::Get()
       .ScrubList();  // Clean the font list, removing nonsensical entries
 
   gFrame->ReloadAllVP();  // once more, and good to go
+  perf_charts.End();
 
   gFrame->Refresh(false);
   gFrame->Raise();
@@ -1917,7 +2021,14 @@ bool MyApp::OnInit() {
   CheckDongleAccess(gFrame);
 
   // Initialize the CommBridge
+  PerfScope perf_comm("Initialize CommBridge", PerfTrace::kStartup);
   m_comm_bridge.Initialize();
+  perf_comm.End();
+
+  if (!g_capture_file.empty()) {
+    auto capture = std::make_shared<CaptureCommDriver>(g_capture_file);
+    if (capture->IsOk()) capture->Activate();
+  }
 
   std::vector<std::string> ipv4_addrs = get_local_ipv4_addresses();
 
@@ -1929,6 +2040,7 @@ bool MyApp::OnInit() {
     if (data_dir.Last() != wxFileName::GetPathSeparator())
       data_dir.Append(wxFileName::GetPathSeparator());
 
+    PerfScope perf_rest("Start REST server", PerfTrace::kStartup);
     make_certificate(ipAddr, data_dir.ToStdString());
 
     m_rest_server.StartServer(fs::path(data_dir.ToStdString()));
@@ -1941,6 +2053,8 @@ bool MyApp::OnInit() {
 int MyApp::OnExit() {
 
   wxLogMessage(_T("opencpn::MyApp starting exit."));
+  if (!g_trace_file.empty())
+    PerfTrace::GetInstance().WriteChromeTrace(g_trace_file);
   m_checker.OnExit();
   m_usb_watcher.Stop();
   //  Send current nav status data to log file   // pjotrc 2010.02.09
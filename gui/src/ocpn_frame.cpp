@@ -76,6 +76,7 @@
 #include "model/nav_object_database.h"
 #include "model/navutil_base.h"
 #include "model/own_ship.h"
+#include "model/perf_trace.h"
 #include "model/plugin_loader.h"
 #include "model/routeman.h"
 #include "model/select.h"
@@ -129,6 +130,7 @@
 #include "S57QueryDialog.h"
 #include "SystemCmdSound.h"
 #include "tcmgr.h"
+#include "tile_render.h"
 #include "timers.h"
 #include "toolbar.h"
 #include "TrackPropDlg.h"
@@ -708,8 +710,8 @@ MyFrame::MyFrame(wxFrame *frame, const wxString &title, const wxPoint &pos,
   //    Establish my children
   struct MuxLogCallbacks log_callbacks;
   log_callbacks.log_is_active = []() { return NMEALogWindow::GetInstance().Active(); };
-  log_callbacks.log_message = [](const std::string& s) {
-    NMEALogWindow::GetInstance().Add(s); };
+  log_callbacks.log_message = [](NmeaLogEntry&& entry) {
+    NMEALogWindow::GetInstance().Add(std::move(entry)); };
   g_pMUX = new Multiplexer(log_callbacks, g_b_legacy_input_filter_behaviour);
 
   struct AisDecoderCallbacks  ais_callbacks;
@@ -4651,6 +4653,7 @@ void MyFrame::PositionIENCToolbar() {
 // running much faster.
 void MyFrame::OnInitTimer(wxTimerEvent &event) {
   InitTimer.Stop();
+  PerfScope perf_step("MyFrame::OnInitTimer", PerfTrace::kStartup);
   wxString msg;
   msg.Printf(_T("OnInitTimer...%d"), m_iInitCount);
   wxLogMessage(msg);
@@ -4688,6 +4691,7 @@ void MyFrame::OnInitTimer(wxTimerEvent &event) {
 
       // Rebuild chart database, if necessary
       if (g_NeedDBUpdate > 0) {
+        PerfScope perf_rebuild("Rebuild chart database", PerfTrace::kStartup);
         RebuildChartDatabase();
         for (unsigned int i = 0; i < g_canvasArray.GetCount(); i++) {
           ChartCanvas *cc = g_canvasArray.Item(i);
@@ -4731,7 +4735,9 @@ void MyFrame::OnInitTimer(wxTimerEvent &event) {
         }
       }
 
+      PerfScope perf_navobj("Load nav objects", PerfTrace::kStartup);
       pConfig->LoadNavObjects();
+      perf_navobj.End();
       //    Re-enable anchor watches if set in config file
       if (!g_AW1GUID.IsEmpty()) {
         pAnchorWatchPoint1 = pWayPointMan->FindRoutePointByGUID(g_AW1GUID);
@@ -4750,13 +4756,15 @@ void MyFrame::OnInitTimer(wxTimerEvent &event) {
         laymsg.Printf(wxT("Getting .gpx layer files from: %s"),
                       layerdir.c_str());
         wxLogMessage(laymsg);
+        PerfScope perf_layers("Load layers", PerfTrace::kStartup);
         pConfig->LoadLayers(layerdir);
       }
 
       break;
     }
-    case 1:
+    case 1: {
       // Connect Datastreams
+      PerfScope perf_conn("Start connections", PerfTrace::kStartup);
 
       for (size_t i = 0; i < TheConnectionParams()->Count(); i++) {
         ConnectionParams *cp = TheConnectionParams()->Item(i);
@@ -4769,12 +4777,15 @@ void MyFrame::OnInitTimer(wxTimerEvent &event) {
       console = new ConsoleCanvas(gFrame);  // the console
       console->SetColorScheme(global_color_scheme);
       break;
+    }
 
     case 2: {
       if (m_initializing) break;
       m_initializing = true;
       AbstractPlatform::ShowBusySpinner();
+      PerfScope perf_plugins("Load plugins", PerfTrace::kStartup);
       PluginLoader::getInstance()->LoadAllPlugIns(true);
+      perf_plugins.End();
       AbstractPlatform::HideBusySpinner();
       //            RequestNewToolbars();
       RequestNewMasterToolbar();
@@ -4849,7 +4860,9 @@ void MyFrame::OnInitTimer(wxTimerEvent &event) {
       //  Give the user dialog on any blacklisted PlugIns
       g_pi_manager ->ShowDeferredBlacklistMessages();
 
+      PerfScope perf_late("Plugin LateInit", PerfTrace::kStartup);
       g_pi_manager->CallLateInit();
+      perf_late.End();
 
       //  If any PlugIn implements PlugIn Charts, we need to re-run the initial
       //  chart load logic to select the correct chart as saved from the last
@@ -4895,6 +4908,7 @@ void MyFrame::OnInitTimer(wxTimerEvent &event) {
       pConfig->Read("OptionsSizeX", &sx, -1);
       pConfig->Read("OptionsSizeY", &sy, -1);
 
+    PerfScope perf_options("Create options dialog", PerfTrace::kStartup);
     wxWindow *optionsParent = this;
 #ifdef __WXOSX__
     optionsParent = GetPrimaryCanvas();
@@ -4990,6 +5004,22 @@ void MyFrame::OnInitTimer(wxTimerEvent &event) {
 
   RefreshAllCanvas(true);
   wxGetApp().m_usb_watcher.Start();
+
+  if (g_bDeferredInitDone) {
+    perf_step.End();
+    auto &perf_trace = PerfTrace::GetInstance();
+    perf_trace.LogSummary("Startup", PerfTrace::kStartup);
+    if (g_trace_file.empty()) {
+      perf_trace.SetEnabled(false);
+      perf_trace.Clear();
+    }
+    if (!g_render_tiles.empty()) {
+      CallAfter([this] {
+        RenderTiles(GetPrimaryCanvas(), g_render_tiles);
+        Close();
+      });
+    }
+  }
 }
 
 wxDEFINE_EVENT(EVT_BASIC_NAV_DATA, ObservedEvt);
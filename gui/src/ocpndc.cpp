@@ -50,6 +50,7 @@
 #include <wx/graphics.h>
 #include <wx/dcclient.h>
 
+#include <list>
 #include <vector>
 
 #include "ocpndc.h"
@@ -107,6 +107,7 @@ typedef __LA_INT64_T la_int64_t;  //  "older" libarchive versions support
 #include "model/plugin_handler.h"
 #include "model/plugin_loader.h"
 #include "model/plugin_paths.h"
+#include "model/render_stats.h"
 #include "model/route.h"
 #include "model/routeman.h"
 #include "model/safe_mode.h"
@@ -1545,6 +1546,13 @@ bool PlugInManager::RenderAllGLCanvasOverlayPlugIns(wxGLContext* pcontext,
     PlugInContainer* pic = plugin_array->Item(i);
     if (pic->m_enabled && pic->m_init_state) {
       if (pic->m_cap_flag & WANTS_OPENGL_OVERLAY_CALLBACK) {
+        //  Pre-118 plugins are only called for the legacy priority, don't
+        //  time calls which do nothing.
+        if (priority > 0 && pic->m_api_version < 118) continue;
+        std::string pass = "Plugin " + pic->m_common_name.ToStdString();
+        if (priority > 0) pass += " @" + std::to_string(priority);
+        RenderPassTimer timer(pass);
+
         PlugIn_ViewPort pivp = CreatePlugInViewport(vp);
 
         switch (pic->m_api_version) {
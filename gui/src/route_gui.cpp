@@ -418,17 +418,20 @@ void RouteGui::DrawGLRouteLines(ViewPort &vp, ChartCanvas *canvas, ocpnDC &dc) {
   /* direction arrows.. could probably be further optimized for opengl */
   dc.SetPen(*wxThePenList->FindOrCreatePen(col, 1, wxPENSTYLE_SOLID));
 
+  std::vector<double> lat, lon;
+  GetPointLatLons(lat, lon);
+  std::vector<wxPoint> rpt(lat.size());
+  if (rpt.size())
+    canvas->GetCanvasPointPix(&lat[0], &lon[0], rpt.size(), &rpt[0]);
+
   wxRoutePointListNode *node = m_route.pRoutePointList->GetFirst();
-  wxPoint rpt1, rpt2;
-  while (node) {
+  for (size_t i = 0; node; i++, node = node->GetNext()) {
     RoutePoint *prp = node->GetData();
-    canvas->GetCanvasPointPix(prp->m_lat, prp->m_lon, &rpt2);
-    if (node != m_route.pRoutePointList->GetFirst()) {
+    if (i > 0) {
       if (!prp->m_bIsActive || !g_bAllowShipToActive)
-        RenderSegmentArrowsGL(dc, rpt1.x, rpt1.y, rpt2.x, rpt2.y, vp);
+        RenderSegmentArrowsGL(dc, rpt[i - 1].x, rpt[i - 1].y, rpt[i].x,
+                              rpt[i].y, vp);
     }
-    rpt1 = rpt2;
-    node = node->GetNext();
   }
 #endif
 }
@@ -442,13 +445,20 @@ void RouteGui::DrawGLLines(ViewPort &vp, ocpnDC *dc, ChartCanvas *canvas) {
   wxPoint2DDouble r1;
   wxPoint2DDouble lastpoint;
 
+  //  Project all the route points at once
+  std::vector<double> lat, lon;
+  GetPointLatLons(lat, lon);
+  std::vector<wxPoint2DDouble> pix(lat.size());
+  if (pix.empty()) return;
+  canvas->GetDoubleCanvasPointPix(&lat[0], &lon[0], pix.size(), &pix[0]);
+
   wxRoutePointListNode *node = m_route.pRoutePointList->GetFirst();
   RoutePoint *prp2 = node->GetData();
-  canvas->GetDoubleCanvasPointPix(prp2->m_lat, prp2->m_lon, &lastpoint);
+  lastpoint = pix[0];
 
   // single point.. make sure it shows up for highlighting
   if (m_route.GetnPoints() == 1 && dc) {
-    canvas->GetDoubleCanvasPointPix(prp2->m_lat, prp2->m_lon, &r1);
+    r1 = pix[0];
     dc->DrawLine(r1.m_x, r1.m_y, r1.m_x + 2, r1.m_y + 2);
     return;
   }
@@ -458,15 +468,16 @@ void RouteGui::DrawGLLines(ViewPort &vp, ocpnDC *dc, ChartCanvas *canvas) {
 
   // dc is passed for thicker highlighted lines (performance not very important)
 
+  size_t i2 = 0;
   for (node = node->GetNext(); node; node = node->GetNext()) {
     RoutePoint *prp1 = prp2;
     prp2 = node->GetData();
+    i2++;
 
     // Provisional, to properly set status of last point in route
     prp2->m_pos_on_screen = false;
     {
-      wxPoint2DDouble r2;
-      canvas->GetDoubleCanvasPointPix(prp2->m_lat, prp2->m_lon, &r2);
+      wxPoint2DDouble r2 = pix[i2];
       if (std::isnan(r2.m_x)) {
         r1valid = false;
         continue;
@@ -503,7 +514,7 @@ void RouteGui::DrawGLLines(ViewPort &vp, ocpnDC *dc, ChartCanvas *canvas) {
 
 
       if (!r1valid) {
-        canvas->GetDoubleCanvasPointPix(prp1->m_lat, prp1->m_lon, &r1);
+        r1 = pix[i2 - 1];
         if (std::isnan(r1.m_x)) continue;
       }
 
@@ -552,6 +563,19 @@ void RouteGui::DrawGLLines(ViewPort &vp, ocpnDC *dc, ChartCanvas *canvas) {
 #endif
 }
 
+void RouteGui::GetPointLatLons(std::vector<double> &lat,
+                               std::vector<double> &lon) {
+  lat.clear();
+  lon.clear();
+  lat.reserve(m_route.pRoutePointList->GetCount());
+  lon.reserve(m_route.pRoutePointList->GetCount());
+  for (wxRoutePointListNode *node = m_route.pRoutePointList->GetFirst(); node;
+       node = node->GetNext()) {
+    lat.push_back(node->GetData()->m_lat);
+    lon.push_back(node->GetData()->m_lon);
+  }
+}
+
 void RouteGui::CalculateDCRect(wxDC &dc_route, ChartCanvas *canvas,
                                wxRect *prect) {
   dc_route.ResetBoundingBox();
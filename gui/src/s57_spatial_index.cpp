@@ -0,0 +1,239 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Spatial index over the rendering rules of an S57 chart
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "s57_spatial_index.h"
+
+// Lists shorter than this are not worth a grid, they are kept in one cell
+static const size_t kMinGridObjects = 64;
+static const size_t kObjectsPerCell = 4;
+static const int kMaxGridSide = 256;
+
+// Stored for objects which must be returned by every query
+static const double kEverywhere = 1e9;
+
+static bool IsGoodBox(const LLBBox &bb) {
+  return std::isfinite(bb.GetMinLat()) && std::isfinite(bb.GetMaxLat()) &&
+         std::isfinite(bb.GetMinLon()) && std::isfinite(bb.GetMaxLon()) &&
+         bb.GetMinLat() <= bb.GetMaxLat() && bb.GetMinLon() <= bb.GetMaxLon();
+}
+
+void S57SpatialIndex::Clear() {
+  for (int i = 0; i < PRIO_NUM; ++i)
+    for (int j = 0; j < LUPNAME_NUM; j++) m_slots[i][j] = Slot();
+}
+
+void S57SpatialIndex::Invalidate(int prio, int type) {
+  m_slots[prio][type].built = false;
+}
+
+void S57SpatialIndex::Build(Slot &slot, ObjRazRules *head) {
+  slot = Slot();
+  slot.built = true;
+  slot.head = head;
+
+  for (ObjRazRules *top = head; top; top = top->next)
+    slot.rules.push_back(top);
+
+  size_t n = slot.rules.size();
+  slot.boxes.resize(n);
+  slot.in_large.assign(n, 0);
+  slot.stamp.assign(n, 0);
+
+  //  Grid extent is the union of the object boxes.
+  //  Objects with children (multipoint soundings) are returned by every
+  //  query, the boxes of the children are not covered by the parent box
+  //  once expanded by the rendered text.
+  bool have_extent = false;
+  for (size_t i = 0; i < n; i++) {
+    const LLBBox &bb = slot.rules[i]->obj->BBObj;
+    Box &b = slot.boxes[i];
+    if (slot.rules[i]->child || !IsGoodBox(bb)) {
+      b.minlat = b.minlon = -kEverywhere;
+      b.maxlat = b.maxlon = kEverywhere;
+      continue;
+    }
+    b.minlat = bb.GetMinLat();
+    b.minlon = bb.GetMinLon();
+    b.maxlat = bb.GetMaxLat();
+    b.maxlon = bb.GetMaxLon();
+
+    if (!have_extent) {
+      slot.lat0 = b.minlat, slot.lon0 = b.minlon;
+      slot.lat1 = b.maxlat, slot.lon1 = b.maxlon;
+      have_extent = true;
+    } else {
+      slot.lat0 = std::min(slot.lat0, b.minlat);
+      slot.lon0 = std::min(slot.lon0, b.minlon);
+      slot.lat1 = std::max(slot.lat1, b.maxlat);
+      slot.lon1 = std::max(slot.lon1, b.maxlon);
+    }
+  }
+
+  if (have_extent) {
+    double w = std::max(slot.lon1 - slot.lon0, 1e-9);
+    double h = std::max(slot.lat1 - slot.lat0, 1e-9);
+    int ncells = 1;
+    if (n >= kMinGridObjects)
+      ncells = (int)std::min<size_t>(n / kObjectsPerCell,
+                                     kMaxGridSide * kMaxGridSide);
+    slot.nx = (int)std::lround(std::sqrt(ncells * w / h));
+    slot.nx = std::max(1, std::min(slot.nx, kMaxGridSide));
+    slot.ny = std::max(1, std::min(ncells / slot.nx, kMaxGridSide));
+    slot.inv_cell_lon = slot.nx / w;
+    slot.inv_cell_lat = slot.ny / h;
+    slot.cells.resize(slot.nx * slot.ny);
+  }
+
+  Box none = {0, 0, 0, 0};
+  for (uint32_t i = 0; i < n; i++) Insert(slot, i, none, false);
+}
+
+void S57SpatialIndex::CellRange(const Slot &slot, const Box &box, int &ix0,
+                                int &iy0, int &ix1, int &iy1) const {
+  ix0 = (int)std::floor((box.minlon - slot.lon0) * slot.inv_cell_lon);
+  ix1 = (int)std::floor((box.maxlon - slot.lon0) * slot.inv_cell_lon);
+  iy0 = (int)std::floor((box.minlat - slot.lat0) * slot.inv_cell_lat);
+  iy1 = (int)std::floor((box.maxlat - slot.lat0) * slot.inv_cell_lat);
+  ix0 = std::max(0, std::min(ix0, slot.nx - 1));
+  ix1 = std::max(0, std::min(ix1, slot.nx - 1));
+  iy0 = std::max(0, std::min(iy0, slot.ny - 1));
+  iy1 = std::max(0, std::min(iy1, slot.ny - 1));
+}
+
+void S57SpatialIndex::Insert(Slot &slot, uint32_t index, const Box &old_box,
+                             bool have_old_box) {
+  if (slot.in_large[index]) return;
+
+  const Box &b = slot.boxes[index];
+  bool large = slot.cells.empty() || b.minlat < slot.lat0 ||
+               b.maxlat > slot.lat1 || b.minlon < slot.lon0 ||
+               b.maxlon > slot.lon1;
+
+  int ix0, iy0, ix1, iy1;
+  if (!large) {
+    CellRange(slot, b, ix0, iy0, ix1, iy1);
+    int span = (ix1 - ix0 + 1) * (iy1 - iy0 + 1);
+    large = slot.cells.size() > 1 &&
+            span > std::max(4, (int)slot.cells.size() / 8);
+  }
+  if (large) {
+    slot.in_large[index] = 1;
+    slot.large.push_back(index);
+    return;
+  }
+
+  int ox0 = 1, oy0 = 1, ox1 = 0, oy1 = 0;  // empty
+  if (have_old_box) CellRange(slot, old_box, ox0, oy0, ox1, oy1);
+
+  for (int iy = iy0; iy <= iy1; iy++) {
+    for (int ix = ix0; ix <= ix1; ix++) {
+      if (ix >= ox0 && ix <= ox1 && iy >= oy0 && iy <= oy1) continue;
+      slot.cells[iy * slot.nx + ix].push_back(index);
+    }
+  }
+}
+
+void S57SpatialIndex::Collect(Slot &slot, const Box &box,
+                              std::vector<S57IndexHit> &hits) {
+  uint32_t query_id = slot.query_id;
+  auto test = [&](uint32_t k) {
+    if (slot.stamp[k] == query_id) return;
+    const Box &b = slot.boxes[k];
+    if (b.maxlat < box.minlat || b.minlat > box.maxlat ||
+        b.maxlon < box.minlon || b.minlon > box.maxlon)
+      return;
+    slot.stamp[k] = query_id;
+    S57IndexHit hit = {slot.rules[k], k};
+    hits.push_back(hit);
+  };
+
+  for (uint32_t k : slot.large) test(k);
+
+  if (slot.cells.empty() || box.maxlat < slot.lat0 || box.minlat > slot.lat1 ||
+      box.maxlon < slot.lon0 || box.minlon > slot.lon1)
+    return;
+
+  int ix0, iy0, ix1, iy1;
+  CellRange(slot, box, ix0, iy0, ix1, iy1);
+  for (int iy = iy0; iy <= iy1; iy++)
+    for (int ix = ix0; ix <= ix1; ix++)
+      for (uint32_t k : slot.cells[iy * slot.nx + ix]) test(k);
+}
+
+void S57SpatialIndex::Query(ObjRazRules *head, int prio, int type,
+                            const LLBBox &box, std::vector<S57IndexHit> &hits) {
+  Slot &slot = m_slots[prio][type];
+  if (!slot.built || slot.head != head) Build(slot, head);
+
+  hits.clear();
+  if (slot.rules.empty()) return;
+
+  if (++slot.query_id == 0) {
+    std::fill(slot.stamp.begin(), slot.stamp.end(), 0);
+    slot.query_id = 1;
+  }
+
+  //  Same longitude wrap as s52plib::ObjectRenderCheckPos()
+  static const double shifts[] = {0., 360., -360.};
+  for (double shift : shifts) {
+    Box q = {box.GetMinLat(), box.GetMinLon() + shift, box.GetMaxLat(),
+             box.GetMaxLon() + shift};
+    Collect(slot, q, hits);
+  }
+
+  std::sort(hits.begin(), hits.end(),
+            [](const S57IndexHit &a, const S57IndexHit &b) {
+              return a.index < b.index;
+            });
+}
+
+void S57SpatialIndex::Update(int prio, int type,
+                             const std::vector<S57IndexHit> &hits) {
+  Slot &slot = m_slots[prio][type];
+  if (!slot.built) return;
+
+  for (const S57IndexHit &hit : hits) {
+    uint32_t k = hit.index;
+    if (k >= slot.rules.size() || slot.rules[k] != hit.rules) continue;
+
+    const LLBBox &bb = hit.rules->obj->BBObj;
+    Box &b = slot.boxes[k];
+    if (!(bb.GetMinLat() < b.minlat || bb.GetMaxLat() > b.maxlat ||
+          bb.GetMinLon() < b.minlon || bb.GetMaxLon() > b.maxlon))
+      continue;
+
+    //  Boxes are only grown, an object which shrinks back is still returned
+    //  by queries of its former extent and rejected by the render checks.
+    Box old_box = b;
+    b.minlat = std::min(b.minlat, bb.GetMinLat());
+    b.minlon = std::min(b.minlon, bb.GetMinLon());
+    b.maxlat = std::max(b.maxlat, bb.GetMaxLat());
+    b.maxlon = std::max(b.maxlon, bb.GetMaxLon());
+    Insert(slot, k, old_box, true);
+  }
+}
@@ -48,6 +48,7 @@
 #include "model/georef.h"
 #include "navutil.h"  // for LogMessageOnce
 #include "model/navutil_base.h"
+#include "model/perf_trace.h"
 #include "ocpn_pixel.h"
 #include "ocpndc.h"
 #include "s52utils.h"
@@ -509,6 +510,7 @@ void s57chart::FreeObjectsAndRules() {
       }
     }
   }
+  m_spatial_index.Clear();
 }
 
 void s57chart::ClearRenderedTextCache() {
@@ -1718,13 +1720,20 @@ bool s57chart::DoRenderRegionViewOnGL(const wxGLContext &glc,
 }
 
 
+void s57chart::QueryVisibleRules(int prio, int type,
+                                 std::vector<S57IndexHit> &hits) {
+  m_spatial_index.Query(razRules[prio][type], prio, type, ps52plib->GetBBox(),
+                        hits);
+}
+
 bool s57chart::DoRenderOnGL(const wxGLContext &glc, const ViewPort &VPoint) {
 #ifdef ocpnUSE_GL
 
-  int i;
+  int i, j;
   ObjRazRules *top;
   ObjRazRules *crnt;
   ViewPort tvp = VPoint;  // undo const  TODO fix this in PLIB
+  std::vector<S57IndexHit> hits;
 
 #if 1
 
@@ -1733,13 +1742,13 @@ bool s57chart::DoRenderOnGL(const wxGLContext &glc, const ViewPort &VPoint) {
 
   for (i = 0; i < PRIO_NUM; ++i) {
     if (ps52plib->m_nBoundaryStyle == SYMBOLIZED_BOUNDARIES)
-      top = razRules[i][4];  // Area Symbolized Boundaries
+      j = 4;  // Area Symbolized Boundaries
     else
-      top = razRules[i][3];  // Area Plain Boundaries
+      j = 3;  // Area Plain Boundaries
 
-    while (top != NULL) {
-      crnt = top;
-      top = top->next;  // next object
+    QueryVisibleRules(i, j, hits);
+    for (const S57IndexHit &hit : hits) {
+      crnt = hit.rules;
       crnt->sm_transform_parms = &vp_transform;
       ps52plib->RenderAreaToGL(glc, crnt);
     }
@@ -1776,42 +1785,44 @@ bool s57chart::DoRenderOnGL(const wxGLContext &glc, const ViewPort &VPoint) {
   //    Render the lines and points
   for (i = 0; i < PRIO_NUM; ++i) {
     if (ps52plib->m_nBoundaryStyle == SYMBOLIZED_BOUNDARIES)
-      top = razRules[i][4];  // Area Symbolized Boundaries
+      j = 4;  // Area Symbolized Boundaries
     else
-      top = razRules[i][3];  // Area Plain Boundaries
-    while (top != NULL) {
-      crnt = top;
-      top = top->next;  // next object
+      j = 3;  // Area Plain Boundaries
+    QueryVisibleRules(i, j, hits);
+    for (const S57IndexHit &hit : hits) {
+      crnt = hit.rules;
       crnt->sm_transform_parms = &vp_transform;
       ps52plib->RenderObjectToGL(glc, crnt);
     }
+    m_spatial_index.Update(i, j, hits);
   }
   // qDebug() << "Done Boundaries" << sw.GetTime();
 
   for (i = 0; i < PRIO_NUM; ++i) {
-    top = razRules[i][2];  // LINES
-    while (top != NULL) {
-      crnt = top;
-      top = top->next;
+    QueryVisibleRules(i, 2, hits);  // LINES
+    for (const S57IndexHit &hit : hits) {
+      crnt = hit.rules;
       crnt->sm_transform_parms = &vp_transform;
       ps52plib->RenderObjectToGL(glc, crnt);
     }
+    m_spatial_index.Update(i, 2, hits);
   }
 
   // qDebug() << "Done Lines" << sw.GetTime();
 
   for (i = 0; i < PRIO_NUM; ++i) {
     if (ps52plib->m_nSymbolStyle == SIMPLIFIED)
-      top = razRules[i][0];  // SIMPLIFIED Points
+      j = 0;  // SIMPLIFIED Points
     else
-      top = razRules[i][1];  // Paper Chart Points Points
+      j = 1;  // Paper Chart Points Points
 
-    while (top != NULL) {
-      crnt = top;
-      top = top->next;
+    QueryVisibleRules(i, j, hits);
+    for (const S57IndexHit &hit : hits) {
+      crnt = hit.rules;
       crnt->sm_transform_parms = &vp_transform;
       ps52plib->RenderObjectToGL(glc, crnt);
     }
+    m_spatial_index.Update(i, j, hits);
   }
   // qDebug() << "Done Points" << sw.GetTime();
 
@@ -1824,10 +1835,10 @@ bool s57chart::DoRenderOnGLText(const wxGLContext &glc,
                                 const ViewPort &VPoint) {
 #ifdef ocpnUSE_GL
 
-  int i;
-  ObjRazRules *top;
+  int i, j;
   ObjRazRules *crnt;
   ViewPort tvp = VPoint;  // undo const  TODO fix this in PLIB
+  std::vector<S57IndexHit> hits;
 
 #if 0
     //      Render the areas quickly
@@ -1849,36 +1860,38 @@ bool s57chart::DoRenderOnGLText(const wxGLContext &glc,
   //    Render the lines and points
   for (i = 0; i < PRIO_NUM; ++i) {
     if (ps52plib->m_nBoundaryStyle == SYMBOLIZED_BOUNDARIES)
-      top = razRules[i][4];  // Area Symbolized Boundaries
+      j = 4;  // Area Symbolized Boundaries
     else
-      top = razRules[i][3];  // Area Plain Boundaries
+      j = 3;  // Area Plain Boundaries
 
-    while (top != NULL) {
-      crnt = top;
-      top = top->next;  // next object
+    QueryVisibleRules(i, j, hits);
+    for (const S57IndexHit &hit : hits) {
+      crnt = hit.rules;
       crnt->sm_transform_parms = &vp_transform;
       ps52plib->RenderObjectToGLText(glc, crnt);
     }
+    m_spatial_index.Update(i, j, hits);
 
-    top = razRules[i][2];  // LINES
-    while (top != NULL) {
-      crnt = top;
-      top = top->next;
+    QueryVisibleRules(i, 2, hits);  // LINES
+    for (const S57IndexHit &hit : hits) {
+      crnt = hit.rules;
       crnt->sm_transform_parms = &vp_transform;
       ps52plib->RenderObjectToGLText(glc, crnt);
     }
+    m_spatial_index.Update(i, 2, hits);
 
     if (ps52plib->m_nSymbolStyle == SIMPLIFIED)
-      top = razRules[i][0];  // SIMPLIFIED Points
+      j = 0;  // SIMPLIFIED Points
     else
-      top = razRules[i][1];  // Paper Chart Points Points
+      j = 1;  // Paper Chart Points Points
 
-    while (top != NULL) {
-      crnt = top;
-      top = top->next;
+    QueryVisibleRules(i, j, hits);
+    for (const S57IndexHit &hit : hits) {
+      crnt = hit.rules;
       crnt->sm_transform_parms = &vp_transform;
       ps52plib->RenderObjectToGLText(glc, crnt);
     }
+    m_spatial_index.Update(i, j, hits);
   }
 
 #endif  //#ifdef ocpnUSE_GL
@@ -2296,7 +2309,6 @@ bool s57chart::DoRenderViewOnDC(wxMemoryDC &dc, const ViewPort &VPoint,
 int s57chart::DCRenderRect(wxMemoryDC &dcinput, const ViewPort &vp,
                            wxRect *rect) {
   int i;
-  ObjRazRules *top;
   ObjRazRules *crnt;
 
   wxASSERT(rect);
@@ -2355,15 +2367,15 @@ int s57chart::DCRenderRect(wxMemoryDC &dcinput, const ViewPort &vp,
   }
 
   //      Render the areas quickly
+  std::vector<S57IndexHit> hits;
   for (i = 0; i < PRIO_NUM; ++i) {
     if (ps52plib->m_nBoundaryStyle == SYMBOLIZED_BOUNDARIES)
-      top = razRules[i][4];  // Area Symbolized Boundaries
+      QueryVisibleRules(i, 4, hits);  // Area Symbolized Boundaries
     else
-      top = razRules[i][3];  // Area Plain Boundaries
+      QueryVisibleRules(i, 3, hits);  // Area Plain Boundaries
 
-    while (top != NULL) {
-      crnt = top;
-      top = top->next;  // next object
+    for (const S57IndexHit &hit : hits) {
+      crnt = hit.rules;
       crnt->sm_transform_parms = &vp_transform;
       ps52plib->RenderAreaToDC(&dcinput, crnt, &pb_spec);
     }
@@ -2408,10 +2420,10 @@ int s57chart::DCRenderRect(wxMemoryDC &dcinput, const ViewPort &vp,
 
 bool s57chart::DCRenderLPB(wxMemoryDC &dcinput, const ViewPort &vp,
                            wxRect *rect) {
-  int i;
-  ObjRazRules *top;
+  int i, j;
   ObjRazRules *crnt;
   ViewPort tvp = vp;  // undo const  TODO fix this in PLIB
+  std::vector<S57IndexHit> hits;
 
   for (i = 0; i < PRIO_NUM; ++i) {
     //      Set up a Clipper for Lines
@@ -2422,35 +2434,38 @@ bool s57chart::DCRenderLPB(wxMemoryDC &dcinput, const ViewPort &vp,
     //      }
 
     if (ps52plib->m_nBoundaryStyle == SYMBOLIZED_BOUNDARIES)
-      top = razRules[i][4];  // Area Symbolized Boundaries
+      j = 4;  // Area Symbolized Boundaries
     else
-      top = razRules[i][3];  // Area Plain Boundaries
-    while (top != NULL) {
-      crnt = top;
-      top = top->next;  // next object
+      j = 3;  // Area Plain Boundaries
+
+    QueryVisibleRules(i, j, hits);
+    for (const S57IndexHit &hit : hits) {
+      crnt = hit.rules;
       crnt->sm_transform_parms = &vp_transform;
       ps52plib->RenderObjectToDC(&dcinput, crnt);
     }
+    m_spatial_index.Update(i, j, hits);
 
-    top = razRules[i][2];  // LINES
-    while (top != NULL) {
-      crnt = top;
-      top = top->next;
+    QueryVisibleRules(i, 2, hits);  // LINES
+    for (const S57IndexHit &hit : hits) {
+      crnt = hit.rules;
       crnt->sm_transform_parms = &vp_transform;
       ps52plib->RenderObjectToDC(&dcinput, crnt);
     }
+    m_spatial_index.Update(i, 2, hits);
 
     if (ps52plib->m_nSymbolStyle == SIMPLIFIED)
-      top = razRules[i][0];  // SIMPLIFIED Points
+      j = 0;  // SIMPLIFIED Points
     else
-      top = razRules[i][1];  // Paper Chart Points Points
+      j = 1;  // Paper Chart Points Points
 
-    while (top != NULL) {
-      crnt = top;
-      top = top->next;
+    QueryVisibleRules(i, j, hits);
+    for (const S57IndexHit &hit : hits) {
+      crnt = hit.rules;
       crnt->sm_transform_parms = &vp_transform;
       ps52plib->RenderObjectToDC(&dcinput, crnt);
     }
+    m_spatial_index.Update(i, j, hits);
 
     //      Destroy Clipper
     if (pdcc) delete pdcc;
@@ -2467,43 +2482,45 @@ bool s57chart::DCRenderLPB(wxMemoryDC &dcinput, const ViewPort &vp,
 }
 
 bool s57chart::DCRenderText(wxMemoryDC &dcinput, const ViewPort &vp) {
-  int i;
-  ObjRazRules *top;
+  int i, j;
   ObjRazRules *crnt;
   ViewPort tvp = vp;  // undo const  TODO fix this in PLIB
+  std::vector<S57IndexHit> hits;
 
   for (i = 0; i < PRIO_NUM; ++i) {
     if (ps52plib->m_nBoundaryStyle == SYMBOLIZED_BOUNDARIES)
-      top = razRules[i][4];  // Area Symbolized Boundaries
+      j = 4;  // Area Symbolized Boundaries
     else
-      top = razRules[i][3];  // Area Plain Boundaries
+      j = 3;  // Area Plain Boundaries
 
-    while (top != NULL) {
-      crnt = top;
-      top = top->next;  // next object
+    QueryVisibleRules(i, j, hits);
+    for (const S57IndexHit &hit : hits) {
+      crnt = hit.rules;
       crnt->sm_transform_parms = &vp_transform;
       ps52plib->RenderObjectToDCText(&dcinput, crnt);
     }
+    m_spatial_index.Update(i, j, hits);
 
-    top = razRules[i][2];  // LINES
-    while (top != NULL) {
-      crnt = top;
-      top = top->next;
+    QueryVisibleRules(i, 2, hits);  // LINES
+    for (const S57IndexHit &hit : hits) {
+      crnt = hit.rules;
       crnt->sm_transform_parms = &vp_transform;
       ps52plib->RenderObjectToDCText(&dcinput, crnt);
     }
+    m_spatial_index.Update(i, 2, hits);
 
     if (ps52plib->m_nSymbolStyle == SIMPLIFIED)
-      top = razRules[i][0];  // SIMPLIFIED Points
+      j = 0;  // SIMPLIFIED Points
     else
-      top = razRules[i][1];  // Paper Chart Points Points
+      j = 1;  // Paper Chart Points Points
 
-    while (top != NULL) {
-      crnt = top;
-      top = top->next;
+    QueryVisibleRules(i, j, hits);
+    for (const S57IndexHit &hit : hits) {
+      crnt = hit.rules;
       crnt->sm_transform_parms = &vp_transform;
       ps52plib->RenderObjectToDCText(&dcinput, crnt);
     }
+    m_spatial_index.Update(i, j, hits);
   }
 
   return true;
@@ -2671,6 +2688,7 @@ wxString s57chart::buildSENCName(const wxString &name) {
 //    Returns with error code, and associated SENC file name in m_S57FileName
 //-----------------------------------------------------------------------------------------------
 int s57chart::FindOrCreateSenc(const wxString &name, bool b_progress) {
+  PerfScope perf("s57chart::FindOrCreateSenc");
   //  This method may be called for a compressed .000 cell, so check and
   //  decompress if necessary
   wxString ext;
@@ -3520,9 +3538,15 @@ std::list<S57Obj*> *s57chart::GetAssociatedObjects(S57Obj *obj) {
       ObjRazRules *top;
       disPrioIdx = 1;  // PRIO_GROUP1:S57 group 1 filled areas
 
+      std::vector<S57IndexHit> hits;
+      LLBBox point_box;
+      point_box.Set(lat, lon, lat, lon);
+
       gotit = false;
-      top = razRules[disPrioIdx][3];  // PLAIN_BOUNDARIES
-      while (top != NULL) {
+      m_spatial_index.Query(razRules[disPrioIdx][3], disPrioIdx, 3, point_box,
+                            hits);  // PLAIN_BOUNDARIES
+      for (const S57IndexHit &hit : hits) {
+        top = hit.rules;
         if (top->obj->bIsAssociable) {
           if (top->obj->BBObj.Contains(lat, lon)) {
             if (IsPointInObjArea(lat, lon, 0.0, top->obj)) {
@@ -3532,14 +3556,13 @@ std::list<S57Obj*> *s57chart::GetAssociatedObjects(S57Obj *obj) {
             }
           }
         }
-
-        ObjRazRules *nxx = top->next;
-        top = nxx;
       }
 
       if (!gotit) {
-        top = razRules[disPrioIdx][4];  // SYMBOLIZED_BOUNDARIES
-        while (top != NULL) {
+        m_spatial_index.Query(razRules[disPrioIdx][4], disPrioIdx, 4,
+                              point_box, hits);  // SYMBOLIZED_BOUNDARIES
+        for (const S57IndexHit &hit : hits) {
+          top = hit.rules;
           if (top->obj->bIsAssociable) {
             if (top->obj->BBObj.Contains(lat, lon)) {
               if (IsPointInObjArea(lat, lon, 0.0, top->obj)) {
@@ -3548,9 +3571,6 @@ std::list<S57Obj*> *s57chart::GetAssociatedObjects(S57Obj *obj) {
               }
             }
           }
-
-          ObjRazRules *nxx = top->next;
-          top = nxx;
         }
       }
 
@@ -4437,6 +4457,8 @@ int s57chart::_insertRules(S57Obj *obj, LUPrec *LUP, s57chart *pOwner) {
   else
     razRules[disPrioIdx][LUPtypeIdx] = rzRules;
 
+  m_spatial_index.Invalidate(disPrioIdx, LUPtypeIdx);
+
 #endif
 
   return 1;
@@ -4454,6 +4476,8 @@ void s57chart::ResetPointBBoxes(const ViewPort &vp_last,
 
   for (int i = 0; i < PRIO_NUM; ++i) {
     for (int j = 0; j < 2; ++j) {
+      //  Index the rescaled boxes, instead of those grown at the last scale
+      m_spatial_index.Invalidate(i, j);
       top = razRules[i][j];
 
       while (top != NULL) {
@@ -4748,17 +4772,25 @@ ListOfObjRazRules *s57chart::GetObjRuleListAtLatLon(float lat, float lon,
   PrepareForRender(VPoint, ps52plib);
 
   //    Iterate thru the razRules array, by object/rule type
+  //    Only the objects whose bounding box is within select_radius
+  //    of lat/lon are candidates
 
   ObjRazRules *top;
+  std::vector<S57IndexHit> hits;
+  LLBBox pick_box;
+  pick_box.Set(lat, lon, lat, lon);
+  pick_box.EnLarge(select_radius);
 
   for (int i = 0; i < PRIO_NUM; ++i) {
     if (selection_mask & MASK_POINT) {
       // Points by type, array indices [0..1]
 
       int point_type = (ps52plib->m_nSymbolStyle == SIMPLIFIED) ? 0 : 1;
-      top = razRules[i][point_type];
+      m_spatial_index.Query(razRules[i][point_type], i, point_type, pick_box,
+                            hits);
 
-      while (top != NULL) {
+      for (const S57IndexHit &hit : hits) {
+        top = hit.rules;
         if (top->obj->npt ==
             1)  // Do not select Multipoint objects (SOUNDG) yet.
         {
@@ -4784,8 +4816,6 @@ ListOfObjRazRules *s57chart::GetObjRuleListAtLatLon(float lat, float lon,
             child_item = child_item->next;
           }
         }
-
-        top = top->next;
       }
     }
 
@@ -4794,28 +4824,27 @@ ListOfObjRazRules *s57chart::GetObjRuleListAtLatLon(float lat, float lon,
 
       int area_boundary_type =
           (ps52plib->m_nBoundaryStyle == PLAIN_BOUNDARIES) ? 3 : 4;
-      top = razRules[i][area_boundary_type];  // Area nnn Boundaries
-      while (top != NULL) {
+      m_spatial_index.Query(razRules[i][area_boundary_type], i,
+                            area_boundary_type, pick_box, hits);
+      for (const S57IndexHit &hit : hits) {
+        top = hit.rules;
         if (ps52plib->ObjectRenderCheck(top)) {
           if (DoesLatLonSelectObject(lat, lon, select_radius, top->obj))
             selected_rules.push_back(top);
         }
-
-        top = top->next;
-      }  // while
+      }
     }
 
     if (selection_mask & MASK_LINE) {
       // Finally, lines
-      top = razRules[i][2];  // Lines
+      m_spatial_index.Query(razRules[i][2], i, 2, pick_box, hits);  // Lines
 
-      while (top != NULL) {
+      for (const S57IndexHit &hit : hits) {
+        top = hit.rules;
         if (ps52plib->ObjectRenderCheck(top)) {
           if (DoesLatLonSelectObject(lat, lon, select_radius, top->obj))
             selected_rules.push_back(top);
         }
-
-        top = top->next;
       }
     }
   }
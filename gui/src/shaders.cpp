@@ -231,6 +231,31 @@ static const GLchar *ring_fragment_shader_source =
     "}\n"
     "}\n";
 
+// AIS target batch shader, see AisSymbolBatch
+
+static const GLchar* ais_batch_vertex_shader_source =
+    "attribute vec2 aLocal;\n"
+    "attribute vec2 aExtrude;\n"
+    "attribute vec2 aPos;\n"
+    "attribute vec2 aRot;\n"
+    "attribute float aScale;\n"
+    "attribute vec4 aColor;\n"
+    "uniform mat4 MVMatrix;\n"
+    "varying vec4 fragColor;\n"
+    "void main() {\n"
+    "   vec2 p = aScale * aLocal + aExtrude;\n"
+    "   vec2 r = vec2(p.x * aRot.x + p.y * aRot.y, p.y * aRot.x - p.x * aRot.y);\n"
+    "   fragColor = aColor;\n"
+    "   gl_Position = MVMatrix * vec4(aPos + r, 0.0, 1.0);\n"
+    "}\n";
+
+static const GLchar* ais_batch_fragment_shader_source =
+    "precision lowp float;\n"
+    "varying vec4 fragColor;\n"
+    "void main() {\n"
+    "   gl_FragColor = fragColor;\n"
+    "}\n";
+
   // Alpha 2D texture shader
 static const GLchar* Android_texture_2DA_vertex_shader_source =
     "attribute vec2 aPos;\n"
@@ -258,6 +283,7 @@ GLShaderProgram *ptexture_2D_shader_program[2];
 GLShaderProgram *pcircle_filled_shader_program[2];
 GLShaderProgram *ptexture_2DA_shader_program[2];
 GLShaderProgram *pring_shader_program[2];
+GLShaderProgram *pais_batch_shader_program[2];
 
 GLint texture_2DA_vertex_shader_p;
 GLint texture_2DA_fragment_shader_p;
@@ -339,6 +365,16 @@ bool loadShaders(int index) {
       pring_shader_program[index] = shaderProgram;
   }
 
+  if (!pais_batch_shader_program[index]) {
+    GLShaderProgram *shaderProgram = new GLShaderProgram;
+    shaderProgram->addShaderFromSource(ais_batch_vertex_shader_source, GL_VERTEX_SHADER);
+    shaderProgram->addShaderFromSource(ais_batch_fragment_shader_source, GL_FRAGMENT_SHADER);
+    shaderProgram->linkProgram();
+
+    if (shaderProgram->isOK())
+      pais_batch_shader_program[index] = shaderProgram;
+  }
+
 #ifdef __ANDROID__
   //  2DA shader called by some Android plugins
   if (!texture_2DA_vertex_shader_p) {
@@ -25,12 +25,18 @@
  *
  */
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+
 // Include OCPNPlatform.h before shapefile_basemap.h to prevent obscure syntax
 // error when compiling with VS2022
 #include "OCPNPlatform.h"
 #include "shapefile_basemap.h"
 #include "chartbase.h"
 #include "glChartCanvas.h"
+#include "model/georef.h"
 
 #ifdef ocpnUSE_GL
 #include "shaders.h"
@@ -47,87 +53,162 @@ extern wxString gWorldShapefileLocation;
 
 #ifdef ocpnUSE_GL
 
-typedef union {
-  GLdouble data[6];
-  struct sGLvertex {
-    GLdouble x;
-    GLdouble y;
-    GLdouble z;
-    GLdouble r;
-    GLdouble g;
-    GLdouble b;
-  } info;
-} GLvertexshp;
-#include <list>
-
-static std::list<float_2Dpt> g_pvshp;
-static std::list<GLvertexshp *> g_vertexesshp;
-static int g_typeshp, g_posshp;
-static float_2Dpt g_p1shp, g_p2shp;
-
-void __CALL_CONVENTION shpscombineCallback(GLdouble coords[3],
-                                           GLdouble *vertex_data[4],
-                                           GLfloat weight[4],
-                                           GLdouble **dataOut) {
-  GLvertexshp *vertex;
-
-  vertex = new GLvertexshp();
-  g_vertexesshp.push_back(vertex);
-
-  vertex->info.x = coords[0];
-  vertex->info.y = coords[1];
-
-  *dataOut = vertex->data;
+/** Triangles of one mesh being collected from the GLU tessellator. */
+struct ShpTessState {
+  std::vector<float> *triangles;
+  std::deque<std::array<GLdouble, 3>> combined;
+  GLenum type;
+  int pos;
+  float p1[2];
+  float p2[2];
+};
+
+void __CALL_CONVENTION shpscombineCallbackD(GLdouble coords[3],
+                                            GLdouble *vertex_data[4],
+                                            GLfloat weight[4],
+                                            GLdouble **dataOut, void *data) {
+  auto state = static_cast<ShpTessState *>(data);
+  state->combined.push_back({coords[0], coords[1], 0});
+  *dataOut = state->combined.back().data();
 }
 
-void __CALL_CONVENTION shpserrorCallback(GLenum errorCode) {
+void __CALL_CONVENTION shpserrorCallbackD(GLenum errorCode, void *data) {
   const GLubyte *estring;
   estring = gluErrorString(errorCode);
   // wxLogMessage( _T("OpenGL Tessellation Error: %s"), estring );
 }
 
-void __CALL_CONVENTION shpsbeginCallback(GLenum type) {
+void __CALL_CONVENTION shpsbeginCallbackD(GLenum type, void *data) {
+  auto state = static_cast<ShpTessState *>(data);
   switch (type) {
     case GL_TRIANGLES:
     case GL_TRIANGLE_STRIP:
     case GL_TRIANGLE_FAN:
-      g_typeshp = type;
+      state->type = type;
       break;
     default:
       printf("tess unhandled begin type: %d\n", type);
   }
 
-  g_posshp = 0;
+  state->pos = 0;
 }
 
-void __CALL_CONVENTION shpsendCallback() {}
+void __CALL_CONVENTION shpsendCallbackD(void *data) {}
 
-void __CALL_CONVENTION shpsvertexCallback(GLvoid *arg) {
-  GLvertexshp *vertex;
-  vertex = (GLvertexshp *)arg;
-  float_2Dpt p;
-  p.y = vertex->info.x;
-  p.x = vertex->info.y;
+void __CALL_CONVENTION shpsvertexCallbackD(GLvoid *arg, void *data) {
+  auto state = static_cast<ShpTessState *>(data);
+  auto vertex = static_cast<GLdouble *>(arg);
+  float p[2] = {static_cast<float>(vertex[0]), static_cast<float>(vertex[1])};
 
   // convert strips and fans into triangles
-  if (g_typeshp != GL_TRIANGLES) {
-    if (g_posshp > 2) {
-      g_pvshp.push_back(g_p1shp);
-      g_pvshp.push_back(g_p2shp);
+  if (state->type != GL_TRIANGLES) {
+    if (state->pos > 2) {
+      state->triangles->insert(state->triangles->end(), state->p1,
+                               state->p1 + 2);
+      state->triangles->insert(state->triangles->end(), state->p2,
+                               state->p2 + 2);
     }
 
-    if (g_typeshp == GL_TRIANGLE_STRIP)
-      g_p1shp = g_p2shp;
-    else if (g_posshp == 0)
-      g_p1shp = p;
-    g_p2shp = p;
+    if (state->type == GL_TRIANGLE_STRIP) {
+      state->p1[0] = state->p2[0], state->p1[1] = state->p2[1];
+    } else if (state->pos == 0) {
+      state->p1[0] = p[0], state->p1[1] = p[1];
+    }
+    state->p2[0] = p[0], state->p2[1] = p[1];
   }
 
-  g_pvshp.push_back(p);
-  g_posshp++;
+  state->triangles->insert(state->triangles->end(), p, p + 2);
+  state->pos++;
+}
+
+/** Fill mesh.triangles from mesh.rings, each ring filled on its own. */
+static void TessellateMesh(BasemapMesh &mesh) {
+  ShpTessState state;
+  state.triangles = &mesh.triangles;
+  state.type = GL_TRIANGLES;
+  state.pos = 0;
+
+  GLUtesselator *tobj = gluNewTess();
+  gluTessCallback(tobj, GLU_TESS_VERTEX_DATA,
+                  (_GLUfuncptr)&shpsvertexCallbackD);
+  gluTessCallback(tobj, GLU_TESS_BEGIN_DATA, (_GLUfuncptr)&shpsbeginCallbackD);
+  gluTessCallback(tobj, GLU_TESS_END_DATA, (_GLUfuncptr)&shpsendCallbackD);
+  gluTessCallback(tobj, GLU_TESS_COMBINE_DATA,
+                  (_GLUfuncptr)&shpscombineCallbackD);
+  gluTessCallback(tobj, GLU_TESS_ERROR_DATA, (_GLUfuncptr)&shpserrorCallbackD);
+
+  gluTessNormal(tobj, 0, 0, 1);
+  gluTessProperty(tobj, GLU_TESS_WINDING_RULE, GLU_TESS_WINDING_NONZERO);
+
+  std::vector<GLdouble> coords;
+  for (size_t r = 0; r + 1 < mesh.ring_starts.size(); r++) {
+    size_t first = mesh.ring_starts[r];
+    size_t last = mesh.ring_starts[r + 1];
+    if (last - first < 3) continue;
+    // gluTessVertex keeps the pointers until gluTessEndPolygon
+    coords.resize(3 * (last - first));
+    gluTessBeginPolygon(tobj, &state);
+    gluTessBeginContour(tobj);
+    for (size_t i = first; i < last; i++) {
+      GLdouble *c = &coords[3 * (i - first)];
+      c[0] = mesh.rings[2 * i];
+      c[1] = mesh.rings[2 * i + 1];
+      c[2] = 0;
+      gluTessVertex(tobj, c, c);
+    }
+    gluTessEndContour(tobj);
+    gluTessEndPolygon(tobj);
+    state.combined.clear();
+  }
+  gluDeleteTess(tobj);
+  mesh.triangles.shrink_to_fit();
 }
 #endif
 
+/**
+ * Convert (lon, lat) offset pairs from the mesh reference into mercator
+ * meters from the reference. Latitudes are clamped short of the poles
+ * which have no mercator coordinate.
+ */
+static void ToMercator(const BasemapMesh &mesh, const std::vector<float> &ll,
+                       std::vector<float> &sm) {
+  double y30 = toSMcache_y30(mesh.ref_lat);
+  sm.resize(ll.size());
+  for (size_t i = 0; i < ll.size(); i += 2) {
+    double lat = std::min(std::max(mesh.ref_lat + ll[i + 1], -89.0), 89.0);
+    double x, y;
+    toSMcache(lat, mesh.ref_lon + ll[i], y30, mesh.ref_lon, &x, &y);
+    sm[i] = x;
+    sm[i + 1] = y;
+  }
+}
+
+/**
+ * Affine map from mercator meters relative to a mesh reference to viewport
+ * pixels: x = x0 + a * e + b * n, y = y0 + b * e - a * n.
+ *
+ * The reference is placed lon_shift degrees from the mesh reference as is.
+ * ViewPort::GetDoublePixFromLL() would bring it back within 180 degrees
+ * of the view center and undo a +/-360 shift across the date line.
+ */
+struct MercatorTransform {
+  MercatorTransform(ViewPort &vp, const BasemapMesh &mesh, double lon_shift) {
+    const double z = WGS84_semimajor_axis_meters * mercator_k0;
+    double e = (mesh.ref_lon + lon_shift - vp.clon) * DEGREE * z;
+    double n = toSMcache_y30(mesh.ref_lat) - toSMcache_y30(vp.clat);
+    a = vp.view_scale_ppm * cos(vp.rotation);
+    b = vp.view_scale_ppm * sin(vp.rotation);
+    x0 = vp.pix_width / 2.0 + a * e + b * n;
+    y0 = vp.pix_height / 2.0 + b * e - a * n;
+  }
+  double x0, y0, a, b;
+};
+
+static bool IsMercator(const ViewPort &vp) {
+  return vp.m_projection_type == PROJECTION_MERCATOR ||
+         vp.m_projection_type == PROJECTION_WEB_MERCATOR;
+}
+
 ShapeBaseChartSet::ShapeBaseChartSet() : _loaded(false) {
 }
 
@@ -245,6 +326,15 @@ void ShapeBaseChartSet::LoadBasemaps(const std::string &dir) {
     //LowestQualityBaseMap().LoadSHP();
 }
 
+ShapeBaseChart::~ShapeBaseChart() {
+#ifdef ocpnUSE_GL
+  for (auto &mesh : _meshes) {
+    if (mesh.vbo) glDeleteBuffers(1, &mesh.vbo);
+  }
+#endif
+  delete _reader;
+}
+
 bool ShapeBaseChart::LoadSHP() {
   _reader = new shp::ShapefileReader(_filename);
   auto bounds = _reader->getBounds();
@@ -263,141 +353,153 @@ bool ShapeBaseChart::LoadSHP() {
     }
   }
   _is_tiled = (has_x && has_y);
-  if (_is_usable && _is_tiled) {
-    size_t feat{0};
-    for (auto const &feature : *_reader) {
-      auto f1 = feature.getAttributes();
-      _tiles[LatLonKey(std::any_cast<int>(feature.getAttributes()["y"]),
-                       std::any_cast<int>(feature.getAttributes()["x"]))]
-          .push_back(feat);
-      feat++;
+  if (!_is_usable) {
+    return false;
+  }
+
+  // The reader is not thread safe, read all features here and tessellate
+  // the tiles in parallel below.
+  if (!_is_tiled) {
+    _meshes.emplace_back(0, 0);
+  }
+  for (auto const &feature : *_reader) {
+    if (!_is_tiled) {
+      AddFeature(_meshes.front(), feature);
+      continue;
+    }
+    auto attributes = feature.getAttributes();
+    int lat = std::any_cast<int>(attributes["y"]);
+    int lon = std::any_cast<int>(attributes["x"]);
+    auto found = _tiles.find(LatLonKey(lat, lon));
+    if (found == _tiles.end()) {
+      found = _tiles.emplace(LatLonKey(lat, lon), _meshes.size()).first;
+      _meshes.emplace_back(lat + _dmod / 2.0, lon + _dmod / 2.0);
     }
+    AddFeature(_meshes[found->second], feature);
   }
+
+#ifdef ocpnUSE_GL
+  std::atomic<size_t> next(0);
+  auto tessellate = [&]() {
+    for (size_t i = next++; i < _meshes.size(); i = next++) {
+      TessellateMesh(_meshes[i]);
+    }
+  };
+  unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+  std::vector<std::future<void>> workers;
+  for (unsigned t = 1; t < threads; t++) {
+    workers.push_back(std::async(std::launch::async, tessellate));
+  }
+  tessellate();
+  for (auto &worker : workers) worker.get();
+#endif
   return _is_usable;
 }
 
-void ShapeBaseChart::DoDrawPolygonFilled(ocpnDC &pnt, ViewPort &vp,
-                                         const shp::Feature &feature) {
-  double old_x = -9999999.0, old_y = -9999999.0;
+void ShapeBaseChart::AddFeature(BasemapMesh &mesh,
+                                const shp::Feature &feature) {
   auto polygon = static_cast<shp::Polygon *>(feature.getGeometry());
-  pnt.SetBrush(_color);
   for (auto &ring : polygon->getRings()) {
-    wxPoint *poly_pt = new wxPoint[ring.getPoints().size()];
-    size_t cnt{0};
-    auto bbox = vp.GetBBox();
+    size_t first = mesh.rings.size() / 2;
+    LLBBox box;
+    double minlat = 90, minlon = 180, maxlat = -90, maxlon = -180;
     for (auto &point : ring.getPoints()) {
-      // if (bbox.ContainsMarge(point.getY(), point.getX(), 0.05)) {
-      wxPoint2DDouble q =
-          ShapeBaseChartSet::GetDoublePixFromLL(vp, point.getY(), point.getX());
-      if (round(q.m_x) != round(old_x) || round(q.m_y) != round(old_y)) {
-        poly_pt[cnt].x = round(q.m_x);
-        poly_pt[cnt].y = round(q.m_y);
-        cnt++;
+      float dlon = point.getX() - mesh.ref_lon;
+      float dlat = point.getY() - mesh.ref_lat;
+      size_t n = mesh.rings.size();
+      if (n / 2 > first && mesh.rings[n - 2] == dlon &&
+          mesh.rings[n - 1] == dlat) {
+        continue;
       }
-      old_x = q.m_x;
-      old_y = q.m_y;
-      //}
+      mesh.rings.push_back(dlon);
+      mesh.rings.push_back(dlat);
+      minlat = std::min(minlat, point.getY());
+      maxlat = std::max(maxlat, point.getY());
+      minlon = std::min(minlon, point.getX());
+      maxlon = std::max(maxlon, point.getX());
+    }
+    // Drop the closing point, the ring is closed implicitly
+    size_t n = mesh.rings.size();
+    if (n / 2 > first + 1 && mesh.rings[n - 2] == mesh.rings[2 * first] &&
+        mesh.rings[n - 1] == mesh.rings[2 * first + 1]) {
+      mesh.rings.resize(n - 2);
     }
-    if (cnt > 1) {
-      pnt.DrawPolygonTessellated(cnt, poly_pt, 0, 0);
+    if (mesh.rings.size() / 2 - first < 2) {
+      mesh.rings.resize(2 * first);
+      continue;
     }
-    delete[] poly_pt;
+    box.Set(minlat, minlon, maxlat, maxlon);
+    mesh.ring_starts.push_back(mesh.rings.size() / 2);
+    mesh.ring_boxes.push_back(box);
   }
 }
 
-void ShapeBaseChart::AddPointToTessList(shp::Point &point, ViewPort &vp,
-                                        GLUtesselator *tobj, bool idl) {
-#ifdef ocpnUSE_GL
+bool ShapeBaseChart::Loaded(bool wait) {
+  if (!_is_usable) {
+    return false;
+  }
+  if (!_reader && !_loaded.valid()) {
+    _loading = true;
+    _loaded = std::async(std::launch::async, [&]() {
+      bool ret = LoadSHP();
+      _loading = false;
+      return ret;
+    });
+  }
+  if (_loaded.valid()) {
+    if (!wait && _loaded.wait_for(std::chrono::milliseconds(0)) !=
+                     std::future_status::ready) {
+      return false;  // not yet loaded
+    }
+    _is_usable = _loaded.get();
+  }
+  return _is_usable;
+}
+
+void ShapeBaseChart::DoDrawPolygonFilled(ocpnDC &pnt, ViewPort &vp,
+                                         BasemapMesh &mesh, double lon_shift) {
+  bool mercator = IsMercator(vp);
+  if (mercator && mesh.rings_sm.empty()) {
+    ToMercator(mesh, mesh.rings, mesh.rings_sm);
+  }
+  MercatorTransform tf(vp, mesh, lon_shift);
+  // The DC is offset by the rotated viewport origin, see GetDoublePixFromLL()
+  tf.x0 -= vp.rv_rect.x, tf.y0 -= vp.rv_rect.y;
 
-  wxPoint2DDouble q;
-  if (glChartCanvas::HasNormalizedViewPort(vp)) {
-    q = ShapeBaseChartSet::GetDoublePixFromLL(vp, point.getY(), point.getX());
-  } else {  // tesselation directly from lat/lon
-    q.m_x = point.getY(), q.m_y = point.getX();
-  }
-  GLvertexshp *vertex = new GLvertexshp();
-  g_vertexesshp.push_back(vertex);
-  if (vp.m_projection_type != PROJECTION_POLAR) {
-    // need to correctly pick +180 or -180 longitude for projections
-    // that have a discontiguous date line
-
-    if (idl && (point.getX() == 180)) {
-      if (vp.m_projection_type == PROJECTION_MERCATOR ||
-          vp.m_projection_type == PROJECTION_EQUIRECTANGULAR) {
-        // q.m_x -= 40058986 * 4096.0;  // 360 degrees in normalized
-        // viewport
+  pnt.SetBrush(_color);
+  for (size_t r = 0; r + 1 < mesh.ring_starts.size(); r++) {
+    size_t first = mesh.ring_starts[r];
+    size_t last = mesh.ring_starts[r + 1];
+    _dc_points.clear();
+    for (size_t i = first; i < last; i++) {
+      wxPoint2DDouble q;
+      if (mercator) {
+        double e = mesh.rings_sm[2 * i], n = mesh.rings_sm[2 * i + 1];
+        q.m_x = tf.x0 + tf.a * e + tf.b * n;
+        q.m_y = tf.y0 + tf.b * e - tf.a * n;
       } else {
-        q.m_x -= 360;  // lat/lon coordinates
+        q = ShapeBaseChartSet::GetDoublePixFromLL(
+            vp, mesh.ref_lat + mesh.rings[2 * i + 1],
+            mesh.ref_lon + mesh.rings[2 * i]);
+      }
+      wxPoint pt(round(q.m_x), round(q.m_y));
+      if (_dc_points.empty() || pt != _dc_points.back()) {
+        _dc_points.push_back(pt);
       }
     }
+    if (_dc_points.size() > 1) {
+      pnt.DrawPolygonTessellated(_dc_points.size(), _dc_points.data(), 0, 0);
+    }
   }
-  vertex->info.x = q.m_x;
-  vertex->info.y = q.m_y;
-
-  gluTessVertex(tobj, (GLdouble *)vertex, (GLdouble *)vertex);
-#endif
 }
 
 void ShapeBaseChart::DoDrawPolygonFilledGL(ocpnDC &pnt, ViewPort &vp,
-                                           const shp::Feature &feature) {
+                                           BasemapMesh &mesh,
+                                           double lon_shift) {
 #ifdef ocpnUSE_GL
-
-  bool idl =
-      vp.GetBBox().GetMinLon() <= -180 || vp.GetBBox().GetMaxLon() >= 180;
-  auto polygon = static_cast<shp::Polygon *>(feature.getGeometry());
-  for (auto &ring : polygon->getRings()) {
-    size_t cnt{0};
-    GLUtesselator *tobj = gluNewTess();
-
-    gluTessCallback(tobj, GLU_TESS_VERTEX, (_GLUfuncptr)&shpsvertexCallback);
-    gluTessCallback(tobj, GLU_TESS_BEGIN, (_GLUfuncptr)&shpsbeginCallback);
-    gluTessCallback(tobj, GLU_TESS_END, (_GLUfuncptr)&shpsendCallback);
-    gluTessCallback(tobj, GLU_TESS_COMBINE, (_GLUfuncptr)&shpscombineCallback);
-    gluTessCallback(tobj, GLU_TESS_ERROR, (_GLUfuncptr)&shpserrorCallback);
-
-    gluTessNormal(tobj, 0, 0, 1);
-    gluTessProperty(tobj, GLU_TESS_WINDING_RULE, GLU_TESS_WINDING_NONZERO);
-
-    gluTessBeginPolygon(tobj, NULL);
-    gluTessBeginContour(tobj);
-    for (auto &point : ring.getPoints()) {
-      AddPointToTessList(point, vp, tobj, idl);
-      cnt++;
-    }
-    gluTessEndContour(tobj);
-    gluTessEndPolygon(tobj);
-    gluDeleteTess(tobj);
-
-    for (auto ver : g_vertexesshp) delete ver;
-    g_vertexesshp.clear();
-  }
-  float_2Dpt *polyv = new float_2Dpt[g_pvshp.size()];
-  int cnt = 0;
-  for (auto pt : g_pvshp) {
-    polyv[cnt++] = pt;
-  }
-  size_t polycnt = g_pvshp.size();
-  g_pvshp.clear();
-
-  GLuint vbo = 0;
-
-  //  Build the shader viewport transform matrix
-  mat4x4 m, mvp;
-  mat4x4_identity(m);
-  mat4x4_scale_aniso(mvp, m, 2.0 / (float)vp.pix_width,
-                     2.0 / (float)vp.pix_height, 1.0);
-  mat4x4_translate_in_place(mvp, -vp.pix_width / 2, vp.pix_height / 2, 0);
-
-  float *pvt = new float[2 * (polycnt)];
-  for (size_t i = 0; i < polycnt; i++) {
-    float_2Dpt *pc = polyv + i;
-    // wxPoint2DDouble q(pc->y, pc->x);// = vp.GetDoublePixFromLL(pc->y, pc->x);
-    wxPoint2DDouble q = vp.GetDoublePixFromLL(pc->y, pc->x);
-
-    pvt[i * 2] = q.m_x;
-    pvt[(i * 2) + 1] = q.m_y;
+  if (mesh.triangles.empty()) {
+    return;
   }
-
   GLShaderProgram *shader = pcolor_tri_shader_program[pnt.m_canvasIndex];
   shader->Bind();
 
@@ -408,36 +510,61 @@ void ShapeBaseChart::DoDrawPolygonFilledGL(ocpnDC &pnt, ViewPort &vp,
   colorv[3] = 1.0;
   shader->SetUniform4fv("color", colorv);
 
-  shader->SetAttributePointerf("position", pvt);
-
-  glDrawArrays(GL_TRIANGLES, 0, polycnt);
-
-  delete[] pvt;
-  glDeleteBuffers(1, &vbo);
+  size_t count = mesh.triangles.size() / 2;
+  if (IsMercator(vp)) {
+    // Mercator is affine in the buffer coordinates, so the cached buffer
+    // is drawn as is with the viewport mapping in TransformMatrix.
+    if (!mesh.vbo) {
+      std::vector<float> sm;
+      ToMercator(mesh, mesh.triangles, sm);
+      glGenBuffers(1, &mesh.vbo);
+      glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+      glBufferData(GL_ARRAY_BUFFER, sm.size() * sizeof(float), sm.data(),
+                   GL_STATIC_DRAW);
+    }
+    MercatorTransform tf(vp, mesh, lon_shift);
+    mat4x4 m;
+    mat4x4_identity(m);
+    m[0][0] = tf.a, m[0][1] = tf.b;
+    m[1][0] = tf.b, m[1][1] = -tf.a;
+    m[3][0] = tf.x0, m[3][1] = tf.y0;
+    shader->SetUniformMatrix4fv("TransformMatrix", (GLfloat *)m);
+
+    // With the buffer bound the attribute pointer is an offset into it
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+    shader->SetAttributePointerf("position", nullptr);
+    glDrawArrays(GL_TRIANGLES, 0, count);
+
+    mat4x4_identity(m);
+    shader->SetUniformMatrix4fv("TransformMatrix", (GLfloat *)m);
+  } else {
+    _gl_points.resize(2 * count);
+    for (size_t i = 0; i < count; i++) {
+      wxPoint2DDouble q =
+          vp.GetDoublePixFromLL(mesh.ref_lat + mesh.triangles[2 * i + 1],
+                                mesh.ref_lon + mesh.triangles[2 * i]);
+      _gl_points[2 * i] = q.m_x;
+      _gl_points[2 * i + 1] = q.m_y;
+    }
+    shader->SetAttributePointerf("position", _gl_points.data());
+    glDrawArrays(GL_TRIANGLES, 0, count);
+  }
   shader->UnBind();
 #endif
 }
 
 void ShapeBaseChart::DrawPolygonFilled(ocpnDC &pnt, ViewPort &vp) {
-  if (!_is_usable) {
+  if (!Loaded(false)) {
     return;
   }
-  if (!_reader) {
-    _loading = true;
-    _loaded = std::async(std::launch::async, [&]() {
-      bool ret = LoadSHP();
-      _loading = false;
-      return ret;
-    });
-  }
-  if (_loading) {
-    if (_loaded.wait_for(std::chrono::milliseconds(0)) ==
-        std::future_status::ready) {
-      _is_usable = _loaded.get();
+
+  auto draw = [&](BasemapMesh &mesh, double lon_shift) {
+    if (pnt.GetDC()) {
+      DoDrawPolygonFilled(pnt, vp, mesh, lon_shift);
     } else {
-      return;  // not yet loaded
+      DoDrawPolygonFilledGL(pnt, vp, mesh, lon_shift);
     }
-  }
+  };
 
   int pmod = _dmod;
   LLBBox bbox = vp.GetBBox();
@@ -464,61 +591,58 @@ void ShapeBaseChart::DrawPolygonFilled(ocpnDC &pnt, ViewPort &vp) {
         } else if (j >= 180) {
           lon = j - 360;
         }
-        for (auto fid : _tiles[LatLonKey(i, lon)]) {
-          auto const &feature = _reader->getFeature(fid);
-          if (pnt.GetDC()) {
-            DoDrawPolygonFilled(pnt, vp,
-                                feature);  // Parallelize using std::async?
-          } else {
-            DoDrawPolygonFilledGL(pnt, vp,
-                                  feature);  // Parallelize using std::async?
-          }
+        auto found = _tiles.find(LatLonKey(i, lon));
+        if (found != _tiles.end()) {
+          draw(_meshes[found->second], j - lon);
         }
       }
     }
-  } else {
-    for (auto const &feature : *_reader) {
-      if (pnt.GetDC()) {
-        DoDrawPolygonFilled(pnt, vp,
-                            feature);  // Parallelize using std::async?
-      } else {
-        DoDrawPolygonFilledGL(pnt, vp,
-                              feature);  // Parallelize using std::async?
-      }
-    }
+  } else if (!_meshes.empty()) {
+    draw(_meshes.front(), 0);
+    if (bbox.GetMinLon() < -180) draw(_meshes.front(), -360);
+    if (bbox.GetMaxLon() > 180) draw(_meshes.front(), 360);
   }
 }
 
 bool ShapeBaseChart::CrossesLand(double &lat1, double &lon1, double &lat2,
                                  double &lon2) {
+  if (!Loaded(true)) {
+    return false;
+  }
   double latmin = std::min(lat1, lat2);
   double lonmin = std::min(lon1, lon2);
-  double latmax = std::min(lat1, lat2);
-  double lonmax = std::min(lon1, lon2);
+  double latmax = std::max(lat1, lat2);
+  double lonmax = std::max(lon1, lon2);
 
   auto A = std::make_pair(lat1, lon1);
   auto B = std::make_pair(lat2, lon2);
+  LLBBox box;
+  box.Set(latmin, lonmin, latmax, lonmax);
 
   if (_is_tiled) {
-    for (int i = floor(latmin); i < ceil(latmax); i++) {
-      for (int j = floor(lonmin); j < ceil(lonmax); j++) {
+    // Tiles are keyed by their south west corner, aligned to _dmod
+    auto align = [&](double v) {
+      int i = floor(v);
+      return i - ((i % _dmod) + _dmod) % _dmod;
+    };
+    for (int i = align(latmin); i <= floor(latmax); i += _dmod) {
+      for (int j = align(lonmin); j <= floor(lonmax); j += _dmod) {
         int lon{j};
         if (j < -180) {
           lon = j + 360;
         } else if (j >= 180) {
           lon = j - 360;
         }
-        for (auto fid : _tiles[LatLonKey(i, lon)]) {
-          auto const &feature = _reader->getFeature(fid);
-          if (PolygonLineIntersect(feature, A, B)) {
-            return true;
-          }
+        auto found = _tiles.find(LatLonKey(i, lon));
+        if (found != _tiles.end() &&
+            PolygonLineIntersect(_meshes[found->second], box, A, B)) {
+          return true;
         }
       }
     }
   } else {
-    for (auto const &feature : *_reader) {
-      if (PolygonLineIntersect(feature, A, B)) {
+    for (auto const &mesh : _meshes) {
+      if (PolygonLineIntersect(mesh, box, A, B)) {
         return true;
       }
     }
@@ -530,7 +654,7 @@ bool ShapeBaseChart::CrossesLand(double &lat1, double &lon1, double &lat2,
 bool ShapeBaseChart::LineLineIntersect(const std::pair<double, double> &A,
                                        const std::pair<double, double> &B,
                                        const std::pair<double, double> &C,
-                                       const std::pair<double, double> &D) {
+                                       const std::pair<double, double> &D) const {
   // Line AB represented as a1x + b1y = c1
   double a1 = B.second - A.second;
   double b1 = A.first - B.first;
@@ -562,24 +686,26 @@ bool ShapeBaseChart::LineLineIntersect(const std::pair<double, double> &A,
   return false;
 }
 
-bool ShapeBaseChart::PolygonLineIntersect(const shp::Feature &feature,
-                                          const std::pair<double, double> &A,
-                                          const std::pair<double, double> &B) {
-  auto polygon = static_cast<shp::Polygon *>(feature.getGeometry());
-  std::pair<double, double> previous_point;
-  for (auto &ring : polygon->getRings()) {
-    size_t cnt{0};
-    for (auto &point : ring.getPoints()) {
-      auto pnt = std::make_pair(point.getY(), point.getX());
-      if (cnt > 0) {
-        // TODO: Is it faster to first check if we are in the boundong box of
-        // the line?
-        if (LineLineIntersect(A, B, previous_point, pnt)) {
-          return true;
-        }
+bool ShapeBaseChart::PolygonLineIntersect(
+    const BasemapMesh &mesh, const LLBBox &box,
+    const std::pair<double, double> &A,
+    const std::pair<double, double> &B) const {
+  for (size_t r = 0; r + 1 < mesh.ring_starts.size(); r++) {
+    if (box.IntersectOut(mesh.ring_boxes[r])) {
+      continue;
+    }
+    size_t first = mesh.ring_starts[r];
+    size_t last = mesh.ring_starts[r + 1];
+    std::pair<double, double> previous_point(
+        mesh.ref_lat + mesh.rings[2 * last - 1],
+        mesh.ref_lon + mesh.rings[2 * last - 2]);
+    for (size_t i = first; i < last; i++) {
+      auto pnt = std::make_pair(mesh.ref_lat + mesh.rings[2 * i + 1],
+                                mesh.ref_lon + mesh.rings[2 * i]);
+      if (LineLineIntersect(A, B, previous_point, pnt)) {
+        return true;
       }
       previous_point = pnt;
-      cnt++;
     }
   }
   return false;
@@ -590,3 +716,34 @@ void ShapeBaseChartSet::RenderViewOnDC(ocpnDC &dc, ViewPort &vp) {
     SelectBaseMap(vp.chart_scale).RenderViewOnDC(dc, vp);
   }
 }
+
+std::vector<bool> ShapeBaseChartSet::CrossesLand(
+    const std::vector<LandTestSegment> &segments) {
+  std::vector<bool> result(segments.size(), false);
+  if (!IsUsable() || segments.empty()) {
+    return result;
+  }
+  ShapeBaseChart &basemap = HighestQualityBaseMap();
+  if (!basemap.Loaded(true)) {
+    return result;
+  }
+  // std::vector<bool> packs bits, give each worker its own flags
+  std::vector<char> crosses(segments.size(), 0);
+  std::atomic<size_t> next(0);
+  auto test = [&]() {
+    for (size_t i = next++; i < segments.size(); i = next++) {
+      LandTestSegment s = segments[i];
+      crosses[i] = basemap.CrossesLand(s.lat1, s.lon1, s.lat2, s.lon2);
+    }
+  };
+  unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+  threads = std::min<size_t>(threads, segments.size() / 64 + 1);
+  std::vector<std::future<void>> workers;
+  for (unsigned t = 1; t < threads; t++) {
+    workers.push_back(std::async(std::launch::async, test));
+  }
+  test();
+  for (auto &worker : workers) worker.get();
+  for (size_t i = 0; i < segments.size(); i++) result[i] = crosses[i];
+  return result;
+}
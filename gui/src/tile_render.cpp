@@ -0,0 +1,342 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Batch rendering of XYZ chart tiles through a chart canvas
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include <wx/wxprec.h>
+
+#ifndef WX_PRECOMP
+#include <wx/wx.h>
+#endif
+
+#include <wx/filename.h>
+#include <wx/image.h>
+#include <wx/mstream.h>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+
+#include "model/xyz_tiles.h"
+
+#include "chcanv.h"
+#include "color_handler.h"
+#include "OCPNRegion.h"
+#include "Quilt.h"
+#include "tile_render.h"
+#include "viewport.h"
+
+/** Writes tiles as <root>/<z>/<x>/<y>.png. */
+class DirTileSink : public TileSink {
+public:
+  explicit DirTileSink(const std::string& root) : m_root(root) {}
+
+  bool Put(const TileId& tile, const std::vector<unsigned char>& png) override {
+    wxFileName path(m_root, "");
+    path.AppendDir(std::to_string(tile.z));
+    path.AppendDir(std::to_string(tile.x));
+    path.SetFullName(std::to_string(tile.y) + ".png");
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (!path.DirExists() &&
+          !path.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) {
+        wxLogWarning("Cannot create tile directory %s", path.GetPath());
+        return false;
+      }
+    }
+    std::ofstream stream(path.GetFullPath().ToStdString(), std::ios::binary);
+    stream.write(reinterpret_cast<const char*>(png.data()), png.size());
+    return stream.good();
+  }
+
+private:
+  const std::string m_root;
+  std::mutex m_mutex;
+};
+
+/**
+ * Writes tiles to a MBTiles 1.3 file in one transaction. Existing tiles
+ * are replaced.
+ */
+class MbtilesTileSink : public TileSink {
+public:
+  explicit MbtilesTileSink(const TileRenderSpec& spec)
+      : m_db(spec.output, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE) {
+    m_db.exec(
+        "CREATE TABLE IF NOT EXISTS metadata (name TEXT, value TEXT);"
+        "CREATE UNIQUE INDEX IF NOT EXISTS name ON metadata (name);"
+        "CREATE TABLE IF NOT EXISTS tiles (zoom_level INTEGER, "
+        "tile_column INTEGER, tile_row INTEGER, tile_data BLOB);"
+        "CREATE UNIQUE INDEX IF NOT EXISTS tile_index ON tiles "
+        "(zoom_level, tile_column, tile_row);");
+    m_transaction.reset(new SQLite::Transaction(m_db));
+
+    char bounds[128];
+    snprintf(bounds, sizeof(bounds), "%.6f,%.6f,%.6f,%.6f", spec.lon_min,
+             spec.lat_min, spec.lon_max, spec.lat_max);
+    wxFileName fn(spec.output);
+    SetMetadata("name", fn.GetName().ToStdString());
+    SetMetadata("format", "png");
+    SetMetadata("type", "baselayer");
+    SetMetadata("bounds", bounds);
+    SetMetadata("minzoom", std::to_string(spec.zmin));
+    SetMetadata("maxzoom", std::to_string(spec.zmax));
+  }
+
+  bool Put(const TileId& tile, const std::vector<unsigned char>& png) override {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    try {
+      SQLite::Statement insert(m_db,
+                               "INSERT OR REPLACE INTO tiles VALUES (?,?,?,?)");
+      insert.bind(1, tile.z);
+      insert.bind(2, tile.x);
+      insert.bind(3, (1 << tile.z) - 1 - tile.y);  // TMS rows count from south
+      insert.bind(4, png.data(), static_cast<int>(png.size()));
+      insert.exec();
+    } catch (std::exception& ex) {
+      wxLogWarning("Cannot write tile %d/%d/%d: %s", tile.z, tile.x, tile.y,
+                   ex.what());
+      return false;
+    }
+    return true;
+  }
+
+  bool Close() override {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_transaction) return true;
+    try {
+      m_transaction->commit();
+    } catch (std::exception& ex) {
+      wxLogWarning("Cannot commit tiles: %s", ex.what());
+      return false;
+    }
+    m_transaction.reset();
+    return true;
+  }
+
+private:
+  void SetMetadata(const std::string& name, const std::string& value) {
+    SQLite::Statement insert(m_db,
+                             "INSERT OR REPLACE INTO metadata VALUES (?,?)");
+    insert.bind(1, name);
+    insert.bind(2, value);
+    insert.exec();
+  }
+
+  SQLite::Database m_db;
+  std::unique_ptr<SQLite::Transaction> m_transaction;
+  std::mutex m_mutex;
+};
+
+std::unique_ptr<TileSink> TileSink::Create(const TileRenderSpec& spec) {
+  try {
+    if (spec.IsMbtiles())
+      return std::unique_ptr<TileSink>(new MbtilesTileSink(spec));
+  } catch (std::exception& ex) {
+    wxLogWarning("Cannot open %s: %s", spec.output.c_str(), ex.what());
+    return nullptr;
+  }
+  if (!wxFileName::Mkdir(spec.output, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) {
+    wxLogWarning("Cannot create tile directory %s", spec.output.c_str());
+    return nullptr;
+  }
+  return std::unique_ptr<TileSink>(new DirTileSink(spec.output));
+}
+
+/** A rendered RGB tile waiting for PNG encoding. */
+struct RenderedTile {
+  explicit RenderedTile(const TileId& t) : tile(t) {}
+  TileId tile;
+  std::vector<unsigned char> rgb;
+};
+
+/**
+ * Bounded queue feeding the encoder threads, Push() blocks the renderer
+ * when the encoders fall behind to cap memory usage.
+ */
+class TileEncoderPool {
+public:
+  TileEncoderPool(TileSink& sink, int tile_size)
+      : m_sink(sink), m_tile_size(tile_size), m_done(false), m_errors(0) {
+    unsigned n = std::max(std::thread::hardware_concurrency(), 1u);
+    m_max_queued = 4 * n;
+    for (unsigned i = 0; i < n; i++)
+      m_threads.emplace_back([this] { Worker(); });
+  }
+
+  ~TileEncoderPool() { Finish(); }
+
+  void Push(RenderedTile&& tile) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_not_full.wait(lock, [&] { return m_queue.size() < m_max_queued; });
+    m_queue.push_back(std::move(tile));
+    m_not_empty.notify_one();
+  }
+
+  /** Wait until all tiles are written, return number of failed tiles. */
+  int Finish() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_done = true;
+    }
+    m_not_empty.notify_all();
+    for (auto& t : m_threads) t.join();
+    m_threads.clear();
+    return m_errors;
+  }
+
+private:
+  void Worker() {
+    while (true) {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_not_empty.wait(lock, [&] { return m_done || !m_queue.empty(); });
+      if (m_queue.empty()) return;
+      RenderedTile tile = std::move(m_queue.front());
+      m_queue.pop_front();
+      m_not_full.notify_one();
+      lock.unlock();
+
+      // Each thread uses its own wxImage over the raw data, wxImage
+      // reference counting is not thread safe.
+      wxImage image(m_tile_size, m_tile_size, tile.rgb.data(), true);
+      wxMemoryOutputStream stream;
+      std::vector<unsigned char> png;
+      if (image.SaveFile(stream, wxBITMAP_TYPE_PNG)) {
+        png.resize(stream.GetSize());
+        stream.CopyTo(png.data(), png.size());
+      }
+      if (png.empty() || !m_sink.Put(tile.tile, png)) m_errors++;
+    }
+  }
+
+  TileSink& m_sink;
+  const int m_tile_size;
+  size_t m_max_queued;
+  bool m_done;
+  std::atomic<int> m_errors;
+  std::mutex m_mutex;
+  std::condition_variable m_not_empty;
+  std::condition_variable m_not_full;
+  std::deque<RenderedTile> m_queue;
+  std::vector<std::thread> m_threads;
+};
+
+TileRenderer::TileRenderer(ChartCanvas* canvas, int tile_size)
+    : m_canvas(canvas), m_tile_size(tile_size) {}
+
+bool TileRenderer::RenderTile(const TileId& tile,
+                              std::vector<unsigned char>& rgb) {
+  ViewPort& vp = m_canvas->GetVP();
+  vp.Invalidate();
+  m_canvas->SetViewPoint(TileYToLat(tile.y + 0.5, tile.z),
+                         TileXToLon(tile.x + 0.5, tile.z),
+                         TileScalePpm(tile.z, m_tile_size), 0, 0,
+                         PROJECTION_MERCATOR, false, false);
+  Quilt* quilt = m_canvas->m_pQuilt;
+  if (vp.m_projection_type != PROJECTION_MERCATOR) {
+    // Quilt picked a chart with its own projection, force web mercator.
+    vp.b_MercatorProjectionOverride = true;
+    vp.SetProjectionType(PROJECTION_MERCATOR);
+    vp.SetBoxes();
+    quilt->Compose(vp);
+  }
+  if (!quilt->IsComposed() || quilt->GetnCharts() == 0) return false;
+
+  wxBitmap bitmap(m_tile_size, m_tile_size);
+  wxMemoryDC dc(bitmap);
+  dc.SetBackground(wxBrush(GetGlobalColor("NODTA")));
+  dc.Clear();
+  ViewPort svp = vp;
+  OCPNRegion region(wxRect(0, 0, m_tile_size, m_tile_size));
+  quilt->RenderQuiltRegionViewOnDCNoText(dc, svp, region);
+  quilt->RenderQuiltRegionViewOnDCTextOnly(dc, svp, region);
+  dc.SelectObject(wxNullBitmap);
+
+  wxImage image = bitmap.ConvertToImage();
+  const unsigned char* data = image.GetData();
+  rgb.assign(data, data + 3 * m_tile_size * m_tile_size);
+  return true;
+}
+
+int TileRenderer::Run(const TileRenderSpec& spec) {
+  auto tiles = TilesInBox(spec.lat_min, spec.lon_min, spec.lat_max,
+                          spec.lon_max, spec.zmin, spec.zmax);
+  if (tiles.empty()) {
+    wxLogWarning("No tiles to render, or more than %d",
+                 static_cast<int>(kMaxTilesInBox));
+    return -1;
+  }
+  std::unique_ptr<TileSink> sink = TileSink::Create(spec);
+  if (!sink) return -1;
+  wxLogMessage("Rendering %d tiles to %s", static_cast<int>(tiles.size()),
+               spec.output.c_str());
+
+  ViewPort saved_vp = m_canvas->GetVP();
+  bool saved_quilt = m_canvas->GetQuiltMode();
+  if (!saved_quilt) m_canvas->SetQuiltMode(true);
+  ViewPort& vp = m_canvas->GetVP();
+  vp.pix_width = m_tile_size;
+  vp.pix_height = m_tile_size;
+
+  int rendered = 0;
+  int errors;
+  {
+    TileEncoderPool pool(*sink, m_tile_size);
+    for (size_t i = 0; i < tiles.size(); i++) {
+      RenderedTile tile(tiles[i]);
+      if (!RenderTile(tiles[i], tile.rgb)) continue;
+      pool.Push(std::move(tile));
+      rendered++;
+      if (rendered % 1000 == 0)
+        wxLogMessage("Rendered %d of %d tiles", static_cast<int>(i + 1),
+                     static_cast<int>(tiles.size()));
+    }
+    errors = pool.Finish();
+  }
+  bool closed = sink->Close();
+
+  vp.pix_width = saved_vp.pix_width;
+  vp.pix_height = saved_vp.pix_height;
+  if (!saved_quilt) m_canvas->SetQuiltMode(false);
+  m_canvas->LoadVP(saved_vp);
+
+  wxLogMessage("Wrote %d tiles, %d without chart data, %d failed",
+               rendered - errors, static_cast<int>(tiles.size()) - rendered,
+               errors);
+  return closed ? rendered - errors : -1;
+}
+
+bool RenderTiles(ChartCanvas* canvas, const std::string& spec) {
+  TileRenderSpec render_spec;
+  std::string error = render_spec.Parse(spec);
+  if (!error.empty()) {
+    wxLogWarning("Bad tile render spec %s: %s", spec.c_str(), error.c_str());
+    return false;
+  }
+  return TileRenderer(canvas).Run(render_spec) >= 0;
+}
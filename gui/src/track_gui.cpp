@@ -1,3 +1,4 @@
+#include <cmath>
 #include <list>
 
 #include <wx/colour.h>
@@ -6,11 +7,17 @@
 
 #include "color_handler.h"
 #include "navutil.h"
+#include "model/config_vars.h"
 #include "model/own_ship.h"
 #include "model/routeman.h"
+#include "model/track_geometry.h"
 #include "track_gui.h"
 #include "glChartCanvas.h"
 
+#ifdef ocpnUSE_GL
+#include "shaders.h"
+#endif
+
 extern Routeman* g_pRouteMan;
 extern wxColour g_colourTrackLineColour;
 
@@ -97,7 +104,44 @@ void TrackGui::GetPointLists(ChartCanvas *cc,
   if (!m_track.IsVisible() || m_track.GetnPoints() == 0) return;
   Finalize();
   //    OCPNStopWatch sw;
-  Segments(cc, pointlists, box, VP.view_scale_ppm);
+  std::vector<int> points;
+  Segments(points, box, VP.view_scale_ppm);
+
+  //    Add last segment, dynamically, maybe.....
+  // we should not add this segment if it is not on the screen...
+  if (m_track.IsRunning()) {
+    points.push_back(-1);
+    points.push_back(m_track.TrackPoints.size() - 1);
+  }
+
+  //  Project the selected track points in one batch
+  std::vector<double> lat, lon;
+  lat.reserve(points.size() + 1);
+  lon.reserve(points.size() + 1);
+  for (int n : points) {
+    if (n >= 0 && (size_t)n < m_track.TrackPoints.size()) {
+      lat.push_back(m_track.TrackPoints[n]->m_lat);
+      lon.push_back(m_track.TrackPoints[n]->m_lon);
+    }
+  }
+  if (m_track.IsRunning()) {
+    lat.push_back(gLat);
+    lon.push_back(gLon);
+  }
+  std::vector<wxPoint> pix(lat.size());
+  if (pix.size()) cc->GetCanvasPointPix(&lat[0], &lon[0], pix.size(), &pix[0]);
+
+  size_t ipix = 0;
+  for (int n : points) {
+    if (n < 0) {
+      std::list<wxPoint> new_list;
+      pointlists.push_back(new_list);
+      continue;
+    }
+    wxPoint r(INVALID_COORD, INVALID_COORD);
+    if ((size_t)n < m_track.TrackPoints.size()) r = pix[ipix++];
+    AddPointToList(pointlists, r);
+  }
 #if 0
     if(GetnPoints() > 40000) {
         double t = sw.GetTime();
@@ -112,24 +156,12 @@ void TrackGui::GetPointLists(ChartCanvas *cc,
     }
 #endif
 
-  //    Add last segment, dynamically, maybe.....
-  // we should not add this segment if it is not on the screen...
-  if (m_track.IsRunning()) {
-    std::list<wxPoint> new_list;
-    pointlists.push_back(new_list);
-    AddPointToList(cc, pointlists, m_track.TrackPoints.size() - 1);
-    wxPoint r;
-    cc->GetCanvasPointPix(gLat, gLon, &r);
-    pointlists.back().push_back(r);
-  }
+  if (m_track.IsRunning()) pointlists.back().push_back(pix[ipix]);
 }
 
 void TrackGui::Draw(ChartCanvas* cc, ocpnDC& dc, ViewPort& VP,
                     const LLBBox& box) {
-  std::list<std::list<wxPoint> > pointlists;
-  GetPointLists(cc, pointlists, VP, box);
-
-  if (!pointlists.size()) return;
+  if (!m_track.IsVisible() || m_track.GetnPoints() == 0) return;
 
   //  Establish basic colour
   wxColour basic_colour;
@@ -168,6 +200,18 @@ void TrackGui::Draw(ChartCanvas* cc, ocpnDC& dc, ViewPort& VP,
     if (scale  < 0.004) radius = 0;
   }
 
+  if (DrawGL(cc, dc, col, width, style, radius)) {
+    if (m_track.m_HighlightedTrackPoint >= 0)
+      TrackPointGui(m_track.TrackPoints[m_track.m_HighlightedTrackPoint])
+          .Draw(cc, dc);
+    return;
+  }
+
+  std::list<std::list<wxPoint> > pointlists;
+  GetPointLists(cc, pointlists, VP, box);
+
+  if (!pointlists.size()) return;
+
   {
     wxPen p = *wxThePenList->FindOrCreatePen(col, width, style);
 #ifdef ocpnUSE_GL
@@ -215,22 +259,160 @@ void TrackGui::Draw(ChartCanvas* cc, ocpnDC& dc, ViewPort& VP,
     TrackPointGui(m_track.TrackPoints[m_track.m_HighlightedTrackPoint]).Draw(cc, dc);
 }
 
+/* Draws the track from the cached mercator geometry at the level of detail
+   of the view scale. Each chunk is a vertex buffer placed on the canvas by
+   TransformMatrix, so no track point is projected while panning or
+   zooming. Returns false if the cache does not apply and the track must
+   be drawn from point lists. */
+bool TrackGui::DrawGL(ChartCanvas* cc, ocpnDC& dc, const wxColour& col,
+                      int width, wxPenStyle style, int hilite_width) {
+#if defined(ocpnUSE_GL) && defined(ocpnUSE_GLSL)
+  ViewPort& vp = cc->GetVP();
+  if (dc.GetDC() || style != wxPENSTYLE_SOLID) return false;
+  if (vp.m_projection_type != PROJECTION_MERCATOR &&
+      vp.m_projection_type != PROJECTION_WEB_MERCATOR)
+    return false;
+  if (dc.m_canvasIndex < 0 || dc.m_canvasIndex > 1) return false;
+  GLShaderProgram* shader = pcolor_tri_shader_program[dc.m_canvasIndex];
+  if (!shader) return false;
+
+  // Wide lines are drawn from triangles by ocpnDC
+  GLint parms[2];
+  glGetIntegerv(GL_SMOOTH_LINE_WIDTH_RANGE, &parms[0]);
+  if (glGetError()) glGetIntegerv(GL_ALIASED_LINE_WIDTH_RANGE, &parms[0]);
+  if (wxMax(width, hilite_width) > parms[1]) return false;
+
+  std::vector<unsigned> released = TrackGeometry::TakeReleasedBuffers();
+  if (released.size()) glDeleteBuffers(released.size(), released.data());
+
+  TrackGeometry& geometry = m_track.m_geometry;
+  geometry.Update(m_track.TrackPoints);
+  int level = TrackGeometry::LevelForScale(vp.view_scale_ppm);
+  std::vector<TrackGeometry::Chunk>& chunks = geometry.GetChunks(level);
+
+  //  Chunks on screen with their mapping from mercator meters to pixels:
+  //  x = x0 + a * e + b * n, y = y0 + b * e - a * n
+  struct Placed {
+    TrackGeometry::Chunk* chunk;
+    double x0, y0;
+  };
+  std::vector<Placed> placed;
+  double a = vp.view_scale_ppm * cos(vp.rotation);
+  double b = vp.view_scale_ppm * sin(vp.rotation);
+  double margin = wxMax(width, hilite_width);
+  for (TrackGeometry::Chunk& chunk : chunks) {
+    if (chunk.Count() < 2) continue;
+    wxPoint2DDouble p0 = vp.GetDoublePixFromLL(chunk.ref_lat, chunk.ref_lon);
+    double ex[2] = {chunk.min_x, chunk.max_x};
+    double ny[2] = {chunk.min_y, chunk.max_y};
+    double xmin = INFINITY, xmax = -INFINITY, ymin = INFINITY, ymax = -INFINITY;
+    for (double e : ex) {
+      for (double n : ny) {
+        double x = p0.m_x + a * e + b * n, y = p0.m_y + b * e - a * n;
+        xmin = wxMin(xmin, x), xmax = wxMax(xmax, x);
+        ymin = wxMin(ymin, y), ymax = wxMax(ymax, y);
+      }
+    }
+    if (xmax < -margin || ymax < -margin || xmin > vp.pix_width + margin ||
+        ymin > vp.pix_height + margin)
+      continue;
+
+    if (!chunk.buffer) {
+      glGenBuffers(1, &chunk.buffer);
+      chunk.dirty = true;
+    }
+    if (chunk.dirty) {
+      glBindBuffer(GL_ARRAY_BUFFER, chunk.buffer);
+      glBufferData(GL_ARRAY_BUFFER, chunk.xy.size() * sizeof(float),
+                   chunk.xy.data(), GL_DYNAMIC_DRAW);
+      chunk.dirty = false;
+    }
+    placed.push_back({&chunk, p0.m_x, p0.m_y});
+  }
+
+  //  Coarse levels may skip the last points, close the gap to the end of
+  //  the track and on to the ship while running
+  std::vector<wxPoint> tail;
+  int last = m_track.TrackPoints.size() - 1;
+  int kept = geometry.LastKept(level);
+  wxPoint r;
+  if (kept >= 0 && kept < last) {
+    cc->GetCanvasPointPix(m_track.TrackPoints[kept]->m_lat,
+                          m_track.TrackPoints[kept]->m_lon, &r);
+    tail.push_back(r);
+  }
+  if (tail.size() || m_track.IsRunning()) {
+    cc->GetCanvasPointPix(m_track.TrackPoints[last]->m_lat,
+                          m_track.TrackPoints[last]->m_lon, &r);
+    tail.push_back(r);
+  }
+  if (m_track.IsRunning()) {
+    cc->GetCanvasPointPix(gLat, gLon, &r);
+    tail.push_back(r);
+  }
+
+  wxColor trackLine_dim_colour = GetDimColor(g_colourTrackLineColour);
+  wxColour hilt(trackLine_dim_colour.Red(), trackLine_dim_colour.Green(),
+                trackLine_dim_colour.Blue(), 128);
+
+  auto stroke = [&](const wxColour& c, int w) {
+    ocpnDC::SetGLAttrs(true);
+    glLineWidth(wxMax(g_GLMinSymbolLineWidth, w));
+    shader->Bind();
+    float colorv[4];
+    colorv[0] = c.Red() / float(256);
+    colorv[1] = c.Green() / float(256);
+    colorv[2] = c.Blue() / float(256);
+    colorv[3] = c.Alpha() / float(256);
+    shader->SetUniform4fv("color", colorv);
+
+    mat4x4 m;
+    for (const Placed& p : placed) {
+      mat4x4_identity(m);
+      m[0][0] = a, m[0][1] = b;
+      m[1][0] = b, m[1][1] = -a;
+      m[3][0] = p.x0, m[3][1] = p.y0;
+      shader->SetUniformMatrix4fv("TransformMatrix", (GLfloat*)m);
+
+      // With the buffer bound the attribute pointer is an offset into it
+      glBindBuffer(GL_ARRAY_BUFFER, p.chunk->buffer);
+      shader->SetAttributePointerf("position", nullptr);
+      glDrawArrays(GL_LINE_STRIP, 0, p.chunk->Count());
+    }
+    mat4x4_identity(m);
+    shader->SetUniformMatrix4fv("TransformMatrix", (GLfloat*)m);
+    shader->UnBind();
+
+    if (tail.size() > 1) {
+      dc.SetPen(*wxThePenList->FindOrCreatePen(c, w, wxPENSTYLE_SOLID));
+      dc.StrokeLines(tail.size(), tail.data());
+    }
+    glDisable(GL_LINE_SMOOTH);
+    glDisable(GL_POLYGON_SMOOTH);
+    glDisable(GL_BLEND);
+  };
+
+  if (hilite_width >= 1) stroke(hilt, hilite_width);
+  stroke(col, width);
+  return true;
+#else
+  return false;
+#endif
+}
+
 // Entry to recursive Assemble at the head of the SubTracks tree
-void TrackGui::Segments(ChartCanvas *cc,
-                        std::list<std::list<wxPoint> > &pointlists,
-                        const LLBBox &box, double scale) {
+void TrackGui::Segments(std::vector<int> &points, const LLBBox &box,
+                        double scale) {
   if (!m_track.SubTracks.size()) return;
 
   int level = m_track.SubTracks.size() - 1, last = -2;
-  Assemble(cc, pointlists, box, 1 / scale / scale, last, level, 0);
+  Assemble(points, box, 1 / scale / scale, last, level, 0);
 }
 
-/* assembles lists of line strips from the given track recursively traversing
-   the subtracks data */
-void TrackGui::Assemble(ChartCanvas *cc,
-                        std::list<std::list<wxPoint> > &pointlists,
-                        const LLBBox &box, double scale, int &last, int level,
-                        int pos) {
+/* assembles the indices of the points of the line strips to draw,
+   recursively traversing the subtracks data. -1 starts a new line strip */
+void TrackGui::Assemble(std::vector<int> &points, const LLBBox &box,
+                        double scale, int &last, int level, int pos) {
   if (pos == (int)m_track.SubTracks[level].size()) return;
 
   SubTrack &s = m_track.SubTracks[level][pos];
@@ -239,26 +421,19 @@ void TrackGui::Assemble(ChartCanvas *cc,
   if (s.m_scale < scale) {
     pos <<= level;
 
-    if (last < pos - 1) {
-      std::list<wxPoint> new_list;
-      pointlists.push_back(new_list);
-    }
+    if (last < pos - 1) points.push_back(-1);
 
-    if (last < pos) AddPointToList(cc, pointlists, pos);
+    if (last < pos) points.push_back(pos);
     last = wxMin(pos + (1 << level), m_track.TrackPoints.size() - 1);
-    AddPointToList(cc, pointlists, last);
+    points.push_back(last);
   } else {
-    Assemble(cc, pointlists, box, scale, last, level - 1, pos << 1);
-    Assemble(cc, pointlists, box, scale, last, level - 1, (pos << 1) + 1);
+    Assemble(points, box, scale, last, level - 1, pos << 1);
+    Assemble(points, box, scale, last, level - 1, (pos << 1) + 1);
   }
 }
 
-void TrackGui::AddPointToList(ChartCanvas *cc,
-                              std::list<std::list<wxPoint> > &pointlists, int n) {
-  wxPoint r(INVALID_COORD, INVALID_COORD);
-  if ((size_t)n < m_track.TrackPoints.size())
-    cc->GetCanvasPointPix(m_track.TrackPoints[n]->m_lat, m_track.TrackPoints[n]->m_lon, &r);
-
+void TrackGui::AddPointToList(std::list<std::list<wxPoint> > &pointlists,
+                              const wxPoint &r) {
   std::list<wxPoint> &pointlist = pointlists.back();
   if (r.x == INVALID_COORD) {
     if (pointlist.size()) {
@@ -35,6 +35,8 @@
 #include <wx/clipbrd.h>
 #include <wx/aui/aui.h>
 
+#include <list>
+
 #if defined(__OCPN__ANDROID__)
 #include <GLES2/gl2.h>
 #elif defined(__WXQT__) || defined(__WXGTK__)
@@ -50,6 +52,7 @@
 #include "chcanv.h"
 #include "TCWin.h"
 #include "model/geodesic.h"
+#include "model/georef_batch.h"
 #include "styles.h"
 #include "model/routeman.h"
 #include "navutil.h"
@@ -109,6 +112,7 @@ extern struct sigaction sa_all_old;
 extern sigjmp_buf env;  // the context saved by sigsetjmp();
 #endif
 
+#include <algorithm>
 #include <vector>
 
 // ----------------------------------------------------------------------------
@@ -152,41 +156,11 @@ wxPoint ViewPort::GetPixFromLL(double lat, double lon) {
 wxPoint2DDouble ViewPort::GetDoublePixFromLL(double lat, double lon) {
   double easting = 0;
   double northing = 0;
-  double xlon = lon;
 
   /*  Make sure lon and lon0 are same phase */
-  if (xlon * clon < 0.) {
-    if (xlon < 0.)
-      xlon += 360.;
-    else
-      xlon -= 360.;
-  }
+  double xlon = PhaseLongitude(lon, clon);
 
-  if (fabs(xlon - clon) > 180.) {
-    if (xlon > clon)
-      xlon -= 360.;
-    else
-      xlon += 360.;
-  }
-
-  // update cache of trig functions used for projections
-  if (clat != lat0_cache) {
-    lat0_cache = clat;
-    switch (m_projection_type) {
-      case PROJECTION_MERCATOR:
-      case PROJECTION_WEB_MERCATOR:
-        cache0 = toSMcache_y30(clat);
-        break;
-      case PROJECTION_POLAR:
-        cache0 = toPOLARcache_e(clat);
-        break;
-      case PROJECTION_ORTHOGRAPHIC:
-      case PROJECTION_STEREOGRAPHIC:
-      case PROJECTION_GNOMONIC:
-        cache_phi0(clat, &cache0, &cache1);
-        break;
-    }
-  }
+  UpdateProjectionCache();
 
   switch (m_projection_type) {
     case PROJECTION_MERCATOR:
@@ -245,23 +219,111 @@ wxPoint2DDouble ViewPort::GetDoublePixFromLL(double lat, double lon) {
       printf("unhandled projection\n");
   }
 
-  if (!wxFinite(easting) || !wxFinite(northing))
-    return wxPoint2DDouble(easting, northing);
+  //    Scale, apply VP Rotation and center
+  double x, y;
+  ProjectedToPix(view_scale_ppm, rotation, pix_width / 2.0, pix_height / 2.0)
+      .Apply(easting, northing, &x, &y);
+  return wxPoint2DDouble(x, y);
+}
+
+void ViewPort::UpdateProjectionCache() {
+  // update cache of trig functions used for projections
+  if (clat != lat0_cache) {
+    lat0_cache = clat;
+    switch (m_projection_type) {
+      case PROJECTION_MERCATOR:
+      case PROJECTION_WEB_MERCATOR:
+        cache0 = toSMcache_y30(clat);
+        break;
+      case PROJECTION_POLAR:
+        cache0 = toPOLARcache_e(clat);
+        break;
+      case PROJECTION_ORTHOGRAPHIC:
+      case PROJECTION_STEREOGRAPHIC:
+      case PROJECTION_GNOMONIC:
+        cache_phi0(clat, &cache0, &cache1);
+        break;
+    }
+  }
+}
+
+//  Batch projection.
+//  Uses the batch forms of the projections and the same pixel transform
+//  as the single point GetDoublePixFromLL(), see model/georef_batch.h, so
+//  both give bit identical results and polylines projected either way line
+//  up.
 
-  double epix = easting * view_scale_ppm;
-  double npix = northing * view_scale_ppm;
-  double dxr = epix;
-  double dyr = npix;
+#define PROJECT_BLOCK 64
 
-  //    Apply VP Rotation
-  double angle = rotation;
+void ViewPort::GetDoublePixFromLL(const double *lat, const double *lon,
+                                  int count, wxPoint2DDouble *r) {
+  double easting[PROJECT_BLOCK], northing[PROJECT_BLOCK];
+  double x[PROJECT_BLOCK], y[PROJECT_BLOCK];
 
-  if (angle) {
-    dxr = epix * cos(angle) + npix * sin(angle);
-    dyr = npix * cos(angle) - epix * sin(angle);
+  switch (m_projection_type) {
+    case PROJECTION_MERCATOR:
+    case PROJECTION_WEB_MERCATOR:
+    case PROJECTION_POLAR:
+    case PROJECTION_STEREOGRAPHIC:
+    case PROJECTION_ORTHOGRAPHIC:
+    case PROJECTION_GNOMONIC:
+    case PROJECTION_EQUIRECTANGULAR:
+      break;
+    default:
+      for (int i = 0; i < count; i++)
+        r[i] = GetDoublePixFromLL(lat[i], lon[i]);
+      return;
   }
 
-  return wxPoint2DDouble((pix_width / 2.0) + dxr, (pix_height / 2.0) - dyr);
+  UpdateProjectionCache();
+  ProjectedToPix to_pix(view_scale_ppm, rotation, pix_width / 2.0,
+                        pix_height / 2.0);
+
+  for (int i = 0; i < count; i += PROJECT_BLOCK) {
+    int n = std::min(PROJECT_BLOCK, count - i);
+    ProjectBlock(lat + i, lon + i, n, easting, northing);
+    to_pix.Apply(easting, northing, n, x, y);
+    for (int j = 0; j < n; j++) r[i + j] = wxPoint2DDouble(x[j], y[j]);
+  }
+}
+
+void ViewPort::ProjectBlock(const double *lat, const double *lon, int count,
+                            double *easting, double *northing) {
+  double xlon[PROJECT_BLOCK];
+  PhaseLongitudes(lon, count, clon, xlon);
+
+  switch (m_projection_type) {
+    case PROJECTION_MERCATOR:
+    case PROJECTION_WEB_MERCATOR:
+      toSMcacheBatch(lat, xlon, count, cache0, clon, easting, northing);
+      break;
+
+    case PROJECTION_POLAR:
+      toPOLARBatch(lat, xlon, count, cache0, clat, clon, easting, northing);
+      break;
+
+    case PROJECTION_STEREOGRAPHIC:
+      toSTEREOBatch(lat, xlon, count, cache0, cache1, clon, easting,
+                    northing);
+      break;
+
+    case PROJECTION_ORTHOGRAPHIC:
+      for (int i = 0; i < count; i++)
+        toORTHO(lat[i], xlon[i], cache0, cache1, clon, &easting[i],
+                &northing[i]);
+      break;
+
+    case PROJECTION_GNOMONIC:
+      for (int i = 0; i < count; i++)
+        toGNO(lat[i], xlon[i], cache0, cache1, clon, &easting[i],
+              &northing[i]);
+      break;
+
+    case PROJECTION_EQUIRECTANGULAR:
+      for (int i = 0; i < count; i++)
+        toEQUIRECT(lat[i], xlon[i], clat, clon, &easting[i], &northing[i]);
+      break;
+  }
 }
 
 void ViewPort::GetLLFromPix(const wxPoint2DDouble &p, double *lat,
@@ -422,11 +484,11 @@ OCPNRegion ViewPort::GetVPRegionIntersect(const OCPNRegion &region,
   rotation = 0;
 
   std::list<ContourRegion> cregions;
-  for (std::list<poly_contour>::const_iterator i = llregion.contours.begin();
+  for (std::vector<poly_contour>::const_iterator i = llregion.contours.begin();
        i != llregion.contours.end(); i++) {
     float *contour_points = new float[2 * i->size()];
     int idx = 0;
-    std::list<contour_pt>::const_iterator j;
+    poly_contour::const_iterator j;
     for (j = i->begin(); j != i->end(); j++) {
       contour_points[idx++] = j->y;
       contour_points[idx++] = j->x;
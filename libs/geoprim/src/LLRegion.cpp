@@ -29,6 +29,9 @@
 #include <string.h>
 #include <math.h>
 
+#include <algorithm>
+#include <list>
+
 #if defined(__OCPN__ANDROID__)
  //#include <GLES2/gl2.h>
  #include <qopengl.h>
@@ -49,6 +52,9 @@
 #endif
 
 #include "LLRegion.h"
+#include "LOD_reduce.h"
+
+bool LLRegion::s_use_tessellator = false;
 
 static inline double cross(const contour_pt &v1, const contour_pt &v2) {
   return v1.y * v2.x - v1.x * v2.y;
@@ -83,6 +89,13 @@ LLRegion::LLRegion(size_t n, const float *points) {
 
 LLRegion::LLRegion(size_t n, const double *points) { InitPoints(n, points); }
 
+LLRegion::LLRegion(const FlatRegion &flat) {
+  for (size_t i = 0; i < flat.ContourCount(); i++) {
+    const contour_pt *points = flat.Contour(i);
+    contours.push_back(poly_contour(points, points + flat.ContourSize(i)));
+  }
+}
+
 // determine if a loop of points is counter clockwise
 bool LLRegion::PointsCCW(size_t n, const double *points) {
   double total = 0;
@@ -95,11 +108,9 @@ bool LLRegion::PointsCCW(size_t n, const double *points) {
 }
 
 void LLRegion::Print() const {
-  for (std::list<poly_contour>::const_iterator i = contours.begin();
-       i != contours.end(); i++) {
+  for (const auto &contour : contours) {
     printf("[");
-    for (poly_contour::const_iterator j = i->begin(); j != i->end(); j++)
-      printf("(%g %g) ", j->y, j->x);
+    for (const auto &p : contour) printf("(%g %g) ", p.y, p.x);
     printf("]\n");
   }
 }
@@ -108,12 +119,10 @@ void LLRegion::plot(const char *fn) const {
   char filename[100] = "/home/sean/";
   strcat(filename, fn);
   FILE *f = fopen(filename, "w");
-  for (std::list<poly_contour>::const_iterator i = contours.begin();
-       i != contours.end(); i++) {
-    for (poly_contour::const_iterator j = i->begin(); j != i->end(); j++)
-      fprintf(f, "%f %f\n", j->x, j->y);
+  for (const auto &contour : contours) {
+    for (const auto &p : contour) fprintf(f, "%f %f\n", p.x, p.y);
 
-    fprintf(f, "%f %f\n", i->begin()->x, i->begin()->y);
+    fprintf(f, "%f %f\n", contour.front().x, contour.front().y);
     fprintf(f, "\n");
   }
   fclose(f);
@@ -127,11 +136,10 @@ LLBBox LLRegion::GetBox() const {
   // there are 3 possible longitude bounds: -180 to 180, 0 to 360, -360 to 0
   double minlat = 90, minlon[3] = {180, 360, 0};
   double maxlat = -90, maxlon[3] = {-180, 0, -360};
-  for (std::list<poly_contour>::const_iterator i = contours.begin();
-       i != contours.end(); i++) {
+  for (const auto &contour : contours) {
     bool neg = false, pos = false;
-    for (poly_contour::const_iterator j = i->begin(); j != i->end(); j++)
-      if (j->x < 0)
+    for (const auto &p : contour)
+      if (p.x < 0)
         neg = true;
       else
         pos = true;
@@ -140,13 +148,13 @@ LLBBox LLRegion::GetBox() const {
     if (neg && !pos) resolved[1] = 360;
     if (pos && !neg) resolved[2] = -360;
 
-    for (poly_contour::const_iterator j = i->begin(); j != i->end(); j++) {
-      minlat = wxMin(minlat, j->y);
-      maxlat = wxMax(maxlat, j->y);
+    for (const auto &p : contour) {
+      minlat = wxMin(minlat, p.y);
+      maxlat = wxMax(maxlat, p.y);
 
       for (int k = 0; k < 3; k++) {
-        minlon[k] = wxMin(minlon[k], j->x + resolved[k]);
-        maxlon[k] = wxMax(maxlon[k], j->x + resolved[k]);
+        minlon[k] = wxMin(minlon[k], p.x + resolved[k]);
+        maxlon[k] = wxMax(maxlon[k], p.x + resolved[k]);
       }
     }
   }
@@ -210,11 +218,10 @@ bool LLRegion::Contains(float lat, float lon) const {
   if (lon > 180) return Contains(lat, lon - 360);
 
   int cnt = 0;
-  for (std::list<poly_contour>::const_iterator i = contours.begin();
-       i != contours.end(); i++) {
-    contour_pt l = *i->rbegin();
-    for (poly_contour::const_iterator j = i->begin(); j != i->end(); j++) {
-      contour_pt p = *j, a, b;
+  for (const auto &contour : contours) {
+    contour_pt l = contour.back();
+    for (const auto &p : contour) {
+      contour_pt a, b;
       if (p.x < l.x)
         a = p, b = l;
       else
@@ -308,6 +315,7 @@ void LLRegion::Intersect(const LLRegion &region) {
     return;
   }
 
+  if (Clip(region, ClipOp::kIntersect)) return;
   Put(region, GLU_TESS_WINDING_ABS_GEQ_TWO, false);
 }
 
@@ -317,44 +325,68 @@ void LLRegion::Union(const LLRegion &region) {
     return;
   }
 
+  if (Clip(region, ClipOp::kUnion)) return;
   Put(region, GLU_TESS_WINDING_POSITIVE, false);
 }
 
 void LLRegion::Subtract(const LLRegion &region) {
   if (NoIntersection(region)) return;
 
+  if (Clip(region, ClipOp::kSubtract)) return;
   Put(region, GLU_TESS_WINDING_POSITIVE, true);
 }
 
-void LLRegion::Reduce(double factor) {
-  double factor2 = factor * factor;
+FlatRegion LLRegion::ToFlat() const {
+  FlatRegion flat;
+  for (const auto &contour : contours)
+    flat.AddContour(contour.data(), contour.size());
+  return flat;
+}
+
+// scanline clipping on flat arrays, falls back to the tessellator if the
+// result boundary cannot be closed
+bool LLRegion::Clip(const LLRegion &region, ClipOp op) {
+  if (s_use_tessellator) return false;
 
-  std::list<poly_contour>::iterator i = contours.begin();
-  while (i != contours.end()) {
-    if (i->size() < 3) {
+  FlatRegion result;
+  if (!ClipRegions(ToFlat(), region.ToFlat(), op, result)) return false;
+
+  *this = LLRegion(result);
+  Optimize();
+  return true;
+}
+
+void LLRegion::Reduce(double factor) {
+  // reduce segments, contours are independent so they are simplified
+  // together on all cores
+  std::vector<LODLine> lines;
+  std::vector<poly_contour *> reduced;
+  for (auto &contour : contours) {
+    if (contour.size() < 3) {
       printf("invalid contour");
       continue;
     }
-
-    // reduce segments
-    contour_pt l = *i->rbegin();
-    poly_contour::iterator j = i->begin(), k;
-    while (j != i->end()) {
-      k = j;
-      j++;
-      if (dist2(vector(*k, l)) < factor2)
-        i->erase(k);
-      else
-        l = *k;
-    }
-
-    // erase zero contours
-    if (i->size() < 3)
-      i = contours.erase(i);
-    else
-      i++;
+    lines.emplace_back(&contour[0].y, 0, contour.size() - 1, factor);
+    reduced.push_back(&contour);
+  }
+  LODReduce(lines);
+
+  for (size_t i = 0; i < lines.size(); i++) {
+    poly_contour &contour = *reduced[i];
+    size_t n = 0;
+    for (size_t j = 0; j < contour.size(); j++)
+      if (lines[i].keep[j]) contour[n++] = contour[j];
+    contour.resize(n);
   }
 
+  // erase zero contours
+  contours.erase(std::remove_if(contours.begin(), contours.end(),
+                                [](const poly_contour &contour) {
+                                  return contour.size() < 3;
+                                }),
+                 contours.end());
+  m_box.Invalidate();
+
   // Optimize();
 }
 
@@ -368,7 +400,7 @@ bool LLRegion::NoIntersection(const LLBBox &box) const {
         return false;
 
     // test if any segment crosses the box
-    for(std::list<poly_contour>::const_iterator i = contours.begin(); i != contours.end(); i++) {
+    for(std::vector<poly_contour>::const_iterator i = contours.begin(); i != contours.end(); i++) {
         contour_pt l = *i->rbegin();
         int state = ComputeState(box, l), lstate = state;
         if(state == 4) return false;
@@ -453,16 +485,12 @@ bool LLRegion::NoIntersection(const LLRegion &region) const {
 }
 
 void LLRegion::PutContours(work &w, const LLRegion &region, bool reverse) {
-  for (std::list<poly_contour>::const_iterator i = region.contours.begin();
-       i != region.contours.end(); i++) {
+  for (const auto &contour : region.contours) {
     gluTessBeginContour(w.tobj);
     if (reverse)
-      for (poly_contour::const_reverse_iterator j = i->rbegin(); j != i->rend();
-           j++)
-        w.PutVertex(*j);
+      for (auto j = contour.rbegin(); j != contour.rend(); j++) w.PutVertex(*j);
     else
-      for (poly_contour::const_iterator j = i->begin(); j != i->end(); j++)
-        w.PutVertex(*j);
+      for (const auto &p : contour) w.PutVertex(p);
     gluTessEndContour(w.tobj);
   }
 }
@@ -495,9 +523,8 @@ void LLRegion::Put(const LLRegion &region, int winding_rule, bool reverse) {
 
 // same result as union, but only allowed if there is no intersection
 void LLRegion::Combine(const LLRegion &region) {
-  for (std::list<poly_contour>::const_iterator i = region.contours.begin();
-       i != region.contours.end(); i++)
-    contours.push_back(*i);
+  contours.insert(contours.end(), region.contours.begin(),
+                  region.contours.end());
   m_box.Invalidate();
 }
 
@@ -522,20 +549,18 @@ void LLRegion::InitPoints(size_t n, const double *points) {
     return;
   }
 
-  std::list<contour_pt> pts;
+  poly_contour pts;
+  pts.reserve(n);
   bool adjust = false;
 
-  bool ccw = PointsCCW(n, points);
   for (unsigned int i = 0; i < 2 * n; i += 2) {
     contour_pt p;
     p.y = points[i + 0];
     p.x = points[i + 1];
     if (p.x < -180 || p.x > 180) adjust = true;
-    if (ccw)
-      pts.push_back(p);
-    else
-      pts.push_front(p);
+    pts.push_back(p);
   }
+  if (!PointsCCW(n, points)) std::reverse(pts.begin(), pts.end());
 
   contours.push_back(pts);
 
@@ -551,68 +576,74 @@ void LLRegion::AdjustLongitude() {
   if (!resolved.Empty()) {
     Intersect(clip);
     // apply longitude offset
-    for (std::list<poly_contour>::iterator i = resolved.contours.begin();
-         i != resolved.contours.end(); i++)
-      for (poly_contour::iterator j = i->begin(); j != i->end(); j++)
-        if (j->x > 0)
-          j->x -= 360;
+    for (auto &contour : resolved.contours)
+      for (auto &p : contour)
+        if (p.x > 0)
+          p.x -= 360;
         else
-          j->x += 360;
+          p.x += 360;
     Union(resolved);
   }
   Intersect(clip);
 }
 
+static inline bool Collinear(const contour_pt &l, const contour_pt &j,
+                             const contour_pt &k) {
+  return fabs(cross(vector(j, l), vector(j, k))) < 1e-12;
+}
+
 void LLRegion::Optimize() {
   // merge parallel segments
-  std::list<poly_contour>::iterator i = contours.begin();
-  while (i != contours.end()) {
-    if (i->size() < 3) {
+  for (auto &contour : contours) {
+    if (contour.size() < 3) {
       printf("invalid contour");
       continue;
     }
 
     // Round coordinates to avoid numerical errors in region computations
     const double eps = 6e-6;  // about 1cm on earth's surface at equator
-    for (poly_contour::iterator j = i->begin(); j != i->end(); j++) {
-      // j->x -= fmod(j->x, 1e-8);
-      j->x = round(j->x / eps) * eps;
-      j->y = round(j->y / eps) * eps;
+    for (auto &p : contour) {
+      // p.x -= fmod(p.x, 1e-8);
+      p.x = round(p.x / eps) * eps;
+      p.y = round(p.y / eps) * eps;
     }
 
 #if 0
         // round toward 180 and -180 as this is where adjusted longitudes
         // are split, and so zero contours can get eliminated by the next step
-        for(poly_contour::iterator j = i->begin(); j != i->end(); j++)
-            if(fabs(j->x - 180) < 2e-4) j->x = 180;
-            else if(fabs(j->x + 180) < 2e-4) j->x = -180;
+        for(auto &p : contour)
+            if(fabs(p.x - 180) < 2e-4) p.x = 180;
+            else if(fabs(p.x + 180) < 2e-4) p.x = -180;
 #endif
 
-    // eliminiate parallel segments
-    poly_contour::iterator j = i->begin();
-    int s = i->size();
-    for (int c = 0; c < s; c++) {
-      poly_contour::iterator l = j, k = j;
-
-      if (l == i->begin()) l = i->end();
-      l--;
-
-      k++;
-      if (k == i->end()) k = i->begin();
-
-      if (l == k) break;
-      if (fabs(cross(vector(*j, *l), vector(*j, *k))) < 1e-12) {
-        i->erase(j);
-        j = l;
-        c--;
-      } else
-        j = k;
+    // eliminiate parallel segments, compacting in place
+    size_t n = 0;
+    for (size_t j = 0; j < contour.size(); j++) {
+      contour[n++] = contour[j];
+      while (n >= 3 &&
+             Collinear(contour[n - 3], contour[n - 2], contour[n - 1])) {
+        contour[n - 2] = contour[n - 1];
+        n--;
+      }
+    }
+    contour.resize(n);
+
+    // and across the closing segment
+    while (contour.size() >= 3) {
+      size_t m = contour.size();
+      if (Collinear(contour[m - 2], contour[m - 1], contour[0]))
+        contour.pop_back();
+      else if (Collinear(contour[m - 1], contour[0], contour[1]))
+        contour.erase(contour.begin());
+      else
+        break;
     }
-
-    // erase zero contours
-    if (i->size() < 3)
-      i = contours.erase(i);
-    else
-      i++;
   }
+
+  // erase zero contours
+  contours.erase(std::remove_if(contours.begin(), contours.end(),
+                                [](const poly_contour &contour) {
+                                  return contour.size() < 3;
+                                }),
+                 contours.end());
 }
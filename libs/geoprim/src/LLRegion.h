@@ -27,19 +27,16 @@
 #ifndef _LLREGION_H_
 #define _LLREGION_H_
 
-#include <list>
+#include <vector>
 
 #include "bbox.h"
-
-struct contour_pt {
-  double y, x;
-};
+#include "poly_clip.h"
 
 // ----------------------------------------------------------------------------
 // LLRegion
 // ----------------------------------------------------------------------------
 
-typedef std::list<contour_pt> poly_contour;
+typedef std::vector<contour_pt> poly_contour;
 class LLBBox;
 
 struct work;
@@ -50,6 +47,7 @@ public:
   LLRegion(const LLBBox& llbbox);
   LLRegion(size_t n, const float* points);
   LLRegion(size_t n, const double* points);
+  explicit LLRegion(const FlatRegion& flat);
 
   static bool PointsCCW(size_t n, const double* points);
 
@@ -70,13 +68,23 @@ public:
 
   void Reduce(double factor);
 
-  std::list<poly_contour> contours;
+  /** Copy of the contours in a single vertex array. */
+  FlatRegion ToFlat() const;
+
+  /**
+   * Use the GLU tessellator for Intersect(), Union() and Subtract() instead
+   * of ClipRegions(). Only meant for regression tests and benchmarks.
+   */
+  static void SetUseTessellator(bool use) { s_use_tessellator = use; }
+
+  std::vector<poly_contour> contours;
 
 private:
   bool NoIntersection(const LLBBox& box) const;
   bool NoIntersection(const LLRegion& region) const;
   void PutContours(work& w, const LLRegion& region, bool reverse = false);
   void Put(const LLRegion& region, int winding_rule, bool reverse = false);
+  bool Clip(const LLRegion& region, ClipOp op);
   void Combine(const LLRegion& region);
   void InitBox(float minlat, float minlon, float maxlat, float maxlon);
   void InitPoints(size_t n, const double* points);
@@ -84,6 +92,8 @@ private:
   void Optimize();
 
   LLBBox m_box;
+
+  static bool s_use_tessellator;
 };
 
 #endif
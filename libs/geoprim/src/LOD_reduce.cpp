@@ -24,178 +24,185 @@
  ***************************************************************************
  *
  */
-#include <stdio.h>
-#include <stdarg.h>
-#include <string.h>
-#include <math.h>
-#include <ctype.h>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <utility>
 #include <vector>
 
-#include "vector2D.h"
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOD_SSE2
+#endif
 
-void DouglasPeucker(double *PointList, int fp, int lp, double epsilon,
-                    std::vector<int> *keep) {
-  // Find the point with the maximum distance
-  double dmax = 0;
-  int index = 0;
+#include "LOD_reduce.h"
 
-  vector2D va(PointList[2 * fp] - PointList[2 * lp],
-              PointList[2 * fp + 1] - PointList[2 * lp + 1]);
+/** Below this many points per thread the parallel reduce stays serial. */
+static const size_t kPointsPerThread = 16384;
 
-  double da = va.x * va.x + va.y * va.y;
-  for (int i = fp + 1; i < lp; ++i) {
-    vector2D vb(PointList[2 * i] - PointList[2 * fp],
-                PointList[2 * i + 1] - PointList[2 * fp + 1]);
-
-    double dab = va.x * vb.x + va.y * vb.y;
-    double db = vb.x * vb.x + vb.y * vb.y;
-    double d = da - dab * dab / db;
-    if (d > dmax) {
-      index = i;
-      dmax = d;
-    }
+/**
+ * Return the index of the point of first + 1 .. last - 1 farthest from the
+ * segment first, last and its squared distance in d2max. Coordinates are
+ * separate arrays in c so that two points are handled per SSE2 operation.
+ * Ties go to the lowest index, like a plain loop.
+ */
+template <int D>
+static int Farthest(const double *const *c, int first, int last,
+                    double *d2max) {
+  double a[D], u[D], len2 = 0;
+  for (int k = 0; k < D; k++) {
+    a[k] = c[k][first];
+    u[k] = c[k][last] - a[k];
+    len2 += u[k] * u[k];
   }
-  // If max distance is greater than epsilon, recursively simplify
-  if (dmax > epsilon * epsilon) {
-    keep->push_back(index);
-
-    // Recursive call
-    DouglasPeucker(PointList, fp, index, epsilon, keep);
-    DouglasPeucker(PointList, index, lp, epsilon, keep);
+  // With first and last the same point the distance is to that point
+  double inv = len2 > 0 ? 1 / len2 : 0;
+
+  int index = first + 1;
+  double best = -1;
+  int i = first + 1;
+#ifdef LOD_SSE2
+  if (last - i >= 2) {
+    __m128d va[D], vu[D];
+    for (int k = 0; k < D; k++) {
+      va[k] = _mm_set1_pd(a[k]);
+      vu[k] = _mm_set1_pd(u[k]);
+    }
+    const __m128d vinv = _mm_set1_pd(inv);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1);
+    const __m128d two = _mm_set1_pd(2);
+    __m128d vbest = _mm_set1_pd(-1);
+    __m128d vi = _mm_set_pd(i + 1, i);
+    __m128d vindex = vi;
+    for (; i + 1 < last; i += 2) {
+      __m128d p[D];
+      __m128d dot = zero;
+      for (int k = 0; k < D; k++) {
+        p[k] = _mm_sub_pd(_mm_loadu_pd(c[k] + i), va[k]);
+        dot = _mm_add_pd(dot, _mm_mul_pd(p[k], vu[k]));
+      }
+      __m128d t = _mm_min_pd(_mm_max_pd(_mm_mul_pd(dot, vinv), zero), one);
+      __m128d d2 = zero;
+      for (int k = 0; k < D; k++) {
+        __m128d e = _mm_sub_pd(p[k], _mm_mul_pd(t, vu[k]));
+        d2 = _mm_add_pd(d2, _mm_mul_pd(e, e));
+      }
+      __m128d farther = _mm_cmpgt_pd(d2, vbest);
+      vbest = _mm_or_pd(_mm_and_pd(farther, d2), _mm_andnot_pd(farther, vbest));
+      vindex = _mm_or_pd(_mm_and_pd(farther, vi),
+                         _mm_andnot_pd(farther, vindex));
+      vi = _mm_add_pd(vi, two);
+    }
+    double lane_best[2], lane_index[2];
+    _mm_storeu_pd(lane_best, vbest);
+    _mm_storeu_pd(lane_index, vindex);
+    int lane = lane_best[1] > lane_best[0] ||
+               (lane_best[1] == lane_best[0] && lane_index[1] < lane_index[0]);
+    best = lane_best[lane];
+    index = static_cast<int>(lane_index[lane]);
   }
-}
-
-void DouglasPeuckerF(float *PointList, int fp, int lp, double epsilon,
-                     std::vector<int> *keep) {
-  // Find the point with the maximum distance
-  double dmax = 0;
-  int index = 0;
-
-  vector2D va(PointList[2 * fp] - PointList[2 * lp],
-              PointList[2 * fp + 1] - PointList[2 * lp + 1]);
-
-  double da = va.x * va.x + va.y * va.y;
-  for (int i = fp + 1; i < lp; ++i) {
-    vector2D vb(PointList[2 * i] - PointList[2 * fp],
-                PointList[2 * i + 1] - PointList[2 * fp + 1]);
-
-    double dab = va.x * vb.x + va.y * vb.y;
-    double db = vb.x * vb.x + vb.y * vb.y;
-    double d = da - dab * dab / db;
-    if (d > dmax) {
+#endif
+  for (; i < last; i++) {
+    double dot = 0, p[D];
+    for (int k = 0; k < D; k++) {
+      p[k] = c[k][i] - a[k];
+      dot += p[k] * u[k];
+    }
+    double t = std::min(std::max(dot * inv, 0.0), 1.0);
+    double d2 = 0;
+    for (int k = 0; k < D; k++) {
+      double e = p[k] - t * u[k];
+      d2 += e * e;
+    }
+    if (d2 > best) {
+      best = d2;
       index = i;
-      dmax = d;
     }
   }
-  // If max distance is greater than epsilon, recursively simplify
-  if (dmax > epsilon * epsilon) {
-    keep->push_back(index);
-
-    // Recursive call
-    DouglasPeuckerF(PointList, fp, index, epsilon, keep);
-    DouglasPeuckerF(PointList, index, lp, epsilon, keep);
-  }
+  *d2max = best;
+  return index;
 }
 
-void DouglasPeuckerFI(float *PointList, int fp, int lp, double epsilon,
-                      std::vector<bool> &keep) {
-  keep[fp] = true;
-  keep[lp] = true;
-
-  // Find the point with the maximum distance
-  double dmax = 0;
-  int maxdistIndex = -1;
-
-  vector2D va(PointList[2 * fp] - PointList[2 * lp],
-              PointList[2 * fp + 1] - PointList[2 * lp + 1]);
-
-  double da = va.x * va.x + va.y * va.y;
-  for (int i = fp + 1; i < lp; ++i) {
-    vector2D vb(PointList[2 * i] - PointList[2 * fp],
-                PointList[2 * i + 1] - PointList[2 * fp + 1]);
-
-    double dab = va.x * vb.x + va.y * vb.y;
-    double db = vb.x * vb.x + vb.y * vb.y;
-    double d = da - dab * dab / db;
-    if (d > dmax) {
-      maxdistIndex = i;
-      dmax = d;
-    }
-  }
-  // If max distance is greater than epsilon, recursively simplify
-  if (dmax > epsilon * epsilon) {
-    // Recursive call
-    DouglasPeuckerFI(PointList, fp, maxdistIndex, epsilon, keep);
-    DouglasPeuckerFI(PointList, maxdistIndex, lp, epsilon, keep);
+template <typename T>
+static void Reduce(const T *xy, int first, int last, double epsilon,
+                   std::vector<bool> &keep, int stride, int dim) {
+  if (last < first) return;
+  if (keep.size() <= static_cast<size_t>(last)) keep.resize(last + 1, false);
+  keep[first] = true;
+  keep[last] = true;
+  if (last - first < 2) return;
+
+  dim = dim == 3 ? 3 : 2;
+  int n = last - first + 1;
+  std::vector<double> coords[3];
+  const double *c[3] = {nullptr, nullptr, nullptr};
+  for (int k = 0; k < dim; k++) {
+    coords[k].resize(n);
+    for (int i = 0; i < n; i++)
+      coords[k][i] = xy[static_cast<size_t>(first + i) * stride + k];
+    c[k] = coords[k].data();
   }
-}
-
-void DouglasPeuckerDI(double *PointList, int fp, int lp, double epsilon,
-                      std::vector<bool> &keep) {
-  keep[fp] = true;
-  keep[lp] = true;
-
-  // Find the point with the maximum distance
-  double dmax = 0;
-  int maxdistIndex = -1;
-
-  vector2D va(PointList[3 * fp] - PointList[3 * lp],
-              PointList[3 * fp + 1] - PointList[3 * lp + 1]);
-  double da = sqrt(va.x * va.x + va.y * va.y);
-
-  double y2 = PointList[3 * lp + 1];
-  double y1 = PointList[3 * fp + 1];
-  double x2 = PointList[3 * lp];
-  double x1 = PointList[3 * fp];
-
-  for (int i = fp + 1; i < lp; ++i) {
-    // Distance from point to line.
-    // ref.  https://en.wikipedia.org/wiki/Distance_from_a_point_to_a_line
-    double d = (y2 - y1) * PointList[3 * i] - (x2 - x1) * PointList[3 * i + 1] +
-               (x2 * y1) - (y2 * x1);
-
-    d = fabs(d / da);
 
-    if (d > dmax) {
-      maxdistIndex = i;
-      dmax = d;
+  // Ranges still to split, instead of recursing
+  double epsilon2 = epsilon * epsilon;
+  std::vector<std::pair<int, int>> stack;
+  stack.emplace_back(0, n - 1);
+  while (!stack.empty()) {
+    std::pair<int, int> range = stack.back();
+    stack.pop_back();
+    if (range.second - range.first < 2) continue;
+
+    double d2;
+    int index = dim == 3 ? Farthest<3>(c, range.first, range.second, &d2)
+                         : Farthest<2>(c, range.first, range.second, &d2);
+    if (d2 > epsilon2) {
+      keep[first + index] = true;
+      stack.emplace_back(index, range.second);
+      stack.emplace_back(range.first, index);
     }
   }
-  // If max distance is greater than epsilon, recursively simplify
-  if (dmax > epsilon) {
-    // Recursive call
-    DouglasPeuckerDI(PointList, fp, maxdistIndex, epsilon, keep);
-    DouglasPeuckerDI(PointList, maxdistIndex, lp, epsilon, keep);
-  }
 }
 
-void DouglasPeuckerM(double *PointList, int fp, int lp, double epsilon,
-                     std::vector<int> *keep) {
-  // Find the point with the maximum distance
-  int index = 0;
-  double lmax = 0;
-
-  vector2D va(PointList[2 * fp] - PointList[2 * lp],
-              PointList[2 * fp + 1] - PointList[2 * lp + 1]);
+void LODReduce(const double *xy, int first, int last, double epsilon,
+               std::vector<bool> &keep, int stride, int dim) {
+  Reduce(xy, first, last, epsilon, keep, stride, dim);
+}
 
-  for (int i = fp + 1; i < lp; ++i) {
-    vector2D vb(PointList[2 * i] - PointList[2 * fp],
-                PointList[2 * i + 1] - PointList[2 * fp + 1]);
+void LODReduce(const float *xy, int first, int last, double epsilon,
+               std::vector<bool> &keep, int stride, int dim) {
+  Reduce(xy, first, last, epsilon, keep, stride, dim);
+}
 
-    vector2D vn;
-    double l = vGetLengthOfNormal(&vb, &va, &vn);
-    if (l > lmax) {
-      index = i;
-      lmax = l;
-    }
+void LODReduce(std::vector<LODLine> &lines) {
+  // Longest lines first, to balance the load
+  std::vector<size_t> order(lines.size());
+  size_t points = 0;
+  for (size_t i = 0; i < lines.size(); i++) {
+    order[i] = i;
+    points += std::max(lines[i].last - lines[i].first + 1, 0);
   }
-  // If max distance is greater than epsilon, recursively simplify
-  if (lmax > epsilon) {
-    keep->push_back(index);
-
-    // Recursive call
-    DouglasPeuckerM(PointList, fp, index, epsilon, keep);
-    DouglasPeuckerM(PointList, index, lp, epsilon, keep);
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return lines[a].last - lines[a].first > lines[b].last - lines[b].first;
+  });
+
+  std::atomic<size_t> next(0);
+  auto reduce = [&]() {
+    for (size_t i = next++; i < order.size(); i = next++) {
+      LODLine &line = lines[order[i]];
+      Reduce(line.xy, line.first, line.last, line.epsilon, line.keep,
+             line.stride, line.dim);
+    }
+  };
+  unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+  threads = std::min<size_t>(threads, points / kPointsPerThread + 1);
+  threads = std::min<size_t>(threads, lines.size());
+  std::vector<std::future<void>> workers;
+  for (unsigned t = 1; t < threads; t++) {
+    workers.push_back(std::async(std::launch::async, reduce));
   }
+  reduce();
+  for (auto &worker : workers) worker.get();
 }
-
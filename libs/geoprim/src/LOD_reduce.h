@@ -31,16 +31,42 @@
 
 #include <vector>
 
-void DouglasPeucker(double *PointList, int fp, int lp,
-                               double epsilon, std::vector<int> *keep);
-void DouglasPeuckerF(float *PointList, int fp, int lp,
-                                double epsilon, std::vector<int> *keep);
-void DouglasPeuckerM(double *PointList, int fp, int lp,
-                                double epsilon, std::vector<int> *keep);
-void DouglasPeuckerFI(float *PointList, int fp, int lp,
-                                 double epsilon, std::vector<bool> &keep);
-void DouglasPeuckerDI(double *PointList, int fp, int lp,
-                                 double epsilon, std::vector<bool> &keep);
+/**
+ * Douglas-Peucker line simplification. Marks in keep the points of the
+ * range first..last to keep so that no dropped point is farther than
+ * epsilon from the simplified line. first and last are always kept and
+ * entries of keep outside the range are left alone.
+ *
+ * Points are dim coordinates, 2 or 3, at xy[i * stride]. The distance is
+ * to the segment between the kept points, also for closed rings where
+ * first and last are the same point.
+ */
+void LODReduce(const double *xy, int first, int last, double epsilon,
+               std::vector<bool> &keep, int stride = 2, int dim = 2);
+void LODReduce(const float *xy, int first, int last, double epsilon,
+               std::vector<bool> &keep, int stride = 2, int dim = 2);
+
+/** An independent polyline for the parallel LODReduce(). */
+struct LODLine {
+  LODLine(const double *xy_, int first_, int last_, double epsilon_,
+          int stride_ = 2, int dim_ = 2)
+      : xy(xy_),
+        first(first_),
+        last(last_),
+        epsilon(epsilon_),
+        stride(stride_),
+        dim(dim_) {}
+
+  const double *xy;
+  int first;
+  int last;
+  double epsilon;
+  int stride;
+  int dim;
+  std::vector<bool> keep;  ///< Result, grown to last + 1 entries if smaller
+};
 
+/** Simplify many polylines, spread over all cores. */
+void LODReduce(std::vector<LODLine> &lines);
 
-#endif    // guard
+#endif  // guard
@@ -0,0 +1,486 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Scanline boolean operations on polygon sets
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "poly_clip.h"
+
+namespace {
+
+/** Points closer than this in degrees are considered coincident. */
+const double kEps = 1e-10;
+
+inline double Cross(double ax, double ay, double bx, double by) {
+  return ax * by - ay * bx;
+}
+
+inline bool Less(const contour_pt& a, const contour_pt& b) {
+  return a.y < b.y || (a.y == b.y && a.x < b.x);
+}
+
+inline bool Equal(const contour_pt& a, const contour_pt& b) {
+  return a.y == b.y && a.x == b.x;
+}
+
+struct Edge {
+  Edge(const contour_pt& p_, const contour_pt& q_, int owner_)
+      : p(p_),
+        q(q_),
+        owner(owner_),
+        minx(std::min(p.x, q.x)),
+        maxx(std::max(p.x, q.x)),
+        miny(std::min(p.y, q.y)),
+        maxy(std::max(p.y, q.y)),
+        len(sqrt((q.x - p.x) * (q.x - p.x) + (q.y - p.y) * (q.y - p.y))) {}
+
+  contour_pt p, q;
+  int owner;  ///< 0 for the first operand, 1 for the second
+  double minx, maxx, miny, maxy;
+  double len;
+};
+
+/** Point where another edge crosses or touches an edge. */
+struct Split {
+  Split(size_t edge_, double t_, const contour_pt& x_)
+      : edge(edge_), t(t_), x(x_) {}
+
+  bool operator<(const Split& other) const {
+    return edge < other.edge || (edge == other.edge && t < other.t);
+  }
+
+  size_t edge;
+  double t;  ///< Position along the edge, 0 at p and 1 at q
+  contour_pt x;
+};
+
+/**
+ * Piece of an edge with no other edge crossing its interior, lo < hi in
+ * (y, x) order. wa and wb are the winding number changes when crossing it
+ * from west to east, summed over coincident pieces.
+ */
+struct Segment {
+  contour_pt lo, hi;
+  int wa, wb;
+  double dxdy;  ///< Inverse slope, 0 if horizontal
+
+  bool Horizontal() const { return lo.y == hi.y; }
+
+  double XAt(double y) const {
+    if (y <= lo.y) return lo.x;
+    if (y >= hi.y) return hi.x;
+    return lo.x + dxdy * (y - lo.y);
+  }
+};
+
+struct Directed {
+  contour_pt from, to;
+};
+
+void AddEdges(std::vector<Edge>& edges, const FlatRegion& region,
+              size_t contour, int owner) {
+  const contour_pt* points = region.Contour(contour);
+  size_t n = region.ContourSize(contour);
+  for (size_t i = 0; i < n; i++) {
+    const contour_pt& p = points[i];
+    const contour_pt& q = points[i + 1 < n ? i + 1 : 0];
+    if (!Equal(p, q)) edges.emplace_back(p, q, owner);
+  }
+}
+
+/** Split edges[i] at x unless x is at an end point or off the edge. */
+void SplitAt(const std::vector<Edge>& edges, size_t i, const contour_pt& x,
+             std::vector<Split>& splits) {
+  const Edge& e = edges[i];
+  double ex = e.q.x - e.p.x, ey = e.q.y - e.p.y;
+  double t = ((x.x - e.p.x) * ex + (x.y - e.p.y) * ey) / (e.len * e.len);
+  if (t * e.len <= kEps || (1 - t) * e.len <= kEps) return;
+  if (fabs(Cross(ex, ey, x.x - e.p.x, x.y - e.p.y)) / e.len > kEps) return;
+  splits.emplace_back(i, t, x);
+}
+
+/**
+ * Record where e and f cross, touch or overlap. A touching end point is
+ * used as is so the pieces of both edges share exactly the same vertex.
+ */
+void IntersectEdges(const std::vector<Edge>& edges, size_t i, size_t j,
+                    std::vector<Split>& splits) {
+  const Edge& e = edges[i];
+  const Edge& f = edges[j];
+  double ex = e.q.x - e.p.x, ey = e.q.y - e.p.y;
+  double fx = f.q.x - f.p.x, fy = f.q.y - f.p.y;
+  double elen = e.len, flen = f.len;
+
+  // Signed distances of each edge's end points from the other edge's line.
+  double d_fp = Cross(ex, ey, f.p.x - e.p.x, f.p.y - e.p.y) / elen;
+  double d_fq = Cross(ex, ey, f.q.x - e.p.x, f.q.y - e.p.y) / elen;
+  double d_ep = Cross(fx, fy, e.p.x - f.p.x, e.p.y - f.p.y) / flen;
+  double d_eq = Cross(fx, fy, e.q.x - f.p.x, e.q.y - f.p.y) / flen;
+
+  bool fp_on = fabs(d_fp) <= kEps, fq_on = fabs(d_fq) <= kEps;
+  if (fp_on && fq_on) {  // collinear, split at overlap ends
+    SplitAt(edges, i, f.p, splits);
+    SplitAt(edges, i, f.q, splits);
+    SplitAt(edges, j, e.p, splits);
+    SplitAt(edges, j, e.q, splits);
+    return;
+  }
+  // Edges sharing an end point, like neighbours in a contour, meet only there
+  if (Equal(e.p, f.p) || Equal(e.p, f.q) || Equal(e.q, f.p) ||
+      Equal(e.q, f.q))
+    return;
+  if ((d_fp > kEps && d_fq > kEps) || (d_fp < -kEps && d_fq < -kEps)) return;
+  if ((d_ep > kEps && d_eq > kEps) || (d_ep < -kEps && d_eq < -kEps)) return;
+
+  contour_pt x;
+  if (fp_on) {
+    x = f.p;
+  } else if (fq_on) {
+    x = f.q;
+  } else if (fabs(d_ep) <= kEps) {
+    x = e.p;
+  } else if (fabs(d_eq) <= kEps) {
+    x = e.q;
+  } else {
+    double t = d_ep / (d_ep - d_eq);
+    x.x = e.p.x + t * ex;
+    x.y = e.p.y + t * ey;
+  }
+  SplitAt(edges, i, x, splits);
+  SplitAt(edges, j, x, splits);
+}
+
+/**
+ * Return the points where edges intersect, sorted on edge and position,
+ * using sweep and prune on x.
+ */
+std::vector<Split> SplitEdges(const std::vector<Edge>& edges) {
+  std::vector<std::pair<double, size_t>> order;
+  order.reserve(edges.size());
+  for (size_t i = 0; i < edges.size(); i++)
+    order.emplace_back(edges[i].minx, i);
+  std::sort(order.begin(), order.end());
+
+  std::vector<Split> splits;
+  for (size_t i = 0; i < order.size(); i++) {
+    const Edge& e = edges[order[i].second];
+    for (size_t j = i + 1; j < order.size(); j++) {
+      const Edge& f = edges[order[j].second];
+      if (f.minx > e.maxx + kEps) break;
+      if (f.miny > e.maxy + kEps || f.maxy < e.miny - kEps) continue;
+      IntersectEdges(edges, order[i].second, order[j].second, splits);
+    }
+  }
+  std::sort(splits.begin(), splits.end());
+  return splits;
+}
+
+/** Cut edges at the splits into pieces, merging coincident pieces. */
+std::vector<Segment> MakeSegments(const std::vector<Edge>& edges,
+                                  const std::vector<Split>& splits) {
+  std::vector<Segment> segments;
+  segments.reserve(edges.size() + splits.size());
+  std::vector<contour_pt> points;
+  auto split = splits.begin();
+  for (size_t ix = 0; ix < edges.size(); ix++) {
+    const Edge& e = edges[ix];
+    points.clear();
+    points.push_back(e.p);
+    for (; split != splits.end() && split->edge == ix; split++)
+      points.push_back(split->x);
+    points.push_back(e.q);
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+      const contour_pt& from = points[i];
+      const contour_pt& to = points[i + 1];
+      if (Equal(from, to)) continue;
+      Segment s;
+      bool up = Less(from, to);
+      s.lo = up ? from : to;
+      s.hi = up ? to : from;
+      // Entering a counter clockwise contour from the west crosses an edge
+      // running south.
+      int w = s.Horizontal() ? 0 : (up ? -1 : 1);
+      s.dxdy = s.Horizontal() ? 0 : (s.hi.x - s.lo.x) / (s.hi.y - s.lo.y);
+      s.wa = e.owner == 0 ? w : 0;
+      s.wb = e.owner == 1 ? w : 0;
+      segments.push_back(s);
+    }
+  }
+
+  auto key_less = [](const Segment& a, const Segment& b) {
+    if (!Equal(a.lo, b.lo)) return Less(a.lo, b.lo);
+    return Less(a.hi, b.hi);
+  };
+  std::sort(segments.begin(), segments.end(), key_less);
+  size_t n = 0;
+  for (size_t i = 0; i < segments.size(); i++) {
+    if (n > 0 && Equal(segments[n - 1].lo, segments[i].lo) &&
+        Equal(segments[n - 1].hi, segments[i].hi)) {
+      segments[n - 1].wa += segments[i].wa;
+      segments[n - 1].wb += segments[i].wb;
+    } else {
+      segments[n++] = segments[i];
+    }
+  }
+  segments.resize(n);
+  return segments;
+}
+
+inline bool Inside(ClipOp op, int wa, int wb) {
+  switch (op) {
+    case ClipOp::kIntersect:
+      return wa > 0 && wb > 0;
+    case ClipOp::kUnion:
+      return wa > 0 || wb > 0;
+    case ClipOp::kSubtract:
+      return wa > 0 && wb <= 0;
+  }
+  return false;
+}
+
+/**
+ * Is (x, y) inside the result, given the active segments. With north set
+ * the point is just north of y, else just south of it.
+ */
+bool InsideAt(ClipOp op, const std::vector<Segment>& segments,
+              const std::vector<size_t>& active, double y, double x,
+              bool north) {
+  int wa = 0, wb = 0;
+  for (size_t i : active) {
+    const Segment& s = segments[i];
+    if (north ? s.hi.y <= y : s.hi.y < y) continue;
+    if (s.XAt(y) < x) {
+      wa += s.wa;
+      wb += s.wb;
+    }
+  }
+  return Inside(op, wa, wb);
+}
+
+/**
+ * Sweep north over the segment start points, keeping the segments crossing
+ * the sweep line sorted west to east. Segments do not cross, so the order
+ * is kept until they end and the winding numbers on both sides of a new
+ * segment are the sums over the segments west of it. Segments separating
+ * inside from outside are kept, directed with the inside to the left.
+ */
+std::vector<Directed> ClassifySegments(const std::vector<Segment>& segments,
+                                       ClipOp op) {
+  std::vector<Directed> boundary;
+  std::vector<size_t> active, horizontal;
+  std::vector<bool> north, south;
+  size_t next = 0;  // segments are sorted on lo
+  while (next < segments.size()) {
+    double y0 = segments[next].lo.y;
+    size_t first = next;
+    horizontal.clear();
+    for (; next < segments.size() && segments[next].lo.y == y0; next++)
+      if (segments[next].Horizontal()) horizontal.push_back(next);
+
+    south.clear();
+    for (size_t i : horizontal) {
+      const Segment& s = segments[i];
+      south.push_back(
+          InsideAt(op, segments, active, y0, (s.lo.x + s.hi.x) / 2, false));
+    }
+
+    // Drop segments ending here, lazily also those which ended below.
+    active.erase(std::remove_if(active.begin(), active.end(),
+                                [&](size_t i) { return segments[i].hi.y <= y0; }),
+                 active.end());
+
+    // Insert new segments west of those passing further east at y0, or
+    // from the same point but turning further east.
+    bool started = false;
+    for (size_t ix = first; ix < next; ix++) {
+      const Segment& s = segments[ix];
+      if (s.Horizontal()) continue;
+      auto pos = std::lower_bound(
+          active.begin(), active.end(), ix, [&](size_t i, size_t j) {
+            double xi = segments[i].XAt(y0), xj = segments[j].XAt(y0);
+            return xi < xj || (xi == xj && segments[i].dxdy < segments[j].dxdy);
+          });
+      active.insert(pos, ix);
+      started = true;
+    }
+
+    if (started) {
+      int wa = 0, wb = 0;
+      for (size_t i : active) {
+        const Segment& s = segments[i];
+        bool in_west = Inside(op, wa, wb);
+        wa += s.wa;
+        wb += s.wb;
+        if (s.lo.y != y0) continue;  // classified when it started
+        bool in_east = Inside(op, wa, wb);
+        if (in_west && !in_east) boundary.push_back({s.lo, s.hi});
+        if (!in_west && in_east) boundary.push_back({s.hi, s.lo});
+      }
+    }
+
+    for (size_t k = 0; k < horizontal.size(); k++) {
+      const Segment& s = segments[horizontal[k]];
+      bool in_north =
+          InsideAt(op, segments, active, y0, (s.lo.x + s.hi.x) / 2, true);
+      if (in_north && !south[k]) boundary.push_back({s.lo, s.hi});
+      if (!in_north && south[k]) boundary.push_back({s.hi, s.lo});
+    }
+  }
+  return boundary;
+}
+
+/** Link boundary segments into closed contours, false if any is open. */
+bool ChainContours(std::vector<Directed>& boundary, FlatRegion& result) {
+  std::sort(boundary.begin(), boundary.end(),
+            [](const Directed& a, const Directed& b) {
+              return Less(a.from, b.from);
+            });
+  std::vector<bool> used(boundary.size(), false);
+  std::vector<contour_pt> contour;
+  for (size_t first = 0; first < boundary.size(); first++) {
+    if (used[first]) continue;
+    contour.clear();
+    size_t cur = first;
+    while (true) {
+      used[cur] = true;
+      contour.push_back(boundary[cur].from);
+      const contour_pt& to = boundary[cur].to;
+      if (Equal(to, boundary[first].from)) break;
+      Directed key = {to, to};
+      auto it = std::lower_bound(boundary.begin(), boundary.end(), key,
+                                 [](const Directed& a, const Directed& b) {
+                                   return Less(a.from, b.from);
+                                 });
+      size_t found = boundary.size();
+      for (; it != boundary.end() && Equal(it->from, to); it++) {
+        size_t i = it - boundary.begin();
+        if (!used[i]) {
+          found = i;
+          break;
+        }
+      }
+      if (found == boundary.size()) return false;
+      cur = found;
+    }
+    if (contour.size() >= 3) result.AddContour(contour.data(), contour.size());
+  }
+  return true;
+}
+
+}  // namespace
+
+void ContourBox::Expand(const contour_pt& p) {
+  if (!Valid()) {
+    minx = maxx = p.x;
+    miny = maxy = p.y;
+    return;
+  }
+  minx = std::min(minx, p.x);
+  maxx = std::max(maxx, p.x);
+  miny = std::min(miny, p.y);
+  maxy = std::max(maxy, p.y);
+}
+
+void ContourBox::Expand(const ContourBox& other) {
+  if (!other.Valid()) return;
+  if (!Valid()) {
+    *this = other;
+    return;
+  }
+  minx = std::min(minx, other.minx);
+  maxx = std::max(maxx, other.maxx);
+  miny = std::min(miny, other.miny);
+  maxy = std::max(maxy, other.maxy);
+}
+
+void FlatRegion::AddContour(const contour_pt* points, size_t n) {
+  ContourBox box;
+  for (size_t i = 0; i < n; i++) box.Expand(points[i]);
+  m_points.insert(m_points.end(), points, points + n);
+  m_starts.push_back(m_points.size());
+  m_boxes.push_back(box);
+  m_box.Expand(box);
+}
+
+void FlatRegion::AddContour(const FlatRegion& other, size_t contour) {
+  AddContour(other.Contour(contour), other.ContourSize(contour));
+}
+
+void FlatRegion::Clear() {
+  m_points.clear();
+  m_starts.assign(1, 0);
+  m_boxes.clear();
+  m_box = ContourBox();
+}
+
+bool FlatRegion::IsBox() const {
+  if (ContourCount() != 1 || ContourSize(0) != 4) return false;
+  const contour_pt* p = Contour(0);
+  double area = 0;
+  for (int i = 0; i < 4; i++) {
+    const contour_pt& a = p[i];
+    const contour_pt& b = p[(i + 1) % 4];
+    if ((a.x == b.x) == (a.y == b.y)) return false;
+    if (a.x != m_box.minx && a.x != m_box.maxx) return false;
+    if (a.y != m_box.miny && a.y != m_box.maxy) return false;
+    area += Cross(a.x, a.y, b.x, b.y);
+  }
+  return area > 0;
+}
+
+bool ClipRegions(const FlatRegion& a, const FlatRegion& b, ClipOp op,
+                 FlatRegion& result) {
+  result.Clear();
+  bool a_is_box = a.IsBox(), b_is_box = b.IsBox();
+  std::vector<Edge> edges;
+
+  for (size_t i = 0; i < a.ContourCount(); i++) {
+    const ContourBox& box = a.ContourBounds(i);
+    if (b.Empty() || box.Disjoint(b.Bounds())) {
+      if (op != ClipOp::kIntersect) result.AddContour(a, i);
+    } else if (b_is_box && box.Inside(b.Bounds())) {
+      if (op == ClipOp::kIntersect) result.AddContour(a, i);
+    } else {
+      AddEdges(edges, a, i, 0);
+    }
+  }
+  for (size_t i = 0; i < b.ContourCount(); i++) {
+    const ContourBox& box = b.ContourBounds(i);
+    if (a.Empty() || box.Disjoint(a.Bounds())) {
+      if (op == ClipOp::kUnion) result.AddContour(b, i);
+    } else if (a_is_box && op != ClipOp::kSubtract &&
+               box.Inside(a.Bounds())) {
+      if (op == ClipOp::kIntersect) result.AddContour(b, i);
+    } else {
+      AddEdges(edges, b, i, 1);
+    }
+  }
+  if (edges.empty()) return true;
+
+  std::vector<Split> splits = SplitEdges(edges);
+  std::vector<Segment> segments = MakeSegments(edges, splits);
+  std::vector<Directed> boundary = ClassifySegments(segments, op);
+  return ChainContours(boundary, result);
+}
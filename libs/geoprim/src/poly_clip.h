@@ -0,0 +1,106 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Scanline boolean operations on polygon sets
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef __POLY_CLIP_H__
+#define __POLY_CLIP_H__
+
+#include <cstddef>
+#include <vector>
+
+struct contour_pt {
+  double y, x;
+};
+
+/** Bounds of a contour or region, x is longitude and y latitude. */
+struct ContourBox {
+  ContourBox() : minx(0), miny(0), maxx(-1), maxy(-1) {}
+
+  bool Valid() const { return minx <= maxx; }
+
+  /** True if the boxes have no common point. */
+  bool Disjoint(const ContourBox& other) const {
+    return minx > other.maxx || maxx < other.minx || miny > other.maxy ||
+           maxy < other.miny;
+  }
+
+  /** True if this box is within other, borders included. */
+  bool Inside(const ContourBox& other) const {
+    return minx >= other.minx && maxx <= other.maxx && miny >= other.miny &&
+           maxy <= other.maxy;
+  }
+
+  void Expand(const contour_pt& p);
+  void Expand(const ContourBox& other);
+
+  double minx, miny, maxx, maxy;
+};
+
+/**
+ * Set of closed contours stored in one vertex array with the start offset
+ * and bounds of each contour. As in LLRegion outer contours run counter
+ * clockwise and holes clockwise, i.e. positive winding is inside.
+ */
+class FlatRegion {
+public:
+  FlatRegion() : m_starts(1, 0) {}
+
+  void AddContour(const contour_pt* points, size_t n);
+  void AddContour(const FlatRegion& other, size_t contour);
+  void Clear();
+
+  bool Empty() const { return m_boxes.empty(); }
+  size_t ContourCount() const { return m_boxes.size(); }
+  size_t ContourSize(size_t i) const { return m_starts[i + 1] - m_starts[i]; }
+  const contour_pt* Contour(size_t i) const { return &m_points[m_starts[i]]; }
+  const ContourBox& ContourBounds(size_t i) const { return m_boxes[i]; }
+
+  /** Bounds of all contours, invalid if empty. */
+  const ContourBox& Bounds() const { return m_box; }
+
+  /** True if the region is a single axis aligned rectangle. */
+  bool IsBox() const;
+
+private:
+  std::vector<contour_pt> m_points;
+  std::vector<size_t> m_starts;
+  std::vector<ContourBox> m_boxes;
+  ContourBox m_box;
+};
+
+enum class ClipOp { kIntersect, kUnion, kSubtract };
+
+/**
+ * Compute a op b into result using the positive winding rule on both
+ * operands. Contours whose bounds are disjoint from the other operand, or
+ * inside it when it is a rectangle, bypass clipping. The rest is split at
+ * all edge intersections and each piece is classified in a horizontal
+ * sweep over the vertex latitudes.
+ *
+ * Return false if the boundary could not be closed due to numerical
+ * problems, result is then undefined.
+ */
+bool ClipRegions(const FlatRegion& a, const FlatRegion& b, ClipOp op,
+                 FlatRegion& result);
+
+#endif  // __POLY_CLIP_H__
@@ -518,7 +518,7 @@ int PolyTessGeo::BuildTessGLU() {
     bool_keep[ptValid - 1] = true;
     bool_keep[ptValid - 2] = true;
 
-    DouglasPeuckerDI(geoPt, 1, ptValid - 2, m_LOD_meters, bool_keep);
+    LODReduce(geoPt, 1, ptValid - 2, m_LOD_meters, bool_keep, 3);
 
     // Create a new buffer
     double *LOD_result = (double *)malloc((m_cntr[0]) * 3 * sizeof(double));
@@ -860,7 +860,7 @@ int PolyTessGeo::BuildTess(void) {
     bool_keep[ptValid - 1] = true;
     bool_keep[ptValid - 2] = true;
 
-    DouglasPeuckerFI(geoPt, 1, ptValid - 2, m_LOD_meters, bool_keep);
+    LODReduce(geoPt, 1, ptValid - 2, m_LOD_meters, bool_keep);
 
     // Create a new buffer
     float *LOD_result = (float *)malloc((npte)*2 * sizeof(float));
@@ -34,6 +34,9 @@
 #include <math.h>
 #include <stdlib.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #ifdef __OCPN__ANDROID__
 // Handle occasional SIG on Android
@@ -83,6 +86,7 @@ static const double mercator_k0 = 0.9996;
 #include <wx/image.h>
 #include <wx/tokenzr.h>
 #include <wx/fileconf.h>
+#include <algorithm>
 #include <fstream>
 
 #ifndef PROJECTION_MERCATOR
@@ -3961,13 +3965,14 @@ int s52plib::RenderLS(ObjRazRules *rzRules, Rules *rules) {
           nPoints = 2;
         }
 
-        wxPoint l;
-        GetPointPixSingle(rzRules, ppt[1], ppt[0], &l);
-        ppt += 2;
+        if ((int)m_pix_buffer.size() < nPoints) m_pix_buffer.resize(nPoints);
+        wxPoint *pix = &m_pix_buffer[0];
+        GetPointPixArray(rzRules, ppt, pix, nPoints);
+
+        wxPoint l = pix[0];
 
         for (int ip = 0; ip < nPoints - 1; ip++) {
-          wxPoint r;
-          GetPointPixSingle(rzRules, ppt[1], ppt[0], &r);
+          wxPoint r = pix[ip + 1];
           //        Draw the edge as point-to-point
           x0 = l.x, y0 = l.y;
           x1 = r.x, y1 = r.y;
@@ -3982,7 +3987,6 @@ int s52plib::RenderLS(ObjRazRules *rzRules, Rules *rules) {
           }
 
           l = r;
-          ppt += 2;
         }
       }
 
@@ -4351,13 +4355,14 @@ int s52plib::RenderLSPlugIn(ObjRazRules *rzRules, Rules *rules) {
           nPoints = 2;
         }
 
-        wxPoint l;
-        GetPointPixSingle(rzRules, ppt[1], ppt[0], &l);
-        ppt += 2;
+        if ((int)m_pix_buffer.size() < nPoints) m_pix_buffer.resize(nPoints);
+        wxPoint *pix = &m_pix_buffer[0];
+        GetPointPixArray(rzRules, ppt, pix, nPoints);
+
+        wxPoint l = pix[0];
 
         for (int ip = 0; ip < nPoints - 1; ip++) {
-          wxPoint r;
-          GetPointPixSingle(rzRules, ppt[1], ppt[0], &r);
+          wxPoint r = pix[ip + 1];
           //        Draw the edge as point-to-point
           x0 = l.x, y0 = l.y;
           x1 = r.x, y1 = r.y;
@@ -4391,7 +4396,6 @@ int s52plib::RenderLSPlugIn(ObjRazRules *rzRules, Rules *rules) {
           }
 
           l = r;
-          ppt += 2;
         }
       }
       ls = ls->next;
@@ -4561,13 +4565,14 @@ int s52plib::RenderLS_Dash_GLSL(ObjRazRules *rzRules, Rules *rules) {
           nPoints = 2;
         }
 
-        wxPoint l;
-        GetPointPixSingle(rzRules, ppt[1], ppt[0], &l);
-        ppt += 2;
+        if ((int)m_pix_buffer.size() < nPoints) m_pix_buffer.resize(nPoints);
+        wxPoint *pix = &m_pix_buffer[0];
+        GetPointPixArray(rzRules, ppt, pix, nPoints);
+
+        wxPoint l = pix[0];
 
         for (int ip = 0; ip < nPoints - 1; ip++) {
-          wxPoint r;
-          GetPointPixSingle(rzRules, ppt[1], ppt[0], &r);
+          wxPoint r = pix[ip + 1];
           //        Draw the edge as point-to-point
           x0 = l.x, y0 = l.y;
           x1 = r.x, y1 = r.y;
@@ -4621,7 +4626,6 @@ int s52plib::RenderLS_Dash_GLSL(ObjRazRules *rzRules, Rules *rules) {
           }
 
           l = r;
-          ppt += 2;
         }
       }
 
@@ -4729,10 +4733,13 @@ int s52plib::RenderLC(ObjRazRules *rzRules, Rules *rules) {
           vbo_inc = -2;
         }
 
+        if ((int)m_pix_buffer.size() < nPoints) m_pix_buffer.resize(nPoints);
+        wxPoint *pix = &m_pix_buffer[0];
+        GetPointPixArray(rzRules, ppt, pix, nPoints);
+
         double offset = 0;
         for (int ip = 0; ip < nPoints; ip++) {
-          wxPoint r;
-          GetPointPixSingle(rzRules, ppt[vbo_index + 1], ppt[vbo_index], &r);
+          wxPoint r = pix[vbo_index / 2];
           if ((r.x != lp.x) || (r.y != lp.y)) {
             mask[index] = (ls->priority == priority_current) ? 1 : 0;
             ptp[index++] = r;
@@ -4846,49 +4853,32 @@ int s52plib::RenderLC(ObjRazRules *rzRules, Rules *rules) {
 int s52plib::reduceLOD(double LOD_meters, int nPoints, double *source,
                        wxPoint2DDouble **dest, int *maskIn, int **maskOut) {
   //      Reduce the LOD of this linestring
-  std::vector<int> index_keep;
+  std::vector<bool> keep(nPoints, true);
   if (nPoints > 5 && (LOD_meters > .01)) {
-    index_keep.push_back(0);
-    index_keep.push_back(nPoints - 1);
-    index_keep.push_back(nPoints - 2);
-
-    DouglasPeucker(source, 0, nPoints - 2, LOD_meters, &index_keep);
-
-  } else {
-    index_keep.resize(nPoints);
-    // Consider using std::iota here when there is C++11 support.
-    for (int i = 0; i < nPoints; i++) index_keep[i] = i;
+    keep.assign(nPoints, false);
+    keep[nPoints - 1] = true;
+    LODReduce(source, 0, nPoints - 2, LOD_meters, keep);
   }
+  int nKept = std::count(keep.begin(), keep.end(), true);
 
   wxPoint2DDouble *pReduced =
-      (wxPoint2DDouble *)malloc((index_keep.size()) * sizeof(wxPoint2DDouble));
+      (wxPoint2DDouble *)malloc(nKept * sizeof(wxPoint2DDouble));
   *dest = pReduced;
 
   int *pmaskOut = NULL;
   if (maskIn) {
-    *maskOut = (int *)malloc((index_keep.size()) * sizeof(int));
+    *maskOut = (int *)malloc(nKept * sizeof(int));
     pmaskOut = *maskOut;
   }
 
-  double *ppr = source;
   int ir = 0;
   for (int ip = 0; ip < nPoints; ip++) {
-    double x = *ppr++;
-    double y = *ppr++;
-    int maskval = 1;
-    if (maskIn) maskval = maskIn[ip];
-    // printf("LOD:  %10g  %10g\n", x, y);
-
-    for (unsigned int j = 0; j < index_keep.size(); j++) {
-      if (index_keep[j] == ip) {
-        if (pmaskOut) pmaskOut[ir] = maskval;
-        pReduced[ir++] = wxPoint2DDouble(x, y);
-        break;
-      }
-    }
+    if (!keep[ip]) continue;
+    if (pmaskOut) pmaskOut[ir] = maskIn[ip];
+    pReduced[ir++] = wxPoint2DDouble(source[2 * ip], source[2 * ip + 1]);
   }
 
-  return index_keep.size();
+  return nKept;
 }
 
 // Line Complex
@@ -5157,9 +5147,13 @@ int s52plib::RenderLCPlugIn(ObjRazRules *rzRules, Rules *rules) {
           vbo_index = (nPoints - 1) * 2;
           vbo_inc = -2;
         }
+
+        if ((int)m_pix_buffer.size() < nPoints) m_pix_buffer.resize(nPoints);
+        wxPoint *pix = &m_pix_buffer[0];
+        GetPointPixArray(rzRules, ppt, pix, nPoints);
+
         for (int ip = 0; ip < nPoints; ip++) {
-          wxPoint r;
-          GetPointPixSingle(rzRules, ppt[vbo_index + 1], ppt[vbo_index], &r);
+          wxPoint r = pix[vbo_index / 2];
 
           if (1 /*(r.x != lp.x) || (r.y != lp.y)*/) {
             ptp[index++] = r;
@@ -10035,8 +10029,81 @@ void s52plib::AdjustTextList(int dx, int dy, int screenw, int screenh) {
 
 bool s52plib::GetPointPixArray(ObjRazRules *rzRules, wxPoint2DDouble *pd,
                                wxPoint *pp, int nv) {
-  for (int i = 0; i < nv; i++) {
-    GetPointPixSingle(rzRules, pd[i].m_y, pd[i].m_x, pp + i);
+  float en[2 * 64];
+  for (int i = 0; i < nv; i += 64) {
+    int n = wxMin(64, nv - i);
+    for (int j = 0; j < n; j++) {
+      en[2 * j] = pd[i + j].m_x;
+      en[2 * j + 1] = pd[i + j].m_y;
+    }
+    GetPointPixArray(rzRules, en, pp + i, n);
+  }
+
+  return true;
+}
+
+bool s52plib::GetPointPixArray(ObjRazRules *rzRules, const float *en,
+                               wxPoint *pp, int nv) {
+  //  Same arithmetic as GetPointPixSingle(), with the per object setup
+  //  done once for the whole array
+  double xr = rzRules->obj->x_rate;
+  double xo = rzRules->obj->x_origin;
+  double yr = rzRules->obj->y_rate;
+  double yo = rzRules->obj->y_origin;
+
+  if (fabs(xo) > 1) {  // cm93 hits this
+    if (GetBBox().GetMaxLon() >= 180. &&
+        rzRules->obj->BBObj.GetMaxLon() < GetBBox().GetMinLon())
+      xo += mercator_k0 * WGS84_semimajor_axis_meters * 2.0 * PI;
+    else if ((GetBBox().GetMinLon() <= -180. &&
+              rzRules->obj->BBObj.GetMinLon() > GetBBox().GetMaxLon()) ||
+             (rzRules->obj->BBObj.GetMaxLon() >= 180 &&
+              GetBBox().GetMinLon() <= 0.))
+      xo -= mercator_k0 * WGS84_semimajor_axis_meters * 2.0 * PI;
+  }
+
+  const double ec = rzRules->sm_transform_parms->easting_vp_center;
+  const double nc = rzRules->sm_transform_parms->northing_vp_center;
+  const double ppm = vp_plib.view_scale_ppm;
+  const int hw = vp_plib.pix_width / 2;
+  const int hh = vp_plib.pix_height / 2;
+
+  int i = 0;
+#if defined(__SSE2__) && !defined(__WXOSX__)
+  //  One point per iteration, x and y in the two lanes.
+  //  y = hh - (valy - nc) * ppm is computed as (valy - nc) * -ppm + hh,
+  //  which is exact, so the results match the scalar code.
+  const __m128d rate = _mm_set_pd(yr, xr);
+  const __m128d origin = _mm_set_pd(yo, xo);
+  const __m128d center = _mm_set_pd(nc, ec);
+  const __m128d scale = _mm_set_pd(-ppm, ppm);
+  const __m128d half = _mm_set_pd(hh, hw);
+  const __m128d p05 = _mm_set1_pd(.5), m05 = _mm_set1_pd(-.5);
+  for (; i < nv; i++) {
+    __m128d v = _mm_cvtps_pd(
+        _mm_castpd_ps(_mm_load_sd((const double *)(en + 2 * i))));
+    v = _mm_add_pd(_mm_mul_pd(v, rate), origin);
+    v = _mm_add_pd(_mm_mul_pd(_mm_sub_pd(v, center), scale), half);
+
+    //  roundint()
+    __m128i t = _mm_cvttpd_epi32(v);
+    __m128d f = _mm_sub_pd(v, _mm_cvtepi32_pd(t));
+    __m128i up = _mm_shuffle_epi32(_mm_castpd_si128(_mm_cmpge_pd(f, p05)),
+                                   _MM_SHUFFLE(2, 0, 2, 0));
+    __m128i down = _mm_shuffle_epi32(_mm_castpd_si128(_mm_cmple_pd(f, m05)),
+                                     _MM_SHUFFLE(2, 0, 2, 0));
+    t = _mm_add_epi32(_mm_sub_epi32(t, up), down);
+
+    pp[i].x = _mm_cvtsi128_si32(t);
+    pp[i].y = _mm_cvtsi128_si32(_mm_srli_si128(t, 4));
+  }
+#endif
+  for (; i < nv; i++) {
+    double valx = (en[2 * i] * xr) + xo;
+    double valy = (en[2 * i + 1] * yr) + yo;
+
+    pp[i].x = roundint(((valx - ec) * ppm) + hw);
+    pp[i].y = roundint(hh - ((valy - nc) * ppm));
   }
 
   return true;
@@ -513,6 +513,10 @@ private:
 
   bool GetPointPixArray(ObjRazRules *rzRules, wxPoint2DDouble *pd, wxPoint *pp,
                         int nv);
+  //  Project nv (east, north) float pairs, as stored in the line vertex
+  //  buffer, with the same results as GetPointPixSingle()
+  bool GetPointPixArray(ObjRazRules *rzRules, const float *en, wxPoint *pp,
+                        int nv);
   bool GetPointPixSingle(ObjRazRules *rzRules, float north, float east,
                          wxPoint *r);
   void GetPixPointSingle(int pixx, int pixy, double *plat, double *plon);
@@ -549,6 +553,8 @@ private:
   int *ledge;
   int *redge;
 
+  std::vector<wxPoint> m_pix_buffer;  // projected line vertices
+
   int m_colortable_index;
   int m_colortable_index_save;
 
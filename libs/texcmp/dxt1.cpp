@@ -0,0 +1,493 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  DXT1 block encoder with SSE2/AVX2 kernels
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+#include "dxt1.h"
+
+Dxt1FitFunc Dxt1_FitIndices = Dxt1_FitIndices_generic;
+Dxt1MomentsFunc Dxt1_Moments = Dxt1_Moments_generic;
+
+/** Palette entry which is never the nearest, disables index 3. */
+static const float kUnused = 10000;
+
+/**
+ * Error of a four colour fit below which the three colour mode is not
+ * tried, a squared error of 32 per channel and pixel. It hardly ever
+ * wins on such blocks.
+ */
+static const float kThreeColourError = 16 * 3 * 32;
+
+float Dxt1_FitIndices_generic(const Dxt1Pixels *pixels,
+                              const float palette[4][3], uint32_t *indices) {
+  float total = 0;
+  uint32_t packed = 0;
+  for (int i = 0; i < 16; i++) {
+    float best = 0;
+    uint32_t best_j = 0;
+    for (uint32_t j = 0; j < 4; j++) {
+      float dr = pixels->r[i] - palette[j][0];
+      float dg = pixels->g[i] - palette[j][1];
+      float db = pixels->b[i] - palette[j][2];
+      float e = dr * dr + dg * dg;
+      e = e + db * db;
+      if (j == 0 || e < best) {
+        best = e;
+        best_j = j;
+      }
+    }
+    packed |= best_j << (2 * i);
+    total += best;
+  }
+  *indices = packed;
+  return total;
+}
+
+void Dxt1_Moments_generic(const Dxt1Pixels *pixels, float moments[15]) {
+  float *m = moments;
+  for (int k = 0; k < 9; k++) m[k] = 0;
+  for (int k = 9; k < 12; k++) m[k] = 255;
+  for (int k = 12; k < 15; k++) m[k] = 0;
+  for (int i = 0; i < 16; i++) {
+    float r = pixels->r[i], g = pixels->g[i], b = pixels->b[i];
+    m[0] += r;
+    m[1] += g;
+    m[2] += b;
+    m[3] += r * r;
+    m[4] += r * g;
+    m[5] += r * b;
+    m[6] += g * g;
+    m[7] += g * b;
+    m[8] += b * b;
+    m[9] = std::min(m[9], r);
+    m[10] = std::min(m[10], g);
+    m[11] = std::min(m[11], b);
+    m[12] = std::max(m[12], r);
+    m[13] = std::max(m[13], g);
+    m[14] = std::max(m[14], b);
+  }
+}
+
+void Dxt1_ResolveRoutines() {
+  bool sse2 = false, avx2 = false;
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int info[4];
+  __cpuid(info, 0);
+  int ids = info[0];
+  if (ids >= 1) {
+    __cpuid(info, 1);
+    sse2 = (info[3] & (1 << 26)) != 0;
+    // AVX registers must be saved by the os too
+    bool ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    if (ids >= 7 && ymm) {
+      __cpuidex(info, 7, 0);
+      avx2 = (info[1] & (1 << 5)) != 0;
+    }
+  }
+#elif defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  sse2 = __builtin_cpu_supports("sse2");
+  avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+#ifdef TEXCMP_HAVE_SSE2
+  if (sse2) {
+    Dxt1_FitIndices = Dxt1_FitIndices_sse2;
+    Dxt1_Moments = Dxt1_Moments_sse2;
+  }
+#endif
+#ifdef TEXCMP_HAVE_AVX2
+  if (avx2) {
+    Dxt1_FitIndices = Dxt1_FitIndices_avx2;
+    Dxt1_Moments = Dxt1_Moments_avx2;
+  }
+#endif
+  (void)sse2;
+  (void)avx2;
+}
+
+namespace {
+
+/** Candidate encoding: 565 endpoints, indices and error. */
+struct Fit {
+  int c0, c1;
+  bool four;  ///< Four colour mode, else three colours
+  uint32_t indices;
+  float error;
+};
+
+int Pack565(const float c[3]) {
+  int r = (int)(c[0] * (31.f / 255.f) + 0.5f);
+  int g = (int)(c[1] * (63.f / 255.f) + 0.5f);
+  int b = (int)(c[2] * (31.f / 255.f) + 0.5f);
+  r = std::min(std::max(r, 0), 31);
+  g = std::min(std::max(g, 0), 63);
+  b = std::min(std::max(b, 0), 31);
+  return r << 11 | g << 5 | b;
+}
+
+/** Expand like the decoder does, replicating the high bits. */
+void Unpack565(int c, int rgb[3]) {
+  int r = c >> 11 & 31, g = c >> 5 & 63, b = c & 31;
+  rgb[0] = r << 3 | r >> 2;
+  rgb[1] = g << 2 | g >> 4;
+  rgb[2] = b << 3 | b >> 2;
+}
+
+/** Palette as decoded by squish::Decompress(), index order of a block. */
+void MakePalette(int c0, int c1, bool four, float palette[4][3]) {
+  int a[3], b[3];
+  Unpack565(c0, a);
+  Unpack565(c1, b);
+  for (int k = 0; k < 3; k++) {
+    palette[0][k] = (float)a[k];
+    palette[1][k] = (float)b[k];
+    if (four) {
+      palette[2][k] = (float)((2 * a[k] + b[k]) / 3);
+      palette[3][k] = (float)((a[k] + 2 * b[k]) / 3);
+    } else {
+      palette[2][k] = (float)((a[k] + b[k]) / 2);
+      palette[3][k] = kUnused;
+    }
+  }
+}
+
+Fit Evaluate(const Dxt1Pixels &px, int c0, int c1, bool four) {
+  Fit fit;
+  fit.c0 = c0;
+  fit.c1 = c1;
+  fit.four = four;
+  float palette[4][3];
+  MakePalette(c0, c1, four, palette);
+  fit.error = Dxt1_FitIndices(&px, palette, &fit.indices);
+  return fit;
+}
+
+void Keep(Fit &best, const Fit &fit) {
+  if (fit.error < best.error) best = fit;
+}
+
+/** Pixel count and channel sums of each palette index of a fit. */
+struct IndexSums {
+  float n[4];
+  float s[4][3];
+};
+
+void SumByIndex(const Dxt1Pixels &px, uint32_t indices, IndexSums &sums) {
+  for (int j = 0; j < 4; j++) {
+    sums.n[j] = 0;
+    for (int k = 0; k < 3; k++) sums.s[j][k] = 0;
+  }
+  for (int i = 0; i < 16; i++) {
+    int j = indices >> (2 * i) & 3;
+    sums.n[j] += 1;
+    sums.s[j][0] += px.r[i];
+    sums.s[j][1] += px.g[i];
+    sums.s[j][2] += px.b[i];
+  }
+}
+
+/**
+ * Endpoints minimising the squared error for the indices summed up in
+ * sums, solved per channel. Return false if the indices do not span both
+ * endpoints.
+ */
+bool LeastSquares(const IndexSums &sums, bool four, float e0[3],
+                  float e1[3]) {
+  static const float kWeight4[4] = {1.f, 0.f, 2.f / 3.f, 1.f / 3.f};
+  static const float kWeight3[4] = {1.f, 0.f, 0.5f, 0.f};
+  const float *weight = four ? kWeight4 : kWeight3;
+  float aa = 0, ab = 0, bb = 0;
+  float ax[3] = {0, 0, 0}, bx[3] = {0, 0, 0};
+  for (int j = 0; j < 4; j++) {
+    float a = weight[j];
+    float b = 1.f - a;
+    aa += sums.n[j] * a * a;
+    ab += sums.n[j] * a * b;
+    bb += sums.n[j] * b * b;
+    for (int k = 0; k < 3; k++) {
+      ax[k] += a * sums.s[j][k];
+      bx[k] += b * sums.s[j][k];
+    }
+  }
+  float det = aa * bb - ab * ab;
+  if (fabsf(det) < 1e-3f) return false;
+  for (int k = 0; k < 3; k++) {
+    e0[k] = std::min(std::max((ax[k] * bb - bx[k] * ab) / det, 0.f), 255.f);
+    e1[k] = std::min(std::max((bx[k] * aa - ax[k] * ab) / det, 0.f), 255.f);
+  }
+  return true;
+}
+
+/**
+ * Move the 565 values v0, v1 of channel k by at most one step each to
+ * minimise the error of that channel while the indices stay. The error
+ * is exact for the decoded palette and channels are independent, so this
+ * is a lot cheaper than trying the steps with Evaluate().
+ */
+void SearchChannel(const IndexSums &sums, int k, bool four, int &v0,
+                   int &v1) {
+  const int bits = k == 1 ? 6 : 5;
+  const int max = (1 << bits) - 1;
+  int best0 = v0, best1 = v1;
+  float best = 0;
+  bool first = true;
+  for (int a = std::max(v0 - 1, 0); a <= std::min(v0 + 1, max); a++) {
+    for (int b = std::max(v1 - 1, 0); b <= std::min(v1 + 1, max); b++) {
+      int ea = a << (8 - bits) | a >> (2 * bits - 8);
+      int eb = b << (8 - bits) | b >> (2 * bits - 8);
+      float p[4] = {(float)ea, (float)eb, 0, 0};
+      if (four) {
+        p[2] = (float)((2 * ea + eb) / 3);
+        p[3] = (float)((ea + 2 * eb) / 3);
+      } else {
+        p[2] = (float)((ea + eb) / 2);
+      }
+      // sum of (p - x)^2 over the pixels less the constant sum of x^2
+      float e = 0;
+      for (int j = 0; j < 4; j++)
+        e += p[j] * (sums.n[j] * p[j] - 2 * sums.s[j][k]);
+      if (first || e < best) {
+        best = e;
+        best0 = a;
+        best1 = b;
+        first = false;
+      }
+    }
+  }
+  v0 = best0;
+  v1 = best1;
+}
+
+/**
+ * Iterate least squares endpoints while that lowers the error. With
+ * lattice they are placed on the 565 grid by SearchChannel(), else just
+ * rounded.
+ */
+void ImproveLeastSquares(const Dxt1Pixels &px, Fit &best, int iterations,
+                         bool lattice) {
+  static const int kShift[3] = {11, 5, 0};
+  static const int kMax[3] = {31, 63, 31};
+  float e0[3], e1[3];
+  IndexSums sums;
+  for (int n = 0; n < iterations && best.error > 0; n++) {
+    SumByIndex(px, best.indices, sums);
+    if (!LeastSquares(sums, best.four, e0, e1)) break;
+    int c0 = Pack565(e0), c1 = Pack565(e1);
+    for (int k = 0; lattice && k < 3; k++) {
+      int v0 = c0 >> kShift[k] & kMax[k], v1 = c1 >> kShift[k] & kMax[k];
+      SearchChannel(sums, k, best.four, v0, v1);
+      c0 = (c0 & ~(kMax[k] << kShift[k])) | v0 << kShift[k];
+      c1 = (c1 & ~(kMax[k] << kShift[k])) | v1 << kShift[k];
+    }
+    Fit fit = Evaluate(px, c0, c1, best.four);
+    if (!(fit.error < best.error)) break;
+    best = fit;
+  }
+}
+
+/**
+ * Principal axis endpoints: the pixels at both ends of the projection,
+ * from the moments as returned by Dxt1_Moments().
+ */
+void AxisEndpoints(const Dxt1Pixels &px, const float m[15], float e0[3],
+                   float e1[3]) {
+  // covariance times 16
+  float rr = m[3] - m[0] * m[0] / 16, rg = m[4] - m[0] * m[1] / 16;
+  float rb = m[5] - m[0] * m[2] / 16, gg = m[6] - m[1] * m[1] / 16;
+  float gb = m[7] - m[1] * m[2] / 16, bb = m[8] - m[2] * m[2] / 16;
+
+  // power iteration, starting from the bounding box diagonal
+  float v[3] = {m[12] - m[9], m[13] - m[10], m[14] - m[11]};
+  for (int n = 0; n < 4; n++) {
+    float x = rr * v[0] + rg * v[1] + rb * v[2];
+    float y = rg * v[0] + gg * v[1] + gb * v[2];
+    float z = rb * v[0] + gb * v[1] + bb * v[2];
+    float l = std::max(fabsf(x), std::max(fabsf(y), fabsf(z)));
+    if (l == 0) break;
+    v[0] = x / l;
+    v[1] = y / l;
+    v[2] = z / l;
+  }
+
+  int imin = 0, imax = 0;
+  float dmin = 0, dmax = 0;
+  for (int i = 0; i < 16; i++) {
+    float d = px.r[i] * v[0] + px.g[i] * v[1] + px.b[i] * v[2];
+    if (i == 0 || d < dmin) dmin = d, imin = i;
+    if (i == 0 || d > dmax) dmax = d, imax = i;
+  }
+  e0[0] = px.r[imax];
+  e0[1] = px.g[imax];
+  e0[2] = px.b[imax];
+  e1[0] = px.r[imin];
+  e1[1] = px.g[imin];
+  e1[2] = px.b[imin];
+}
+
+void WriteBlock(Fit fit, unsigned char *block) {
+  if (fit.four) {
+    if (fit.c0 == fit.c1)
+      fit.indices = 0;
+    else if (fit.c0 < fit.c1) {
+      std::swap(fit.c0, fit.c1);
+      fit.indices ^= 0x55555555;  // 0 <-> 1, 2 <-> 3
+    }
+  } else if (fit.c0 > fit.c1) {
+    std::swap(fit.c0, fit.c1);
+    fit.indices ^= ~(fit.indices >> 1) & 0x55555555;  // 0 <-> 1
+  }
+  block[0] = fit.c0 & 0xff;
+  block[1] = fit.c0 >> 8;
+  block[2] = fit.c1 & 0xff;
+  block[3] = fit.c1 >> 8;
+  for (int i = 0; i < 4; i++) block[4 + i] = fit.indices >> (8 * i) & 0xff;
+}
+
+/** Endpoints whose 2/3 : 1/3 mix is nearest to a channel value. */
+struct SingleEntry {
+  unsigned char a, b;
+};
+
+struct SingleTables {
+  SingleEntry five[256];
+  SingleEntry six[256];
+
+  SingleTables() {
+    Fill(five, 5);
+    Fill(six, 6);
+  }
+
+  static void Fill(SingleEntry *table, int bits) {
+    int n = 1 << bits;
+    for (int v = 0; v < 256; v++) {
+      int best = 256;
+      for (int a = 0; a < n; a++) {
+        for (int b = 0; b < n; b++) {
+          int ea = a << (8 - bits) | a >> (2 * bits - 8);
+          int eb = b << (8 - bits) | b >> (2 * bits - 8);
+          int e = abs((2 * ea + eb) / 3 - v);
+          if (e < best) {
+            best = e;
+            table[v].a = a;
+            table[v].b = b;
+          }
+        }
+      }
+    }
+  }
+};
+
+/** Solid blocks are common in charts, encode them exactly as can be. */
+void CompressSolid(const Dxt1Pixels &px, unsigned char *block) {
+  static const SingleTables tables;
+  const SingleEntry &r = tables.five[(int)px.r[0]];
+  const SingleEntry &g = tables.six[(int)px.g[0]];
+  const SingleEntry &b = tables.five[(int)px.b[0]];
+  Fit fit;
+  fit.c0 = r.a << 11 | g.a << 5 | b.a;
+  fit.c1 = r.b << 11 | g.b << 5 | b.b;
+  fit.four = true;
+  fit.indices = 0xaaaaaaaa;  // all 2, the 2/3 : 1/3 mix
+  fit.error = 0;
+  WriteBlock(fit, block);
+}
+
+void CompressPixels(const Dxt1Pixels &px, unsigned char *block,
+                    Dxt1Quality quality) {
+  float moments[15];
+  Dxt1_Moments(&px, moments);
+  if (moments[9] == moments[12] && moments[10] == moments[13] &&
+      moments[11] == moments[14]) {
+    CompressSolid(px, block);
+    return;
+  }
+  float e0[3], e1[3];
+  AxisEndpoints(px, moments, e0, e1);
+  Fit best = Evaluate(px, Pack565(e0), Pack565(e1), true);
+  ImproveLeastSquares(px, best, quality == DXT1_QUALITY ? 2 : 1,
+                      quality == DXT1_QUALITY);
+  if (quality == DXT1_QUALITY && best.error > kThreeColourError) {
+    Fit three = Evaluate(px, Pack565(e0), Pack565(e1), false);
+    ImproveLeastSquares(px, three, 1, true);
+    Keep(best, three);
+  }
+  WriteBlock(best, block);
+}
+
+}  // namespace
+
+void Dxt1_CompressBlock(const unsigned char *rgb, unsigned char *block,
+                        Dxt1Quality quality) {
+  Dxt1Pixels px;
+  for (int i = 0; i < 16; i++) {
+    px.r[i] = rgb[3 * i];
+    px.g[i] = rgb[3 * i + 1];
+    px.b[i] = rgb[3 * i + 2];
+  }
+  CompressPixels(px, block, quality);
+}
+
+void Dxt1_CompressImageRGB(const unsigned char *rgb, int width, int height,
+                           void *blocks, Dxt1Quality quality, bool b_flatten,
+                           void (*throttle)(void *), void *throttle_data,
+                           volatile bool &b_abort) {
+  unsigned char *target = (unsigned char *)blocks;
+  unsigned char r_mask = 0xff, g_mask = 0xff, b_mask = 0xff;
+  if (b_flatten) {
+    r_mask = 0xf8;
+    g_mask = 0xfc;
+    b_mask = 0xf8;
+  }
+
+  // images smaller than a block repeat their pixels, like squish
+  int bw = std::min(width, 4);
+  int bh = std::min(height, 4);
+  Dxt1Pixels pixels;
+  for (int y = 0; y < height; y += 4) {
+    for (int x = 0; x < width; x += 4) {
+      for (int py = 0; py < 4; py++) {
+        const unsigned char *row = rgb + 3 * width * (y + py % bh);
+        for (int px = 0; px < 4; px++) {
+          const unsigned char *s = row + 3 * (x + px % bw);
+          int i = 4 * py + px;
+          pixels.r[i] = s[0] & r_mask;
+          pixels.g[i] = s[1] & g_mask;
+          pixels.b[i] = s[2] & b_mask;
+        }
+      }
+      CompressPixels(pixels, target, quality);
+      target += 8;
+    }
+    if (throttle) throttle(throttle_data);
+    if (b_abort) break;
+  }
+}
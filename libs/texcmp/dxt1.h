@@ -0,0 +1,100 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  DXT1 block encoder with SSE2/AVX2 kernels
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef __DXT1_H__
+#define __DXT1_H__
+
+#include <stdint.h>
+
+/** Encoder effort, both modes give opaque blocks for GL_COMPRESSED_RGB. */
+enum Dxt1Quality {
+  /**
+   * Principal axis endpoints and one least squares step rounded to 565,
+   * two index fits a block. For textures uploaded right away.
+   */
+  DXT1_FAST,
+  /**
+   * Two least squares steps with the endpoints searched on the 565 grid,
+   * plus the three colour mode for blocks the four colours fit badly. At
+   * most five index fits a block, for the texture cache.
+   */
+  DXT1_QUALITY
+};
+
+/** Pixels of one 4x4 block, a plane per channel, values 0..255. */
+struct Dxt1Pixels {
+  alignas(32) float r[16];
+  alignas(32) float g[16];
+  alignas(32) float b[16];
+};
+
+/**
+ * Map each pixel to the nearest of the four palette colours, store the
+ * 2 bit indices (pixel 0 in the low bits) and return the summed squared
+ * error. Ties go to the lower index. All values are small integers held
+ * in floats, so every variant gives bit identical results.
+ */
+typedef float (*Dxt1FitFunc)(const Dxt1Pixels *pixels,
+                             const float palette[4][3], uint32_t *indices);
+
+extern Dxt1FitFunc Dxt1_FitIndices;
+
+float Dxt1_FitIndices_generic(const Dxt1Pixels *pixels,
+                              const float palette[4][3], uint32_t *indices);
+float Dxt1_FitIndices_sse2(const Dxt1Pixels *pixels,
+                           const float palette[4][3], uint32_t *indices);
+float Dxt1_FitIndices_avx2(const Dxt1Pixels *pixels,
+                           const float palette[4][3], uint32_t *indices);
+
+/**
+ * Sums of r, g, b, of the products rr, rg, rb, gg, gb, bb, then minimum
+ * and maximum of r, g, b. Exact integers too.
+ */
+typedef void (*Dxt1MomentsFunc)(const Dxt1Pixels *pixels, float moments[15]);
+
+extern Dxt1MomentsFunc Dxt1_Moments;
+
+void Dxt1_Moments_generic(const Dxt1Pixels *pixels, float moments[15]);
+void Dxt1_Moments_sse2(const Dxt1Pixels *pixels, float moments[15]);
+void Dxt1_Moments_avx2(const Dxt1Pixels *pixels, float moments[15]);
+
+/** Select the fastest Dxt1_FitIndices and Dxt1_Moments the cpu supports. */
+void Dxt1_ResolveRoutines();
+
+/** Encode 16 RGB pixels, row by row, into an 8 byte DXT1 block. */
+void Dxt1_CompressBlock(const unsigned char *rgb, unsigned char *block,
+                        Dxt1Quality quality);
+
+/**
+ * Drop-in for squish::CompressImageRGBpow2_Flatten_Throttle_Abort() in
+ * DXT1 mode: encode a width x height RGB image, optionally flattened to
+ * 565 first. throttle is called after each row of blocks, b_abort is
+ * checked there too.
+ */
+void Dxt1_CompressImageRGB(const unsigned char *rgb, int width, int height,
+                           void *blocks, Dxt1Quality quality, bool b_flatten,
+                           void (*throttle)(void *), void *throttle_data,
+                           volatile bool &b_abort);
+
+#endif
@@ -0,0 +1,130 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  DXT1 block encoder with SSE2/AVX2 kernels
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+
+#include "dxt1.h"
+
+#ifdef TEXCMP_HAVE_AVX2
+
+#include <immintrin.h>
+
+static __m128 Low(__m256 v) { return _mm256_castps256_ps128(v); }
+
+static __m128 High(__m256 v) { return _mm256_extractf128_ps(v, 1); }
+
+static float HorizontalSum(__m256 v) {
+  float s[4];
+  _mm_storeu_ps(s, _mm_add_ps(Low(v), High(v)));
+  return (s[0] + s[1]) + (s[2] + s[3]);
+}
+
+static float HorizontalMin(__m256 v) {
+  __m128 h = _mm_min_ps(Low(v), High(v));
+  h = _mm_min_ps(h, _mm_movehl_ps(h, h));
+  h = _mm_min_ss(h, _mm_shuffle_ps(h, h, 1));
+  return _mm_cvtss_f32(h);
+}
+
+static float HorizontalMax(__m256 v) {
+  __m128 h = _mm_max_ps(Low(v), High(v));
+  h = _mm_max_ps(h, _mm_movehl_ps(h, h));
+  h = _mm_max_ss(h, _mm_shuffle_ps(h, h, 1));
+  return _mm_cvtss_f32(h);
+}
+
+// eight pixels a step
+float Dxt1_FitIndices_avx2(const Dxt1Pixels *pixels,
+                           const float palette[4][3], uint32_t *indices) {
+  __m256 total = _mm256_setzero_ps();
+  uint32_t packed = 0;
+  for (int i = 0; i < 16; i += 8) {
+    __m256 r = _mm256_load_ps(pixels->r + i);
+    __m256 g = _mm256_load_ps(pixels->g + i);
+    __m256 b = _mm256_load_ps(pixels->b + i);
+    __m256 best = _mm256_setzero_ps();
+    __m256i best_j = _mm256_setzero_si256();
+    for (int j = 0; j < 4; j++) {
+      __m256 dr = _mm256_sub_ps(r, _mm256_set1_ps(palette[j][0]));
+      __m256 dg = _mm256_sub_ps(g, _mm256_set1_ps(palette[j][1]));
+      __m256 db = _mm256_sub_ps(b, _mm256_set1_ps(palette[j][2]));
+      __m256 e = _mm256_add_ps(_mm256_mul_ps(dr, dr), _mm256_mul_ps(dg, dg));
+      e = _mm256_add_ps(e, _mm256_mul_ps(db, db));
+      if (j == 0) {
+        best = e;
+        continue;
+      }
+      __m256 less = _mm256_cmp_ps(e, best, _CMP_LT_OQ);
+      best = _mm256_min_ps(e, best);
+      best_j = _mm256_blendv_epi8(best_j, _mm256_set1_epi32(j),
+                                  _mm256_castps_si256(less));
+    }
+    total = _mm256_add_ps(total, best);
+
+    // shift lane k into place for pixel i + k, then or all lanes together
+    const __m256i shift = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+    __m256i bits = _mm256_sllv_epi32(best_j, shift);
+    __m128i half = _mm_or_si128(_mm256_castsi256_si128(bits),
+                                _mm256_extracti128_si256(bits, 1));
+    half = _mm_or_si128(half, _mm_srli_si128(half, 8));
+    half = _mm_or_si128(half, _mm_srli_si128(half, 4));
+    packed |= (uint32_t)_mm_cvtsi128_si32(half) << (2 * i);
+  }
+  *indices = packed;
+  return HorizontalSum(total);
+}
+
+void Dxt1_Moments_avx2(const Dxt1Pixels *pixels, float moments[15]) {
+  __m256 c[2][3];
+  for (int h = 0; h < 2; h++) {
+    c[h][0] = _mm256_load_ps(pixels->r + 8 * h);
+    c[h][1] = _mm256_load_ps(pixels->g + 8 * h);
+    c[h][2] = _mm256_load_ps(pixels->b + 8 * h);
+  }
+  static const int kPairs[9][2] = {{0, -1}, {1, -1}, {2, -1}, {0, 0}, {0, 1},
+                                   {0, 2},  {1, 1},  {1, 2},  {2, 2}};
+  for (int k = 0; k < 9; k++) {
+    int a = kPairs[k][0], b = kPairs[k][1];
+    __m256 s = b < 0 ? _mm256_add_ps(c[0][a], c[1][a])
+                     : _mm256_add_ps(_mm256_mul_ps(c[0][a], c[0][b]),
+                                     _mm256_mul_ps(c[1][a], c[1][b]));
+    moments[k] = HorizontalSum(s);
+  }
+  for (int k = 0; k < 3; k++) {
+    moments[9 + k] = HorizontalMin(_mm256_min_ps(c[0][k], c[1][k]));
+    moments[12 + k] = HorizontalMax(_mm256_max_ps(c[0][k], c[1][k]));
+  }
+}
+
+#else
+
+float Dxt1_FitIndices_avx2(const Dxt1Pixels *pixels,
+                           const float palette[4][3], uint32_t *indices) {
+  return Dxt1_FitIndices_generic(pixels, palette, indices);
+}
+
+void Dxt1_Moments_avx2(const Dxt1Pixels *pixels, float moments[15]) {
+  Dxt1_Moments_generic(pixels, moments);
+}
+
+#endif
@@ -0,0 +1,128 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  DXT1 block encoder with SSE2/AVX2 kernels
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+
+#include "dxt1.h"
+
+#ifdef TEXCMP_HAVE_SSE2
+
+#include <emmintrin.h>
+
+static float HorizontalSum(__m128 v) {
+  float s[4];
+  _mm_storeu_ps(s, v);
+  return (s[0] + s[1]) + (s[2] + s[3]);
+}
+
+static float HorizontalMin(__m128 v) {
+  v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+  v = _mm_min_ss(v, _mm_shuffle_ps(v, v, 1));
+  return _mm_cvtss_f32(v);
+}
+
+static float HorizontalMax(__m128 v) {
+  v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+  v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+  return _mm_cvtss_f32(v);
+}
+
+// four pixels a step
+float Dxt1_FitIndices_sse2(const Dxt1Pixels *pixels,
+                           const float palette[4][3], uint32_t *indices) {
+  __m128 total = _mm_setzero_ps();
+  uint32_t packed = 0;
+  for (int i = 0; i < 16; i += 4) {
+    __m128 r = _mm_load_ps(pixels->r + i);
+    __m128 g = _mm_load_ps(pixels->g + i);
+    __m128 b = _mm_load_ps(pixels->b + i);
+    __m128 best = _mm_setzero_ps();
+    __m128i best_j = _mm_setzero_si128();
+    for (int j = 0; j < 4; j++) {
+      __m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[j][0]));
+      __m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[j][1]));
+      __m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[j][2]));
+      __m128 e = _mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg));
+      e = _mm_add_ps(e, _mm_mul_ps(db, db));
+      if (j == 0) {
+        best = e;
+        continue;
+      }
+      __m128i less = _mm_castps_si128(_mm_cmplt_ps(e, best));
+      best = _mm_min_ps(e, best);
+      best_j = _mm_or_si128(_mm_and_si128(less, _mm_set1_epi32(j)),
+                            _mm_andnot_si128(less, best_j));
+    }
+    total = _mm_add_ps(total, best);
+
+    // collect the 2 bit indices, lane k is pixel i + k
+    __m128i bits = best_j;
+    bits = _mm_or_si128(bits, _mm_srli_si128(_mm_slli_epi32(bits, 2), 4));
+    bits = _mm_or_si128(bits, _mm_srli_si128(_mm_slli_epi32(bits, 4), 8));
+    packed |= (uint32_t)_mm_cvtsi128_si32(bits) << (2 * i);
+  }
+  *indices = packed;
+  return HorizontalSum(total);
+}
+
+void Dxt1_Moments_sse2(const Dxt1Pixels *pixels, float moments[15]) {
+  __m128 sum[9], lo[3], hi[3];
+  for (int k = 0; k < 9; k++) sum[k] = _mm_setzero_ps();
+  for (int k = 0; k < 3; k++) {
+    lo[k] = _mm_set1_ps(255);
+    hi[k] = _mm_setzero_ps();
+  }
+  for (int i = 0; i < 16; i += 4) {
+    __m128 c[3] = {_mm_load_ps(pixels->r + i), _mm_load_ps(pixels->g + i),
+                   _mm_load_ps(pixels->b + i)};
+    for (int k = 0; k < 3; k++) {
+      sum[k] = _mm_add_ps(sum[k], c[k]);
+      lo[k] = _mm_min_ps(lo[k], c[k]);
+      hi[k] = _mm_max_ps(hi[k], c[k]);
+    }
+    sum[3] = _mm_add_ps(sum[3], _mm_mul_ps(c[0], c[0]));
+    sum[4] = _mm_add_ps(sum[4], _mm_mul_ps(c[0], c[1]));
+    sum[5] = _mm_add_ps(sum[5], _mm_mul_ps(c[0], c[2]));
+    sum[6] = _mm_add_ps(sum[6], _mm_mul_ps(c[1], c[1]));
+    sum[7] = _mm_add_ps(sum[7], _mm_mul_ps(c[1], c[2]));
+    sum[8] = _mm_add_ps(sum[8], _mm_mul_ps(c[2], c[2]));
+  }
+  for (int k = 0; k < 9; k++) moments[k] = HorizontalSum(sum[k]);
+  for (int k = 0; k < 3; k++) {
+    moments[9 + k] = HorizontalMin(lo[k]);
+    moments[12 + k] = HorizontalMax(hi[k]);
+  }
+}
+
+#else
+
+float Dxt1_FitIndices_sse2(const Dxt1Pixels *pixels,
+                           const float palette[4][3], uint32_t *indices) {
+  return Dxt1_FitIndices_generic(pixels, palette, indices);
+}
+
+void Dxt1_Moments_sse2(const Dxt1Pixels *pixels, float moments[15]) {
+  Dxt1_Moments_generic(pixels, moments);
+}
+
+#endif
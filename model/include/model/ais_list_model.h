@@ -0,0 +1,124 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Incrementally sorted rows of the AIS target list
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef _AIS_LIST_MODEL_H__
+#define _AIS_LIST_MODEL_H__
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <wx/string.h>
+
+/** Sort key of a target list row in the current sort column. */
+struct AisListKey {
+  int rank = 1;          ///< Lower ranks always come first, e.g. SART
+  bool numeric = false;  ///< Compare num if true, else str
+  double num = 0;
+  wxString str;
+  double range = 0;  ///< Secondary key of numeric columns, ascending
+
+  bool operator==(const AisListKey& other) const {
+    return rank == other.rank && numeric == other.numeric &&
+           num == other.num && range == other.range && str == other.str;
+  }
+  bool operator!=(const AisListKey& other) const { return !(*this == other); }
+};
+
+/**
+ * The rows of the AIS target list, keyed by MMSI, in display order.
+ *
+ * The rows are synced with the decoder target list on each refresh:
+ * BeginSync(), Update() for each target to show, EndSync(). Rows not
+ * updated are removed, and only rows whose sort key changed are moved,
+ * by binary insertion unless many moved. The formatted text of each cell
+ * is cached until the row fingerprint changes.
+ *
+ * Without autosort the order is kept: new rows go last and changed keys
+ * do not move rows until Sort() is called.
+ */
+class AisListModel {
+public:
+  AisListModel();
+
+  /** Set the sort direction, takes effect on next Sort(). */
+  void SetReverse(bool reverse) { m_reverse = reverse; }
+
+  void SetAutosort(bool autosort) { m_autosort = autosort; }
+
+  void BeginSync();
+
+  /**
+   * Add or update the row of mmsi with its sort key and a fingerprint of
+   * all fields shown in the row.
+   */
+  void Update(int mmsi, const AisListKey& key, uint64_t fingerprint);
+
+  /** Remove rows not updated since BeginSync(), then fix the order. */
+  void EndSync();
+
+  /** Fully re-sort all rows with the current keys. */
+  void Sort();
+
+  size_t Size() const { return m_order.size(); }
+
+  /** Return MMSI of row in display order, -1 if out of range. */
+  int GetMmsi(long row) const;
+
+  /** Return display position of mmsi, -1 if not present. */
+  long FindRow(int mmsi) const;
+
+  /** Return cached text of a cell, nullptr if not cached. */
+  const wxString* GetCell(long row, int column) const;
+
+  void SetCell(long row, int column, const wxString& text);
+
+  /** Drop all cached cell texts, e.g. after a unit change. */
+  void ClearCells();
+
+  void Clear();
+
+private:
+  struct Row {
+    int mmsi;
+    AisListKey key;
+    uint64_t fingerprint;
+    bool seen;
+    bool moved;
+    size_t pos;
+    std::vector<wxString> cells;
+    std::vector<bool> cell_valid;
+  };
+
+  bool Less(const Row* a, const Row* b) const;
+  void UpdatePositions(size_t from);
+
+  std::unordered_map<int, Row> m_rows;
+  std::vector<Row*> m_order;
+  std::vector<Row*> m_moved;
+  bool m_reverse;
+  bool m_autosort;
+};
+
+#endif  // _AIS_LIST_MODEL_H__
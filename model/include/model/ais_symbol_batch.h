@@ -0,0 +1,144 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Batched geometry of AIS target symbols, predictors and tracks
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef _AIS_SYMBOL_BATCH_H__
+#define _AIS_SYMBOL_BATCH_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct AisBatchColor {
+  uint8_t r, g, b, a;
+};
+
+/**
+ * Vertex of the batched geometry, drawn as GL_TRIANGLES. The screen
+ * position is pos + rotate(scale * local + extrude) where rotate() is the
+ * transrot() rotation in ais.cpp with rot = (sin_theta, cos_theta).
+ * Strokes are widened by extrude so their width in pixels does not
+ * depend on the symbol scale.
+ */
+struct AisBatchVertex {
+  float local[2];
+  float extrude[2];
+  float pos[2];
+  float rot[2];
+  float scale;
+  AisBatchColor color;
+};
+
+/** Placement of a symbol on screen, the default is no rotation. */
+struct AisSymbolInstance {
+  AisSymbolInstance(float x_, float y_, float scale_ = 1,
+                    float sin_theta_ = 1, float cos_theta_ = 0)
+      : x(x_), y(y_), sin_theta(sin_theta_), cos_theta(cos_theta_),
+        scale(scale_) {}
+
+  float x;
+  float y;
+  float sin_theta;
+  float cos_theta;
+  float scale;
+};
+
+/**
+ * Per-frame vertex buffer of AIS target graphics, replacing one draw call
+ * per target element with a single draw of the whole buffer.
+ *
+ * Symbols are templates registered once and instanced by position,
+ * rotation, scale and colour. The instance transform is applied by the
+ * vertex shader, so adding a symbol only copies the template vertices.
+ * Predictor lines, tracks and other strokes share the same buffer as
+ * screen space quads. Geometry is drawn in the order it was added.
+ */
+class AisSymbolBatch {
+public:
+  /**
+   * Add a symbol template and return its id. The outline is a closed
+   * polygon as x, y pairs in symbol units, the fill is given as triangles
+   * of indexes into the outline.
+   */
+  int AddTemplate(const std::vector<float>& outline,
+                  const std::vector<uint16_t>& triangles);
+
+  /** Return fan triangles of a polygon with n points, star shaped at first. */
+  static std::vector<uint16_t> FanTriangles(size_t n, size_t first = 0);
+
+  /** Return the outline of a circle with radius 1 and n points. */
+  static std::vector<float> CircleOutline(size_t n);
+
+  /**
+   * Add an instance of template id. Fill is skipped if its alpha is 0,
+   * the outline if outline_width is 0.
+   */
+  void AddSymbol(int id, const AisSymbolInstance& at, AisBatchColor fill,
+                 AisBatchColor outline, float outline_width);
+
+  /**
+   * Add a convex polygon with n points given as x, y pairs relative to
+   * at, for shapes which change with each target like the real size.
+   */
+  void AddPolygon(const AisSymbolInstance& at, const float* xy, size_t n,
+                  AisBatchColor fill, AisBatchColor outline,
+                  float outline_width);
+
+  /** Add a screen space line with square caps. */
+  void AddLine(float x1, float y1, float x2, float y2, float width,
+               AisBatchColor color);
+
+  /** Add a dashed screen space line, dash and gap lengths in pixels. */
+  void AddDashedLine(float x1, float y1, float x2, float y2, float width,
+                     float dash, float gap, AisBatchColor color);
+
+  /** Add a line strip of n points given as x, y pairs. */
+  void AddPolyline(const float* xy, size_t n, float width,
+                   AisBatchColor color);
+
+  const std::vector<AisBatchVertex>& GetVertices() const { return m_vertices; }
+
+  size_t Size() const { return m_vertices.size(); }
+
+  bool Empty() const { return m_vertices.empty(); }
+
+  /** Drop the geometry of the frame, keeping the templates. */
+  void Clear() { m_vertices.clear(); }
+
+private:
+  struct Template {
+    std::vector<float> outline;
+    std::vector<uint16_t> triangles;
+    std::vector<float> stroke;  ///< local x, y, extrude x, y for width 1
+  };
+
+  void AddVertex(const AisSymbolInstance& at, float lx, float ly, float ex,
+                 float ey, AisBatchColor color);
+  void AddStroke(const AisSymbolInstance& at, float ax, float ay, float bx,
+                 float by, float width, AisBatchColor color, bool cap = true);
+
+  std::vector<Template> m_templates;
+  std::vector<AisBatchVertex> m_vertices;
+};
+
+#endif  // _AIS_SYMBOL_BATCH_H__
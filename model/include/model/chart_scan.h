@@ -0,0 +1,104 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Chart directory listing and scan manifest
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef CHART_SCAN_H__
+#define CHART_SCAN_H__
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <wx/string.h>
+
+/** A file found by ListChartDirFiles(). */
+struct ChartScanFile {
+  wxString path;  ///< As returned by wxDir::GetAllFiles()
+  uint64_t size;
+  int64_t mtime;  ///< Seconds since the epoch, like wxDateTime::GetTicks()
+};
+
+/**
+ * Return all files below dir with size and modification time, the same
+ * files in the same order as a sorted wxDir::GetAllFiles(). Directories
+ * are read and files stat'ed on several threads.
+ */
+std::vector<ChartScanFile> ListChartDirFiles(const wxString& dir);
+
+/**
+ * Size and modification time of the files probed by chart database
+ * updates, the chart class which probed them and whether the probe found a
+ * chart. Lets an update skip files which are unchanged since they were
+ * rejected, and catch changed files even if their modification time went
+ * backwards.
+ *
+ * Stored as a text file, not thread safe.
+ */
+class ChartScanManifest {
+public:
+  enum State {
+    kUnknown,   ///< Never probed by chart_class
+    kChanged,   ///< Probed, but size or time changed since
+    kChart,     ///< Unchanged, probe gave a chart
+    kNotChart,  ///< Unchanged, probe failed
+  };
+
+  State Find(const ChartScanFile& file, const wxString& chart_class) const;
+
+  /**
+   * Record the probe of file by chart_class. Only failures which do not
+   * depend on anything but the file should be recorded, Forget() the
+   * others so the file is probed again.
+   */
+  void Set(const ChartScanFile& file, const wxString& chart_class,
+           bool is_chart);
+
+  void Forget(const ChartScanFile& file);
+
+  /** Drop records below dir not in files, a full listing of dir. */
+  void Prune(const wxString& dir, const std::vector<ChartScanFile>& files);
+
+  void Clear();
+
+  size_t Size() const { return m_records.size(); }
+
+  /** Read manifest file, silently starting from scratch if not usable. */
+  void Load(const wxString& path);
+
+  /** Write manifest file if modified, return false on errors. */
+  bool Save(const wxString& path);
+
+private:
+  struct Record {
+    uint64_t size;
+    int64_t mtime;
+    std::string chart_class;
+    bool is_chart;
+  };
+
+  std::unordered_map<std::string, Record> m_records;  ///< By UTF-8 path
+  bool m_dirty = false;
+};
+
+#endif  // CHART_SCAN_H__
@@ -32,11 +32,16 @@ extern int g_unit_test_1;
 extern int g_unit_test_2;
 extern bool g_start_fullscreen;
 extern bool g_rebuild_gl_cache;
+extern bool g_build_gl_cache;
 extern bool g_parse_all_enc;
 extern bool g_bportable;
 extern bool g_config_wizard;
 extern bool g_bdisable_opengl;
 extern std::string g_configdir;
+extern std::string g_capture_file;
+extern std::string g_trace_file;
+extern std::string g_render_tiles;
+extern std::string g_gl_raster_format;
 extern std::vector<std::string> g_params;
 
 #endif  // _CMDLINE_H__
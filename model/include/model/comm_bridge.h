@@ -30,6 +30,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <wx/event.h>
 #include <wx/log.h>
@@ -45,8 +46,26 @@ typedef struct{
   std::string active_source;
   std::string active_identifier;
   int active_source_address;
+  int active_source_id;      // PrioritySource::source_id, -1 if none
+  int active_identifier_id;  // PrioritySource::identifier_id, -1 if none
 } PriorityContainer;
 
+/**
+ * A source of prioritized data, one per GetPriorityKey() string. The
+ * index in CommBridge::m_sources is the source handle.
+ */
+typedef struct {
+  std::string key;         // as stored in the config priority maps
+  std::string source;      // key up to ';', "<bus> <iface>:<address>"
+  std::string identifier;  // key after ';', like "GPRMC" or a PGN
+  int source_address;
+  int source_id;      // equal for handles with the same source
+  int identifier_id;  // equal for handles with the same identifier, or -1
+} PrioritySource;
+
+/** Priority of each source handle in a category, -1 if not ranked. */
+typedef std::vector<int> PriorityMap;
+
 typedef struct {
   int position_watchdog;
   int variation_watchdog;
@@ -88,8 +107,10 @@ public:
   void OnWatchdogTimer(wxTimerEvent& event);
   bool EvalPriority(std::shared_ptr <const NavMsg> msg,
                             PriorityContainer& active_priority,
-                            std::unordered_map<std::string, int>& priority_map);
+                            PriorityMap& priority_map);
   std::string GetPriorityKey(std::shared_ptr <const NavMsg> msg);
+  /** Return the source handle of msg, created when first seen. */
+  int GetSourceHandle(std::shared_ptr <const NavMsg> msg);
 
   std::vector<std::string> GetPriorityMaps();
   PriorityContainer& GetPriorityContainer(const std::string category);
@@ -130,16 +151,30 @@ private:
   void InitializePriorityContainers();
   void PresetPriorityContainers();
 
-  std::string GetPriorityMap(std::unordered_map<std::string, int> &map);
-  void ApplyPriorityMap(std::unordered_map<std::string, int>& priority_map,
+  std::string GetPriorityMap(const PriorityMap &map);
+  void ApplyPriorityMap(PriorityMap& priority_map,
                         wxString &new_prio, int category);
   void ApplyPriorityMaps(std::vector<std::string> new_maps);
 
   void ClearPriorityMaps();
   void PresetPriorityContainer(PriorityContainer &pc,
-                        const std::unordered_map<std::string, int> &priority_map);
-  void SelectNextLowerPriority(const std::unordered_map<std::string, int> &map,
+                               const PriorityMap &priority_map);
+  void SelectNextLowerPriority(const PriorityMap &map,
                                          PriorityContainer &pc);
+  void SetActiveSource(PriorityContainer &pc, const PrioritySource &source);
+  int GetKeyHandle(const std::string &key);
+
+  /** Message fields which map to a source handle, see GetSourceHandle(). */
+  struct SourceTuple {
+    NavAddr::Bus bus;
+    NavAddr::Bus source_bus;
+    std::string iface;
+    std::string talker;  // N0183
+    std::string type;    // N0183
+    uint64_t pgn;        // N2000
+    int address;         // N2000
+    int handle;
+  };
 
   PriorityContainer active_priority_position;
   PriorityContainer active_priority_velocity;
@@ -148,11 +183,20 @@ private:
   PriorityContainer active_priority_satellites;
   PriorityContainer active_priority_void;
 
-  std::unordered_map<std::string, int> priority_map_position;
-  std::unordered_map<std::string, int> priority_map_velocity;
-  std::unordered_map<std::string, int> priority_map_heading;
-  std::unordered_map<std::string, int> priority_map_variation;
-  std::unordered_map<std::string, int> priority_map_satellites;
+  PriorityMap priority_map_position;
+  PriorityMap priority_map_velocity;
+  PriorityMap priority_map_heading;
+  PriorityMap priority_map_variation;
+  PriorityMap priority_map_satellites;
+
+  std::vector<PrioritySource> m_sources;  // indexed by source handle
+  std::unordered_map<std::string, int> m_key_handles;
+  std::unordered_map<std::string, int> m_source_ids;
+  std::unordered_map<std::string, int> m_identifier_ids;
+  std::vector<SourceTuple> m_tuples;
+  std::unordered_multimap<size_t, int> m_tuple_index;  // hash -> m_tuples
+  std::shared_ptr<const NavMsg> m_last_msg;  // evaluated in several categories
+  int m_last_handle;
 
   int n_LogWatchdogPeriod;
 
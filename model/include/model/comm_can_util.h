@@ -26,8 +26,12 @@
 #ifndef _COMMCANUTIL_H
 #define _COMMCANUTIL_H
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <wx/datetime.h>
 
@@ -76,17 +80,20 @@ public:
   int pgn;
 };
 
-/** Track fast message fragments eventually forming complete messages. */
+/**
+ * Track fast message fragments eventually forming complete messages.
+ * Entries in progress are indexed by (source, destination, PGN, sequence
+ * counter) and are reused once removed, their data buffers included.
+ */
 class FastMessageMap {
 public:
   class Entry {
   public:
     Entry()
-        : time_arrived(wxDateTime::Now()),
-          sid(0), expected_length(0), cursor(0) {}
+        : sid(0), expected_length(0), cursor(0), in_use(false) {}
 
 
-    wxDateTime time_arrived;  ///< time of last fragment.
+    std::chrono::steady_clock::time_point time_arrived;  ///< last fragment.
 
     /// Can header, used to "map" the incoming fast message fragments
     CanHeader header;
@@ -98,10 +105,11 @@ public:
     unsigned int expected_length;  ///< total data length from first frame
     unsigned int cursor;  ///< cursor into the current position in data.
     std::vector<unsigned char> data;  ///< Received data
+    bool in_use;  ///< false for free entries, available to AddNewEntry()
   };
 
   FastMessageMap() : dropped_frames(0),
-                     last_gc_run(wxDateTime::Now()) {}
+                     last_gc_run(std::chrono::steady_clock::now()) {}
 
   Entry operator[](int i) const { return entries[i]; }  /// Getter
   Entry& operator[](int i) { return entries[i]; }       /// Setter
@@ -112,26 +120,36 @@ public:
   /** Allocate a new, fresh entry and return index to it. */
   int AddNewEntry(void);
 
-  /** Insert a new entry, first part of a multipart message. */
+  /**
+   * Insert a new entry, first part of a multipart message. The entry is
+   * removed if data is not a first part.
+   */
   bool InsertEntry(const CanHeader header, const unsigned char* data,
                    int index);
 
   /** Append fragment to existing multipart message. */
   bool AppendEntry(const CanHeader hdr, const unsigned char* data, int index);
 
-  /** Remove entry at pos. */
+  /** Remove entry at pos, making it available for reuse. */
   void Remove(int pos);
 
+  /** Number of messages being reassembled. */
+  size_t InUse() const { return entries.size() - m_free.size(); }
+
   std::vector<Entry> entries;
 
 private:
-  bool IsEntryExpired(unsigned int i);
-  int GarbageCollector(void);
-  void CheckGc();
-
+  static uint64_t Key(const CanHeader& header, unsigned char sid);
+  bool IsEntryExpired(unsigned int i,
+                      std::chrono::steady_clock::time_point now);
+  int GarbageCollector(std::chrono::steady_clock::time_point now);
+  void CheckGc(std::chrono::steady_clock::time_point now);
+
+  std::unordered_map<uint64_t, int> m_index;  ///< Key() -> entries index
+  std::vector<int> m_free;  ///< Removed entries, reused first
   int dropped_frames;
-  wxDateTime last_gc_run;
-  wxDateTime dropped_frame_time;
+  std::chrono::steady_clock::time_point last_gc_run;
+  std::chrono::steady_clock::time_point dropped_frame_time;
 };
 
 
@@ -0,0 +1,161 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Binary capture and timed replay of NavMsg traffic
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+/**
+ * \file
+ * Capture of all NavMsgBus traffic to an append-only binary log, and
+ * replay of such a log at recorded or accelerated speed. Used to
+ * benchmark the comm stack with real traffic.
+ *
+ * The log starts with the 8 bytes "OCPNCAP" + format version. Each record
+ * is a type byte, a 32 bit body size and the body, all integers in host
+ * byte order. Source records define the NavAddr of a 16 bit source id,
+ * message records hold a timestamp in ns since the capture start, the
+ * source id and the bus specific message fields.
+ */
+
+#ifndef _COMM_DRV_CAPTURE_H
+#define _COMM_DRV_CAPTURE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "model/comm_driver.h"
+#include "model/comm_navmsg_bus.h"
+
+/**
+ * Records every message notified on the NavMsgBus once activated. Records
+ * are encoded on the notifying thread into a memory buffer, written to
+ * file in large blocks.
+ */
+class CaptureCommDriver : public AbstractCommDriver {
+public:
+  /** Create driver writing to path, which is truncated. */
+  CaptureCommDriver(const std::string& path);
+  virtual ~CaptureCommDriver();
+
+  /** Messages sent to the driver are not recorded. */
+  bool SendMessage(std::shared_ptr<const NavMsg> msg,
+                   std::shared_ptr<const NavAddr> addr) override {
+    return false;
+  }
+
+  /** Register driver and start recording the bus. */
+  void Activate() override;
+
+  /** Append message to the log, can be called from any thread. */
+  void Record(const NavMsg& msg);
+
+  /** Write buffered records to file. */
+  void Flush();
+
+  bool IsOk() const { return m_file != nullptr; }
+  uint64_t GetCount() const { return m_count; }
+
+private:
+  uint16_t GetSourceId(const NavAddr& addr);
+  void WriteBuffer();
+
+  std::mutex m_mutex;  // protects everything below
+  FILE* m_file;
+  std::vector<unsigned char> m_buffer;
+  std::unordered_map<std::string, uint16_t> m_sources;
+  std::chrono::steady_clock::time_point m_start;
+  std::chrono::steady_clock::time_point m_last_write;
+  std::atomic<uint64_t> m_count;
+
+  NavMsgSubscription m_subscription;
+};
+
+/** Outcome of a ReplayCommDriver run. */
+struct ReplayStats {
+  ReplayStats()
+      : messages(0), bytes(0), log_ns(0), wall_ns(0), max_lag_ns(0) {}
+
+  uint64_t messages;
+  uint64_t bytes;       ///< Sum of message payload sizes
+  uint64_t log_ns;      ///< Recorded duration
+  uint64_t wall_ns;     ///< Replay duration
+  uint64_t max_lag_ns;  ///< Largest delay behind the replay schedule
+  /** Time spent in the listener Notify() for each message. */
+  std::vector<uint32_t> notify_ns;
+};
+
+/**
+ * Plays a CaptureCommDriver log to a listener, normally the NavMsgBus.
+ * Messages are notified at their recorded time divided by speed, or as
+ * fast as possible if speed is zero.
+ */
+class ReplayCommDriver : public AbstractCommDriver {
+public:
+  ReplayCommDriver(const std::string& path, DriverListener& listener,
+                   double speed = 1.0);
+  virtual ~ReplayCommDriver();
+
+  bool SendMessage(std::shared_ptr<const NavMsg> msg,
+                   std::shared_ptr<const NavAddr> addr) override {
+    return false;
+  }
+
+  /** Register driver and start replaying on a separate thread. */
+  void Activate() override;
+
+  /**
+   * Replay the complete log on the calling thread.
+   * @return false if the file cannot be read or is corrupt.
+   */
+  bool Run();
+
+  /** Stop a replay started by Activate() and wait for its thread. */
+  void Stop();
+
+  bool IsDone() const { return m_done; }
+
+  /** Valid once IsDone() is true. */
+  const ReplayStats& GetStats() const { return m_stats; }
+
+private:
+  std::shared_ptr<const NavMsg> Decode(const std::vector<unsigned char>& body,
+                                       uint64_t& t_ns, size_t& bytes);
+  void AddSource(const std::vector<unsigned char>& body);
+
+  std::string m_path;
+  DriverListener& m_listener;
+  double m_speed;
+  std::unordered_map<uint16_t, std::shared_ptr<const NavAddr>> m_sources;
+  ReplayStats m_stats;
+  std::atomic<bool> m_stop;
+  std::atomic<bool> m_done;
+  std::thread m_thread;
+};
+
+#endif  // _COMM_DRV_CAPTURE_H
@@ -32,6 +32,7 @@
 #include <wx/event.h>
 
 #include "model/comm_drv_n0183.h"
+#include "model/comm_navmsg_bus.h"
 #include "model/conn_params.h"
 
 class CommDriverN0183AndroidIntEvent : public wxEvent {
@@ -78,6 +79,7 @@ private:
 
   ConnectionParams m_params;
   DriverListener& m_listener;
+  NavMsgIdCache m_msg_ids;
   void handle_N0183_MSG(CommDriverN0183AndroidIntEvent& event);
 };
 
@@ -57,6 +57,7 @@
 #endif
 
 #include "model/comm_drv_n0183.h"
+#include "model/comm_navmsg_bus.h"
 #include "model/conn_params.h"
 #include "observable.h"
 
@@ -93,6 +94,7 @@ public:
 private:
   ConnectionParams m_params;
   DriverListener& m_listener;
+  NavMsgIdCache m_msg_ids;
 
   void handle_N0183_MSG(CommDriverN0183NetEvent& event);
   wxString GetNetPort() const { return m_net_port; }
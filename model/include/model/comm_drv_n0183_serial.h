@@ -28,6 +28,7 @@
 #include <wx/event.h>
 
 #include "model/comm_drv_n0183.h"
+#include "model/comm_navmsg_bus.h"
 #include "model/comm_out_queue.h"
 #include "model/conn_params.h"
 #include "model/garmin_protocol_mgr.h"
@@ -89,6 +90,12 @@ public:
   bool SendMessage(std::shared_ptr<const NavMsg> msg,
                    std::shared_ptr<const NavAddr> addr) override;
 
+  /** Adds "outputQueue" with the PerfCounter stats of the output queue. */
+  std::unordered_map<std::string, std::string> GetAttributes() const override;
+
+  /** Output messages, drained by the secondary thread. */
+  LockFreeCommOutQueue& GetOutQueue() { return *m_out_queue; }
+
 private:
   bool m_ok;
   std::string m_portstring;
@@ -102,8 +109,9 @@ private:
 
   ConnectionParams m_params;
   DriverListener& m_listener;
+  NavMsgIdCache m_msg_ids;
 
-  std::unique_ptr<CommOutQueue> m_out_queue;
+  std::unique_ptr<LockFreeCommOutQueue> m_out_queue;
 
   void handle_N0183_MSG(CommDriverN0183SerialEvent& event);
 };
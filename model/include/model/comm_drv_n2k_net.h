@@ -26,6 +26,10 @@
 #ifndef _COMMDRIVERN2KNET_H
 #define _COMMDRIVERN2KNET_H
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include <wx/wxprec.h>
 
 #ifndef WX_PRECOMP
@@ -34,6 +38,7 @@
 
 #include "model/comm_can_util.h"
 #include "model/comm_drv_n2k.h"
+#include "model/comm_navmsg_bus.h"
 #include "model/conn_params.h"
 
 #include <wx/datetime.h>
@@ -89,24 +94,34 @@ class MrqContainer;
 class FastMessageMap;
 
 
+/**
+ * Single producer, single consumer byte ring. The producer may put() while
+ * the consumer get()s on another thread without any locking. Bytes which
+ * do not fit are dropped, the consumer owns the unread ones.
+ */
 class circular_buffer {
 public:
+  /** Capacity is size rounded up to a power of two. */
   circular_buffer(size_t size);
-  void reset();
-  size_t capacity() const;
+  size_t capacity() const { return mask_ + 1; }
   size_t size() const;
   bool empty() const;
-  bool full() const;
-  void put(unsigned char item);
+  bool full() const { return size() == capacity(); }
+
+  /** Store up to count bytes, return the number of bytes stored. */
+  size_t put(const unsigned char* data, size_t count);
+  void put(unsigned char item) { put(&item, 1); }
+
+  /** Read up to count bytes to data, return the number of bytes read. */
+  size_t get(unsigned char* data, size_t count);
+  /** Return next byte, or 0 if empty. */
   unsigned char get();
 
 private:
-  std::mutex mutex_;
   std::unique_ptr<unsigned char[]> buf_;
-  size_t head_ = 0;
-  size_t tail_ = 0;
-  const size_t max_size_;
-  bool full_ = 0;
+  size_t mask_;
+  std::atomic<size_t> head_;  // bytes put, written by the producer only
+  std::atomic<size_t> tail_;  // bytes read, written by the consumer only
 };
 
 class CommDriverN2KNet : public CommDriverN2K, public wxEvtHandler {
@@ -142,6 +157,7 @@ public:
 private:
   ConnectionParams m_params;
   DriverListener& m_listener;
+  NavMsgIdCache m_msg_ids;
 
   void handle_N2K_MSG(CommDriverN2KNetEvent& event);
   wxString GetNetPort() const { return m_net_port; }
@@ -168,11 +184,11 @@ private:
   dsPortType GetPortType() const { return m_io_select; }
   wxString GetPort() const { return m_portstring; }
 
-  std::vector<unsigned char> PushFastMsgFragment(const CanHeader& header,
-                                                 int position);
-  std::vector<unsigned char> PushCompleteMsg(const CanHeader header,
-                                             int position,
-                                             const can_frame frame);
+  void PushFastMsgFragment(const CanHeader& header, int position,
+                           std::vector<unsigned char>& data);
+  void PushCompleteMsg(const CanHeader& header, int position,
+                       const can_frame& frame,
+                       std::vector<unsigned char>& data);
 
   void HandleCanFrameInput(can_frame frame);
 
@@ -181,14 +197,14 @@ private:
   bool ChecksumOK(const std::string& sentence);
   void SetOk(bool ok) { m_bok = ok; };
 
-  N2K_Format DetectFormat(std::vector<unsigned char> packet);
-  bool ProcessActisense_ASCII_RAW(std::vector<unsigned char> packet);
-  bool ProcessActisense_ASCII_N2K(std::vector<unsigned char> packet);
-  bool ProcessActisense_N2K(std::vector<unsigned char> packet);
-  bool ProcessActisense_RAW(std::vector<unsigned char> packet);
-  bool ProcessActisense_NGT(std::vector<unsigned char> packet);
-  bool ProcessSeaSmart(std::vector<unsigned char> packet);
-  bool ProcessMiniPlex(std::vector<unsigned char> packet);
+  N2K_Format DetectFormat(const std::vector<unsigned char>& packet);
+  bool ProcessActisense_ASCII_RAW(const std::vector<unsigned char>& packet);
+  bool ProcessActisense_ASCII_N2K(const std::vector<unsigned char>& packet);
+  bool ProcessActisense_N2K(const std::vector<unsigned char>& packet);
+  bool ProcessActisense_RAW(const std::vector<unsigned char>& packet);
+  bool ProcessActisense_NGT(const std::vector<unsigned char>& packet);
+  bool ProcessSeaSmart(const std::vector<unsigned char>& packet);
+  bool ProcessMiniPlex(const std::vector<unsigned char>& packet);
 
 
   bool SendN2KNetwork(std::shared_ptr<const Nmea2000Msg> &msg,
@@ -32,6 +32,7 @@
 
 #include "config.h"
 #include "model/comm_drv_n2k.h"
+#include "model/comm_navmsg_bus.h"
 #include "model/conn_params.h"
 
 #ifndef __ANDROID__
@@ -107,6 +108,7 @@ private:
 
   ConnectionParams m_params;
   DriverListener& m_listener;
+  NavMsgIdCache m_msg_ids;
 
   bool m_bmg47_resp;
   bool m_bmg01_resp;
@@ -22,6 +22,7 @@
 #ifndef _DRIVER_NAVMSG_H
 #define _DRIVER_NAVMSG_H
 
+#include <cstdint>
 #include <memory>
 #include <sstream>
 #include <vector>
@@ -192,6 +193,12 @@ public:
   const std::string name;
 };
 
+/** Interned NavMsg key, see NavMsgBus::GetMsgId(). */
+typedef uint32_t NavMsgId;
+
+/** NavMsg::msg_id of a message whose key is not resolved. */
+const NavMsgId kNoNavMsgId = UINT32_MAX;
+
 /** Actual data sent between application and transport layer */
 class NavMsg : public KeyProvider {
 public:
@@ -209,9 +216,15 @@ public:
 
   std::shared_ptr<const NavAddr> source;
 
+  /**
+   * Interned key(), set by drivers which resolve it once for many
+   * messages, see NavMsgIdCache. Else NavMsgBus::Notify() looks it up.
+   */
+  NavMsgId msg_id;
+
 protected:
   NavMsg(const NavAddr::Bus& _bus, std::shared_ptr<const NavAddr> src)
-      : bus(_bus), source(src){};
+      : bus(_bus), source(src), msg_id(kNoNavMsgId){};
 };
 
 /**
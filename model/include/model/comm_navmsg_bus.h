@@ -30,7 +30,15 @@
 #ifndef _NAVMSG_BUS_H__
 #define _NAVMSG_BUS_H__
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <wx/event.h>
@@ -38,26 +46,180 @@
 
 #include "model/comm_driver.h"
 
+/** How a NavMsgBus subscriber receives its messages. */
+enum class NavMsgDelivery {
+  WxEvent,  ///< ObservedEvt queued to a wxEvtHandler, as for Observable
+  Direct,   ///< Callback run on the thread calling NavMsgBus::Notify()
+  Worker    ///< Callback run in notification order on the bus worker thread
+};
 
 /** The raw message layer, a singleton. */
 class NavMsgBus : public DriverListener {
 public:
+  using Callback = std::function<void(std::shared_ptr<const NavMsg>)>;
+
+  /** Subscription id matching all messages, whatever their key. */
+  static constexpr NavMsgId kAllMsgs = UINT32_MAX;
+
   /* Singleton implementation. */
   static NavMsgBus& GetInstance();
 
   NavMsgBus& operator=(NavMsgBus&) = delete;
   NavMsgBus(const NavMsgBus&) = delete;
+  ~NavMsgBus();
 
   void SendMessage(std::shared_ptr<const NavMsg> message,
                    std::shared_ptr<const NavAddr> address);
 
+  /**
+   * Notify the Observable listeners of message key, and the subscribers of
+   * its interned id. The key is only built if message->msg_id is not set.
+   * Can be called from any thread.
+   */
   void Notify(std::shared_ptr<const NavMsg> message);
 
   /* DriverListener implementation: */
   void Notify(const AbstractCommDriver& driver);
 
+  /**
+   * Return the id of a NavMsg key like NavMsg::key(), interning it on
+   * first use. Ids are stable for the lifetime of the process.
+   */
+  NavMsgId GetMsgId(const std::string& key);
+  NavMsgId GetMsgId(const KeyProvider& kp) { return GetMsgId(kp.GetKey()); }
+
+  /**
+   * Run callback for each message with given id, or for all messages if
+   * id is kAllMsgs, on the notifying thread or the bus worker thread.
+   * Direct callbacks must be short and must not block, they delay the
+   * driver which received the message.
+   * @return Handle used by Unsubscribe().
+   */
+  int Subscribe(NavMsgId id, Callback callback, NavMsgDelivery delivery);
+
+  /** Queue an ObservedEvt of type ev_type to handler for each message. */
+  int Subscribe(NavMsgId id, wxEvtHandler* handler, wxEventType ev_type);
+
+  /**
+   * Remove subscription. A Worker callback may still be running or queued
+   * when this returns, queued messages are dropped before being delivered.
+   */
+  void Unsubscribe(int handle);
+
+private:
+  struct Subscriber {
+    int handle;
+    NavMsgDelivery delivery;
+    Callback callback;
+    wxEvtHandler* handler;
+    wxEventType ev_type;
+    std::atomic<bool> active;
+  };
+
+  using SubscriberList = std::vector<std::shared_ptr<Subscriber>>;
+
+  /** Immutable state read by Notify(), replaced as a whole on changes. */
+  struct Snapshot {
+    std::unordered_map<std::string, NavMsgId> ids;
+    std::vector<std::shared_ptr<Observable>> observables;  // indexed by id
+    std::vector<SubscriberList> subscribers;               // indexed by id
+    SubscriberList all;                                    // kAllMsgs
+  };
+
+  struct Retired {
+    std::unique_ptr<Snapshot> snapshot;
+    unsigned epoch;  // m_epoch when replaced
+  };
+
+  /** Node of the worker queue, the oldest one is a consumed dummy. */
+  struct WorkItem {
+    std::shared_ptr<Subscriber> subscriber;
+    std::shared_ptr<const NavMsg> message;
+    std::atomic<WorkItem*> next;
+  };
+
+  NavMsgBus();
+
+  int AddSubscriber(NavMsgId id, std::shared_ptr<Subscriber> subscriber);
+  unsigned EnterRead();
+  void LeaveRead(unsigned epoch);
+  void Publish(Snapshot* snapshot);
+  void Reclaim();
+  void Dispatch(const SubscriberList& subscribers,
+                std::shared_ptr<const NavMsg> message);
+  void PushWork(WorkItem* item);
+  void StartWorker();
+  void RunWorker();
+
+  std::atomic<Snapshot*> m_snapshot;
+  std::atomic<unsigned> m_epoch;
+  std::atomic<int> m_readers[2];  // by m_epoch parity, see Reclaim()
+  std::atomic<bool> m_has_retired;
+
+  std::mutex m_mutex;  // serializes changes of m_snapshot
+  std::vector<Retired> m_retired;
+  int m_next_handle;
+
+  //  Worker queue: lock free singly linked list, producers append at
+  //  m_work_head, the worker consumes from m_work_tail.
+  std::atomic<WorkItem*> m_work_head;
+  WorkItem* m_work_tail;
+  std::atomic<bool> m_worker_idle;
+  std::atomic<bool> m_stop;
+  std::mutex m_work_mutex;  // worker start and sleep only
+  std::condition_variable m_work_cv;
+  std::thread m_worker;
+};
+
+/**
+ * Resolves the NavMsg::msg_id of received messages from a cheap code like
+ * the PGN, so that a driver builds and interns each key only once. Not
+ * thread safe, one per receiving thread.
+ */
+class NavMsgIdCache {
+public:
+  void Resolve(Nmea2000Msg& msg) { Resolve(msg.PGN.pgn, msg); }
+
+  /** Set msg_id for types up to eight characters, like all NMEA types. */
+  void Resolve(Nmea0183Msg& msg);
+
+  void Resolve(uint64_t code, NavMsg& msg);
+
+private:
+  std::unordered_map<uint64_t, NavMsgId> m_ids;
+};
+
+/** Keeps a NavMsgBus subscription over its lifespan. */
+class NavMsgSubscription final {
+public:
+  NavMsgSubscription() : m_handle(-1) {}
+
+  NavMsgSubscription(NavMsgId id, NavMsgBus::Callback callback,
+                     NavMsgDelivery delivery)
+      : m_handle(NavMsgBus::GetInstance().Subscribe(id, callback, delivery)) {}
+
+  NavMsgSubscription(NavMsgSubscription&& other) : m_handle(other.m_handle) {
+    other.m_handle = -1;
+  }
+
+  NavMsgSubscription(const NavMsgSubscription&) = delete;
+  NavMsgSubscription& operator=(const NavMsgSubscription&) = delete;
+
+  ~NavMsgSubscription() { Reset(); }
+
+  void Init(NavMsgId id, NavMsgBus::Callback callback,
+            NavMsgDelivery delivery) {
+    Reset();
+    m_handle = NavMsgBus::GetInstance().Subscribe(id, callback, delivery);
+  }
+
+  void Reset() {
+    if (m_handle >= 0) NavMsgBus::GetInstance().Unsubscribe(m_handle);
+    m_handle = -1;
+  }
+
 private:
-  NavMsgBus() = default;
+  int m_handle;
 };
 
 #endif  // NAVMSG_BUS_H
@@ -1,14 +1,18 @@
 #ifndef COMM__OUT_QUEUE_H__
 #define COMM__OUT_QUEUE_H__
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "model/lockfree_ring.h"
+
 using namespace std::literals::chrono_literals;
 
 class PerfCounter {
@@ -149,6 +153,97 @@ public:
   bool push_back(const std::string& line) override;
 };
 
+/**
+ * A CommOutQueue sending messages in the order they were pushed, keeping
+ * at most max_buffered messages of each type like CommOutQueue: once a
+ * type has more, its oldest pending message is dropped. Encapsulated
+ * sentences starting with '!' like AIS VDM/VDO are multi-part and per
+ * target, these are never dropped for a newer one.
+ *
+ * Producers and the writer thread share no locks. Messages go through a
+ * bounded lock free FIFO, a push to a full FIFO fails like the former
+ * serial driver queue. Each message type owns a slot counting its queued
+ * messages; dropping the oldest of a type just increments the slot's skip
+ * count, and the writer discards that many messages of the type as it
+ * meets them. Types beyond kMaxTypes are queued without a limit.
+ */
+class LockFreeCommOutQueue : public CommOutQueue {
+public:
+  static const size_t kMaxTypes = 128;
+
+  /**
+   * @param max_buffered Max number of pending messages of a type.
+   * @param fifo_size Max number of queued messages of all types.
+   */
+  explicit LockFreeCommOutQueue(unsigned max_buffered = 12,
+                                size_t fifo_size = 128);
+
+  ~LockFreeCommOutQueue() override;
+
+  /**
+   * Insert line, dropping the oldest pending line of the same type if
+   * there are max_buffered of them.
+   * @return false on invalid input or if the queue is full.
+   */
+  bool push_back(const std::string& line) override;
+
+  /** Return next line, throws std::underflow_error if empty. */
+  std::string pop() override;
+
+  /** Move next line to line and return true, return false if empty. */
+  bool try_pop(std::string& line);
+
+  int size() const override { return m_in_queue.load(); }
+
+  /**
+   * Return counters for all messages. overflow_msgs counts dropped
+   * messages, the rate fields are not maintained.
+   */
+  PerfCounter GetPerf() const;
+
+  /** Return counters like GetPerf() for each message type. */
+  std::unordered_map<uint64_t, PerfCounter> GetTypePerf() const;
+
+private:
+  struct Slot {
+    Slot() : type(0), queued(0), skip(0), msgs_in(0), msgs_out(0),
+             overwritten(0) {}
+    std::atomic<uint64_t> type;  ///< 0: unused
+    std::atomic<int> queued;     ///< Messages of type in the FIFO
+    std::atomic<int> skip;       ///< Oldest queued messages to discard
+    std::atomic<size_t> msgs_in;
+    std::atomic<size_t> msgs_out;
+    std::atomic<size_t> overwritten;
+  };
+
+  struct Item {
+    Item(const std::string& l, Slot* s)
+        : line(l), stamp(std::chrono::steady_clock::now()), slot(s) {}
+    std::string line;
+    std::chrono::time_point<std::chrono::steady_clock> stamp;
+    Slot* slot;  ///< nullptr if not limited
+  };
+
+  /** Return slot for type, claiming a free one if needed, or nullptr. */
+  Slot* FindSlot(uint64_t type);
+
+  /** Take ownership of popped item, update counters and return line. */
+  std::string Release(Item* item);
+
+  const int m_max_buffered;
+  std::unique_ptr<Slot[]> m_slots;
+  LockFreeRing<Item*> m_fifo;
+  std::atomic<bool> m_overrun_flag;
+
+  std::atomic<int> m_in_queue;
+  std::atomic<size_t> m_msgs_in;
+  std::atomic<size_t> m_msgs_out;
+  std::atomic<size_t> m_bytes_in;
+  std::atomic<size_t> m_bytes_out;
+  std::atomic<size_t> m_overflow;
+  std::atomic<size_t> m_delay_us;
+};
+
 /** Add unit test measurements to CommOutQueue. */
 
 class MeasuredCommOutQueue : public CommOutQueue {
@@ -164,6 +259,9 @@ public:
 
   std::string pop() override;
 
+  /** Return a consistent copy of perf, usable from any thread. */
+  PerfCounter GetPerf() const;
+
   std::unordered_map<unsigned long, PerfCounter> msg_perf;
 
   PerfCounter perf;
@@ -0,0 +1,103 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Batch forms of the projections used by ViewPort
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef GEOREF_BATCH_H__
+#define GEOREF_BATCH_H__
+
+#include <cmath>
+
+/*
+ * Batch forms of the georef.h projections and of the pixel transform used
+ * by ViewPort, for polylines with many points. The results are bit
+ * identical to the single point functions: the transcendental parts are
+ * evaluated per point in libm, the rest runs two points per SSE2
+ * instruction in the same order of operations as the single point code.
+ * Both georef.cpp and georef_batch.cpp are built without floating point
+ * contraction so that FMA does not fuse either path on its own.
+ */
+
+/**
+ * Return lon moved by 360 degrees if needed to be within 180 degrees of
+ * lon0, as ViewPort::GetDoublePixFromLL() does before projecting.
+ */
+inline double PhaseLongitude(double lon, double lon0) {
+  if (lon * lon0 < 0.) {
+    if (lon < 0.)
+      lon += 360.;
+    else
+      lon -= 360.;
+  }
+  if (fabs(lon - lon0) > 180.) {
+    if (lon > lon0)
+      lon -= 360.;
+    else
+      lon += 360.;
+  }
+  return lon;
+}
+
+/** PhaseLongitude() of count longitudes. */
+void PhaseLongitudes(const double* lon, int count, double lon0,
+                     double* xlon);
+
+/** toSMcache() of count points, xlon in phase with lon0. */
+void toSMcacheBatch(const double* lat, const double* xlon, int count,
+                    double y30, double lon0, double* x, double* y);
+
+/** toPOLAR() of count points, xlon in phase with lon0. */
+void toPOLARBatch(const double* lat, const double* xlon, int count,
+                  double e, double lat0, double lon0, double* x, double* y);
+
+/** toSTEREO() of count points, xlon in phase with lon0. */
+void toSTEREOBatch(const double* lat, const double* xlon, int count,
+                   double sin_phi0, double cos_phi0, double lon0, double* x,
+                   double* y);
+
+/**
+ * Projected meters to view pixels: scale, rotate, flip the y axis and move
+ * to the center. Points which are not finite, like the far side of the
+ * earth, are passed through unchanged.
+ */
+class ProjectedToPix {
+public:
+  ProjectedToPix(double scale_ppm, double rotation, double center_x,
+                 double center_y)
+      : m_scale(scale_ppm),
+        m_rotation(rotation),
+        m_cos(rotation ? cos(rotation) : 1.),
+        m_sin(rotation ? sin(rotation) : 0.),
+        m_cx(center_x),
+        m_cy(center_y) {}
+
+  void Apply(double easting, double northing, double* x, double* y) const;
+
+  /** Apply() to count points. */
+  void Apply(const double* easting, const double* northing, int count,
+             double* x, double* y) const;
+
+private:
+  double m_scale, m_rotation, m_cos, m_sin, m_cx, m_cy;
+};
+
+#endif  // GEOREF_BATCH_H__
@@ -0,0 +1,129 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Bounded lock-free multi producer, multi consumer queue
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef _LOCKFREE_RING_H__
+#define _LOCKFREE_RING_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/**
+ * Fixed capacity FIFO queue which can be used from any number of threads
+ * without locks. Each cell has a sequence number telling whether it is
+ * free for the producer of a given position or filled for its consumer,
+ * producers and consumers claim positions with a compare and swap on the
+ * shared counters (D. Vyukov's bounded MPMC queue).
+ *
+ * Push() fails rather than blocks when the queue is full, the caller
+ * decides whether to drop or retry.
+ */
+template <typename T>
+class LockFreeRing {
+public:
+  /** Create queue, capacity is rounded up to a power of two. */
+  explicit LockFreeRing(size_t capacity)
+      : m_enqueue_pos(0), m_dequeue_pos(0) {
+    size_t size = 2;
+    while (size < capacity) size *= 2;
+    m_mask = size - 1;
+    m_cells.reset(new Cell[size]);
+    for (size_t i = 0; i < size; i++) m_cells[i].sequence = i;
+  }
+
+  LockFreeRing(const LockFreeRing&) = delete;
+  LockFreeRing& operator=(const LockFreeRing&) = delete;
+
+  /** Append value, return false and leave it untouched if full. */
+  bool Push(T&& value) {
+    size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &m_cells[pos & m_mask];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = std::move(value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /** Move oldest element to value, return false if empty. */
+  bool Pop(T& value) {
+    size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &m_cells[pos & m_mask];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_dequeue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    value = std::move(cell->value);
+    cell->value = T();
+    cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t Capacity() const { return m_mask + 1; }
+
+  /** Approximate number of queued elements. */
+  size_t Size() const {
+    size_t tail = m_dequeue_pos.load(std::memory_order_relaxed);
+    size_t head = m_enqueue_pos.load(std::memory_order_relaxed);
+    return head > tail ? head - tail : 0;
+  }
+
+private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> m_cells;
+  size_t m_mask;
+  alignas(64) std::atomic<size_t> m_enqueue_pos;
+  alignas(64) std::atomic<size_t> m_dequeue_pos;
+};
+
+#endif  // _LOCKFREE_RING_H__
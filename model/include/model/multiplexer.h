@@ -34,6 +34,7 @@
 #endif  // precompiled headers
 
 #include "model/comm_navmsg.h"
+#include "model/nmea_log.h"
 
 class Multiplexer;  // forward
 
@@ -41,10 +42,10 @@ extern Multiplexer* g_pMUX;
 
 struct MuxLogCallbacks {
   std::function<bool()> log_is_active;
-  std::function<void(const std::string&)> log_message;
+  std::function<void(NmeaLogEntry&&)> log_message;
   MuxLogCallbacks()
     : log_is_active([]() { return false; }),
-      log_message([](const std::string& s) { }) { }
+      log_message([](NmeaLogEntry&& entry) { }) { }
 
 };
 
@@ -70,6 +71,11 @@ private:
 
   void InitN2KCommListeners();
 
+  void LogInputEntry(const std::string &msg, const std::string &stream_name,
+                     bool b_filter, bool b_error, bool check_binary);
+  void LogOutputEntry(const std::string &msg, const std::string &stream_name,
+                      const char *color);
+
   void HandleN0183(std::shared_ptr<const Nmea0183Msg> n0183_msg);
   bool HandleN2K_Log(std::shared_ptr<const Nmea2000Msg> n2k_msg);
   std::string N2K_LogMessage_Detail(unsigned int pgn,
@@ -1,14 +1,64 @@
 #ifndef _ABSTRACT_NMEA_LOG__
 #define _ABSTRACT_NMEA_LOG__
 
+#include <ctime>
+#include <string>
+
 #include <wx/string.h>
 
+/**
+ * A log line before formatting, which is done by NmeaLogEntry::Format().
+ * Creating one is cheap enough to be done for each received message.
+ */
+struct NmeaLogEntry {
+  enum class Direction { Input, Output, Formatted };
+
+  NmeaLogEntry()
+      : direction(Direction::Formatted), stamp(0), check_binary(false) {}
+
+  NmeaLogEntry(Direction d, const std::string& c, const std::string& s,
+               const std::string& m, bool check = false)
+      : direction(d),
+        color(c),
+        stream(s),
+        message(m),
+        stamp(std::time(nullptr)),
+        check_binary(check) {}
+
+  /** A line which is logged as is. */
+  explicit NmeaLogEntry(const std::string& line)
+      : direction(Direction::Formatted),
+        message(line),
+        stamp(0),
+        check_binary(false) {}
+
+  /**
+   * Return "<COLOR>[--> ]hh:mm:ss (stream) message". If check_binary is
+   * set non-printable characters are shown as <0xNN>, and input lines are
+   * tagged as errors if there are other ones than CR and LF.
+   */
+  std::string Format() const;
+
+  Direction direction;
+  std::string color;  ///< Legend colour tag like "<GREEN>"
+  std::string stream;
+  std::string message;
+  time_t stamp;
+  bool check_binary;
+};
+
 class NmeaLog {
 public:
 
   /** Add an formatted string to log output. */
   virtual void Add(const wxString& s) = 0;
 
+  /**
+   * Add an entry to log output. The default implementation formats it
+   * right away, a log might queue it and format it later.
+   */
+  virtual void Add(NmeaLogEntry&& entry) { Add(wxString(entry.Format())); }
+
   /** Return true if log is visible i. e., if it's any point using Add(). */
   virtual bool Active() const = 0;
 };
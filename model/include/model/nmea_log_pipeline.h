@@ -0,0 +1,116 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Background formatting and batching of NMEA log lines
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef _NMEA_LOG_PIPELINE_H__
+#define _NMEA_LOG_PIPELINE_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model/lockfree_ring.h"
+#include "model/nmea_log.h"
+
+/** Formatted lines handed over to the log window. */
+struct NmeaLogBatch {
+  NmeaLogBatch() : dropped(0) {}
+
+  std::vector<std::string> lines;  ///< Oldest first
+  uint64_t dropped;  ///< Lines lost since the previous batch
+};
+
+/**
+ * Moves the formatting of NMEA log lines off the GUI thread.
+ *
+ * Producers push raw entries into a lock-free ring from any thread. A
+ * worker drains the ring each interval, formats and filters the entries
+ * and appends them to a pending batch holding at most max_lines lines.
+ * The ready callback runs once when the pending batch becomes non-empty,
+ * the GUI then takes it with TakeBatch(). While the GUI has not taken it
+ * further lines are coalesced into the same batch, so there is at most
+ * one delivery per interval whatever the message rate.
+ *
+ * Entries which do not fit in the ring, and lines pushed out of the batch
+ * before being displayed, are counted as dropped.
+ */
+class NmeaLogPipeline {
+public:
+  explicit NmeaLogPipeline(size_t capacity = 4096);
+  ~NmeaLogPipeline();
+
+  /** Queue entry for formatting, never blocks. */
+  void Push(NmeaLogEntry&& entry);
+
+  /**
+   * Start the worker. ready is called on the worker thread when a batch
+   * becomes available, it must not block.
+   */
+  void Start(size_t max_lines, std::chrono::milliseconds interval,
+             std::function<void()> ready);
+
+  /** Stop the worker, discarding queued entries and the pending batch. */
+  void Stop();
+
+  /**
+   * Have the worker format the entries pushed so far into the pending
+   * batch now and wait until it is done, including a due ready call.
+   * Must not be called from ready.
+   */
+  void Flush();
+
+  /** Only keep lines containing filter, all if empty. */
+  void SetFilter(const std::string& filter);
+
+  /** Return the pending batch and clear it. */
+  NmeaLogBatch TakeBatch();
+
+private:
+  void Run();
+  void Drain();
+
+  LockFreeRing<NmeaLogEntry> m_ring;
+  std::atomic<uint64_t> m_ring_dropped;
+
+  std::mutex m_mutex;  // protects everything below
+  std::condition_variable m_cv;
+  std::condition_variable m_flushed_cv;
+  uint64_t m_flush_requested;  // Flush() calls
+  uint64_t m_flushed;  // Flush() calls served by the worker
+  NmeaLogBatch m_batch;
+  bool m_notified;  // ready called, batch not yet taken
+  std::string m_filter;
+  size_t m_max_lines;
+  std::chrono::milliseconds m_interval;
+  std::function<void()> m_ready;
+  bool m_stop;
+  std::thread m_thread;
+};
+
+#endif  // _NMEA_LOG_PIPELINE_H__
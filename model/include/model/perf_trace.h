@@ -0,0 +1,135 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Lightweight scoped timers for startup and hot path profiling
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef _PERF_TRACE_H__
+#define _PERF_TRACE_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/** A completed PerfScope. */
+struct PerfEvent {
+  const char* name;     ///< Static string, as given to PerfScope
+  const char* category; ///< Static string, as given to PerfScope
+  int64_t start_us;     ///< Start time relative to the trace epoch
+  int64_t duration_us;
+  unsigned thread;      ///< Small integer thread id, see PerfTrace::ThreadId()
+  int depth;            ///< Nesting level within the thread, 0 at top
+};
+
+/**
+ * Process wide store of PerfScope timings. Recording is off by default;
+ * when off a PerfScope costs one atomic load.
+ *
+ * Events can be exported in the Chrome trace event format, viewable
+ * in chrome://tracing or https://ui.perfetto.dev, and summarized in the
+ * log.
+ */
+class PerfTrace {
+public:
+  static PerfTrace& GetInstance();
+
+  /** Category of the startup phases. */
+  static const char* const kStartup;
+
+  /** Default category, used for hot paths like rendering and decoding. */
+  static const char* const kDefault;
+
+  void SetEnabled(bool enabled);
+
+  bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  /** Add a completed event, dropped if the buffer is full. */
+  void Record(const char* name, const char* category,
+              std::chrono::steady_clock::time_point start,
+              std::chrono::steady_clock::time_point end, int depth);
+
+  /** Return a copy of all recorded events in recording order. */
+  std::vector<PerfEvent> GetEvents() const;
+
+  /** Number of events not recorded because the buffer was full. */
+  uint64_t GetDropped() const;
+
+  /** Remove all events. */
+  void Clear();
+
+  /** Write all events as a Chrome trace JSON file, return success. */
+  bool WriteChromeTrace(const std::string& path) const;
+
+  /**
+   * Log the events in category with a depth up to max_depth in start
+   * order, indented by depth, as a timing breakdown headed by title.
+   */
+  void LogSummary(const std::string& title, const char* category,
+                  int max_depth = 2) const;
+
+  /** Return a small integer identifying the calling thread, from 1. */
+  static unsigned ThreadId();
+
+private:
+  PerfTrace();
+
+  static const size_t kMaxEvents = 1 << 20;
+
+  std::atomic<bool> m_enabled;
+  const std::chrono::steady_clock::time_point m_epoch;
+  mutable std::mutex m_mutex;
+  std::vector<PerfEvent> m_events;
+  uint64_t m_dropped;
+};
+
+/**
+ * Times the enclosing scope, or until End() is called, and records it in
+ * PerfTrace if enabled when the scope was entered. name and category must
+ * be static strings. Typical usage:
+ *
+ *     void ChartCanvas::OnPaint(wxPaintEvent& event) {
+ *       PerfScope perf("ChartCanvas::OnPaint");
+ *       ...
+ */
+class PerfScope {
+public:
+  explicit PerfScope(const char* name,
+                     const char* category = PerfTrace::kDefault);
+  ~PerfScope() { End(); }
+
+  PerfScope(const PerfScope&) = delete;
+  PerfScope& operator=(const PerfScope&) = delete;
+
+  /** Stop timing before the end of the scope, no-op if already done. */
+  void End();
+
+private:
+  const char* m_name;
+  const char* m_category;
+  bool m_active;
+  int m_depth;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+#endif  // _PERF_TRACE_H__
@@ -0,0 +1,93 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Persistent cache of plugin library check results
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef PLUGIN_LIB_CACHE_H__
+#define PLUGIN_LIB_CACHE_H__
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/** What is known about a plugin library file without loading it. */
+struct PluginLibInfo {
+  PluginLibInfo()
+      : size(0),
+        mtime(0),
+        compatible(false),
+        loadable(false),
+        api_version(0),
+        version_major(0),
+        version_minor(0) {}
+
+  std::string path;
+  uint64_t size;
+  int64_t mtime;
+  bool compatible;  ///< PluginLoader::CheckPluginCompatibility() result
+  bool loadable;    ///< Loaded successfully, the fields below are valid
+  std::string common_name;
+  int api_version;
+  int version_major;
+  int version_minor;
+};
+
+/**
+ * Library compatibility checks and basic plugin data, keyed by library
+ * path. An entry is only valid as long as the file size and modification
+ * time are unchanged. The cache is stored as a text file, and discarded
+ * when written by another OpenCPN version.
+ *
+ * Lookup() and Update() can be used from any thread.
+ */
+class PluginLibCache {
+public:
+  PluginLibCache(const std::string& path, const std::string& version);
+
+  /** Fill in size and mtime for lib_path, return false if not a file. */
+  static bool Stat(const std::string& lib_path, PluginLibInfo& info);
+
+  /**
+   * Return true and update info if lib_path has a valid entry. info must
+   * have size and mtime as returned by Stat().
+   */
+  bool Lookup(const std::string& lib_path, PluginLibInfo& info) const;
+
+  /** Add or replace the entry for info.path. */
+  void Update(const PluginLibInfo& info);
+
+  /** Read cache file, silently starting from scratch if not usable. */
+  void Load();
+
+  /** Write cache file if modified, return false on errors. */
+  bool Save();
+
+private:
+  const std::string m_path;
+  const std::string m_version;
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, PluginLibInfo> m_entries;
+  bool m_dirty;
+};
+
+#endif  // PLUGIN_LIB_CACHE_H__
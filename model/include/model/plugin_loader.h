@@ -29,6 +29,8 @@
 #define PLUGIN_LOADER_H_GUARD
 
 #include <functional>
+#include <memory>
+#include <mutex>
 
 #include <wx/wx.h>
 #include <wx/bitmap.h>
@@ -39,6 +41,7 @@
 
 #include "model/catalog_parser.h"
 #include "model/plugin_blacklist.h"
+#include "model/plugin_lib_cache.h"
 #include "model/semantic_vers.h"
 #include "observable_evtvar.h"
 #include "ocpn_plugin.h"
@@ -246,7 +249,18 @@ private:
   PluginLoader();
   bool LoadPlugInDirectory(const wxString& plugin_dir, bool load_enabled);
   bool LoadPluginCandidate(const wxString& file_name, bool load_enabled);
+
+  /**
+   * Run CheckPluginCompatibility() for all libraries in file_list lacking
+   * a valid cache entry, using several threads, and cache the results.
+   */
+  void ScanCandidates(const wxArrayString& file_list);
+
+  /** Cached CheckPluginCompatibility(), info is the library cache entry. */
+  bool IsCompatible(const wxString& file_name, PluginLibInfo& info);
+
   std::unique_ptr<AbstractBlacklist> m_blacklist;
+  std::unique_ptr<PluginLibCache> m_lib_cache;
   ArrayOfPlugIns plugin_array;
   wxString m_last_error_string;
   wxString m_plugin_location;
@@ -254,6 +268,7 @@ private:
 #ifdef __WXMSW__
   wxString m_module_name;
   bool m_found_wxwidgets;
+  std::mutex m_module_mutex;
 #endif
 
   const wxBitmap* m_default_plugin_icon;
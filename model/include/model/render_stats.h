@@ -0,0 +1,137 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Frame time and render pass statistics
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef _RENDER_STATS_H__
+#define _RENDER_STATS_H__
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** Percentiles over the last window_size samples. */
+class RollingPercentiles {
+public:
+  explicit RollingPercentiles(size_t window_size = 256);
+
+  void Add(double value);
+
+  /** Number of samples in the window. */
+  size_t Size() const { return m_samples.size(); }
+
+  /** Number of samples added since construction. */
+  uint64_t Count() const { return m_count; }
+
+  /** Most recently added sample, 0 if none. */
+  double Last() const { return m_last; }
+
+  /** Return the nearest-rank p percentile (0..100) in window, 0 if empty. */
+  double Percentile(double p) const;
+
+  /** Largest sample in window, 0 if empty. */
+  double Max() const;
+
+private:
+  const size_t m_window_size;
+  std::vector<double> m_samples;
+  size_t m_next;
+  uint64_t m_count;
+  double m_last;
+};
+
+/** Snapshot of the timing of one render pass, all times in ms. */
+struct RenderPassStats {
+  std::string pass;
+  uint64_t count;  ///< Total number of samples, not just in window
+  double last;
+  double p50;
+  double p95;
+  double p99;
+  double max;
+};
+
+/**
+ * Process wide CPU timings of the passes in a chart canvas frame, fed
+ * by RenderPassTimer. Each pass keeps a rolling window so the
+ * percentiles reflect recent frames. Multiple canvases feed the same
+ * passes.
+ *
+ * Used by the on-screen diagnostic overlay and the REST server, all
+ * methods are thread safe.
+ */
+class RenderStats {
+public:
+  static RenderStats& GetInstance();
+
+  /** Name of the pass covering the complete frame. */
+  static const char* const kFrame;
+
+  /** Add a sample for pass, created on first use. */
+  void Add(const std::string& pass, double ms);
+
+  /** Return all passes in the order they were first seen. */
+  std::vector<RenderPassStats> GetSummary() const;
+
+  /** Return GetSummary() as a JSON object with a "passes" array. */
+  std::string ToJson() const;
+
+  void Clear();
+
+private:
+  RenderStats() = default;
+
+  mutable std::mutex m_mutex;
+  std::vector<std::string> m_order;
+  std::unordered_map<std::string, RollingPercentiles> m_passes;
+};
+
+/**
+ * Adds the time from construction until Stop() or end of scope to a
+ * RenderStats pass:
+ *
+ *     {
+ *       RenderPassTimer timer("DrawDynamicRoutesTracksAndWaypoints");
+ *       DrawDynamicRoutesTracksAndWaypoints(vp);
+ *     }
+ */
+class RenderPassTimer {
+public:
+  explicit RenderPassTimer(const std::string& pass);
+  ~RenderPassTimer() { Stop(); }
+
+  RenderPassTimer(const RenderPassTimer&) = delete;
+  RenderPassTimer& operator=(const RenderPassTimer&) = delete;
+
+  /** Stop timing before the end of the scope, no-op if already done. */
+  void Stop();
+
+private:
+  const std::string m_pass;
+  bool m_active;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+#endif  // _RENDER_STATS_H__
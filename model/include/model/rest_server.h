@@ -171,6 +171,15 @@ public:
  *    - Returns (example):
  *        {"version": "5.8.9" }
  *
+ *  GET /api/render-stats  <br>
+ *  Return chart canvas frame and render pass CPU times in ms over the
+ *  most recent frames. Does not require api_key or source.
+ *    - Parameters: None
+ *    - Returns (example):
+ *        {"unit": "ms", "passes": [{"pass": "Frame", "count": 1200,
+ *          "last": 9.1, "p50": 8.7, "p95": 14.2, "p99": 21.0,
+ *          "max": 35.5}, ...]}
+ *
  *  GET /api/list-routes  <br>
  *  Return list of available routes
  *    - source=`<ip>` Mandatory, origin ip address or hostname.
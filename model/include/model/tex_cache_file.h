@@ -0,0 +1,142 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Memory mapped raster texture cache file
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef TEX_CACHE_FILE_H__
+#define TEX_CACHE_FILE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <wx/string.h>
+
+/** What a cache file holds. A file made for another layout is reset. */
+struct TexCacheLayout {
+  uint32_t format;          ///< GL compressed texture format
+  uint32_t chartdate;       ///< Chart edition, seconds since the epoch
+  uint32_t chartfile_date;  ///< Chart file modification time
+  uint32_t chartfile_size;
+  uint32_t schemes;  ///< Colour schemes
+  uint32_t tiles;    ///< Texture tiles of the chart
+  std::vector<uint32_t> level_sizes;  ///< Bytes of each mip level of a tile
+};
+
+/**
+ * Compressed texture tiles of one chart, each level stored as given by the
+ * caller, usually LZ4 compressed.
+ *
+ * The file starts with a header and an index table with one entry per
+ * colour scheme and tile, giving the offset, size and checksum of each
+ * stored level. Levels are appended to the file, the first level stored
+ * for a tile starts a page and the others a cache line. The file is mapped
+ * read only, Get() returns a pointer into the mapping.
+ *
+ * A level is verified against its checksum when it is first read. A bad
+ * level is dropped from the index so it is built again; opening a file
+ * reads nothing but the header and the index.
+ *
+ * Not thread safe.
+ */
+class TexCacheFile {
+public:
+  static const size_t kPageSize = 4096;
+
+  TexCacheFile();
+  ~TexCacheFile();
+
+  TexCacheFile(const TexCacheFile&) = delete;
+  TexCacheFile& operator=(const TexCacheFile&) = delete;
+
+  /**
+   * Open or create the cache file at path, starting it afresh if it does
+   * not match layout. Return false if the file cannot be used at all.
+   */
+  bool Open(const wxString& path, const TexCacheLayout& layout);
+
+  void Close();
+
+  bool IsOpen() const;
+
+  /** True if the file was created or reset by Open(). */
+  bool IsNew() const { return m_new; }
+
+  /** True if level of tile is stored, not yet verified. */
+  bool Has(unsigned scheme, unsigned tile, unsigned level) const;
+
+  /**
+   * Stored data of level and its size, valid until the next Get(), Put()
+   * or Close(). Return nullptr if missing or corrupt.
+   */
+  const unsigned char* Get(unsigned scheme, unsigned tile, unsigned level,
+                           size_t* size);
+
+  /** Store size bytes of data as level, return false on errors. */
+  bool Put(unsigned scheme, unsigned tile, unsigned level,
+           const unsigned char* data, size_t size);
+
+  /** Levels dropped by Get() since Open() because of bad checksums. */
+  unsigned GetCorruptCount() const { return m_corrupt; }
+
+private:
+  /** Where a level is stored, as in the index. */
+  struct Extent {
+    uint32_t offset;  ///< In kLevelAlign units from the start of file
+    uint32_t size;
+    uint32_t checksum;
+  };
+
+  bool Reset();
+  bool ReadAt(uint64_t offset, void* data, size_t size);
+  bool WriteAt(uint64_t offset, const void* data, size_t size);
+  bool WriteEntry(size_t index);
+  bool Map(uint64_t size);
+  void Unmap();
+  size_t EntrySize() const;
+  uint64_t FileSize();
+
+  std::vector<unsigned char> m_header;  ///< Expected header, as on disk
+  TexCacheLayout m_layout;
+  uint64_t m_data_offset = 0;  ///< First level
+  uint64_t m_end = 0;          ///< End of the stored levels
+
+  std::vector<uint32_t> m_levels;   ///< Per entry, bit mask of the levels
+  std::vector<Extent> m_extents;    ///< Per entry, per level
+  std::vector<uint32_t> m_verified;  ///< Per entry, bit mask of levels
+  bool m_new = false;
+  unsigned m_corrupt = 0;
+
+#ifdef _WIN32
+  void* m_file = nullptr;
+  void* m_mapping = nullptr;
+#else
+  int m_fd = -1;
+#endif
+  const unsigned char* m_map = nullptr;
+  uint64_t m_map_size = 0;
+};
+
+/** Checksum of the cache file entries. */
+uint32_t TexCacheChecksum(const unsigned char* data, size_t size);
+
+#endif  // TEX_CACHE_FILE_H__
@@ -36,6 +36,7 @@
 #include "hyperlink.h"
 #include "route.h"
 #include "vector2D.h"
+#include "model/track_geometry.h"
 
 extern std::vector<Track*> g_TrackList;
 
@@ -165,15 +166,13 @@ public:
 protected:
 //  void Segments(ChartCanvas *cc, std::list<std::list<wxPoint> > &pointlists,
 //                const LLBBox &box, double scale);
-  void DouglasPeuckerReducer(std::vector<TrackPoint *> &list,
-                             std::vector<bool> &keeplist, int from, int to,
-                             double delta);
   double GetXTE(TrackPoint *fm1, TrackPoint *fm2, TrackPoint *to);
   double GetXTE(double fm1Lat, double fm1Lon, double fm2Lat, double fm2Lon,
                 double toLat, double toLon);
 
   std::vector<TrackPoint *> TrackPoints;
   std::vector<std::vector<SubTrack> > SubTracks;
+  TrackGeometry m_geometry;  ///< Projected points for the GL renderer
 
 private:
 //  void GetPointLists(ChartCanvas *cc,
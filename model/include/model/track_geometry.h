@@ -0,0 +1,119 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Cached mercator geometry of tracks at several detail levels
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef _TRACK_GEOMETRY_H__
+#define _TRACK_GEOMETRY_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class TrackPoint;
+
+/**
+ * Line strip of a track projected to mercator meters, cached so drawing
+ * only needs the viewport mapping instead of projecting each point.
+ *
+ * The strip is kept at kLevels levels of detail. Level 0 has all points,
+ * level n > 0 drops points closer than Tolerance(n) meters to the last
+ * kept one, so it is off the full track by at most that distance. Levels
+ * are built on first use and then extended as points are appended.
+ *
+ * Each level is split in chunks with their own reference point, so the
+ * float offsets keep their precision and a chunk can be culled and
+ * uploaded on its own. Consecutive chunks share their joining point.
+ */
+class TrackGeometry {
+public:
+  static const int kLevels = 18;
+
+  struct Chunk {
+    double ref_lat;
+    double ref_lon;
+    double ref_y;           ///< Mercator northing of ref from the equator
+    std::vector<float> xy;  ///< Mercator meters east, north of ref
+    float min_x, min_y, max_x, max_y;
+    unsigned buffer = 0;  ///< GL buffer id owned by the renderer
+    bool dirty = true;    ///< xy changed since buffer was uploaded
+
+    size_t Count() const { return xy.size() / 2; }
+  };
+
+  TrackGeometry() = default;
+  ~TrackGeometry();
+  TrackGeometry(const TrackGeometry&) = delete;
+  TrackGeometry& operator=(const TrackGeometry&) = delete;
+
+  /**
+   * Sync with the track points. Points appended since the last call are
+   * added to the built levels. If points at the end were replaced, like
+   * ActiveTrack does when it drops a point in line, the levels are rolled
+   * back to the last unchanged point first.
+   */
+  void Update(const std::vector<TrackPoint*>& points);
+
+  /** Return the chunks of a level, building it if needed. */
+  std::vector<Chunk>& GetChunks(int level);
+
+  /** Return source index of the last point kept in a built level. */
+  int LastKept(int level) const;
+
+  /** Number of track points the geometry was synced with. */
+  size_t Size() const { return m_points.size(); }
+
+  /** Return the distance in meters a level may be off the track. */
+  static double Tolerance(int level);
+
+  /** Return the coarsest level with tolerance below one pixel. */
+  static int LevelForScale(double view_scale_ppm);
+
+  void Clear();
+
+  /**
+   * Return GL buffers of chunks dropped since the last call. They are
+   * deleted by the renderer when its context is current.
+   */
+  static std::vector<unsigned> TakeReleasedBuffers();
+
+private:
+  struct Level {
+    bool built = false;
+    std::vector<Chunk> chunks;
+    std::vector<uint32_t> kept;  ///< Source index of each kept point
+  };
+
+  void Extend(Level& level, double tolerance, size_t from);
+  void AddKept(Level& level, size_t index);
+  void Truncate(Level& level, size_t size);
+  void Release(Chunk& chunk);
+  void Offset(const Chunk& chunk, size_t index, double* x, double* y) const;
+
+  std::vector<const TrackPoint*> m_points;
+  std::vector<double> m_y;  ///< Mercator northing of each point
+  double m_last_lat = 0;
+  double m_last_lon = 0;
+  Level m_levels[kLevels];
+};
+
+#endif  // _TRACK_GEOMETRY_H__
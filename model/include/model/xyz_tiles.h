@@ -0,0 +1,99 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Web mercator XYZ tile arithmetic
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#ifndef _XYZ_TILES_H__
+#define _XYZ_TILES_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** A web mercator (XYZ, "slippy map") tile, y counted from north. */
+struct TileId {
+  TileId(int z_, int x_, int y_) : z(z_), x(x_), y(y_) {}
+  int z;
+  int x;
+  int y;
+};
+
+/** Longitude of the west edge of tile column x, fractional x allowed. */
+double TileXToLon(double x, int z);
+
+/** Latitude of the north edge of tile row y, fractional y allowed. */
+double TileYToLat(double y, int z);
+
+/** Tile column containing lon, clamped to the valid range. */
+int LonToTileX(double lon, int z);
+
+/** Tile row containing lat, clamped to the valid range. */
+int LatToTileY(double lat, int z);
+
+/**
+ * ViewPort::view_scale_ppm rendering one tile as tile_size pixels at zoom
+ * z, in the mercator units used by toSM().
+ */
+double TileScalePpm(int z, int tile_size = 256);
+
+/** Largest number of tiles in a render job, about 20 GB of PNG tiles. */
+const uint64_t kMaxTilesInBox = 1 << 20;
+
+/** Number of tiles TilesInBox() would return, without a limit. */
+uint64_t CountTilesInBox(double lat_min, double lon_min, double lat_max,
+                         double lon_max, int zmin, int zmax);
+
+/**
+ * All tiles covering the box for each zoom level in [zmin, zmax], or no
+ * tiles at all if there are more than max_tiles.
+ */
+std::vector<TileId> TilesInBox(double lat_min, double lon_min, double lat_max,
+                               double lon_max, int zmin, int zmax,
+                               uint64_t max_tiles = kMaxTilesInBox);
+
+/**
+ * Tile render job as given on the command line:
+ *
+ *     <lat_min>,<lon_min>,<lat_max>,<lon_max>:<zmin>-<zmax>:<output>
+ *
+ * where output is a .mbtiles file or a directory for z/x/y.png files.
+ * Jobs with more than kMaxTilesInBox tiles are rejected.
+ */
+struct TileRenderSpec {
+  TileRenderSpec()
+      : lat_min(0), lon_min(0), lat_max(0), lon_max(0), zmin(0), zmax(0) {}
+
+  /** Parse spec, return empty string if ok else an error message. */
+  std::string Parse(const std::string& spec);
+
+  bool IsMbtiles() const;
+
+  double lat_min;
+  double lon_min;
+  double lat_max;
+  double lon_max;
+  int zmin;
+  int zmax;
+  std::string output;
+};
+
+#endif  // _XYZ_TILES_H__
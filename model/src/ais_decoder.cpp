@@ -64,6 +64,7 @@
 #include "model/multiplexer.h"
 #include "model/navutil_base.h"
 #include "model/own_ship.h"
+#include "model/perf_trace.h"
 #include "model/route_point.h"
 #include "model/select.h"
 #include "SoundFactory.h"
@@ -1623,6 +1624,7 @@ AisError AisDecoder::DecodeSingleVDO(const wxString &str,
 //----------------------------------------------------------------------------------------
 
 AisError AisDecoder::DecodeN0183(const wxString &str) {
+  PerfScope perf("AisDecoder::DecodeN0183");
   AisError ret = AIS_GENERIC_ERROR;
   wxString string_to_parse;
 
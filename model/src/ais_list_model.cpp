@@ -0,0 +1,179 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Incrementally sorted rows of the AIS target list
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+
+#include "model/ais_list_model.h"
+
+/** Re-sort everything if more rows than 1 / kMaxMovedShare moved. */
+static const size_t kMaxMovedShare = 8;
+
+AisListModel::AisListModel() : m_reverse(false), m_autosort(true) {}
+
+bool AisListModel::Less(const Row* a, const Row* b) const {
+  const AisListKey& ka = a->key;
+  const AisListKey& kb = b->key;
+  if (ka.rank != kb.rank) return ka.rank < kb.rank;
+  if (ka.numeric) {
+    if (ka.num != kb.num) return m_reverse ? ka.num > kb.num : ka.num < kb.num;
+    if (ka.range != kb.range) return ka.range < kb.range;
+  } else {
+    int cmp = ka.str.Cmp(kb.str);
+    if (cmp != 0) return m_reverse ? cmp > 0 : cmp < 0;
+  }
+  return a->mmsi < b->mmsi;
+}
+
+void AisListModel::BeginSync() {
+  for (auto& kv : m_rows) kv.second.seen = false;
+}
+
+void AisListModel::Update(int mmsi, const AisListKey& new_key,
+                          uint64_t fingerprint) {
+  // A NaN key would break the ordering
+  AisListKey key = new_key;
+  if (std::isnan(key.num)) key.num = -1;
+  if (std::isnan(key.range)) key.range = -1;
+
+  auto found = m_rows.find(mmsi);
+  if (found == m_rows.end()) {
+    Row& row = m_rows[mmsi];
+    row.mmsi = mmsi;
+    row.key = key;
+    row.fingerprint = fingerprint;
+    row.seen = true;
+    row.moved = true;
+    row.pos = SIZE_MAX;
+    m_moved.push_back(&row);
+    return;
+  }
+  Row& row = found->second;
+  row.seen = true;
+  if (row.fingerprint != fingerprint) {
+    row.fingerprint = fingerprint;
+    row.cell_valid.clear();
+  }
+  if (row.key != key) {
+    row.key = key;
+    if (!row.moved && m_autosort) {
+      row.moved = true;
+      m_moved.push_back(&row);
+    }
+  }
+}
+
+void AisListModel::EndSync() {
+  // Take moved rows out, together with the ones to remove
+  size_t first_change = m_order.size();
+  for (size_t i = 0; i < m_order.size(); i++) {
+    if (!m_order[i]->seen || m_order[i]->moved) {
+      first_change = i;
+      break;
+    }
+  }
+  auto end = std::remove_if(m_order.begin() + first_change, m_order.end(),
+                            [](Row* row) { return !row->seen || row->moved; });
+  m_order.erase(end, m_order.end());
+  for (auto it = m_rows.begin(); it != m_rows.end();) {
+    if (!it->second.seen)
+      it = m_rows.erase(it);
+    else
+      ++it;
+  }
+
+  if (!m_autosort) {
+    // Only new rows are in m_moved, they go last
+    m_order.insert(m_order.end(), m_moved.begin(), m_moved.end());
+  } else if (m_moved.size() * kMaxMovedShare > m_order.size()) {
+    m_order.insert(m_order.end(), m_moved.begin(), m_moved.end());
+    std::sort(m_order.begin(), m_order.end(),
+              [&](const Row* a, const Row* b) { return Less(a, b); });
+    first_change = 0;
+  } else {
+    for (Row* row : m_moved) {
+      auto pos = std::upper_bound(
+          m_order.begin(), m_order.end(), row,
+          [&](const Row* a, const Row* b) { return Less(a, b); });
+      first_change = std::min(first_change,
+                              static_cast<size_t>(pos - m_order.begin()));
+      m_order.insert(pos, row);
+    }
+  }
+  for (Row* row : m_moved) row->moved = false;
+  m_moved.clear();
+  UpdatePositions(first_change);
+}
+
+void AisListModel::Sort() {
+  std::sort(m_order.begin(), m_order.end(),
+            [&](const Row* a, const Row* b) { return Less(a, b); });
+  UpdatePositions(0);
+}
+
+void AisListModel::UpdatePositions(size_t from) {
+  for (size_t i = from; i < m_order.size(); i++) m_order[i]->pos = i;
+}
+
+int AisListModel::GetMmsi(long row) const {
+  if (row < 0 || static_cast<size_t>(row) >= m_order.size()) return -1;
+  return m_order[row]->mmsi;
+}
+
+long AisListModel::FindRow(int mmsi) const {
+  auto found = m_rows.find(mmsi);
+  if (found == m_rows.end()) return -1;
+  return static_cast<long>(found->second.pos);
+}
+
+const wxString* AisListModel::GetCell(long row, int column) const {
+  if (row < 0 || static_cast<size_t>(row) >= m_order.size()) return nullptr;
+  const Row* r = m_order[row];
+  if (column < 0 || static_cast<size_t>(column) >= r->cell_valid.size() ||
+      !r->cell_valid[column])
+    return nullptr;
+  return &r->cells[column];
+}
+
+void AisListModel::SetCell(long row, int column, const wxString& text) {
+  if (row < 0 || static_cast<size_t>(row) >= m_order.size() || column < 0)
+    return;
+  Row* r = m_order[row];
+  if (static_cast<size_t>(column) >= r->cells.size())
+    r->cells.resize(column + 1);
+  if (static_cast<size_t>(column) >= r->cell_valid.size())
+    r->cell_valid.resize(column + 1, false);
+  r->cells[column] = text;
+  r->cell_valid[column] = true;
+}
+
+void AisListModel::ClearCells() {
+  for (auto& kv : m_rows) kv.second.cell_valid.clear();
+}
+
+void AisListModel::Clear() {
+  m_order.clear();
+  m_moved.clear();
+  m_rows.clear();
+}
@@ -0,0 +1,186 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Batched geometry of AIS target symbols, predictors and tracks
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include <cmath>
+
+#include "model/ais_symbol_batch.h"
+
+/** Dashes of a line are capped to keep the vertex count bounded. */
+static const int kMaxDashes = 512;
+
+static const AisSymbolInstance kScreen(0, 0);
+
+int AisSymbolBatch::AddTemplate(const std::vector<float>& outline,
+                                const std::vector<uint16_t>& triangles) {
+  Template t;
+  t.outline = outline;
+  t.triangles = triangles;
+  // Stroke the outline once with width 1 in a scratch batch, instances
+  // only scale the extrusion to the outline width.
+  AisSymbolBatch scratch;
+  size_t n = outline.size() / 2;
+  for (size_t i = 0; i < n; i++) {
+    size_t j = (i + 1) % n;
+    scratch.AddStroke(kScreen, outline[2 * i], outline[2 * i + 1],
+                      outline[2 * j], outline[2 * j + 1], 1, {0, 0, 0, 0});
+  }
+  for (const auto& v : scratch.m_vertices) {
+    t.stroke.push_back(v.local[0]);
+    t.stroke.push_back(v.local[1]);
+    t.stroke.push_back(v.extrude[0]);
+    t.stroke.push_back(v.extrude[1]);
+  }
+  m_templates.push_back(t);
+  return static_cast<int>(m_templates.size()) - 1;
+}
+
+std::vector<uint16_t> AisSymbolBatch::FanTriangles(size_t n, size_t first) {
+  std::vector<uint16_t> triangles;
+  for (size_t i = 1; i + 1 < n; i++) {
+    triangles.push_back(first);
+    triangles.push_back((first + i) % n);
+    triangles.push_back((first + i + 1) % n);
+  }
+  return triangles;
+}
+
+std::vector<float> AisSymbolBatch::CircleOutline(size_t n) {
+  std::vector<float> outline;
+  for (size_t i = 0; i < n; i++) {
+    double a = 2 * M_PI * i / n;
+    outline.push_back(std::cos(a));
+    outline.push_back(std::sin(a));
+  }
+  return outline;
+}
+
+void AisSymbolBatch::AddVertex(const AisSymbolInstance& at, float lx,
+                               float ly, float ex, float ey,
+                               AisBatchColor color) {
+  m_vertices.emplace_back();
+  AisBatchVertex& v = m_vertices.back();
+  v.local[0] = lx;
+  v.local[1] = ly;
+  v.extrude[0] = ex;
+  v.extrude[1] = ey;
+  v.pos[0] = at.x;
+  v.pos[1] = at.y;
+  v.rot[0] = at.sin_theta;
+  v.rot[1] = at.cos_theta;
+  v.scale = at.scale;
+  v.color = color;
+}
+
+void AisSymbolBatch::AddStroke(const AisSymbolInstance& at, float ax,
+                               float ay, float bx, float by, float width,
+                               AisBatchColor color, bool cap) {
+  float dx = bx - ax;
+  float dy = by - ay;
+  float len = std::sqrt(dx * dx + dy * dy);
+  if (len == 0 || width <= 0) return;
+  // Unit direction and normal scaled to half the width. The square caps
+  // close the gaps at the corners of outlines and polylines.
+  float h = width / 2;
+  dx *= h / len;
+  dy *= h / len;
+  float nx = -dy;
+  float ny = dx;
+  if (!cap) dx = dy = 0;
+
+  AddVertex(at, ax, ay, -dx + nx, -dy + ny, color);
+  AddVertex(at, ax, ay, -dx - nx, -dy - ny, color);
+  AddVertex(at, bx, by, dx + nx, dy + ny, color);
+  AddVertex(at, bx, by, dx + nx, dy + ny, color);
+  AddVertex(at, ax, ay, -dx - nx, -dy - ny, color);
+  AddVertex(at, bx, by, dx - nx, dy - ny, color);
+}
+
+void AisSymbolBatch::AddSymbol(int id, const AisSymbolInstance& at,
+                               AisBatchColor fill, AisBatchColor outline,
+                               float outline_width) {
+  if (id < 0 || static_cast<size_t>(id) >= m_templates.size()) return;
+  const Template& t = m_templates[id];
+  if (fill.a) {
+    for (uint16_t i : t.triangles)
+      AddVertex(at, t.outline[2 * i], t.outline[2 * i + 1], 0, 0, fill);
+  }
+  if (outline_width > 0) {
+    for (size_t i = 0; i < t.stroke.size(); i += 4)
+      AddVertex(at, t.stroke[i], t.stroke[i + 1],
+                t.stroke[i + 2] * outline_width,
+                t.stroke[i + 3] * outline_width, outline);
+  }
+}
+
+void AisSymbolBatch::AddPolygon(const AisSymbolInstance& at, const float* xy,
+                                size_t n, AisBatchColor fill,
+                                AisBatchColor outline, float outline_width) {
+  if (n < 2) return;
+  if (fill.a) {
+    for (size_t i = 1; i + 1 < n; i++) {
+      AddVertex(at, xy[0], xy[1], 0, 0, fill);
+      AddVertex(at, xy[2 * i], xy[2 * i + 1], 0, 0, fill);
+      AddVertex(at, xy[2 * i + 2], xy[2 * i + 3], 0, 0, fill);
+    }
+  }
+  if (outline_width > 0) {
+    for (size_t i = 0; i < n; i++) {
+      size_t j = (i + 1) % n;
+      AddStroke(at, xy[2 * i], xy[2 * i + 1], xy[2 * j], xy[2 * j + 1],
+                outline_width, outline);
+    }
+  }
+}
+
+void AisSymbolBatch::AddLine(float x1, float y1, float x2, float y2,
+                             float width, AisBatchColor color) {
+  AddStroke(kScreen, x1, y1, x2, y2, width, color);
+}
+
+void AisSymbolBatch::AddDashedLine(float x1, float y1, float x2, float y2,
+                                   float width, float dash, float gap,
+                                   AisBatchColor color) {
+  float dx = x2 - x1;
+  float dy = y2 - y1;
+  float len = std::sqrt(dx * dx + dy * dy);
+  if (len == 0) return;
+  if (dash <= 0 || gap <= 0 || len / (dash + gap) > kMaxDashes) {
+    AddLine(x1, y1, x2, y2, width, color);
+    return;
+  }
+  dx /= len;
+  dy /= len;
+  for (float s = 0; s < len; s += dash + gap) {
+    float e = std::fmin(s + dash, len);
+    AddStroke(kScreen, x1 + s * dx, y1 + s * dy, x1 + e * dx, y1 + e * dy,
+              width, color, false);
+  }
+}
+
+void AisSymbolBatch::AddPolyline(const float* xy, size_t n, float width,
+                                 AisBatchColor color) {
+  for (size_t i = 0; i + 1 < n; i++)
+    AddLine(xy[2 * i], xy[2 * i + 1], xy[2 * i + 2], xy[2 * i + 3], width,
+            color);
+}
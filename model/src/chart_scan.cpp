@@ -0,0 +1,223 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Chart directory listing and scan manifest
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+#include <wx/dir.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+
+#include "model/chart_scan.h"
+
+static const char* const kMagic = "OCPN-CHART-SCAN 2";
+
+/** More threads do not make a single disk any faster. */
+static const unsigned kMaxScanThreads = 8;
+
+static std::string Utf8(const wxString& s) { return std::string(s.utf8_str()); }
+
+static wxString WithSeparator(const wxString& dir) {
+  if (dir.empty() || wxEndsWithPathSeparator(dir)) return dir;
+  return dir + wxFILE_SEP_PATH;
+}
+
+/** Stat the files of dir into files, add its subdirectories to dirs. */
+static void ListDir(const wxString& dir, std::vector<ChartScanFile>& files,
+                    std::vector<wxString>& dirs) {
+  wxDir d(dir);
+  if (!d.IsOpened()) return;
+  wxString prefix = WithSeparator(dir);
+  wxString name;
+  for (bool ok = d.GetFirst(&name, wxEmptyString, wxDIR_FILES | wxDIR_HIDDEN);
+       ok; ok = d.GetNext(&name)) {
+    ChartScanFile file;
+    file.path = prefix + name;
+    wxStructStat st;
+    if (wxStat(file.path, &st) == 0) {
+      file.size = st.st_size;
+      file.mtime = st.st_mtime;
+    } else {
+      file.size = 0;
+      file.mtime = 0;
+    }
+    files.push_back(file);
+  }
+  for (bool ok = d.GetFirst(&name, wxEmptyString, wxDIR_DIRS | wxDIR_HIDDEN);
+       ok; ok = d.GetNext(&name))
+    dirs.push_back(prefix + name);
+}
+
+std::vector<ChartScanFile> ListChartDirFiles(const wxString& dir) {
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::deque<wxString> pending(1, dir);
+  int busy = 0;
+  std::vector<ChartScanFile> files;
+
+  // Each worker takes directories until none are left and no other worker
+  // can add more
+  auto walk = [&]() {
+    std::vector<ChartScanFile> found;
+    std::vector<wxString> subdirs;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      cond.wait(lock, [&] { return !pending.empty() || busy == 0; });
+      if (pending.empty()) break;
+      wxString path = pending.front();
+      pending.pop_front();
+      busy++;
+      lock.unlock();
+      subdirs.clear();
+      ListDir(path, found, subdirs);
+      lock.lock();
+      busy--;
+      pending.insert(pending.end(), subdirs.begin(), subdirs.end());
+      cond.notify_all();
+    }
+    files.insert(files.end(), found.begin(), found.end());
+  };
+
+  unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+  threads = std::min(threads, kMaxScanThreads);
+  std::vector<std::future<void>> workers;
+  for (unsigned t = 1; t < threads; t++)
+    workers.push_back(std::async(std::launch::async, walk));
+  walk();
+  for (auto& worker : workers) worker.get();
+
+  std::sort(files.begin(), files.end(),
+            [](const ChartScanFile& a, const ChartScanFile& b) {
+              return a.path < b.path;
+            });
+  return files;
+}
+
+ChartScanManifest::State ChartScanManifest::Find(
+    const ChartScanFile& file, const wxString& chart_class) const {
+  auto found = m_records.find(Utf8(file.path));
+  if (found == m_records.end()) return kUnknown;
+  const Record& record = found->second;
+  if (record.chart_class != Utf8(chart_class)) return kUnknown;
+  if (record.size != file.size || record.mtime != file.mtime) return kChanged;
+  return record.is_chart ? kChart : kNotChart;
+}
+
+void ChartScanManifest::Set(const ChartScanFile& file,
+                            const wxString& chart_class, bool is_chart) {
+  Record record = {file.size, file.mtime, Utf8(chart_class), is_chart};
+  auto inserted = m_records.emplace(Utf8(file.path), record);
+  Record& old = inserted.first->second;
+  if (!inserted.second && old.size == record.size &&
+      old.mtime == record.mtime && old.chart_class == record.chart_class &&
+      old.is_chart == record.is_chart)
+    return;
+  old = record;
+  m_dirty = true;
+}
+
+void ChartScanManifest::Forget(const ChartScanFile& file) {
+  if (m_records.erase(Utf8(file.path))) m_dirty = true;
+}
+
+void ChartScanManifest::Prune(const wxString& dir,
+                              const std::vector<ChartScanFile>& files) {
+  std::string prefix = Utf8(WithSeparator(dir));
+  std::unordered_set<std::string> present;
+  for (const auto& file : files) present.insert(Utf8(file.path));
+  for (auto it = m_records.begin(); it != m_records.end();) {
+    if (it->first.compare(0, prefix.size(), prefix) == 0 &&
+        !present.count(it->first)) {
+      it = m_records.erase(it);
+      m_dirty = true;
+    } else {
+      ++it;
+    }
+  }
+}
+
+void ChartScanManifest::Clear() {
+  if (m_records.empty()) return;
+  m_records.clear();
+  m_dirty = true;
+}
+
+void ChartScanManifest::Load(const wxString& path) {
+  m_records.clear();
+  m_dirty = false;
+  std::ifstream stream(path.fn_str());
+  std::string line;
+  if (!std::getline(stream, line) || line != kMagic) return;
+  //  size, mtime, is_chart, chart_class, path
+  while (std::getline(stream, line)) {
+    size_t tab1 = line.find('\t');
+    size_t tab2 = line.find('\t', tab1 + 1);
+    size_t tab3 = line.find('\t', tab2 + 1);
+    size_t tab4 = line.find('\t', tab3 + 1);
+    if (tab4 == std::string::npos) continue;
+    Record record;
+    try {
+      record.size = std::stoull(line.substr(0, tab1));
+      record.mtime = std::stoll(line.substr(tab1 + 1, tab2 - tab1 - 1));
+    } catch (std::logic_error&) {
+      continue;
+    }
+    record.is_chart = line.compare(tab2 + 1, tab3 - tab2 - 1, "1") == 0;
+    record.chart_class = line.substr(tab3 + 1, tab4 - tab3 - 1);
+    m_records[line.substr(tab4 + 1)] = record;
+  }
+}
+
+bool ChartScanManifest::Save(const wxString& path) {
+  if (!m_dirty && wxFileExists(path)) return true;
+  wxString tmp_path = path + ".tmp";
+  {
+    std::ofstream stream(tmp_path.fn_str());
+    stream << kMagic << "\n";
+    for (const auto& kv : m_records) {
+      const Record& record = kv.second;
+      stream << record.size << "\t" << record.mtime << "\t"
+             << (record.is_chart ? 1 : 0) << "\t" << record.chart_class
+             << "\t" << kv.first << "\n";
+    }
+    if (!stream.good()) {
+      wxLogWarning("Cannot write chart scan manifest %s", tmp_path);
+      return false;
+    }
+  }
+  if (!wxRenameFile(tmp_path, path, true)) {
+    wxLogWarning("Cannot update chart scan manifest %s", path);
+    return false;
+  }
+  m_dirty = false;
+  return true;
+}
@@ -24,9 +24,14 @@ int g_unit_test_1 = 0;
 int g_unit_test_2 = 0;
 bool g_start_fullscreen = false;
 bool g_rebuild_gl_cache = false;
+bool g_build_gl_cache = false;
 bool g_parse_all_enc = false;
 bool g_bportable = false;
 bool g_bdisable_opengl = false;
 bool g_config_wizard = false;
 std::string g_configdir;
+std::string g_capture_file;
+std::string g_trace_file;
+std::string g_render_tiles;
+std::string g_gl_raster_format = "dxt1";
 std::vector<std::string> g_params;
@@ -23,6 +23,8 @@
  *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
  **************************************************************************/
 
+#include <functional>
+
 // For compilers that support precompilation, includes "wx.h".
 #include <wx/wxprec.h>
 
@@ -112,7 +114,7 @@ BEGIN_EVENT_TABLE(CommBridge, wxEvtHandler)
 EVT_TIMER(WATCHDOG_TIMER, CommBridge::OnWatchdogTimer)
 END_EVENT_TABLE()
 
-CommBridge::CommBridge() {}
+CommBridge::CommBridge() : m_last_handle(-1) {}
 
 CommBridge::~CommBridge() {}
 
@@ -154,19 +156,21 @@ void CommBridge::PresetWatchdogs() {
   m_watchdogs.satellite_watchdog = 20;
 }
 
-void CommBridge::SelectNextLowerPriority(const std::unordered_map<std::string, int> &map,
+void CommBridge::SelectNextLowerPriority(const PriorityMap &map,
                                          PriorityContainer &pc) {
 
   int best_prio = 100;
-  for (auto it = map.begin(); it != map.end(); it++) {
-      if (it->second > pc.active_priority){
-        best_prio = wxMin(best_prio, it->second);
+  for (int prio : map) {
+      if (prio > pc.active_priority){
+        best_prio = wxMin(best_prio, prio);
       }
     }
 
     pc.active_priority = best_prio;
     pc.active_source.clear();
     pc.active_identifier.clear();
+    pc.active_source_id = -1;
+    pc.active_identifier_id = -1;
 
 }
 
@@ -413,15 +417,16 @@ void CommBridge::OnDriverStateChange(){
 
 }
 
-std::string CommBridge::GetPriorityMap(std::unordered_map<std::string, int> &map){
+std::string CommBridge::GetPriorityMap(const PriorityMap &map){
 
   #define MAX_SOURCES 10
   std::string sa[MAX_SOURCES];
   std::string result;
 
-  for (auto& it: map) {
-    if ((it.second >= 0) && (it.second < MAX_SOURCES))
-      sa[it.second] = it.first;
+  for (size_t handle = 0; handle < map.size(); handle++) {
+    int prio = map[handle];
+    if ((prio >= 0) && (prio < MAX_SOURCES))
+      sa[prio] = m_sources[handle].key;
   }
 
   //build the packed string result
@@ -451,14 +456,16 @@ std::vector<std::string> CommBridge::GetPriorityMaps(){
   return result;
 }
 
-void CommBridge::ApplyPriorityMap(std::unordered_map<std::string, int>& priority_map, wxString &new_prio, int category){
+void CommBridge::ApplyPriorityMap(PriorityMap& priority_map, wxString &new_prio, int category){
   priority_map.clear();
   wxStringTokenizer tk(new_prio, "|");
   int index = 0;
   while (tk.HasMoreTokens()) {
     wxString entry = tk.GetNextToken();
     std::string s_entry(entry.c_str());
-    priority_map[s_entry] = index;
+    int handle = GetKeyHandle(s_entry);
+    priority_map.resize(m_sources.size(), -1);
+    priority_map[handle] = index;
     index++;
   }
 }
@@ -485,30 +492,36 @@ void CommBridge::ApplyPriorityMaps(std::vector<std::string> new_maps){
 }
 
 void CommBridge::PresetPriorityContainer(PriorityContainer &pc,
-                                         const std::unordered_map<std::string, int> &priority_map){
+                                         const PriorityMap &priority_map){
   // Extract some info from the preloaded map
-  // Find the key corresponding to priority 0, the highest
-  std::string key0;
-  for (auto& it: priority_map) {
-    if (it.second == 0)
-      key0 = it.first;
+  // Find the source corresponding to priority 0, the highest
+  int handle0 = -1;
+  for (size_t handle = 0; handle < priority_map.size(); handle++) {
+    if (priority_map[handle] == 0)
+      handle0 = handle;
   }
 
-  wxString this_key(key0.c_str());
-  wxStringTokenizer tkz(this_key, _T(";"));
-  wxString wxs_this_source = tkz.GetNextToken();
-  std::string source = wxs_this_source.ToStdString();
-  wxString wxs_this_identifier = tkz.GetNextToken();
-  std::string this_identifier = wxs_this_identifier.ToStdString();
-
-  wxStringTokenizer tka(wxs_this_source, _T(":"));
-  tka.GetNextToken();
-  int source_address = atoi(tka.GetNextToken().ToStdString().c_str());
-
   pc.active_priority = 0;
-  pc.active_source = source;
-  pc.active_identifier = this_identifier;
-  pc.active_source_address = source_address;
+  pc.active_source.clear();
+  pc.active_identifier.clear();
+  pc.active_source_address = 0;
+  pc.active_source_id = -1;
+  pc.active_identifier_id = -1;
+  if (handle0 >= 0) SetActiveSource(pc, m_sources[handle0]);
+}
+
+void CommBridge::SetActiveSource(PriorityContainer &pc,
+                                 const PrioritySource &source) {
+  //  The strings are only read by the GUI, copy them on changes only
+  if (pc.active_source_id != source.source_id) {
+    pc.active_source = source.source;
+    pc.active_source_address = source.source_address;
+    pc.active_source_id = source.source_id;
+  }
+  if (pc.active_identifier_id != source.identifier_id) {
+    pc.active_identifier = source.identifier;
+    pc.active_identifier_id = source.identifier_id;
+  }
 }
 
 
@@ -1085,6 +1098,18 @@ void CommBridge::InitializePriorityContainers(){
   active_priority_variation.active_source_address = -1;
   active_priority_satellites.active_source_address = -1;
 
+  active_priority_position.active_source_id = -1;
+  active_priority_velocity.active_source_id = -1;
+  active_priority_heading.active_source_id = -1;
+  active_priority_variation.active_source_id = -1;
+  active_priority_satellites.active_source_id = -1;
+
+  active_priority_position.active_identifier_id = -1;
+  active_priority_velocity.active_identifier_id = -1;
+  active_priority_heading.active_identifier_id = -1;
+  active_priority_variation.active_identifier_id = -1;
+  active_priority_satellites.active_identifier_id = -1;
+
   active_priority_void.active_priority = -1;
 
  }
@@ -1218,43 +1243,125 @@ std::string CommBridge::GetPriorityKey(std::shared_ptr <const NavMsg> msg){
 
 }
 
-bool CommBridge::EvalPriority(std::shared_ptr <const NavMsg> msg,
-                                      PriorityContainer& active_priority,
-                                      std::unordered_map<std::string, int>& priority_map) {
+int CommBridge::GetKeyHandle(const std::string &key) {
+  auto it = m_key_handles.find(key);
+  if (it != m_key_handles.end()) return it->second;
+
+  // Split the key once, as "<source>:<address>;<identifier>"
+  PrioritySource ps;
+  ps.key = key;
+  size_t semi = key.find(';');
+  ps.source = key.substr(0, semi);
+  if (semi != std::string::npos)
+    ps.identifier = key.substr(semi + 1, key.find(';', semi + 1) - semi - 1);
+  size_t colon = ps.source.find(':');
+  ps.source_address =
+      colon == std::string::npos ? 0 : atoi(ps.source.c_str() + colon + 1);
+
+  auto sid = m_source_ids.emplace(ps.source, (int)m_source_ids.size());
+  ps.source_id = sid.first->second;
+  ps.identifier_id = -1;
+  if (ps.identifier.size()) {
+    auto iid = m_identifier_ids.emplace(ps.identifier,
+                                        (int)m_identifier_ids.size());
+    ps.identifier_id = iid.first->second;
+  }
 
-  std::string this_key = GetPriorityKey(msg);
-  if (debug_priority) printf("This Key: %s\n", this_key.c_str());
+  int handle = m_sources.size();
+  m_sources.push_back(ps);
+  m_key_handles[key] = handle;
+  return handle;
+}
 
-  // Pull some identifiers from the unique key
-  wxStringTokenizer tkz(this_key, _T(";"));
-  wxString wxs_this_source = tkz.GetNextToken();
-  std::string source = wxs_this_source.ToStdString();
-  wxString wxs_this_identifier = tkz.GetNextToken();
-  std::string this_identifier = wxs_this_identifier.ToStdString();
+int CommBridge::GetSourceHandle(std::shared_ptr <const NavMsg> msg){
+  // Messages are usually evaluated for several categories in a row
+  if (msg == m_last_msg) return m_last_handle;
 
-  wxStringTokenizer tka(wxs_this_source, _T(":"));
-  tka.GetNextToken();
-  int source_address = atoi(tka.GetNextToken().ToStdString().c_str());
+  // Look up the fields making up GetPriorityKey() without building it
+  static const std::string empty;
+  const std::string *talker = &empty;
+  const std::string *type = &empty;
+  uint64_t pgn = 0;
+  int address = 0;
+  if (msg->bus == NavAddr::Bus::N0183) {
+    auto msg_0183 = dynamic_cast<const Nmea0183Msg*>(msg.get());
+    if (msg_0183) {
+      talker = &msg_0183->talker;
+      type = &msg_0183->type;
+    }
+  } else if (msg->bus == NavAddr::Bus::N2000) {
+    auto msg_n2k = dynamic_cast<const Nmea2000Msg*>(msg.get());
+    if (msg_n2k) {
+      pgn = msg_n2k->PGN.pgn;
+      address = msg_n2k->payload.at(7);
+    }
+  }
 
-  // Fetch the established priority for the message
-  int this_priority;
+  std::hash<std::string> hash_string;
+  size_t hash = hash_string(msg->source->iface);
+  hash = hash * 31 + hash_string(*talker);
+  hash = hash * 31 + hash_string(*type);
+  hash = hash * 31 + std::hash<uint64_t>()(pgn);
+  hash = hash * 31 + address;
+  hash = hash * 31 + (size_t)msg->bus * 8 + (size_t)msg->source->bus;
+
+  int handle = -1;
+  auto range = m_tuple_index.equal_range(hash);
+  for (auto it = range.first; it != range.second; it++) {
+    const SourceTuple &t = m_tuples[it->second];
+    if (t.bus == msg->bus && t.source_bus == msg->source->bus &&
+        t.pgn == pgn && t.address == address &&
+        t.iface == msg->source->iface && t.talker == *talker &&
+        t.type == *type) {
+      handle = t.handle;
+      break;
+    }
+  }
+
+  if (handle < 0) {
+    handle = GetKeyHandle(GetPriorityKey(msg));
+    SourceTuple t = {msg->bus, msg->source->bus, msg->source->iface,
+                     *talker, *type, pgn, address, handle};
+    m_tuple_index.emplace(hash, (int)m_tuples.size());
+    m_tuples.push_back(t);
+  }
+
+  m_last_msg = msg;
+  m_last_handle = handle;
+  return handle;
+}
+
+bool CommBridge::EvalPriority(std::shared_ptr <const NavMsg> msg,
+                                      PriorityContainer& active_priority,
+                                      PriorityMap& priority_map) {
+
+  int handle = GetSourceHandle(msg);
+  const PrioritySource &this_source = m_sources[handle];
+  const char *source = this_source.source.c_str();
+  if (debug_priority) printf("This Key: %s\n", this_source.key.c_str());
 
-  auto it = priority_map.find(this_key);
-  if (it == priority_map.end()) {
+  // Fetch the established priority for the message
+  if ((int)priority_map.size() <= handle)
+    priority_map.resize(m_sources.size(), -1);
+  if (priority_map[handle] < 0) {
     // Not found, so make it default highest priority
-    priority_map[this_key] = 0;
+    priority_map[handle] = 0;
   }
 
-  this_priority = priority_map[this_key];
+  int this_priority = priority_map[handle];
 
-  for (auto it = priority_map.begin(); it != priority_map.end(); it++) {
-        if (debug_priority) printf("               priority_map:  %s  %d\n", it->first.c_str(), it->second);
+  if (debug_priority) {
+    for (size_t h = 0; h < priority_map.size(); h++) {
+      if (priority_map[h] >= 0)
+        printf("               priority_map:  %s  %d\n",
+               m_sources[h].key.c_str(), priority_map[h]);
+    }
   }
 
   //Incoming message priority lower than currently active priority?
   //  If so, drop the message
   if (this_priority > active_priority.active_priority){
-    if (debug_priority)  printf("      Drop low priority: %s %d %d \n", source.c_str(), this_priority,
+    if (debug_priority)  printf("      Drop low priority: %s %d %d \n", source, this_priority,
                                   active_priority.active_priority);
     return false;
   }
@@ -1262,11 +1369,9 @@ bool CommBridge::EvalPriority(std::shared_ptr <const NavMsg> msg,
   // A channel returning, after being watchdogged out.
   if (this_priority < active_priority.active_priority){
     active_priority.active_priority = this_priority;
-    active_priority.active_source = source;
-    active_priority.active_identifier = this_identifier;
-    active_priority.active_source_address = source_address;
+    SetActiveSource(active_priority, this_source);
 
-    if (debug_priority) printf("  Restoring high priority: %s %d\n", source.c_str(), this_priority);
+    if (debug_priority) printf("  Restoring high priority: %s %d\n", source, this_priority);
     return true;
   }
 
@@ -1274,91 +1379,60 @@ bool CommBridge::EvalPriority(std::shared_ptr <const NavMsg> msg,
   // Do we see two sources with the same priority?
   // If so, we take the first one, and deprioritize this one.
 
-  if (active_priority.active_source.size()){
+  if (active_priority.active_source_id >= 0){
 
-    if (debug_priority) printf("source: %s\n", source.c_str());
+    if (debug_priority) printf("source: %s\n", source);
     if (debug_priority) printf("active_source: %s\n", active_priority.active_source.c_str());
 
-    if (source.compare(active_priority.active_source) != 0){
+    if (this_source.source_id != active_priority.active_source_id){
 
       // Auto adjust the priority of the this message down
       //First, find the lowest priority in use in this map
       int lowest_priority = -10;     // safe enough
-      for (auto it = priority_map.begin(); it != priority_map.end(); it++) {
-        if (it->second > lowest_priority)
-          lowest_priority = it->second;
+      for (int prio : priority_map) {
+        if (prio > lowest_priority)
+          lowest_priority = prio;
       }
 
-      priority_map[this_key] = lowest_priority + 1;
-      if (debug_priority) printf("          Lowering priority A: %s :%d\n", source.c_str(), priority_map[this_key]);
+      priority_map[handle] = lowest_priority + 1;
+      if (debug_priority) printf("          Lowering priority A: %s :%d\n", source, priority_map[handle]);
       return false;
     }
   }
 
   //  For N0183 message, has the Mnemonic (id) changed?
   //  Example:  RMC and AIVDO from same source.
+  //  Similar for n2k PGN...
 
+  if (msg->bus == NavAddr::Bus::N0183 || msg->bus == NavAddr::Bus::N2000) {
+    if (active_priority.active_identifier_id >= 0){
 
-  if(msg->bus == NavAddr::Bus::N0183){
-    auto msg_0183 = std::dynamic_pointer_cast<const Nmea0183Msg>(msg);
-    if (msg_0183){
-      if (active_priority.active_identifier.size()){
-
-        if (debug_priority) printf("this_identifier: %s\n", this_identifier.c_str());
-        if (debug_priority) printf("active_priority.active_identifier: %s\n", active_priority.active_identifier.c_str());
-
-        if (this_identifier.compare(active_priority.active_identifier) != 0){
-          // if necessary, auto adjust the priority of the this message down
-          //and drop it
-          if (priority_map[this_key] == active_priority.active_priority){
-            int lowest_priority = -10;     // safe enough
-            for (auto it = priority_map.begin(); it != priority_map.end(); it++) {
-              if (it->second > lowest_priority)
-                lowest_priority = it->second;
-            }
-
-            priority_map[this_key] = lowest_priority + 1;
-            if (debug_priority) printf("          Lowering priority B: %s :%d\n", source.c_str(), priority_map[this_key]);
-          }
-
-          return false;
-        }
-      }
-    }
-  }
-
-  //  Similar for n2k PGN...
+      if (debug_priority) printf("this_identifier: %s\n", this_source.identifier.c_str());
+      if (debug_priority) printf("active_priority.active_identifier: %s\n", active_priority.active_identifier.c_str());
 
-  else if(msg->bus == NavAddr::Bus::N2000){
-    auto msg_n2k = std::dynamic_pointer_cast<const Nmea2000Msg>(msg);
-    if (msg_n2k){
-      if (active_priority.active_identifier.size()){
-        if (this_identifier.compare(active_priority.active_identifier) != 0){
-         // if necessary, auto adjust the priority of the this message down
-          //and drop it
-          if (priority_map[this_key] == active_priority.active_priority){
-            int lowest_priority = -10;     // safe enough
-            for (auto it = priority_map.begin(); it != priority_map.end(); it++) {
-              if (it->second > lowest_priority)
-                lowest_priority = it->second;
-            }
-
-            priority_map[this_key] = lowest_priority + 1;
-            if (debug_priority) printf("          Lowering priority: %s :%d\n", source.c_str(), priority_map[this_key]);
+      if (this_source.identifier_id != active_priority.active_identifier_id){
+        // if necessary, auto adjust the priority of the this message down
+        //and drop it
+        if (priority_map[handle] == active_priority.active_priority){
+          int lowest_priority = -10;     // safe enough
+          for (int prio : priority_map) {
+            if (prio > lowest_priority)
+              lowest_priority = prio;
           }
 
-          return false;
+          priority_map[handle] = lowest_priority + 1;
+          if (debug_priority) printf("          Lowering priority B: %s :%d\n", source, priority_map[handle]);
         }
+
+        return false;
       }
     }
   }
 
 
   // Update the records
-  active_priority.active_source = source;
-  active_priority.active_identifier = this_identifier;
-  active_priority.active_source_address = source_address;
-  if (debug_priority) printf("  Accepting high priority: %s %d\n", source.c_str(), this_priority);
+  SetActiveSource(active_priority, this_source);
+  if (debug_priority) printf("  Accepting high priority: %s %d\n", source, this_priority);
 
   return true;
 }
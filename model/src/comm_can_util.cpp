@@ -24,6 +24,7 @@
  **************************************************************************/
 
 #include <algorithm>
+#include <cstring>
 #include <vector>
 
 #include "model/comm_can_util.h"
@@ -106,53 +107,57 @@ bool CanHeader::IsFastMessage() const {
 
 //  FastMessage implementation
 
-bool FastMessageMap::IsEntryExpired(unsigned int i) {
-    return (wxDateTime::Now() - entries[i].time_arrived
-              > wxTimeSpan(0, 0, kEntryMaxAgeSecs));
+uint64_t FastMessageMap::Key(const CanHeader& header, unsigned char sid) {
+  // The top three sid bits is a sequence counter, the rest a frame counter
+  return static_cast<uint64_t>(sid & 0xE0) << 48 |
+         static_cast<uint64_t>(header.source) << 40 |
+         static_cast<uint64_t>(header.destination) << 32 |
+         static_cast<uint32_t>(header.pgn);
 }
 
-void FastMessageMap::CheckGc() {
-  bool last_run_over_age = (wxDateTime::Now() - last_gc_run) > wxTimeSpan(0, 0, kGcIntervalSecs);
-  if (last_run_over_age || entries.size() > kGcThreshold) {
-    GarbageCollector();
-    last_gc_run = wxDateTime::Now();
+bool FastMessageMap::IsEntryExpired(unsigned int i,
+                                    std::chrono::steady_clock::time_point now) {
+  return entries[i].in_use &&
+         now - entries[i].time_arrived > std::chrono::seconds(kEntryMaxAgeSecs);
+}
+
+void FastMessageMap::CheckGc(std::chrono::steady_clock::time_point now) {
+  bool last_run_over_age =
+      now - last_gc_run > std::chrono::seconds(kGcIntervalSecs);
+  if (last_run_over_age || InUse() > static_cast<size_t>(kGcThreshold)) {
+    GarbageCollector(now);
+    last_gc_run = now;
   }
 }
 
 int FastMessageMap::FindMatchingEntry(const CanHeader header,
                                       const unsigned char sid) {
-  for (unsigned i = 0; i < entries.size(); i++) {
-    if (((sid & 0xE0) == (entries[i].sid & 0xE0)) &&
-        (entries[i].header.pgn == header.pgn) &&
-        (entries[i].header.source == header.source) &&
-        (entries[i].header.destination == header.destination)) {
-      return i;
-    }
-  }
-  return kNotFound;
+  auto it = m_index.find(Key(header, sid));
+  return it == m_index.end() ? kNotFound : it->second;
 }
 
 int FastMessageMap::AddNewEntry(void) {
-  entries.push_back(Entry());
-  return entries.size() - 1;
+  int index;
+  if (m_free.empty()) {
+    entries.push_back(Entry());
+    index = entries.size() - 1;
+  } else {
+    index = m_free.back();
+    m_free.pop_back();
+  }
+  entries[index].in_use = true;
+  return index;
 }
 
-int FastMessageMap::GarbageCollector(void) {
-  std::vector<unsigned> stale_entries;
-  bool bremoved;
+int FastMessageMap::GarbageCollector(
+    std::chrono::steady_clock::time_point now) {
   int nremoved = 0;
-  do {
-    bremoved = false;
-    for (unsigned i = 0; i < entries.size(); i++) {
-      if (IsEntryExpired(i)) {
-        Remove(i);
-        nremoved++;
-        bremoved = true;
-        break;
-      }
+  for (unsigned i = 0; i < entries.size(); i++) {
+    if (IsEntryExpired(i, now)) {
+      Remove(i);
+      nremoved++;
     }
-  } while (bremoved);
-
+  }
   return nremoved;
 }
 
@@ -163,7 +168,8 @@ bool FastMessageMap::InsertEntry(const CanHeader header,
   // data[1] Length of data bytes
   // data[2..7] 6 data bytes
 
-  CheckGc();
+  auto now = std::chrono::steady_clock::now();
+  CheckGc(now);
   // Ensure that this is indeed the first frame of a fast message
   if ((data[0] & 0x1F) == 0) {
     int total_data_len;  // will also include padding as we memcpy all of the
@@ -171,43 +177,53 @@ bool FastMessageMap::InsertEntry(const CanHeader header,
     total_data_len = static_cast<unsigned int>(data[1]);
     total_data_len += 7 - ((total_data_len - 6) % 7);
 
-    entries[index].sid = static_cast<unsigned int>(data[0]);
-    entries[index].expected_length = static_cast<unsigned int>(data[1]);
-    entries[index].header = header;
-    entries[index].time_arrived = wxDateTime::Now();
+    Entry& entry = entries[index];
+    entry.sid = static_cast<unsigned int>(data[0]);
+    entry.expected_length = static_cast<unsigned int>(data[1]);
+    entry.header = header;
+    entry.time_arrived = now;
 
-    entries[index].data.resize(total_data_len);
-    memcpy(&entries[index].data[0], &data[2], 6);
+    entry.data.resize(total_data_len);  // keeps capacity of reused entries
+    memcpy(&entry.data[0], &data[2], 6);
     // First frame of a multi-frame Fast Message contains six data bytes.
     // Position the cursor ready for next message
-    entries[index].cursor = 6;
+    entry.cursor = 6;
+    m_index[Key(header, data[0])] = index;
 
     // Fusion, using fast messages to sends frames less than eight bytes
-    return entries[index].expected_length <= 6;
+    return entry.expected_length <= 6;
   }
-  return false;
   // No further processing is performed if this is not a start frame.
   // A start frame may have been dropped and we received a subsequent frame
+  Remove(index);
+  return false;
 }
 
 bool FastMessageMap::AppendEntry(const CanHeader header,
                                  const unsigned char* data, int position) {
+  Entry& entry = entries[position];
   // Check that this is the next message in the sequence
-  if ((entries[position].sid + 1) == data[0]) {
-    memcpy(&entries[position].data[entries[position].cursor], &data[1], 7);
-    entries[position].sid = data[0];
+  if ((entry.sid + 1) == data[0]) {
     // Subsequent messages contains seven data bytes (last message may be padded
     // with 0xFF)
-    entries[position].cursor += 7;
+    if (entry.cursor + 7 > entry.data.size()) {
+      // More frames than announced by the first one, drop the message
+      Remove(position);
+      return false;
+    }
+    memcpy(&entry.data[entry.cursor], &data[1], 7);
+    entry.sid = data[0];
+    entry.cursor += 7;
+    entry.time_arrived = std::chrono::steady_clock::now();
     // Is this the last message ?
-    return entries[position].cursor >= entries[position].expected_length;
+    return entry.cursor >= entry.expected_length;
   } else if ((data[0] & 0x1F) == 0) {
     // We've found a matching entry, however this is a start frame, therefore
     // we've missed an end frame, and now we have a start frame with the same id
     // (top 3 bits). The id has obviously rolled over. Should really double
-    // check that (data[0] & 0xE0) Clear the entry as we don't want to leak
-    // memory, prior to inserting a start frame
-    entries.erase(entries.begin() + position);
+    // check that (data[0] & 0xE0) Clear the entry, prior to inserting a start
+    // frame
+    Remove(position);
     position = AddNewEntry();
     // And now insert it
     InsertEntry(header, data, position);
@@ -217,10 +233,10 @@ bool FastMessageMap::AppendEntry(const CanHeader header,
     // This is not the next frame in the sequence and not a start frame
     // We've dropped an intermedite frame, so free the slot and do no further
     // processing
-    entries.erase(entries.begin() + position);
+    Remove(position);
     // Dropped Frame Statistics
     if (dropped_frames == 0) {
-      dropped_frame_time = wxDateTime::Now();
+      dropped_frame_time = std::chrono::steady_clock::now();
       dropped_frames += 1;
     } else {
       dropped_frames += 1;
@@ -239,8 +255,10 @@ bool FastMessageMap::AppendEntry(const CanHeader header,
 }
 
 void FastMessageMap::Remove(int pos) {
-  if ((unsigned int)(pos + 1) >= entries.size())
-    entries.erase(entries.begin() + pos);
+  Entry& entry = entries[pos];
+  if (!entry.in_use) return;
+  auto it = m_index.find(Key(entry.header, entry.sid));
+  if (it != m_index.end() && it->second == pos) m_index.erase(it);
+  entry.in_use = false;
+  m_free.push_back(pos);
 }
-
-
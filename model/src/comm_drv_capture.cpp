@@ -0,0 +1,450 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Binary capture and timed replay of NavMsg traffic
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+// For compilers that support precompilation, includes "wx.h".
+#include <wx/wxprec.h>
+
+#ifndef WX_PRECOMP
+#include <wx/wx.h>
+#endif  // precompiled headers
+
+#include <algorithm>
+#include <cstring>
+
+#include <wx/log.h>
+
+#include "model/comm_drv_capture.h"
+#include "model/comm_drv_registry.h"
+
+using namespace std;
+using namespace std::chrono;
+
+static const char kMagic[8] = {'O', 'C', 'P', 'N', 'C', 'A', 'P', 1};
+
+enum RecordType : uint8_t { kSourceRecord = 1, kMessageRecord = 2 };
+
+static const size_t kRecordHeaderSize = 5;  // type + body size
+static const size_t kWriteSize = 256 * 1024;
+static const size_t kMaxBodySize = 16 * 1024 * 1024;
+static const auto kMaxWriteDelay = seconds(1);
+
+template <typename T>
+static void Put(vector<unsigned char>& buf, T value) {
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(&value);
+  buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+static void PutString(vector<unsigned char>& buf, const string& s) {
+  Put<uint32_t>(buf, static_cast<uint32_t>(s.size()));
+  buf.insert(buf.end(), s.begin(), s.end());
+}
+
+static void PutBytes(vector<unsigned char>& buf,
+                     const vector<unsigned char>& bytes) {
+  Put<uint32_t>(buf, static_cast<uint32_t>(bytes.size()));
+  buf.insert(buf.end(), bytes.begin(), bytes.end());
+}
+
+/** Bounds checked reads from a record body. */
+class RecordReader {
+public:
+  RecordReader(const vector<unsigned char>& body)
+      : m_pos(body.data()), m_end(body.data() + body.size()), m_ok(true) {}
+
+  template <typename T>
+  T Get() {
+    T value = 0;
+    if (!Check(sizeof(T))) return value;
+    memcpy(&value, m_pos, sizeof(T));
+    m_pos += sizeof(T);
+    return value;
+  }
+
+  string GetString() {
+    uint32_t size = Get<uint32_t>();
+    if (!Check(size)) return "";
+    string s(reinterpret_cast<const char*>(m_pos), size);
+    m_pos += size;
+    return s;
+  }
+
+  vector<unsigned char> GetBytes() {
+    uint32_t size = Get<uint32_t>();
+    if (!Check(size)) return vector<unsigned char>();
+    vector<unsigned char> bytes(m_pos, m_pos + size);
+    m_pos += size;
+    return bytes;
+  }
+
+  bool IsOk() const { return m_ok; }
+
+private:
+  bool Check(size_t size) {
+    if (!m_ok || static_cast<size_t>(m_end - m_pos) < size) m_ok = false;
+    return m_ok;
+  }
+
+  const unsigned char* m_pos;
+  const unsigned char* m_end;
+  bool m_ok;
+};
+
+/** Patch the body size of the record starting at offset. */
+static void EndRecord(vector<unsigned char>& buf, size_t offset) {
+  size_t size = buf.size() - offset - kRecordHeaderSize;
+  uint32_t size32 = static_cast<uint32_t>(size);
+  memcpy(buf.data() + offset + 1, &size32, sizeof(size32));
+}
+
+static size_t BeginRecord(vector<unsigned char>& buf, RecordType type) {
+  size_t offset = buf.size();
+  Put<uint8_t>(buf, type);
+  Put<uint32_t>(buf, 0);
+  return offset;
+}
+
+CaptureCommDriver::CaptureCommDriver(const string& path)
+    : AbstractCommDriver(NavAddr::Bus::TestBus, path),
+      m_start(steady_clock::now()),
+      m_last_write(m_start),
+      m_count(0) {
+  m_file = fopen(path.c_str(), "wb");
+  if (!m_file) {
+    wxLogWarning("Cannot open capture file %s", path.c_str());
+    return;
+  }
+  m_buffer.reserve(kWriteSize + 64 * 1024);
+  m_buffer.insert(m_buffer.end(), kMagic, kMagic + sizeof(kMagic));
+}
+
+CaptureCommDriver::~CaptureCommDriver() {
+  m_subscription.Reset();
+  lock_guard<mutex> lock(m_mutex);
+  if (!m_file) return;
+  WriteBuffer();
+  fclose(m_file);
+  wxLogMessage("Capture: %llu messages written to %s",
+               static_cast<unsigned long long>(m_count.load()),
+               iface.c_str());
+}
+
+void CaptureCommDriver::Activate() {
+  CommDriverRegistry::GetInstance().Activate(shared_from_this());
+
+  //  A Direct callback may still run when the driver is destroyed, it
+  //  only holds a weak reference.
+  weak_ptr<AbstractCommDriver> self = shared_from_this();
+  auto record = [self](shared_ptr<const NavMsg> msg) {
+    auto driver = self.lock();
+    if (driver) static_cast<CaptureCommDriver*>(driver.get())->Record(*msg);
+  };
+  m_subscription.Init(NavMsgBus::kAllMsgs, record, NavMsgDelivery::Direct);
+}
+
+uint16_t CaptureCommDriver::GetSourceId(const NavAddr& addr) {
+  //  Drivers pass sliced NavAddr copies, bus and iface is all there is.
+  string key = NavAddr::BusToString(addr.bus) + "!@!" + addr.iface;
+  auto it = m_sources.find(key);
+  if (it != m_sources.end()) return it->second;
+
+  if (m_sources.size() >= UINT16_MAX) {
+    wxLogWarning("Capture: too many sources, using the first one");
+    return 0;
+  }
+  uint16_t id = static_cast<uint16_t>(m_sources.size());
+  m_sources[key] = id;
+
+  size_t offset = BeginRecord(m_buffer, kSourceRecord);
+  Put<uint16_t>(m_buffer, id);
+  Put<uint8_t>(m_buffer, static_cast<uint8_t>(addr.bus));
+  PutString(m_buffer, addr.iface);
+  EndRecord(m_buffer, offset);
+  return id;
+}
+
+void CaptureCommDriver::Record(const NavMsg& msg) {
+  switch (msg.bus) {
+    case NavAddr::Bus::N0183:
+    case NavAddr::Bus::N2000:
+    case NavAddr::Bus::Signalk:
+    case NavAddr::Bus::Plugin:
+      break;
+    default:
+      return;
+  }
+
+  lock_guard<mutex> lock(m_mutex);
+  if (!m_file) return;
+
+  //  Timestamp taken with the lock held, records are in time order
+  auto now = steady_clock::now();
+  uint16_t source = 0;
+  if (msg.source) source = GetSourceId(*msg.source);
+
+  size_t offset = BeginRecord(m_buffer, kMessageRecord);
+  Put<uint64_t>(m_buffer, duration_cast<nanoseconds>(now - m_start).count());
+  Put<uint16_t>(m_buffer, source);
+  Put<uint8_t>(m_buffer, static_cast<uint8_t>(msg.bus));
+  switch (msg.bus) {
+    case NavAddr::Bus::N0183: {
+      auto& m = static_cast<const Nmea0183Msg&>(msg);
+      PutString(m_buffer, m.talker);
+      PutString(m_buffer, m.type);
+      PutString(m_buffer, m.payload);
+      break;
+    }
+    case NavAddr::Bus::N2000: {
+      auto& m = static_cast<const Nmea2000Msg&>(msg);
+      Put<uint64_t>(m_buffer, m.PGN.pgn);
+      PutBytes(m_buffer, m.payload);
+      break;
+    }
+    case NavAddr::Bus::Signalk: {
+      auto& m = static_cast<const SignalkMsg&>(msg);
+      PutString(m_buffer, m.context_self);
+      PutString(m_buffer, m.context);
+      PutString(m_buffer, m.raw_message);
+      break;
+    }
+    case NavAddr::Bus::Plugin: {
+      auto& m = static_cast<const PluginMsg&>(msg);
+      PutString(m_buffer, m.name);
+      PutString(m_buffer, m.dest_host);
+      PutString(m_buffer, m.message);
+      break;
+    }
+    default:
+      break;
+  }
+  EndRecord(m_buffer, offset);
+  m_count++;
+
+  if (m_buffer.size() >= kWriteSize || now - m_last_write > kMaxWriteDelay) {
+    WriteBuffer();
+    m_last_write = now;
+  }
+}
+
+void CaptureCommDriver::Flush() {
+  lock_guard<mutex> lock(m_mutex);
+  if (!m_file) return;
+  WriteBuffer();
+  fflush(m_file);
+}
+
+void CaptureCommDriver::WriteBuffer() {
+  if (m_buffer.empty()) return;
+  if (fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) != m_buffer.size()) {
+    wxLogWarning("Capture: write error on %s, stopping", iface.c_str());
+    fclose(m_file);
+    m_file = nullptr;
+  }
+  m_buffer.clear();
+}
+
+ReplayCommDriver::ReplayCommDriver(const string& path, DriverListener& l,
+                                   double speed)
+    : AbstractCommDriver(NavAddr::Bus::TestBus, path),
+      m_path(path),
+      m_listener(l),
+      m_speed(speed),
+      m_stop(false),
+      m_done(false) {}
+
+ReplayCommDriver::~ReplayCommDriver() { Stop(); }
+
+void ReplayCommDriver::Activate() {
+  CommDriverRegistry::GetInstance().Activate(shared_from_this());
+  if (m_thread.joinable()) return;
+  m_thread = thread([this] { Run(); });
+}
+
+void ReplayCommDriver::Stop() {
+  m_stop = true;
+  if (m_thread.joinable()) m_thread.join();
+}
+
+/** Read next record, return 1 if ok, 0 at end of file and -1 on errors. */
+static int ReadRecord(FILE* f, vector<unsigned char>& body, uint8_t& type) {
+  unsigned char header[kRecordHeaderSize];
+  size_t n = fread(header, 1, sizeof(header), f);
+  if (n == 0 && feof(f)) return 0;
+  if (n != sizeof(header)) return -1;
+  type = header[0];
+  uint32_t size;
+  memcpy(&size, header + 1, sizeof(size));
+  if (size > kMaxBodySize) return -1;
+  body.resize(size);
+  if (size && fread(body.data(), 1, size, f) != size) return -1;
+  return 1;
+}
+
+void ReplayCommDriver::AddSource(const vector<unsigned char>& body) {
+  RecordReader reader(body);
+  uint16_t id = reader.Get<uint16_t>();
+  auto bus = static_cast<NavAddr::Bus>(reader.Get<uint8_t>());
+  string iface = reader.GetString();
+  if (reader.IsOk()) m_sources[id] = make_shared<const NavAddr>(bus, iface);
+}
+
+shared_ptr<const NavMsg> ReplayCommDriver::Decode(
+    const vector<unsigned char>& body, uint64_t& t_ns, size_t& bytes) {
+  RecordReader reader(body);
+  t_ns = reader.Get<uint64_t>();
+  uint16_t source_id = reader.Get<uint16_t>();
+  auto bus = static_cast<NavAddr::Bus>(reader.Get<uint8_t>());
+
+  shared_ptr<const NavAddr> source;
+  auto it = m_sources.find(source_id);
+  if (it != m_sources.end())
+    source = it->second;
+  else
+    source = make_shared<const NavAddr>(bus, "");
+
+  shared_ptr<const NavMsg> msg;
+  switch (bus) {
+    case NavAddr::Bus::N0183: {
+      string talker = reader.GetString();
+      string type = reader.GetString();
+      string payload = reader.GetString();
+      bytes = payload.size();
+      //  The constructor splits talker and type, "ALL" copies must not be
+      auto m = make_shared<const Nmea0183Msg>(talker + type, payload, source);
+      if (m->type != type) m = make_shared<const Nmea0183Msg>(*m, type);
+      msg = m;
+      break;
+    }
+    case NavAddr::Bus::N2000: {
+      uint64_t pgn = reader.Get<uint64_t>();
+      vector<unsigned char> payload = reader.GetBytes();
+      bytes = payload.size();
+      msg = make_shared<const Nmea2000Msg>(pgn, payload, source);
+      break;
+    }
+    case NavAddr::Bus::Signalk: {
+      string context_self = reader.GetString();
+      string context = reader.GetString();
+      string raw_message = reader.GetString();
+      bytes = raw_message.size();
+      msg = make_shared<const SignalkMsg>(context_self, context, raw_message,
+                                          source->iface);
+      break;
+    }
+    case NavAddr::Bus::Plugin: {
+      string name = reader.GetString();
+      string dest_host = reader.GetString();
+      string message = reader.GetString();
+      bytes = message.size();
+      msg = make_shared<const PluginMsg>(name, dest_host, message);
+      break;
+    }
+    default:
+      return nullptr;
+  }
+  return reader.IsOk() ? msg : nullptr;
+}
+
+bool ReplayCommDriver::Run() {
+  m_done = false;
+  m_stats = ReplayStats();
+  m_sources.clear();
+
+  FILE* f = fopen(m_path.c_str(), "rb");
+  if (!f) {
+    wxLogWarning("Replay: cannot open %s", m_path.c_str());
+    m_done = true;
+    return false;
+  }
+  setvbuf(f, nullptr, _IOFBF, 1024 * 1024);
+
+  char magic[sizeof(kMagic)];
+  bool ok = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+            memcmp(magic, kMagic, sizeof(magic)) == 0;
+  if (!ok) {
+    wxLogWarning("Replay: %s is not a capture file", m_path.c_str());
+    fclose(f);
+    m_done = true;
+    return false;
+  }
+
+  vector<unsigned char> body;
+  bool have_first = false;
+  uint64_t first_ns = 0;
+  auto start = steady_clock::now();
+  while (!m_stop) {
+    uint8_t type;
+    int status = ReadRecord(f, body, type);
+    if (status <= 0) {
+      ok = status == 0;
+      break;
+    }
+    if (type == kSourceRecord) {
+      AddSource(body);
+      continue;
+    }
+    if (type != kMessageRecord) continue;  // from a later format
+
+    uint64_t t_ns;
+    size_t bytes = 0;
+    auto msg = Decode(body, t_ns, bytes);
+    if (!msg) {
+      ok = false;
+      break;
+    }
+    if (!have_first) {
+      first_ns = t_ns;
+      have_first = true;
+    }
+    uint64_t log_ns = t_ns >= first_ns ? t_ns - first_ns : 0;
+
+    if (m_speed > 0) {
+      auto due = start + nanoseconds(static_cast<uint64_t>(log_ns / m_speed));
+      auto now = steady_clock::now();
+      if (now < due) {
+        this_thread::sleep_until(due);
+      } else {
+        uint64_t lag = duration_cast<nanoseconds>(now - due).count();
+        m_stats.max_lag_ns = max(m_stats.max_lag_ns, lag);
+      }
+    }
+
+    auto t0 = steady_clock::now();
+    m_listener.Notify(msg);
+    auto t1 = steady_clock::now();
+
+    uint64_t notify_ns = duration_cast<nanoseconds>(t1 - t0).count();
+    m_stats.notify_ns.push_back(
+        static_cast<uint32_t>(min<uint64_t>(notify_ns, UINT32_MAX)));
+    m_stats.messages++;
+    m_stats.bytes += bytes;
+    m_stats.log_ns = log_ns;
+  }
+  m_stats.wall_ns =
+      duration_cast<nanoseconds>(steady_clock::now() - start).count();
+  fclose(f);
+
+  if (!ok) wxLogWarning("Replay: read error in %s", m_path.c_str());
+  m_done = true;
+  return ok;
+}
@@ -228,9 +228,11 @@ void CommDriverN0183AndroidInt::handle_N0183_MSG(
 
     // notify message listener and also "ALL" N0183 messages, to support plugin
     // API using original talker id
-    auto msg = std::make_shared<const Nmea0183Msg>(identifier, full_sentence,
-                                                   GetAddress());
-    auto msg_all = std::make_shared<const Nmea0183Msg>(*msg, "ALL");
+    auto msg = std::make_shared<Nmea0183Msg>(identifier, full_sentence,
+                                             GetAddress());
+    auto msg_all = std::make_shared<Nmea0183Msg>(*msg, "ALL");
+    m_msg_ids.Resolve(*msg);
+    m_msg_ids.Resolve(*msg_all);
 
     if (m_params.SentencePassesFilter(full_sentence, FILTER_INPUT))
       m_listener.Notify(std::move(msg));
@@ -27,7 +27,7 @@
 #endif  // precompiled headers
 
 #include <mutex>  // std::mutex
-#include <queue>  // std::queue
+#include <sstream>
 #include <thread>
 #include <vector>
 
@@ -62,40 +62,6 @@ class CommDriverN0183Serial;  // fwd
 
 #define MAX_OUT_QUEUE_MESSAGE_LENGTH 100
 
-template <typename T>
-class n0183_atomic_queue {
-public:
-  size_t size() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_queque.size();
-  }
-
-  bool empty() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_queque.empty();
-  }
-
-  const T& front() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_queque.front();
-  }
-
-  void push(const T& value) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_queque.push(value);
-  }
-
-  void pop() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_queque.pop();
-  }
-
-private:
-  std::queue<T> m_queque;
-  mutable std::mutex m_mutex;
-};
-
-#define OUT_QUEUE_LENGTH 20
 #define MAX_OUT_QUEUE_MESSAGE_LENGTH 100
 
 wxDEFINE_EVENT(wxEVT_COMMDRIVER_N0183_SERIAL, CommDriverN0183SerialEvent);
@@ -148,7 +114,6 @@ class CommDriverN0183SerialThread {
   int m_baud;
   size_t m_send_retries;
 
-  n0183_atomic_queue<char*> out_que;
   WaitContinue device_waiter;
   ObsListener resume_listener;
   ObsListener new_device_listener;
@@ -217,7 +182,7 @@ CommDriverN0183Serial::CommDriverN0183Serial(const ConnectionParams* params,
       m_secondary_thread(NULL),
       m_params(*params),
       m_listener(listener),
-      m_out_queue(std::unique_ptr<CommOutQueue>(new MeasuredCommOutQueue(12))) {
+      m_out_queue(new LockFreeCommOutQueue()) {
   m_baudrate = wxString::Format("%i", params->Baudrate);
   SetSecThreadInActive();
   m_garmin_handler = NULL;
@@ -338,6 +303,15 @@ void CommDriverN0183Serial::Activate() {
   // TODO: Read input data.
 }
 
+std::unordered_map<std::string, std::string>
+CommDriverN0183Serial::GetAttributes() const {
+  auto attrs = CommDriverN0183::GetAttributes();
+  std::stringstream ss;
+  ss << m_out_queue->GetPerf();
+  attrs["outputQueue"] = ss.str();
+  return attrs;
+}
+
 bool CommDriverN0183Serial::SendMessage(std::shared_ptr<const NavMsg> msg,
                                         std::shared_ptr<const NavAddr> addr) {
   auto msg_0183 = std::dynamic_pointer_cast<const Nmea0183Msg>(msg);
@@ -387,9 +361,11 @@ void CommDriverN0183Serial::handle_N0183_MSG(
 
     // notify message listener and also "ALL" N0183 messages, to support plugin
     // API using original talker id
-    auto msg = std::make_shared<const Nmea0183Msg>(identifier, full_sentence,
-                                                   GetAddress());
-    auto msg_all = std::make_shared<const Nmea0183Msg>(*msg, "ALL");
+    auto msg = std::make_shared<Nmea0183Msg>(identifier, full_sentence,
+                                             GetAddress());
+    auto msg_all = std::make_shared<Nmea0183Msg>(*msg, "ALL");
+    m_msg_ids.Resolve(*msg);
+    m_msg_ids.Resolve(*msg_all);
 
     if (m_params.SentencePassesFilter(full_sentence, FILTER_INPUT))
       m_listener.Notify(std::move(msg));
@@ -446,17 +422,9 @@ void CommDriverN0183SerialThread::CloseComPortPhysical() {
 }
 
 bool CommDriverN0183SerialThread::SetOutMsg(const wxString& msg) {
-  if (out_que.size() < OUT_QUEUE_LENGTH) {
-    wxCharBuffer buf = msg.ToUTF8();
-    if (buf.data()) {
-      char* qmsg = (char*)malloc(strlen(buf.data()) + 1);
-      strcpy(qmsg, buf.data());
-      out_que.push(qmsg);
-      return true;
-    }
-  }
-
-  return false;
+  wxCharBuffer buf = msg.ToUTF8();
+  if (!buf.data()) return false;
+  return m_parent_driver->GetOutQueue().push_back(buf.data());
 }
 
 void CommDriverN0183SerialThread::ThreadMessage(const wxString& msg) {
@@ -594,16 +562,10 @@ void* CommDriverN0183SerialThread::Entry() {
 
     //      Check for any pending output message
 
-    bool b_qdata = !out_que.empty();
-
-    while (b_qdata) {
-      //  Take a copy of message
-      char* qmsg = out_que.front();
-      out_que.pop();
-      // m_outCritical.Leave();
-      char msg[MAX_OUT_QUEUE_MESSAGE_LENGTH];
-      strncpy(msg, qmsg, MAX_OUT_QUEUE_MESSAGE_LENGTH - 1);
-      free(qmsg);
+    std::string msg;
+    while (m_parent_driver->GetOutQueue().try_pop(msg)) {
+      if (msg.size() >= MAX_OUT_QUEUE_MESSAGE_LENGTH)
+        msg.resize(MAX_OUT_QUEUE_MESSAGE_LENGTH - 1);
 
       if (-1 == WriteComPortPhysical(msg) && 10 < m_send_retries++) {
         // We failed to write the port 10 times, let's close the port so that
@@ -611,9 +573,7 @@ void* CommDriverN0183SerialThread::Entry() {
         m_send_retries = 0;
         CloseComPortPhysical();
       }
-
-      b_qdata = !out_que.empty();
-    }  // while b_qdata
+    }  // while queued messages
   }    // while not done.
 
 thread_exit:
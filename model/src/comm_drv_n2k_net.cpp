@@ -55,6 +55,7 @@
 #include <netinet/tcp.h>
 #endif
 
+#include <algorithm>
 #include <vector>
 #include <wx/socket.h>
 #include <wx/log.h>
@@ -84,49 +85,59 @@ class MrqContainer{
 
 // circular_buffer implementation
 
+static size_t RoundUpPow2(size_t size) {
+  size_t n = 1;
+  while (n < size) n <<= 1;
+  return n;
+}
+
 circular_buffer::circular_buffer(size_t size)
-      : buf_(std::unique_ptr<unsigned char[]>(new unsigned char[size])), max_size_(size) {}
+    : buf_(new unsigned char[RoundUpPow2(size)]),
+      mask_(RoundUpPow2(size) - 1),
+      head_(0),
+      tail_(0) {}
+
+size_t circular_buffer::size() const {
+  // tail first: it never passes the head, loaded after it
+  size_t tail = tail_.load(std::memory_order_acquire);
+  return head_.load(std::memory_order_acquire) - tail;
+}
 
-//void circular_buffer::reset()
-//{}
+bool circular_buffer::empty() const { return size() == 0; }
 
-//size_t circular_buffer::capacity() const
-//{}
+size_t circular_buffer::put(const unsigned char* data, size_t count) {
+  size_t head = head_.load(std::memory_order_relaxed);
+  size_t tail = tail_.load(std::memory_order_acquire);
+  count = std::min(count, capacity() - (head - tail));
 
-//size_t circular_buffer::size() const
-//{}
+  // Copy in at most two chunks, the second one after wrapping around
+  size_t pos = head & mask_;
+  size_t first = std::min(count, capacity() - pos);
+  memcpy(&buf_[pos], data, first);
+  memcpy(&buf_[0], data + first, count - first);
 
-bool circular_buffer::empty() const {
-    // if head and tail are equal, we are empty
-    return (!full_ && (head_ == tail_));
+  head_.store(head + count, std::memory_order_release);
+  return count;
 }
 
-bool circular_buffer::full() const {
-    // If tail is ahead the head by 1, we are full
-    return full_;
-}
+size_t circular_buffer::get(unsigned char* data, size_t count) {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  size_t head = head_.load(std::memory_order_acquire);
+  count = std::min(count, head - tail);
 
-void circular_buffer::put(unsigned char item) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    buf_[head_] = item;
-    if (full_) tail_ = (tail_ + 1) % max_size_;
+  size_t pos = tail & mask_;
+  size_t first = std::min(count, capacity() - pos);
+  memcpy(data, &buf_[pos], first);
+  memcpy(data + first, &buf_[0], count - first);
 
-    head_ = (head_ + 1) % max_size_;
-
-    full_ = head_ == tail_;
+  tail_.store(tail + count, std::memory_order_release);
+  return count;
 }
 
 unsigned char circular_buffer::get() {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    if (empty()) return 0;
-
-    // Read data and advance the tail (we now have a free space)
-    auto val = buf_[tail_];
-    full_ = false;
-    tail_ = (tail_ + 1) % max_size_;
-
-    return val;
+  unsigned char val = 0;
+  get(&val, 1);
+  return val;
 }
 
 /// CAN v2.0 29 bit header as used by NMEA 2000
@@ -293,8 +304,10 @@ void CommDriverN2KNet::handle_N2K_MSG(CommDriverN2KNetEvent& event) {
   //printf("          %ld\n", pgn);
 
   auto name = PayloadToName(*payload);
-  auto msg = std::make_shared<const Nmea2000Msg>(pgn, *payload, GetAddress(name));
-  auto msg_all = std::make_shared<const Nmea2000Msg>(1, *payload, GetAddress(name));
+  auto msg = std::make_shared<Nmea2000Msg>(pgn, *payload, GetAddress(name));
+  auto msg_all = std::make_shared<Nmea2000Msg>(1, *payload, GetAddress(name));
+  m_msg_ids.Resolve(*msg);
+  m_msg_ids.Resolve(*msg_all);
 
   m_listener.Notify(std::move(msg));
   m_listener.Notify(std::move(msg_all));
@@ -482,49 +495,43 @@ bool CommDriverN2KNet::SendMessage(std::shared_ptr<const NavMsg> msg,
   return SendN2KNetwork(msg_n2k, dest_addr_n2k);
 }
 
-std::vector<unsigned char> CommDriverN2KNet::PushCompleteMsg(const CanHeader header,
-                                                   int position,
-                                                   const can_frame frame) {
-  std::vector<unsigned char> data;
-  data.push_back(0x93);
-  data.push_back(0x13);
-  data.push_back(header.priority);
-  data.push_back(header.pgn & 0xFF);
-  data.push_back((header.pgn >> 8) & 0xFF);
-  data.push_back((header.pgn >> 16) & 0xFF);
-  data.push_back(header.destination);
-  data.push_back(header.source);
-  data.push_back(0xFF);  // FIXME (dave) generate the time fields
-  data.push_back(0xFF);
-  data.push_back(0xFF);
-  data.push_back(0xFF);
-  data.push_back(CAN_MAX_DLEN);  // nominally 8
-  for (size_t n = 0; n < CAN_MAX_DLEN; n++) data.push_back(frame.data[n]);
-  data.push_back(0x55);  // CRC dummy, not checked
-  return data;
+/** Write the 13 bytes Actisense N2K header preceding the data bytes. */
+static void PutN2kHeader(const CanHeader& header, unsigned char length,
+                         unsigned char data_length, unsigned char* data) {
+  data[0] = 0x93;
+  data[1] = length;
+  data[2] = header.priority;
+  data[3] = header.pgn & 0xFF;
+  data[4] = (header.pgn >> 8) & 0xFF;
+  data[5] = (header.pgn >> 16) & 0xFF;
+  data[6] = header.destination;
+  data[7] = header.source;
+  data[8] = 0xFF;  // FIXME (dave) generate the time fields
+  data[9] = 0xFF;
+  data[10] = 0xFF;
+  data[11] = 0xFF;
+  data[12] = data_length;
 }
 
-std::vector<unsigned char> CommDriverN2KNet::PushFastMsgFragment(const CanHeader& header,
-                                                       int position) {
-  std::vector<unsigned char> data;
-  data.push_back(0x93);
-  data.push_back(fast_messages->entries[position].expected_length + 11);
-  data.push_back(header.priority);
-  data.push_back(header.pgn & 0xFF);
-  data.push_back((header.pgn >> 8) & 0xFF);
-  data.push_back((header.pgn >> 16) & 0xFF);
-  data.push_back(header.destination);
-  data.push_back(header.source);
-  data.push_back(0xFF);  // FIXME (dave) Could generate the time fields
-  data.push_back(0xFF);
-  data.push_back(0xFF);
-  data.push_back(0xFF);
-  data.push_back(fast_messages->entries[position].expected_length);
-  for (size_t n = 0; n < fast_messages->entries[position].expected_length; n++)
-    data.push_back(fast_messages->entries[position].data[n]);
-  data.push_back(0x55);  // CRC dummy
+void CommDriverN2KNet::PushCompleteMsg(const CanHeader& header, int position,
+                                       const can_frame& frame,
+                                       std::vector<unsigned char>& data) {
+  data.resize(13 + CAN_MAX_DLEN + 1);
+  PutN2kHeader(header, 0x13, CAN_MAX_DLEN, &data[0]);  // nominally 8
+  memcpy(&data[13], frame.data, CAN_MAX_DLEN);
+  data[13 + CAN_MAX_DLEN] = 0x55;  // CRC dummy, not checked
+}
+
+void CommDriverN2KNet::PushFastMsgFragment(const CanHeader& header,
+                                           int position,
+                                           std::vector<unsigned char>& data) {
+  const FastMessageMap::Entry& entry = fast_messages->entries[position];
+  size_t length = entry.expected_length;
+  data.resize(13 + length + 1);
+  PutN2kHeader(header, length + 11, length, &data[0]);
+  memcpy(&data[13], &entry.data[0], length);
+  data[13 + length] = 0x55;  // CRC dummy
   fast_messages->Remove(position);
-  return data;
 }
 
 /**
@@ -559,13 +566,15 @@ void CommDriverN2KNet::HandleCanFrameInput(can_frame frame) {
     }
   }
   if (ready) {
-    std::vector<unsigned char> vec;
+    // Built in place, the vector is then moved to the event payload
+    auto payload = std::make_shared<std::vector<uint8_t> >();
+    std::vector<unsigned char>& vec = *payload;
     if (position >= 0) {
       // Re-assembled fast message
-      vec = PushFastMsgFragment(header, position);
+      PushFastMsgFragment(header, position, vec);
     } else {
       // Single frame message
-      vec = PushCompleteMsg(header, position, frame);
+      PushCompleteMsg(header, position, frame, vec);
     }
 
     // Intercept network management messages not used by OCPN navigation core.
@@ -575,21 +584,20 @@ void CommDriverN2KNet::HandleCanFrameInput(can_frame frame) {
 
     // Message is ready
     CommDriverN2KNetEvent Nevent(wxEVT_COMMDRIVER_N2K_NET, 0);
-    auto payload = std::make_shared<std::vector<uint8_t> >(vec);
     Nevent.SetPayload(payload);
     AddPendingEvent(Nevent);
 
   }
 }
 
-bool isASCII(std::vector<unsigned char> packet) {
+bool isASCII(const std::vector<unsigned char>& packet) {
   for (unsigned char c : packet) {
     if (!isascii(c)) return false;
   }
   return true;
 }
 
-N2K_Format CommDriverN2KNet::DetectFormat(std::vector<unsigned char> packet) {
+N2K_Format CommDriverN2KNet::DetectFormat(const std::vector<unsigned char>& packet) {
 
   // A simplistic attempt at identifying which of the various available
   //    on-wire (or air) formats being emitted by a configured
@@ -620,7 +628,7 @@ N2K_Format CommDriverN2KNet::DetectFormat(std::vector<unsigned char> packet) {
   return N2KFormat_Undefined;
 }
 
-bool CommDriverN2KNet::ProcessActisense_N2K(std::vector<unsigned char> packet) {
+bool CommDriverN2KNet::ProcessActisense_N2K(const std::vector<unsigned char>& packet) {
 
   //1002 d0 1500ff0401f80900684c1b00a074eb14f89052d288 1003
 
@@ -729,7 +737,7 @@ bool CommDriverN2KNet::ProcessActisense_N2K(std::vector<unsigned char> packet) {
     return true;
 }
 
-bool CommDriverN2KNet::ProcessActisense_RAW(std::vector<unsigned char> packet) {
+bool CommDriverN2KNet::ProcessActisense_RAW(const std::vector<unsigned char>& packet) {
     //1002 95 0e15870402f8094b  fc e6 20 00 00 ff ff 6f 1003
 
     can_frame frame;
@@ -809,7 +817,7 @@ bool CommDriverN2KNet::ProcessActisense_RAW(std::vector<unsigned char> packet) {
     return true;
 }
 
-bool CommDriverN2KNet::ProcessActisense_NGT(std::vector<unsigned char> packet) {
+bool CommDriverN2KNet::ProcessActisense_NGT(const std::vector<unsigned char>& packet) {
   std::vector<unsigned char> data;
   bool bInMsg = false;
   bool bGotESC = false;
@@ -872,7 +880,7 @@ bool CommDriverN2KNet::ProcessActisense_NGT(std::vector<unsigned char> packet) {
   return true;
 }
 
-bool CommDriverN2KNet::ProcessActisense_ASCII_RAW(std::vector<unsigned char> packet) {
+bool CommDriverN2KNet::ProcessActisense_ASCII_RAW(const std::vector<unsigned char>& packet) {
   can_frame frame;
 
   while (!m_circle->empty()) {
@@ -920,7 +928,7 @@ bool CommDriverN2KNet::ProcessActisense_ASCII_RAW(std::vector<unsigned char> pac
   return true;
 }
 
-bool CommDriverN2KNet::ProcessActisense_ASCII_N2K(std::vector<unsigned char> packet) {
+bool CommDriverN2KNet::ProcessActisense_ASCII_N2K(const std::vector<unsigned char>& packet) {
   // A001001.732 04FF6 1FA03 C8FBA80329026400
   std::string sentence;
 
@@ -996,7 +1004,7 @@ bool CommDriverN2KNet::ProcessActisense_ASCII_N2K(std::vector<unsigned char> pac
   return true;
 }
 
-bool CommDriverN2KNet::ProcessSeaSmart(std::vector<unsigned char> packet) {
+bool CommDriverN2KNet::ProcessSeaSmart(const std::vector<unsigned char>& packet) {
   while (!m_circle->empty()) {
     char b = m_circle->get();
     if ((b != 0x0a) && (b != 0x0d)) {
@@ -1068,7 +1076,7 @@ bool CommDriverN2KNet::ProcessSeaSmart(std::vector<unsigned char> packet) {
   return true;
 }
 
-bool CommDriverN2KNet::ProcessMiniPlex(std::vector<unsigned char> packet) {
+bool CommDriverN2KNet::ProcessMiniPlex(const std::vector<unsigned char>& packet) {
   /*
   $MXPGN – NMEA 2000 PGN Data
   This sentence transports NMEA 2000/CAN frames in NMEA 0183 format. The MiniPlex-3 will transmit this
@@ -1258,12 +1266,7 @@ void CommDriverN2KNet::OnSocketEvent(wxSocketEvent& event) {
       }
 
       bool done = false;
-      if (newdata > 0) {
-        for (int i = 0; i < newdata; i++) {
-          m_circle->put(data[i]);
-          //printf("%c", data.at(i));
-        }
-      }
+      if (newdata > 0) m_circle->put(&data[0], newdata);
 
       m_n2k_format = DetectFormat(data);
 
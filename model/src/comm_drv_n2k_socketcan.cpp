@@ -119,6 +119,7 @@ class Worker {
   const wxString m_port_name;
   std::atomic<int> m_run_flag;
   FastMessageMap fast_messages;
+  NavMsgIdCache m_msg_ids;
   int m_socket;
 };
 
@@ -563,8 +564,10 @@ void Worker::HandleInput(CanFrame frame) {
     }
     //auto name = N2kName(static_cast<uint64_t>(header.pgn));
     auto src_addr = m_parent_driver->GetAddress(m_parent_driver->node_name);
-    auto msg = std::make_shared<const Nmea2000Msg>(header.pgn, vec, src_addr);
-    auto msg_all = std::make_shared<const Nmea2000Msg>(1, vec, src_addr);
+    auto msg = std::make_shared<Nmea2000Msg>(header.pgn, vec, src_addr);
+    auto msg_all = std::make_shared<Nmea2000Msg>(1, vec, src_addr);
+    m_msg_ids.Resolve(*msg);
+    m_msg_ids.Resolve(*msg_all);
 
     ProcessRxMessages(msg);
     m_parent_driver->m_listener.Notify(std::move(msg));
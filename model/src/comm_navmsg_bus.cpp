@@ -23,6 +23,9 @@
  *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
  **************************************************************************/
 
+#include <algorithm>
+#include <cassert>
+
 // For compilers that support precompilation, includes "wx.h".
 #include <wx/wxprec.h>
 
@@ -34,8 +37,249 @@
 
 using namespace std;
 
+NavMsgBus::NavMsgBus()
+    : m_snapshot(new Snapshot),
+      m_epoch(0),
+      m_has_retired(false),
+      m_next_handle(0),
+      m_work_head(new WorkItem),
+      m_worker_idle(false),
+      m_stop(false) {
+  m_readers[0] = 0;
+  m_readers[1] = 0;
+  m_work_head.load()->next = nullptr;
+  m_work_tail = m_work_head.load();
+}
+
+NavMsgBus::~NavMsgBus() {
+  m_stop = true;
+  {
+    lock_guard<mutex> lock(m_work_mutex);
+    m_work_cv.notify_all();
+  }
+  if (m_worker.joinable()) m_worker.join();
+  while (m_work_tail) {
+    WorkItem* next = m_work_tail->next.load();
+    delete m_work_tail;
+    m_work_tail = next;
+  }
+  delete m_snapshot.load();
+}
+
 void NavMsgBus::Notify(std::shared_ptr<const NavMsg> msg) {
-  Observable(*msg).Notify(msg);
+  NavMsgId id = msg->msg_id;
+  if (id == kNoNavMsgId) id = GetMsgId(msg->key());
+
+  //  Lock free read of the subscribers, the snapshot is not freed before
+  //  LeaveRead(), see Reclaim().
+  unsigned epoch = EnterRead();
+  const Snapshot* snapshot = m_snapshot.load();
+  if (id < snapshot->subscribers.size()) {
+    snapshot->observables[id]->Notify(msg);
+    const SubscriberList& subscribers = snapshot->subscribers[id];
+    if (!subscribers.empty()) Dispatch(subscribers, msg);
+  }
+  if (!snapshot->all.empty()) Dispatch(snapshot->all, msg);
+  LeaveRead(epoch);
+}
+
+void NavMsgBus::Dispatch(const SubscriberList& subscribers,
+                         shared_ptr<const NavMsg> msg) {
+  for (const auto& s : subscribers) {
+    switch (s->delivery) {
+      case NavMsgDelivery::Direct:
+        s->callback(msg);
+        break;
+      case NavMsgDelivery::WxEvent: {
+        auto evt = new ObservedEvt(s->ev_type);
+        evt->SetSharedPtr(msg);
+        wxQueueEvent(s->handler, evt);
+        break;
+      }
+      case NavMsgDelivery::Worker: {
+        if (m_stop) break;
+        auto item = new WorkItem;
+        item->subscriber = s;
+        item->message = msg;
+        PushWork(item);
+        break;
+      }
+    }
+  }
+}
+
+/**
+ * Append item to the worker queue without locks (D. Vyukov's intrusive
+ * MPSC queue). Unlike a bounded ring it never fails, a slow subscriber
+ * does not make the driver drop or wait. The worker is only woken if idle.
+ */
+void NavMsgBus::PushWork(WorkItem* item) {
+  item->next.store(nullptr, memory_order_relaxed);
+  WorkItem* prev = m_work_head.exchange(item, memory_order_acq_rel);
+  prev->next.store(item);
+  if (m_worker_idle.load()) {
+    lock_guard<mutex> lock(m_work_mutex);
+    m_work_cv.notify_one();
+  }
+}
+
+NavMsgId NavMsgBus::GetMsgId(const std::string& key) {
+  unsigned epoch = EnterRead();
+  const Snapshot* snapshot = m_snapshot.load();
+  auto it = snapshot->ids.find(key);
+  bool found = it != snapshot->ids.end();
+  NavMsgId id = found ? it->second : 0;
+  LeaveRead(epoch);
+  if (found) return id;
+
+  lock_guard<mutex> lock(m_mutex);
+  snapshot = m_snapshot.load();
+  it = snapshot->ids.find(key);
+  if (it != snapshot->ids.end()) return it->second;
+
+  auto next = new Snapshot(*snapshot);
+  id = static_cast<NavMsgId>(next->subscribers.size());
+  next->ids[key] = id;
+  next->observables.push_back(make_shared<Observable>(key));
+  next->subscribers.emplace_back();
+  Publish(next);
+  return id;
+}
+
+int NavMsgBus::Subscribe(NavMsgId id, Callback callback,
+                         NavMsgDelivery delivery) {
+  assert(delivery != NavMsgDelivery::WxEvent && "Use the wxEvtHandler form");
+  auto s = make_shared<Subscriber>();
+  s->delivery = delivery;
+  s->callback = callback;
+  s->handler = nullptr;
+  s->ev_type = wxEVT_NULL;
+  if (delivery == NavMsgDelivery::Worker) StartWorker();
+  return AddSubscriber(id, s);
+}
+
+int NavMsgBus::Subscribe(NavMsgId id, wxEvtHandler* handler,
+                         wxEventType ev_type) {
+  auto s = make_shared<Subscriber>();
+  s->delivery = NavMsgDelivery::WxEvent;
+  s->handler = handler;
+  s->ev_type = ev_type;
+  return AddSubscriber(id, s);
+}
+
+int NavMsgBus::AddSubscriber(NavMsgId id, shared_ptr<Subscriber> s) {
+  lock_guard<mutex> lock(m_mutex);
+  const Snapshot* snapshot = m_snapshot.load();
+  if (id != kAllMsgs && id >= snapshot->subscribers.size()) {
+    wxLogWarning("NavMsgBus: subscribing to unknown message id %u", id);
+    return -1;
+  }
+  s->handle = m_next_handle++;
+  s->active = true;
+  auto next = new Snapshot(*snapshot);
+  if (id == kAllMsgs)
+    next->all.push_back(s);
+  else
+    next->subscribers[id].push_back(s);
+  Publish(next);
+  return s->handle;
+}
+
+void NavMsgBus::Unsubscribe(int handle) {
+  lock_guard<mutex> lock(m_mutex);
+  auto next = new Snapshot(*m_snapshot.load());
+  std::vector<SubscriberList*> lists = {&next->all};
+  for (auto& subscribers : next->subscribers) lists.push_back(&subscribers);
+  for (SubscriberList* list : lists) {
+    SubscriberList& subscribers = *list;
+    auto it = find_if(subscribers.begin(), subscribers.end(),
+                      [handle](const shared_ptr<Subscriber>& s) {
+                        return s->handle == handle;
+                      });
+    if (it == subscribers.end()) continue;
+    (*it)->active = false;
+    subscribers.erase(it);
+    Publish(next);
+    return;
+  }
+  delete next;
+}
+
+/** Register a reader in the current epoch, return it for LeaveRead(). */
+unsigned NavMsgBus::EnterRead() {
+  while (true) {
+    unsigned epoch = m_epoch.load();
+    m_readers[epoch & 1].fetch_add(1);
+    if (m_epoch.load() == epoch) return epoch;
+    //  Raced with Reclaim() advancing the epoch, which may reuse the counter
+    LeaveRead(epoch);
+  }
+}
+
+/** The last reader leaving an epoch frees what it was holding back. */
+void NavMsgBus::LeaveRead(unsigned epoch) {
+  if (m_readers[epoch & 1].fetch_sub(1) != 1 || !m_has_retired.load()) return;
+  unique_lock<mutex> lock(m_mutex, try_to_lock);
+  if (lock.owns_lock()) Reclaim();
+}
+
+/** Replace the snapshot, must be called with m_mutex held. */
+void NavMsgBus::Publish(Snapshot* snapshot) {
+  Retired retired;
+  retired.snapshot.reset(m_snapshot.exchange(snapshot));
+  retired.epoch = m_epoch.load();
+  m_retired.push_back(std::move(retired));
+  Reclaim();
+}
+
+/**
+ * Free the retired snapshots no reader can still use, must be called with
+ * m_mutex held. Readers count themselves in the counter of the epoch
+ * parity. Once no reader of the previous epoch is left, all readers
+ * started in the current epoch, after all snapshots retired in earlier
+ * epochs were replaced: these are freed and the epoch advanced, which
+ * reuses the drained counter. Two rounds free everything when idle,
+ * otherwise the last reader leaving an epoch calls again.
+ */
+void NavMsgBus::Reclaim() {
+  for (int round = 0; round < 2 && !m_retired.empty(); round++) {
+    unsigned epoch = m_epoch.load();
+    if (m_readers[(epoch + 1) & 1].load() != 0) break;
+    m_retired.erase(remove_if(m_retired.begin(), m_retired.end(),
+                              [epoch](const Retired& r) {
+                                return r.epoch != epoch;
+                              }),
+                    m_retired.end());
+    m_epoch.store(epoch + 1);
+  }
+  m_has_retired = !m_retired.empty();
+}
+
+void NavMsgBus::StartWorker() {
+  lock_guard<mutex> lock(m_work_mutex);
+  if (m_stop || m_worker.joinable()) return;
+  m_worker = thread(&NavMsgBus::RunWorker, this);
+}
+
+void NavMsgBus::RunWorker() {
+  while (!m_stop) {
+    WorkItem* next = m_work_tail->next.load(memory_order_acquire);
+    if (next) {
+      //  next becomes the dummy, its payload is moved out
+      delete m_work_tail;
+      m_work_tail = next;
+      auto subscriber = std::move(next->subscriber);
+      auto message = std::move(next->message);
+      if (subscriber->active) subscriber->callback(message);
+      continue;
+    }
+    //  Sleep, the seq_cst m_worker_idle and next accesses make sure either
+    //  PushWork() sees the flag or the predicate sees the item.
+    unique_lock<mutex> lock(m_work_mutex);
+    m_worker_idle = true;
+    m_work_cv.wait(lock, [&] { return m_stop || m_work_tail->next.load(); });
+    m_worker_idle = false;
+  }
 }
 
 NavMsgBus& NavMsgBus::GetInstance() {
@@ -45,3 +289,17 @@ NavMsgBus& NavMsgBus::GetInstance() {
 
 /** Handle changes in driver list. */
 void NavMsgBus::Notify(AbstractCommDriver const&) {}
+
+void NavMsgIdCache::Resolve(Nmea0183Msg& msg) {
+  if (msg.type.size() > sizeof(uint64_t)) return;
+  uint64_t code = 0;
+  for (char c : msg.type) code = code << 8 | static_cast<unsigned char>(c);
+  Resolve(code, msg);
+}
+
+void NavMsgIdCache::Resolve(uint64_t code, NavMsg& msg) {
+  auto found = m_ids.find(code);
+  if (found == m_ids.end())
+    found = m_ids.emplace(code, NavMsgBus::GetInstance().GetMsgId(msg)).first;
+  msg.msg_id = found->second;
+}
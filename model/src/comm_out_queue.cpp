@@ -148,12 +148,148 @@ bool CommOutQueueSingle::push_back(const std::string& line) {
   return true;
 }
 
+LockFreeCommOutQueue::LockFreeCommOutQueue(unsigned max_buffered,
+                                           size_t fifo_size)
+    : CommOutQueue(max_buffered),
+      m_max_buffered(max_buffered),
+      m_slots(new Slot[kMaxTypes]),
+      m_fifo(fifo_size),
+      m_overrun_flag(false),
+      m_in_queue(0),
+      m_msgs_in(0),
+      m_msgs_out(0),
+      m_bytes_in(0),
+      m_bytes_out(0),
+      m_overflow(0),
+      m_delay_us(0) {}
+
+LockFreeCommOutQueue::~LockFreeCommOutQueue() {
+  Item* item;
+  while (m_fifo.Pop(item)) delete item;
+}
+
+LockFreeCommOutQueue::Slot* LockFreeCommOutQueue::FindSlot(uint64_t type) {
+  static_assert((kMaxTypes & (kMaxTypes - 1)) == 0, "kMaxTypes: not 2^n");
+  size_t hash = (type * 0x9E3779B97F4A7C15ull) >> 32;
+  for (size_t probe = 0; probe < kMaxTypes; probe++) {
+    Slot& slot = m_slots[(hash + probe) & (kMaxTypes - 1)];
+    uint64_t slot_type = slot.type.load(std::memory_order_acquire);
+    if (slot_type == 0) {
+      if (slot.type.compare_exchange_strong(slot_type, type)) return &slot;
+    }
+    if (slot_type == type) return &slot;
+  }
+  return nullptr;
+}
+
+bool LockFreeCommOutQueue::push_back(const std::string& line) {
+  if (line.size() < 7) return false;
+  m_msgs_in++;
+  m_bytes_in += line.size();
+
+  // Multi-part encapsulated sentences are never dropped for a newer one
+  Slot* slot = line[0] == '!' ? nullptr : FindSlot(GetNmeaType(line));
+  if (slot) {
+    slot->msgs_in++;
+    slot->queued++;
+  }
+  auto item = new Item(line, slot);
+  if (!m_fifo.Push(std::move(item))) {
+    if (slot) slot->queued--;
+    delete item;
+    m_overflow++;
+    if (!m_overrun_flag.exchange(true)) ReportOverrun(line, false);
+    return false;
+  }
+  m_in_queue++;
+  if (slot && slot->queued.load() - slot->skip.load() > m_max_buffered) {
+    // Too many of this type pending, the writer drops the oldest one.
+    slot->skip++;
+    slot->overwritten++;
+    m_overflow++;
+    m_in_queue--;
+    if (!m_overrun_flag.exchange(true)) ReportOverrun(line, false);
+  }
+  return true;
+}
+
+std::string LockFreeCommOutQueue::Release(Item* item) {
+  using namespace std::chrono;
+  std::unique_ptr<Item> owned(item);
+  auto delay = duration_cast<microseconds>(steady_clock::now() - item->stamp);
+  size_t delay_us = m_delay_us.load(std::memory_order_relaxed);
+  m_delay_us.store(static_cast<size_t>(0.95 * delay_us + 0.05 * delay.count()),
+                   std::memory_order_relaxed);  // LP filter
+  m_in_queue--;
+  m_msgs_out++;
+  m_bytes_out += item->line.size();
+  return std::move(item->line);
+}
+
+bool LockFreeCommOutQueue::try_pop(std::string& line) {
+  Item* item;
+  while (m_fifo.Pop(item)) {
+    Slot* slot = item->slot;
+    if (slot) {
+      slot->queued--;
+      int skip = slot->skip.load();
+      while (skip > 0 && !slot->skip.compare_exchange_weak(skip, skip - 1))
+        continue;
+      if (skip > 0) {
+        // Oldest of its type with a newer one pending beyond max_buffered
+        delete item;
+        continue;
+      }
+      slot->msgs_out++;
+    }
+    line = Release(item);
+    return true;
+  }
+  return false;
+}
+
+std::string LockFreeCommOutQueue::pop() {
+  std::string line;
+  if (!try_pop(line))
+    throw std::underflow_error("Attempt to pop() from empty buffer");
+  return line;
+}
+
+PerfCounter LockFreeCommOutQueue::GetPerf() const {
+  PerfCounter perf;
+  perf.msgs_in = m_msgs_in.load();
+  perf.msgs_out = m_msgs_out.load();
+  perf.bytes_in = m_bytes_in.load();
+  perf.bytes_out = m_bytes_out.load();
+  perf.in_out_delay_us = m_delay_us.load();
+  perf.overflow_msgs = m_overflow.load();
+  perf.in_queue = m_in_queue.load();
+  return perf;
+}
+
+std::unordered_map<uint64_t, PerfCounter> LockFreeCommOutQueue::GetTypePerf()
+    const {
+  std::unordered_map<uint64_t, PerfCounter> type_perf;
+  for (size_t i = 0; i < kMaxTypes; i++) {
+    const Slot& slot = m_slots[i];
+    uint64_t type = slot.type.load();
+    if (type == 0) continue;
+    PerfCounter& perf = type_perf[type];
+    perf.msgs_in = slot.msgs_in.load();
+    perf.msgs_out = slot.msgs_out.load();
+    perf.overflow_msgs = slot.overwritten.load();
+    perf.in_queue = slot.queued.load() - slot.skip.load();
+  }
+  return type_perf;
+}
+
 bool MeasuredCommOutQueue::push_back(const std::string& line) {
   using std::chrono::duration;
   using std::chrono::steady_clock;
 
   auto t1 = steady_clock::now();
   bool ok = CommOutQueue::push_back(line);
+  std::lock_guard<std::mutex> lock(m_mutex);
   msg_perf[GetNmeaType(line)].in(line.size(), ok);
   perf.in(line.size(), ok);
   auto t2 = steady_clock::now();
@@ -163,6 +299,11 @@ bool MeasuredCommOutQueue::push_back(const std::string& line) {
   return ok;
 }
 
+PerfCounter MeasuredCommOutQueue::GetPerf() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return perf;
+}
+
 std::string MeasuredCommOutQueue::pop() {
   using std::chrono::duration;
   using std::chrono::steady_clock;
@@ -0,0 +1,224 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Batch forms of the projections used by ViewPort
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "model/georef.h"
+#include "model/georef_batch.h"
+
+/** Points per block of the per point scratch arrays. */
+static const int kBlock = 64;
+
+void PhaseLongitudes(const double* lon, int count, double lon0,
+                     double* xlon) {
+  int i = 0;
+#ifdef __SSE2__
+  const __m128d c = _mm_set1_pd(lon0);
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d p360 = _mm_set1_pd(360.), m360 = _mm_set1_pd(-360.);
+  const __m128d p180 = _mm_set1_pd(180.);
+  const __m128d abs_mask =
+      _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+  for (; i + 1 < count; i += 2) {
+    __m128d x = _mm_loadu_pd(lon + i);
+
+    __m128d opposite = _mm_cmplt_pd(_mm_mul_pd(x, c), zero);
+    __m128d negative = _mm_cmplt_pd(x, zero);
+    __m128d add = _mm_or_pd(_mm_and_pd(negative, p360),
+                            _mm_andnot_pd(negative, m360));
+    x = _mm_add_pd(x, _mm_and_pd(opposite, add));
+
+    __m128d far = _mm_cmpgt_pd(_mm_and_pd(_mm_sub_pd(x, c), abs_mask), p180);
+    __m128d east = _mm_cmpgt_pd(x, c);
+    add = _mm_or_pd(_mm_and_pd(east, m360), _mm_andnot_pd(east, p360));
+    x = _mm_add_pd(x, _mm_and_pd(far, add));
+
+    _mm_storeu_pd(xlon + i, x);
+  }
+#endif
+  for (; i < count; i++) xlon[i] = PhaseLongitude(lon[i], lon0);
+}
+
+void toSMcacheBatch(const double* lat, const double* xlon, int count,
+                    double y30, double lon0, double* x, double* y) {
+  const double z = WGS84_semimajor_axis_meters * mercator_k0;
+  int i = 0;
+#ifdef __SSE2__
+  const __m128d c = _mm_set1_pd(lon0);
+  const __m128d deg = _mm_set1_pd(DEGREE);
+  const __m128d vz = _mm_set1_pd(z);
+  for (; i + 1 < count; i += 2) {
+    __m128d e = _mm_loadu_pd(xlon + i);
+    e = _mm_mul_pd(_mm_mul_pd(_mm_sub_pd(e, c), deg), vz);
+    _mm_storeu_pd(x + i, e);
+  }
+#endif
+  for (; i < count; i++) x[i] = (xlon[i] - lon0) * DEGREE * z;
+
+  for (i = 0; i < count; i++) {
+    const double s = sin(lat[i] * DEGREE);
+    const double y3 = (.5 * log((1 + s) / (1 - s))) * z;
+    y[i] = y3 - y30;
+  }
+}
+
+void toPOLARBatch(const double* lat, const double* xlon, int count,
+                  double e, double lat0, double lon0, double* x, double* y) {
+  const double z = WGS84_semimajor_axis_meters * mercator_k0;
+  const double pole = lat0 > 0 ? 90 : -90;
+  double d[kBlock], sin_theta[kBlock], cos_theta[kBlock];
+
+  for (int b = 0; b < count; b += kBlock) {
+    const int n = std::min(kBlock, count - b);
+    for (int i = 0; i < n; i++) {
+      double theta = (xlon[b + i] - lon0) * DEGREE;
+      d[i] = tan((pole - lat[b + i]) * DEGREE / 2);
+      sin_theta[i] = sin(theta);
+      cos_theta[i] = cos(theta);
+    }
+    int i = 0;
+#ifdef __SSE2__
+    const __m128d abs_mask =
+        _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+    const __m128d ve = _mm_set1_pd(e);
+    const __m128d vz = _mm_set1_pd(z);
+    for (; i + 1 < n; i += 2) {
+      __m128d vd = _mm_loadu_pd(d + i);
+      __m128d vx = _mm_mul_pd(_mm_and_pd(vd, abs_mask),
+                              _mm_loadu_pd(sin_theta + i));
+      __m128d vy =
+          _mm_sub_pd(ve, _mm_mul_pd(vd, _mm_loadu_pd(cos_theta + i)));
+      _mm_storeu_pd(x + b + i, _mm_mul_pd(vx, vz));
+      _mm_storeu_pd(y + b + i, _mm_mul_pd(vy, vz));
+    }
+#endif
+    for (; i < n; i++) {
+      x[b + i] = fabs(d[i]) * sin_theta[i] * z;
+      y[b + i] = (e - d[i] * cos_theta[i]) * z;
+    }
+  }
+}
+
+void toSTEREOBatch(const double* lat, const double* xlon, int count,
+                   double sin_phi0, double cos_phi0, double lon0, double* x,
+                   double* y) {
+  const double z = WGS84_semimajor_axis_meters * mercator_k0;
+  double cos_phi[kBlock], sin_phi[kBlock], cos_theta[kBlock],
+      sin_theta[kBlock];
+
+  for (int b = 0; b < count; b += kBlock) {
+    const int n = std::min(kBlock, count - b);
+    for (int i = 0; i < n; i++) {
+      double theta = (xlon[b + i] - lon0) * DEGREE, phi = lat[b + i] * DEGREE;
+      cos_phi[i] = cos(phi);
+      sin_phi[i] = sin(phi);
+      cos_theta[i] = cos(theta);
+      sin_theta[i] = sin(theta);
+    }
+    int i = 0;
+#ifdef __SSE2__
+    const __m128d s0 = _mm_set1_pd(sin_phi0), c0 = _mm_set1_pd(cos_phi0);
+    const __m128d one = _mm_set1_pd(1), two = _mm_set1_pd(2);
+    const __m128d vz = _mm_set1_pd(z);
+    for (; i + 1 < n; i += 2) {
+      __m128d cp = _mm_loadu_pd(cos_phi + i);
+      __m128d v0 = _mm_loadu_pd(sin_phi + i);
+      __m128d w0 = _mm_mul_pd(_mm_loadu_pd(cos_theta + i), cp);
+      __m128d u = _mm_mul_pd(_mm_loadu_pd(sin_theta + i), cp);
+      __m128d v = _mm_sub_pd(_mm_mul_pd(c0, v0), _mm_mul_pd(s0, w0));
+      __m128d w = _mm_add_pd(_mm_mul_pd(s0, v0), _mm_mul_pd(c0, w0));
+      __m128d t = _mm_div_pd(two, _mm_add_pd(w, one));
+      _mm_storeu_pd(x + b + i, _mm_mul_pd(_mm_mul_pd(u, t), vz));
+      _mm_storeu_pd(y + b + i, _mm_mul_pd(_mm_mul_pd(v, t), vz));
+    }
+#endif
+    for (; i < n; i++) {
+      //  As toSTEREO1() and toSTEREO()
+      double w0 = cos_theta[i] * cos_phi[i];
+      double u = sin_theta[i] * cos_phi[i];
+      double v = cos_phi0 * sin_phi[i] - sin_phi0 * w0;
+      double w = sin_phi0 * sin_phi[i] + cos_phi0 * w0;
+      double t = 2 / (w + 1);
+      x[b + i] = u * t * z;
+      y[b + i] = v * t * z;
+    }
+  }
+}
+
+void ProjectedToPix::Apply(double easting, double northing, double* x,
+                           double* y) const {
+  if (!std::isfinite(easting) || !std::isfinite(northing)) {
+    *x = easting;
+    *y = northing;
+    return;
+  }
+  double epix = easting * m_scale;
+  double npix = northing * m_scale;
+  double dxr = epix;
+  double dyr = npix;
+  if (m_rotation) {
+    dxr = epix * m_cos + npix * m_sin;
+    dyr = npix * m_cos - epix * m_sin;
+  }
+  *x = m_cx + dxr;
+  *y = m_cy - dyr;
+}
+
+void ProjectedToPix::Apply(const double* easting, const double* northing,
+                           int count, double* x, double* y) const {
+  int i = 0;
+#ifdef __SSE2__
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d scale = _mm_set1_pd(m_scale);
+  const __m128d vcos = _mm_set1_pd(m_cos), vsin = _mm_set1_pd(m_sin);
+  const __m128d cx = _mm_set1_pd(m_cx), cy = _mm_set1_pd(m_cy);
+  for (; i + 1 < count; i += 2) {
+    __m128d e = _mm_loadu_pd(easting + i);
+    __m128d n = _mm_loadu_pd(northing + i);
+    //  v - v is 0 unless v is infinite or NaN
+    __m128d finite = _mm_and_pd(_mm_cmpeq_pd(_mm_sub_pd(e, e), zero),
+                                _mm_cmpeq_pd(_mm_sub_pd(n, n), zero));
+    if (_mm_movemask_pd(finite) != 3) {
+      Apply(easting[i], northing[i], x + i, y + i);
+      Apply(easting[i + 1], northing[i + 1], x + i + 1, y + i + 1);
+      continue;
+    }
+    __m128d dxr = _mm_mul_pd(e, scale);  // epix
+    __m128d dyr = _mm_mul_pd(n, scale);  // npix
+    if (m_rotation) {
+      __m128d epix = dxr;
+      dxr = _mm_add_pd(_mm_mul_pd(epix, vcos), _mm_mul_pd(dyr, vsin));
+      dyr = _mm_sub_pd(_mm_mul_pd(dyr, vcos), _mm_mul_pd(epix, vsin));
+    }
+    _mm_storeu_pd(x + i, _mm_add_pd(cx, dxr));
+    _mm_storeu_pd(y + i, _mm_sub_pd(cy, dyr));
+  }
+#endif
+  for (; i < count; i++) Apply(easting[i], northing[i], x + i, y + i);
+}
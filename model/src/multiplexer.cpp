@@ -124,19 +124,18 @@ void Multiplexer::LogOutputMessageColor(const wxString &msg,
                                         const wxString &stream_name,
                                         const wxString &color) {
   if (m_log_callbacks.log_is_active()) {
-    wxDateTime now = wxDateTime::Now();
-    wxString ss;
-#ifndef __WXQT__  //  Date/Time on Qt are broken, at least for android
-    ss = now.FormatISOTime();
-#endif
-    ss.Prepend(_T("--> "));
-    ss.Append(_T(" ("));
-    ss.Append(stream_name);
-    ss.Append(_T(") "));
-    ss.Append(msg);
-    ss.Prepend(color);
-
-    m_log_callbacks.log_message(ss.ToStdString());
+    m_log_callbacks.log_message(NmeaLogEntry(
+        NmeaLogEntry::Direction::Output, color.ToStdString(),
+        stream_name.ToStdString(), msg.ToStdString()));
+  }
+}
+
+void Multiplexer::LogOutputEntry(const std::string &msg,
+                                const std::string &stream_name,
+                                const char *color) {
+  if (m_log_callbacks.log_is_active()) {
+    m_log_callbacks.log_message(NmeaLogEntry(
+        NmeaLogEntry::Direction::Output, color, stream_name, msg, true));
   }
 }
 
@@ -151,29 +150,25 @@ void Multiplexer::LogOutputMessage(const wxString &msg, wxString stream_name,
 void Multiplexer::LogInputMessage(const wxString &msg,
                                   const wxString &stream_name, bool b_filter,
                                   bool b_error) {
-  if (m_log_callbacks.log_is_active()) {
-    wxDateTime now = wxDateTime::Now();
-    wxString ss;
-#ifndef __WXQT__  //  Date/Time on Qt are broken, at least for android
-    ss = now.FormatISOTime();
-#endif
-    ss.Append(_T(" ("));
-    ss.Append(stream_name);
-    ss.Append(_T(") "));
-    ss.Append(msg);
-    if (b_error) {
-      ss.Prepend(_T("<RED>"));
-    } else {
-      if (b_filter)
-        if (m_legacy_input_filter_behaviour)
-          ss.Prepend(_T("<CORAL>"));
-        else
-          ss.Prepend(_T("<MAROON>"));
-      else
-        ss.Prepend(_T("<GREEN>"));
-    }
-    m_log_callbacks.log_message(ss.ToStdString());
-  }
+  if (m_log_callbacks.log_is_active())
+    LogInputEntry(msg.ToStdString(), stream_name.ToStdString(), b_filter,
+                  b_error, false);
+}
+
+void Multiplexer::LogInputEntry(const std::string &msg,
+                                const std::string &stream_name,
+                                bool b_filter, bool b_error,
+                                bool check_binary) {
+  const char *color;
+  if (b_error)
+    color = "<RED>";
+  else if (b_filter)
+    color = m_legacy_input_filter_behaviour ? "<CORAL>" : "<MAROON>";
+  else
+    color = "<GREEN>";
+  m_log_callbacks.log_message(NmeaLogEntry(NmeaLogEntry::Direction::Input,
+                                           color, stream_name, msg,
+                                           check_binary));
 }
 
 void Multiplexer::HandleN0183(std::shared_ptr<const Nmea0183Msg> n0183_msg) {
@@ -182,15 +177,12 @@ void Multiplexer::HandleN0183(std::shared_ptr<const Nmea0183Msg> n0183_msg) {
   const auto& drivers = CommDriverRegistry::GetInstance().GetDrivers();
   auto source_driver = FindDriver(drivers, n0183_msg->source->iface);
 
-  wxString fmsg;
   bool bpass_input_filter = true;
 
   // Send to the Debug Window, if open
   //  Special formatting for non-printable characters helps debugging NMEA
   //  problems
   if (m_log_callbacks.log_is_active()) {
-    std::string str = n0183_msg->payload;
-
     // Get the params for the driver sending this message
       ConnectionParams params;
       auto drv_serial =
@@ -216,18 +208,6 @@ void Multiplexer::HandleN0183(std::shared_ptr<const Nmea0183Msg> n0183_msg) {
     bpass_input_filter = params.SentencePassesFilter(n0183_msg->payload.c_str(),
                                         FILTER_INPUT);
 
-    bool b_error = false;
-    for (std::string::iterator it = str.begin(); it != str.end(); ++it) {
-      if (isprint(*it))
-        fmsg += *it;
-      else {
-        wxString bin_print;
-        bin_print.Printf(_T("<0x%02X>"), *it);
-        fmsg += bin_print;
-        if ((*it != 0x0a) && (*it != 0x0d)) b_error = true;
-      }
-    }
-
     // FIXME (dave)  Flag checksum errors, but fix and process the sentence anyway
     //std::string goodMessage(message);
     //bool checksumOK = CheckSumCheck(event.GetNMEAString());
@@ -237,8 +217,10 @@ void Multiplexer::HandleN0183(std::shared_ptr<const Nmea0183Msg> n0183_msg) {
     //}
 
 
-    wxString port(n0183_msg->source->iface);
-    LogInputMessage(fmsg, port, !bpass_input_filter, b_error);
+    //  Non-printable characters are escaped, and flagged as errors, when
+    //  the log formats the line.
+    LogInputEntry(n0183_msg->payload, n0183_msg->source->iface,
+                  !bpass_input_filter, false, true);
   }
 
   // Detect virtual driver, message comes from plugin API
@@ -294,11 +276,11 @@ void Multiplexer::HandleN0183(std::shared_ptr<const Nmea0183Msg> n0183_msg) {
             // Send to the Debug Window, if open
             if (!bout_filter) {
               if (bxmit_ok)
-                LogOutputMessageColor(fmsg, driver->iface, _T("<BLUE>"));
+                LogOutputEntry(n0183_msg->payload, driver->iface, "<BLUE>");
               else
-                LogOutputMessageColor(fmsg, driver->iface, _T("<RED>"));
+                LogOutputEntry(n0183_msg->payload, driver->iface, "<RED>");
             } else
-              LogOutputMessageColor(fmsg, driver->iface, _T("<CORAL>"));
+              LogOutputEntry(n0183_msg->payload, driver->iface, "<CORAL>");
           }
         }
       }
@@ -0,0 +1,205 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Background formatting and batching of NMEA log lines
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+// For compilers that support precompilation, includes "wx.h".
+#include <wx/wxprec.h>
+
+#ifndef WX_PRECOMP
+#include <wx/wx.h>
+#endif  // precompiled headers
+
+#include <cctype>
+#include <cstdio>
+
+#include <wx/datetime.h>
+
+#include "model/nmea_log_pipeline.h"
+
+// Entries formatted per lock hold when filling the batch
+static const size_t kDrainChunk = 256;
+
+std::string NmeaLogEntry::Format() const {
+  if (direction == Direction::Formatted) return message;
+
+  std::string line;
+  line.reserve(message.size() + stream.size() + 32);
+
+  std::string tag = color;
+  std::string text;
+  if (check_binary) {
+    text.reserve(message.size());
+    for (char c : message) {
+      unsigned char uc = static_cast<unsigned char>(c);
+      if (isprint(uc)) {
+        text += c;
+      } else {
+        char bin_print[8];
+        snprintf(bin_print, sizeof(bin_print), "<0x%02X>", uc);
+        text += bin_print;
+        if (c != 0x0a && c != 0x0d && direction == Direction::Input)
+          tag = "<RED>";
+      }
+    }
+  }
+
+  line += tag;
+  if (direction == Direction::Output) line += "--> ";
+#ifndef __WXQT__  //  Date/Time on Qt are broken, at least for android
+  line += wxDateTime(stamp).FormatISOTime().ToStdString();
+#endif
+  line += " (";
+  line += stream;
+  line += ") ";
+  line += check_binary ? text : message;
+  return line;
+}
+
+NmeaLogPipeline::NmeaLogPipeline(size_t capacity)
+    : m_ring(capacity),
+      m_ring_dropped(0),
+      m_flush_requested(0),
+      m_flushed(0),
+      m_notified(false),
+      m_max_lines(0),
+      m_interval(100),
+      m_stop(true) {}
+
+NmeaLogPipeline::~NmeaLogPipeline() { Stop(); }
+
+void NmeaLogPipeline::Push(NmeaLogEntry&& entry) {
+  if (!m_ring.Push(std::move(entry))) m_ring_dropped++;
+}
+
+void NmeaLogPipeline::Start(size_t max_lines,
+                            std::chrono::milliseconds interval,
+                            std::function<void()> ready) {
+  Stop();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_max_lines = max_lines;
+  m_interval = interval;
+  m_ready = ready;
+  m_stop = false;
+  m_thread = std::thread(&NmeaLogPipeline::Run, this);
+}
+
+void NmeaLogPipeline::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stop) return;
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  m_flushed_cv.notify_all();
+  if (m_thread.joinable()) m_thread.join();
+
+  NmeaLogEntry entry;
+  while (m_ring.Pop(entry)) continue;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_batch = NmeaLogBatch();
+  m_notified = false;
+  m_ring_dropped = 0;
+}
+
+void NmeaLogPipeline::Flush() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (m_stop) return;
+  uint64_t flush = ++m_flush_requested;
+  m_cv.notify_all();
+  m_flushed_cv.wait(lock, [&] { return m_stop || m_flushed >= flush; });
+}
+
+void NmeaLogPipeline::SetFilter(const std::string& filter) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_filter = filter;
+}
+
+NmeaLogBatch NmeaLogPipeline::TakeBatch() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  NmeaLogBatch batch;
+  std::swap(batch, m_batch);
+  m_notified = false;
+  return batch;
+}
+
+void NmeaLogPipeline::Run() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_stop) {
+    m_cv.wait_for(lock, m_interval,
+                  [&] { return m_stop || m_flushed != m_flush_requested; });
+    if (m_stop) return;
+    uint64_t flush = m_flush_requested;
+    lock.unlock();
+    Drain();
+    lock.lock();
+    if (!m_notified && (m_batch.lines.size() || m_batch.dropped)) {
+      m_notified = true;
+      auto ready = m_ready;
+      lock.unlock();
+      ready();
+      lock.lock();
+    }
+    m_flushed = flush;
+    m_flushed_cv.notify_all();
+  }
+}
+
+void NmeaLogPipeline::Drain() {
+  std::string filter;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    filter = m_filter;
+  }
+
+  std::vector<std::string> lines;
+  lines.reserve(kDrainChunk);
+  NmeaLogEntry entry;
+  bool more = true;
+  while (more) {
+    //  Without filter only the lines which can end up on screen are worth
+    //  formatting, older ones are counted as dropped.
+    size_t queued = filter.empty() ? m_ring.Size() : 0;
+    uint64_t skipped = 0;
+    while (queued > m_max_lines && m_ring.Pop(entry)) {
+      queued--;
+      skipped++;
+    }
+
+    lines.clear();
+    while (lines.size() < kDrainChunk && (more = m_ring.Pop(entry))) {
+      std::string line = entry.Format();
+      if (filter.empty() || line.find(filter) != std::string::npos)
+        lines.push_back(std::move(line));
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_batch.dropped += skipped + m_ring_dropped.exchange(0);
+    auto& batch = m_batch.lines;
+    for (auto& line : lines) batch.push_back(std::move(line));
+    if (batch.size() > m_max_lines) {
+      size_t excess = batch.size() - m_max_lines;
+      m_batch.dropped += excess;
+      batch.erase(batch.begin(), batch.begin() + excess);
+    }
+  }
+}
@@ -0,0 +1,169 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Lightweight scoped timers for startup and hot path profiling
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include <wx/log.h>
+
+#include "model/perf_trace.h"
+
+using namespace std::chrono;
+
+static thread_local int perf_depth = 0;
+
+static std::string JsonEscape(const char* s) {
+  std::string escaped;
+  for (; *s; s++) {
+    if (*s == '"' || *s == '\\') escaped += '\\';
+    if (static_cast<unsigned char>(*s) >= 0x20) escaped += *s;
+  }
+  return escaped;
+}
+
+const char* const PerfTrace::kStartup = "startup";
+const char* const PerfTrace::kDefault = "opencpn";
+
+PerfTrace& PerfTrace::GetInstance() {
+  static PerfTrace instance;
+  return instance;
+}
+
+PerfTrace::PerfTrace()
+    : m_enabled(false), m_epoch(steady_clock::now()), m_dropped(0) {}
+
+unsigned PerfTrace::ThreadId() {
+  static std::atomic<unsigned> next_id(1);
+  static thread_local unsigned id = next_id++;
+  return id;
+}
+
+void PerfTrace::SetEnabled(bool enabled) {
+  m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void PerfTrace::Record(const char* name, const char* category,
+                       steady_clock::time_point start,
+                       steady_clock::time_point end, int depth) {
+  PerfEvent event;
+  event.name = name;
+  event.category = category;
+  event.start_us = duration_cast<microseconds>(start - m_epoch).count();
+  event.duration_us = duration_cast<microseconds>(end - start).count();
+  event.thread = ThreadId();
+  event.depth = depth;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_events.size() >= kMaxEvents) {
+    m_dropped++;
+    return;
+  }
+  m_events.push_back(event);
+}
+
+std::vector<PerfEvent> PerfTrace::GetEvents() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_events;
+}
+
+uint64_t PerfTrace::GetDropped() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_dropped;
+}
+
+void PerfTrace::Clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_events.clear();
+  m_events.shrink_to_fit();
+  m_dropped = 0;
+}
+
+bool PerfTrace::WriteChromeTrace(const std::string& path) const {
+  auto events = GetEvents();
+  std::ofstream stream(path);
+  stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  const char* separator = "\n";
+  for (const auto& ev : events) {
+    stream << separator << "{\"name\":\"" << JsonEscape(ev.name)
+           << "\",\"cat\":\"" << JsonEscape(ev.category)
+           << "\",\"ph\":\"X\",\"ts\":" << ev.start_us
+           << ",\"dur\":" << ev.duration_us << ",\"pid\":1,\"tid\":"
+           << ev.thread << "}";
+    separator = ",\n";
+  }
+  stream << "\n]}\n";
+  if (!stream.good()) {
+    wxLogWarning("Cannot write trace file %s", path.c_str());
+    return false;
+  }
+  wxLogMessage("Wrote %d trace events to %s", static_cast<int>(events.size()),
+               path.c_str());
+  return true;
+}
+
+void PerfTrace::LogSummary(const std::string& title, const char* category,
+                           int max_depth) const {
+  auto events = GetEvents();
+  events.erase(std::remove_if(events.begin(), events.end(),
+                              [&](const PerfEvent& ev) {
+                                return ev.depth > max_depth ||
+                                       strcmp(ev.category, category) != 0;
+                              }),
+               events.end());
+  std::stable_sort(events.begin(), events.end(),
+                   [](const PerfEvent& a, const PerfEvent& b) {
+                     return a.start_us < b.start_us;
+                   });
+  unsigned this_thread = ThreadId();
+  wxLogMessage("%s timing breakdown:", title.c_str());
+  for (const auto& ev : events) {
+    std::string indent(2 * (ev.depth + 1), ' ');
+    if (ev.thread == this_thread) {
+      wxLogMessage("%s%s: %.1f ms", indent.c_str(), ev.name,
+                   ev.duration_us / 1000.0);
+    } else {
+      wxLogMessage("%s%s: %.1f ms (thread %u)", indent.c_str(), ev.name,
+                   ev.duration_us / 1000.0, ev.thread);
+    }
+  }
+}
+
+PerfScope::PerfScope(const char* name, const char* category)
+    : m_name(name),
+      m_category(category),
+      m_active(PerfTrace::GetInstance().IsEnabled()),
+      m_depth(0) {
+  if (!m_active) return;
+  m_depth = perf_depth++;
+  m_start = steady_clock::now();
+}
+
+void PerfScope::End() {
+  if (!m_active) return;
+  m_active = false;
+  auto end = steady_clock::now();
+  perf_depth--;
+  PerfTrace::GetInstance().Record(m_name, m_category, m_start, end, m_depth);
+}
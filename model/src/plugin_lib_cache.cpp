@@ -0,0 +1,138 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Persistent cache of plugin library check results
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+
+#include "model/plugin_lib_cache.h"
+
+static const char* const kMagic = "OCPN-PLUGIN-LIBS";
+
+static std::vector<std::string> Split(const std::string& line, char sep) {
+  std::vector<std::string> fields;
+  std::istringstream is(line);
+  std::string field;
+  while (std::getline(is, field, sep)) fields.push_back(field);
+  return fields;
+}
+
+PluginLibCache::PluginLibCache(const std::string& path,
+                               const std::string& version)
+    : m_path(path), m_version(version), m_dirty(false) {}
+
+bool PluginLibCache::Stat(const std::string& lib_path, PluginLibInfo& info) {
+  wxFileName fn(lib_path);
+  if (!fn.FileExists()) return false;
+  wxULongLong size = fn.GetSize();
+  if (size == wxInvalidSize) return false;
+  info.path = lib_path;
+  info.size = size.GetValue();
+  info.mtime = static_cast<int64_t>(wxFileModificationTime(lib_path));
+  return true;
+}
+
+bool PluginLibCache::Lookup(const std::string& lib_path,
+                            PluginLibInfo& info) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto found = m_entries.find(lib_path);
+  if (found == m_entries.end()) return false;
+  if (found->second.size != info.size || found->second.mtime != info.mtime)
+    return false;
+  info = found->second;
+  return true;
+}
+
+void PluginLibCache::Update(const PluginLibInfo& info) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries[info.path] = info;
+  m_dirty = true;
+}
+
+void PluginLibCache::Load() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.clear();
+  m_dirty = false;
+  std::ifstream stream(m_path);
+  std::string line;
+  if (!std::getline(stream, line)) return;
+  if (line != std::string(kMagic) + " " + m_version) {
+    wxLogMessage("Discarding plugin library cache from other version");
+    m_dirty = true;
+    return;
+  }
+  //  size, mtime, compatible, loadable, api, major, minor, name, path
+  while (std::getline(stream, line)) {
+    auto fields = Split(line, '\t');
+    if (fields.size() != 9) continue;
+    PluginLibInfo info;
+    try {
+      info.size = std::stoull(fields[0]);
+      info.mtime = std::stoll(fields[1]);
+      info.compatible = fields[2] == "1";
+      info.loadable = fields[3] == "1";
+      info.api_version = std::stoi(fields[4]);
+      info.version_major = std::stoi(fields[5]);
+      info.version_minor = std::stoi(fields[6]);
+    } catch (std::logic_error&) {
+      continue;
+    }
+    info.common_name = fields[7];
+    info.path = fields[8];
+    m_entries[info.path] = info;
+  }
+}
+
+bool PluginLibCache::Save() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_dirty) return true;
+  std::string tmp_path = m_path + ".tmp";
+  {
+    std::ofstream stream(tmp_path);
+    stream << kMagic << " " << m_version << "\n";
+    for (const auto& kv : m_entries) {
+      const PluginLibInfo& info = kv.second;
+      stream << info.size << "\t" << info.mtime << "\t"
+             << (info.compatible ? 1 : 0) << "\t" << (info.loadable ? 1 : 0)
+             << "\t" << info.api_version << "\t" << info.version_major << "\t"
+             << info.version_minor << "\t" << info.common_name << "\t"
+             << info.path << "\n";
+    }
+    if (!stream.good()) {
+      wxLogWarning("Cannot write plugin library cache %s", tmp_path.c_str());
+      return false;
+    }
+  }
+  if (!wxRenameFile(tmp_path, m_path, true)) {
+    wxLogWarning("Cannot update plugin library cache %s", m_path.c_str());
+    return false;
+  }
+  m_dirty = false;
+  return true;
+}
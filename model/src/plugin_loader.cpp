@@ -27,8 +27,11 @@
 #include "config.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <set>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 #ifdef USE_LIBELF
@@ -55,6 +58,7 @@
 #include <wx/tokenzr.h>
 #include <wx/window.h>
 #include <wx/process.h>
+#include <wx/thread.h>
 
 #include "model/base_platform.h"
 #include "model/catalog_handler.h"
@@ -67,6 +71,7 @@
 #include "model/plugin_blacklist.h"
 #include "model/plugin_cache.h"
 #include "model/plugin_handler.h"
+#include "model/plugin_lib_cache.h"
 #include "model/plugin_loader.h"
 #include "model/plugin_paths.h"
 #include "model/safe_mode.h"
@@ -85,6 +90,17 @@
 static const std::vector<std::string> SYSTEM_PLUGINS = {
     "chartdownloader", "wmm", "dashboard", "grib"};
 
+/** Flush log unless running in a compatibility scan thread. */
+static void FlushLog() {
+  if (wxThread::IsMain()) wxLog::FlushActive();
+}
+
+static long MsSince(std::chrono::steady_clock::time_point start) {
+  using namespace std::chrono;
+  return static_cast<long>(
+      duration_cast<milliseconds>(steady_clock::now() - start).count());
+}
+
 /** Return complete PlugInContainer matching pic. */
 static PlugInContainer* GetContainer(const PlugInData& pd,
                                      const ArrayOfPlugIns& plugin_array) {
@@ -419,6 +435,14 @@ bool PluginLoader::LoadAllPlugIns(bool load_enabled, bool keep_orphans) {
   vector<string> dirs = PluginPaths::getInstance()->Libdirs();
   wxLogMessage("PluginLoader: loading plugins from %s", ocpn::join(dirs, ';'));
   setLoadPath();
+  auto start = std::chrono::steady_clock::now();
+  if (!m_lib_cache) {
+    wxString path = g_BasePlatform->GetPrivateDataDir() + sep +
+                    "plugin_libs.dat";
+    m_lib_cache = std::make_unique<PluginLibCache>(path.ToStdString(),
+                                                   VERSION_FULL);
+    m_lib_cache->Load();
+  }
   bool any_dir_loaded = false;
   for (const auto& dir : dirs) {
     wxString wxdir(dir);
@@ -437,6 +461,8 @@ bool PluginLoader::LoadAllPlugIns(bool load_enabled, bool keep_orphans) {
   evt_plugin_loadall_finalize.Notify(errors, "");
   load_errors.clear();
 
+  m_lib_cache->Save();
+  wxLogMessage("PluginLoader: all plugins loaded in %ld ms", MsSince(start));
   return any_dir_loaded;
 }
 
@@ -512,7 +538,8 @@ bool PluginLoader::LoadPluginCandidate(const wxString& file_name,
   wxLogMessage(msg.c_str());
   wxLog::FlushActive();
 
-  bool b_compat = CheckPluginCompatibility(file_name);
+  PluginLibInfo lib_info;
+  bool b_compat = IsCompatible(file_name, lib_info);
 
   if (!b_compat) {
     msg =
@@ -525,16 +552,33 @@ bool PluginLoader::LoadPluginCandidate(const wxString& file_name,
     return false;
   }
 
-  PlugInContainer* pic = LoadPlugIn(file_name);
-
   // Check the config file to see if this PlugIn is user-enabled,
   // only loading enabled plugins.
-  // Make the check late enough to pick up incompatible plugins anyway
+  // Make the check late enough to pick up incompatible plugins anyway,
+  // unless the library is known to load from a previous run.
   const auto path = std::string("/PlugIns/") + plugin_file.ToStdString();
   ConfigVar<bool> enabled(path, "bEnabled", TheBaseConfig());
+  if (load_enabled && !enabled.Get(true) && lib_info.loadable) {
+    wxLogMessage("Skipping not enabled candidate %s, not loaded.",
+                 lib_info.common_name.c_str());
+    return true;
+  }
+
+  PlugInContainer* pic = LoadPlugIn(file_name);
+  if (pic && pic->m_pplugin && !lib_info.path.empty()) {
+    lib_info.loadable = true;
+    lib_info.common_name = pic->m_pplugin->GetCommonName().ToStdString();
+    lib_info.api_version = pic->m_api_version;
+    lib_info.version_major = pic->m_pplugin->GetPlugInVersionMajor();
+    lib_info.version_minor = pic->m_pplugin->GetPlugInVersionMinor();
+    m_lib_cache->Update(lib_info);
+  }
+
   if (load_enabled && !enabled.Get(true)) {
-    pic->m_destroy_fn(pic->m_pplugin);
-    delete pic;
+    if (pic) {
+      pic->m_destroy_fn(pic->m_pplugin);
+      delete pic;
+    }
     wxLogMessage("Skipping not enabled candidate.");
     return true;
   }
@@ -557,8 +601,11 @@ bool PluginLoader::LoadPluginCandidate(const wxString& file_name,
       if (dynamic_cast<wxApp*>(wxAppConsole::GetInstance())) {
         // The CLI has no graphics context, but plugins assumes there is.
         if (pic->m_enabled) {
+          auto init_start = std::chrono::steady_clock::now();
           pic->m_cap_flag = pic->m_pplugin->Init();
           pic->m_init_state = true;
+          wxLogMessage("PluginLoader: %s Init() in %ld ms",
+                       pic->m_common_name, MsSince(init_start));
         }
       }
       evt_load_plugin.Notify(pic);
@@ -679,12 +726,16 @@ bool PluginLoader::LoadPlugInDirectory(const wxString& plugin_dir,
   wxDir::GetAllFiles(m_plugin_location, &file_list, pispec, get_flags);
 
   wxLogMessage("Found %d candidates", (int)file_list.GetCount());
+  ScanCandidates(file_list);
   for (unsigned int i = 0; i < file_list.GetCount(); i++) {
     wxLog::FlushActive();
 
     wxString file_name = file_list[i];
 
+    auto start = std::chrono::steady_clock::now();
     LoadPluginCandidate(file_name, load_enabled);
+    wxLogMessage("PluginLoader: %s processed in %ld ms", file_name,
+                 MsSince(start));
   }
 
   // Scrub the plugin array...
@@ -719,6 +770,57 @@ bool PluginLoader::LoadPlugInDirectory(const wxString& plugin_dir,
   return ret;
 }
 
+void PluginLoader::ScanCandidates(const wxArrayString& file_list) {
+  if (!m_lib_cache || safe_mode::get_mode()) return;
+  std::vector<PluginLibInfo> unchecked;
+  for (const auto& file_name : file_list) {
+    PluginLibInfo info;
+    std::string path = file_name.ToStdString();
+    if (PluginLibCache::Stat(path, info) && !m_lib_cache->Lookup(path, info))
+      unchecked.push_back(info);
+  }
+  if (unchecked.empty()) return;
+
+  auto start = std::chrono::steady_clock::now();
+  // The first check initializes static data used by the following ones,
+  // run it before starting any thread.
+  unchecked[0].compatible = CheckPluginCompatibility(unchecked[0].path);
+  m_lib_cache->Update(unchecked[0]);
+
+  std::atomic<size_t> next(1);
+  auto check_next = [&] {
+    for (size_t i = next++; i < unchecked.size(); i = next++) {
+      unchecked[i].compatible = CheckPluginCompatibility(unchecked[i].path);
+      m_lib_cache->Update(unchecked[i]);
+    }
+  };
+  size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+  thread_count = std::min(thread_count, unchecked.size() - 1);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < thread_count; i++) threads.emplace_back(check_next);
+  for (auto& t : threads) t.join();
+  wxLog::FlushActive();
+  wxLogMessage("PluginLoader: checked %d libraries in %ld ms",
+               static_cast<int>(unchecked.size()), MsSince(start));
+}
+
+bool PluginLoader::IsCompatible(const wxString& file_name,
+                                PluginLibInfo& info) {
+  std::string path = file_name.ToStdString();
+  if (!m_lib_cache || !PluginLibCache::Stat(path, info)) {
+    info = PluginLibInfo();
+    return CheckPluginCompatibility(file_name);
+  }
+  if (m_lib_cache->Lookup(path, info)) {
+    wxLogMessage("Plugin is compatible (cached): %s",
+                 info.compatible ? "true" : "false");
+    return info.compatible;
+  }
+  info.compatible = CheckPluginCompatibility(file_name);
+  m_lib_cache->Update(info);
+  return info.compatible;
+}
+
 bool PluginLoader::UpdatePlugIns() {
   bool bret = false;
 
@@ -1133,7 +1235,7 @@ bool ReadModuleInfoFromELF(const wxString& file,
 FailureEpilogue:
   if (elf_handle != nullptr) elf_end(elf_handle);
   if (file_handle >= 0) close(file_handle);
-  wxLog::FlushActive();
+  FlushLog();
   return false;
 }
 #endif  // USE_LIBELF
@@ -1153,6 +1255,7 @@ bool PluginLoader::CheckPluginCompatibility(const wxString& plugin_file) {
   // NOTE: this solution may not follow symlinks but almost no one uses simlinks for wxWidgets dlls
 
   // Only go through this process once per instance of O.
+  std::unique_lock<std::mutex> module_lock(m_module_mutex);
   if (!m_found_wxwidgets) {
     DWORD myPid = GetCurrentProcessId();
     HANDLE hProcess =
@@ -1189,7 +1292,10 @@ bool PluginLoader::CheckPluginCompatibility(const wxString& plugin_file) {
       if (hProcess) CloseHandle(hProcess);
     }
   }
-  if (!m_found_wxwidgets) {
+  const bool found_wxwidgets = m_found_wxwidgets;
+  const wxString module_name = m_module_name;
+  module_lock.unlock();
+  if (!found_wxwidgets) {
     wxLogMessage(wxString::Format("Cannot identify wxWidgets core DLL for %s",
                                   plugin_file.c_str()));
   } else {
@@ -1227,7 +1333,7 @@ bool PluginLoader::CheckPluginCompatibility(const wxString& plugin_file) {
             (PCHAR)((DWORD_PTR)virtualpointer +
                     Rva2Offset(pImportDescriptor->Name, pSech, ntheaders));
         // Check if the plugin DLL dependencey is same as main process wxWidgets core DLL
-        if (m_module_name.Find(libname[i]) != wxNOT_FOUND) {
+        if (module_name.Find(libname[i]) != wxNOT_FOUND) {
           // Match found - plugin is compatible
           b_compat = true;
           wxLogMessage(
@@ -1323,7 +1429,7 @@ bool PluginLoader::CheckPluginCompatibility(const wxString& plugin_file) {
   wxLogMessage("Plugin is compatible by elf library scan: %s",
                b_compat ? "true" : "false");
 
-  wxLog::FlushActive();
+  FlushLog();
   return b_compat;
 
 #endif  // LIBELF
@@ -0,0 +1,143 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Frame time and render pass statistics
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+#include "model/render_stats.h"
+
+using namespace std::chrono;
+
+RollingPercentiles::RollingPercentiles(size_t window_size)
+    : m_window_size(std::max(window_size, static_cast<size_t>(1))),
+      m_next(0),
+      m_count(0),
+      m_last(0) {}
+
+void RollingPercentiles::Add(double value) {
+  if (m_samples.size() < m_window_size) {
+    m_samples.push_back(value);
+  } else {
+    m_samples[m_next] = value;
+  }
+  m_next = (m_next + 1) % m_window_size;
+  m_count++;
+  m_last = value;
+}
+
+double RollingPercentiles::Percentile(double p) const {
+  if (m_samples.empty()) return 0;
+  p = std::min(std::max(p, 0.0), 100.0);
+  std::vector<double> sorted(m_samples);
+  auto rank = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+  size_t ix = rank > 0 ? rank - 1 : 0;
+  std::nth_element(sorted.begin(), sorted.begin() + ix, sorted.end());
+  return sorted[ix];
+}
+
+double RollingPercentiles::Max() const {
+  if (m_samples.empty()) return 0;
+  return *std::max_element(m_samples.begin(), m_samples.end());
+}
+
+const char* const RenderStats::kFrame = "Frame";
+
+RenderStats& RenderStats::GetInstance() {
+  static RenderStats instance;
+  return instance;
+}
+
+void RenderStats::Add(const std::string& pass, double ms) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto found = m_passes.find(pass);
+  if (found == m_passes.end()) {
+    m_order.push_back(pass);
+    found = m_passes.emplace(pass, RollingPercentiles()).first;
+  }
+  found->second.Add(ms);
+}
+
+std::vector<RenderPassStats> RenderStats::GetSummary() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<RenderPassStats> summary;
+  for (const auto& pass : m_order) {
+    const RollingPercentiles& samples = m_passes.at(pass);
+    RenderPassStats stats;
+    stats.pass = pass;
+    stats.count = samples.Count();
+    stats.last = samples.Last();
+    stats.p50 = samples.Percentile(50);
+    stats.p95 = samples.Percentile(95);
+    stats.p99 = samples.Percentile(99);
+    stats.max = samples.Max();
+    summary.push_back(stats);
+  }
+  return summary;
+}
+
+static std::string JsonEscape(const std::string& s) {
+  std::string escaped;
+  for (char c : s) {
+    if (c == '"' || c == '\\') escaped += '\\';
+    if (static_cast<unsigned char>(c) >= 0x20) escaped += c;
+  }
+  return escaped;
+}
+
+std::string RenderStats::ToJson() const {
+  std::ostringstream ss;
+  ss << "{\"unit\":\"ms\",\"passes\":[";
+  const char* separator = "";
+  char buf[160];
+  for (const auto& stats : GetSummary()) {
+    snprintf(buf, sizeof(buf),
+             "\"count\":%llu,\"last\":%.3f,\"p50\":%.3f,\"p95\":%.3f,"
+             "\"p99\":%.3f,\"max\":%.3f}",
+             static_cast<unsigned long long>(stats.count), stats.last,
+             stats.p50, stats.p95, stats.p99, stats.max);
+    ss << separator << "{\"pass\":\"" << JsonEscape(stats.pass) << "\","
+       << buf;
+    separator = ",";
+  }
+  ss << "]}";
+  return ss.str();
+}
+
+void RenderStats::Clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_order.clear();
+  m_passes.clear();
+}
+
+RenderPassTimer::RenderPassTimer(const std::string& pass)
+    : m_pass(pass), m_active(true), m_start(steady_clock::now()) {}
+
+void RenderPassTimer::Stop() {
+  if (!m_active) return;
+  m_active = false;
+  auto elapsed = duration_cast<microseconds>(steady_clock::now() - m_start);
+  RenderStats::GetInstance().Add(m_pass, elapsed.count() / 1000.0);
+}
@@ -40,6 +40,7 @@
 #include "model/nav_object_database.h"
 #include "model/ocpn_utils.h"
 #include "model/pincode.h"
+#include "model/render_stats.h"
 #include "model/rest_server.h"
 #include "model/routeman.h"
 
@@ -347,6 +348,9 @@ static void fn(struct mg_connection* c, int ev, void* ev_data, void* fn_data) {
       std::string reply(kVersionReply);
       ocpn::replace(reply, "@version@", PACKAGE_VERSION);
       mg_http_reply(c, 200, "", reply.c_str());
+    } else if (mg_http_match_uri(hm, "/api/render-stats")) {
+      std::string reply = RenderStats::GetInstance().ToJson();
+      mg_http_reply(c, 200, "", "%s\n", reply.c_str());
     } else if (mg_http_match_uri(hm, "/api/list-routes")) {
       HandleListRoutes(c, hm, parent);
     } else if (mg_http_match_uri(hm, "/api/activate-route")) {
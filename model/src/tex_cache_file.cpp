@@ -0,0 +1,332 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Memory mapped raster texture cache file
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <wx/filename.h>
+#include <wx/log.h>
+
+#include "model/tex_cache_file.h"
+
+static const uint32_t kMagic = 0x4f544332;  // "OTC2"
+
+/** Levels start on a cache line, the index counts offsets in these. */
+static const size_t kLevelAlign = 64;
+
+static uint64_t RoundUp(uint64_t size, uint64_t align) {
+  return (size + align - 1) / align * align;
+}
+
+uint32_t TexCacheChecksum(const unsigned char* data, size_t size) {
+  // FNV-1a taking 8 bytes a step, folded to 32 bits
+  const uint64_t kPrime = 1099511628211ull;
+  uint64_t h = 14695981039346656037ull;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, 8);
+    h = (h ^ word) * kPrime;
+  }
+  for (; i < size; i++) h = (h ^ data[i]) * kPrime;
+  return (uint32_t)(h ^ (h >> 32));
+}
+
+TexCacheFile::TexCacheFile() {}
+
+TexCacheFile::~TexCacheFile() { Close(); }
+
+bool TexCacheFile::IsOpen() const {
+#ifdef _WIN32
+  return m_file != nullptr;
+#else
+  return m_fd >= 0;
+#endif
+}
+
+size_t TexCacheFile::EntrySize() const {
+  return sizeof(uint32_t) + m_layout.level_sizes.size() * sizeof(Extent);
+}
+
+uint64_t TexCacheFile::FileSize() {
+#ifdef _WIN32
+  LARGE_INTEGER li;
+  return GetFileSizeEx(m_file, &li) ? li.QuadPart : 0;
+#else
+  struct stat st;
+  return fstat(m_fd, &st) == 0 ? st.st_size : 0;
+#endif
+}
+
+bool TexCacheFile::Open(const wxString& path, const TexCacheLayout& layout) {
+  Close();
+  m_layout = layout;
+  size_t levels = layout.level_sizes.size();
+  if (levels == 0 || levels > 32 || layout.tiles == 0) return false;
+
+  // magic, layout and level sizes, all as uint32_t
+  std::vector<uint32_t> header = {kMagic,
+                                  layout.format,
+                                  layout.chartdate,
+                                  layout.chartfile_date,
+                                  layout.chartfile_size,
+                                  layout.schemes,
+                                  layout.tiles,
+                                  (uint32_t)levels};
+  header.insert(header.end(), layout.level_sizes.begin(),
+                layout.level_sizes.end());
+  m_header.resize(header.size() * sizeof(uint32_t));
+  memcpy(m_header.data(), header.data(), m_header.size());
+
+  size_t entries = (size_t)layout.schemes * layout.tiles;
+  m_data_offset = RoundUp(m_header.size() + entries * EntrySize(), kPageSize);
+  m_end = m_data_offset;
+  m_levels.assign(entries, 0);
+  m_extents.assign(entries * levels, Extent{0, 0, 0});
+  m_verified.assign(entries, 0);
+  m_corrupt = 0;
+  m_new = false;
+
+  wxFileName fn(path);
+  if (!fn.DirExists()) fn.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+
+#ifdef _WIN32
+  HANDLE file = CreateFileW(path.wc_str(), GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) return false;
+  m_file = file;
+#else
+  m_fd = open(path.fn_str(), O_RDWR | O_CREAT, 0644);
+  if (m_fd < 0) return false;
+#endif
+  uint64_t file_size = FileSize();
+
+  std::vector<unsigned char> found(m_header.size());
+  if (file_size < m_data_offset || !ReadAt(0, found.data(), found.size()) ||
+      found != m_header) {
+    if (!Reset()) {
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  std::vector<unsigned char> index(entries * EntrySize());
+  if (!ReadAt(m_header.size(), index.data(), index.size())) {
+    Close();
+    return false;
+  }
+  bool empty = true;
+  for (size_t i = 0; i < entries; i++) {
+    const unsigned char* p = index.data() + i * EntrySize();
+    uint32_t& mask = m_levels[i];
+    memcpy(&mask, p, sizeof(uint32_t));
+    memcpy(&m_extents[i * levels], p + sizeof(uint32_t),
+           levels * sizeof(Extent));
+    mask &= (1u << levels) - 1;
+    for (unsigned l = 0; l < levels; l++) {
+      if (!(mask & (1u << l))) continue;
+      const Extent& extent = m_extents[i * levels + l];
+      uint64_t offset = (uint64_t)extent.offset * kLevelAlign;
+      // a level beyond the end of file is left over from a lost write
+      if (offset < m_data_offset || offset + extent.size > file_size ||
+          extent.size == 0)
+        mask &= ~(1u << l);
+      else
+        m_end = std::max(m_end, offset + extent.size);
+    }
+    if (mask) empty = false;
+  }
+  m_new = empty;
+  Map(file_size);
+  return true;
+}
+
+bool TexCacheFile::Reset() {
+  Unmap();
+#ifdef _WIN32
+  LARGE_INTEGER zero;
+  zero.QuadPart = 0;
+  if (!SetFilePointerEx(m_file, zero, NULL, FILE_BEGIN) ||
+      !SetEndOfFile(m_file))
+    return false;
+#else
+  if (ftruncate(m_fd, 0) != 0) return false;
+#endif
+  std::vector<unsigned char> start(m_header);
+  start.resize(m_data_offset, 0);
+  if (!WriteAt(0, start.data(), start.size())) return false;
+  m_new = true;
+  return true;
+}
+
+void TexCacheFile::Close() {
+  Unmap();
+#ifdef _WIN32
+  if (m_file) CloseHandle(m_file);
+  m_file = nullptr;
+#else
+  if (m_fd >= 0) close(m_fd);
+  m_fd = -1;
+#endif
+}
+
+bool TexCacheFile::Map(uint64_t size) {
+  Unmap();
+  if (size == 0) return false;
+#ifdef _WIN32
+  HANDLE mapping =
+      CreateFileMappingW(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!mapping) return false;
+  void* map = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!map) {
+    CloseHandle(mapping);
+    return false;
+  }
+  m_mapping = mapping;
+#else
+  void* map = mmap(nullptr, size, PROT_READ, MAP_SHARED, m_fd, 0);
+  if (map == MAP_FAILED) return false;
+#endif
+  m_map = (const unsigned char*)map;
+  m_map_size = size;
+  return true;
+}
+
+void TexCacheFile::Unmap() {
+  if (!m_map) return;
+#ifdef _WIN32
+  UnmapViewOfFile(m_map);
+  CloseHandle(m_mapping);
+  m_mapping = nullptr;
+#else
+  munmap((void*)m_map, m_map_size);
+#endif
+  m_map = nullptr;
+  m_map_size = 0;
+}
+
+bool TexCacheFile::ReadAt(uint64_t offset, void* data, size_t size) {
+#ifdef _WIN32
+  OVERLAPPED ov = {};
+  ov.Offset = (DWORD)offset;
+  ov.OffsetHigh = (DWORD)(offset >> 32);
+  DWORD done = 0;
+  return ReadFile(m_file, data, (DWORD)size, &done, &ov) && done == size;
+#else
+  return pread(m_fd, data, size, offset) == (ssize_t)size;
+#endif
+}
+
+bool TexCacheFile::WriteAt(uint64_t offset, const void* data, size_t size) {
+#ifdef _WIN32
+  OVERLAPPED ov = {};
+  ov.Offset = (DWORD)offset;
+  ov.OffsetHigh = (DWORD)(offset >> 32);
+  DWORD done = 0;
+  return WriteFile(m_file, data, (DWORD)size, &done, &ov) && done == size;
+#else
+  return pwrite(m_fd, data, size, offset) == (ssize_t)size;
+#endif
+}
+
+bool TexCacheFile::WriteEntry(size_t index) {
+  size_t levels = m_layout.level_sizes.size();
+  std::vector<unsigned char> buf(EntrySize());
+  memcpy(buf.data(), &m_levels[index], sizeof(uint32_t));
+  memcpy(buf.data() + sizeof(uint32_t), &m_extents[index * levels],
+         levels * sizeof(Extent));
+  return WriteAt(m_header.size() + index * EntrySize(), buf.data(),
+                 buf.size());
+}
+
+bool TexCacheFile::Has(unsigned scheme, unsigned tile, unsigned level) const {
+  if (scheme >= m_layout.schemes || tile >= m_layout.tiles ||
+      level >= m_layout.level_sizes.size())
+    return false;
+  return m_levels[scheme * m_layout.tiles + tile] & (1u << level);
+}
+
+const unsigned char* TexCacheFile::Get(unsigned scheme, unsigned tile,
+                                       unsigned level, size_t* size) {
+  if (!IsOpen() || !Has(scheme, tile, level)) return nullptr;
+  size_t index = scheme * m_layout.tiles + tile;
+  const Extent& extent =
+      m_extents[index * m_layout.level_sizes.size() + level];
+  uint64_t offset = (uint64_t)extent.offset * kLevelAlign;
+
+  // the file grows with each new level, map it again to reach them
+  if (offset + extent.size > m_map_size) {
+    uint64_t file_size = FileSize();
+    if (offset + extent.size <= file_size) Map(file_size);
+  }
+
+  uint32_t bit = 1u << level;
+  bool ok = m_map && offset + extent.size <= m_map_size;
+  if (ok && !(m_verified[index] & bit)) {
+    ok = TexCacheChecksum(m_map + offset, extent.size) == extent.checksum;
+    if (ok) m_verified[index] |= bit;
+  }
+  if (!ok) {
+    m_levels[index] &= ~bit;
+    WriteEntry(index);
+    m_corrupt++;
+    return nullptr;
+  }
+  *size = extent.size;
+  return m_map + offset;
+}
+
+bool TexCacheFile::Put(unsigned scheme, unsigned tile, unsigned level,
+                       const unsigned char* data, size_t size) {
+  if (!IsOpen() || scheme >= m_layout.schemes || tile >= m_layout.tiles ||
+      level >= m_layout.level_sizes.size() || size == 0 ||
+      size > UINT32_MAX)
+    return false;
+  size_t index = scheme * m_layout.tiles + tile;
+  uint64_t offset = RoundUp(m_end, m_levels[index] ? kLevelAlign : kPageSize);
+  if (offset / kLevelAlign > UINT32_MAX) return false;
+
+  // data first, so a lost index write only loses this level
+  if (!WriteAt(offset, data, size)) return false;
+  m_end = offset + size;
+  Extent& extent = m_extents[index * m_layout.level_sizes.size() + level];
+  extent.offset = (uint32_t)(offset / kLevelAlign);
+  extent.size = (uint32_t)size;
+  extent.checksum = TexCacheChecksum(data, size);
+  m_levels[index] |= 1u << level;
+  m_verified[index] |= 1u << level;
+  m_new = false;
+  return WriteEntry(index);
+}
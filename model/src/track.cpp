@@ -96,6 +96,8 @@ millions of points.
 #include "model/routeman.h"
 #include "model/select.h"
 
+#include "LOD_reduce.h"
+
 std::vector<Track*> g_TrackList;
 
 #if defined(__UNIX__) && \
@@ -698,30 +700,6 @@ TrackPoint *Track::AddNewPoint(vector2D point, wxDateTime time) {
   return tPoint;
 }
 
-void Track::DouglasPeuckerReducer(std::vector<TrackPoint *> &list,
-                                  std::vector<bool> &keeplist, int from, int to,
-                                  double delta) {
-  keeplist[from] = true;
-  keeplist[to] = true;
-
-  int maxdistIndex = -1;
-  double maxdist = 0;
-
-  for (int i = from + 1; i < to; i++) {
-    double dist = 1852.0 * GetXTE(list[from], list[to], list[i]);
-
-    if (dist > maxdist) {
-      maxdist = dist;
-      maxdistIndex = i;
-    }
-  }
-
-  if (maxdist > delta) {
-    DouglasPeuckerReducer(list, keeplist, from, maxdistIndex, delta);
-    DouglasPeuckerReducer(list, keeplist, maxdistIndex, to, delta);
-  }
-}
-
 double Track::Length() {
   TrackPoint *l = NULL;
   double total = 0.0;
@@ -750,17 +728,26 @@ int Track::Simplify(double maxDelta) {
 
   ::wxBeginBusyCursor();
 
+  //  Points on the earth sphere in meters, so that the distance to a
+  //  segment is the cross track error
+  std::vector<double> xyz;
+  xyz.reserve(TrackPoints.size() * 3);
   for (size_t i = 0; i < TrackPoints.size(); i++) {
     TrackPoint *trackpoint = TrackPoints[i];
+    double lat = trackpoint->m_lat * DEGREE, lon = trackpoint->m_lon * DEGREE;
+    xyz.push_back(WGS84_semimajor_axis_meters * cos(lat) * cos(lon));
+    xyz.push_back(WGS84_semimajor_axis_meters * cos(lat) * sin(lon));
+    xyz.push_back(WGS84_semimajor_axis_meters * sin(lat));
 
     pointlist.push_back(trackpoint);
-    keeplist.push_back(false);
   }
+  keeplist.assign(pointlist.size(), false);
 
-  DouglasPeuckerReducer(pointlist, keeplist, 0, pointlist.size() - 1, maxDelta);
+  LODReduce(xyz.data(), 0, pointlist.size() - 1, maxDelta, keeplist, 3, 3);
 
   pSelect->DeleteAllSelectableTrackSegments(this);
   SubTracks.clear();
+  m_geometry.Clear();
   TrackPoints.clear();
 
   for (size_t i = 0; i < pointlist.size(); i++) {
@@ -0,0 +1,208 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Cached mercator geometry of tracks at several detail levels
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#include "model/georef.h"
+#include "model/track.h"
+#include "model/track_geometry.h"
+
+/** Points per chunk, also the amount re-uploaded when a point is added. */
+static const size_t kChunkPoints = 1024;
+
+/** Largest offset from the chunk reference in meters. */
+static const double kChunkExtent = 1e6;
+
+static std::mutex s_released_mutex;
+static std::vector<unsigned> s_released;
+
+TrackGeometry::~TrackGeometry() { Clear(); }
+
+double TrackGeometry::Tolerance(int level) {
+  return level > 0 ? std::ldexp(1.0, level - 1) : 0;
+}
+
+int TrackGeometry::LevelForScale(double view_scale_ppm) {
+  if (!(view_scale_ppm > 0)) return kLevels - 1;
+  double pixel = 1 / view_scale_ppm;
+  int level = 0;
+  while (level + 1 < kLevels && Tolerance(level + 1) <= pixel) level++;
+  return level;
+}
+
+void TrackGeometry::Update(const std::vector<TrackPoint*>& points) {
+  // Find the unchanged part, only the end of a track is ever replaced
+  size_t keep = std::min(m_points.size(), points.size());
+  while (keep > 0 && m_points[keep - 1] != points[keep - 1]) keep--;
+  if (keep > 0 && keep == m_points.size() &&
+      (points[keep - 1]->m_lat != m_last_lat ||
+       points[keep - 1]->m_lon != m_last_lon))
+    keep--;
+  if (keep == m_points.size() && keep == points.size()) return;
+
+  for (Level& level : m_levels)
+    if (level.built) Truncate(level, keep);
+  m_points.resize(keep);
+  m_y.resize(keep);
+
+  double y30 = toSMcache_y30(0);
+  for (size_t i = keep; i < points.size(); i++) {
+    double x, y;
+    toSMcache(points[i]->m_lat, 0, y30, 0, &x, &y);
+    m_points.push_back(points[i]);
+    m_y.push_back(y);
+  }
+  if (m_points.size()) {
+    m_last_lat = m_points.back()->m_lat;
+    m_last_lon = m_points.back()->m_lon;
+  }
+
+  for (int i = 0; i < kLevels; i++)
+    if (m_levels[i].built) Extend(m_levels[i], Tolerance(i), keep);
+}
+
+std::vector<TrackGeometry::Chunk>& TrackGeometry::GetChunks(int level) {
+  level = std::min(std::max(level, 0), kLevels - 1);
+  Level& l = m_levels[level];
+  if (!l.built) {
+    l.built = true;
+    Extend(l, Tolerance(level), 0);
+  }
+  return l.chunks;
+}
+
+int TrackGeometry::LastKept(int level) const {
+  level = std::min(std::max(level, 0), kLevels - 1);
+  const Level& l = m_levels[level];
+  return l.kept.empty() ? -1 : static_cast<int>(l.kept.back());
+}
+
+void TrackGeometry::Offset(const Chunk& chunk, size_t index, double* x,
+                           double* y) const {
+  const double z = WGS84_semimajor_axis_meters * mercator_k0;
+  double dlon = m_points[index]->m_lon - chunk.ref_lon;
+  if (dlon > 180)
+    dlon -= 360;
+  else if (dlon < -180)
+    dlon += 360;
+  *x = dlon * DEGREE * z;
+  *y = m_y[index] - chunk.ref_y;
+}
+
+void TrackGeometry::Extend(Level& level, double tolerance, size_t from) {
+  double tol2 = tolerance * tolerance;
+  for (size_t i = from; i < m_points.size(); i++) {
+    if (level.kept.empty() || tolerance == 0) {
+      AddKept(level, i);
+      continue;
+    }
+    const Chunk& chunk = level.chunks.back();
+    double x, y;
+    Offset(chunk, i, &x, &y);
+    double dx = x - chunk.xy[chunk.xy.size() - 2];
+    double dy = y - chunk.xy.back();
+    if (dx * dx + dy * dy > tol2) AddKept(level, i);
+  }
+}
+
+void TrackGeometry::AddKept(Level& level, size_t index) {
+  double x = 0, y = 0;
+  if (level.chunks.size()) Offset(level.chunks.back(), index, &x, &y);
+  if (level.chunks.empty() || level.chunks.back().Count() >= kChunkPoints ||
+      std::fabs(x) > kChunkExtent || std::fabs(y) > kChunkExtent) {
+    // Start a chunk at the previous point to continue the strip
+    size_t ref = level.kept.empty() ? index : level.kept.back();
+    level.chunks.emplace_back();
+    Chunk& chunk = level.chunks.back();
+    chunk.ref_lat = m_points[ref]->m_lat;
+    chunk.ref_lon = m_points[ref]->m_lon;
+    chunk.ref_y = m_y[ref];
+    chunk.min_x = chunk.min_y = chunk.max_x = chunk.max_y = 0;
+    if (ref != index) {
+      chunk.xy.push_back(0);
+      chunk.xy.push_back(0);
+      Offset(chunk, index, &x, &y);
+    }
+  }
+  Chunk& chunk = level.chunks.back();
+  chunk.xy.push_back(x);
+  chunk.xy.push_back(y);
+  chunk.min_x = std::min(chunk.min_x, static_cast<float>(x));
+  chunk.min_y = std::min(chunk.min_y, static_cast<float>(y));
+  chunk.max_x = std::max(chunk.max_x, static_cast<float>(x));
+  chunk.max_y = std::max(chunk.max_y, static_cast<float>(y));
+  chunk.dirty = true;
+  level.kept.push_back(index);
+}
+
+void TrackGeometry::Truncate(Level& level, size_t size) {
+  bool changed = false;
+  while (level.kept.size() && level.kept.back() >= size) {
+    level.kept.pop_back();
+    Chunk& chunk = level.chunks.back();
+    chunk.xy.resize(chunk.xy.size() - 2);
+    chunk.dirty = true;
+    changed = true;
+    // A chunk with only the point shared with the previous one is empty
+    if (chunk.Count() == 0 ||
+        (chunk.Count() == 1 && level.chunks.size() > 1)) {
+      Release(chunk);
+      level.chunks.pop_back();
+    }
+  }
+  if (!changed || level.chunks.empty()) return;
+  Chunk& chunk = level.chunks.back();
+  chunk.min_x = chunk.min_y = chunk.max_x = chunk.max_y = 0;
+  for (size_t i = 0; i < chunk.xy.size(); i += 2) {
+    chunk.min_x = std::min(chunk.min_x, chunk.xy[i]);
+    chunk.min_y = std::min(chunk.min_y, chunk.xy[i + 1]);
+    chunk.max_x = std::max(chunk.max_x, chunk.xy[i]);
+    chunk.max_y = std::max(chunk.max_y, chunk.xy[i + 1]);
+  }
+}
+
+void TrackGeometry::Release(Chunk& chunk) {
+  if (!chunk.buffer) return;
+  std::lock_guard<std::mutex> lock(s_released_mutex);
+  s_released.push_back(chunk.buffer);
+  chunk.buffer = 0;
+}
+
+void TrackGeometry::Clear() {
+  for (Level& level : m_levels) {
+    for (Chunk& chunk : level.chunks) Release(chunk);
+    level = Level();
+  }
+  m_points.clear();
+  m_y.clear();
+}
+
+std::vector<unsigned> TrackGeometry::TakeReleasedBuffers() {
+  std::lock_guard<std::mutex> lock(s_released_mutex);
+  std::vector<unsigned> released;
+  released.swap(s_released);
+  return released;
+}
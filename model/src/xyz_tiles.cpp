@@ -0,0 +1,131 @@
+/***************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Web mercator XYZ tile arithmetic
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+
+#include "model/georef.h"
+#include "model/xyz_tiles.h"
+
+static const double kMaxMercatorLat = 85.0511287798;
+
+double TileXToLon(double x, int z) { return x / (1 << z) * 360.0 - 180.0; }
+
+double TileYToLat(double y, int z) {
+  double n = M_PI - 2.0 * M_PI * y / (1 << z);
+  return 180.0 / M_PI * atan(sinh(n));
+}
+
+int LonToTileX(double lon, int z) {
+  int n = 1 << z;
+  int x = static_cast<int>(floor((lon + 180.0) / 360.0 * n));
+  return std::min(std::max(x, 0), n - 1);
+}
+
+int LatToTileY(double lat, int z) {
+  int n = 1 << z;
+  lat = std::min(std::max(lat, -kMaxMercatorLat), kMaxMercatorLat);
+  double rad = lat * M_PI / 180.0;
+  double y = (1.0 - log(tan(rad) + 1.0 / cos(rad)) / M_PI) / 2.0 * n;
+  return std::min(std::max(static_cast<int>(floor(y)), 0), n - 1);
+}
+
+double TileScalePpm(int z, int tile_size) {
+  double world_meters = 2 * M_PI * WGS84_semimajor_axis_meters * mercator_k0;
+  return static_cast<double>(tile_size) * (1 << z) / world_meters;
+}
+
+uint64_t CountTilesInBox(double lat_min, double lon_min, double lat_max,
+                         double lon_max, int zmin, int zmax) {
+  uint64_t count = 0;
+  for (int z = zmin; z <= zmax; z++) {
+    uint64_t columns = LonToTileX(lon_max, z) - LonToTileX(lon_min, z) + 1;
+    uint64_t rows = LatToTileY(lat_min, z) - LatToTileY(lat_max, z) + 1;
+    count += columns * rows;
+  }
+  return count;
+}
+
+std::vector<TileId> TilesInBox(double lat_min, double lon_min, double lat_max,
+                               double lon_max, int zmin, int zmax,
+                               uint64_t max_tiles) {
+  std::vector<TileId> tiles;
+  uint64_t count =
+      CountTilesInBox(lat_min, lon_min, lat_max, lon_max, zmin, zmax);
+  if (count > max_tiles) return tiles;
+  tiles.reserve(count);
+  for (int z = zmin; z <= zmax; z++) {
+    int x0 = LonToTileX(lon_min, z);
+    int x1 = LonToTileX(lon_max, z);
+    int y0 = LatToTileY(lat_max, z);
+    int y1 = LatToTileY(lat_min, z);
+    for (int x = x0; x <= x1; x++) {
+      for (int y = y0; y <= y1; y++) tiles.emplace_back(z, x, y);
+    }
+  }
+  return tiles;
+}
+
+std::string TileRenderSpec::Parse(const std::string& spec) {
+  // The output path might contain ':' as in C:\tiles, split on first two.
+  size_t colon1 = spec.find(':');
+  size_t colon2 =
+      colon1 == std::string::npos ? colon1 : spec.find(':', colon1 + 1);
+  if (colon2 == std::string::npos)
+    return "Expected <bbox>:<zmin>-<zmax>:<output>";
+
+  std::istringstream bbox(spec.substr(0, colon1));
+  char c1 = 0, c2 = 0, c3 = 0;
+  bbox >> lat_min >> c1 >> lon_min >> c2 >> lat_max >> c3 >> lon_max;
+  if (bbox.fail() || c1 != ',' || c2 != ',' || c3 != ',' || !bbox.eof())
+    return "Bad bounding box, expected <lat_min>,<lon_min>,<lat_max>,<lon_max>";
+  if (lat_min >= lat_max || lon_min >= lon_max || lat_min < -90 ||
+      lat_max > 90 || lon_min < -180 || lon_max > 180)
+    return "Bounding box out of range or empty";
+
+  std::istringstream zoom(spec.substr(colon1 + 1, colon2 - colon1 - 1));
+  char dash = 0;
+  zoom >> zmin >> dash >> zmax;
+  if (zoom.fail() || dash != '-' || !zoom.eof())
+    return "Bad zoom range, expected <zmin>-<zmax>";
+  if (zmin < 0 || zmax > 24 || zmin > zmax) return "Zoom range out of 0..24";
+  uint64_t count =
+      CountTilesInBox(lat_min, lon_min, lat_max, lon_max, zmin, zmax);
+  if (count > kMaxTilesInBox)
+    return "Too many tiles: " + std::to_string(count) + ", at most " +
+           std::to_string(kMaxTilesInBox);
+
+  output = spec.substr(colon2 + 1);
+  if (output.empty()) return "Missing output path";
+  return "";
+}
+
+bool TileRenderSpec::IsMbtiles() const {
+  static const std::string kSuffix = ".mbtiles";
+  return output.size() > kSuffix.size() &&
+         output.compare(output.size() - kSuffix.size(), kSuffix.size(),
+                        kSuffix) == 0;
+}
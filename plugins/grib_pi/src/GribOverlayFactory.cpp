@@ -256,7 +256,7 @@ GRIBOverlayFactory::GRIBOverlayFactory(GRIBUICtrlBar &dlg)
   m_tParticleTimer.Connect(
       wxEVT_TIMER, wxTimerEventHandler(GRIBOverlayFactory::OnParticleTimer),
       NULL, this);
-  m_bUpdateParticles = false;
+  m_ParticleFieldId = 0;
 
   // Generate the wind arrow cache
 
@@ -410,6 +410,8 @@ void GRIBOverlayFactory::SetGribTimelineRecordSet(
     GribTimelineRecordSet *pGribTimelineRecordSet) {
   Reset();
   m_pGribTimelineRecordSet = pGribTimelineRecordSet;
+  // new records, particles must sample a new field
+  m_ParticleFieldId++;
 }
 
 void GRIBOverlayFactory::ClearCachedData(void) {
@@ -569,7 +571,6 @@ bool GRIBOverlayFactory::DoRenderGribOverlay(PlugIn_ViewPort *vp) {
 
   //     render each type of record
   GribRecord **pGR = m_pGribTimelineRecordSet->m_GribRecordPtrArray;
-  wxArrayPtrVoid **pIA = m_pGribTimelineRecordSet->m_IsobarArray;
 
   for (int overlay = 1; overlay >= 0; overlay--) {
     for (int i = 0; i < GribOverlaySettings::SETTINGS_COUNT; i++) {
@@ -580,7 +581,7 @@ bool GRIBOverlayFactory::DoRenderGribOverlay(PlugIn_ViewPort *vp) {
         } else {
           if (m_dlg.m_bDataPlot[i]) {
             RenderGribBarbedArrows(i, pGR, vp);
-            RenderGribIsobar(i, pGR, pIA, vp);
+            RenderGribIsobar(i, pGR, m_pGribTimelineRecordSet, vp);
             RenderGribNumbers(i, pGR, vp);
             RenderGribParticles(i, pGR, vp);
           } else {
@@ -593,11 +594,11 @@ bool GRIBOverlayFactory::DoRenderGribOverlay(PlugIn_ViewPort *vp) {
       if (i == GribOverlaySettings::PRESSURE) {
         if (!overlay) { /*no overalay for pressure*/
           if (m_dlg.m_bDataPlot[i]) {
-            RenderGribIsobar(i, pGR, pIA, vp);
+            RenderGribIsobar(i, pGR, m_pGribTimelineRecordSet, vp);
             RenderGribNumbers(i, pGR, vp);
           } else {
             if (m_Settings.Settings[i].m_iIsoBarVisibility)
-              RenderGribIsobar(i, pGR, pIA, vp);
+              RenderGribIsobar(i, pGR, m_pGribTimelineRecordSet, vp);
           }
         }
         continue;
@@ -608,7 +609,7 @@ bool GRIBOverlayFactory::DoRenderGribOverlay(PlugIn_ViewPort *vp) {
         RenderGribOverlayMap(i, pGR, vp);
       else {
         RenderGribBarbedArrows(i, pGR, vp);
-        RenderGribIsobar(i, pGR, pIA, vp);
+        RenderGribIsobar(i, pGR, m_pGribTimelineRecordSet, vp);
         RenderGribDirectionArrows(i, pGR, vp);
         RenderGribNumbers(i, pGR, vp);
         RenderGribParticles(i, pGR, vp);
@@ -1411,7 +1412,7 @@ void GRIBOverlayFactory::RenderGribBarbedArrows(int settings, GribRecord **pGR,
 }
 
 void GRIBOverlayFactory::RenderGribIsobar(int settings, GribRecord **pGR,
-                                          wxArrayPtrVoid **pIsobarArray,
+                                          GribTimelineRecordSet *pSet,
                                           PlugIn_ViewPort *vp) {
   if (!m_Settings.Settings[settings].m_bIsoBars) return;
 
@@ -1428,8 +1429,23 @@ void GRIBOverlayFactory::RenderGribIsobar(int settings, GribRecord **pGR,
   wxColour back_color;
   GetGlobalColor(_T ( "DILG1" ), &back_color);
 
+  double min = m_Settings.GetMin(settings);
+  double max = m_Settings.GetMax(settings);
+
+  /* convert min and max to units being used */
+  double factor = (settings == GribOverlaySettings::PRESSURE &&
+                   m_Settings.Settings[settings].m_Units == 2)
+                      ? 0.03
+                      : 1.;  // divide spacing by 1/33 for PRESURRE & inHG
+  double spacing = m_Settings.Settings[settings].m_iIsoBarSpacing * factor;
+
+  IsoLineCache &cache = pSet->GetIsoLineCache(idx);
+  IsoLineCache::Key key = {pGRA, settings, min, max, spacing,
+                           m_Settings.Settings[settings].m_Units};
+  std::shared_ptr<IsoLineList> isolines = cache.Find(key);
+
   //    Initialize the array of Isobars if necessary
-  if (!pIsobarArray[idx]) {
+  if (!isolines) {
     // build magnitude from multiple record types like wind and current
     if (idy >= 0 && !polar && pGR[idy]) {
       pGRM = GribRecord::MagnitudeRecord(*pGR[idx], *pGR[idy]);
@@ -1441,48 +1457,26 @@ void GRIBOverlayFactory::RenderGribIsobar(int settings, GribRecord **pGR,
       pGRA = pGRM;
     }
 
-    pIsobarArray[idx] = new wxArrayPtrVoid;
-    IsoLine *piso;
-
-    wxGenericProgressDialog *progressdialog = nullptr;
-    wxDateTime start = wxDateTime::Now();
-
-    double min = m_Settings.GetMin(settings);
-    double max = m_Settings.GetMax(settings);
-
-    /* convert min and max to units being used */
-    double factor = (settings == GribOverlaySettings::PRESSURE &&
-                     m_Settings.Settings[settings].m_Units == 2)
-                        ? 0.03
-                        : 1.;  // divide spacing by 1/33 for PRESURRE & inHG
-
-    for (double press = min; press <= max;
-         press += (m_Settings.Settings[settings].m_iIsoBarSpacing * factor)) {
-      if (progressdialog)
-        progressdialog->Update(press - min);
-      else {
-        wxDateTime now = wxDateTime::Now();
-        if ((now - start).GetSeconds() > 3 && press - min < (max - min) / 2) {
-          progressdialog = new wxGenericProgressDialog(
-              _("Building Isobar map"), _("Wind"), max - min + 1, NULL,
-              wxPD_SMOOTH | wxPD_ELAPSED_TIME | wxPD_REMAINING_TIME);
-        }
-      }
-
-      piso = new IsoLine(press,
-                         m_Settings.CalibrationFactor(settings, press, true),
-                         m_Settings.CalibrationOffset(settings), pGRA);
-
-      pIsobarArray[idx]->Add(piso);
+    //    All levels are extracted in a single pass over the grid
+    std::vector<IsoLineLevel> levels;
+    for (double press = min; press <= max; press += spacing) {
+      double threshold =
+          press / m_Settings.CalibrationFactor(settings, press, true) -
+          m_Settings.CalibrationOffset(settings);
+      levels.push_back({press, threshold});
     }
-    delete progressdialog;
+
+    isolines = std::make_shared<IsoLineList>();
+    for (IsoLine *piso : IsoLine::ExtractIsoLines(pGRA, levels))
+      isolines->emplace_back(piso);
+    cache.Insert(key, isolines);
 
     delete pGRM;
   }
 
   //    Draw the Isobars
-  for (unsigned int i = 0; i < pIsobarArray[idx]->GetCount(); i++) {
-    IsoLine *piso = (IsoLine *)pIsobarArray[idx]->Item(i);
+  for (auto &iso : *isolines) {
+    IsoLine *piso = iso.get();
     piso->drawIsoLine(this, m_pdc, vp, true);  // g_bGRIBUseHiDef
 
     // Draw Isobar labels
@@ -2065,215 +2059,94 @@ void GRIBOverlayFactory::RenderGribParticles(int settings, GribRecord **pGR,
 
   if (!m_ParticleMap) m_ParticleMap = new ParticleMap(settings);
 
-  std::vector<Particle> &particles = m_ParticleMap->m_Particles;
+  ParticleEngine &engine = m_ParticleMap->m_Engine;
+  engine.SetField(pGRX, pGRY, m_ParticleFieldId);
 
-  const int max_duration = 50;
   const int run_count = 6;
 
   double density = m_Settings.Settings[settings].m_dParticleDensity;
   //    density = density * sqrt(vp.view_scale_ppm);
 
   int history_size = 27 / sqrt(density);
-  history_size = wxMin(history_size, MAX_PARTICLE_HISTORY);
-
-  std::vector<Particle>::iterator it;
-  // if the history size changed
-  if (m_ParticleMap->history_size != history_size) {
-    for (unsigned int i = 0; i < particles.size(); i++) {
-      Particle &it = particles[i];
-      if (m_ParticleMap->history_size > history_size &&
-          it.m_HistoryPos >= history_size) {
-        it = particles[particles.size() - 1];
-        particles.pop_back();
-        i--;
-        continue;
-      }
-
-      it.m_HistorySize = it.m_HistoryPos + 1;
-    }
-    m_ParticleMap->history_size = history_size;
-  }
-
-  // Did the viewport change?  update cached screen coordinates
-  // we could use normalized coordinates in opengl and avoid this
-  PlugIn_ViewPort &lvp = m_ParticleMap->last_viewport;
-  if (lvp.bValid == false || vp->view_scale_ppm != lvp.view_scale_ppm ||
-      vp->skew != lvp.skew || vp->rotation != lvp.rotation) {
-    for (it = particles.begin(); it != particles.end(); it++)
-      for (int i = 0; i < it->m_HistorySize; i++) {
-        Particle::ParticleNode &n = it->m_History[i];
-        float(&p)[2] = n.m_Pos;
-        if (p[0] == -10000) continue;
-
-        wxPoint ps;
-        GetCanvasPixLL(vp, &ps, p[1], p[0]);
-        n.m_Screen[0] = ps.x;
-        n.m_Screen[1] = ps.y;
-      }
-
-    lvp = *vp;
-  } else  // just panning, do quicker update
-      if (vp->clat != lvp.clat || vp->clon != lvp.clon) {
-    wxPoint p1, p2;
-    GetCanvasPixLL(vp, &p1, 0, 0);
-    GetCanvasPixLL(&lvp, &p2, 0, 0);
-
-    p1 -= p2;
-
-    for (it = particles.begin(); it != particles.end(); it++)
-      for (int i = 0; i < it->m_HistorySize; i++) {
-        Particle::ParticleNode &n = it->m_History[i];
-        float(&p)[2] = n.m_Pos;
-        if (p[0] == -10000) continue;
-
-        n.m_Screen[0] += p1.x;
-        n.m_Screen[1] += p1.y;
-      }
-    lvp = *vp;
-  }
-
-  double ptime = 0;
-
-  // update particle map
-  if (m_bUpdateParticles) {
-    for (unsigned int i = 0; i < particles.size(); i++) {
-      Particle &it = particles[i];
-
-      // Update the interpolation factor
-      if (++it.m_Run < run_count) continue;
-      it.m_Run = 0;
-
-      // don't allow particle to live too long
-      if (it.m_Duration > max_duration) {
-        it = particles[particles.size() - 1];
-        particles.pop_back();
-        i--;
-        continue;
-      }
-
-      it.m_Duration++;
-
-      float(&pp)[2] = it.m_History[it.m_HistoryPos].m_Pos;
-
-      // maximum history size
-      if (++it.m_HistorySize > history_size) it.m_HistorySize = history_size;
-
-      if (++it.m_HistoryPos >= history_size) it.m_HistoryPos = 0;
-
-      Particle::ParticleNode &n = it.m_History[it.m_HistoryPos];
-      float(&p)[2] = n.m_Pos;
-      double vkn = 0, ang;
-
-      if (it.m_Duration < max_duration - history_size &&
-          GribRecord::getInterpolatedValues(vkn, ang, pGRX, pGRY, pp[0],
-                                            pp[1]) &&
-          vkn > 0 && vkn < 100) {
-        vkn = m_Settings.CalibrateValue(settings, vkn);
-        double d;
-        if (settings == GribOverlaySettings::CURRENT)
-          d = vkn * run_count;
-        else
-          d = vkn * run_count / 4;
-
-        ang += 180;
-
-#if 0    // elliptical very accurate but incredibly slow
-                double dp[2];
-                PositionBearingDistanceMercator_Plugin(pp[1], pp[0], ang,
-                                                       d, &dp[1], &dp[0]);
-                p[0] = dp[0];
-                p[1] = dp[1];
-#elif 0  // really fast rectangular.. not really good at high latitudes
-
-        float angr = ang / 180 * M_PI;
-        p[0] = pp[0] + sinf(angr) * d / 60;
-        p[1] = pp[1] + cosf(angr) * d / 60;
-#else    // spherical (close enough)
-        float angr = ang / 180 * M_PI;
-        float latr = pp[1] * M_PI / 180;
-        float D = d / 3443;  // earth radius in nm
-        float sD = sinf(D), cD = cosf(D);
-        float sy = sinf(latr), cy = cosf(latr);
-        float sa = sinf(angr), ca = cosf(angr);
-
-        p[0] = pp[0] + asinf(sa * sD / cy) * 180 / M_PI;
-        p[1] = asinf(sy * cD + cy * sD * ca) * 180 / M_PI;
-#endif
-        wxPoint ps;
-        GetCanvasPixLL(vp, &ps, p[1], p[0]);
-
-        n.m_Screen[0] = ps.x;
-        n.m_Screen[1] = ps.y;
-
-        wxColor c = GetGraphicColor(settings, vkn);
-
-        n.m_Color[0] = c.Red();
-        n.m_Color[1] = c.Green();
-        n.m_Color[2] = c.Blue();
-      } else
-        p[0] = -10000;
-      ptime += sw.Time();
-    }
-  }
-  m_bUpdateParticles = false;
+  history_size = wxMin(history_size, PARTICLE_HISTORY_STRIDE);
 
   int total_particles = density * pGRX->getNi() * pGRX->getNj();
 
   // set max cap to avoid locking the program up
-  if (total_particles > 60000) total_particles = 60000;
-
-  // remove particles if needed;
-  int remove_particles = ((int)particles.size() - total_particles) / 16;
-  for (int i = 0; i < remove_particles; i++) particles.pop_back();
-
-  // add new particles as needed
-  int run = 0;
-  int new_particles = (total_particles - (int)particles.size()) / 64;
-
-  for (int npi = 0; npi < new_particles; npi++) {
-    float p[2];
-    double vkn, ang;
-    for (int i = 0; i < 20; i++) {
-      // random position in the grib area
-      p[0] =
-          (float)rand() / RAND_MAX * (pGRX->getLonMax() - pGRX->getLonMin()) +
-          pGRX->getLonMin();
-      p[1] =
-          (float)rand() / RAND_MAX * (pGRX->getLatMax() - pGRX->getLatMin()) +
-          pGRX->getLatMin();
-
-      if (GribRecord::getInterpolatedValues(vkn, ang, pGRX, pGRY, p[0], p[1]) &&
-          vkn > 0 && vkn < 100)
-        vkn = m_Settings.CalibrateValue(settings, vkn);
-      else
-        continue;  // try again
+  if (total_particles > 100000) total_particles = 100000;
+
+  //  Engine parameters, only passed on when changed
+  ParticleEngine::Params params;
+  params.max_particles = total_particles;
+  params.history_size = history_size;
+  params.max_duration = 50;
+  params.run_count = run_count;
+  // distance moved in nm is the speed in knots times run_count, scaled
+  // down for wind
+  double nm_per_ms = 3.6 / 1.852 * run_count;
+  if (settings != GribOverlaySettings::CURRENT) nm_per_ms /= 4;
+  params.distance_scale = nm_per_ms / 60;
+  /* try hard to find a random position where current is faster than 1 knot
+   */
+  params.min_spawn_speed =
+      settings == GribOverlaySettings::CURRENT ? 1.852 / 3.6 : 0;
+  params.color_lut.resize(3 * ParticleEngine::kColorLutSize);
+  for (int i = 0; i < ParticleEngine::kColorLutSize; i++) {
+    double vkn = (i + .5) * ParticleEngine::kMaxSpeed /
+                 ParticleEngine::kColorLutSize;
+    GetGraphicColor(settings, m_Settings.CalibrateValue(settings, vkn),
+                    params.color_lut[3 * i], params.color_lut[3 * i + 1],
+                    params.color_lut[3 * i + 2]);
+  }
+  ParticleEngine::Params &last = m_ParticleMap->m_Params;
+  if (params.max_particles != last.max_particles ||
+      params.history_size != last.history_size ||
+      params.distance_scale != last.distance_scale ||
+      params.min_spawn_speed != last.min_spawn_speed ||
+      params.color_lut != last.color_lut) {
+    engine.SetParams(params);
+    last = params;
+  }
 
-      /* try hard to find a random position where current is faster than 1 knot
-       */
-      if (settings != GribOverlaySettings::CURRENT || vkn > 1 - (double)i / 20)
-        break;
+  std::shared_ptr<const ParticleFrame> frame = engine.GetFrame();
+  const ParticleFrame &f = *frame;
+  const int stride = PARTICLE_HISTORY_STRIDE;
+
+  //  Project all particle nodes. In mercator the screen position is an
+  //  affine function of longitude and mercator y, no need to call into
+  //  the core for each point.
+  std::vector<float> &screen = m_ParticleMap->m_Screen;
+  screen.resize(2 * f.count * stride);
+  if (vp->m_projection_type == PI_PROJECTION_MERCATOR) {
+    const double dlon = 1, dmerc = 0.01;
+    double mlat = ParticleEngine::ToMerc(vp->clat);
+    double lat2 = (2 * atan(exp(mlat + dmerc)) - M_PI / 2) * 180 / M_PI;
+    wxPoint2DDouble p0, p1, p2;
+    GetDoubleCanvasPixLL(vp, &p0, vp->clat, vp->clon);
+    GetDoubleCanvasPixLL(vp, &p1, vp->clat, vp->clon + dlon);
+    GetDoubleCanvasPixLL(vp, &p2, lat2, vp->clon);
+    const float ax = (p1.m_x - p0.m_x) / dlon, ay = (p1.m_y - p0.m_y) / dlon;
+    const float bx = (p2.m_x - p0.m_x) / dmerc, by = (p2.m_y - p0.m_y) / dmerc;
+    const float x0 = p0.m_x, y0 = p0.m_y;
+    const float clon = vp->clon, cmerc = mlat;
+    const float *lon = f.lon.data(), *merc = f.merc.data();
+    float *sp = screen.data();
+    for (int n = 0; n < f.count * stride; n++) {
+      float l = lon[n] - clon;
+      l -= 360.f * floorf((l + 180.f) / 360.f);
+      float m = merc[n] - cmerc;
+      sp[2 * n] = x0 + ax * l + bx * m;
+      sp[2 * n + 1] = y0 + ay * l + by * m;
+    }
+  } else {
+    for (int n = 0; n < f.count * stride; n++) {
+      if (std::isnan(f.lon[n])) continue;
+      double lat = 2 * atan(exp(f.merc[n])) * 180 / M_PI - 90;
+      wxPoint2DDouble ps;
+      GetDoubleCanvasPixLL(vp, &ps, lat, f.lon[n]);
+      screen[2 * n] = ps.m_x;
+      screen[2 * n + 1] = ps.m_y;
     }
-
-    Particle np;
-    np.m_Duration = rand() % (max_duration / 2);
-    np.m_HistoryPos = 0;
-    np.m_HistorySize = 1;
-    np.m_Run = run++;
-    if (run == run_count) run = 0;
-
-    memcpy(np.m_History[np.m_HistoryPos].m_Pos, p, sizeof p);
-
-    wxPoint ps;
-    GetCanvasPixLL(vp, &ps, p[1], p[0]);
-    np.m_History[np.m_HistoryPos].m_Screen[0] = ps.x;
-    np.m_History[np.m_HistoryPos].m_Screen[1] = ps.y;
-
-    wxColour c = GetGraphicColor(settings, vkn);
-    np.m_History[np.m_HistoryPos].m_Color[0] = c.Red();
-    np.m_History[np.m_HistoryPos].m_Color[1] = c.Green();
-    np.m_History[np.m_HistoryPos].m_Color[2] = c.Blue();
-
-    particles.push_back(np);
   }
 
   // settings for opengl lines
@@ -2291,35 +2164,36 @@ void GRIBOverlayFactory::RenderGribParticles(int settings, GribRecord **pGR,
   float *&va = m_ParticleMap->vertex_array;
   float *&caf = m_ParticleMap->color_float_array;
 
-  if (m_ParticleMap->array_size < particles.size() && !m_pdc) {
-    m_ParticleMap->array_size = 2 * particles.size();
+  if (m_ParticleMap->array_size < (unsigned int)f.count && !m_pdc) {
+    m_ParticleMap->array_size = 2 * f.count;
     delete[] ca;
     delete[] va;
     delete[] caf;
 
-    ca =
-        new unsigned char[m_ParticleMap->array_size * MAX_PARTICLE_HISTORY * 8];
-    caf = new float[m_ParticleMap->array_size * MAX_PARTICLE_HISTORY * 8];
-    va = new float[m_ParticleMap->array_size * MAX_PARTICLE_HISTORY * 4];
+    ca = new unsigned char[m_ParticleMap->array_size * stride * 8];
+    caf = new float[m_ParticleMap->array_size * stride * 8];
+    va = new float[m_ParticleMap->array_size * stride * 4];
   }
 
   // draw particles
-  for (std::vector<Particle>::iterator it = particles.begin();
-       it != particles.end(); it++) {
+  for (int p = 0; p < f.count; p++) {
     wxUint8 alpha = 250;
 
-    int i = it->m_HistoryPos;
-
-    bool lip_valid = false;
-    float *lp = NULL, lip[2];
+    bool lp_valid = false, lip_valid = false;
+    float lp[2], lip[2];
     wxUint8 lc[4];
     float lcf[4];
 
-    for (;;) {
-      float(&dp)[2] = it->m_History[i].m_Pos;
-      if (dp[0] != -10000) {
-        float(&sp)[2] = it->m_History[i].m_Screen;
-        wxUint8(&ci)[3] = it->m_History[i].m_Color;
+    // interpolate between points..  a cubic interpolation
+    // might allow a much higher run_count
+    float d = (float)f.run[p] / f.run_count;
+
+    int i = f.pos[p];
+    for (int k = 0; k < f.history[p]; k++) {
+      int n = p * stride + i;
+      if (!std::isnan(f.lon[n])) {
+        const float *sp = &screen[2 * n];
+        const uint8_t *ci = &f.color[3 * n];
 
         wxUint8 c[4] = {ci[0], ci[1], (unsigned char)(ci[2] + 240 - alpha / 2),
                         alpha};
@@ -2329,12 +2203,8 @@ void GRIBOverlayFactory::RenderGribParticles(int settings, GribRecord **pGR,
         cf[2] = ((unsigned char)(ci[2] + 240 - alpha / 2)) / 256.;
         cf[3] = alpha / 256.;
 
-        if (lp && fabsf(lp[0] - sp[0]) < vp->pix_width) {
+        if (lp_valid && fabsf(lp[0] - sp[0]) < vp->pix_width) {
           float sip[2];
-
-          // interpolate between points..  a cubic interpolation
-          // might allow a much higher run_count
-          float d = (float)it->m_Run / run_count;
           for (int j = 0; j < 2; j++) sip[j] = d * lp[j] + (1 - d) * sp[j];
 
           if (lip_valid && fabsf(lip[0] - sip[0]) < vp->pix_width) {
@@ -2344,11 +2214,11 @@ void GRIBOverlayFactory::RenderGribParticles(int settings, GribRecord **pGR,
             } else {
               memcpy(ca + 4 * cnt, c, sizeof lc);
               memcpy(caf + 4 * cnt, cf, sizeof lcf);
-              memcpy(va + 2 * cnt, lip, sizeof sp);
+              memcpy(va + 2 * cnt, lip, sizeof lip);
               cnt++;
               memcpy(ca + 4 * cnt, lc, sizeof c);
               memcpy(caf + 4 * cnt, lcf, sizeof cf);
-              memcpy(va + 2 * cnt, sip, sizeof sp);
+              memcpy(va + 2 * cnt, sip, sizeof sip);
               cnt++;
             }
           }
@@ -2359,18 +2229,12 @@ void GRIBOverlayFactory::RenderGribParticles(int settings, GribRecord **pGR,
 
         memcpy(lc, c, sizeof lc);
         memcpy(lcf, cf, sizeof lcf);
-
-        lp = sp;
+        memcpy(lp, sp, sizeof lp);
+        lp_valid = true;
       }
 
-      if (--i < 0) {
-        i = history_size - 1;
-        if (i >= it->m_HistorySize) break;
-      }
-
-      if (i == it->m_HistoryPos) break;
-
-      alpha -= 240 / history_size;
+      if (--i < 0) i = f.history_size - 1;
+      alpha -= 240 / f.history_size;
     }
   }
 
@@ -2393,21 +2257,9 @@ void GRIBOverlayFactory::RenderGribParticles(int settings, GribRecord **pGR,
   //  Try to run at 20 fps,
   //  But also arrange not to consume more than 33% CPU(core) duty cycle
   m_tParticleTimer.Start(wxMax(50 - time, 2 * time), wxTIMER_ONE_SHOT);
-
-#if 0
-    static int total_time;
-    total_time += time;
-    static int total_count;
-    if(++total_count == 100) {
-        printf("time: %.2f\n", (double)total_time / total_count);
-        total_time = total_count = 0;
-    }
-#endif
 }
 
 void GRIBOverlayFactory::OnParticleTimer(wxTimerEvent &event) {
-  m_bUpdateParticles = true;
-
   // If multicanvas are active, render the overlay on the right canvas only
   if (GetCanvasCount() > 1)               // multi?
     GetCanvasByIndex(1)->Refresh(false);  // update the last rendered canvas
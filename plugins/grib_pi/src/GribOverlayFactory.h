@@ -68,54 +68,42 @@ public:
   double m_dwidth, m_dheight;
 };
 
-#define MAX_PARTICLE_HISTORY 8
 #include <vector>
 #include <list>
-struct Particle {
-  int m_Duration;
-
-  // history is a ringbuffer.. because so many particles are
-  // used, it is a slight optimization over std::list
-  int m_HistoryPos, m_HistorySize, m_Run;
-  struct ParticleNode {
-    float m_Pos[2];
-    float m_Screen[2];
-    wxUint8 m_Color[3];
-  } m_History[MAX_PARTICLE_HISTORY];
-};
+
+#include "ParticleEngine.h"
 
 struct ParticleMap {
 public:
   ParticleMap(int settings)
       : m_Setting(settings),
-        history_size(0),
         array_size(0),
         color_array(NULL),
         vertex_array(NULL),
         color_float_array(NULL) {
-    // XXX should be done in default PlugIn_ViewPort CTOR
-    last_viewport.bValid = false;
+    m_Engine.Start();
   }
 
   ~ParticleMap() {
+    m_Engine.Stop();
     delete[] color_array;
     delete[] vertex_array;
     delete[] color_float_array;
   }
 
-  std::vector<Particle> m_Particles;
+  // particles are advected on the engine's worker thread
+  ParticleEngine m_Engine;
+  ParticleEngine::Params m_Params;
 
   // particles are rebuilt whenever any of these fields change
-  time_t m_Reference_Time;
   int m_Setting;
-  int history_size;
 
   unsigned int array_size;
   unsigned char *color_array;
   float *vertex_array;
   float *color_float_array;
 
-  PlugIn_ViewPort last_viewport;
+  std::vector<float> m_Screen;  // projected particle nodes, x y pairs
 };
 
 class LineBuffer {
@@ -198,7 +186,7 @@ private:
   void RenderGribBarbedArrows(int config, GribRecord **pGR,
                               PlugIn_ViewPort *vp);
   void RenderGribIsobar(int config, GribRecord **pGR,
-                        wxArrayPtrVoid **pIsobarArray, PlugIn_ViewPort *vp);
+                        GribTimelineRecordSet *pSet, PlugIn_ViewPort *vp);
   void RenderGribDirectionArrows(int config, GribRecord **pGR,
                                  PlugIn_ViewPort *vp);
   void RenderGribOverlayMap(int config, GribRecord **pGR, PlugIn_ViewPort *vp);
@@ -267,7 +255,7 @@ private:
 
   ParticleMap *m_ParticleMap;
   wxTimer m_tParticleTimer;
-  bool m_bUpdateParticles;
+  unsigned long m_ParticleFieldId;
 
   LineBuffer m_WindArrowCache[14];
   LineBuffer m_SingleArrow[2], m_DoubleArrow[2];
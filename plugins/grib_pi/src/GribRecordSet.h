@@ -89,6 +89,11 @@ public:
     m_GribRecordUnref[i] = true;
   }
 
+  bool IsUnRefGribRecord(int i) const {
+    assert(i >= 0 && i < Idx_COUNT);
+    return m_GribRecordUnref[i];
+  }
+
   void RemoveGribRecords() {
     for (int i = 0; i < Idx_COUNT; i++) {
       if (m_GribRecordUnref[i] == true) {
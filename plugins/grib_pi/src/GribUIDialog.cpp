@@ -136,9 +136,7 @@ wxWindow *GetGRIBCanvas() {
    a subset of the input, but also would need to be recomputed when panning the
    screen */
 GribTimelineRecordSet::GribTimelineRecordSet(unsigned int cnt)
-    : GribRecordSet(cnt) {
-  for (int i = 0; i < Idx_COUNT; i++) m_IsobarArray[i] = NULL;
-}
+    : GribRecordSet(cnt), m_pFileIsoLineCache(NULL) {}
 
 GribTimelineRecordSet::~GribTimelineRecordSet() {
   // RemoveGribRecords();
@@ -146,17 +144,8 @@ GribTimelineRecordSet::~GribTimelineRecordSet() {
 }
 
 void GribTimelineRecordSet::ClearCachedData() {
-  for (int i = 0; i < Idx_COUNT; i++) {
-    if (m_IsobarArray[i]) {
-      //    Clear out the cached isobars
-      for (unsigned int j = 0; j < m_IsobarArray[i]->GetCount(); j++) {
-        IsoLine *piso = (IsoLine *)m_IsobarArray[i]->Item(j);
-        delete piso;
-      }
-      delete m_IsobarArray[i];
-      m_IsobarArray[i] = NULL;
-    }
-  }
+  //    Clear out the cached isobars
+  m_IsoLineCache.Clear();
 }
 
 //---------------------------------------------------------------------------------------
@@ -1484,6 +1473,7 @@ GribTimelineRecordSet *GRIBUICtrlBar::GetTimeLineRecordSet(wxDateTime time) {
 
   GribTimelineRecordSet *set =
       new GribTimelineRecordSet(m_bGRIBActiveFile->GetCounter());
+  set->m_pFileIsoLineCache = &m_bGRIBActiveFile->m_IsoLineCache;
   for (int i = 0; i < Idx_COUNT; i++) {
     GribRecordSet *GRS1 = NULL, *GRS2 = NULL;
     GribRecord *GR1 = NULL, *GR2 = NULL;
@@ -104,8 +104,16 @@ public:
 
   void ClearCachedData();
 
-  /* cache isobars here to speed up rendering */
-  wxArrayPtrVoid *m_IsobarArray[Idx_COUNT];
+  /** Return the isoline cache used for the record at index i. */
+  IsoLineCache &GetIsoLineCache(int i) {
+    if (IsUnRefGribRecord(i) || !m_pFileIsoLineCache) return m_IsoLineCache;
+    return *m_pFileIsoLineCache;
+  }
+
+  /* cache isobars here to speed up rendering, interpolated records are
+     owned by this set, records from the file share the file's cache */
+  IsoLineCache m_IsoLineCache;
+  IsoLineCache *m_pFileIsoLineCache;
 };
 
 //----------------------------------------------------------------------------------------------------------
@@ -282,6 +290,9 @@ public:
 
   const unsigned int GetCounter() { return m_counter; }
 
+  /* isolines of the records owned by this file */
+  IsoLineCache m_IsoLineCache;
+
   WX_DEFINE_ARRAY_INT(int, GribIdxArray);
   GribIdxArray m_GribIdxArray;
 
@@ -26,6 +26,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //#include "model/georef.h"
 #include <wx/graphics.h>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <tuple>
+
 #include "IsoLine.h"
 #include "GribSettingsDialog.h"
 #include "GribOverlayFactory.h"
@@ -159,68 +164,26 @@ ClipResult cohen_sutherland_line_clip_i(int *x0_, int *y0_, int *x1_, int *y1_,
 double round_msvc(double x) { return (floor(x + 0.5)); }
 
 //---------------------------------------------------------------
-IsoLine::IsoLine(double val, double coeff, double offset,
-                 const GribRecord *rec_) {
+IsoLine::IsoLine(double val, const GribRecord *rec_,
+                 std::list<Segment *> &segments) {
+  Init(rec_);
+  value = val;
+  trace.splice(trace.end(), segments);
+  BuildContinuousSegments();
+}
+
+void IsoLine::Init(const GribRecord *rec_) {
   if (wxGetDisplaySize().x > 0) {
     m_pixelMM = PlugInGetDisplaySizeMM() / wxGetDisplaySize().x;
     m_pixelMM = wxMax(.02, m_pixelMM);  // protect against bad data
   } else
     m_pixelMM = 0.27;  // semi-standard number...
 
-  value = val / coeff - offset;
-
   rec = rec_;
   W = rec_->getNi();
   H = rec_->getNj();
-
-  //---------------------------------------------------------
-  // Génère la liste des segments.
-  extractIsoLine(rec_);
-
-  value = val;
-
-  if (trace.size() == 0) return;
-
-  //      Join the isoline segments into a nice list
-  //      Which is end-to-end continuous and unidirectional
-
-  //      Create a master wxList of the trace list
-  std::list<Segment *>::iterator it;
-  for (it = trace.begin(); it != trace.end(); it++) {
-    Segment *seg = *it;
-    seg->bUsed = false;
-    m_seglist.Append(*it);
-  }
-
-  //      Isoline may be discontinuous....
-  //      So build a list of continuous segments
-  bool bdone = false;
-  while (!bdone) {
-    MySegList *ps = BuildContinuousSegment();
-
-    m_SegListList.Append(ps);
-
-    MySegList::Node *node;
-    Segment *seg;
-
-    // recreate the master list, removing used segs
-
-    node = m_seglist.GetFirst();
-    while (node) {
-      seg = node->GetData();
-      if (seg->bUsed) {
-        m_seglist.Erase(node);
-        node = m_seglist.GetFirst();
-      } else
-        node = node->GetNext();
-    }
-
-    if (0 == m_seglist.GetCount()) bdone = true;
-  }
-
-  /// printf("create Isobar : press=%4.0f long=%d\n", pressure/100,
-  /// trace.size());
 }
+
 //---------------------------------------------------------------
 IsoLine::~IsoLine() {
   // printf("delete Isobar : press=%4.0f long=%d\n", pressure/100,
@@ -237,127 +200,68 @@ IsoLine::~IsoLine() {
   m_SegListList.Clear();
 }
 
-MySegList *IsoLine::BuildContinuousSegment(void) {
-  MySegList::Node *node;
-  Segment *seg;
-
-  MySegList *ret_list = new MySegList;
-
-  //     Build a chain extending from the "2" end of the target segment
-  //      The joined list, side 2...
-  MySegList segjoin2;
-
-  //      Add any first segment to the list
-  node = m_seglist.GetFirst();
-  Segment *seg0 = node->GetData();
-  seg0->bUsed = true;
-  segjoin2.Append(seg0);
-
-  Segment *tseg = seg0;
+//      Join the isoline segments into lists which are end-to-end
+//      continuous and unidirectional. Isoline may be discontinuous....
+void IsoLine::BuildContinuousSegments(void) {
+  if (trace.size() == 0) return;
 
-  while (tseg) {
-    bool badded = false;
-    Segment *seg;
-    node = m_seglist.GetFirst();
-    while (node) {
-      seg = node->GetData();
+  //      Index all segments by both endpoints, so that the neighbours of
+  //      a segment are found without scanning the whole trace
+  EndpointIndex index;
+  index.reserve(trace.size() * 2);
+  std::list<Segment *>::iterator it;
+  for (it = trace.begin(); it != trace.end(); it++) {
+    Segment *seg = *it;
+    seg->bUsed = false;
+    index.insert(std::make_pair(EndpointKey{seg->px1, seg->py1}, seg));
+    index.insert(std::make_pair(EndpointKey{seg->px2, seg->py2}, seg));
+  }
 
-      if ((!seg->bUsed) && (seg->py1 == tseg->py2) &&
-          (seg->px1 == tseg->px2))  // fits without reverse
-      {
-        seg->bUsed = true;
-        segjoin2.Append(seg);
-        badded = true;
-        break;
-      } else if ((!seg->bUsed) && (seg->py2 == tseg->py2) &&
-                 (seg->px2 == tseg->px2))  // fits, needs reverse
-      {
-        seg->bUsed = true;
-        double a = seg->px2;
-        seg->px2 = seg->px1;
-        seg->px1 = a;
-        double b = seg->py2;
-        seg->py2 = seg->py1;
-        seg->py1 = b;
-        segjoin2.Append(seg);
-        badded = true;
-        break;
-      }
+  for (it = trace.begin(); it != trace.end(); it++) {
+    if (!(*it)->bUsed) m_SegListList.Append(BuildContinuousSegment(*it, index));
+  }
+}
 
-      node = node->GetNext();
+//      Find an unused segment with an end at (x, y), mark it as used and
+//      orient it so that (x, y) is its "1" end if start, else its "2" end.
+Segment *IsoLine::TakeSegmentAt(EndpointIndex &index, double x, double y,
+                                bool start) {
+  auto range = index.equal_range(EndpointKey{x, y});
+  for (auto it = range.first; it != range.second; it++) {
+    Segment *seg = it->second;
+    if (seg->bUsed) continue;
+    seg->bUsed = true;
+    bool at_start = seg->px1 == x && seg->py1 == y;
+    if (at_start != start) {
+      std::swap(seg->px1, seg->px2);
+      std::swap(seg->py1, seg->py2);
     }
-    if (badded == true)
-      tseg = seg;
-    else
-      tseg = NULL;
+    return seg;
   }
+  return NULL;
+}
 
-  //     Build a chain extending from the "1" end of the target segment
-  //      The joined list, side 1...
-  MySegList segjoin1;
-
-  //      Add the same first segment to the list
-  node = m_seglist.GetFirst();
-  seg0 = node->GetData();
+MySegList *IsoLine::BuildContinuousSegment(Segment *seg0,
+                                           EndpointIndex &index) {
+  MySegList *ret_list = new MySegList;
   seg0->bUsed = true;
-  segjoin1.Append(seg0);
 
-  tseg = seg0;
-
-  while (tseg) {
-    bool badded = false;
-    node = m_seglist.GetFirst();
-    while (node) {
-      seg = node->GetData();
-
-      if ((!seg->bUsed) && (seg->py2 == tseg->py1) &&
-          (seg->px2 == tseg->px1))  // fits without reverse
-      {
-        seg->bUsed = true;
-        segjoin1.Append(seg);
-        badded = true;
-        break;
-      } else if ((!seg->bUsed) && (seg->py1 == tseg->py1) &&
-                 (seg->px1 == tseg->px1))  // fits, needs reverse
-      {
-        seg->bUsed = true;
-        double a = seg->px2;
-        seg->px2 = seg->px1;
-        seg->px1 = a;
-        double b = seg->py2;
-        seg->py2 = seg->py1;
-        seg->py1 = b;
-        segjoin1.Append(seg);
-        badded = true;
-        break;
-      }
-
-      node = node->GetNext();
-    }
-    if (badded == true)
-      tseg = seg;
-    else
-      tseg = NULL;
+  //     Build a chain extending from the "1" end of the target segment,
+  //     prepended in reverse order so the result stays unidirectional
+  std::vector<Segment *> segjoin1;
+  for (Segment *tseg = seg0; tseg;) {
+    tseg = TakeSegmentAt(index, tseg->px1, tseg->py1, false);
+    if (tseg) segjoin1.push_back(tseg);
   }
+  for (auto it = segjoin1.rbegin(); it != segjoin1.rend(); it++)
+    ret_list->Append(*it);
 
-  //     Now have two lists...
-
-  //     Start with "1" side list,
-  //    starting from the end, and skipping the first segment
-
-  int n1 = segjoin1.GetCount();
-  for (int i = n1 - 1; i > 0; i--) {
-    node = segjoin1.Item(i);
-    seg = node->GetData();
-    ret_list->Append(seg);
-  }
+  ret_list->Append(seg0);
 
-  //     Now add the "2"side list
-  int n2 = segjoin2.GetCount();
-  for (int i = 0; i < n2; i++) {
-    node = segjoin2.Item(i);
-    seg = node->GetData();
-    ret_list->Append(seg);
+  //     Now extend from the "2" end of the target segment
+  for (Segment *tseg = seg0; tseg;) {
+    tseg = TakeSegmentAt(index, tseg->px2, tseg->py2, true);
+    if (tseg) ret_list->Append(tseg);
   }
 
   //     And there it is
@@ -670,79 +574,150 @@ void Segment::traduitCode(int I, int w, int J, char c1, int &i, int &j) {
   }
 }
 
-//-----------------------------------------------------------------------
-// Génère la liste des segments.
-// Les coordonnées sont les indices dans la grille du GribRecord
-//---------------------------------------------------------
-void IsoLine::extractIsoLine(const GribRecord *rec) {
-  int i, j, W, H;
-  double a, b, c, d;
-  W = rec->getNi();
-  H = rec->getNj();
+// Détermine si 1 ou 2 segments traversent la case ab-cd
+// a  b
+// c  d
+void IsoLine::extractCellSegments(int ni, int W, int j, double a, double b,
+                                  double c, double d, double value,
+                                  const GribRecord *rec,
+                                  std::list<Segment *> &trace) {
+  //--------------------------------
+  // 1 segment en diagonale
+  //--------------------------------
+  if ((a <= value && b <= value && c <= value && d > value) ||
+      (a > value && b > value && c > value && d <= value))
+    trace.push_back(new Segment(ni, W, j, 'c', 'd', 'b', 'd', rec, value));
+  else if ((a <= value && c <= value && d <= value && b > value) ||
+           (a > value && c > value && d > value && b <= value))
+    trace.push_back(new Segment(ni, W, j, 'a', 'b', 'b', 'd', rec, value));
+  else if ((c <= value && d <= value && b <= value && a > value) ||
+           (c > value && d > value && b > value && a <= value))
+    trace.push_back(new Segment(ni, W, j, 'a', 'b', 'a', 'c', rec, value));
+  else if ((a <= value && b <= value && d <= value && c > value) ||
+           (a > value && b > value && d > value && c <= value))
+    trace.push_back(new Segment(ni, W, j, 'a', 'c', 'c', 'd', rec, value));
+  //--------------------------------
+  // 1 segment H ou V
+  //--------------------------------
+  else if ((a <= value && b <= value && c > value && d > value) ||
+           (a > value && b > value && c <= value && d <= value))
+    trace.push_back(new Segment(ni, W, j, 'a', 'c', 'b', 'd', rec, value));
+  else if ((a <= value && c <= value && b > value && d > value) ||
+           (a > value && c > value && b <= value && d <= value))
+    trace.push_back(new Segment(ni, W, j, 'a', 'b', 'c', 'd', rec, value));
+  //--------------------------------
+  // 2 segments en diagonale
+  //--------------------------------
+  else if (a <= value && d <= value && c > value && b > value) {
+    trace.push_back(new Segment(ni, W, j, 'a', 'b', 'b', 'd', rec, value));
+    trace.push_back(new Segment(ni, W, j, 'a', 'c', 'c', 'd', rec, value));
+  } else if (a > value && d > value && c <= value && b <= value) {
+    trace.push_back(new Segment(ni, W, j, 'a', 'b', 'a', 'c', rec, value));
+    trace.push_back(new Segment(ni, W, j, 'b', 'd', 'c', 'd', rec, value));
+  }
+}
+
+std::vector<IsoLine *> IsoLine::ExtractIsoLines(
+    const GribRecord *rec, const std::vector<IsoLineLevel> &levels) {
+  const int W = rec->getNi();
+  const int H = rec->getNj();
+  const int nlevels = levels.size();
 
   int We = W;
   if (rec->getLonMax() + rec->getDi() - rec->getLonMin() == 360) We++;
 
-  for (j = 1; j < H; j++)  // !!!! 1 to end
-  {
-    a = rec->getValue(0, j - 1);
-    c = rec->getValue(0, j);
-    for (i = 1; i < We; i++, a = b, c = d) {
-      //            x = rec->getX(i);
-      //            y = rec->getY(j);
-
-      int ni = i;
-      if (i == W) ni = 0;
-      b = rec->getValue(ni, j - 1);
-      d = rec->getValue(ni, j);
-
-      if (a == GRIB_NOTDEF || b == GRIB_NOTDEF || c == GRIB_NOTDEF ||
-          d == GRIB_NOTDEF)
-        continue;
+  //  Levels sorted by threshold, so each cell only visits the levels
+  //  between its smallest and largest corner value
+  std::vector<int> order(nlevels);
+  for (int l = 0; l < nlevels; l++) order[l] = l;
+  std::sort(order.begin(), order.end(), [&levels](int l1, int l2) {
+    return levels[l1].threshold < levels[l2].threshold;
+  });
+  std::vector<double> thresholds(nlevels);
+  for (int l = 0; l < nlevels; l++)
+    thresholds[l] = levels[order[l]].threshold;
+
+  //  Split the rows 1..H-1 in bands, one segment list per band and level.
+  //  Concatenating the bands in order gives the segments in row order.
+  unsigned int nthreads = std::max(1u, std::thread::hardware_concurrency());
+  const int band_rows =
+      std::max(8, (int)((H + 4 * nthreads - 1) / (4 * nthreads)));
+  const int nbands = H > 1 ? (H - 2) / band_rows + 1 : 0;
+  std::vector<std::vector<std::list<Segment *>>> bands(
+      nbands, std::vector<std::list<Segment *>>(nlevels));
+
+  std::atomic<int> next_band(0);
+  auto worker = [&]() {
+    for (int band = next_band++; band < nbands; band = next_band++) {
+      std::vector<std::list<Segment *>> &traces = bands[band];
+      int jend = std::min(H, 1 + (band + 1) * band_rows);
+      for (int j = 1 + band * band_rows; j < jend; j++) {
+        double a = rec->getValue(0, j - 1);
+        double c = rec->getValue(0, j);
+        double b, d;
+        for (int i = 1; i < We; i++, a = b, c = d) {
+          int ni = i;
+          if (i == W) ni = 0;
+          b = rec->getValue(ni, j - 1);
+          d = rec->getValue(ni, j);
+
+          if (a == GRIB_NOTDEF || b == GRIB_NOTDEF || c == GRIB_NOTDEF ||
+              d == GRIB_NOTDEF)
+            continue;
+
+          double lo = std::min(std::min(a, b), std::min(c, d));
+          double hi = std::max(std::max(a, b), std::max(c, d));
+          auto first =
+              std::lower_bound(thresholds.begin(), thresholds.end(), lo);
+          for (auto t = first; t != thresholds.end() && *t <= hi; t++) {
+            int l = order[t - thresholds.begin()];
+            extractCellSegments(ni, W, j, a, b, c, d, *t, rec, traces[l]);
+          }
+        }
+      }
+    }
+  };
+
+  nthreads = std::min(nthreads, (unsigned int)nbands);
+  std::vector<std::thread> threads;
+  for (unsigned int t = 1; t < nthreads; t++) threads.emplace_back(worker);
+  worker();
+  for (auto &thread : threads) thread.join();
+
+  std::vector<IsoLine *> isolines(nlevels);
+  for (int l = 0; l < nlevels; l++) {
+    std::list<Segment *> trace;
+    for (int band = 0; band < nbands; band++)
+      trace.splice(trace.end(), bands[band][l]);
+    isolines[l] = new IsoLine(levels[l].value, rec, trace);
+  }
+  return isolines;
+}
 
-      if ((a < value && b < value && c < value && d < value) ||
-          (a > value && b > value && c > value && d > value))
-        continue;
+//==================================================================================
+// IsoLineCache
+//==================================================================================
+bool IsoLineCache::Key::operator<(const Key &other) const {
+  return std::tie(rec, settings, min, max, spacing, units) <
+         std::tie(other.rec, other.settings, other.min, other.max,
+                  other.spacing, other.units);
+}
 
-      // Détermine si 1 ou 2 segments traversent la case ab-cd
-      // a  b
-      // c  d
-      //--------------------------------
-      // 1 segment en diagonale
-      //--------------------------------
-      if ((a <= value && b <= value && c <= value && d > value) ||
-          (a > value && b > value && c > value && d <= value))
-        trace.push_back(new Segment(ni, W, j, 'c', 'd', 'b', 'd', rec, value));
-      else if ((a <= value && c <= value && d <= value && b > value) ||
-               (a > value && c > value && d > value && b <= value))
-        trace.push_back(new Segment(ni, W, j, 'a', 'b', 'b', 'd', rec, value));
-      else if ((c <= value && d <= value && b <= value && a > value) ||
-               (c > value && d > value && b > value && a <= value))
-        trace.push_back(new Segment(ni, W, j, 'a', 'b', 'a', 'c', rec, value));
-      else if ((a <= value && b <= value && d <= value && c > value) ||
-               (a > value && b > value && d > value && c <= value))
-        trace.push_back(new Segment(ni, W, j, 'a', 'c', 'c', 'd', rec, value));
-      //--------------------------------
-      // 1 segment H ou V
-      //--------------------------------
-      else if ((a <= value && b <= value && c > value && d > value) ||
-               (a > value && b > value && c <= value && d <= value))
-        trace.push_back(new Segment(ni, W, j, 'a', 'c', 'b', 'd', rec, value));
-      else if ((a <= value && c <= value && b > value && d > value) ||
-               (a > value && c > value && b <= value && d <= value))
-        trace.push_back(new Segment(ni, W, j, 'a', 'b', 'c', 'd', rec, value));
-      //--------------------------------
-      // 2 segments en diagonale
-      //--------------------------------
-      else if (a <= value && d <= value && c > value && b > value) {
-        trace.push_back(new Segment(ni, W, j, 'a', 'b', 'b', 'd', rec, value));
-        trace.push_back(new Segment(ni, W, j, 'a', 'c', 'c', 'd', rec, value));
-      } else if (a > value && d > value && c <= value && b <= value) {
-        trace.push_back(new Segment(ni, W, j, 'a', 'b', 'a', 'c', rec, value));
-        trace.push_back(new Segment(ni, W, j, 'b', 'd', 'c', 'd', rec, value));
-      }
+std::shared_ptr<IsoLineList> IsoLineCache::Find(const Key &key) const {
+  auto found = m_cache.find(key);
+  return found == m_cache.end() ? nullptr : found->second;
+}
+
+void IsoLineCache::Insert(const Key &key,
+                          std::shared_ptr<IsoLineList> isolines) {
+  if (m_cache.find(key) == m_cache.end()) {
+    if (m_cache.size() >= kMaxEntries) {
+      m_cache.erase(m_order.front());
+      m_order.pop_front();
     }
+    m_order.push_back(key);
   }
+  m_cache[key] = isolines;
 }
 
 // ----------------------------------------------------------------------------
@@ -25,9 +25,13 @@ Dessin des données GRIB (avec QT)
 
 #include <iostream>
 #include <cmath>
+#include <deque>
 #include <vector>
 #include <list>
+#include <map>
+#include <memory>
 #include <set>
+#include <unordered_map>
 
 #include "ocpn_plugin.h"
 
@@ -100,12 +104,27 @@ private:
 class GRIBOverlayFactory;
 class TexFont;
 
+//===============================================================
+// One contour level: the displayed value and the threshold in record units
+struct IsoLineLevel {
+  double value;
+  double threshold;
+};
+
 //===============================================================
 class IsoLine {
 public:
-  IsoLine(double val, double coeff, double offset, const GribRecord *rec);
   ~IsoLine();
 
+  /**
+   * Extract the isolines of all levels in a single pass over the grid.
+   * The grid is split in bands of rows which are processed in parallel,
+   * each cell is only tested against the levels within its value range.
+   * Returned isolines are in the same order as levels, owned by caller.
+   */
+  static std::vector<IsoLine *> ExtractIsoLines(
+      const GribRecord *rec, const std::vector<IsoLineLevel> &levels);
+
   void drawIsoLine(GRIBOverlayFactory *pof, wxDC *dc, PlugIn_ViewPort *vp,
                    bool bHiDef);
 
@@ -120,6 +139,27 @@ public:
   double getValue() { return value; }
 
 private:
+  // Segment endpoint, used to join segments sharing an edge crossing
+  struct EndpointKey {
+    double x, y;
+    bool operator==(const EndpointKey &other) const {
+      return x == other.x && y == other.y;
+    }
+  };
+  struct EndpointHash {
+    size_t operator()(const EndpointKey &k) const {
+      // + 0.0 folds -0.0 into 0.0, they compare equal and must hash equal
+      size_t h = std::hash<double>()(k.x + 0.0);
+      return h ^ (std::hash<double>()(k.y + 0.0) + 0x9e3779b9 + (h << 6) +
+                  (h >> 2));
+    }
+  };
+  typedef std::unordered_multimap<EndpointKey, Segment *, EndpointHash>
+      EndpointIndex;
+
+  IsoLine(double val, const GribRecord *rec, std::list<Segment *> &segments);
+  void Init(const GribRecord *rec);
+
   double value;
   int W, H;  // taille de la grille
   const GribRecord *rec;
@@ -130,12 +170,15 @@ private:
   void intersectionAreteGrille(int i, int j, int k, int l, double *x, double *y,
                                const GribRecord *rec);
 
-  //-----------------------------------------------------------------------
-  // Génère la liste des segments.
-  // Les coordonnées sont les indices dans la grille du GribRecord
-  //---------------------------------------------------------
-  void extractIsoLine(const GribRecord *rec);
-  MySegList *BuildContinuousSegment(void);
+  static void extractCellSegments(int ni, int W, int j, double a, double b,
+                                  double c, double d, double value,
+                                  const GribRecord *rec,
+                                  std::list<Segment *> &trace);
+
+  void BuildContinuousSegments(void);
+  MySegList *BuildContinuousSegment(Segment *seg0, EndpointIndex &index);
+  static Segment *TakeSegmentAt(EndpointIndex &index, double x, double y,
+                                bool start);
 
   MySegList m_seglist;
   MySegListList m_SegListList;
@@ -143,4 +186,36 @@ private:
   double m_pixelMM;
 };
 
+typedef std::vector<std::unique_ptr<IsoLine>> IsoLineList;
+
+//===============================================================
+// Isolines already extracted, keyed by record and contour settings.
+// Records are referenced by address only, so a cache must not outlive
+// the owner of the records it is used for. Holds at most kMaxEntries,
+// the oldest entries are dropped first.
+class IsoLineCache {
+public:
+  static const size_t kMaxEntries = 256;
+
+  struct Key {
+    const GribRecord *rec;
+    int settings;
+    double min, max, spacing;
+    int units;
+    bool operator<(const Key &other) const;
+  };
+
+  std::shared_ptr<IsoLineList> Find(const Key &key) const;
+  void Insert(const Key &key, std::shared_ptr<IsoLineList> isolines);
+  void Clear() {
+    m_cache.clear();
+    m_order.clear();
+  }
+  size_t Size() const { return m_cache.size(); }
+
+private:
+  std::map<Key, std::shared_ptr<IsoLineList>> m_cache;
+  std::deque<Key> m_order;  // insertion order, oldest first
+};
+
 #endif
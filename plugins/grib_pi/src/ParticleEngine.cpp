@@ -0,0 +1,464 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  GRIB Plugin particle advection engine
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "GribRecord.h"
+#include "ParticleEngine.h"
+
+static const float kNaN = std::numeric_limits<float>::quiet_NaN();
+
+//---------------------------------------------------------------------------
+// ParticleField
+//---------------------------------------------------------------------------
+bool ParticleField::Set(const GribRecord *pGRX, const GribRecord *pGRY) {
+  ni = nj = 0;
+  if (!pGRX || !pGRY || !pGRX->isOk() || !pGRY->isOk()) return false;
+  if (pGRX->getNi() != pGRY->getNi() || pGRX->getNj() != pGRY->getNj())
+    return false;
+  if (pGRX->getDi() == 0 || pGRX->getDj() == 0) return false;
+
+  int w = pGRX->getNi(), h = pGRX->getNj();
+  m_u.resize(w * h);
+  m_v.resize(w * h);
+  for (int j = 0; j < h; j++)
+    for (int i = 0; i < w; i++) {
+      double x = pGRX->getValue(i, j), y = pGRY->getValue(i, j);
+      bool ok = x != GRIB_NOTDEF && y != GRIB_NOTDEF;
+      m_u[j * w + i] = ok ? x : kNaN;
+      m_v[j * w + i] = ok ? y : kNaN;
+    }
+
+  m_inv_cos.resize(h);
+  for (int j = 0; j < h; j++) {
+    double lat = std::min(fabs(pGRX->getY(j)), 89.5);
+    m_inv_cos[j] = 1 / cos(lat * M_PI / 180);
+  }
+
+  lo1 = pGRX->getX(0);
+  la1 = pGRX->getY(0);
+  inv_di = 1 / pGRX->getDi();
+  inv_dj = 1 / pGRX->getDj();
+  period = 360 * inv_di;
+  lon_min = pGRX->getLonMin();
+  lon_max = pGRX->getLonMax();
+  lat_min = pGRX->getLatMin();
+  lat_max = pGRX->getLatMax();
+  ni = w;
+  nj = h;
+  return true;
+}
+
+void ParticleField::SampleScalar(const float *lon, const float *lat,
+                                 int count, float *u, float *v,
+                                 float *inv_cos) const {
+  const float xmax = ni - 1, ymax = nj - 1;
+  for (int k = 0; k < count; k++) {
+    float x = (lon[k] - lo1) * inv_di;
+    float y = (lat[k] - la1) * inv_dj;
+    // tour du monde à droite ou à gauche ?
+    if (!(x >= 0 && x <= xmax)) {
+      x += period;
+      if (!(x >= 0 && x <= xmax)) x -= 2 * period;
+    }
+    if (!(x >= 0 && x <= xmax && y >= 0 && y <= ymax)) {
+      u[k] = v[k] = kNaN;
+      inv_cos[k] = 1;
+      continue;
+    }
+    int i0 = x, j0 = y;
+    int i1 = std::min(i0 + 1, ni - 1), j1 = std::min(j0 + 1, nj - 1);
+    float dx = x - i0, dy = y - j0;
+    inv_cos[k] = m_inv_cos[j0] + dy * (m_inv_cos[j1] - m_inv_cos[j0]);
+    dx = (3.f - 2.f * dx) * dx * dx;  // pseudo hermite interpolation
+    dy = (3.f - 2.f * dy) * dy * dy;
+
+    int p00 = j0 * ni + i0, p10 = j0 * ni + i1;
+    int p01 = j1 * ni + i0, p11 = j1 * ni + i1;
+    float u0 = m_u[p00] + dx * (m_u[p10] - m_u[p00]);
+    float u1 = m_u[p01] + dx * (m_u[p11] - m_u[p01]);
+    float v0 = m_v[p00] + dx * (m_v[p10] - m_v[p00]);
+    float v1 = m_v[p01] + dx * (m_v[p11] - m_v[p01]);
+    u[k] = u0 + dy * (u1 - u0);
+    v[k] = v0 + dy * (v1 - v0);
+  }
+}
+
+void ParticleField::Sample(const float *lon, const float *lat, int count,
+                           float *u, float *v, float *inv_cos) const {
+  int k = 0;
+#ifdef __SSE2__
+  const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f);
+  const __m128 two = _mm_set1_ps(2.f), three = _mm_set1_ps(3.f);
+  const __m128 xmax = _mm_set1_ps(ni - 1), ymax = _mm_set1_ps(nj - 1);
+  const __m128 vlo1 = _mm_set1_ps(lo1), vla1 = _mm_set1_ps(la1);
+  const __m128 vinv_di = _mm_set1_ps(inv_di), vinv_dj = _mm_set1_ps(inv_dj);
+  const __m128 vperiod = _mm_set1_ps(period);
+  const __m128 nan = _mm_set1_ps(kNaN);
+
+  auto inside = [](__m128 a, __m128 lo, __m128 hi) {
+    return _mm_and_ps(_mm_cmpge_ps(a, lo), _mm_cmple_ps(a, hi));
+  };
+  auto select = [](__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+  };
+  auto lerp = [](__m128 a, __m128 b, __m128 t) {
+    return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+  };
+
+  alignas(16) int i0[4], j0[4];
+  alignas(16) float c[12][4];
+  for (; k + 4 <= count; k += 4) {
+    __m128 x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(lon + k), vlo1), vinv_di);
+    __m128 y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(lat + k), vla1), vinv_dj);
+
+    // tour du monde à droite ou à gauche ?
+    __m128 xa = _mm_add_ps(x, vperiod), xb = _mm_sub_ps(x, vperiod);
+    x = select(inside(x, zero, xmax), x,
+               select(inside(xa, zero, xmax), xa, xb));
+    __m128 valid =
+        _mm_and_ps(inside(x, zero, xmax), inside(y, zero, ymax));
+    x = _mm_and_ps(valid, x);  // keep indexes in range, NaN included
+    y = _mm_and_ps(valid, y);
+
+    __m128i vi0 = _mm_cvttps_epi32(x), vj0 = _mm_cvttps_epi32(y);
+    __m128 dx = _mm_sub_ps(x, _mm_cvtepi32_ps(vi0));
+    __m128 dy = _mm_sub_ps(y, _mm_cvtepi32_ps(vj0));
+    _mm_store_si128((__m128i *)i0, vi0);
+    _mm_store_si128((__m128i *)j0, vj0);
+
+    // gather the corners, no gather instruction before AVX2
+    for (int l = 0; l < 4; l++) {
+      int i1 = std::min(i0[l] + 1, ni - 1), j1 = std::min(j0[l] + 1, nj - 1);
+      int p00 = j0[l] * ni + i0[l], p10 = j0[l] * ni + i1;
+      int p01 = j1 * ni + i0[l], p11 = j1 * ni + i1;
+      c[0][l] = m_u[p00], c[1][l] = m_u[p10];
+      c[2][l] = m_u[p01], c[3][l] = m_u[p11];
+      c[4][l] = m_v[p00], c[5][l] = m_v[p10];
+      c[6][l] = m_v[p01], c[7][l] = m_v[p11];
+      c[8][l] = m_inv_cos[j0[l]], c[9][l] = m_inv_cos[j1];
+    }
+
+    __m128 ic = lerp(_mm_load_ps(c[8]), _mm_load_ps(c[9]), dy);
+    // pseudo hermite interpolation
+    dx = _mm_mul_ps(_mm_sub_ps(three, _mm_mul_ps(two, dx)),
+                    _mm_mul_ps(dx, dx));
+    dy = _mm_mul_ps(_mm_sub_ps(three, _mm_mul_ps(two, dy)),
+                    _mm_mul_ps(dy, dy));
+    __m128 u0 = lerp(_mm_load_ps(c[0]), _mm_load_ps(c[1]), dx);
+    __m128 u1 = lerp(_mm_load_ps(c[2]), _mm_load_ps(c[3]), dx);
+    __m128 v0 = lerp(_mm_load_ps(c[4]), _mm_load_ps(c[5]), dx);
+    __m128 v1 = lerp(_mm_load_ps(c[6]), _mm_load_ps(c[7]), dx);
+
+    _mm_storeu_ps(u + k, select(valid, lerp(u0, u1, dy), nan));
+    _mm_storeu_ps(v + k, select(valid, lerp(v0, v1, dy), nan));
+    _mm_storeu_ps(inv_cos + k, select(valid, ic, one));
+  }
+#endif
+  SampleScalar(lon + k, lat + k, count - k, u + k, v + k, inv_cos + k);
+}
+
+//---------------------------------------------------------------------------
+// ParticleEngine
+//---------------------------------------------------------------------------
+ParticleEngine::ParticleEngine()
+    : m_count(0),
+      m_step(0),
+      m_seed(2463534242u),
+      m_field_id(0),
+      m_new_params_set(false),
+      m_front(std::make_shared<ParticleFrame>()),
+      m_back(std::make_shared<ParticleFrame>()),
+      m_last_read(std::chrono::steady_clock::now()),
+      m_running(false) {}
+
+ParticleEngine::~ParticleEngine() { Stop(); }
+
+float ParticleEngine::ToMerc(float lat) {
+  lat = std::max(-89.5f, std::min(89.5f, lat));
+  return logf(tanf((float)M_PI / 4 + lat * (float)M_PI / 360));
+}
+
+void ParticleEngine::SetField(const GribRecord *pGRX, const GribRecord *pGRY,
+                              unsigned long field_id) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_field && m_field_id == field_id) return;
+  }
+  //  Copy the grid outside the lock, the worker keeps running on the old one
+  auto field = std::make_shared<ParticleField>();
+  if (!field->Set(pGRX, pGRY)) field.reset();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_field = field;
+  m_field_id = field_id;
+}
+
+void ParticleEngine::SetParams(const Params &params) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_new_params = params;
+  m_new_params.history_size =
+      std::max(1, std::min(params.history_size, PARTICLE_HISTORY_STRIDE));
+  m_new_params.run_count = std::max(1, params.run_count);
+  m_new_params_set = true;
+}
+
+void ParticleEngine::Start() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_running) return;
+  m_running = true;
+  m_thread = std::thread([this] { Run(); });
+}
+
+void ParticleEngine::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running) return;
+    m_running = false;
+  }
+  m_cv.notify_all();
+  m_thread.join();
+}
+
+std::shared_ptr<const ParticleFrame> ParticleEngine::GetFrame() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_last_read = std::chrono::steady_clock::now();
+  return m_front;
+}
+
+void ParticleEngine::Run() {
+  using namespace std::chrono;
+  auto next = steady_clock::now();
+  for (;;) {
+    std::shared_ptr<const ParticleField> field;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      next += milliseconds(std::max(m_params.step_ms, 1));
+      if (m_cv.wait_until(lock, next, [this] { return !m_running; })) break;
+
+      // Nobody renders the particles, don't burn cpu
+      if (steady_clock::now() - m_last_read > seconds(1)) continue;
+
+      if (m_new_params_set) {
+        if (m_new_params.history_size != m_params.history_size) {
+          //  Restart the trails, the rings change size
+          for (int i = 0; i < m_count; i++) {
+            m_pos[i] = 0;
+            m_history[i] = 1;
+          }
+        }
+        m_params = m_new_params;
+        m_new_params_set = false;
+      }
+      field = m_field;
+    }
+    // catch up after stalls without running a burst of steps
+    next = std::max(next, steady_clock::now());
+
+    if (!field) {
+      m_count = 0;
+    } else {
+      Step(*field);
+    }
+    Publish();
+  }
+}
+
+void ParticleEngine::Resize(int count) {
+  m_lon.resize(count);
+  m_lat.resize(count);
+  m_duration.resize(count);
+  m_run.resize(count);
+  m_pos.resize(count);
+  m_history.resize(count);
+  m_hist_lon.resize(count * PARTICLE_HISTORY_STRIDE);
+  m_hist_merc.resize(count * PARTICLE_HISTORY_STRIDE);
+  m_hist_color.resize(3 * count * PARTICLE_HISTORY_STRIDE);
+}
+
+//  Replace particle i by the last one
+void ParticleEngine::Remove(int i) {
+  int last = --m_count;
+  if (i == last) return;
+  m_lon[i] = m_lon[last];
+  m_lat[i] = m_lat[last];
+  m_duration[i] = m_duration[last];
+  m_run[i] = m_run[last];
+  m_pos[i] = m_pos[last];
+  m_history[i] = m_history[last];
+  const int s = PARTICLE_HISTORY_STRIDE;
+  memcpy(&m_hist_lon[i * s], &m_hist_lon[last * s], s * sizeof(float));
+  memcpy(&m_hist_merc[i * s], &m_hist_merc[last * s], s * sizeof(float));
+  memcpy(&m_hist_color[3 * i * s], &m_hist_color[3 * last * s], 3 * s);
+}
+
+void ParticleEngine::Step(const ParticleField &field) {
+  const Params &p = m_params;
+  m_step++;
+
+  //  Collect the particles due for advection, drop the ones too old
+  m_active.clear();
+  for (int i = 0; i < m_count; i++) {
+    if (++m_run[i] < p.run_count) continue;
+    m_run[i] = 0;
+
+    // don't allow particle to live too long
+    if (m_duration[i] > p.max_duration) {
+      Remove(i--);
+      continue;
+    }
+    m_duration[i]++;
+    m_active.push_back(i);
+  }
+
+  Advect(field);
+
+  // remove particles if needed;
+  int remove_particles = (m_count - p.max_particles) / 16;
+  if (remove_particles > 0) m_count -= remove_particles;
+
+  // add new particles as needed
+  int new_particles = (p.max_particles - m_count) / 64;
+  if (new_particles > 0) Spawn(field, new_particles);
+}
+
+void ParticleEngine::Advect(const ParticleField &field) {
+  const Params &p = m_params;
+  const int n = m_active.size();
+  m_blon.resize(n);
+  m_blat.resize(n);
+  m_bu.resize(n);
+  m_bv.resize(n);
+  m_bic.resize(n);
+
+  for (int k = 0; k < n; k++) {
+    m_blon[k] = m_lon[m_active[k]];
+    m_blat[k] = m_lat[m_active[k]];
+  }
+  field.Sample(m_blon.data(), m_blat.data(), n, m_bu.data(), m_bv.data(),
+               m_bic.data());
+
+  //  Move along the field, flat earth over one step is close enough
+  const float scale = p.distance_scale;
+  float *lon = m_blon.data(), *lat = m_blat.data();
+  const float *u = m_bu.data(), *v = m_bv.data(), *ic = m_bic.data();
+  for (int k = 0; k < n; k++) {
+    lon[k] += u[k] * ic[k] * scale;
+    lat[k] += v[k] * scale;
+  }
+
+  const int s = PARTICLE_HISTORY_STRIDE;
+  const int lut_size = p.color_lut.size() / 3;
+  for (int k = 0; k < n; k++) {
+    int i = m_active[k];
+
+    // maximum history size
+    if (++m_history[i] > p.history_size) m_history[i] = p.history_size;
+    if (++m_pos[i] >= p.history_size) m_pos[i] = 0;
+    int node = i * s + m_pos[i];
+
+    float speed = sqrtf(u[k] * u[k] + v[k] * v[k]);
+    if (m_duration[i] < p.max_duration - p.history_size && speed > 0 &&
+        speed < kMaxSpeed) {
+      m_lon[i] = lon[k];
+      m_lat[i] = lat[k];
+      m_hist_lon[node] = lon[k];
+      m_hist_merc[node] = ToMerc(lat[k]);
+      int c = std::min((int)(speed * lut_size / kMaxSpeed), lut_size - 1);
+      if (c >= 0) memcpy(&m_hist_color[3 * node], &p.color_lut[3 * c], 3);
+    } else {
+      m_lon[i] = kNaN;
+      m_hist_lon[node] = kNaN;
+    }
+  }
+}
+
+void ParticleEngine::Spawn(const ParticleField &field, int count) {
+  const Params &p = m_params;
+  const int s = PARTICLE_HISTORY_STRIDE;
+  const int lut_size = p.color_lut.size() / 3;
+  if (m_count + count > (int)m_lon.size()) Resize(m_count + count);
+
+  int run = m_step % p.run_count;
+  for (int n = 0; n < count; n++) {
+    float lon, lat, u, v, ic, speed = 0;
+    bool found = false;
+    for (int i = 0; i < 20 && !found; i++) {
+      // random position in the grib area
+      lon = Random() * (field.lon_max - field.lon_min) + field.lon_min;
+      lat = Random() * (field.lat_max - field.lat_min) + field.lat_min;
+      field.Sample(&lon, &lat, 1, &u, &v, &ic);
+      speed = sqrtf(u * u + v * v);
+      if (!(speed > 0 && speed < kMaxSpeed)) continue;  // try again
+
+      /* try hard to find a random position where the field is faster than
+         the minimum */
+      found = speed > p.min_spawn_speed * (1 - i / 20.f);
+    }
+    if (!found) continue;
+
+    int i = m_count++;
+    m_lon[i] = lon;
+    m_lat[i] = lat;
+    m_duration[i] = (int)(Random() * p.max_duration / 2);
+    m_run[i] = run++;
+    if (run == p.run_count) run = 0;
+    m_pos[i] = 0;
+    m_history[i] = 1;
+    m_hist_lon[i * s] = lon;
+    m_hist_merc[i * s] = ToMerc(lat);
+    int c = std::min((int)(speed * lut_size / kMaxSpeed), lut_size - 1);
+    if (c >= 0) memcpy(&m_hist_color[3 * i * s], &p.color_lut[3 * c], 3);
+  }
+}
+
+void ParticleEngine::Publish() {
+  //  The renderer may still hold the previous front buffer
+  if (m_back.use_count() > 1) m_back = std::make_shared<ParticleFrame>();
+
+  ParticleFrame &f = *m_back;
+  const int s = PARTICLE_HISTORY_STRIDE;
+  f.count = m_count;
+  f.history_size = m_params.history_size;
+  f.run_count = m_params.run_count;
+  f.step = m_step;
+  f.lon.assign(m_hist_lon.begin(), m_hist_lon.begin() + m_count * s);
+  f.merc.assign(m_hist_merc.begin(), m_hist_merc.begin() + m_count * s);
+  f.color.assign(m_hist_color.begin(),
+                 m_hist_color.begin() + 3 * m_count * s);
+  f.pos.assign(m_pos.begin(), m_pos.begin() + m_count);
+  f.history.assign(m_history.begin(), m_history.begin() + m_count);
+  f.run.assign(m_run.begin(), m_run.begin() + m_count);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::swap(m_front, m_back);
+}
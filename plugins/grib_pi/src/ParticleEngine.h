@@ -0,0 +1,192 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  GRIB Plugin particle advection engine
+ *
+ ***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,  USA.         *
+ ***************************************************************************
+ */
+
+#ifndef _GRIB_PARTICLEENGINE_H_
+#define _GRIB_PARTICLEENGINE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class GribRecord;
+
+/**
+ * Vector field sampled by the particles: the u/v components of a pair of
+ * GribRecords copied to float arrays, undefined values stored as NaN.
+ */
+class ParticleField {
+public:
+  ParticleField() : ni(0), nj(0) {}
+
+  /** Copy the grid of two records, return false if they do not match. */
+  bool Set(const GribRecord *pGRX, const GribRecord *pGRY);
+
+  /**
+   * Bilinear sampling of count positions. Writes u and v in m/s and
+   * 1/cos(lat) used to convert eastward distances to degrees of longitude.
+   * u and v are NaN outside the grid or next to undefined grid points.
+   */
+  void Sample(const float *lon, const float *lat, int count, float *u,
+              float *v, float *inv_cos) const;
+
+  bool IsOk() const { return ni > 1 && nj > 1; }
+
+  float lon_min, lon_max, lat_min, lat_max;
+
+private:
+  void SampleScalar(const float *lon, const float *lat, int count, float *u,
+                    float *v, float *inv_cos) const;
+
+  int ni, nj;
+  float lo1, la1;        // first grid point
+  float inv_di, inv_dj;  // grid points per degree, may be negative
+  float period;          // grid points per 360 degrees of longitude
+  std::vector<float> m_u, m_v;
+  std::vector<float> m_inv_cos;  // 1/cos(lat) of each grid row
+};
+
+#define PARTICLE_HISTORY_STRIDE 8
+
+/**
+ * Particle positions published to the renderer after each advection step.
+ * Each particle has a history ring of history_size nodes, node n of
+ * particle i is at index i * PARTICLE_HISTORY_STRIDE + n. Undefined nodes
+ * have a NaN longitude.
+ */
+struct ParticleFrame {
+  ParticleFrame() : count(0), history_size(0), run_count(1), step(0) {}
+
+  int count;
+  int history_size;
+  int run_count;
+  unsigned int step;  // advection step which produced this frame
+
+  std::vector<float> lon;
+  std::vector<float> merc;       // mercator y, see ParticleEngine::ToMerc
+  std::vector<uint8_t> color;    // rgb, 3 bytes per node
+  std::vector<uint8_t> pos;      // ring index of the most recent node
+  std::vector<uint8_t> history;  // number of valid nodes in the ring
+  std::vector<uint8_t> run;      // steps since last advection
+};
+
+/**
+ * Advects particles through a ParticleField on a worker thread.
+ *
+ * Particle state is stored as structure of arrays and advanced in batches
+ * using SIMD bilinear sampling. After every step the positions are
+ * published in a ParticleFrame, the renderer always reads the last complete
+ * frame while the worker fills the other one.
+ */
+class ParticleEngine {
+public:
+  struct Params {
+    Params()
+        : max_particles(0),
+          history_size(1),
+          max_duration(50),
+          run_count(6),
+          step_ms(50),
+          distance_scale(1),
+          min_spawn_speed(0) {}
+
+    int max_particles;
+    int history_size;  // <= PARTICLE_HISTORY_STRIDE
+    int max_duration;  // particle lifetime in advections
+    int run_count;     // steps between two advections of a particle
+    int step_ms;       // worker step interval
+    float distance_scale;   // degrees of latitude per m/s and advection
+    float min_spawn_speed;  // m/s, particles are spawned in faster areas
+    std::vector<uint8_t> color_lut;  // rgb for speeds 0 .. kMaxSpeed m/s
+  };
+
+  static const int kColorLutSize = 512;
+  static constexpr float kMaxSpeed = 100.f;  // m/s, faster data is bogus
+
+  ParticleEngine();
+  ~ParticleEngine();
+
+  /** Replace the field unless field_id is the one currently used. */
+  void SetField(const GribRecord *pGRX, const GribRecord *pGRY,
+                unsigned long field_id);
+  void SetParams(const Params &params);
+
+  void Start();
+  void Stop();
+
+  /** Return last complete frame, kept valid while the pointer is held. */
+  std::shared_ptr<const ParticleFrame> GetFrame();
+
+  static float ToMerc(float lat);
+
+private:
+  void Run();
+  void Step(const ParticleField &field);
+  void Spawn(const ParticleField &field, int count);
+  void Advect(const ParticleField &field);
+  void Remove(int i);
+  void Resize(int count);
+  void Publish();
+  float Random() {
+    // xorshift32, rand() is not thread safe
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return (m_seed & 0xffffff) / (float)0x1000000;
+  }
+
+  // Worker owned particle state, one entry per particle
+  int m_count;
+  std::vector<float> m_lon, m_lat;
+  std::vector<int> m_duration;
+  std::vector<uint8_t> m_run, m_pos, m_history;
+  // History rings, laid out as in ParticleFrame
+  std::vector<float> m_hist_lon, m_hist_merc;
+  std::vector<uint8_t> m_hist_color;
+  Params m_params;
+  unsigned int m_step;
+  uint32_t m_seed;
+
+  // Scratch buffers for the batch kernels
+  std::vector<int> m_active;
+  std::vector<float> m_blon, m_blat, m_bu, m_bv, m_bic;
+
+  std::mutex m_mutex;  // protects everything below
+  std::condition_variable m_cv;
+  std::shared_ptr<const ParticleField> m_field;
+  unsigned long m_field_id;
+  Params m_new_params;
+  bool m_new_params_set;
+  std::shared_ptr<ParticleFrame> m_front, m_back;
+  std::chrono::steady_clock::time_point m_last_read;
+
+  std::thread m_thread;
+  bool m_running;
+};
+
+#endif
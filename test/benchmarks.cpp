@@ -0,0 +1,375 @@
+#include "config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <wx/app.h>
+
+#include <gtest/gtest.h>
+
+#include "LOD_reduce.h"
+#include "lod_reference.h"
+#include "model/ais_list_model.h"
+#include "model/ais_symbol_batch.h"
+#include "model/comm_navmsg_bus.h"
+#include "model/comm_out_queue.h"
+#include "model/track.h"
+#include "model/track_geometry.h"
+#include "observable.h"
+#include "region_ops.h"
+
+#ifdef __linux__
+#include "candump.h"
+#endif
+
+#ifdef HAVE_TEXCMP
+#include "dxt1.h"
+#include "dxt1_images.h"
+#include "squish.h"
+#endif
+
+/*
+ * Timings of the hot paths, not part of the unit tests. Built with
+ * -DOCPN_BUILD_BENCHMARKS=ON and run by hand:
+ *
+ *     $ test/benchmarks [--gtest_filter=TrackGeometry.*]
+ *
+ * Results are printed and also written to test_detail.xml if invoked with
+ * --gtest_output=xml.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static double ElapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+TEST(TrackGeometry, LongTrack) {
+  const size_t kLong = 1000000;
+  const int kLevel = 10;
+  std::vector<TrackPoint*> track;
+  for (size_t i = 0; i < kLong; i++)
+    track.push_back(new TrackPoint(50 + 20 * sin(i * 1e-5), 1e-4 * i));
+  TrackGeometry geometry;
+  auto start = Clock::now();
+  geometry.Update(track);
+  geometry.GetChunks(0);
+  geometry.GetChunks(kLevel);
+  double build_ms = ElapsedMs(start);
+
+  track.push_back(new TrackPoint(50, 100));
+  start = Clock::now();
+  geometry.Update(track);
+  double append_us = 1000 * ElapsedMs(start);
+  std::cout << kLong << " track points, two levels: " << build_ms
+            << " ms to build, " << append_us << " us to append\n";
+  RecordProperty("build_ms", std::to_string(build_ms));
+  RecordProperty("append_us", std::to_string(append_us));
+  for (TrackPoint* p : track) delete p;
+}
+
+/** Push rate of kProducers threads while a writer drains the queue. */
+template <typename Queue>
+static double OutQueueRate(Queue& queue) {
+  const int kProducers = 4;
+  const int kTypes = 8;
+  const int kCount = 20000;
+  std::atomic<bool> done(false);
+  std::thread writer([&] {
+    while (true) {
+      bool was_done = done.load();
+      while (queue.size() > 0) {
+        try {
+          queue.pop();
+        } catch (std::underflow_error&) {
+        }
+      }
+      if (was_done) break;
+      std::this_thread::yield();
+    }
+  });
+  auto start = Clock::now();
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < kCount; i++) {
+        std::string line = "$" + std::string(1, 'A' + p) + "X" +
+                           std::string(1, 'A' + i % kTypes) + "XX," +
+                           std::to_string(i);
+        queue.push_back(line);
+      }
+    });
+  }
+  for (auto& producer : producers) producer.join();
+  double elapsed_ms = ElapsedMs(start);
+  done = true;
+  writer.join();
+  return kProducers * kCount / elapsed_ms * 1000;
+}
+
+TEST(CommOutQueue, Producers) {
+  CommOutQueue mutex_queue(12);
+  double mutex_rate = OutQueueRate(mutex_queue);
+  LockFreeCommOutQueue lockfree(12, 1024);
+  double lockfree_rate = OutQueueRate(lockfree);
+  std::cout << "msgs/s, CommOutQueue: " << mutex_rate
+            << ", LockFreeCommOutQueue: " << lockfree_rate << "\n";
+  RecordProperty("mutex_msgs_per_s", std::to_string(mutex_rate));
+  RecordProperty("lockfree_msgs_per_s", std::to_string(lockfree_rate));
+}
+
+/** Messages per second through NavMsgBus::Notify() to an ObsListener. */
+class NavMsgBusObservableRate : public wxAppConsole {
+public:
+  NavMsgBusObservableRate(int count, bool resolved) : rate(0) {
+    auto& bus = NavMsgBus::GetInstance();
+    int received = 0;
+    ObsListener listener(Nmea0183Msg("GPOBS"),
+                         [&](ObservedEvt&) { received++; });
+    NavMsgIdCache cache;
+    auto start = Clock::now();
+    for (int i = 0; i < count; i++) {
+      auto msg = std::make_shared<Nmea0183Msg>("GPOBS");
+      if (resolved) cache.Resolve(*msg);
+      bus.Notify(msg);
+    }
+    ProcessPendingEvents();
+    EXPECT_EQ(received, count);
+    rate = count / ElapsedMs(start) * 1000;
+  }
+
+  double rate;
+};
+
+TEST(NavMsgBus, Throughput) {
+  const int kCount = 100000;
+  auto& bus = NavMsgBus::GetInstance();
+  NavMsgBusObservableRate observable(kCount, false);
+  NavMsgBusObservableRate resolved(kCount, true);
+
+  //  Direct callbacks, the subscriber runs on the notifying thread
+  std::atomic<int> count(0);
+  auto msg = std::make_shared<Nmea0183Msg>("GPTHR");
+  NavMsgIdCache cache;
+  cache.Resolve(*msg);
+  NavMsgSubscription direct(
+      msg->msg_id, [&](std::shared_ptr<const NavMsg>) { count++; },
+      NavMsgDelivery::Direct);
+  auto start = Clock::now();
+  for (int i = 0; i < kCount; i++) bus.Notify(msg);
+  double direct_rate = kCount / ElapsedMs(start) * 1000;
+  EXPECT_EQ(count, kCount);
+  direct.Reset();
+
+  //  Worker callbacks, latency from Notify() to the callback
+  std::atomic<int64_t> latency_ns(0);
+  std::atomic<int> worker_count(0);
+  std::atomic<int64_t> sent(0);
+  NavMsgSubscription worker(
+      msg->msg_id,
+      [&](std::shared_ptr<const NavMsg>) {
+        latency_ns += Clock::now().time_since_epoch().count() - sent;
+        worker_count++;
+      },
+      NavMsgDelivery::Worker);
+  const int kLatencyCount = 1000;
+  for (int i = 0; i < kLatencyCount; i++) {
+    sent = Clock::now().time_since_epoch().count();
+    bus.Notify(msg);
+    while (worker_count <= i) std::this_thread::yield();
+  }
+  double latency_us = std::chrono::duration<double, std::micro>(
+                          Clock::duration(latency_ns / kLatencyCount))
+                          .count();
+
+  std::cout << "msgs/s, observable: " << observable.rate
+            << ", resolved id: " << resolved.rate
+            << ", direct: " << direct_rate << ", worker latency "
+            << latency_us << " us\n";
+  RecordProperty("observable_msgs_per_s", std::to_string(observable.rate));
+  RecordProperty("resolved_msgs_per_s", std::to_string(resolved.rate));
+  RecordProperty("direct_msgs_per_s", std::to_string(direct_rate));
+  RecordProperty("worker_latency_us", std::to_string(latency_us));
+}
+
+TEST(LLRegion, Clip) {
+  RegionOps ops;
+  auto start = Clock::now();
+  ops.Run(true);
+  double tess_ms = ElapsedMs(start);
+  start = Clock::now();
+  ops.Run(false);
+  double clip_ms = ElapsedMs(start);
+  std::cout << ops.rings.size() << " regions x 6 ops, tessellator: "
+            << tess_ms << " ms, scanline: " << clip_ms << " ms\n";
+  RecordProperty("tessellator_ms", std::to_string(tess_ms));
+  RecordProperty("scanline_ms", std::to_string(clip_ms));
+}
+
+TEST(AisListModel, Refresh) {
+  const int kTargets = 5000;
+  const int kRounds = 100;
+  std::srand(4711);
+  auto random_key = []() {
+    AisListKey key;
+    key.rank = std::rand() % 100 == 0 ? 0 : 1;
+    key.numeric = true;
+    key.num = std::rand() % 360;
+    key.range = (std::rand() % 10000) / 100.0;
+    return key;
+  };
+  AisListModel model;
+  std::map<int, AisListKey> keys;
+  auto sync = [&]() {
+    model.BeginSync();
+    for (const auto& kv : keys) model.Update(kv.first, kv.second, kv.first);
+    model.EndSync();
+  };
+  for (int i = 0; i < kTargets; i++) keys[200000000 + i] = random_key();
+  sync();
+
+  // Typical refresh: 1% of the keys changed
+  double elapsed_ms = 0;
+  for (int round = 0; round < kRounds; round++) {
+    for (int i = 0; i < kTargets / 100; i++) {
+      auto it = keys.begin();
+      std::advance(it, std::rand() % keys.size());
+      it->second = random_key();
+    }
+    auto start = Clock::now();
+    sync();
+    elapsed_ms += ElapsedMs(start);
+  }
+  double sync_ms = elapsed_ms / kRounds;
+  std::cout << kTargets << " targets, 1% changed: " << sync_ms
+            << " ms per refresh\n";
+  RecordProperty("sync_ms", std::to_string(sync_ms));
+}
+
+/** Synthetic 10,000 target scene: hull, predictor and predictor circle. */
+TEST(AisSymbolBatch, Scene) {
+  const AisBatchColor green = {0, 255, 0, 255};
+  const AisBatchColor black = {0, 0, 0, 255};
+  const int kTargets = 10000;
+  const int kFrames = 20;
+  AisSymbolBatch batch;
+  std::vector<float> quad = {-8, -6, 0, 24, 8, -6, 0, -6};
+  int ship = batch.AddTemplate(quad, AisSymbolBatch::FanTriangles(4, 3));
+  int circle = batch.AddTemplate(AisSymbolBatch::CircleOutline(16),
+                                 AisSymbolBatch::FanTriangles(16));
+  auto start = Clock::now();
+  for (int frame = 0; frame < kFrames; frame++) {
+    batch.Clear();
+    for (int i = 0; i < kTargets; i++) {
+      float tx = i % 100 * 10.f, ty = i / 100 * 10.f;
+      float a = i * 0.01f + frame;
+      AisSymbolInstance hull(tx, ty, 1, sinf(a), cosf(a));
+      batch.AddLine(tx, ty, tx + 30 * cosf(a), ty + 30 * sinf(a), 3, green);
+      batch.AddSymbol(circle, AisSymbolInstance(tx + 30 * cosf(a),
+                                                ty + 30 * sinf(a), 5),
+                      green, black, 1);
+      batch.AddSymbol(ship, hull, green, black, 2);
+    }
+  }
+  double build_ms = ElapsedMs(start) / kFrames;
+  std::cout << kTargets << " targets, " << batch.Size()
+            << " vertices: " << build_ms << " ms per frame\n";
+  RecordProperty("build_ms", std::to_string(build_ms));
+}
+
+TEST(LODReduce, RandomWalk) {
+  const int n = 2000000;
+  std::vector<double> xy = RandomWalk(n, 2, 42);
+  auto start = Clock::now();
+  std::vector<bool> expected(n);
+  ReferenceReduce(xy.data(), 0, n - 1, 20, expected, 2);
+  double recursive_ms = ElapsedMs(start);
+  start = Clock::now();
+  std::vector<bool> keep;
+  LODReduce(xy.data(), 0, n - 1, 20, keep);
+  double lod_ms = ElapsedMs(start);
+  EXPECT_EQ(keep, expected);
+  std::cout << n << " points, " << std::count(keep.begin(), keep.end(), true)
+            << " kept, recursive: " << recursive_ms
+            << " ms, LODReduce: " << lod_ms << " ms\n";
+  RecordProperty("recursive_ms", std::to_string(recursive_ms));
+  RecordProperty("lod_reduce_ms", std::to_string(lod_ms));
+}
+
+#ifdef __linux__
+TEST(FastMessage, Candump) {
+  auto frames = ReadCandump(std::string(TESTDATA) +
+                            "/candump-2022-07-30_102821-head.log");
+  ASSERT_FALSE(frames.empty());
+  FastMessageMap fast_messages;
+  int messages = Reassemble(fast_messages, frames);
+
+  const int kRuns = 200;
+  auto start = Clock::now();
+  for (int i = 0; i < kRuns; i++) {
+    DropTransfers(fast_messages);
+    EXPECT_EQ(Reassemble(fast_messages, frames), messages);
+  }
+  double frames_per_s = kRuns * frames.size() / ElapsedMs(start) * 1000;
+  std::cout << "frames/s, fast message reassembly: " << frames_per_s << "\n";
+  RecordProperty("frames_per_s", std::to_string(frames_per_s));
+}
+#endif
+
+#ifdef HAVE_TEXCMP
+/**
+ * The encoder against squish in both modes, the fast mode against its
+ * range fit and the quality mode, used to build the texture cache, against
+ * its cluster fit. Both are only 1.0 to 1.7 times faster, so the numbers
+ * are recorded and the checks only catch a clearly slower encoder, not
+ * wall clock noise.
+ */
+TEST(Dxt1, Throughput) {
+  const int dim = 512;
+  const int blocks = dim * dim / 16;
+  auto rgb = ChartTexture(dim, 11);
+  std::mt19937 rng(13);
+  // the lower half like a scanned chart, every block different
+  for (size_t i = rgb.size() / 2; i < rgb.size(); i++)
+    rgb[i] = std::min(255, rgb[i] + (int)(rng() % 24));
+
+  // best of a few runs, the others are disturbed by something else
+  auto blocks_per_s = [&](const std::function<void()>& encode) {
+    double best_ms = 0;
+    for (int n = 0; n < 10; n++) {
+      auto start = Clock::now();
+      encode();
+      double ms = ElapsedMs(start);
+      if (n == 0 || ms < best_ms) best_ms = ms;
+    }
+    return (long)(blocks / best_ms * 1000);
+  };
+  Dxt1_ResolveRoutines();
+  long range = blocks_per_s(
+      [&] { SquishDxt1(rgb, dim, squish::kColourRangeFit); });
+  long cluster = blocks_per_s(
+      [&] { SquishDxt1(rgb, dim, squish::kColourClusterFit); });
+  long fast = blocks_per_s([&] { Dxt1(rgb, dim, DXT1_FAST); });
+  long quality = blocks_per_s([&] { Dxt1(rgb, dim, DXT1_QUALITY); });
+  std::cout << "blocks/s, squish range: " << range << ", cluster: " << cluster
+            << ", dxt1 fast: " << fast << ", quality: " << quality << "\n";
+  RecordProperty("squish_range_blocks_per_s", std::to_string(range));
+  RecordProperty("squish_cluster_blocks_per_s", std::to_string(cluster));
+  RecordProperty("dxt1_fast_blocks_per_s", std::to_string(fast));
+  RecordProperty("dxt1_quality_blocks_per_s", std::to_string(quality));
+  EXPECT_GT(fast, range * 0.8);
+  EXPECT_GT(quality, cluster * 0.8);
+}
+#endif
@@ -1,9 +1,15 @@
 #include "config.h"
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <fstream>
+#include <iostream>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 #if (defined(OCPN_GHC_FILESYSTEM) || (defined(__clang_major__) && (__clang_major__ < 15)))
 #include <ghc/filesystem.hpp>
@@ -20,6 +26,7 @@ namespace fs = std::filesystem;
 
 #include "model/base_platform.h"
 #include "model/comm_drv_registry.h"
+#include "model/comm_navmsg_bus.h"
 #include "model/comm_out_queue.h"
 #include "model/logger.h"
 #include "model/ocpn_utils.h"
@@ -52,6 +59,35 @@ class OverrunEvent : public wxAppConsole {
   };
 };
 
+class NavMsgBusEvent : public wxAppConsole {
+public:
+  NavMsgBusEvent() {
+    int count = 0;
+    auto& bus = NavMsgBus::GetInstance();
+    NavMsgId id = bus.GetMsgId(Nmea0183Msg::MessageKey("EVT"));
+    wxEvtHandler handler;
+    handler.Bind(obsNOTIFY, [&](ObservedEvt& ev) {
+      auto msg = std::static_pointer_cast<const Nmea0183Msg>(ev.GetSharedPtr());
+      EXPECT_EQ(msg->type, "EVT");
+      count++;
+    });
+    int handle = bus.Subscribe(id, &handler, obsNOTIFY);
+    int observed = 0;
+    ObsListener listener(Nmea0183Msg("GPEVT"),
+                         [&](ObservedEvt&) { observed++; });
+    NavMsgIdCache cache;
+    for (int i = 0; i < 3; i++) {
+      auto msg = std::make_shared<Nmea0183Msg>("GPEVT");
+      if (i > 0) cache.Resolve(*msg);
+      bus.Notify(msg);
+    }
+    EXPECT_TRUE(HasPendingEvents());
+    ProcessPendingEvents();
+    EXPECT_EQ(count, 3);
+    EXPECT_EQ(observed, 3);
+    bus.Unsubscribe(handle);
+  }
+};
 
 TEST(Buffer, Single) {
   CommOutQueueSingle queue;
@@ -145,3 +181,201 @@ TEST(Buffer, RateAndSizeLimit) {
 TEST(Buffer, OverrunEvent) {
   OverrunEvent event;
 }
+
+TEST(Buffer, LockFreeFifo) {
+  LockFreeCommOutQueue queue(3, 16);
+  for (int i = 0; i < 10; i++) {
+    std::string line(GPGGA);
+    ocpn::replace(line, "00", std::to_string(i));
+    queue.push_back(line);
+  }
+  queue.push_back(GPGGL);
+  queue.push_back("!AIVDM,2,1");
+  queue.push_back("!AIVDM,2,2");
+  queue.push_back("$ECWPL,1");  // same type sent twice on purpose
+  queue.push_back("$ECWPL,1");
+  queue.push_back("!AIVDM,1,1");
+  EXPECT_EQ(queue.size(), 9);
+  EXPECT_FALSE(queue.push_back("$GPRMC 00"));  // fifo full
+  EXPECT_FALSE(queue.push_back("foo"));
+
+  std::vector<std::string> lines;
+  std::string line;
+  while (queue.try_pop(line)) lines.push_back(line);
+  std::vector<std::string> expected = {
+      "$GPGGA 7",   "$GPGGA 8", "$GPGGA 9", GPGGL,       "!AIVDM,2,1",
+      "!AIVDM,2,2", "$ECWPL,1", "$ECWPL,1", "!AIVDM,1,1"};
+  EXPECT_EQ(lines, expected);
+  EXPECT_EQ(queue.size(), 0);
+  EXPECT_THROW({ queue.pop(); }, std::underflow_error);
+
+  PerfCounter perf = queue.GetPerf();
+  EXPECT_EQ(perf.msgs_in, 17);
+  EXPECT_EQ(perf.msgs_out, 9);
+  EXPECT_EQ(perf.overflow_msgs, 8);
+  auto type_perf = queue.GetTypePerf();
+  EXPECT_EQ(type_perf.size(), 4);
+  for (const auto& kv : type_perf) EXPECT_EQ(kv.second.in_queue, 0);
+}
+
+/**
+ * Producers push messages of kTypes types each while a writer thread
+ * drains the queue. Messages of a type come out in order and the last one
+ * of each type gets through.
+ */
+TEST(Buffer, LockFreeProducers) {
+  const int kProducers = 4;
+  const int kTypes = 8;
+  const int kCount = 2000;
+  LockFreeCommOutQueue queue(3, 1024);
+  std::atomic<bool> done(false);
+  std::unordered_map<std::string, int> last;
+  std::thread writer([&] {
+    std::string line;
+    while (true) {
+      bool was_done = done.load();
+      while (queue.try_pop(line)) {
+        int i = std::stoi(line.substr(7));
+        auto it = last.find(line.substr(0, 6));
+        if (it != last.end()) EXPECT_GT(i, it->second);
+        last[line.substr(0, 6)] = i;
+      }
+      if (was_done) break;
+      std::this_thread::yield();
+    }
+  });
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < kCount; i++) {
+        std::string line = "$" + std::string(1, 'A' + p) + "X" +
+                           std::string(1, 'A' + i % kTypes) + "XX," +
+                           std::to_string(i);
+        while (!queue.push_back(line)) std::this_thread::yield();
+      }
+    });
+  }
+  for (auto& producer : producers) producer.join();
+  done = true;
+  writer.join();
+  EXPECT_EQ(last.size(), kProducers * kTypes);
+  for (const auto& kv : last) EXPECT_GE(kv.second, kCount - kTypes);
+  EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(NavMsgBus, MsgId) {
+  auto& bus = NavMsgBus::GetInstance();
+  NavMsgId gga = bus.GetMsgId(Nmea0183Msg::MessageKey("GGA"));
+  NavMsgId rmc = bus.GetMsgId(Nmea0183Msg::MessageKey("RMC"));
+  EXPECT_NE(gga, rmc);
+  EXPECT_EQ(gga, bus.GetMsgId(Nmea0183Msg("GPGGA")));
+}
+
+TEST(NavMsgBus, ResolvedId) {
+  auto& bus = NavMsgBus::GetInstance();
+  NavMsgIdCache cache;
+  auto n2k = std::make_shared<Nmea2000Msg>(129029);
+  EXPECT_EQ(n2k->msg_id, kNoNavMsgId);
+  cache.Resolve(*n2k);
+  EXPECT_EQ(n2k->msg_id, bus.GetMsgId(*n2k));
+  auto n0183 = std::make_shared<Nmea0183Msg>("GPRES");
+  cache.Resolve(*n0183);
+  EXPECT_EQ(n0183->msg_id, bus.GetMsgId(*n0183));
+  EXPECT_NE(n0183->msg_id, n2k->msg_id);
+  auto all = std::make_shared<Nmea0183Msg>(*n0183, "ALL");
+  EXPECT_EQ(all->msg_id, kNoNavMsgId);
+  cache.Resolve(*all);
+  EXPECT_EQ(all->msg_id, bus.GetMsgId(Nmea0183Msg::MessageKey()));
+
+  int count = 0;
+  NavMsgSubscription subscription(
+      n2k->msg_id, [&](std::shared_ptr<const NavMsg>) { count++; },
+      NavMsgDelivery::Direct);
+  bus.Notify(n2k);
+  bus.Notify(std::make_shared<const Nmea2000Msg>(129029));
+  EXPECT_EQ(count, 2);
+}
+
+TEST(NavMsgBus, Direct) {
+  auto& bus = NavMsgBus::GetInstance();
+  int count = 0;
+  NavMsgId id = bus.GetMsgId(Nmea0183Msg::MessageKey("DIR"));
+  {
+    NavMsgSubscription subscription(
+        id, [&](std::shared_ptr<const NavMsg>) { count++; },
+        NavMsgDelivery::Direct);
+    bus.Notify(std::make_shared<const Nmea0183Msg>("GPDIR"));
+    bus.Notify(std::make_shared<const Nmea0183Msg>("GPXXX"));
+    EXPECT_EQ(count, 1);
+  }
+  bus.Notify(std::make_shared<const Nmea0183Msg>("GPDIR"));
+  EXPECT_EQ(count, 1);
+}
+
+TEST(NavMsgBus, Worker) {
+  auto& bus = NavMsgBus::GetInstance();
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::string> received;
+  NavMsgId id = bus.GetMsgId(Nmea0183Msg::MessageKey("WRK"));
+  NavMsgSubscription subscription(
+      id,
+      [&](std::shared_ptr<const NavMsg> msg) {
+        auto n0183 = std::static_pointer_cast<const Nmea0183Msg>(msg);
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(n0183->payload);
+        cv.notify_one();
+      },
+      NavMsgDelivery::Worker);
+  auto src = std::make_shared<const NavAddr>();
+  for (int i = 0; i < 10; i++)
+    bus.Notify(std::make_shared<const Nmea0183Msg>("GPWRK",
+                                                   std::to_string(i), src));
+  std::unique_lock<std::mutex> lock(mutex);
+  EXPECT_TRUE(cv.wait_for(lock, 5s, [&] { return received.size() == 10; }));
+  for (int i = 0; i < (int)received.size(); i++)
+    EXPECT_EQ(received[i], std::to_string(i));
+}
+
+TEST(NavMsgBus, WorkerProducers) {
+  const int kProducers = 4;
+  const int kCount = 2000;
+  auto& bus = NavMsgBus::GetInstance();
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<int> last(kProducers, -1);
+  int received = 0;
+  bool in_order = true;
+  NavMsgId id = bus.GetMsgId(Nmea0183Msg::MessageKey("WMP"));
+  NavMsgSubscription subscription(
+      id,
+      [&](std::shared_ptr<const NavMsg> msg) {
+        auto n0183 = std::static_pointer_cast<const Nmea0183Msg>(msg);
+        int producer = n0183->talker[1] - '0';
+        int i = std::stoi(n0183->payload);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (i != last[producer] + 1) in_order = false;
+        last[producer] = i;
+        if (++received == kProducers * kCount) cv.notify_one();
+      },
+      NavMsgDelivery::Worker);
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&bus, p] {
+      auto src = std::make_shared<const NavAddr>();
+      std::string id = "P" + std::to_string(p) + "WMP";
+      for (int i = 0; i < kCount; i++)
+        bus.Notify(
+            std::make_shared<const Nmea0183Msg>(id, std::to_string(i), src));
+    });
+  }
+  for (auto& producer : producers) producer.join();
+  std::unique_lock<std::mutex> lock(mutex);
+  EXPECT_TRUE(cv.wait_for(lock, 5s,
+                          [&] { return received == kProducers * kCount; }));
+  EXPECT_TRUE(in_order);
+}
+
+TEST(NavMsgBus, WxEvent) {
+  NavMsgBusEvent event;
+}
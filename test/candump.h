@@ -0,0 +1,65 @@
+/*
+ * NMEA 2000 workload shared by the unit tests and the benchmarks: frames
+ * of a candump log and the fast message reassembly done by the drivers.
+ * Linux only, can_frame comes from the socketcan headers.
+ */
+
+#ifndef CANDUMP_H__
+#define CANDUMP_H__
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "model/comm_can_util.h"
+
+/** Parse the frames of a candump log, lines like "(ts) can0 ID#DATA". */
+inline std::vector<can_frame> ReadCandump(const std::string& path) {
+  std::vector<can_frame> frames;
+  std::ifstream stream(path);
+  for (std::string line; std::getline(stream, line);) {
+    size_t hash = line.find('#');
+    size_t space = line.rfind(' ', hash);
+    if (hash == std::string::npos || space == std::string::npos) continue;
+    can_frame frame = {};
+    frame.can_id = std::stoul(line.substr(space + 1, hash - space - 1),
+                              nullptr, 16);
+    std::string data = line.substr(hash + 1);
+    frame.can_dlc = std::min<size_t>(data.size() / 2, CAN_MAX_DLEN);
+    for (int i = 0; i < frame.can_dlc; i++)
+      frame.data[i] = std::stoul(data.substr(2 * i, 2), nullptr, 16);
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+/** Reassemble frames as the drivers do, return number of messages. */
+inline int Reassemble(FastMessageMap& fast_messages,
+                      const std::vector<can_frame>& frames) {
+  int messages = 0;
+  for (const can_frame& frame : frames) {
+    CanHeader header(frame);
+    bool ready = true;
+    if (header.IsFastMessage()) {
+      int position = fast_messages.FindMatchingEntry(header, frame.data[0]);
+      if (position < 0) {
+        position = fast_messages.AddNewEntry();
+        ready = fast_messages.InsertEntry(header, frame.data, position);
+      } else {
+        ready = fast_messages.AppendEntry(header, frame.data, position);
+      }
+      if (ready) fast_messages.Remove(position);
+    }
+    if (ready) messages++;
+  }
+  return messages;
+}
+
+/** Drop transfers left over at the end of the log. */
+inline void DropTransfers(FastMessageMap& fast_messages) {
+  for (size_t i = 0; i < fast_messages.entries.size(); i++)
+    fast_messages.Remove(i);
+}
+
+#endif  // CANDUMP_H__
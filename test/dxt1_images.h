@@ -0,0 +1,61 @@
+/*
+ * Chart like test images and helpers to encode them with squish and with
+ * the dxt1 encoder, shared by the unit tests and the benchmarks.
+ */
+
+#ifndef DXT1_IMAGES_H__
+#define DXT1_IMAGES_H__
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "dxt1.h"
+#include "squish.h"
+
+/** Depth areas with a gradient, contours, soundings and symbols. */
+inline std::vector<unsigned char> ChartTexture(int dim, unsigned seed) {
+  static const unsigned char kColours[][3] = {
+      {212, 234, 238}, {150, 200, 230}, {245, 228, 170}, {120, 160, 90},
+      {30, 30, 30},    {200, 40, 120},  {255, 255, 255}};
+  std::mt19937 rng(seed);
+  std::vector<unsigned char> rgb(dim * dim * 3);
+  for (int y = 0; y < dim; y++) {
+    for (int x = 0; x < dim; x++) {
+      double d = sin(x * 0.02 + seed) + cos(y * 0.03);
+      d += 0.3 * sin((x + y) * 0.1);
+      unsigned char* p = &rgb[3 * (y * dim + x)];
+      const unsigned char* c = kColours[d < -0.5 ? 1 : d < 0.5 ? 0 : 2];
+      for (int k = 0; k < 3; k++) p[k] = std::min(255, c[k] + (x + y) / 32);
+      if (fabs(d + 0.5) < 0.04 || fabs(d - 0.5) < 0.04)
+        memcpy(p, kColours[4], 3);
+      if (x % 64 < 6 && y % 48 < 8 && (rng() & 3)) memcpy(p, kColours[4], 3);
+      if ((x / 8 + y / 8) % 37 == 0 && (rng() & 1)) memcpy(p, kColours[5], 3);
+      if (rng() % 200 == 0) memcpy(p, kColours[3 + rng() % 4], 3);
+    }
+  }
+  return rgb;
+}
+
+inline std::vector<unsigned char> SquishDxt1(
+    const std::vector<unsigned char>& rgb, int dim, int fit) {
+  std::vector<unsigned char> blocks(dim * dim / 2);
+  volatile bool abort = false;
+  squish::CompressImageRGBpow2_Flatten_Throttle_Abort(
+      rgb.data(), dim, dim, blocks.data(), squish::kDxt1 | fit, true, 0, 0,
+      abort);
+  return blocks;
+}
+
+inline std::vector<unsigned char> Dxt1(const std::vector<unsigned char>& rgb,
+                                       int dim, Dxt1Quality quality) {
+  std::vector<unsigned char> blocks(dim * dim / 2);
+  volatile bool abort = false;
+  Dxt1_CompressImageRGB(rgb.data(), dim, dim, blocks.data(), quality, true, 0,
+                        0, abort);
+  return blocks;
+}
+
+#endif  // DXT1_IMAGES_H__
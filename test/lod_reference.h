@@ -0,0 +1,53 @@
+/*
+ * Plain Douglas-Peucker and random walk test lines, shared by the unit
+ * tests and the benchmarks of LODReduce().
+ */
+
+#ifndef LOD_REFERENCE_H__
+#define LOD_REFERENCE_H__
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+/** Plain recursive Douglas-Peucker, the reference for LODReduce(). */
+inline void ReferenceReduce(const double* xy, int first, int last, double eps,
+                            std::vector<bool>& keep, int dim) {
+  keep[first] = keep[last] = true;
+  double u[3], len2 = 0;
+  for (int k = 0; k < dim; k++) {
+    u[k] = xy[last * dim + k] - xy[first * dim + k];
+    len2 += u[k] * u[k];
+  }
+  double inv = len2 > 0 ? 1 / len2 : 0;
+  int index = -1;
+  double best = eps * eps;
+  for (int i = first + 1; i < last; i++) {
+    double p[3], dot = 0, d2 = 0;
+    for (int k = 0; k < dim; k++) {
+      p[k] = xy[i * dim + k] - xy[first * dim + k];
+      dot += p[k] * u[k];
+    }
+    double t = std::min(std::max(dot * inv, 0.0), 1.0);
+    for (int k = 0; k < dim; k++) d2 += (p[k] - t * u[k]) * (p[k] - t * u[k]);
+    if (d2 > best) {
+      best = d2;
+      index = i;
+    }
+  }
+  if (index < 0) return;
+  ReferenceReduce(xy, first, index, eps, keep, dim);
+  ReferenceReduce(xy, index, last, eps, keep, dim);
+}
+
+/** Random walk of n points, on a coarse grid to get distance ties. */
+inline std::vector<double> RandomWalk(int n, int dim, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> step(-4, 4);
+  std::vector<double> xy(dim);
+  for (int i = 1; i < n; i++)
+    for (int k = 0; k < dim; k++) xy.push_back(xy[xy.size() - dim] + step(rng));
+  return xy;
+}
+
+#endif  // LOD_REFERENCE_H__
@@ -29,8 +29,12 @@
 #include "model/ais_decoder.h"
 #include "model/select.h"
 
+#include "model/comm_can_util.h"
+#include "model/comm_drv_n2k_net.h"
 #include "model/comm_drv_n2k_socketcan.h"
 
+#include "candump.h"
+
 #ifdef _MSC_VER
 const static std::string kSEP("\\");
 #else
@@ -286,6 +290,61 @@ TEST(DriverRegistry, RegisterDriver) {
   EXPECT_EQ(int2, 0);   // All drivers closed.
 }
 
+TEST(FastMessage, Candump) {
+  auto frames = ReadCandump(std::string(TESTDATA) + kSEP +
+                            "candump-2022-07-30_102821-head.log");
+  ASSERT_EQ(frames.size(), 500u);
+
+  FastMessageMap fast_messages;
+  int messages = Reassemble(fast_messages, frames);
+  RecordProperty("messages", std::to_string(messages));
+  EXPECT_GT(messages, 0);
+  EXPECT_LT(messages, (int)frames.size());
+  // Only transfers still in progress at the end of the log are left
+  EXPECT_LT(fast_messages.InUse(), 10u);
+
+  // The same log again gives the same messages, reusing the entries
+  for (int i = 0; i < 3; i++) {
+    DropTransfers(fast_messages);
+    EXPECT_EQ(Reassemble(fast_messages, frames), messages);
+  }
+  EXPECT_LT(fast_messages.entries.size(), 20u);
+}
+
+TEST(FastMessage, MissingFirstFrame) {
+  auto frames = ReadCandump(std::string(TESTDATA) + kSEP +
+                            "candump-2022-07-30_102821-head.log");
+  FastMessageMap fast_messages;
+  // A first frame is not a continuation of a missing first frame
+  for (const can_frame& frame : frames) {
+    CanHeader header(frame);
+    if (!header.IsFastMessage() || (frame.data[0] & 0x1F) == 0) continue;
+    EXPECT_EQ(fast_messages.FindMatchingEntry(header, frame.data[0]), -1);
+    int position = fast_messages.AddNewEntry();
+    EXPECT_FALSE(fast_messages.InsertEntry(header, frame.data, position));
+    EXPECT_EQ(fast_messages.InUse(), 0u);
+    break;
+  }
+}
+
+TEST(CircularBuffer, Wrap) {
+  circular_buffer ring(10);
+  EXPECT_EQ(ring.capacity(), 16u);
+  std::vector<unsigned char> in(12), out(16);
+  for (size_t i = 0; i < in.size(); i++) in[i] = i;
+
+  EXPECT_EQ(ring.put(&in[0], in.size()), 12u);
+  EXPECT_EQ(ring.get(&out[0], 8), 8u);
+  EXPECT_EQ(ring.put(&in[0], in.size()), 12u);  // wraps around
+  EXPECT_TRUE(ring.full());
+  EXPECT_EQ(ring.put(&in[0], 1), 0u);  // dropped
+  EXPECT_EQ(ring.get(&out[0], 16), 16u);
+  for (int i = 0; i < 4; i++) EXPECT_EQ(out[i], i + 8);
+  for (int i = 0; i < 12; i++) EXPECT_EQ(out[i + 4], i);
+  EXPECT_TRUE(ring.empty());
+  EXPECT_EQ(ring.get(), 0);
+}
+
 #ifdef ENABLE_VCAN_TESTS
 TEST(CanEnvironment, vcan0) {
   char line[256];
@@ -0,0 +1,135 @@
+/*
+ * Clipping workload shared by the unit tests and the benchmarks: coastline
+ * rings of the crude basemap and region operations on them.
+ */
+
+#ifndef REGION_OPS_H__
+#define REGION_OPS_H__
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "LLRegion.h"
+
+/** Rings of the polygons in a shapefile as lat, lon pairs. */
+inline std::vector<std::vector<double>> ReadShpRings(const std::string& path) {
+  std::ifstream stream(path, std::ios::binary);
+  std::vector<unsigned char> data((std::istreambuf_iterator<char>(stream)),
+                                  std::istreambuf_iterator<char>());
+  auto be32 = [&](size_t off) {
+    return (data[off] << 24) | (data[off + 1] << 16) | (data[off + 2] << 8) |
+           data[off + 3];
+  };
+  auto le32 = [&](size_t off) {
+    return data[off] | (data[off + 1] << 8) | (data[off + 2] << 16) |
+           (data[off + 3] << 24);
+  };
+  auto le64 = [&](size_t off) {
+    uint64_t bits = 0;
+    for (int i = 7; i >= 0; i--) bits = (bits << 8) | data[off + i];
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+  };
+
+  std::vector<std::vector<double>> rings;
+  size_t off = 100;  // file header
+  while (off + 8 <= data.size()) {
+    size_t rec = off + 8;
+    off = rec + 2 * be32(off + 4);
+    if (off > data.size() || le32(rec) != 5) continue;  // not a polygon
+    int nparts = le32(rec + 36), npoints = le32(rec + 40);
+    size_t parts = rec + 44, points = parts + 4 * nparts;
+    for (int i = 0; i < nparts; i++) {
+      int first = le32(parts + 4 * i);
+      int last = i + 1 < nparts ? le32(parts + 4 * (i + 1)) : npoints;
+      std::vector<double> ring;
+      for (int j = first; j < last - 1; j++) {  // last point closes the ring
+        ring.push_back(le64(points + 16 * j + 8));
+        ring.push_back(le64(points + 16 * j));
+      }
+      if (ring.size() >= 8) rings.push_back(ring);
+    }
+  }
+  return rings;
+}
+
+inline double RegionArea(const LLRegion& region) {
+  double area = 0;
+  for (const auto& contour : region.contours) {
+    const contour_pt* l = &contour.back();
+    for (const auto& p : contour) {
+      area += (l->x * p.y - p.x * l->y) / 2;
+      l = &p;
+    }
+  }
+  return area;
+}
+
+/**
+ * Real coastline polygons from the 10x10 degree cells of the basemap
+ * together with boxes straddling them and shifted copies, much like
+ * chart coverage in the quilt.
+ */
+class RegionOps {
+public:
+  RegionOps() {
+    std::string path = std::string(TESTDATA) +
+                       "/../../data/basemap_shp/basemap_crude_10x10.shp";
+    for (const auto& ring : ReadShpRings(path)) {
+      LLRegion region(ring.size() / 2, ring.data());
+      if (region.Empty()) continue;
+      LLBBox box = region.GetBox();
+      double dlat = box.GetLatRange(), dlon = box.GetLonRange();
+      boxes.emplace_back(box.GetMinLat() + dlat / 3, box.GetMinLon() + dlon / 3,
+                         box.GetMaxLat(), box.GetMaxLon());
+      std::vector<double> shifted(ring);
+      double lat_shift = (box.GetMinLat() > 0 ? -0.3 : 0.3) * dlat;
+      double lon_shift = (box.GetMinLon() > 0 ? -0.2 : 0.2) * dlon;
+      for (size_t i = 0; i < shifted.size(); i += 2) {
+        shifted[i] += lat_shift;
+        shifted[i + 1] += lon_shift;
+      }
+      moved.emplace_back(shifted.size() / 2, shifted.data());
+      rings.push_back(region);
+    }
+  }
+
+  /** Run all operations, return the resulting areas. */
+  std::vector<double> Run(bool tessellator) const {
+    LLRegion::SetUseTessellator(tessellator);
+    std::vector<double> areas;
+    for (size_t i = 0; i < rings.size(); i++) {
+      LLRegion r = rings[i];
+      r.Intersect(boxes[i]);
+      areas.push_back(RegionArea(r));
+      r = rings[i];
+      r.Subtract(boxes[i]);
+      areas.push_back(RegionArea(r));
+      r = rings[i];
+      r.Intersect(moved[i]);
+      areas.push_back(RegionArea(r));
+      r = rings[i];
+      r.Union(moved[i]);
+      areas.push_back(RegionArea(r));
+      r = rings[i];
+      r.Subtract(moved[i]);
+      areas.push_back(RegionArea(r));
+      r = rings[i];
+      r.Union(rings[(i + 1) % rings.size()]);
+      areas.push_back(RegionArea(r));
+    }
+    LLRegion::SetUseTessellator(false);
+    return areas;
+  }
+
+  std::vector<LLRegion> rings;
+  std::vector<LLRegion> boxes;
+  std::vector<LLRegion> moved;
+};
+
+#endif  // REGION_OPS_H__
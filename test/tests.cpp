@@ -1,48 +1,80 @@
 #include "config.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <random>
 #include <thread>
 
 
 #include <wx/app.h>
+#include <wx/dir.h>
 #include <wx/event.h>
 #include <wx/evtloop.h>
 #include <wx/fileconf.h>
+#include <wx/filename.h>
 #include <wx/jsonval.h>
 #include <wx/timer.h>
 
 #include <gtest/gtest.h>
 
+#include "LLRegion.h"
+#include "LOD_reduce.h"
 #include "model/ais_decoder.h"
+#include "model/ais_list_model.h"
 #include "model/ais_defs.h"
 #include "model/ais_state_vars.h"
+#include "model/ais_symbol_batch.h"
+#include "model/chart_scan.h"
 #include "model/cli_platform.h"
 #include "model/comm_ais.h"
 #include "model/comm_appmsg_bus.h"
 #include "model/comm_bridge.h"
+#include "model/comm_drv_capture.h"
 #include "model/comm_drv_file.h"
 #include "model/comm_drv_registry.h"
 #include "model/comm_navmsg_bus.h"
 #include "model/config_vars.h"
+#include "model/georef.h"
+#include "model/georef_batch.h"
 #include "model/ipc_api.h"
 #include "model/logger.h"
 #include "model/multiplexer.h"
 #include "model/navutil_base.h"
+#include "model/nmea_log_pipeline.h"
 #include "model/ocpn_types.h"
 #include "model/ocpn_utils.h"
 #include "model/own_ship.h"
+#include "model/perf_trace.h"
+#include "model/plugin_lib_cache.h"
+#include "model/render_stats.h"
 #include "model/routeman.h"
 #include "model/select.h"
 #include "model/std_instance_chk.h"
+#include "model/tex_cache_file.h"
+#include "model/track.h"
+#include "model/track_geometry.h"
 #include "model/wait_continue.h"
 #include "model/wx_instance_chk.h"
+#include "model/xyz_tiles.h"
 #include "observable_confvar.h"
 #include "ocpn_plugin.h"
+#include "lod_reference.h"
+#include "region_ops.h"
+
+#ifdef HAVE_TEXCMP
+#include "dxt1.h"
+#include "dxt1_images.h"
+#include "squish.h"
+#endif
 
 // Macos up to 10.13
 #if (defined(OCPN_GHC_FILESYSTEM) || (defined(__clang_major__) && (__clang_major__ < 15)))
@@ -878,6 +910,929 @@ TEST(FileDriver, input) {
 }
 #endif
 
+class CaptureListener : public DriverListener {
+public:
+  void Notify(std::shared_ptr<const NavMsg> message) {
+    messages.push_back(message);
+  }
+  void Notify(const AbstractCommDriver& driver) {}
+
+  std::vector<std::shared_ptr<const NavMsg>> messages;
+};
+
+TEST(CaptureDriver, replay) {
+  wxLog::SetActiveTarget(&defaultLog);
+  remove("test-capture.bin");
+  {
+    auto capture = std::make_shared<CaptureCommDriver>("test-capture.bin");
+    capture->Activate();
+    auto& msgbus = NavMsgBus::GetInstance();
+    auto src = std::make_shared<const NavAddr>(NavAddr0183("/dev/ttyUSB0"));
+    auto rmc = std::make_shared<const Nmea0183Msg>(
+        "GPRMC", "$GPRMC,083559.00,A,4717.11437,N*57", src);
+    msgbus.Notify(rmc);
+    msgbus.Notify(std::make_shared<const Nmea0183Msg>(*rmc, "ALL"));
+    std::string s("payload data");
+    auto payload = std::vector<unsigned char>(s.begin(), s.end());
+    msgbus.Notify(std::make_shared<const Nmea2000Msg>(
+        129029, payload, std::make_shared<const NavAddr>(
+                              NavAddr::Bus::N2000, "can0")));
+    EXPECT_EQ(capture->GetCount(), 3);
+    CommDriverRegistry::GetInstance().Deactivate(capture);
+  }
+  CaptureListener listener;
+  ReplayCommDriver replay("test-capture.bin", listener, 0);
+  EXPECT_TRUE(replay.Run());
+  ASSERT_EQ(listener.messages.size(), 3);
+  auto rmc = std::dynamic_pointer_cast<const Nmea0183Msg>(
+      listener.messages[0]);
+  ASSERT_TRUE(rmc);
+  EXPECT_EQ(rmc->talker, "GP");
+  EXPECT_EQ(rmc->type, "RMC");
+  EXPECT_EQ(rmc->payload, "$GPRMC,083559.00,A,4717.11437,N*57");
+  EXPECT_EQ(rmc->source->iface, "/dev/ttyUSB0");
+  EXPECT_EQ(listener.messages[1]->key(), "n0183-ALL");
+  auto n2k = std::dynamic_pointer_cast<const Nmea2000Msg>(
+      listener.messages[2]);
+  ASSERT_TRUE(n2k);
+  EXPECT_EQ(n2k->PGN.pgn, 129029);
+  EXPECT_EQ(n2k->source->iface, "can0");
+  EXPECT_EQ(replay.GetStats().messages, 3);
+  EXPECT_EQ(replay.GetStats().notify_ns.size(), 3);
+}
+
+TEST(NmeaLog, Format) {
+  NmeaLogEntry input(NmeaLogEntry::Direction::Input, "<GREEN>", "/dev/ttyS0",
+                     "$GPRMC,1\r\n", true);
+  std::string line = input.Format();
+  EXPECT_EQ(line.substr(0, 7), "<GREEN>");
+  EXPECT_NE(line.find("(/dev/ttyS0) $GPRMC,1<0x0D><0x0A>"), std::string::npos);
+  NmeaLogEntry error(NmeaLogEntry::Direction::Input, "<GREEN>", "/dev/ttyS0",
+                     std::string("$GP\x01"), true);
+  EXPECT_EQ(error.Format().substr(0, 5), "<RED>");
+  NmeaLogEntry output(NmeaLogEntry::Direction::Output, "<BLUE>", "can0",
+                      "$GPRMC");
+  EXPECT_EQ(output.Format().substr(0, 10), "<BLUE>--> ");
+}
+
+TEST(NmeaLog, Pipeline) {
+  NmeaLogPipeline pipeline(64);
+  std::atomic<int> ready(0);
+  // Only Flush() drives the worker within the test
+  pipeline.Start(35, std::chrono::seconds(60), [&] { ready++; });
+  for (int i = 0; i < 1000; i++)
+    pipeline.Push(NmeaLogEntry(NmeaLogEntry::Direction::Input, "<GREEN>", "s",
+                               "msg" + std::to_string(i)));
+  pipeline.Flush();
+  pipeline.Flush();
+  EXPECT_EQ(ready.load(), 1);  // Coalesced while not taken
+  NmeaLogBatch batch = pipeline.TakeBatch();
+  EXPECT_LE(batch.lines.size(), 35);
+  EXPECT_EQ(batch.lines.size() + batch.dropped, 1000);
+
+  pipeline.SetFilter("msg5");
+  for (int i = 0; i < 20; i++)
+    pipeline.Push(NmeaLogEntry(NmeaLogEntry::Direction::Input, "<GREEN>", "s",
+                               "msg" + std::to_string(i)));
+  pipeline.Flush();
+  EXPECT_EQ(ready.load(), 2);
+  batch = pipeline.TakeBatch();
+  ASSERT_EQ(batch.lines.size(), 1);
+  EXPECT_EQ(batch.dropped, 0);
+  pipeline.Stop();
+  pipeline.Flush();  // Returns at once when stopped
+}
+
+TEST(PluginLibCache, Persistence) {
+  {
+    std::ofstream f("test_pi.so");
+    f << "0123456789";
+  }
+  remove("test-plugin-libs.dat");
+  PluginLibInfo info;
+  ASSERT_TRUE(PluginLibCache::Stat("test_pi.so", info));
+  EXPECT_EQ(info.size, 10);
+  {
+    PluginLibCache cache("test-plugin-libs.dat", "5.9.0");
+    cache.Load();
+    PluginLibInfo probe = info;
+    EXPECT_FALSE(cache.Lookup("test_pi.so", probe));
+    info.compatible = true;
+    info.loadable = true;
+    info.common_name = "Test plugin";
+    info.api_version = 118;
+    cache.Update(info);
+    EXPECT_TRUE(cache.Save());
+  }
+  PluginLibCache cache("test-plugin-libs.dat", "5.9.0");
+  cache.Load();
+  PluginLibInfo probe;
+  ASSERT_TRUE(PluginLibCache::Stat("test_pi.so", probe));
+  ASSERT_TRUE(cache.Lookup("test_pi.so", probe));
+  EXPECT_TRUE(probe.loadable);
+  EXPECT_EQ(probe.common_name, "Test plugin");
+  EXPECT_EQ(probe.api_version, 118);
+  probe.size = 11;  // Modified library
+  EXPECT_FALSE(cache.Lookup("test_pi.so", probe));
+
+  PluginLibCache other_version("test-plugin-libs.dat", "5.10.0");
+  other_version.Load();
+  ASSERT_TRUE(PluginLibCache::Stat("test_pi.so", probe));
+  EXPECT_FALSE(other_version.Lookup("test_pi.so", probe));
+}
+
+TEST(ChartScan, ListAndManifest) {
+  fs::remove_all("chart-scan");
+  for (int i = 0; i < 8; i++) {
+    auto dir = fs::path("chart-scan") / ("d" + std::to_string(i));
+    fs::create_directories(dir / "sub");
+    std::ofstream(dir / "sub" / ("c" + std::to_string(i) + ".kap"))
+        << std::string(i * 10, 'x');
+    std::ofstream(dir / ".hidden") << "h";
+  }
+  wxArrayString expected;
+  wxDir::GetAllFiles("chart-scan", &expected);
+  expected.Sort();
+  auto files = ListChartDirFiles("chart-scan");
+  ASSERT_EQ(files.size(), expected.size());
+  for (size_t i = 0; i < files.size(); i++) {
+    EXPECT_EQ(files[i].path, expected[i]);
+    EXPECT_EQ(files[i].size, wxFileName::GetSize(expected[i]).GetValue());
+    EXPECT_EQ(files[i].mtime, wxFileModificationTime(expected[i]));
+  }
+
+  ChartScanManifest manifest;
+  EXPECT_EQ(manifest.Find(files[0], "ChartKAP"), ChartScanManifest::kUnknown);
+  manifest.Set(files[0], "ChartKAP", false);
+  manifest.Set(files[1], "ChartKAP", true);
+  manifest.Set(files[2], "ChartKAP", false);
+  EXPECT_EQ(manifest.Find(files[0], "ChartKAP"), ChartScanManifest::kNotChart);
+  ChartScanFile changed = files[1];
+  changed.size++;
+  EXPECT_EQ(manifest.Find(changed, "ChartKAP"), ChartScanManifest::kChanged);
+  // A failure is only known for the class which probed the file
+  EXPECT_EQ(manifest.Find(files[0], "oesenc_pi"), ChartScanManifest::kUnknown);
+  manifest.Forget(files[2]);
+  EXPECT_EQ(manifest.Find(files[2], "ChartKAP"), ChartScanManifest::kUnknown);
+  remove("chart-scan.scan");
+  ASSERT_TRUE(manifest.Save("chart-scan.scan"));
+
+  ChartScanManifest loaded;
+  loaded.Load("chart-scan.scan");
+  EXPECT_EQ(loaded.Size(), 2u);
+  EXPECT_EQ(loaded.Find(files[0], "ChartKAP"), ChartScanManifest::kNotChart);
+  EXPECT_EQ(loaded.Find(files[1], "ChartKAP"), ChartScanManifest::kChart);
+  EXPECT_EQ(loaded.Find(files[1], "ChartGEO"), ChartScanManifest::kUnknown);
+
+  // Files gone from the directory are dropped
+  std::vector<ChartScanFile> rest(files.begin() + 1, files.end());
+  loaded.Prune("chart-scan", rest);
+  EXPECT_EQ(loaded.Find(files[0], "ChartKAP"), ChartScanManifest::kUnknown);
+  EXPECT_EQ(loaded.Find(files[1], "ChartKAP"), ChartScanManifest::kChart);
+}
+
+static TexCacheLayout TestCacheLayout() {
+  TexCacheLayout layout;
+  layout.format = 0x83F0;  // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+  layout.chartdate = 1700000000;
+  layout.chartfile_date = 1700000100;
+  layout.chartfile_size = 123456;
+  layout.schemes = 5;
+  layout.tiles = 12;
+  layout.level_sizes = {131072, 32768, 8192, 2048, 512};
+  return layout;
+}
+
+static std::vector<unsigned char> CacheLevelData(size_t size, int seed) {
+  std::mt19937 rng(seed);
+  std::vector<unsigned char> data(size);
+  for (auto& byte : data) byte = rng();
+  return data;
+}
+
+/** Stands in for an LZ4 compressed level, about a tenth of its size. */
+static std::vector<unsigned char> PackedLevelData(unsigned level, int seed) {
+  return CacheLevelData(TestCacheLayout().level_sizes[level] / 10 + seed,
+                        seed);
+}
+
+TEST(TexCacheFile, PutGetReopen) {
+  remove("test-tex-cache.dat");
+  TexCacheLayout layout = TestCacheLayout();
+  size_t size = 0;
+  {
+    TexCacheFile cache;
+    ASSERT_TRUE(cache.Open("test-tex-cache.dat", layout));
+    EXPECT_TRUE(cache.IsNew());
+    EXPECT_FALSE(cache.Has(1, 3, 0));
+    EXPECT_EQ(cache.Get(1, 3, 0, &size), nullptr);
+    for (unsigned level = 0; level < 5; level++) {
+      auto data = PackedLevelData(level, level);
+      ASSERT_TRUE(cache.Put(1, 3, level, data.data(), data.size()));
+    }
+    auto data = PackedLevelData(2, 42);
+    ASSERT_TRUE(cache.Put(4, 11, 2, data.data(), data.size()));
+    EXPECT_FALSE(cache.Put(5, 0, 0, data.data(), data.size()));  // no scheme
+    EXPECT_FALSE(cache.Put(4, 11, 0, data.data(), 0));
+    const unsigned char* level0 = cache.Get(1, 3, 0, &size);
+    ASSERT_NE(level0, nullptr);
+    EXPECT_EQ((uintptr_t)level0 % TexCacheFile::kPageSize, 0u);
+    auto expected = PackedLevelData(0, 0);
+    ASSERT_EQ(size, expected.size());
+    EXPECT_EQ(memcmp(level0, expected.data(), size), 0);
+    // The first level of a tile starts a page
+    const unsigned char* other = cache.Get(4, 11, 2, &size);
+    ASSERT_NE(other, nullptr);
+    EXPECT_EQ((uintptr_t)other % TexCacheFile::kPageSize, 0u);
+  }
+  {
+    TexCacheFile cache;
+    ASSERT_TRUE(cache.Open("test-tex-cache.dat", layout));
+    EXPECT_FALSE(cache.IsNew());
+    for (unsigned level = 0; level < 5; level++) {
+      ASSERT_TRUE(cache.Has(1, 3, level));
+      const unsigned char* data = cache.Get(1, 3, level, &size);
+      ASSERT_NE(data, nullptr);
+      auto expected = PackedLevelData(level, level);
+      ASSERT_EQ(size, expected.size());
+      EXPECT_EQ((uintptr_t)data % 64, 0u);
+      EXPECT_EQ(memcmp(data, expected.data(), size), 0);
+    }
+    EXPECT_TRUE(cache.Has(4, 11, 2));
+    EXPECT_FALSE(cache.Has(4, 11, 1));
+    EXPECT_EQ(cache.GetCorruptCount(), 0u);
+
+    // Levels stored after reopening are appended
+    auto data = PackedLevelData(1, 9);
+    ASSERT_TRUE(cache.Put(4, 11, 1, data.data(), data.size()));
+    const unsigned char* stored = cache.Get(4, 11, 1, &size);
+    ASSERT_NE(stored, nullptr);
+    ASSERT_EQ(size, data.size());
+    EXPECT_EQ(memcmp(stored, data.data(), size), 0);
+    EXPECT_NE(cache.Get(1, 3, 0, &size), nullptr);
+  }
+  // Another chart edition starts the file afresh
+  layout.chartfile_size++;
+  TexCacheFile cache;
+  ASSERT_TRUE(cache.Open("test-tex-cache.dat", layout));
+  EXPECT_TRUE(cache.IsNew());
+  EXPECT_FALSE(cache.Has(1, 3, 0));
+  EXPECT_EQ(wxFileName::GetSize("test-tex-cache.dat").GetValue() %
+                TexCacheFile::kPageSize,
+            0u);
+}
+
+TEST(TexCacheFile, Corruption) {
+  remove("test-tex-cache.dat");
+  TexCacheLayout layout = TestCacheLayout();
+  auto level1 = PackedLevelData(1, 7);
+  size_t size = 0;
+  {
+    TexCacheFile cache;
+    ASSERT_TRUE(cache.Open("test-tex-cache.dat", layout));
+    for (unsigned level = 0; level < 5; level++) {
+      auto data = PackedLevelData(level, level + 6);
+      ASSERT_TRUE(cache.Put(2, 5, level, data.data(), data.size()));
+    }
+  }
+  // Flip a byte in the middle of level 1
+  std::vector<char> file;
+  {
+    std::ifstream f("test-tex-cache.dat", std::ios::binary);
+    file.assign(std::istreambuf_iterator<char>(f), {});
+  }
+  std::vector<char> pattern(level1.begin(), level1.end());
+  auto found = std::search(file.begin(), file.end(), pattern.begin(),
+                           pattern.end());
+  ASSERT_NE(found, file.end());
+  found[level1.size() / 2] ^= 0x10;
+  std::ofstream("test-tex-cache.dat", std::ios::binary)
+      .write(file.data(), file.size());
+
+  TexCacheFile cache;
+  ASSERT_TRUE(cache.Open("test-tex-cache.dat", layout));
+  EXPECT_TRUE(cache.Has(2, 5, 1));
+  EXPECT_NE(cache.Get(2, 5, 0, &size), nullptr);
+  EXPECT_EQ(cache.Get(2, 5, 1, &size), nullptr);
+  EXPECT_FALSE(cache.Has(2, 5, 1));
+  EXPECT_EQ(cache.GetCorruptCount(), 1u);
+  EXPECT_NE(cache.Get(2, 5, 2, &size), nullptr);
+
+  // Built again, appended to the file
+  ASSERT_TRUE(cache.Put(2, 5, 1, level1.data(), level1.size()));
+  const unsigned char* data = cache.Get(2, 5, 1, &size);
+  ASSERT_NE(data, nullptr);
+  ASSERT_EQ(size, level1.size());
+  EXPECT_EQ(memcmp(data, level1.data(), size), 0);
+  EXPECT_EQ(cache.GetCorruptCount(), 1u);
+}
+
+TEST(PerfTrace, Scopes) {
+  auto& trace = PerfTrace::GetInstance();
+  trace.Clear();
+  { PerfScope disabled("disabled"); }
+  trace.SetEnabled(true);
+  {
+    PerfScope outer("outer", PerfTrace::kStartup);
+    PerfScope inner("inner", PerfTrace::kStartup);
+    inner.End();
+    std::thread([] { PerfScope in_thread("thread"); }).join();
+  }
+  trace.SetEnabled(false);
+  auto events = trace.GetEvents();
+  ASSERT_EQ(events.size(), 3);
+  EXPECT_STREQ(events[0].name, "inner");
+  EXPECT_EQ(events[0].depth, 1);
+  EXPECT_STREQ(events[1].name, "thread");
+  EXPECT_EQ(events[1].depth, 0);
+  EXPECT_NE(events[1].thread, events[0].thread);
+  EXPECT_STREQ(events[2].name, "outer");
+  EXPECT_EQ(events[2].depth, 0);
+  EXPECT_LE(events[2].start_us, events[0].start_us);
+
+  ASSERT_TRUE(trace.WriteChromeTrace("test-trace.json"));
+  std::ifstream stream("test-trace.json");
+  std::string json((std::istreambuf_iterator<char>(stream)),
+                   std::istreambuf_iterator<char>());
+  const char* outer = R"("name":"outer","cat":"startup","ph":"X")";
+  EXPECT_NE(json.find(outer), std::string::npos);
+  trace.Clear();
+}
+
+TEST(RenderStats, Percentiles) {
+  RollingPercentiles samples(100);
+  EXPECT_EQ(samples.Percentile(50), 0);
+  for (int i = 1; i <= 150; i++) samples.Add(i);
+  EXPECT_EQ(samples.Size(), 100);
+  EXPECT_EQ(samples.Count(), 150);
+  EXPECT_EQ(samples.Last(), 150);
+  EXPECT_EQ(samples.Percentile(50), 100);
+  EXPECT_EQ(samples.Percentile(95), 145);
+  EXPECT_EQ(samples.Percentile(0), 51);
+  EXPECT_EQ(samples.Max(), 150);
+
+  auto& stats = RenderStats::GetInstance();
+  stats.Clear();
+  { RenderPassTimer frame(RenderStats::kFrame); }
+  stats.Add("Plugin \"x\"", 2.5);
+  auto summary = stats.GetSummary();
+  ASSERT_EQ(summary.size(), 2);
+  EXPECT_EQ(summary[0].pass, RenderStats::kFrame);
+  EXPECT_EQ(summary[0].count, 1);
+  EXPECT_EQ(summary[1].p99, 2.5);
+  std::string json = stats.ToJson();
+  EXPECT_NE(json.find(R"({"pass":"Plugin \"x\"","count":1,"last":2.500)"),
+            std::string::npos);
+  stats.Clear();
+}
+
+/** Check model order and positions against a full sort of keys. */
+static void CheckAisListOrder(const AisListModel& model,
+                              const std::map<int, AisListKey>& keys,
+                              bool reverse) {
+  std::vector<int> expected;
+  for (const auto& kv : keys) expected.push_back(kv.first);
+  std::sort(expected.begin(), expected.end(), [&](int a, int b) {
+    const AisListKey& ka = keys.at(a);
+    const AisListKey& kb = keys.at(b);
+    if (ka.rank != kb.rank) return ka.rank < kb.rank;
+    if (ka.num != kb.num) return reverse ? ka.num > kb.num : ka.num < kb.num;
+    if (ka.range != kb.range) return ka.range < kb.range;
+    return a < b;
+  });
+  ASSERT_EQ(model.Size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(model.GetMmsi(i), expected[i]);
+    ASSERT_EQ(model.FindRow(expected[i]), static_cast<long>(i));
+  }
+}
+
+TEST(AisListModel, IncrementalSort) {
+  const int kTargets = 1000;
+  std::srand(4711);
+  auto random_key = []() {
+    AisListKey key;
+    key.rank = std::rand() % 100 == 0 ? 0 : 1;
+    key.numeric = true;
+    key.num = std::rand() % 360;
+    key.range = (std::rand() % 10000) / 100.0;
+    return key;
+  };
+  AisListModel model;
+  model.SetReverse(true);
+  std::map<int, AisListKey> keys;
+  auto sync = [&]() {
+    model.BeginSync();
+    for (const auto& kv : keys) model.Update(kv.first, kv.second, kv.first);
+    model.EndSync();
+  };
+  for (int i = 0; i < kTargets; i++) keys[200000000 + i] = random_key();
+  sync();
+  CheckAisListOrder(model, keys, true);
+
+  // Few changes are inserted locally, many trigger a full sort
+  for (int changes : {5, 50, 500}) {
+    for (int i = 0; i < changes; i++) {
+      auto it = keys.begin();
+      std::advance(it, std::rand() % keys.size());
+      it->second = random_key();
+    }
+    keys.erase(keys.begin());
+    keys[300000000 + changes] = random_key();
+    sync();
+    CheckAisListOrder(model, keys, true);
+  }
+
+  // Cells are cached until the fingerprint changes
+  int mmsi = model.GetMmsi(0);
+  model.SetCell(0, 3, "cached");
+  ASSERT_NE(model.GetCell(0, 3), nullptr);
+  EXPECT_EQ(*model.GetCell(0, 3), "cached");
+  EXPECT_EQ(model.GetCell(0, 2), nullptr);
+  model.BeginSync();
+  for (const auto& kv : keys) model.Update(kv.first, kv.second, kv.first);
+  model.EndSync();
+  EXPECT_NE(model.GetCell(model.FindRow(mmsi), 3), nullptr);
+  model.BeginSync();
+  for (const auto& kv : keys) model.Update(kv.first, kv.second, 0);
+  model.EndSync();
+  EXPECT_EQ(model.GetCell(model.FindRow(mmsi), 3), nullptr);
+
+  // Without autosort rows keep their place, new ones go last
+  model.SetAutosort(false);
+  keys.begin()->second = random_key();
+  keys[400000000] = random_key();
+  int first = model.GetMmsi(0);
+  sync();
+  EXPECT_EQ(model.GetMmsi(0), first);
+  EXPECT_EQ(model.GetMmsi(model.Size() - 1), 400000000);
+  model.Sort();
+  CheckAisListOrder(model, keys, true);
+
+  // Typical refresh: 1% of the keys changed
+  model.SetAutosort(true);
+  for (int round = 0; round < 10; round++) {
+    for (int i = 0; i < kTargets / 100; i++) {
+      auto it = keys.begin();
+      std::advance(it, std::rand() % keys.size());
+      it->second = random_key();
+    }
+    sync();
+    CheckAisListOrder(model, keys, true);
+  }
+}
+
+/** Screen position of a batch vertex as computed by the vertex shader. */
+static void BatchVertexPos(const AisBatchVertex& v, float* x, float* y) {
+  float px = v.scale * v.local[0] + v.extrude[0];
+  float py = v.scale * v.local[1] + v.extrude[1];
+  *x = v.pos[0] + px * v.rot[0] + py * v.rot[1];
+  *y = v.pos[1] + py * v.rot[0] - px * v.rot[1];
+}
+
+TEST(AisSymbolBatch, Geometry) {
+  const AisBatchColor green = {0, 255, 0, 255};
+  const AisBatchColor black = {0, 0, 0, 255};
+  const AisBatchColor none = {0, 0, 0, 0};
+  AisSymbolBatch batch;
+  std::vector<float> quad = {-8, -6, 0, 24, 8, -6, 0, -6};
+  int ship = batch.AddTemplate(quad, AisSymbolBatch::FanTriangles(4, 3));
+  EXPECT_EQ(AisSymbolBatch::FanTriangles(4, 3).size(), 6u);
+
+  // Fill vertices are the template rotated like transrot() in ais.cpp
+  float theta = 0.3f;
+  AisSymbolInstance at(100, 50, 1.5f, sinf(theta), cosf(theta));
+  batch.AddSymbol(ship, at, green, black, 0);
+  ASSERT_EQ(batch.Size(), 6u);
+  float x, y;
+  BatchVertexPos(batch.GetVertices()[1], &x, &y);
+  float lx = 1.5f * quad[0], ly = 1.5f * quad[1];
+  EXPECT_NEAR(x, 100 + lx * sinf(theta) + ly * cosf(theta), 1e-4);
+  EXPECT_NEAR(y, 50 + ly * sinf(theta) - lx * cosf(theta), 1e-4);
+
+  // Outline only, one quad per edge
+  batch.Clear();
+  batch.AddSymbol(ship, at, none, black, 2);
+  EXPECT_EQ(batch.Size(), 4u * 6u);
+
+  // Strokes keep their pixel width with square caps
+  batch.Clear();
+  batch.AddLine(0, 0, 10, 0, 2, black);
+  ASSERT_EQ(batch.Size(), 6u);
+  for (const auto& v : batch.GetVertices()) {
+    BatchVertexPos(v, &x, &y);
+    EXPECT_TRUE(x == -1 || x == 11);
+    EXPECT_NEAR(std::fabs(y), 1, 1e-6);
+  }
+  batch.Clear();
+  batch.AddDashedLine(0, 0, 10, 0, 1, 2, 2, black);
+  EXPECT_EQ(batch.Size(), 3u * 6u);
+  batch.Clear();
+  float strip[] = {0, 0, 10, 0, 10, 10};
+  batch.AddPolyline(strip, 3, 1, black);
+  EXPECT_EQ(batch.Size(), 2u * 6u);
+
+  // Scene of hull, predictor and predictor circle per target
+  const int kTargets = 100;
+  int circle = batch.AddTemplate(AisSymbolBatch::CircleOutline(16),
+                                 AisSymbolBatch::FanTriangles(16));
+  batch.Clear();
+  for (int i = 0; i < kTargets; i++) {
+    float tx = i % 10 * 10.f, ty = i / 10 * 10.f;
+    float a = i * 0.01f;
+    AisSymbolInstance hull(tx, ty, 1, sinf(a), cosf(a));
+    batch.AddLine(tx, ty, tx + 30 * cosf(a), ty + 30 * sinf(a), 3, green);
+    batch.AddSymbol(circle,
+                    AisSymbolInstance(tx + 30 * cosf(a), ty + 30 * sinf(a), 5),
+                    green, black, 1);
+    batch.AddSymbol(ship, hull, green, black, 2);
+  }
+  EXPECT_EQ(batch.Size(), kTargets * (6u + 14u * 3 + 16u * 6 + 6u + 4u * 6));
+}
+
+/** Points of a level as mercator meters from lat, lon 0, 0. */
+static std::vector<double> GeometryPoints(TrackGeometry& geometry, int level) {
+  std::vector<double> xy;
+  for (const auto& chunk : geometry.GetChunks(level)) {
+    double x0, y0;
+    toSM(chunk.ref_lat, chunk.ref_lon, 0, 0, &x0, &y0);
+    // Chunks after the first repeat the last point of the previous one
+    for (size_t i = xy.empty() ? 0 : 2; i < chunk.xy.size(); i += 2) {
+      xy.push_back(x0 + chunk.xy[i]);
+      xy.push_back(y0 + chunk.xy[i + 1]);
+    }
+  }
+  return xy;
+}
+
+TEST(TrackGeometry, Levels) {
+  EXPECT_EQ(TrackGeometry::LevelForScale(10), 0);
+  EXPECT_EQ(TrackGeometry::LevelForScale(1), 1);
+  EXPECT_EQ(TrackGeometry::LevelForScale(0.001), 10);
+  EXPECT_LE(TrackGeometry::Tolerance(10), 1000);
+
+  // Spiral track with points 10 to 60 m apart
+  const size_t kPoints = 5000;
+  std::vector<TrackPoint*> points;
+  for (size_t i = 0; i < kPoints; i++)
+    points.push_back(new TrackPoint(60 + i * 1e-4 * sin(i * 1e-3),
+                                    10 + i * 1e-4 * cos(i * 1e-3)));
+  TrackGeometry geometry;
+  geometry.Update(points);
+  EXPECT_EQ(GeometryPoints(geometry, 0).size(), 2 * kPoints);
+  EXPECT_GT(geometry.GetChunks(0).size(), kPoints / 1024);
+
+  // A coarse level drops points, but none is off by more than its tolerance
+  const int kLevel = 10;
+  std::vector<double> coarse = GeometryPoints(geometry, kLevel);
+  EXPECT_LT(coarse.size(), 2 * kPoints / 4);
+  double off = 0;
+  size_t k = 0;
+  for (size_t i = 0; i < kPoints; i++) {
+    double x, y;
+    toSM(points[i]->m_lat, points[i]->m_lon, 0, 0, &x, &y);
+    if (k + 2 < coarse.size() && std::hypot(x - coarse[k + 2],
+                                            y - coarse[k + 3]) < 1e-2)
+      k += 2;
+    off = std::max(off, std::hypot(x - coarse[k], y - coarse[k + 1]));
+  }
+  EXPECT_EQ(k + 2, coarse.size());
+  EXPECT_LE(off, TrackGeometry::Tolerance(kLevel) * 1.0001);
+
+  // Appending point by point gives the same geometry as building at once
+  TrackGeometry incremental;
+  std::vector<TrackPoint*> some;
+  incremental.GetChunks(0);
+  incremental.GetChunks(kLevel);
+  for (TrackPoint* p : points) {
+    some.push_back(p);
+    incremental.Update(some);
+  }
+  EXPECT_EQ(GeometryPoints(incremental, 0), GeometryPoints(geometry, 0));
+  EXPECT_EQ(GeometryPoints(incremental, kLevel), coarse);
+
+  // Dropping the next to last point, like ActiveTrack, rolls back
+  TrackPoint* dropped = some[some.size() - 2];
+  some.erase(some.end() - 2);
+  incremental.Update(some);
+  TrackGeometry fresh;
+  fresh.Update(some);
+  EXPECT_EQ(GeometryPoints(incremental, 0), GeometryPoints(fresh, 0));
+  EXPECT_EQ(GeometryPoints(incremental, kLevel),
+            GeometryPoints(fresh, kLevel));
+  // A moved last point is noticed too
+  some.back()->m_lat += 0.01;
+  incremental.Update(some);
+  fresh.Clear();
+  fresh.Update(some);
+  EXPECT_EQ(GeometryPoints(incremental, 0), GeometryPoints(fresh, 0));
+  delete dropped;
+
+  // Appending to a long track only touches the last chunk
+  const size_t kLong = 20000;
+  std::vector<TrackPoint*> long_track = some;
+  for (size_t i = kPoints; i < kLong; i++)
+    long_track.push_back(new TrackPoint(50 + 20 * sin(i * 1e-5), 1e-4 * i));
+  TrackGeometry big;
+  big.Update(long_track);
+  big.GetChunks(0);
+  big.GetChunks(kLevel);
+  for (auto& chunk : big.GetChunks(0)) chunk.dirty = false;
+  long_track.push_back(new TrackPoint(50, 100));
+  big.Update(long_track);
+  size_t dirty = 0;
+  for (auto& chunk : big.GetChunks(0)) dirty += chunk.dirty;
+  EXPECT_GT(big.GetChunks(0).size(), 1u);
+  EXPECT_EQ(dirty, 1u);
+  for (TrackPoint* p : long_track) delete p;
+}
+
+/** Bitwise, NaN from the far side of the earth equals NaN. */
+static bool SameDouble(double a, double b) {
+  return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+/**
+ * The batch projections of ViewPort must give the same pixels as its
+ * single point path, GetDoublePixFromLL(), also across the antimeridian.
+ */
+TEST(GeorefBatch, SameAsSinglePoint) {
+  const int kCount = 151;  // not a multiple of the SIMD width or block
+  std::mt19937 rng(29);
+  std::uniform_real_distribution<double> near(-20, 20), any(-180, 180);
+  std::uniform_real_distribution<double> any_lat(-80, 80);
+  enum { kMercator, kPolar, kStereo };
+  for (double clon : {0.0, 179.5, -179.5, 100.0}) {
+    for (double clat : {60.0, -45.0}) {
+      std::vector<double> lat(kCount), lon(kCount);
+      for (int i = 0; i < kCount; i++) {
+        lat[i] = i % 3 ? clat + near(rng) / 2 : any_lat(rng);
+        double l = i % 4 ? clon + near(rng) : any(rng);
+        lon[i] = l > 180 ? l - 360 : l < -180 ? l + 360 : l;
+      }
+      std::vector<double> xlon(kCount);
+      PhaseLongitudes(lon.data(), kCount, clon, xlon.data());
+      for (int i = 0; i < kCount; i++)
+        ASSERT_TRUE(SameDouble(xlon[i], PhaseLongitude(lon[i], clon)));
+
+      double y30 = toSMcache_y30(clat), e = toPOLARcache_e(clat);
+      double sin_phi0, cos_phi0;
+      cache_phi0(clat, &sin_phi0, &cos_phi0);
+      for (int projection : {kMercator, kPolar, kStereo}) {
+        std::vector<double> easting(kCount), northing(kCount);
+        if (projection == kMercator)
+          toSMcacheBatch(lat.data(), xlon.data(), kCount, y30, clon,
+                         easting.data(), northing.data());
+        else if (projection == kPolar)
+          toPOLARBatch(lat.data(), xlon.data(), kCount, e, clat, clon,
+                       easting.data(), northing.data());
+        else
+          toSTEREOBatch(lat.data(), xlon.data(), kCount, sin_phi0,
+                        cos_phi0, clon, easting.data(), northing.data());
+        for (double rotation : {0.0, 0.3}) {
+          ProjectedToPix to_pix(3e-3, rotation, 400, 300);
+          std::vector<double> x(kCount), y(kCount);
+          to_pix.Apply(easting.data(), northing.data(), kCount, x.data(),
+                       y.data());
+          for (int i = 0; i < kCount; i++) {
+            double ex, ny;
+            double xl = PhaseLongitude(lon[i], clon);
+            if (projection == kMercator)
+              toSMcache(lat[i], xl, y30, clon, &ex, &ny);
+            else if (projection == kPolar)
+              toPOLAR(lat[i], xl, e, clat, clon, &ex, &ny);
+            else
+              toSTEREO(lat[i], xl, sin_phi0, cos_phi0, clon, &ex, &ny);
+            double px, py;
+            to_pix.Apply(ex, ny, &px, &py);
+            EXPECT_TRUE(SameDouble(x[i], px) && SameDouble(y[i], py))
+                << "projection " << projection << " clon " << clon
+                << " lat " << lat[i] << " lon " << lon[i];
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(XyzTiles, Math) {
+  EXPECT_EQ(LonToTileX(-180, 3), 0);
+  EXPECT_EQ(LonToTileX(180, 3), 7);
+  EXPECT_EQ(LatToTileY(89.9, 3), 0);
+  EXPECT_EQ(LatToTileY(-89.9, 3), 7);
+  EXPECT_NEAR(TileYToLat(0, 0), 85.0511, 1e-4);
+  EXPECT_NEAR(TileXToLon(LonToTileX(11.97, 10), 10), 11.95, 0.36);
+  EXPECT_NEAR(TileScalePpm(1) / TileScalePpm(0), 2.0, 1e-9);
+
+  auto tiles = TilesInBox(-85, -180, 85, 180, 0, 2);
+  EXPECT_EQ(tiles.size(), 1u + 4u + 16u);
+  EXPECT_EQ(tiles.front().z, 0);
+  EXPECT_EQ(tiles.back().z, 2);
+  EXPECT_EQ(TilesInBox(57.6, 11.8, 57.6, 11.8, 12, 12).size(), 1u);
+  EXPECT_EQ(CountTilesInBox(-85, -180, 85, 180, 0, 2), 21u);
+  EXPECT_TRUE(TilesInBox(-85, -180, 85, 180, 0, 2, 20).empty());
+  EXPECT_EQ(CountTilesInBox(-89, -180, 89, 180, 24, 24), uint64_t(1) << 48);
+
+  TileRenderSpec spec;
+  EXPECT_EQ(spec.Parse("57.6,11.8,57.8,12.0:10-11:C:\\tiles.mbtiles"), "");
+  EXPECT_EQ(spec.zmax, 11);
+  EXPECT_EQ(spec.output, "C:\\tiles.mbtiles");
+  EXPECT_TRUE(spec.IsMbtiles());
+  EXPECT_NE(spec.Parse("57.6,11.8,57.8:10-11:tiles"), "");
+  EXPECT_NE(spec.Parse("57.6,11.8,57.8,12.0:11-10:tiles"), "");
+  EXPECT_NE(spec.Parse("57.6,11.8,57.8,12.0:10-11"), "");
+  EXPECT_NE(spec.Parse("-80,-180,80,180:0-12:tiles"), "");
+}
+
+TEST(LLRegion, ClipRegression) {
+  RegionOps ops;
+  ASSERT_GT(ops.rings.size(), 500u);
+  auto tess = ops.Run(true);
+  auto clip = ops.Run(false);
+  ASSERT_EQ(tess.size(), clip.size());
+  for (size_t i = 0; i < tess.size(); i++)
+    EXPECT_NEAR(clip[i], tess[i], 1e-5 + 2e-6 * fabs(tess[i])) << "op " << i;
+
+  // |A u B| + |A n B| = |A| + |B|
+  for (size_t i = 0; i < ops.rings.size(); i++) {
+    double a = RegionArea(ops.rings[i]), b = RegionArea(ops.moved[i]);
+    EXPECT_NEAR(clip[6 * i + 3] + clip[6 * i + 2], a + b, 1e-5 + 1e-4 * (a + b));
+  }
+
+  LLRegion hole(-10, -10, 10, 10);
+  hole.Subtract(LLRegion(-1, -1, 1, 1));
+  EXPECT_EQ(hole.contours.size(), 2u);
+  EXPECT_NEAR(RegionArea(hole), 400 - 4, 1e-3);
+  EXPECT_FALSE(hole.Contains(0, 0));
+  EXPECT_TRUE(hole.Contains(5, 5));
+  hole.Union(LLRegion(-2, -2, 2, 2));
+  EXPECT_EQ(hole.contours.size(), 1u);
+  EXPECT_NEAR(RegionArea(hole), 400, 1e-3);
+}
+
+TEST(LODReduce, Reference) {
+  for (int dim = 2; dim <= 3; dim++) {
+    for (unsigned seed = 1; seed <= 20; seed++) {
+      int n = 3 + seed * seed * 10;
+      std::vector<double> xy = RandomWalk(n, dim, seed);
+      double eps = 0.5 + seed % 5;
+      std::vector<bool> expected(n), keep;
+      ReferenceReduce(xy.data(), 0, n - 1, eps, expected, dim);
+      LODReduce(xy.data(), 0, n - 1, eps, keep, dim, dim);
+      ASSERT_EQ(keep, expected) << "dim " << dim << " seed " << seed;
+
+      std::vector<float> fxy(xy.begin(), xy.end());
+      std::vector<bool> fkeep;
+      LODReduce(fxy.data(), 0, n - 1, eps, fkeep, dim, dim);
+      EXPECT_EQ(fkeep, expected);
+
+      // No dropped point is farther than eps from the simplified line
+      int prev = 0;
+      for (int i = 1; i < n; i++) {
+        if (!keep[i]) continue;
+        std::vector<bool> sub(n);
+        ReferenceReduce(xy.data(), prev, i, eps, sub, dim);
+        EXPECT_EQ(std::count(sub.begin(), sub.end(), true), 2);
+        prev = i;
+      }
+    }
+  }
+
+  // Entries outside the range are left alone
+  std::vector<double> xy = RandomWalk(100, 2, 7);
+  std::vector<bool> keep(100, false);
+  keep[0] = keep[99] = true;
+  LODReduce(xy.data(), 1, 98, 1, keep);
+  std::vector<bool> inner(100);
+  ReferenceReduce(xy.data() + 2, 0, 97, 1, inner, 2);
+  for (int i = 1; i < 99; i++) EXPECT_EQ(keep[i], inner[i - 1]);
+
+  // Parallel over many lines is the same as one by one
+  std::vector<std::vector<double>> walks;
+  for (unsigned seed = 0; seed < 64; seed++)
+    walks.push_back(RandomWalk(1000 + seed * 500, 2, seed));
+  std::vector<LODLine> lines;
+  for (auto& walk : walks)
+    lines.emplace_back(walk.data(), 0, walk.size() / 2 - 1, 2.5);
+  LODReduce(lines);
+  for (size_t i = 0; i < walks.size(); i++) {
+    std::vector<bool> serial;
+    LODReduce(walks[i].data(), 0, walks[i].size() / 2 - 1, 2.5, serial);
+    EXPECT_EQ(lines[i].keep, serial) << "line " << i;
+  }
+
+  // Reduced coastlines move by at most the factor, so the area changes by
+  // less than factor times the perimeter
+  RegionOps ops;
+  size_t points = 0, reduced_points = 0;
+  for (const LLRegion& ring : ops.rings) {
+    LLRegion reduced = ring;
+    reduced.Reduce(0.05);
+    double perimeter = 0;
+    for (const auto& contour : ring.contours) {
+      const contour_pt* l = &contour.back();
+      for (const auto& p : contour) {
+        perimeter += hypot(p.x - l->x, p.y - l->y);
+        l = &p;
+      }
+      points += contour.size();
+    }
+    for (const auto& contour : reduced.contours)
+      reduced_points += contour.size();
+    EXPECT_NEAR(RegionArea(reduced), RegionArea(ring), 0.05 * perimeter);
+  }
+  EXPECT_LT(reduced_points, points);
+}
+
+#ifdef HAVE_TEXCMP
+/** PSNR of the decoded blocks against the 565 flattened image. */
+static double Dxt1Psnr(const std::vector<unsigned char>& rgb, int dim,
+                       const std::vector<unsigned char>& blocks) {
+  static const int kMask[3] = {0xf8, 0xfc, 0xf8};
+  std::vector<unsigned char> rgba(dim * dim * 4);
+  squish::DecompressImage(rgba.data(), dim, dim, blocks.data(), squish::kDxt1);
+  double sum = 0;
+  for (int i = 0; i < dim * dim; i++) {
+    for (int k = 0; k < 3; k++) {
+      double d = (rgb[3 * i + k] & kMask[k]) - rgba[4 * i + k];
+      sum += d * d;
+    }
+  }
+  double mse = sum / (dim * dim * 3);
+  return mse == 0 ? 100 : 10 * log10(255 * 255 / mse);
+}
+
+TEST(Dxt1, Conformance) {
+  const int dim = 256;
+  Dxt1_ResolveRoutines();
+  for (unsigned seed = 1; seed <= 3; seed++) {
+    auto rgb = ChartTexture(dim, seed);
+    double range =
+        Dxt1Psnr(rgb, dim, SquishDxt1(rgb, dim, squish::kColourRangeFit));
+    double cluster =
+        Dxt1Psnr(rgb, dim, SquishDxt1(rgb, dim, squish::kColourClusterFit));
+    double fast = Dxt1Psnr(rgb, dim, Dxt1(rgb, dim, DXT1_FAST));
+    double quality = Dxt1Psnr(rgb, dim, Dxt1(rgb, dim, DXT1_QUALITY));
+    EXPECT_GE(fast, range - 0.25) << "seed " << seed;
+    EXPECT_GE(quality, cluster - 0.25) << "seed " << seed;
+    EXPECT_GE(quality, fast - 0.01) << "seed " << seed;
+  }
+
+  // noise has no structure to exploit, still no worse than squish
+  std::mt19937 rng(5);
+  std::vector<unsigned char> noise(64 * 64 * 3);
+  for (auto& c : noise) c = rng();
+  double cluster =
+      Dxt1Psnr(noise, 64, SquishDxt1(noise, 64, squish::kColourClusterFit));
+  EXPECT_GE(Dxt1Psnr(noise, 64, Dxt1(noise, 64, DXT1_QUALITY)), cluster - 0.25);
+
+  // solid blocks and images smaller than a block
+  for (int v = 0; v < 256; v += 5) {
+    std::vector<unsigned char> solid(2 * 2 * 3, v);
+    std::vector<unsigned char> block(8), rgba(4 * 4 * 4);
+    volatile bool abort = false;
+    Dxt1_CompressImageRGB(solid.data(), 2, 2, block.data(), DXT1_FAST, false,
+                          0, 0, abort);
+    squish::Decompress(rgba.data(), block.data(), squish::kDxt1);
+    for (int i = 0; i < 16; i++) {
+      EXPECT_NEAR(rgba[4 * i], v, 2) << v;
+      EXPECT_NEAR(rgba[4 * i + 1], v, 2) << v;
+      EXPECT_NEAR(rgba[4 * i + 2], v, 2) << v;
+    }
+  }
+}
+
+TEST(Dxt1, SimdMatchesGeneric) {
+  const int dim = 128;
+  auto rgb = ChartTexture(dim, 7);
+  std::mt19937 rng(9);
+  for (size_t i = 0; i < rgb.size() / 2; i++) rgb[i] = rng();
+  Dxt1FitFunc fits[] = {Dxt1_FitIndices_generic, Dxt1_FitIndices_sse2,
+                        Dxt1_FitIndices_avx2};
+  Dxt1MomentsFunc moments[] = {Dxt1_Moments_generic, Dxt1_Moments_sse2,
+                               Dxt1_Moments_avx2};
+  Dxt1_ResolveRoutines();
+  Dxt1FitFunc resolved = Dxt1_FitIndices;
+  std::vector<unsigned char> expected[2];
+  for (int v = 0; v < 3; v++) {
+    // the variants the cpu lacks would crash, resolved is the best it has
+    if (v > 0 && resolved == Dxt1_FitIndices_generic) break;
+    if (v > 1 && resolved == Dxt1_FitIndices_sse2) break;
+    Dxt1_FitIndices = fits[v];
+    Dxt1_Moments = moments[v];
+    for (int q = 0; q < 2; q++) {
+      auto blocks = Dxt1(rgb, dim, (Dxt1Quality)q);
+      if (v == 0)
+        expected[q] = blocks;
+      else
+        EXPECT_EQ(blocks, expected[q]) << "variant " << v << " quality " << q;
+    }
+  }
+  Dxt1_ResolveRoutines();
+}
+
+#endif
+
 TEST(Listeners, vector) { ListenerCliApp app; };
 
 TEST(Guernsey, play_log) { GuernseyApp app; }